@@ -0,0 +1,28 @@
+file(
+  GLOB
+  WEBRTC_APPLICATION_BASE64_BENCHMARK_SOURCE_FILES
+  "examples/base64_benchmark/*.c" )
+
+add_executable(
+    WebRTCLinuxBase64Benchmark
+    ${WEBRTC_APPLICATION_BASE64_BENCHMARK_SOURCE_FILES}
+    "examples/base64/simd/base64_simd.c"
+    "examples/logging/logging.c" )
+
+target_include_directories( WebRTCLinuxBase64Benchmark PRIVATE
+                            "examples/base64/"
+                            "examples/base64/simd/"
+                            "examples/logging/"
+                            ${WEBRTC_APPLICATION_MBEDTLS_INCLUDE_DIRS} )
+
+target_compile_definitions( WebRTCLinuxBase64Benchmark
+                            PUBLIC
+                            MBEDTLS_CONFIG_FILE="mbedtls_custom_config.h" )
+
+target_link_libraries( WebRTCLinuxBase64Benchmark
+                       mbedtls
+                       rt
+                       pthread
+)
+
+target_compile_options( WebRTCLinuxBase64Benchmark PRIVATE -Wall -Werror )
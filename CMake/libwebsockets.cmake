@@ -8,9 +8,15 @@ set(LWS_WITH_MBEDTLS ON CACHE INTERNAL "Enable libwebsockets mbedTLS")
 set(LWS_MBEDTLS_INCLUDE_DIRS ${MBEDTLS_BUILD_INCLUDE_DIR} CACHE STRING "MbedTLS include directories")
 set(LWS_MBEDTLS_LIBRARIES mbedtls mbedx509 mbedcrypto CACHE STRING "MbedTLS libraries")
 set(LWS_WITH_HTTP2 ON CACHE INTERNAL "Compile with server support for HTTP/2")
+set(LWS_WITH_TLS_SESSIONS ON CACHE INTERNAL "Cache client TLS sessions for resumption")
 set(LWS_HAVE_SSL_EXTRA_CHAIN_CERTS 1 CACHE INTERNAL "Have extra chain certs")
 set(LWS_HAVE_OPENSSL_ECDH_H 1 CACHE INTERNAL "Enable ECDH")
-set(LWS_WITHOUT_SERVER ON CACHE INTERNAL "Don't build the server part of the library")
+if(BUILD_MOCK_SIGNALING_SERVER)
+  # The mock signaling server serves HTTPS and WSS with libwebsockets.
+  set(LWS_WITHOUT_SERVER OFF CACHE INTERNAL "Build the server part of the library")
+else()
+  set(LWS_WITHOUT_SERVER ON CACHE INTERNAL "Don't build the server part of the library")
+endif()
 set(LWS_WITHOUT_TESTAPPS ON CACHE INTERNAL "Don't build the libwebsocket-test-apps")
 set(LWS_WITHOUT_TEST_SERVER_EXTPOLL ON CACHE INTERNAL "Don't build the test server version that uses external poll")
 set(LWS_WITHOUT_TEST_PING ON CACHE INTERNAL "Don't build the ping test application")
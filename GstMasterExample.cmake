@@ -79,7 +79,6 @@ if(GST_FOUND)
     endif()
 
     target_link_libraries( WebRTCLinuxApplicationGstMaster
-                           sigv4
                            signaling
                            corejson
                            sdp
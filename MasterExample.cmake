@@ -66,7 +66,6 @@ endif()
 # link application with dependencies, note that rt is librt providing message queue's APIs
 message(STATUS "linking websockets to WebRTCLinuxApplication")
 target_link_libraries( WebRTCLinuxApplicationMaster
-                       sigv4
                        signaling
                        corejson
                        sdp
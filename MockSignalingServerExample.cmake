@@ -0,0 +1,33 @@
+file(
+  GLOB
+  WEBRTC_APPLICATION_MOCK_SIGNALING_SERVER_SOURCE_FILES
+  "examples/mock_signaling_server/*.c" )
+
+add_executable(
+    WebRTCLinuxMockSignalingServer
+    ${WEBRTC_APPLICATION_MOCK_SIGNALING_SERVER_SOURCE_FILES}
+    "examples/base64/mbedtls/base64_mbedtls.c"
+    "examples/logging/logging.c"
+    ${WEBRTC_APPLICATION_NETWORKING_UTILS_SOURCE_FILES} )
+
+target_include_directories( WebRTCLinuxMockSignalingServer PRIVATE
+                            "examples/mock_signaling_server/"
+                            "examples/base64/"
+                            "examples/logging/"
+                            ${WEBRTC_APPLICATION_NETWORKING_UTILS_INCLUDE_DIRS}
+                            ${WEBRTC_APPLICATION_MBEDTLS_INCLUDE_DIRS}
+                            ${LIBWEBSOCKETS_INCLUDE_DIRS} )
+
+target_compile_definitions( WebRTCLinuxMockSignalingServer
+                            PUBLIC
+                            MBEDTLS_CONFIG_FILE="mbedtls_custom_config.h" )
+
+target_link_libraries( WebRTCLinuxMockSignalingServer
+                       corejson
+                       mbedtls
+                       websockets
+                       rt
+                       pthread
+)
+
+target_compile_options( WebRTCLinuxMockSignalingServer PRIVATE -Wall -Werror )
@@ -0,0 +1,61 @@
+file(
+  GLOB
+  WEBRTC_APPLICATION_SCTP_BENCHMARK_SOURCE_FILES
+  "examples/sctp_benchmark/*.c" )
+
+add_executable(
+    WebRTCLinuxSctpBenchmark
+    ${WEBRTC_APPLICATION_SIGNALING_CONTROLLER_SOURCE_FILES}
+    ${WEBRTC_APPLICATION_NETWORKING_LIBWEBSOCKETS_SOURCE_FILES}
+    ${WEBRTC_APPLICATION_NETWORKING_UTILS_SOURCE_FILES}
+    ${WEBRTC_APPLICATION_SCTP_BENCHMARK_SOURCE_FILES}
+    ${WEBRTC_APPLICATION_COMMON_UTILS_SOURCE_FILES}
+    ${WEBRTC_APPLICATION_SDP_CONTROLLER_SOURCE_FILES}
+    ${WEBRTC_APPLICATION_ICE_CONTROLLER_SOURCE_FILES}
+    ${WEBRTC_APPLICATION_MBEDTLS_SOURCE_FILES}
+    ${WEBRTC_APPLICATION_COREHTTP_SOURCE_FILES}
+    ${WEBRTC_APPLICATION_LIBSRTP_SOURCE_FILES} )
+
+target_include_directories( WebRTCLinuxSctpBenchmark PRIVATE
+                            ${WEBRTC_APPLICATION_NETWORKING_LIBWEBSOCKETS_INCLUDE_DIRS}
+                            ${WEBRTC_APPLICATION_NETWORKING_UTILS_INCLUDE_DIRS}
+                            ${WEBRTC_APPLICATION_SIGNALING_CONTROLLER_INCLUDE_DIRS}
+                            ${WEBRTC_APPLICATION_COMMON_UTILS_INCLUDE_DIRS}
+                            ${WEBRTC_APPLICATION_SDP_CONTROLLER_INCLUDE_DIRS}
+                            ${WEBRTC_APPLICATION_ICE_CONTROLLER_INCLUDE_DIRS}
+                            ${WEBRTC_APPLICATION_MBEDTLS_INCLUDE_DIRS}
+                            ${WEBRTC_APPLICATION_COREHTTP_INCLUDE_DIRS}
+                            ${WEBRTC_APPLICATION_LIBSRTP_INCLUDE_DIRS}
+                            ${LIBWEBSOCKETS_INCLUDE_DIRS} )
+
+target_compile_definitions( WebRTCLinuxSctpBenchmark
+                            PUBLIC
+                            MBEDTLS_CONFIG_FILE="mbedtls_custom_config.h" )
+
+## The benchmark only exists to measure the data channel, so it always needs usrsctp
+target_compile_definitions( WebRTCLinuxSctpBenchmark PRIVATE ENABLE_SCTP_DATA_CHANNEL=1 )
+
+if( METRIC_PRINT_ENABLED )
+    target_compile_definitions( WebRTCLinuxSctpBenchmark PRIVATE METRIC_PRINT_ENABLED=1 )
+else()
+    target_compile_definitions( WebRTCLinuxSctpBenchmark PRIVATE METRIC_PRINT_ENABLED=0 )
+endif()
+
+target_link_libraries( WebRTCLinuxSctpBenchmark
+                       signaling
+                       corejson
+                       sdp
+                       ice
+                       rtcp
+                       rtp
+                       stun
+                       mbedtls
+                       libsrtp
+                       websockets
+                       usrsctp
+                       dcep
+                       rt
+                       pthread
+)
+
+target_compile_options( WebRTCLinuxSctpBenchmark PRIVATE -Wall -Werror )
@@ -0,0 +1,78 @@
+file(
+  GLOB
+  WEBRTC_APPLICATION_SDP_FUZZ_SOURCE_FILES
+  "examples/sdp_fuzz/*.c" )
+
+set( WEBRTC_APPLICATION_SDP_FUZZ_TARGETS WebRTCLinuxSdpFuzz )
+
+# libFuzzer only comes with Clang, the replay and mutation driver builds everywhere.
+if( CMAKE_C_COMPILER_ID MATCHES "Clang" )
+    list( APPEND WEBRTC_APPLICATION_SDP_FUZZ_TARGETS WebRTCLinuxSdpLibFuzzer )
+endif()
+
+foreach( SDP_FUZZ_TARGET ${WEBRTC_APPLICATION_SDP_FUZZ_TARGETS} )
+    add_executable(
+        ${SDP_FUZZ_TARGET}
+        ${WEBRTC_APPLICATION_SDP_FUZZ_SOURCE_FILES}
+        ${WEBRTC_APPLICATION_NETWORKING_UTILS_SOURCE_FILES}
+        ${WEBRTC_APPLICATION_COMMON_UTILS_SOURCE_FILES}
+        ${WEBRTC_APPLICATION_SDP_CONTROLLER_SOURCE_FILES}
+        ${WEBRTC_APPLICATION_ICE_CONTROLLER_SOURCE_FILES}
+        ${WEBRTC_APPLICATION_MBEDTLS_SOURCE_FILES}
+        ${WEBRTC_APPLICATION_LIBSRTP_SOURCE_FILES} )
+
+    target_include_directories( ${SDP_FUZZ_TARGET} PRIVATE
+                                ${WEBRTC_APPLICATION_NETWORKING_UTILS_INCLUDE_DIRS}
+                                ${WEBRTC_APPLICATION_COMMON_UTILS_INCLUDE_DIRS}
+                                ${WEBRTC_APPLICATION_SDP_CONTROLLER_INCLUDE_DIRS}
+                                ${WEBRTC_APPLICATION_ICE_CONTROLLER_INCLUDE_DIRS}
+                                ${WEBRTC_APPLICATION_MBEDTLS_INCLUDE_DIRS}
+                                ${WEBRTC_APPLICATION_LIBSRTP_INCLUDE_DIRS} )
+
+    # Rejected inputs are the common case while fuzzing, don't log them.
+    target_compile_definitions( ${SDP_FUZZ_TARGET}
+                                PUBLIC
+                                MBEDTLS_CONFIG_FILE="mbedtls_custom_config.h"
+                                LIBRARY_LOG_LEVEL=LOG_NONE )
+
+    if( BUILD_USRSCTP_LIBRARY )
+        target_compile_definitions( ${SDP_FUZZ_TARGET} PRIVATE ENABLE_SCTP_DATA_CHANNEL=1 )
+    else()
+        target_compile_definitions( ${SDP_FUZZ_TARGET} PRIVATE ENABLE_SCTP_DATA_CHANNEL=0 )
+    endif()
+
+    if( METRIC_PRINT_ENABLED )
+        target_compile_definitions( ${SDP_FUZZ_TARGET} PRIVATE METRIC_PRINT_ENABLED=1 )
+    else()
+        target_compile_definitions( ${SDP_FUZZ_TARGET} PRIVATE METRIC_PRINT_ENABLED=0 )
+    endif()
+
+    target_link_libraries( ${SDP_FUZZ_TARGET}
+                           signaling
+                           corejson
+                           sdp
+                           ice
+                           rtcp
+                           rtp
+                           stun
+                           mbedtls
+                           libsrtp
+                           websockets
+                           rt
+                           pthread
+    )
+
+    if( BUILD_USRSCTP_LIBRARY )
+        target_link_libraries( ${SDP_FUZZ_TARGET}
+                               usrsctp
+                               dcep )
+    endif()
+
+    target_compile_options( ${SDP_FUZZ_TARGET} PRIVATE -Wall -Werror )
+endforeach()
+
+if( TARGET WebRTCLinuxSdpLibFuzzer )
+    target_compile_definitions( WebRTCLinuxSdpLibFuzzer PRIVATE SDP_FUZZ_LIBFUZZER=1 )
+    target_compile_options( WebRTCLinuxSdpLibFuzzer PRIVATE -g -fsanitize=fuzzer,address,undefined )
+    target_link_libraries( WebRTCLinuxSdpLibFuzzer -fsanitize=fuzzer,address,undefined )
+endif()
@@ -0,0 +1,29 @@
+file(
+  GLOB
+  WEBRTC_APPLICATION_SIGV4_BENCHMARK_SOURCE_FILES
+  "examples/sigv4_benchmark/*.c" )
+
+add_executable(
+    WebRTCLinuxSigV4Benchmark
+    ${WEBRTC_APPLICATION_SIGV4_BENCHMARK_SOURCE_FILES}
+    "examples/networking/networking_sigv4.c"
+    "examples/logging/logging.c"
+    ${WEBRTC_APPLICATION_NETWORKING_UTILS_SOURCE_FILES} )
+
+target_include_directories( WebRTCLinuxSigV4Benchmark PRIVATE
+                            "examples/networking/"
+                            "examples/logging/"
+                            ${WEBRTC_APPLICATION_NETWORKING_UTILS_INCLUDE_DIRS}
+                            ${WEBRTC_APPLICATION_MBEDTLS_INCLUDE_DIRS} )
+
+target_compile_definitions( WebRTCLinuxSigV4Benchmark
+                            PUBLIC
+                            MBEDTLS_CONFIG_FILE="mbedtls_custom_config.h" )
+
+target_link_libraries( WebRTCLinuxSigV4Benchmark
+                       mbedtls
+                       rt
+                       pthread
+)
+
+target_compile_options( WebRTCLinuxSigV4Benchmark PRIVATE -Wall -Werror )
@@ -0,0 +1,66 @@
+file(
+  GLOB
+  WEBRTC_APPLICATION_SIGNALING_PARSE_BENCHMARK_SOURCE_FILES
+  "examples/signaling_parse_benchmark/*.c" )
+
+add_executable(
+    WebRTCLinuxSignalingParseBenchmark
+    ${WEBRTC_APPLICATION_SIGNALING_PARSE_BENCHMARK_SOURCE_FILES}
+    ${WEBRTC_APPLICATION_SIGNALING_CONTROLLER_SOURCE_FILES}
+    ${WEBRTC_APPLICATION_NETWORKING_LIBWEBSOCKETS_SOURCE_FILES}
+    ${WEBRTC_APPLICATION_NETWORKING_UTILS_SOURCE_FILES}
+    ${WEBRTC_APPLICATION_COMMON_UTILS_SOURCE_FILES}
+    ${WEBRTC_APPLICATION_SDP_CONTROLLER_SOURCE_FILES}
+    ${WEBRTC_APPLICATION_ICE_CONTROLLER_SOURCE_FILES}
+    ${WEBRTC_APPLICATION_MBEDTLS_SOURCE_FILES}
+    ${WEBRTC_APPLICATION_LIBSRTP_SOURCE_FILES} )
+
+target_include_directories( WebRTCLinuxSignalingParseBenchmark PRIVATE
+                            ${WEBRTC_APPLICATION_NETWORKING_LIBWEBSOCKETS_INCLUDE_DIRS}
+                            ${WEBRTC_APPLICATION_NETWORKING_UTILS_INCLUDE_DIRS}
+                            ${WEBRTC_APPLICATION_SIGNALING_CONTROLLER_INCLUDE_DIRS}
+                            ${WEBRTC_APPLICATION_COMMON_UTILS_INCLUDE_DIRS}
+                            ${WEBRTC_APPLICATION_SDP_CONTROLLER_INCLUDE_DIRS}
+                            ${WEBRTC_APPLICATION_ICE_CONTROLLER_INCLUDE_DIRS}
+                            ${WEBRTC_APPLICATION_MBEDTLS_INCLUDE_DIRS}
+                            ${WEBRTC_APPLICATION_LIBSRTP_INCLUDE_DIRS}
+                            ${LIBWEBSOCKETS_INCLUDE_DIRS} )
+
+target_compile_definitions( WebRTCLinuxSignalingParseBenchmark
+                            PUBLIC
+                            MBEDTLS_CONFIG_FILE="mbedtls_custom_config.h" )
+
+if( BUILD_USRSCTP_LIBRARY )
+    target_compile_definitions( WebRTCLinuxSignalingParseBenchmark PRIVATE ENABLE_SCTP_DATA_CHANNEL=1 )
+else()
+    target_compile_definitions( WebRTCLinuxSignalingParseBenchmark PRIVATE ENABLE_SCTP_DATA_CHANNEL=0 )
+endif()
+
+if( METRIC_PRINT_ENABLED )
+    target_compile_definitions( WebRTCLinuxSignalingParseBenchmark PRIVATE METRIC_PRINT_ENABLED=1 )
+else()
+    target_compile_definitions( WebRTCLinuxSignalingParseBenchmark PRIVATE METRIC_PRINT_ENABLED=0 )
+endif()
+
+target_link_libraries( WebRTCLinuxSignalingParseBenchmark
+                       signaling
+                       corejson
+                       sdp
+                       ice
+                       rtcp
+                       rtp
+                       stun
+                       mbedtls
+                       libsrtp
+                       websockets
+                       rt
+                       pthread
+)
+
+if( BUILD_USRSCTP_LIBRARY )
+    target_link_libraries( WebRTCLinuxSignalingParseBenchmark
+                           usrsctp
+                           dcep )
+endif()
+
+target_compile_options( WebRTCLinuxSignalingParseBenchmark PRIVATE -Wall -Werror )
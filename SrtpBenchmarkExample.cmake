@@ -0,0 +1,25 @@
+file(
+  GLOB
+  WEBRTC_APPLICATION_SRTP_BENCHMARK_SOURCE_FILES
+  "examples/srtp_benchmark/*.c" )
+
+add_executable(
+    WebRTCLinuxSrtpBenchmark
+    ${WEBRTC_APPLICATION_SRTP_BENCHMARK_SOURCE_FILES} )
+
+target_include_directories( WebRTCLinuxSrtpBenchmark PRIVATE
+                            ${WEBRTC_APPLICATION_MBEDTLS_INCLUDE_DIRS} )
+
+target_compile_definitions( WebRTCLinuxSrtpBenchmark
+                            PUBLIC
+                            MBEDTLS_CONFIG_FILE="mbedtls_custom_config.h" )
+
+## libsrtp brings its include directories
+target_link_libraries( WebRTCLinuxSrtpBenchmark
+                       libsrtp
+                       mbedtls
+                       rt
+                       pthread
+)
+
+target_compile_options( WebRTCLinuxSrtpBenchmark PRIVATE -Wall -Werror )
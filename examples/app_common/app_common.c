@@ -127,8 +127,12 @@ static PeerConnectionResult_t HandleRxVideoFrame( void * pCustomContext,
                                                   PeerConnectionFrame_t * pFrame );
 static PeerConnectionResult_t HandleRxAudioFrame( void * pCustomContext,
                                                   PeerConnectionFrame_t * pFrame );
+static int32_t GrowSdpBuffers( AppSdpBuffers_t * pSdpBuffers,
+                               size_t constructedBufferSize );
 static void HandleSdpOffer( AppContext_t * pAppContext,
-                            const SignalingMessage_t * pSignalingMessage );
+                            AppSdpBuffers_t * pSdpBuffers,
+                            const SignalingMessage_t * pSignalingMessage,
+                            uint64_t receivedTimeUs );
 static void HandleRemoteCandidate( AppContext_t * pAppContext,
                                    const SignalingMessage_t * pSignalingMessage );
 static void HandleIceServerReconnect( AppContext_t * pAppContext,
@@ -138,6 +142,10 @@ static void HandleLocalCandidateReady( void * pCustomContext,
                                        PeerConnectionIceLocalCandidate_t * pIceLocalCandidate );
 static int OnSignalingMessageReceived( SignalingMessage_t * pSignalingMessage,
                                        void * pUserData );
+static void HandleSignalingMessage( void * pUserData,
+                                    uint32_t workerIndex,
+                                    const SignalingMessage_t * pSignalingMessage,
+                                    uint64_t receivedTimeUs );
 
 #if ENABLE_SCTP_DATA_CHANNEL
     #if ( DATACHANNEL_CUSTOM_CALLBACK_HOOK != 0 )
@@ -149,6 +157,25 @@ static int OnSignalingMessageReceived( SignalingMessage_t * pSignalingMessage,
 #endif /* ENABLE_SCTP_DATA_CHANNEL */
 
 
+static void HandleKeyFrameRequest( void * pCustomContext,
+                                   uint32_t ssrc )
+{
+    AppContext_t * pAppContext = ( AppContext_t * ) pCustomContext;
+
+    if( pAppContext->requestKeyFrameFunc != NULL )
+    {
+        LogDebug( ( "Request keyframe from media source for ssrc: %u", ssrc ) );
+        pAppContext->requestKeyFrameFunc( pAppContext->pAppMediaSourcesContext );
+    }
+}
+
+static void HandlePictureLossIndication( void * pCustomContext,
+                                         RtcpPliPacket_t * pRtcpPliPacket )
+{
+    HandleKeyFrameRequest( pCustomContext,
+                           pRtcpPliPacket->mediaSourceSsrc );
+}
+
 static int32_t StartPeerConnectionSession( AppContext_t * pAppContext,
                                            AppSession_t * pAppSession,
                                            const char * pRemoteClientId,
@@ -167,6 +194,10 @@ static int32_t StartPeerConnectionSession( AppContext_t * pAppContext,
 
     if( ret == 0 )
     {
+        /* Drop the frames left from previous session of this viewer. */
+        AppEgress_ResetViewer( &pAppContext->egressContext,
+                               ( uint32_t )( pAppSession - pAppContext->appSessions ) );
+
         memset( &pcConfig, 0, sizeof( PeerConnectionSessionConfiguration_t ) );
         pcConfig.iceServersCount = ICE_CONTROLLER_MAX_ICE_SERVER_COUNT;
         #if defined( AWS_CA_CERT_PATH )
@@ -210,6 +241,30 @@ static int32_t StartPeerConnectionSession( AppContext_t * pAppContext,
         }
     }
 
+    if( ret == 0 )
+    {
+        peerConnectionResult = PeerConnection_SetKeyFrameRequestCallback( &pAppSession->peerConnectionSession,
+                                                                          HandleKeyFrameRequest,
+                                                                          pAppContext );
+        if( peerConnectionResult != PEER_CONNECTION_RESULT_OK )
+        {
+            LogWarn( ( "PeerConnection_SetKeyFrameRequestCallback fail, result: %d", peerConnectionResult ) );
+            ret = -1;
+        }
+    }
+
+    if( ret == 0 )
+    {
+        peerConnectionResult = PeerConnection_SetPictureLossIndicationCallback( &pAppSession->peerConnectionSession,
+                                                                                HandlePictureLossIndication,
+                                                                                pAppContext );
+        if( peerConnectionResult != PEER_CONNECTION_RESULT_OK )
+        {
+            LogWarn( ( "PeerConnection_SetPictureLossIndicationCallback fail, result: %d", peerConnectionResult ) );
+            ret = -1;
+        }
+    }
+
     /* Add video transceiver */
     if( ret == 0 )
     {
@@ -419,7 +474,7 @@ static int32_t GetIceServerList( AppContext_t * pAppContext,
     int32_t skipProcess = 0;
     int32_t parseResult = 0;
     SignalingControllerResult_t signalingControllerReturn;
-    IceServerConfig_t * pIceServerConfigs;
+    IceServerConfig_t * pIceServerConfigs = NULL;
     size_t iceServerConfigsCount;
     char * pStunUrlPostfix;
     int written;
@@ -567,6 +622,13 @@ static int32_t GetIceServerList( AppContext_t * pAppContext,
         }
     }
 
+    if( pIceServerConfigs != NULL )
+    {
+        /* Everything needed is copied, let the configs be refreshed. */
+        SignalingController_ReleaseIceServerConfigs( &pAppContext->signalingControllerContext,
+                                                     pIceServerConfigs );
+    }
+
     if( skipProcess == 0 )
     {
         *pOutputIceServersCount = currentIceServerIndex;
@@ -748,34 +810,49 @@ static AppSession_t * GetCreatePeerConnectionSession( AppContext_t * pAppContext
     AppSession_t * pAppSession = NULL;
     int i;
     int32_t initResult;
+    uint8_t needStart = 0U;
 
-    for( i = 0; i < AWS_MAX_VIEWER_NUM; i++ )
+    /* Messages of one remote client are always handled by the same signaling
+     * worker, so only different clients race here for a free session. */
+    pthread_mutex_lock( &pAppContext->sessionMutex );
     {
-        if( ( pAppContext->appSessions[i].remoteClientIdLength == remoteClientIdLength ) &&
-            ( strncmp( pAppContext->appSessions[i].remoteClientId, pRemoteClientId, remoteClientIdLength ) == 0 ) )
-        {
-            /* Found existing session. */
-            pAppSession = &pAppContext->appSessions[i];
-            break;
-        }
-        else if( ( allowCreate != 0 ) &&
-                 ( pAppSession == NULL ) &&
-                 ( pAppContext->appSessions[i].peerConnectionSession.state == PEER_CONNECTION_SESSION_STATE_INITED ) )
+        for( i = 0; i < AWS_MAX_VIEWER_NUM; i++ )
         {
-            /* Found free session, keep looping to find existing one. */
-            pAppSession = &pAppContext->appSessions[i];
+            if( ( pAppContext->appSessions[i].remoteClientIdLength == remoteClientIdLength ) &&
+                ( strncmp( pAppContext->appSessions[i].remoteClientId, pRemoteClientId, remoteClientIdLength ) == 0 ) )
+            {
+                /* Found existing session. */
+                pAppSession = &pAppContext->appSessions[i];
+                break;
+            }
+            else if( ( allowCreate != 0 ) &&
+                     ( pAppSession == NULL ) &&
+                     ( pAppContext->appSessions[i].isStarting == 0U ) &&
+                     ( pAppContext->appSessions[i].peerConnectionSession.state == PEER_CONNECTION_SESSION_STATE_INITED ) )
+            {
+                /* Found free session, keep looping to find existing one. */
+                pAppSession = &pAppContext->appSessions[i];
+            }
+            else
+            {
+                /* Do nothing. */
+            }
         }
-        else
+
+        if( ( pAppSession != NULL ) && ( pAppSession->peerConnectionSession.state == PEER_CONNECTION_SESSION_STATE_INITED ) )
         {
-            /* Do nothing. */
+            /* Reserve the session, the other workers skip it while it's starting. */
+            pAppSession->isStarting = 1U;
+            needStart = 1U;
         }
     }
+    pthread_mutex_unlock( &pAppContext->sessionMutex );
 
-    if( ( pAppSession != NULL ) && ( pAppSession->peerConnectionSession.state == PEER_CONNECTION_SESSION_STATE_INITED ) )
+    if( needStart != 0U )
     {
         /* Initialize Peer Connection. */
         LogDebug( ( "Start peer connection on idx: %d for client ID(%lu): %.*s",
-                    i,
+                    ( int ) ( pAppSession - pAppContext->appSessions ),
                     remoteClientIdLength,
                     ( int ) remoteClientIdLength,
                     pRemoteClientId ) );
@@ -783,6 +860,11 @@ static AppSession_t * GetCreatePeerConnectionSession( AppContext_t * pAppContext
                                                  pAppSession,
                                                  pRemoteClientId,
                                                  remoteClientIdLength );
+
+        pthread_mutex_lock( &pAppContext->sessionMutex );
+        pAppSession->isStarting = 0U;
+        pthread_mutex_unlock( &pAppContext->sessionMutex );
+
         if( initResult != 0 )
         {
             pAppSession = NULL;
@@ -860,8 +942,53 @@ static PeerConnectionResult_t HandleRxAudioFrame( void * pCustomContext,
     return PEER_CONNECTION_RESULT_OK;
 }
 
+static int32_t GrowSdpBuffers( AppSdpBuffers_t * pSdpBuffers,
+                               size_t constructedBufferSize )
+{
+    int32_t ret = 0;
+    char * pNewBuffer = NULL;
+
+    if( constructedBufferSize > pSdpBuffers->sdpConstructedBufferSize )
+    {
+        pNewBuffer = ( char * ) realloc( pSdpBuffers->pSdpConstructedBuffer,
+                                         constructedBufferSize );
+        if( pNewBuffer == NULL )
+        {
+            LogError( ( "Fail to allocate %lu bytes for SDP constructed buffer", constructedBufferSize ) );
+            ret = -1;
+        }
+        else
+        {
+            pSdpBuffers->pSdpConstructedBuffer = pNewBuffer;
+            pSdpBuffers->sdpConstructedBufferSize = constructedBufferSize;
+        }
+    }
+
+    /* Escaping the newlines for signaling at most doubles the answer length. */
+    if( ( ret == 0 ) &&
+        ( constructedBufferSize * 2U > pSdpBuffers->sdpBufferSize ) )
+    {
+        pNewBuffer = ( char * ) realloc( pSdpBuffers->pSdpBuffer,
+                                         constructedBufferSize * 2U );
+        if( pNewBuffer == NULL )
+        {
+            LogError( ( "Fail to allocate %lu bytes for SDP buffer", constructedBufferSize * 2U ) );
+            ret = -1;
+        }
+        else
+        {
+            pSdpBuffers->pSdpBuffer = pNewBuffer;
+            pSdpBuffers->sdpBufferSize = constructedBufferSize * 2U;
+        }
+    }
+
+    return ret;
+}
+
 static void HandleSdpOffer( AppContext_t * pAppContext,
-                            const SignalingMessage_t * pSignalingMessage )
+                            AppSdpBuffers_t * pSdpBuffers,
+                            const SignalingMessage_t * pSignalingMessage,
+                            uint64_t receivedTimeUs )
 {
     uint8_t skipProcess = 0;
     SignalingControllerResult_t signalingControllerReturn;
@@ -869,15 +996,18 @@ static void HandleSdpOffer( AppContext_t * pAppContext,
     size_t sdpOfferMessageLength = 0;
     PeerConnectionResult_t peerConnectionResult;
     PeerConnectionBufferSessionDescription_t bufferSessionDescription;
+    char * pFormalSdpMessage = NULL;
     size_t formalSdpMessageLength = 0;
     size_t sdpAnswerMessageLength = 0;
     AppSession_t * pAppSession = NULL;
     SignalingMessage_t signalingMessageSdpAnswer;
+    uint64_t startTimeUs = NetworkingUtils_GetCurrentTimeUs( NULL );
 
     if( ( pAppContext == NULL ) ||
+        ( pSdpBuffers == NULL ) ||
         ( pSignalingMessage == NULL ) )
     {
-        LogError( ( "Invalid input, pAppContext: %p, pEvent: %p", pAppContext, pSignalingMessage ) );
+        LogError( ( "Invalid input, pAppContext: %p, pSdpBuffers: %p, pEvent: %p", pAppContext, pSdpBuffers, pSignalingMessage ) );
         skipProcess = 1;
     }
 
@@ -902,12 +1032,12 @@ static void HandleSdpOffer( AppContext_t * pAppContext,
     if( skipProcess == 0 )
     {
         /* Translate the newline into SDP formal format. The end pattern from signaling event message is "\\n" or "\\r\\n",
-         * so we replace that with "\n" by calling this function. Note that this doesn't support inplace replacement. */
-        formalSdpMessageLength = PEER_CONNECTION_SDP_DESCRIPTION_BUFFER_MAX_LENGTH;
-        signalingControllerReturn = SignalingController_DeserializeSdpContentNewline( pSdpOfferMessage,
-                                                                                      sdpOfferMessageLength,
-                                                                                      pAppContext->sdpBuffer,
-                                                                                      &formalSdpMessageLength );
+         * so we replace that with "\r\n". The SDP lies in the worker's copy of the message, so it's rewritten in place
+         * and handed to the peer connection from there. */
+        pFormalSdpMessage = ( char * ) pSdpOfferMessage;
+        formalSdpMessageLength = sdpOfferMessageLength;
+        signalingControllerReturn = SignalingController_DeserializeSdpContentNewlineInPlace( pFormalSdpMessage,
+                                                                                             &formalSdpMessageLength );
         if( signalingControllerReturn != SIGNALING_CONTROLLER_RESULT_OK )
         {
             LogError( ( "Fail to deserialize SDP offer newline, result: %d, event message(%lu): %.*s.",
@@ -937,7 +1067,7 @@ static void HandleSdpOffer( AppContext_t * pAppContext,
 
     if( skipProcess == 0 )
     {
-        bufferSessionDescription.pSdpBuffer = pAppContext->sdpBuffer;
+        bufferSessionDescription.pSdpBuffer = pFormalSdpMessage;
         bufferSessionDescription.sdpBufferLength = formalSdpMessageLength;
         bufferSessionDescription.type = SDP_CONTROLLER_MESSAGE_TYPE_OFFER;
         peerConnectionResult = PeerConnection_SetRemoteDescription( &pAppSession->peerConnectionSession,
@@ -972,11 +1102,20 @@ static void HandleSdpOffer( AppContext_t * pAppContext,
         }
     }
 
-    if( skipProcess == 0 )
+    if( ( skipProcess == 0 ) &&
+        ( GrowSdpBuffers( pSdpBuffers, PEER_CONNECTION_SDP_DESCRIPTION_BUFFER_MAX_LENGTH ) != 0 ) )
+    {
+        skipProcess = 1;
+    }
+
+    /* Answers with many media sections can outgrow the buffers, double them and create the answer again. */
+    peerConnectionResult = PEER_CONNECTION_RESULT_FAIL_SDP_BUFFER_TOO_SMALL;
+    while( ( skipProcess == 0 ) &&
+           ( peerConnectionResult == PEER_CONNECTION_RESULT_FAIL_SDP_BUFFER_TOO_SMALL ) )
     {
         memset( &bufferSessionDescription, 0, sizeof( PeerConnectionBufferSessionDescription_t ) );
-        bufferSessionDescription.pSdpBuffer = pAppContext->sdpBuffer;
-        bufferSessionDescription.sdpBufferLength = PEER_CONNECTION_SDP_DESCRIPTION_BUFFER_MAX_LENGTH;
+        bufferSessionDescription.pSdpBuffer = pSdpBuffers->pSdpBuffer;
+        bufferSessionDescription.sdpBufferLength = pSdpBuffers->sdpBufferSize;
         peerConnectionResult = PeerConnection_SetLocalDescription( &pAppSession->peerConnectionSession,
                                                                    &bufferSessionDescription );
         if( peerConnectionResult != PEER_CONNECTION_RESULT_OK )
@@ -984,37 +1123,50 @@ static void HandleSdpOffer( AppContext_t * pAppContext,
             LogWarn( ( "PeerConnection_SetLocalDescription fail, result: %d.", peerConnectionResult ) );
             skipProcess = 1;
         }
-    }
 
-    if( skipProcess == 0 )
-    {
-        pAppContext->sdpConstructedBufferLength = PEER_CONNECTION_SDP_DESCRIPTION_BUFFER_MAX_LENGTH;
-        peerConnectionResult = PeerConnection_CreateAnswer( &pAppSession->peerConnectionSession,
-                                                            &bufferSessionDescription,
-                                                            pAppContext->sdpConstructedBuffer,
-                                                            &pAppContext->sdpConstructedBufferLength );
-        if( peerConnectionResult != PEER_CONNECTION_RESULT_OK )
+        if( skipProcess == 0 )
         {
-            LogWarn( ( "PeerConnection_CreateAnswer fail, result: %d.", peerConnectionResult ) );
-            skipProcess = 1;
+            pSdpBuffers->sdpConstructedBufferLength = pSdpBuffers->sdpConstructedBufferSize;
+            peerConnectionResult = PeerConnection_CreateAnswer( &pAppSession->peerConnectionSession,
+                                                                &bufferSessionDescription,
+                                                                pSdpBuffers->pSdpConstructedBuffer,
+                                                                &pSdpBuffers->sdpConstructedBufferLength );
+            if( ( peerConnectionResult == PEER_CONNECTION_RESULT_FAIL_SDP_BUFFER_TOO_SMALL ) &&
+                ( pSdpBuffers->sdpConstructedBufferSize < PEER_CONNECTION_SDP_TEMPLATE_MAX_LENGTH ) )
+            {
+                LogInfo( ( "SDP answer exceeds %lu bytes, growing the SDP buffers.", pSdpBuffers->sdpConstructedBufferSize ) );
+                if( GrowSdpBuffers( pSdpBuffers, MIN( pSdpBuffers->sdpConstructedBufferSize * 2U, PEER_CONNECTION_SDP_TEMPLATE_MAX_LENGTH ) ) != 0 )
+                {
+                    skipProcess = 1;
+                }
+            }
+            else if( peerConnectionResult != PEER_CONNECTION_RESULT_OK )
+            {
+                LogWarn( ( "PeerConnection_CreateAnswer fail, result: %d.", peerConnectionResult ) );
+                skipProcess = 1;
+            }
+            else
+            {
+                /* Empty else marker. */
+            }
         }
     }
 
     if( skipProcess == 0 )
     {
         /* Translate from SDP formal format into signaling event message by replacing newline with "\\n" or "\\r\\n". */
-        sdpAnswerMessageLength = PEER_CONNECTION_SDP_DESCRIPTION_BUFFER_MAX_LENGTH;
-        signalingControllerReturn = SignalingController_SerializeSdpContentNewline( pAppContext->sdpConstructedBuffer,
-                                                                                    pAppContext->sdpConstructedBufferLength,
-                                                                                    pAppContext->sdpBuffer,
+        sdpAnswerMessageLength = pSdpBuffers->sdpBufferSize;
+        signalingControllerReturn = SignalingController_SerializeSdpContentNewline( pSdpBuffers->pSdpConstructedBuffer,
+                                                                                    pSdpBuffers->sdpConstructedBufferLength,
+                                                                                    pSdpBuffers->pSdpBuffer,
                                                                                     &sdpAnswerMessageLength );
         if( signalingControllerReturn != SIGNALING_CONTROLLER_RESULT_OK )
         {
             LogError( ( "Fail to deserialize SDP offer newline, result: %d, constructed buffer(%lu): %.*s",
                         signalingControllerReturn,
-                        pAppContext->sdpConstructedBufferLength,
-                        ( int ) pAppContext->sdpConstructedBufferLength,
-                        pAppContext->sdpConstructedBuffer ) );
+                        pSdpBuffers->sdpConstructedBufferLength,
+                        ( int ) pSdpBuffers->sdpConstructedBufferLength,
+                        pSdpBuffers->pSdpConstructedBuffer ) );
             skipProcess = 1;
         }
     }
@@ -1024,7 +1176,7 @@ static void HandleSdpOffer( AppContext_t * pAppContext,
         signalingMessageSdpAnswer.correlationIdLength = 0U;
         signalingMessageSdpAnswer.pCorrelationId = NULL;
         signalingMessageSdpAnswer.messageType = SIGNALING_TYPE_MESSAGE_SDP_ANSWER;
-        signalingMessageSdpAnswer.pMessage = pAppContext->sdpBuffer;
+        signalingMessageSdpAnswer.pMessage = pSdpBuffers->pSdpBuffer;
         signalingMessageSdpAnswer.messageLength = sdpAnswerMessageLength;
         signalingMessageSdpAnswer.pRemoteClientId = pSignalingMessage->pRemoteClientId;
         signalingMessageSdpAnswer.remoteClientIdLength = pSignalingMessage->remoteClientIdLength;
@@ -1036,6 +1188,15 @@ static void HandleSdpOffer( AppContext_t * pAppContext,
             skipProcess = 1;
             LogError( ( "Send signaling message fail, result: %d", signalingControllerReturn ) );
         }
+        else
+        {
+            LogInfo( ( "Answered SDP offer from client ID(%lu): %.*s, offer to answer: %lu us, queued: %lu us",
+                       pSignalingMessage->remoteClientIdLength,
+                       ( int ) pSignalingMessage->remoteClientIdLength,
+                       pSignalingMessage->pRemoteClientId,
+                       ( unsigned long ) ( NetworkingUtils_GetCurrentTimeUs( NULL ) - receivedTimeUs ),
+                       ( unsigned long ) ( startTimeUs - receivedTimeUs ) ) );
+        }
     }
 
     #if ENABLE_TWCC_SUPPORT
@@ -1215,8 +1376,9 @@ static void HandleLocalCandidateReady( void * pCustomContext,
         signalingMessage.pRemoteClientId = pAppSession->remoteClientId;
         signalingMessage.remoteClientIdLength = pAppSession->remoteClientIdLength;
 
-        signalingControllerReturn = SignalingController_SendMessage( pAppSession->pSignalingControllerContext,
-                                                                     &signalingMessage );
+        /* Candidates arrive in bursts, let the signaling controller coalesce them. */
+        signalingControllerReturn = SignalingController_SendMessageBatched( pAppSession->pSignalingControllerContext,
+                                                                            &signalingMessage );
         if( signalingControllerReturn != SIGNALING_CONTROLLER_RESULT_OK )
         {
             LogError( ( "Send signaling message fail, result: %d", signalingControllerReturn ) );
@@ -1224,7 +1386,7 @@ static void HandleLocalCandidateReady( void * pCustomContext,
         }
         else
         {
-            LogDebug( ( "Sent local candidate to remote peer, msg(%d): %.*s",
+            LogDebug( ( "Queued local candidate to remote peer, msg(%d): %.*s",
                         written,
                         written,
                         &( buffer[ 0 ] ) ) );
@@ -1244,17 +1406,47 @@ static int OnSignalingMessageReceived( SignalingMessage_t * pSignalingMessage,
     LogDebug( ( "Message Length: %lu, Message:", pSignalingMessage->messageLength ) );
     LogDebug( ( "%.*s", ( int ) pSignalingMessage->messageLength, pSignalingMessage->pMessage ) );
 
+    /* Keep the websocket thread free, the workers do the heavy lifting. */
     switch( pSignalingMessage->messageType )
     {
         case SIGNALING_TYPE_MESSAGE_SDP_OFFER:
             #if METRIC_PRINT_ENABLED
                 Metric_StartEvent( METRIC_EVENT_SENDING_FIRST_FRAME );
             #endif
-            HandleSdpOffer( pAppContext,
-                            pSignalingMessage );
+            ( void ) AppSignalingWorker_Dispatch( &pAppContext->signalingWorkerPool,
+                                                  pSignalingMessage );
             break;
         case SIGNALING_TYPE_MESSAGE_SDP_ANSWER:
             break;
+        case SIGNALING_TYPE_MESSAGE_ICE_CANDIDATE:
+        case SIGNALING_TYPE_MESSAGE_RECONNECT_ICE_SERVER:
+            ( void ) AppSignalingWorker_Dispatch( &pAppContext->signalingWorkerPool,
+                                                  pSignalingMessage );
+            break;
+        case SIGNALING_TYPE_MESSAGE_STATUS_RESPONSE:
+            break;
+        default:
+            break;
+    }
+
+    return 0;
+}
+
+static void HandleSignalingMessage( void * pUserData,
+                                    uint32_t workerIndex,
+                                    const SignalingMessage_t * pSignalingMessage,
+                                    uint64_t receivedTimeUs )
+{
+    AppContext_t * pAppContext = ( AppContext_t * ) pUserData;
+
+    switch( pSignalingMessage->messageType )
+    {
+        case SIGNALING_TYPE_MESSAGE_SDP_OFFER:
+            HandleSdpOffer( pAppContext,
+                            &pAppContext->sdpBuffers[ workerIndex ],
+                            pSignalingMessage,
+                            receivedTimeUs );
+            break;
         case SIGNALING_TYPE_MESSAGE_ICE_CANDIDATE:
             HandleRemoteCandidate( pAppContext,
                                    pSignalingMessage );
@@ -1263,13 +1455,9 @@ static int OnSignalingMessageReceived( SignalingMessage_t * pSignalingMessage,
             HandleIceServerReconnect( pAppContext,
                                       pSignalingMessage );
             break;
-        case SIGNALING_TYPE_MESSAGE_STATUS_RESPONSE:
-            break;
         default:
             break;
     }
-
-    return 0;
 }
 
 #if ENABLE_SCTP_DATA_CHANNEL
@@ -1383,6 +1571,16 @@ int AppCommon_Init( AppContext_t * pAppContext,
         }
     }
 
+    if( ret == 0 )
+    {
+        if( pthread_mutex_init( &pAppContext->sessionMutex,
+                                NULL ) != 0 )
+        {
+            LogError( ( "Failed to create sessionMutex mutex" ) );
+            ret = -1;
+        }
+    }
+
     #if ENABLE_TWCC_SUPPORT
         if( pthread_mutex_init( &pAppContext->bitrateModifiedMutex,
                                 NULL ) != 0 )
@@ -1414,6 +1612,35 @@ int AppCommon_Init( AppContext_t * pAppContext,
         }
     }
 
+    if( ret == 0 )
+    {
+        ret = AppEgress_Init( &pAppContext->egressContext );
+    }
+
+    if( ret == 0 )
+    {
+        ret = AppSignalingWorker_Init( &pAppContext->signalingWorkerPool,
+                                       HandleSignalingMessage,
+                                       pAppContext );
+    }
+
+    if( ret == 0 )
+    {
+        for( i = 0; i < AWS_MAX_VIEWER_NUM; i++ )
+        {
+            ret = AppEgress_AddViewer( &pAppContext->egressContext,
+                                       i,
+                                       &pAppContext->appSessions[ i ].peerConnectionSession,
+                                       &pAppContext->appSessions[ i ].transceivers[ DEMO_TRANSCEIVER_MEDIA_INDEX_VIDEO ],
+                                       &pAppContext->appSessions[ i ].transceivers[ DEMO_TRANSCEIVER_MEDIA_INDEX_AUDIO ] );
+            if( ret != 0 )
+            {
+                LogError( ( "Fail to add egress viewer." ) );
+                break;
+            }
+        }
+    }
+
     return ret;
 }
 
@@ -1437,6 +1664,15 @@ int AppCommon_Start( AppContext_t * pAppContext )
             connectInfo.enableStorageSession = 1U;
         #endif
 
+        #if defined( SIGNALING_CACHE_FILE_PATH )
+            connectInfo.pCacheFilePath = SIGNALING_CACHE_FILE_PATH;
+        #endif
+
+        #if defined( AWS_KVS_CONTROL_PLANE_ENDPOINT )
+            connectInfo.pControlPlaneEndpoint = AWS_KVS_CONTROL_PLANE_ENDPOINT;
+            connectInfo.controlPlaneEndpointLength = strlen( AWS_KVS_CONTROL_PLANE_ENDPOINT );
+        #endif
+
         connectInfo.awsConfig.pRegion = AWS_REGION;
         connectInfo.awsConfig.regionLen = strlen( AWS_REGION );
         connectInfo.awsConfig.pService = "kinesisvideo";
@@ -21,6 +21,8 @@
 #include "sdp_controller.h"
 #include "signaling_controller.h"
 #include "peer_connection.h"
+#include "app_egress.h"
+#include "app_signaling_worker.h"
 
 #define DEMO_SDP_BUFFER_MAX_LENGTH ( 10000 )
 #define DEMO_TRANSCEIVER_MEDIA_INDEX_VIDEO ( 0 )
@@ -33,6 +35,7 @@ typedef struct AppMediaSourcesContext AppMediaSourcesContext_t;
 typedef int32_t ( * InitTransceiverFunc_t )( void * pCtx,
                                              TransceiverTrackKind_t trackKind,
                                              Transceiver_t * pTranceiver );
+typedef void ( * RequestKeyFrameFunc_t )( void * pCtx );
 
 typedef struct AppSession
 {
@@ -43,6 +46,9 @@ typedef struct AppSession
     /* Configuration. */
     uint8_t canTrickleIce;
 
+    /* Set while a signaling worker is starting this session, protected by sessionMutex. */
+    uint8_t isStarting;
+
     /* Peer connection session. */
     PeerConnectionSession_t peerConnectionSession;
     Transceiver_t transceivers[ PEER_CONNECTION_TRANSCEIVER_MAX_COUNT ];
@@ -54,23 +60,41 @@ typedef struct AppSession
     struct AppContext * pAppContext;
 } AppSession_t;
 
+/* SDP buffers, one set per signaling worker. They start at PEER_CONNECTION_SDP_DESCRIPTION_BUFFER_MAX_LENGTH
+ * and grow with the largest answer, up to PEER_CONNECTION_SDP_TEMPLATE_MAX_LENGTH. */
+typedef struct AppSdpBuffers
+{
+    char * pSdpConstructedBuffer;
+    size_t sdpConstructedBufferSize;
+    size_t sdpConstructedBufferLength;
+
+    /* Temp buffer of the local description, then the answer with escaped newlines. */
+    char * pSdpBuffer;
+    size_t sdpBufferSize;
+} AppSdpBuffers_t;
+
 typedef struct AppContext
 {
     /* Signaling controller. */
     SignalingControllerContext_t signalingControllerContext;
 
-    /* SDP buffers. */
-    char sdpConstructedBuffer[ PEER_CONNECTION_SDP_DESCRIPTION_BUFFER_MAX_LENGTH ];
-    size_t sdpConstructedBufferLength;
-
-    char sdpBuffer[ PEER_CONNECTION_SDP_DESCRIPTION_BUFFER_MAX_LENGTH ];
+    /* Received signaling messages are handled by the workers, off the websocket thread. */
+    AppSignalingWorkerPool_t signalingWorkerPool;
+    AppSdpBuffers_t sdpBuffers[ APP_SIGNALING_WORKER_NUM ];
 
     /* Peer Connection. */
     AppSession_t appSessions[ AWS_MAX_VIEWER_NUM ];
+    /* Serialize looking up and reserving sessions across signaling workers. */
+    pthread_mutex_t sessionMutex;
+
+    /* Send workers writing media frames to viewers. */
+    AppEgressContext_t egressContext;
 
     /* Media context. */
     InitTransceiverFunc_t initTransceiverFunc;
     AppMediaSourcesContext_t * pAppMediaSourcesContext;
+    /* Optional, NULL if the media source can't produce keyframe on demand. */
+    RequestKeyFrameFunc_t requestKeyFrameFunc;
 
     #if ENABLE_TWCC_SUPPORT
         pthread_mutex_t bitrateModifiedMutex;
@@ -0,0 +1,531 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+#include "logging.h"
+#include "app_egress.h"
+#if METRIC_PRINT_ENABLED
+#include "metric.h"
+#endif
+
+#define APP_EGRESS_QUEUE_MASK ( APP_EGRESS_QUEUE_LENGTH - 1U )
+
+#if ( APP_EGRESS_QUEUE_LENGTH & ( APP_EGRESS_QUEUE_LENGTH - 1 ) ) != 0
+    #error APP_EGRESS_QUEUE_LENGTH must be power of 2
+#endif
+
+static void QueueInit( AppEgressQueue_t * pQueue );
+static int32_t QueuePush( AppEgressQueue_t * pQueue,
+                          AppEgressFrame_t * pFrame );
+static AppEgressFrame_t * QueuePop( AppEgressQueue_t * pQueue );
+#if METRIC_PRINT_ENABLED
+static uint32_t QueueDepth( AppEgressQueue_t * pQueue );
+#endif
+static void ReleaseFrame( AppEgressFrame_t * pFrame );
+static void * EgressWorker_Task( void * pParameter );
+static void StopWorkers( AppEgressContext_t * pEgressContext,
+                         uint32_t startedWorkerNum,
+                         uint32_t createdFdNum );
+
+/*-----------------------------------------------------------*/
+
+static void QueueInit( AppEgressQueue_t * pQueue )
+{
+    uint32_t i;
+
+    for( i = 0; i < APP_EGRESS_QUEUE_LENGTH; i++ )
+    {
+        pQueue->cells[ i ].sequence = i;
+        pQueue->cells[ i ].pFrame = NULL;
+    }
+    pQueue->enqueuePosition = 0U;
+    pQueue->dequeuePosition = 0U;
+}
+
+/* Each cell carries a sequence telling whether it's free for the producer at that position
+ * or filled for the consumer at that position, so no lock is needed on either side. */
+static int32_t QueuePush( AppEgressQueue_t * pQueue,
+                          AppEgressFrame_t * pFrame )
+{
+    int32_t ret = -1;
+    AppEgressQueueCell_t * pCell;
+    uint32_t position = __atomic_load_n( &pQueue->enqueuePosition, __ATOMIC_RELAXED );
+    uint32_t sequence;
+    int32_t diff;
+
+    for( ;; )
+    {
+        pCell = &pQueue->cells[ position & APP_EGRESS_QUEUE_MASK ];
+        sequence = __atomic_load_n( &pCell->sequence, __ATOMIC_ACQUIRE );
+        diff = ( int32_t )( sequence - position );
+
+        if( diff == 0 )
+        {
+            if( __atomic_compare_exchange_n( &pQueue->enqueuePosition, &position, position + 1U,
+                                             1, __ATOMIC_RELAXED, __ATOMIC_RELAXED ) )
+            {
+                ret = 0;
+                break;
+            }
+        }
+        else if( diff < 0 )
+        {
+            /* Queue full. */
+            break;
+        }
+        else
+        {
+            position = __atomic_load_n( &pQueue->enqueuePosition, __ATOMIC_RELAXED );
+        }
+    }
+
+    if( ret == 0 )
+    {
+        pCell->pFrame = pFrame;
+        __atomic_store_n( &pCell->sequence, position + 1U, __ATOMIC_RELEASE );
+    }
+
+    return ret;
+}
+
+static AppEgressFrame_t * QueuePop( AppEgressQueue_t * pQueue )
+{
+    AppEgressFrame_t * pFrame = NULL;
+    AppEgressQueueCell_t * pCell;
+    uint32_t position = __atomic_load_n( &pQueue->dequeuePosition, __ATOMIC_RELAXED );
+    uint32_t sequence;
+    int32_t diff;
+    uint8_t isFound = 0U;
+
+    for( ;; )
+    {
+        pCell = &pQueue->cells[ position & APP_EGRESS_QUEUE_MASK ];
+        sequence = __atomic_load_n( &pCell->sequence, __ATOMIC_ACQUIRE );
+        diff = ( int32_t )( sequence - ( position + 1U ) );
+
+        if( diff == 0 )
+        {
+            if( __atomic_compare_exchange_n( &pQueue->dequeuePosition, &position, position + 1U,
+                                             1, __ATOMIC_RELAXED, __ATOMIC_RELAXED ) )
+            {
+                isFound = 1U;
+                break;
+            }
+        }
+        else if( diff < 0 )
+        {
+            /* Queue empty. */
+            break;
+        }
+        else
+        {
+            position = __atomic_load_n( &pQueue->dequeuePosition, __ATOMIC_RELAXED );
+        }
+    }
+
+    if( isFound != 0U )
+    {
+        pFrame = pCell->pFrame;
+        __atomic_store_n( &pCell->sequence, position + APP_EGRESS_QUEUE_LENGTH, __ATOMIC_RELEASE );
+    }
+
+    return pFrame;
+}
+
+#if METRIC_PRINT_ENABLED
+static uint32_t QueueDepth( AppEgressQueue_t * pQueue )
+{
+    return __atomic_load_n( &pQueue->enqueuePosition, __ATOMIC_RELAXED ) - __atomic_load_n( &pQueue->dequeuePosition, __ATOMIC_RELAXED );
+}
+#endif
+
+static void ReleaseFrame( AppEgressFrame_t * pFrame )
+{
+    if( __atomic_sub_fetch( &pFrame->refCount, 1U, __ATOMIC_ACQ_REL ) == 0U )
+    {
+        free( pFrame );
+    }
+}
+
+static void * EgressWorker_Task( void * pParameter )
+{
+    AppEgressWorker_t * pWorker = ( AppEgressWorker_t * ) pParameter;
+    AppEgressContext_t * pEgressContext = pWorker->pEgressContext;
+    AppEgressViewer_t * pViewer;
+    AppEgressFrame_t * pFrame;
+    PeerConnectionFrame_t peerConnectionFrame;
+    PeerConnectionResult_t peerConnectionResult;
+    Transceiver_t * pTransceiver;
+    uint64_t wakeupCount;
+    uint32_t i;
+    uint8_t isAnyFrame;
+
+    for( ;; )
+    {
+        if( read( pWorker->wakeupFd, &wakeupCount, sizeof( wakeupCount ) ) != sizeof( wakeupCount ) )
+        {
+            LogError( ( "Unexpected read from egress worker %u wakeup fd", pWorker->index ) );
+            continue;
+        }
+
+        if( __atomic_load_n( &pEgressContext->isStopping, __ATOMIC_ACQUIRE ) != 0U )
+        {
+            break;
+        }
+
+        /* Round robin across the viewers of this worker frame by frame, so one viewer can't starve the others. */
+        do
+        {
+            isAnyFrame = 0U;
+            for( i = pWorker->index; i < AWS_MAX_VIEWER_NUM; i += pEgressContext->workerNum )
+            {
+                pViewer = &pEgressContext->viewers[ i ];
+                pFrame = QueuePop( &pViewer->queue );
+                if( pFrame == NULL )
+                {
+                    continue;
+                }
+                isAnyFrame = 1U;
+
+                if( pViewer->pSession->state == PEER_CONNECTION_SESSION_STATE_CONNECTION_READY )
+                {
+                    pTransceiver = ( pFrame->trackKind == TRANSCEIVER_TRACK_KIND_VIDEO ) ? pViewer->pVideoTransceiver : pViewer->pAudioTransceiver;
+
+                    peerConnectionFrame.version = PEER_CONNECTION_FRAME_CURRENT_VERSION;
+                    peerConnectionFrame.presentationUs = pFrame->timestampUs;
+                    peerConnectionFrame.pData = pFrame->data;
+                    peerConnectionFrame.dataLength = pFrame->size;
+
+                    peerConnectionResult = PeerConnection_WriteFrame( pViewer->pSession,
+                                                                      pTransceiver,
+                                                                      &peerConnectionFrame );
+                    if( peerConnectionResult != PEER_CONNECTION_RESULT_OK )
+                    {
+                        LogError( ( "Fail to write %s frame to viewer %u, result: %d",
+                                    ( pFrame->trackKind == TRANSCEIVER_TRACK_KIND_VIDEO ) ? "video" : "audio",
+                                    i,
+                                    peerConnectionResult ) );
+                    }
+                }
+
+                ReleaseFrame( pFrame );
+            }
+        } while( isAnyFrame != 0U );
+    }
+
+    return NULL;
+}
+
+static void StopWorkers( AppEgressContext_t * pEgressContext,
+                         uint32_t startedWorkerNum,
+                         uint32_t createdFdNum )
+{
+    uint64_t wakeup = 1;
+    uint32_t i;
+
+    __atomic_store_n( &pEgressContext->isStopping, 1U, __ATOMIC_RELEASE );
+
+    for( i = 0; i < startedWorkerNum; i++ )
+    {
+        if( write( pEgressContext->workers[ i ].wakeupFd, &wakeup, sizeof( wakeup ) ) != sizeof( wakeup ) )
+        {
+            LogError( ( "Fail to wake up egress worker %u to stop", i ) );
+        }
+        else
+        {
+            pthread_join( pEgressContext->workers[ i ].thread, NULL );
+        }
+    }
+
+    for( i = 0; i < createdFdNum; i++ )
+    {
+        close( pEgressContext->workers[ i ].wakeupFd );
+        pEgressContext->workers[ i ].wakeupFd = -1;
+    }
+}
+
+int32_t AppEgress_Init( AppEgressContext_t * pEgressContext )
+{
+    int32_t ret = 0;
+    long onlineCores;
+    uint32_t i;
+    uint32_t startedWorkerNum = 0;
+    uint32_t createdFdNum = 0;
+
+    if( pEgressContext == NULL )
+    {
+        LogError( ( "Invalid input, pEgressContext: %p", pEgressContext ) );
+        ret = -1;
+    }
+
+    if( ret == 0 )
+    {
+        memset( pEgressContext, 0, sizeof( AppEgressContext_t ) );
+
+        for( i = 0; i < AWS_MAX_VIEWER_NUM; i++ )
+        {
+            QueueInit( &pEgressContext->viewers[ i ].queue );
+            pEgressContext->viewers[ i ].dropPolicy = APP_EGRESS_DEFAULT_DROP_POLICY;
+        }
+
+        onlineCores = sysconf( _SC_NPROCESSORS_ONLN );
+        pEgressContext->workerNum = ( onlineCores > 0 ) ? ( uint32_t ) onlineCores : 1U;
+        if( pEgressContext->workerNum > AWS_MAX_VIEWER_NUM )
+        {
+            pEgressContext->workerNum = AWS_MAX_VIEWER_NUM;
+        }
+        if( pEgressContext->workerNum > APP_EGRESS_MAX_WORKER_NUM )
+        {
+            pEgressContext->workerNum = APP_EGRESS_MAX_WORKER_NUM;
+        }
+
+        for( i = 0; i < AWS_MAX_VIEWER_NUM; i++ )
+        {
+            pEgressContext->viewers[ i ].workerIndex = i % pEgressContext->workerNum;
+        }
+    }
+
+    if( ret == 0 )
+    {
+        /* Workers are joinable so a failed init can stop the ones already started. */
+        for( i = 0; i < pEgressContext->workerNum; i++ )
+        {
+            pEgressContext->workers[ i ].index = i;
+            pEgressContext->workers[ i ].pEgressContext = pEgressContext;
+            pEgressContext->workers[ i ].wakeupFd = eventfd( 0, 0 );
+            if( pEgressContext->workers[ i ].wakeupFd < 0 )
+            {
+                LogError( ( "Fail to create wakeup fd for egress worker %u", i ) );
+                ret = -1;
+                break;
+            }
+            createdFdNum++;
+
+            if( pthread_create( &pEgressContext->workers[ i ].thread,
+                                NULL,
+                                EgressWorker_Task,
+                                &pEgressContext->workers[ i ] ) != 0 )
+            {
+                LogError( ( "Fail to create egress worker %u", i ) );
+                ret = -1;
+                break;
+            }
+            startedWorkerNum++;
+        }
+    }
+
+    if( ret == 0 )
+    {
+        LogInfo( ( "Started %u egress workers for %d viewers", pEgressContext->workerNum, AWS_MAX_VIEWER_NUM ) );
+    }
+    else if( pEgressContext != NULL )
+    {
+        StopWorkers( pEgressContext, startedWorkerNum, createdFdNum );
+    }
+    else
+    {
+        /* Empty else marker. */
+    }
+
+    return ret;
+}
+
+int32_t AppEgress_AddViewer( AppEgressContext_t * pEgressContext,
+                             uint32_t viewerIndex,
+                             PeerConnectionSession_t * pSession,
+                             Transceiver_t * pVideoTransceiver,
+                             Transceiver_t * pAudioTransceiver )
+{
+    int32_t ret = 0;
+
+    if( ( pEgressContext == NULL ) || ( viewerIndex >= AWS_MAX_VIEWER_NUM ) || ( pSession == NULL ) ||
+        ( pVideoTransceiver == NULL ) || ( pAudioTransceiver == NULL ) )
+    {
+        LogError( ( "Invalid input, pEgressContext: %p, viewerIndex: %u, pSession: %p, pVideoTransceiver: %p, pAudioTransceiver: %p",
+                    pEgressContext, viewerIndex, pSession, pVideoTransceiver, pAudioTransceiver ) );
+        ret = -1;
+    }
+
+    if( ret == 0 )
+    {
+        pEgressContext->viewers[ viewerIndex ].pSession = pSession;
+        pEgressContext->viewers[ viewerIndex ].pVideoTransceiver = pVideoTransceiver;
+        pEgressContext->viewers[ viewerIndex ].pAudioTransceiver = pAudioTransceiver;
+    }
+
+    return ret;
+}
+
+int32_t AppEgress_SetDropPolicy( AppEgressContext_t * pEgressContext,
+                                 uint32_t viewerIndex,
+                                 AppEgressDropPolicy_t dropPolicy )
+{
+    int32_t ret = 0;
+
+    if( ( pEgressContext == NULL ) || ( viewerIndex >= AWS_MAX_VIEWER_NUM ) )
+    {
+        LogError( ( "Invalid input, pEgressContext: %p, viewerIndex: %u", pEgressContext, viewerIndex ) );
+        ret = -1;
+    }
+
+    if( ret == 0 )
+    {
+        pEgressContext->viewers[ viewerIndex ].dropPolicy = dropPolicy;
+    }
+
+    return ret;
+}
+
+void AppEgress_ResetViewer( AppEgressContext_t * pEgressContext,
+                            uint32_t viewerIndex )
+{
+    AppEgressViewer_t * pViewer;
+    AppEgressFrame_t * pFrame;
+    uint32_t droppedFrames;
+
+    if( ( pEgressContext != NULL ) && ( viewerIndex < AWS_MAX_VIEWER_NUM ) )
+    {
+        pViewer = &pEgressContext->viewers[ viewerIndex ];
+
+        while( ( pFrame = QueuePop( &pViewer->queue ) ) != NULL )
+        {
+            ReleaseFrame( pFrame );
+        }
+
+        droppedFrames = __atomic_exchange_n( &pViewer->droppedFrames, 0U, __ATOMIC_RELAXED );
+        if( droppedFrames > 0U )
+        {
+            LogInfo( ( "Viewer %u dropped %u frames in previous session", viewerIndex, droppedFrames ) );
+        }
+        #if METRIC_PRINT_ENABLED
+            Metric_RecordHistogram( METRIC_HISTOGRAM_EGRESS_DROPPED_FRAMES, droppedFrames );
+        #endif
+    }
+}
+
+int32_t AppEgress_PushFrame( AppEgressContext_t * pEgressContext,
+                             TransceiverTrackKind_t trackKind,
+                             const uint8_t * pData,
+                             size_t size,
+                             uint64_t timestampUs )
+{
+    int32_t ret = 0;
+    AppEgressFrame_t * pFrame = NULL;
+    AppEgressViewer_t * pViewer;
+    uint64_t wakeup = 1;
+    uint8_t wakeupWorkers[ APP_EGRESS_MAX_WORKER_NUM ] = { 0 };
+    PeerConnectionFrame_t peerConnectionFrame;
+    uint8_t isDropped;
+    uint32_t i;
+
+    if( ( pEgressContext == NULL ) || ( pData == NULL ) )
+    {
+        LogError( ( "Invalid input, pEgressContext: %p, pData: %p", pEgressContext, pData ) );
+        ret = -1;
+    }
+
+    if( ret == 0 )
+    {
+        /* Copy once here, all viewers send from the same buffer. */
+        pFrame = ( AppEgressFrame_t * ) malloc( sizeof( AppEgressFrame_t ) + size );
+        if( pFrame == NULL )
+        {
+            LogError( ( "Fail to allocate egress frame, size: %lu", size ) );
+            ret = -1;
+        }
+    }
+
+    if( ret == 0 )
+    {
+        /* Hold one reference while handing the frame out. */
+        pFrame->refCount = 1U;
+        pFrame->trackKind = trackKind;
+        pFrame->timestampUs = timestampUs;
+        pFrame->size = size;
+        memcpy( pFrame->data, pData, size );
+
+        /* Cache from the source, so a viewer joining an idle stream still gets the latest keyframe. */
+        if( ( trackKind == TRANSCEIVER_TRACK_KIND_VIDEO ) &&
+            ( pEgressContext->viewers[ 0 ].pVideoTransceiver != NULL ) )
+        {
+            peerConnectionFrame.version = PEER_CONNECTION_FRAME_CURRENT_VERSION;
+            peerConnectionFrame.presentationUs = timestampUs;
+            peerConnectionFrame.pData = pFrame->data;
+            peerConnectionFrame.dataLength = size;
+
+            ( void ) PeerConnection_UpdateKeyFrameCache( pEgressContext->viewers[ 0 ].pVideoTransceiver,
+                                                         &peerConnectionFrame );
+        }
+
+        for( i = 0; i < AWS_MAX_VIEWER_NUM; i++ )
+        {
+            pViewer = &pEgressContext->viewers[ i ];
+            if( ( pViewer->pSession == NULL ) ||
+                ( pViewer->pSession->state != PEER_CONNECTION_SESSION_STATE_CONNECTION_READY ) )
+            {
+                continue;
+            }
+
+            isDropped = 0U;
+            __atomic_add_fetch( &pFrame->refCount, 1U, __ATOMIC_RELAXED );
+            if( QueuePush( &pViewer->queue, pFrame ) == 0 )
+            {
+                wakeupWorkers[ pViewer->workerIndex ] = 1U;
+            }
+            else
+            {
+                __atomic_sub_fetch( &pFrame->refCount, 1U, __ATOMIC_RELAXED );
+                isDropped = 1U;
+                if( ( trackKind == TRANSCEIVER_TRACK_KIND_VIDEO ) &&
+                    ( pViewer->dropPolicy == APP_EGRESS_DROP_POLICY_DROP_TO_KEYFRAME ) )
+                {
+                    /* The session drops the following video until next keyframe and asks the source for one. */
+                    ( void ) PeerConnection_RequestVideoResync( pViewer->pSession,
+                                                                pViewer->pVideoTransceiver );
+                }
+            }
+
+            if( isDropped != 0U )
+            {
+                __atomic_add_fetch( &pViewer->droppedFrames, 1U, __ATOMIC_RELAXED );
+                LogVerbose( ( "Drop %s frame for viewer %u", ( trackKind == TRANSCEIVER_TRACK_KIND_VIDEO ) ? "video" : "audio", i ) );
+            }
+
+            #if METRIC_PRINT_ENABLED
+                Metric_RecordHistogram( METRIC_HISTOGRAM_EGRESS_QUEUE_DEPTH, QueueDepth( &pViewer->queue ) );
+            #endif
+        }
+
+        for( i = 0; i < pEgressContext->workerNum; i++ )
+        {
+            if( wakeupWorkers[ i ] != 0U )
+            {
+                if( write( pEgressContext->workers[ i ].wakeupFd, &wakeup, sizeof( wakeup ) ) != sizeof( wakeup ) )
+                {
+                    LogWarn( ( "Fail to wake up egress worker %u", i ) );
+                }
+            }
+        }
+
+        ReleaseFrame( pFrame );
+    }
+
+    return ret;
+}
@@ -0,0 +1,140 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef APP_EGRESS_H
+#define APP_EGRESS_H
+
+#pragma once
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+extern "C" {
+#endif
+/* *INDENT-ON* */
+
+/* Standard includes. */
+#include <stdint.h>
+#include <pthread.h>
+
+#include "demo_config.h"
+#include "peer_connection.h"
+
+/* Maximum number of send workers, the actual number is min( online cores, viewers, this ). */
+#ifndef APP_EGRESS_MAX_WORKER_NUM
+#define APP_EGRESS_MAX_WORKER_NUM ( 8 )
+#endif
+
+/* Number of frames buffered per viewer, must be power of 2. */
+#ifndef APP_EGRESS_QUEUE_LENGTH
+#define APP_EGRESS_QUEUE_LENGTH ( 64 )
+#endif
+
+#ifndef APP_EGRESS_DEFAULT_DROP_POLICY
+#define APP_EGRESS_DEFAULT_DROP_POLICY ( APP_EGRESS_DROP_POLICY_DROP_TO_KEYFRAME )
+#endif
+
+typedef enum AppEgressDropPolicy
+{
+    /* Drop the incoming frame when the viewer queue is full. */
+    APP_EGRESS_DROP_POLICY_DROP_NEWEST = 0,
+    /* Same as above, but request the session to resync video at the next keyframe so the decoder never sees a broken reference. */
+    APP_EGRESS_DROP_POLICY_DROP_TO_KEYFRAME,
+} AppEgressDropPolicy_t;
+
+/* Frame shared by all viewers, freed when the last viewer finishes sending it. */
+typedef struct AppEgressFrame
+{
+    uint32_t refCount;
+    TransceiverTrackKind_t trackKind;
+    uint64_t timestampUs;
+    size_t size;
+    uint8_t data[];
+} AppEgressFrame_t;
+
+typedef struct AppEgressQueueCell
+{
+    uint32_t sequence;
+    AppEgressFrame_t * pFrame;
+} AppEgressQueueCell_t;
+
+/* Bounded lock-free multi-producer multi-consumer queue. */
+typedef struct AppEgressQueue
+{
+    AppEgressQueueCell_t cells[ APP_EGRESS_QUEUE_LENGTH ];
+    uint32_t enqueuePosition;
+    uint32_t dequeuePosition;
+} AppEgressQueue_t;
+
+typedef struct AppEgressViewer
+{
+    AppEgressQueue_t queue;
+    AppEgressDropPolicy_t dropPolicy;
+    uint32_t droppedFrames;
+    uint32_t workerIndex;
+
+    PeerConnectionSession_t * pSession;
+    Transceiver_t * pVideoTransceiver;
+    Transceiver_t * pAudioTransceiver;
+} AppEgressViewer_t;
+
+typedef struct AppEgressWorker
+{
+    pthread_t thread;
+    /* Producers signal the eventfd after enqueuing a frame for any viewer of this worker. */
+    int wakeupFd;
+    uint32_t index;
+    struct AppEgressContext * pEgressContext;
+} AppEgressWorker_t;
+
+typedef struct AppEgressContext
+{
+    AppEgressViewer_t viewers[ AWS_MAX_VIEWER_NUM ];
+    AppEgressWorker_t workers[ APP_EGRESS_MAX_WORKER_NUM ];
+    uint32_t workerNum;
+    /* Set before waking up the workers to make them exit, only when AppEgress_Init fails. */
+    uint8_t isStopping;
+} AppEgressContext_t;
+
+int32_t AppEgress_Init( AppEgressContext_t * pEgressContext );
+
+int32_t AppEgress_AddViewer( AppEgressContext_t * pEgressContext,
+                             uint32_t viewerIndex,
+                             PeerConnectionSession_t * pSession,
+                             Transceiver_t * pVideoTransceiver,
+                             Transceiver_t * pAudioTransceiver );
+
+int32_t AppEgress_SetDropPolicy( AppEgressContext_t * pEgressContext,
+                                 uint32_t viewerIndex,
+                                 AppEgressDropPolicy_t dropPolicy );
+
+/* Drop the frames queued for previous session of the viewer, call it before the viewer is reused. */
+void AppEgress_ResetViewer( AppEgressContext_t * pEgressContext,
+                            uint32_t viewerIndex );
+
+/* Copy the frame once and hand it to every ready viewer, it never blocks on sending. */
+int32_t AppEgress_PushFrame( AppEgressContext_t * pEgressContext,
+                             TransceiverTrackKind_t trackKind,
+                             const uint8_t * pData,
+                             size_t size,
+                             uint64_t timestampUs );
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+}
+#endif
+/* *INDENT-ON* */
+
+#endif /* APP_EGRESS_H */
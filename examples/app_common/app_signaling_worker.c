@@ -0,0 +1,239 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "logging.h"
+#include "networking_utils.h"
+#include "app_signaling_worker.h"
+
+static uint32_t GetWorkerIndex( const char * pRemoteClientId,
+                                size_t remoteClientIdLength );
+static void * SignalingWorker_Task( void * pParameter );
+
+/*-----------------------------------------------------------*/
+
+static uint32_t GetWorkerIndex( const char * pRemoteClientId,
+                                size_t remoteClientIdLength )
+{
+    /* FNV-1a, spreads the viewers across the workers. */
+    uint32_t hash = 2166136261U;
+    size_t i;
+
+    for( i = 0; i < remoteClientIdLength; i++ )
+    {
+        hash ^= ( uint8_t ) pRemoteClientId[ i ];
+        hash *= 16777619U;
+    }
+
+    return hash % APP_SIGNALING_WORKER_NUM;
+}
+
+static void * SignalingWorker_Task( void * pParameter )
+{
+    AppSignalingWorker_t * pWorker = ( AppSignalingWorker_t * ) pParameter;
+    AppSignalingWorkerPool_t * pPool = pWorker->pPool;
+    AppSignalingJob_t * pJob;
+
+    for( ;; )
+    {
+        pthread_mutex_lock( &pWorker->mutex );
+        {
+            while( pWorker->pHead == NULL )
+            {
+                pthread_cond_wait( &pWorker->cond,
+                                   &pWorker->mutex );
+            }
+
+            pJob = pWorker->pHead;
+            pWorker->pHead = pJob->pNext;
+            if( pWorker->pHead == NULL )
+            {
+                pWorker->pTail = NULL;
+            }
+            pWorker->queueLength--;
+        }
+        pthread_mutex_unlock( &pWorker->mutex );
+
+        pPool->handler( pPool->pUserData,
+                        pWorker->index,
+                        &pJob->signalingMessage,
+                        pJob->receivedTimeUs );
+
+        free( pJob );
+    }
+
+    return NULL;
+}
+
+int32_t AppSignalingWorker_Init( AppSignalingWorkerPool_t * pPool,
+                                 AppSignalingWorkerHandler_t handler,
+                                 void * pUserData )
+{
+    int32_t ret = 0;
+    uint32_t i;
+    pthread_attr_t threadAttr;
+
+    if( ( pPool == NULL ) || ( handler == NULL ) )
+    {
+        LogError( ( "Invalid input, pPool: %p, handler: %p", pPool, handler ) );
+        ret = -1;
+    }
+
+    if( ret == 0 )
+    {
+        memset( pPool, 0, sizeof( AppSignalingWorkerPool_t ) );
+        pPool->handler = handler;
+        pPool->pUserData = pUserData;
+
+        pthread_attr_init( &threadAttr );
+        pthread_attr_setdetachstate( &threadAttr, PTHREAD_CREATE_DETACHED );
+
+        for( i = 0; i < APP_SIGNALING_WORKER_NUM; i++ )
+        {
+            pPool->workers[ i ].index = i;
+            pPool->workers[ i ].pPool = pPool;
+
+            if( ( pthread_mutex_init( &pPool->workers[ i ].mutex, NULL ) != 0 ) ||
+                ( pthread_cond_init( &pPool->workers[ i ].cond, NULL ) != 0 ) )
+            {
+                LogError( ( "Fail to create lock for signaling worker %u", i ) );
+                ret = -1;
+                break;
+            }
+
+            if( pthread_create( &pPool->workers[ i ].thread,
+                                &threadAttr,
+                                SignalingWorker_Task,
+                                &pPool->workers[ i ] ) != 0 )
+            {
+                LogError( ( "Fail to create signaling worker %u", i ) );
+                ret = -1;
+                break;
+            }
+        }
+
+        pthread_attr_destroy( &threadAttr );
+    }
+
+    if( ret == 0 )
+    {
+        LogInfo( ( "Started %d signaling workers", APP_SIGNALING_WORKER_NUM ) );
+    }
+
+    return ret;
+}
+
+int32_t AppSignalingWorker_Dispatch( AppSignalingWorkerPool_t * pPool,
+                                     const SignalingMessage_t * pSignalingMessage )
+{
+    int32_t ret = 0;
+    AppSignalingWorker_t * pWorker = NULL;
+    AppSignalingJob_t * pJob = NULL;
+    SignalingMessage_t * pCopy;
+    char * pData;
+
+    if( ( pPool == NULL ) || ( pSignalingMessage == NULL ) )
+    {
+        LogError( ( "Invalid input, pPool: %p, pSignalingMessage: %p", pPool, pSignalingMessage ) );
+        ret = -1;
+    }
+
+    if( ret == 0 )
+    {
+        pJob = ( AppSignalingJob_t * ) malloc( sizeof( AppSignalingJob_t ) +
+                                               pSignalingMessage->remoteClientIdLength +
+                                               pSignalingMessage->correlationIdLength +
+                                               pSignalingMessage->messageLength );
+        if( pJob == NULL )
+        {
+            LogError( ( "Fail to allocate signaling job" ) );
+            ret = -1;
+        }
+    }
+
+    if( ret == 0 )
+    {
+        pJob->pNext = NULL;
+        pJob->receivedTimeUs = NetworkingUtils_GetCurrentTimeUs( NULL );
+
+        pCopy = &pJob->signalingMessage;
+        pData = pJob->data;
+        pCopy->messageType = pSignalingMessage->messageType;
+
+        pCopy->pRemoteClientId = pData;
+        pCopy->remoteClientIdLength = pSignalingMessage->remoteClientIdLength;
+        if( pSignalingMessage->remoteClientIdLength > 0U )
+        {
+            memcpy( pData, pSignalingMessage->pRemoteClientId, pSignalingMessage->remoteClientIdLength );
+            pData += pSignalingMessage->remoteClientIdLength;
+        }
+
+        pCopy->pCorrelationId = ( pSignalingMessage->correlationIdLength > 0U ) ? pData : NULL;
+        pCopy->correlationIdLength = pSignalingMessage->correlationIdLength;
+        if( pSignalingMessage->correlationIdLength > 0U )
+        {
+            memcpy( pData, pSignalingMessage->pCorrelationId, pSignalingMessage->correlationIdLength );
+            pData += pSignalingMessage->correlationIdLength;
+        }
+
+        pCopy->pMessage = pData;
+        pCopy->messageLength = pSignalingMessage->messageLength;
+        if( pSignalingMessage->messageLength > 0U )
+        {
+            memcpy( pData, pSignalingMessage->pMessage, pSignalingMessage->messageLength );
+        }
+
+        pWorker = &pPool->workers[ GetWorkerIndex( pSignalingMessage->pRemoteClientId,
+                                                   pSignalingMessage->remoteClientIdLength ) ];
+
+        pthread_mutex_lock( &pWorker->mutex );
+        {
+            if( pWorker->queueLength >= APP_SIGNALING_WORKER_QUEUE_MAX_LENGTH )
+            {
+                pWorker->droppedMessages++;
+                ret = -1;
+            }
+            else
+            {
+                if( pWorker->pTail == NULL )
+                {
+                    pWorker->pHead = pJob;
+                }
+                else
+                {
+                    pWorker->pTail->pNext = pJob;
+                }
+                pWorker->pTail = pJob;
+                pWorker->queueLength++;
+                pthread_cond_signal( &pWorker->cond );
+            }
+        }
+        pthread_mutex_unlock( &pWorker->mutex );
+
+        if( ret != 0 )
+        {
+            LogWarn( ( "Signaling worker %u is full, dropping message type %d, dropped: %u",
+                       pWorker->index,
+                       pSignalingMessage->messageType,
+                       pWorker->droppedMessages ) );
+            free( pJob );
+        }
+    }
+
+    return ret;
+}
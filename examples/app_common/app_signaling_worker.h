@@ -0,0 +1,95 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef APP_SIGNALING_WORKER_H
+#define APP_SIGNALING_WORKER_H
+
+#pragma once
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+extern "C" {
+#endif
+/* *INDENT-ON* */
+
+/* Standard includes. */
+#include <stdint.h>
+#include <pthread.h>
+
+#include "signaling_controller.h"
+
+/* Number of threads handling received signaling messages. */
+#ifndef APP_SIGNALING_WORKER_NUM
+#define APP_SIGNALING_WORKER_NUM ( 4 )
+#endif
+
+/* Messages waiting per worker, new messages are dropped above this. */
+#ifndef APP_SIGNALING_WORKER_QUEUE_MAX_LENGTH
+#define APP_SIGNALING_WORKER_QUEUE_MAX_LENGTH ( 64 )
+#endif
+
+/* Called in the worker thread, pSignalingMessage is only valid during the call.
+ * The message is the worker's own copy, the handler may rewrite it in place. */
+typedef void ( * AppSignalingWorkerHandler_t )( void * pUserData,
+                                                uint32_t workerIndex,
+                                                const SignalingMessage_t * pSignalingMessage,
+                                                uint64_t receivedTimeUs );
+
+typedef struct AppSignalingJob
+{
+    struct AppSignalingJob * pNext;
+    SignalingMessage_t signalingMessage;
+    uint64_t receivedTimeUs;
+    /* Remote client ID, correlation ID and message. */
+    char data[];
+} AppSignalingJob_t;
+
+typedef struct AppSignalingWorker
+{
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    AppSignalingJob_t * pHead;
+    AppSignalingJob_t * pTail;
+    uint32_t queueLength;
+    uint32_t droppedMessages;
+    uint32_t index;
+    struct AppSignalingWorkerPool * pPool;
+} AppSignalingWorker_t;
+
+typedef struct AppSignalingWorkerPool
+{
+    AppSignalingWorker_t workers[ APP_SIGNALING_WORKER_NUM ];
+    AppSignalingWorkerHandler_t handler;
+    void * pUserData;
+} AppSignalingWorkerPool_t;
+
+int32_t AppSignalingWorker_Init( AppSignalingWorkerPool_t * pPool,
+                                 AppSignalingWorkerHandler_t handler,
+                                 void * pUserData );
+
+/* Copy the message and queue it to a worker. All messages from the same remote
+ * client go to the same worker, so they're handled in the order received. */
+int32_t AppSignalingWorker_Dispatch( AppSignalingWorkerPool_t * pPool,
+                                     const SignalingMessage_t * pSignalingMessage );
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+}
+#endif
+/* *INDENT-ON* */
+
+#endif /* APP_SIGNALING_WORKER_H */
@@ -20,6 +20,8 @@ typedef enum Base64Result
     BASE64_RESULT_BUFFER_TOO_SMALL,
 } Base64Result_t;
 
+/* pOutputData may be pInputData to decode in place, the output is written
+ * behind the input still to be read. */
 Base64Result_t Base64_Decode( const char * pInputData,
                               size_t inputDataLength,
                               char * pOutputData,
@@ -0,0 +1,844 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Standard includes. */
+#include <string.h>
+#include <pthread.h>
+
+#include "logging.h"
+#include "base64.h"
+#include "base64_simd.h"
+
+#if defined( __GNUC__ ) && ( defined( __x86_64__ ) || defined( __i386__ ) )
+    #define BASE64_SIMD_X86 1
+    #include <immintrin.h>
+#elif defined( __aarch64__ )
+    #define BASE64_SIMD_NEON 1
+    #include <arm_neon.h>
+#endif
+
+/* Marks the characters outside the alphabet in decodeTable, valid values stay
+ * below 64 so a set top bit flags an invalid character. */
+#define BASE64_SIMD_INVALID_CHARACTER   ( 0xFFU )
+
+/* Encode whole groups of 3 bytes, returns the bytes consumed. */
+typedef size_t ( * Base64SimdEncodeBlocks_t )( const uint8_t * pInput,
+                                               size_t inputLength,
+                                               uint8_t * pOutput );
+
+/* Decode whole groups of 4 characters, returns the characters consumed. Stops
+ * before the first block holding anything outside the alphabet, padding and
+ * line breaks included. The output may overlap the input from the start. */
+typedef size_t ( * Base64SimdDecodeBlocks_t )( const uint8_t * pInput,
+                                               size_t inputLength,
+                                               uint8_t * pOutput );
+
+typedef struct Base64SimdCodec
+{
+    const char * pName;
+    Base64SimdEncodeBlocks_t encodeBlocks;
+    Base64SimdDecodeBlocks_t decodeBlocks;
+} Base64SimdCodec_t;
+
+static const char encodeAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static uint8_t decodeTable[ 256 ];
+
+static pthread_once_t initOnce = PTHREAD_ONCE_INIT;
+static Base64SimdImplementation_t currentImplementation = BASE64_SIMD_IMPLEMENTATION_SCALAR;
+
+static size_t EncodeBlocksScalar( const uint8_t * pInput,
+                                  size_t inputLength,
+                                  uint8_t * pOutput );
+
+static size_t DecodeBlocksScalar( const uint8_t * pInput,
+                                  size_t inputLength,
+                                  uint8_t * pOutput );
+
+#if BASE64_SIMD_X86
+static size_t EncodeBlocksSse41( const uint8_t * pInput,
+                                 size_t inputLength,
+                                 uint8_t * pOutput );
+
+static size_t DecodeBlocksSse41( const uint8_t * pInput,
+                                 size_t inputLength,
+                                 uint8_t * pOutput );
+
+static size_t EncodeBlocksAvx2( const uint8_t * pInput,
+                                size_t inputLength,
+                                uint8_t * pOutput );
+
+static size_t DecodeBlocksAvx2( const uint8_t * pInput,
+                                size_t inputLength,
+                                uint8_t * pOutput );
+#endif /* BASE64_SIMD_X86 */
+
+#if BASE64_SIMD_NEON
+static size_t EncodeBlocksNeon( const uint8_t * pInput,
+                                size_t inputLength,
+                                uint8_t * pOutput );
+
+static size_t DecodeBlocksNeon( const uint8_t * pInput,
+                                size_t inputLength,
+                                uint8_t * pOutput );
+#endif /* BASE64_SIMD_NEON */
+
+static const Base64SimdCodec_t codecs[ BASE64_SIMD_IMPLEMENTATION_MAX ] = {
+    [ BASE64_SIMD_IMPLEMENTATION_SCALAR ] = { "scalar", EncodeBlocksScalar, DecodeBlocksScalar },
+#if BASE64_SIMD_X86
+    [ BASE64_SIMD_IMPLEMENTATION_SSE41 ] = { "sse4.1", EncodeBlocksSse41, DecodeBlocksSse41 },
+    [ BASE64_SIMD_IMPLEMENTATION_AVX2 ] = { "avx2", EncodeBlocksAvx2, DecodeBlocksAvx2 },
+#else
+    [ BASE64_SIMD_IMPLEMENTATION_SSE41 ] = { "sse4.1", NULL, NULL },
+    [ BASE64_SIMD_IMPLEMENTATION_AVX2 ] = { "avx2", NULL, NULL },
+#endif /* BASE64_SIMD_X86 */
+#if BASE64_SIMD_NEON
+    [ BASE64_SIMD_IMPLEMENTATION_NEON ] = { "neon", EncodeBlocksNeon, DecodeBlocksNeon },
+#else
+    [ BASE64_SIMD_IMPLEMENTATION_NEON ] = { "neon", NULL, NULL },
+#endif /* BASE64_SIMD_NEON */
+};
+
+/*----------------------------------------------------------------------------*/
+
+static void Initialize( void )
+{
+    int i;
+
+    memset( decodeTable, BASE64_SIMD_INVALID_CHARACTER, sizeof( decodeTable ) );
+    for( i = 0; i < 64; i++ )
+    {
+        decodeTable[ ( uint8_t ) encodeAlphabet[ i ] ] = ( uint8_t ) i;
+    }
+
+    #if BASE64_SIMD_X86
+        __builtin_cpu_init();
+    #endif
+
+    for( i = BASE64_SIMD_IMPLEMENTATION_MAX - 1; i > BASE64_SIMD_IMPLEMENTATION_SCALAR; i-- )
+    {
+        if( Base64Simd_IsSupported( ( Base64SimdImplementation_t ) i ) != 0U )
+        {
+            break;
+        }
+    }
+
+    currentImplementation = ( Base64SimdImplementation_t ) i;
+    LogDebug( ( "Base64 codec: %s", codecs[ currentImplementation ].pName ) );
+}
+
+/*----------------------------------------------------------------------------*/
+
+static size_t EncodeBlocksScalar( const uint8_t * pInput,
+                                  size_t inputLength,
+                                  uint8_t * pOutput )
+{
+    size_t consumed;
+
+    for( consumed = 0; inputLength - consumed >= 3U; consumed += 3U )
+    {
+        *pOutput++ = encodeAlphabet[ pInput[ consumed ] >> 2 ];
+        *pOutput++ = encodeAlphabet[ ( ( pInput[ consumed ] & 0x03U ) << 4 ) | ( pInput[ consumed + 1U ] >> 4 ) ];
+        *pOutput++ = encodeAlphabet[ ( ( pInput[ consumed + 1U ] & 0x0FU ) << 2 ) | ( pInput[ consumed + 2U ] >> 6 ) ];
+        *pOutput++ = encodeAlphabet[ pInput[ consumed + 2U ] & 0x3FU ];
+    }
+
+    return consumed;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static size_t DecodeBlocksScalar( const uint8_t * pInput,
+                                  size_t inputLength,
+                                  uint8_t * pOutput )
+{
+    size_t consumed;
+    uint8_t b0, b1, b2, b3;
+
+    for( consumed = 0; inputLength - consumed >= 4U; consumed += 4U )
+    {
+        b0 = decodeTable[ pInput[ consumed ] ];
+        b1 = decodeTable[ pInput[ consumed + 1U ] ];
+        b2 = decodeTable[ pInput[ consumed + 2U ] ];
+        b3 = decodeTable[ pInput[ consumed + 3U ] ];
+
+        if( ( ( b0 | b1 | b2 | b3 ) & 0x80U ) != 0U )
+        {
+            break;
+        }
+
+        *pOutput++ = ( uint8_t ) ( ( b0 << 2 ) | ( b1 >> 4 ) );
+        *pOutput++ = ( uint8_t ) ( ( b1 << 4 ) | ( b2 >> 2 ) );
+        *pOutput++ = ( uint8_t ) ( ( b2 << 6 ) | b3 );
+    }
+
+    return consumed;
+}
+
+/*----------------------------------------------------------------------------*/
+
+#if BASE64_SIMD_X86
+
+/* Alphabet lookup of 16 6-bit indices, from "Base64 encoding with SIMD
+ * instructions" by Wojciech Mula. */
+__attribute__( ( target( "sse4.1" ) ) )
+static inline __m128i TranslateSse41( __m128i indices )
+{
+    const __m128i shiftLut = _mm_setr_epi8( 'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                            '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                            '/' - 63, 'A', 0, 0 );
+    __m128i reduced, less;
+
+    reduced = _mm_subs_epu8( indices, _mm_set1_epi8( 51 ) );
+    less = _mm_cmpgt_epi8( _mm_set1_epi8( 26 ), indices );
+    reduced = _mm_or_si128( reduced, _mm_and_si128( less, _mm_set1_epi8( 13 ) ) );
+
+    return _mm_add_epi8( _mm_shuffle_epi8( shiftLut, reduced ), indices );
+}
+
+/*----------------------------------------------------------------------------*/
+
+/* Spread 12 bytes into 16 6-bit indices. */
+__attribute__( ( target( "sse4.1" ) ) )
+static inline __m128i UnpackSse41( __m128i input )
+{
+    const __m128i shuffle = _mm_setr_epi8( 1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10 );
+    __m128i t0, t1, t2, t3;
+
+    input = _mm_shuffle_epi8( input, shuffle );
+    t0 = _mm_and_si128( input, _mm_set1_epi32( 0x0FC0FC00 ) );
+    t1 = _mm_mulhi_epu16( t0, _mm_set1_epi32( 0x04000040 ) );
+    t2 = _mm_and_si128( input, _mm_set1_epi32( 0x003F03F0 ) );
+    t3 = _mm_mullo_epi16( t2, _mm_set1_epi32( 0x01000010 ) );
+
+    return _mm_or_si128( t1, t3 );
+}
+
+/*----------------------------------------------------------------------------*/
+
+__attribute__( ( target( "sse4.1" ) ) )
+static size_t EncodeBlocksSse41( const uint8_t * pInput,
+                                 size_t inputLength,
+                                 uint8_t * pOutput )
+{
+    size_t consumed = 0;
+    __m128i input;
+
+    /* 12 bytes are used of the 16 loaded. */
+    while( inputLength - consumed >= 16U )
+    {
+        input = _mm_loadu_si128( ( const __m128i * ) &( pInput[ consumed ] ) );
+        _mm_storeu_si128( ( __m128i * ) pOutput, TranslateSse41( UnpackSse41( input ) ) );
+
+        consumed += 12U;
+        pOutput += 16;
+    }
+
+    return consumed;
+}
+
+/*----------------------------------------------------------------------------*/
+
+/* Character validation and lookup by nibble, from "Faster Base64 Encoding and
+ * Decoding using AVX2 Instructions" by Wojciech Mula and Daniel Lemire. */
+__attribute__( ( target( "sse4.1" ) ) )
+static size_t DecodeBlocksSse41( const uint8_t * pInput,
+                                 size_t inputLength,
+                                 uint8_t * pOutput )
+{
+    size_t consumed = 0;
+    const __m128i lutLo = _mm_setr_epi8( 0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                         0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A );
+    const __m128i lutHi = _mm_setr_epi8( 0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                         0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10 );
+    const __m128i lutRoll = _mm_setr_epi8( 0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0 );
+    const __m128i pack = _mm_setr_epi8( 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1 );
+    const __m128i nibbleMask = _mm_set1_epi8( 0x0F );
+    __m128i input, hiNibbles, lo, hi, roll, output;
+    uint32_t tail;
+
+    while( inputLength - consumed >= 16U )
+    {
+        input = _mm_loadu_si128( ( const __m128i * ) &( pInput[ consumed ] ) );
+        hiNibbles = _mm_and_si128( _mm_srli_epi32( input, 4 ), nibbleMask );
+        lo = _mm_shuffle_epi8( lutLo, _mm_and_si128( input, nibbleMask ) );
+        hi = _mm_shuffle_epi8( lutHi, hiNibbles );
+
+        if( _mm_testz_si128( lo, hi ) == 0 )
+        {
+            break;
+        }
+
+        roll = _mm_shuffle_epi8( lutRoll,
+                                 _mm_add_epi8( _mm_cmpeq_epi8( input, _mm_set1_epi8( '/' ) ), hiNibbles ) );
+        output = _mm_add_epi8( input, roll );
+        output = _mm_maddubs_epi16( output, _mm_set1_epi32( 0x01400140 ) );
+        output = _mm_madd_epi16( output, _mm_set1_epi32( 0x00011000 ) );
+        output = _mm_shuffle_epi8( output, pack );
+
+        /* Store the 12 decoded bytes only, the output may end right here. */
+        _mm_storel_epi64( ( __m128i * ) pOutput, output );
+        tail = ( uint32_t ) _mm_extract_epi32( output, 2 );
+        memcpy( &( pOutput[ 8 ] ), &( tail ), sizeof( tail ) );
+
+        consumed += 16U;
+        pOutput += 12;
+    }
+
+    return consumed;
+}
+
+/*----------------------------------------------------------------------------*/
+
+__attribute__( ( target( "avx2" ) ) )
+static size_t EncodeBlocksAvx2( const uint8_t * pInput,
+                                size_t inputLength,
+                                uint8_t * pOutput )
+{
+    size_t consumed = 0;
+    const __m256i shuffle = _mm256_setr_epi8( 1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+                                              1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10 );
+    const __m256i shiftLut = _mm256_setr_epi8( 'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                               '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                               '/' - 63, 'A', 0, 0,
+                                               'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                               '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                               '/' - 63, 'A', 0, 0 );
+    __m256i input, t0, t1, t2, t3, indices, reduced, less;
+
+    /* Each lane takes 12 bytes, the second load ends 28 bytes in. */
+    while( inputLength - consumed >= 28U )
+    {
+        input = _mm256_inserti128_si256( _mm256_castsi128_si256( _mm_loadu_si128( ( const __m128i * ) &( pInput[ consumed ] ) ) ),
+                                         _mm_loadu_si128( ( const __m128i * ) &( pInput[ consumed + 12U ] ) ),
+                                         1 );
+
+        input = _mm256_shuffle_epi8( input, shuffle );
+        t0 = _mm256_and_si256( input, _mm256_set1_epi32( 0x0FC0FC00 ) );
+        t1 = _mm256_mulhi_epu16( t0, _mm256_set1_epi32( 0x04000040 ) );
+        t2 = _mm256_and_si256( input, _mm256_set1_epi32( 0x003F03F0 ) );
+        t3 = _mm256_mullo_epi16( t2, _mm256_set1_epi32( 0x01000010 ) );
+        indices = _mm256_or_si256( t1, t3 );
+
+        reduced = _mm256_subs_epu8( indices, _mm256_set1_epi8( 51 ) );
+        less = _mm256_cmpgt_epi8( _mm256_set1_epi8( 26 ), indices );
+        reduced = _mm256_or_si256( reduced, _mm256_and_si256( less, _mm256_set1_epi8( 13 ) ) );
+
+        _mm256_storeu_si256( ( __m256i * ) pOutput,
+                             _mm256_add_epi8( _mm256_shuffle_epi8( shiftLut, reduced ), indices ) );
+
+        consumed += 24U;
+        pOutput += 32;
+    }
+
+    return consumed;
+}
+
+/*----------------------------------------------------------------------------*/
+
+__attribute__( ( target( "avx2" ) ) )
+static size_t DecodeBlocksAvx2( const uint8_t * pInput,
+                                size_t inputLength,
+                                uint8_t * pOutput )
+{
+    size_t consumed = 0;
+    const __m256i lutLo = _mm256_setr_epi8( 0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                            0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+                                            0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                            0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A );
+    const __m256i lutHi = _mm256_setr_epi8( 0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                            0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+                                            0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                            0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10 );
+    const __m256i lutRoll = _mm256_setr_epi8( 0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+                                              0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0 );
+    const __m256i pack = _mm256_setr_epi8( 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                                           2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1 );
+    const __m256i nibbleMask = _mm256_set1_epi8( 0x0F );
+    __m256i input, hiNibbles, lo, hi, roll, output;
+
+    while( inputLength - consumed >= 32U )
+    {
+        input = _mm256_loadu_si256( ( const __m256i * ) &( pInput[ consumed ] ) );
+        hiNibbles = _mm256_and_si256( _mm256_srli_epi32( input, 4 ), nibbleMask );
+        lo = _mm256_shuffle_epi8( lutLo, _mm256_and_si256( input, nibbleMask ) );
+        hi = _mm256_shuffle_epi8( lutHi, hiNibbles );
+
+        if( _mm256_testz_si256( lo, hi ) == 0 )
+        {
+            break;
+        }
+
+        roll = _mm256_shuffle_epi8( lutRoll,
+                                    _mm256_add_epi8( _mm256_cmpeq_epi8( input, _mm256_set1_epi8( '/' ) ), hiNibbles ) );
+        output = _mm256_add_epi8( input, roll );
+        output = _mm256_maddubs_epi16( output, _mm256_set1_epi32( 0x01400140 ) );
+        output = _mm256_madd_epi16( output, _mm256_set1_epi32( 0x00011000 ) );
+        output = _mm256_shuffle_epi8( output, pack );
+        output = _mm256_permutevar8x32_epi32( output, _mm256_setr_epi32( 0, 1, 2, 4, 5, 6, 3, 7 ) );
+
+        /* Store the 24 decoded bytes only. */
+        _mm_storeu_si128( ( __m128i * ) pOutput, _mm256_castsi256_si128( output ) );
+        _mm_storel_epi64( ( __m128i * ) &( pOutput[ 16 ] ), _mm256_extracti128_si256( output, 1 ) );
+
+        consumed += 32U;
+        pOutput += 24;
+    }
+
+    return consumed;
+}
+
+#endif /* BASE64_SIMD_X86 */
+
+/*----------------------------------------------------------------------------*/
+
+#if BASE64_SIMD_NEON
+
+static size_t EncodeBlocksNeon( const uint8_t * pInput,
+                                size_t inputLength,
+                                uint8_t * pOutput )
+{
+    size_t consumed = 0;
+    const uint8x16_t mask = vdupq_n_u8( 0x3F );
+    uint8x16x4_t alphabet, output;
+    uint8x16x3_t input;
+
+    alphabet.val[ 0 ] = vld1q_u8( ( const uint8_t * ) &( encodeAlphabet[ 0 ] ) );
+    alphabet.val[ 1 ] = vld1q_u8( ( const uint8_t * ) &( encodeAlphabet[ 16 ] ) );
+    alphabet.val[ 2 ] = vld1q_u8( ( const uint8_t * ) &( encodeAlphabet[ 32 ] ) );
+    alphabet.val[ 3 ] = vld1q_u8( ( const uint8_t * ) &( encodeAlphabet[ 48 ] ) );
+
+    while( inputLength - consumed >= 48U )
+    {
+        /* Deinterleaves the first, second and third byte of 16 groups. */
+        input = vld3q_u8( &( pInput[ consumed ] ) );
+
+        output.val[ 0 ] = vshrq_n_u8( input.val[ 0 ], 2 );
+        output.val[ 1 ] = vandq_u8( vorrq_u8( vshlq_n_u8( input.val[ 0 ], 4 ), vshrq_n_u8( input.val[ 1 ], 4 ) ), mask );
+        output.val[ 2 ] = vandq_u8( vorrq_u8( vshlq_n_u8( input.val[ 1 ], 2 ), vshrq_n_u8( input.val[ 2 ], 6 ) ), mask );
+        output.val[ 3 ] = vandq_u8( input.val[ 2 ], mask );
+
+        output.val[ 0 ] = vqtbl4q_u8( alphabet, output.val[ 0 ] );
+        output.val[ 1 ] = vqtbl4q_u8( alphabet, output.val[ 1 ] );
+        output.val[ 2 ] = vqtbl4q_u8( alphabet, output.val[ 2 ] );
+        output.val[ 3 ] = vqtbl4q_u8( alphabet, output.val[ 3 ] );
+
+        vst4q_u8( pOutput, output );
+
+        consumed += 48U;
+        pOutput += 64;
+    }
+
+    return consumed;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static size_t DecodeBlocksNeon( const uint8_t * pInput,
+                                size_t inputLength,
+                                uint8_t * pOutput )
+{
+    size_t consumed = 0;
+    const uint8x16_t offset = vdupq_n_u8( 64 );
+    uint8x16x4_t lutLow, lutHigh, input;
+    uint8x16x3_t output;
+    uint8x16_t values[ 4 ], error;
+    int i;
+
+    /* Out of range table lookups give 0, so characters from 128 up decode to 0
+     * and are caught by their own top bit instead. */
+    for( i = 0; i < 4; i++ )
+    {
+        lutLow.val[ i ] = vld1q_u8( &( decodeTable[ 16 * i ] ) );
+        lutHigh.val[ i ] = vld1q_u8( &( decodeTable[ 64 + 16 * i ] ) );
+    }
+
+    while( inputLength - consumed >= 64U )
+    {
+        input = vld4q_u8( &( pInput[ consumed ] ) );
+        error = vdupq_n_u8( 0 );
+
+        for( i = 0; i < 4; i++ )
+        {
+            values[ i ] = vorrq_u8( vqtbl4q_u8( lutLow, input.val[ i ] ),
+                                    vqtbl4q_u8( lutHigh, vsubq_u8( input.val[ i ], offset ) ) );
+            error = vorrq_u8( error, vorrq_u8( values[ i ], input.val[ i ] ) );
+        }
+
+        if( vmaxvq_u8( error ) >= 0x80U )
+        {
+            break;
+        }
+
+        output.val[ 0 ] = vorrq_u8( vshlq_n_u8( values[ 0 ], 2 ), vshrq_n_u8( values[ 1 ], 4 ) );
+        output.val[ 1 ] = vorrq_u8( vshlq_n_u8( values[ 1 ], 4 ), vshrq_n_u8( values[ 2 ], 2 ) );
+        output.val[ 2 ] = vorrq_u8( vshlq_n_u8( values[ 2 ], 6 ), values[ 3 ] );
+
+        vst3q_u8( pOutput, output );
+
+        consumed += 64U;
+        pOutput += 48;
+    }
+
+    return consumed;
+}
+
+#endif /* BASE64_SIMD_NEON */
+
+/*----------------------------------------------------------------------------*/
+
+/* Decode the rest of the input from a group boundary the way mbedTLS does:
+ * line breaks and spaces around them are skipped, up to 2 '=' may end the
+ * data and a trailing partial group is dropped. inputIndex characters were
+ * already decoded into outputIndex bytes without any of those. */
+static Base64Result_t DecodeGeneric( const uint8_t * pInput,
+                                     size_t inputLength,
+                                     size_t inputIndex,
+                                     uint8_t * pOutput,
+                                     size_t outputIndex,
+                                     size_t * pOutputDataLength )
+{
+    Base64Result_t ret = BASE64_RESULT_OK;
+    size_t i, digits = 0, outputLength;
+    uint32_t equals = 0, accumulatedDigits = 0, value = 0;
+    uint8_t hasSpaces;
+    uint8_t * pCurOutput = &( pOutput[ outputIndex ] );
+
+    /* First pass validates and sizes the output, nothing is written. */
+    for( i = inputIndex; i < inputLength; i++ )
+    {
+        hasSpaces = 0U;
+        while( ( i < inputLength ) && ( pInput[ i ] == ' ' ) )
+        {
+            i++;
+            hasSpaces = 1U;
+        }
+
+        if( i == inputLength )
+        {
+            break;
+        }
+
+        if( ( ( inputLength - i ) >= 2U ) && ( pInput[ i ] == '\r' ) && ( pInput[ i + 1U ] == '\n' ) )
+        {
+            continue;
+        }
+
+        if( pInput[ i ] == '\n' )
+        {
+            continue;
+        }
+
+        if( ( hasSpaces != 0U ) ||
+            ( ( pInput[ i ] == '=' ) && ( ++equals > 2U ) ) ||
+            ( ( pInput[ i ] != '=' ) && ( ( equals != 0U ) || ( decodeTable[ pInput[ i ] ] == BASE64_SIMD_INVALID_CHARACTER ) ) ) )
+        {
+            ret = BASE64_RESULT_INVALID_INPUT;
+            break;
+        }
+
+        digits++;
+    }
+
+    if( ret == BASE64_RESULT_OK )
+    {
+        /* ( digits * 6 + 7 ) / 8 without overflow, the decoded prefix is a
+         * whole number of groups. */
+        outputLength = outputIndex + ( 6U * ( digits >> 3 ) ) + ( ( 6U * ( digits & 0x7U ) + 7U ) >> 3 );
+        outputLength = ( digits == 0U ) ? outputIndex : outputLength - equals;
+
+        if( *pOutputDataLength < outputLength )
+        {
+            ret = BASE64_RESULT_BUFFER_TOO_SMALL;
+        }
+    }
+
+    if( ret == BASE64_RESULT_OK )
+    {
+        equals = 0;
+        for( i = inputIndex; i < inputLength; i++ )
+        {
+            if( ( pInput[ i ] == '\r' ) || ( pInput[ i ] == '\n' ) || ( pInput[ i ] == ' ' ) )
+            {
+                continue;
+            }
+
+            value <<= 6;
+            if( pInput[ i ] == '=' )
+            {
+                equals++;
+            }
+            else
+            {
+                value |= decodeTable[ pInput[ i ] ] & 0x3FU;
+            }
+
+            if( ++accumulatedDigits == 4U )
+            {
+                accumulatedDigits = 0;
+                *pCurOutput++ = ( uint8_t ) ( value >> 16 );
+                if( equals <= 1U )
+                {
+                    *pCurOutput++ = ( uint8_t ) ( value >> 8 );
+                }
+                if( equals == 0U )
+                {
+                    *pCurOutput++ = ( uint8_t ) value;
+                }
+            }
+        }
+
+        *pOutputDataLength = ( size_t ) ( pCurOutput - pOutput );
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+Base64SimdImplementation_t Base64Simd_GetImplementation( void )
+{
+    pthread_once( &( initOnce ), Initialize );
+
+    return currentImplementation;
+}
+
+/*----------------------------------------------------------------------------*/
+
+uint8_t Base64Simd_IsSupported( Base64SimdImplementation_t implementation )
+{
+    uint8_t ret = 0U;
+
+    switch( implementation )
+    {
+        case BASE64_SIMD_IMPLEMENTATION_SCALAR:
+            ret = 1U;
+            break;
+        #if BASE64_SIMD_X86
+            case BASE64_SIMD_IMPLEMENTATION_SSE41:
+                ret = ( __builtin_cpu_supports( "sse4.1" ) != 0 ) ? 1U : 0U;
+                break;
+            case BASE64_SIMD_IMPLEMENTATION_AVX2:
+                ret = ( __builtin_cpu_supports( "avx2" ) != 0 ) ? 1U : 0U;
+                break;
+        #endif /* BASE64_SIMD_X86 */
+        #if BASE64_SIMD_NEON
+            case BASE64_SIMD_IMPLEMENTATION_NEON:
+                /* Part of every AArch64 CPU. */
+                ret = 1U;
+                break;
+        #endif /* BASE64_SIMD_NEON */
+        default:
+            break;
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+Base64Result_t Base64Simd_ForceImplementation( Base64SimdImplementation_t implementation )
+{
+    Base64Result_t ret = BASE64_RESULT_OK;
+
+    pthread_once( &( initOnce ), Initialize );
+
+    if( ( implementation >= BASE64_SIMD_IMPLEMENTATION_MAX ) ||
+        ( Base64Simd_IsSupported( implementation ) == 0U ) )
+    {
+        ret = BASE64_RESULT_BAD_PARAMETER;
+    }
+    else
+    {
+        currentImplementation = implementation;
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+const char * Base64Simd_GetImplementationName( Base64SimdImplementation_t implementation )
+{
+    return ( implementation < BASE64_SIMD_IMPLEMENTATION_MAX ) ? codecs[ implementation ].pName : "unknown";
+}
+
+/*----------------------------------------------------------------------------*/
+
+Base64Result_t Base64_Encode( const char * pInputData,
+                              size_t inputDataLength,
+                              char * pOutputData,
+                              size_t * pOutputDataLength )
+{
+    Base64Result_t ret = BASE64_RESULT_OK;
+    const uint8_t * pInput = ( const uint8_t * ) pInputData;
+    uint8_t * pOutput = ( uint8_t * ) pOutputData;
+    size_t consumed = 0, outputLength = 0, remaining;
+
+    if( ( ( pInputData == NULL ) && ( inputDataLength > 0U ) ) ||
+        ( pOutputData == NULL ) ||
+        ( pOutputDataLength == NULL ) )
+    {
+        ret = BASE64_RESULT_BAD_PARAMETER;
+    }
+    else if( inputDataLength == 0U )
+    {
+        *pOutputDataLength = 0;
+    }
+    else if( inputDataLength > ( ( ( size_t ) -1 ) / 4U - 1U ) * 3U )
+    {
+        ret = BASE64_RESULT_BUFFER_TOO_SMALL;
+    }
+    else
+    {
+        /* Room for the terminator as mbedTLS wants it. */
+        outputLength = 4U * ( ( inputDataLength + 2U ) / 3U );
+
+        if( *pOutputDataLength < outputLength + 1U )
+        {
+            ret = BASE64_RESULT_BUFFER_TOO_SMALL;
+        }
+        else
+        {
+            pthread_once( &( initOnce ), Initialize );
+
+            consumed = codecs[ currentImplementation ].encodeBlocks( pInput, inputDataLength, pOutput );
+            pOutput += consumed / 3U * 4U;
+            consumed += EncodeBlocksScalar( &( pInput[ consumed ] ), inputDataLength - consumed, pOutput );
+            pOutput = ( uint8_t * ) &( pOutputData[ consumed / 3U * 4U ] );
+            remaining = inputDataLength - consumed;
+
+            if( remaining == 1U )
+            {
+                *pOutput++ = encodeAlphabet[ pInput[ consumed ] >> 2 ];
+                *pOutput++ = encodeAlphabet[ ( pInput[ consumed ] & 0x03U ) << 4 ];
+                *pOutput++ = '=';
+                *pOutput++ = '=';
+            }
+            else if( remaining == 2U )
+            {
+                *pOutput++ = encodeAlphabet[ pInput[ consumed ] >> 2 ];
+                *pOutput++ = encodeAlphabet[ ( ( pInput[ consumed ] & 0x03U ) << 4 ) | ( pInput[ consumed + 1U ] >> 4 ) ];
+                *pOutput++ = encodeAlphabet[ ( pInput[ consumed + 1U ] & 0x0FU ) << 2 ];
+                *pOutput++ = '=';
+            }
+            else
+            {
+                /* Empty else marker. */
+            }
+
+            *pOutput = '\0';
+            *pOutputDataLength = outputLength;
+        }
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+Base64Result_t Base64_Decode( const char * pInputData,
+                              size_t inputDataLength,
+                              char * pOutputData,
+                              size_t * pOutputDataLength )
+{
+    Base64Result_t ret = BASE64_RESULT_OK;
+    const uint8_t * pInput = ( const uint8_t * ) pInputData;
+    uint8_t * pOutput = ( uint8_t * ) pOutputData;
+    size_t consumed = 0, outputLength = 0, padding = 0, lastGroup;
+    uint8_t b0, b1, b2, b3, isDone = 0U;
+
+    if( ( ( pInputData == NULL ) && ( inputDataLength > 0U ) ) ||
+        ( pOutputData == NULL ) ||
+        ( pOutputDataLength == NULL ) )
+    {
+        ret = BASE64_RESULT_BAD_PARAMETER;
+    }
+    else if( inputDataLength == 0U )
+    {
+        *pOutputDataLength = 0;
+        isDone = 1U;
+    }
+    else
+    {
+        pthread_once( &( initOnce ), Initialize );
+    }
+
+    /* Fast path for what signaling sends, whole padded groups without line
+     * breaks. Anything else continues in DecodeGeneric from the first group
+     * the fast path can't take. */
+    if( ( ret == BASE64_RESULT_OK ) &&
+        ( isDone == 0U ) &&
+        ( ( inputDataLength % 4U ) == 0U ) )
+    {
+        if( pInput[ inputDataLength - 1U ] == '=' )
+        {
+            padding = ( pInput[ inputDataLength - 2U ] == '=' ) ? 2U : 1U;
+        }
+
+        outputLength = inputDataLength / 4U * 3U - padding;
+
+        if( *pOutputDataLength >= outputLength )
+        {
+            lastGroup = inputDataLength - 4U;
+
+            consumed = codecs[ currentImplementation ].decodeBlocks( pInput, lastGroup, pOutput );
+            consumed += DecodeBlocksScalar( &( pInput[ consumed ] ), lastGroup - consumed, &( pOutput[ consumed / 4U * 3U ] ) );
+
+            if( consumed == lastGroup )
+            {
+                b0 = decodeTable[ pInput[ lastGroup ] ];
+                b1 = decodeTable[ pInput[ lastGroup + 1U ] ];
+                b2 = ( padding < 2U ) ? decodeTable[ pInput[ lastGroup + 2U ] ] : 0U;
+                b3 = ( padding < 1U ) ? decodeTable[ pInput[ lastGroup + 3U ] ] : 0U;
+
+                if( ( ( b0 | b1 | b2 | b3 ) & 0x80U ) == 0U )
+                {
+                    pOutput = &( pOutput[ lastGroup / 4U * 3U ] );
+                    *pOutput++ = ( uint8_t ) ( ( b0 << 2 ) | ( b1 >> 4 ) );
+                    if( padding < 2U )
+                    {
+                        *pOutput++ = ( uint8_t ) ( ( b1 << 4 ) | ( b2 >> 2 ) );
+                    }
+                    if( padding < 1U )
+                    {
+                        *pOutput++ = ( uint8_t ) ( ( b2 << 6 ) | b3 );
+                    }
+
+                    *pOutputDataLength = outputLength;
+                    isDone = 1U;
+                }
+            }
+        }
+        else
+        {
+            /* Line breaks may make it fit, the generic path sizes exactly. */
+            consumed = 0;
+        }
+    }
+
+    if( ( ret == BASE64_RESULT_OK ) && ( isDone == 0U ) )
+    {
+        ret = DecodeGeneric( pInput,
+                             inputDataLength,
+                             consumed,
+                             ( uint8_t * ) pOutputData,
+                             consumed / 4U * 3U,
+                             pOutputDataLength );
+    }
+
+    return ret;
+}
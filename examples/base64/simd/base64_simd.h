@@ -0,0 +1,58 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef BASE64_SIMD_H
+#define BASE64_SIMD_H
+
+#pragma once
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+extern "C" {
+#endif
+/* *INDENT-ON* */
+
+#include "base64.h"
+
+typedef enum Base64SimdImplementation
+{
+    BASE64_SIMD_IMPLEMENTATION_SCALAR = 0,
+    BASE64_SIMD_IMPLEMENTATION_SSE41,
+    BASE64_SIMD_IMPLEMENTATION_AVX2,
+    BASE64_SIMD_IMPLEMENTATION_NEON,
+    BASE64_SIMD_IMPLEMENTATION_MAX,
+} Base64SimdImplementation_t;
+
+/* The implementation Base64_Encode and Base64_Decode use, the best one the CPU
+ * supports unless another was forced. */
+Base64SimdImplementation_t Base64Simd_GetImplementation( void );
+
+/* Returns 1 if the CPU supports the implementation. */
+uint8_t Base64Simd_IsSupported( Base64SimdImplementation_t implementation );
+
+/* Switch to another supported implementation, for benchmarks and for
+ * comparing the implementations. Not thread safe against running calls. */
+Base64Result_t Base64Simd_ForceImplementation( Base64SimdImplementation_t implementation );
+
+const char * Base64Simd_GetImplementationName( Base64SimdImplementation_t implementation );
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+}
+#endif
+/* *INDENT-ON* */
+
+#endif /* BASE64_SIMD_H */
@@ -0,0 +1,361 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Base64 codec benchmark.
+ *
+ * First checks every implementation of the SIMD codec the CPU supports against
+ * mbedTLS on random inputs: encodings must match byte for byte, and decoding
+ * canonical, corrupted and line wrapped encodings must give the same result
+ * and output, in place too. Then reports encode and decode throughput of
+ * mbedTLS and each implementation for buffer sizes from an ICE candidate to a
+ * large SDP offer.
+ *
+ * Usage: WebRTCLinuxBase64Benchmark [-n check_iterations] [-m megabytes_per_case]
+ *
+ * Exits with 1 if any implementation disagrees with mbedTLS.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "mbedtls/base64.h"
+
+#include "logging.h"
+#include "base64.h"
+#include "base64_simd.h"
+
+/* Random inputs per implementation, unless overridden by -n. */
+#define BASE64_BENCHMARK_DEFAULT_CHECK_ITERATIONS   ( 100000 )
+
+/* Data encoded or decoded per case, unless overridden by -m. */
+#define BASE64_BENCHMARK_DEFAULT_MEGABYTES          ( 256 )
+
+#define BASE64_BENCHMARK_MAX_CHECK_LENGTH           ( 4096 )
+#define BASE64_BENCHMARK_MAX_LENGTH                 ( 65536 )
+#define BASE64_BENCHMARK_ENCODED_LENGTH( x )        ( ( ( x ) + 2 ) / 3 * 4 + 1 )
+
+/* Characters the corruptions insert, none of them in the alphabet. */
+static const char corruptions[] = "=\r\n -.*\x80\xff";
+
+static const size_t benchmarkLengths[] = { 64, 1024, 8192, 65536 };
+
+static uint8_t rawBuffer[ BASE64_BENCHMARK_MAX_LENGTH ];
+static uint8_t encodedBuffer[ BASE64_BENCHMARK_ENCODED_LENGTH( BASE64_BENCHMARK_MAX_LENGTH ) + 16 ];
+static uint8_t expectedBuffer[ BASE64_BENCHMARK_ENCODED_LENGTH( BASE64_BENCHMARK_MAX_LENGTH ) + 16 ];
+static uint8_t actualBuffer[ BASE64_BENCHMARK_ENCODED_LENGTH( BASE64_BENCHMARK_MAX_LENGTH ) + 16 ];
+
+/*----------------------------------------------------------------------------*/
+
+static uint64_t GetTimeNs( void )
+{
+    struct timespec now;
+
+    clock_gettime( CLOCK_MONOTONIC, &( now ) );
+
+    return ( uint64_t ) now.tv_sec * 1000000000ULL + ( uint64_t ) now.tv_nsec;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static Base64Result_t ToBase64Result( int mbedtlsResult )
+{
+    Base64Result_t ret = BASE64_RESULT_OK;
+
+    if( mbedtlsResult == MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL )
+    {
+        ret = BASE64_RESULT_BUFFER_TOO_SMALL;
+    }
+    else if( mbedtlsResult != 0 )
+    {
+        ret = BASE64_RESULT_INVALID_INPUT;
+    }
+    else
+    {
+        /* Empty else marker. */
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+/* Replace, insert or drop a few characters, or wrap the lines. */
+static size_t Corrupt( uint8_t * pData,
+                       size_t length )
+{
+    int i, count = rand() % 4;
+    size_t position;
+
+    for( i = 0; ( i < count ) && ( length > 0U ); i++ )
+    {
+        position = ( size_t ) rand() % length;
+
+        switch( rand() % 4 )
+        {
+            case 0:
+                pData[ position ] = ( uint8_t ) corruptions[ rand() % ( sizeof( corruptions ) - 1U ) ];
+                break;
+            case 1:
+                memmove( &( pData[ position + 1U ] ), &( pData[ position ] ), length - position );
+                pData[ position ] = ( uint8_t ) corruptions[ rand() % ( sizeof( corruptions ) - 1U ) ];
+                length++;
+                break;
+            case 2:
+                memmove( &( pData[ position ] ), &( pData[ position + 1U ] ), length - position - 1U );
+                length--;
+                break;
+            default:
+                memmove( &( pData[ position + 2U ] ), &( pData[ position ] ), length - position );
+                pData[ position ] = '\r';
+                pData[ position + 1U ] = '\n';
+                length += 2U;
+                break;
+        }
+    }
+
+    return length;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static int CheckDecode( const uint8_t * pEncoded,
+                        size_t encodedLength,
+                        size_t outputSize )
+{
+    int ret = 0;
+    Base64Result_t expectedResult, actualResult;
+    size_t expectedLength = 0, actualLength = outputSize;
+
+    expectedResult = ToBase64Result( mbedtls_base64_decode( expectedBuffer, outputSize, &( expectedLength ), pEncoded, encodedLength ) );
+    actualResult = Base64_Decode( ( const char * ) pEncoded, encodedLength, ( char * ) actualBuffer, &( actualLength ) );
+
+    if( ( expectedResult != actualResult ) ||
+        ( ( expectedResult == BASE64_RESULT_OK ) &&
+          ( ( expectedLength != actualLength ) || ( memcmp( expectedBuffer, actualBuffer, expectedLength ) != 0 ) ) ) )
+    {
+        printf( "decode mismatch, %lu characters into %lu bytes: mbedtls %d/%lu, %s %d/%lu\n",
+                encodedLength, outputSize, expectedResult, expectedLength,
+                Base64Simd_GetImplementationName( Base64Simd_GetImplementation() ), actualResult, actualLength );
+        ret = -1;
+    }
+
+    if( ( ret == 0 ) && ( expectedResult == BASE64_RESULT_OK ) )
+    {
+        memcpy( actualBuffer, pEncoded, encodedLength );
+        actualLength = encodedLength;
+
+        if( ( Base64_Decode( ( const char * ) actualBuffer, encodedLength, ( char * ) actualBuffer, &( actualLength ) ) != BASE64_RESULT_OK ) ||
+            ( expectedLength != actualLength ) ||
+            ( memcmp( expectedBuffer, actualBuffer, expectedLength ) != 0 ) )
+        {
+            printf( "in place decode mismatch, %lu characters\n", encodedLength );
+            ret = -1;
+        }
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static int RunCheck( uint32_t iterations )
+{
+    int ret = 0;
+    uint32_t i;
+    size_t j, length, expectedLength, actualLength, corruptedLength;
+    Base64Result_t expectedResult, actualResult;
+    static uint8_t corrupted[ BASE64_BENCHMARK_ENCODED_LENGTH( BASE64_BENCHMARK_MAX_CHECK_LENGTH ) * 4 ];
+
+    for( i = 0; ( ret == 0 ) && ( i < iterations ); i++ )
+    {
+        /* Mostly short lengths to hit every tail, sometimes long ones. */
+        length = ( size_t ) rand() % ( ( i % 16U == 0U ) ? BASE64_BENCHMARK_MAX_CHECK_LENGTH : 256U );
+        for( j = 0; j < length; j++ )
+        {
+            rawBuffer[ j ] = ( uint8_t ) rand();
+        }
+
+        expectedLength = 0;
+        actualLength = BASE64_BENCHMARK_ENCODED_LENGTH( length ) - ( ( i % 8U == 0U ) ? 1U : 0U );
+        expectedResult = ToBase64Result( mbedtls_base64_encode( expectedBuffer, actualLength, &( expectedLength ), rawBuffer, length ) );
+        actualResult = Base64_Encode( ( const char * ) rawBuffer, length, ( char * ) encodedBuffer, &( actualLength ) );
+
+        if( ( expectedResult != actualResult ) ||
+            ( ( expectedResult == BASE64_RESULT_OK ) &&
+              ( ( expectedLength != actualLength ) || ( memcmp( expectedBuffer, encodedBuffer, expectedLength ) != 0 ) ) ) )
+        {
+            printf( "encode mismatch, %lu bytes: mbedtls %d/%lu, %s %d/%lu\n",
+                    length, expectedResult, expectedLength,
+                    Base64Simd_GetImplementationName( Base64Simd_GetImplementation() ), actualResult, actualLength );
+            ret = -1;
+        }
+
+        if( ( ret == 0 ) && ( expectedResult == BASE64_RESULT_OK ) )
+        {
+            ret = CheckDecode( encodedBuffer, actualLength, length );
+        }
+
+        if( ( ret == 0 ) && ( expectedResult == BASE64_RESULT_OK ) && ( length > 0U ) )
+        {
+            ret = CheckDecode( encodedBuffer, actualLength, length - 1U );
+        }
+
+        if( ( ret == 0 ) && ( expectedResult == BASE64_RESULT_OK ) )
+        {
+            memcpy( corrupted, encodedBuffer, actualLength );
+            corruptedLength = Corrupt( corrupted, actualLength );
+            ret = CheckDecode( corrupted, corruptedLength, sizeof( actualBuffer ) );
+        }
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static void RunBenchmark( const char * pName,
+                          uint8_t useMbedtls,
+                          size_t length,
+                          uint32_t megabytes )
+{
+    uint64_t startTimeNs, encodeTimeNs, decodeTimeNs;
+    uint64_t i, rounds = ( ( uint64_t ) megabytes * 1024U * 1024U + length - 1U ) / length;
+    size_t encodedLength = 0, decodedLength = 0;
+
+    startTimeNs = GetTimeNs();
+    for( i = 0; i < rounds; i++ )
+    {
+        encodedLength = sizeof( encodedBuffer );
+        if( useMbedtls != 0U )
+        {
+            ( void ) mbedtls_base64_encode( encodedBuffer, encodedLength, &( encodedLength ), rawBuffer, length );
+        }
+        else
+        {
+            ( void ) Base64_Encode( ( const char * ) rawBuffer, length, ( char * ) encodedBuffer, &( encodedLength ) );
+        }
+    }
+    encodeTimeNs = GetTimeNs() - startTimeNs;
+
+    startTimeNs = GetTimeNs();
+    for( i = 0; i < rounds; i++ )
+    {
+        decodedLength = sizeof( actualBuffer );
+        if( useMbedtls != 0U )
+        {
+            ( void ) mbedtls_base64_decode( actualBuffer, decodedLength, &( decodedLength ), encodedBuffer, encodedLength );
+        }
+        else
+        {
+            ( void ) Base64_Decode( ( const char * ) encodedBuffer, encodedLength, ( char * ) actualBuffer, &( decodedLength ) );
+        }
+    }
+    decodeTimeNs = GetTimeNs() - startTimeNs;
+
+    /* Throughput counts the raw bytes both ways. */
+    printf( "%-8s %8lu %12.1f %12.1f %s\n",
+            pName,
+            length,
+            encodeTimeNs > 0U ? ( double ) ( rounds * length ) * 1000.0 / ( double ) encodeTimeNs : 0.0,
+            decodeTimeNs > 0U ? ( double ) ( rounds * length ) * 1000.0 / ( double ) decodeTimeNs : 0.0,
+            ( ( decodedLength == length ) && ( memcmp( actualBuffer, rawBuffer, length ) == 0 ) ) ? "ok" : "round trip failed" );
+}
+
+/*----------------------------------------------------------------------------*/
+
+int main( int argc,
+          char * argv[] )
+{
+    int ret = 0, option, implementation;
+    uint32_t iterations = BASE64_BENCHMARK_DEFAULT_CHECK_ITERATIONS, megabytes = BASE64_BENCHMARK_DEFAULT_MEGABYTES;
+    Base64SimdImplementation_t defaultImplementation;
+    size_t i;
+
+    while( ( option = getopt( argc, argv, "n:m:" ) ) != -1 )
+    {
+        switch( option )
+        {
+            case 'n':
+                iterations = ( uint32_t ) strtoul( optarg, NULL, 10 );
+                break;
+            case 'm':
+                megabytes = ( uint32_t ) strtoul( optarg, NULL, 10 );
+                break;
+            default:
+                printf( "Usage: %s [-n check_iterations] [-m megabytes_per_case]\n", argv[ 0 ] );
+                ret = -1;
+                break;
+        }
+    }
+
+    if( ( ret == 0 ) && ( megabytes == 0U ) )
+    {
+        printf( "Megabytes per case must be above 0\n" );
+        ret = -1;
+    }
+
+    if( ret == 0 )
+    {
+        srand( 1 );
+        defaultImplementation = Base64Simd_GetImplementation();
+        printf( "default implementation: %s\n", Base64Simd_GetImplementationName( defaultImplementation ) );
+
+        for( implementation = 0; implementation < BASE64_SIMD_IMPLEMENTATION_MAX; implementation++ )
+        {
+            if( Base64Simd_ForceImplementation( ( Base64SimdImplementation_t ) implementation ) == BASE64_RESULT_OK )
+            {
+                ret = RunCheck( iterations ) == 0 ? ret : -1;
+                printf( "%-8s %u checks %s\n",
+                        Base64Simd_GetImplementationName( ( Base64SimdImplementation_t ) implementation ),
+                        iterations,
+                        ret == 0 ? "passed" : "failed" );
+            }
+        }
+    }
+
+    if( ret == 0 )
+    {
+        for( i = 0; i < sizeof( rawBuffer ); i++ )
+        {
+            rawBuffer[ i ] = ( uint8_t ) rand();
+        }
+
+        printf( "%-8s %8s %12s %12s\n", "codec", "bytes", "encode MB/s", "decode MB/s" );
+
+        for( i = 0; i < sizeof( benchmarkLengths ) / sizeof( benchmarkLengths[ 0 ] ); i++ )
+        {
+            RunBenchmark( "mbedtls", 1U, benchmarkLengths[ i ], megabytes );
+
+            for( implementation = 0; implementation < BASE64_SIMD_IMPLEMENTATION_MAX; implementation++ )
+            {
+                if( Base64Simd_ForceImplementation( ( Base64SimdImplementation_t ) implementation ) == BASE64_RESULT_OK )
+                {
+                    RunBenchmark( Base64Simd_GetImplementationName( ( Base64SimdImplementation_t ) implementation ),
+                                  0U, benchmarkLengths[ i ], megabytes );
+                }
+            }
+        }
+
+        ( void ) Base64Simd_ForceImplementation( defaultImplementation );
+    }
+
+    return ( ret == 0 ) ? 0 : 1;
+}
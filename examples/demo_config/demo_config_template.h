@@ -51,6 +51,17 @@
 
 #define AWS_MAX_VIEWER_NUM ( 2 )
 
+/* Uncomment to persist the generated DTLS certificate and key, so they are reused after reboot. */
+// #define DTLS_CERTIFICATE_PERSIST_CERT_PATH "cert/dtls_cert.der"
+// #define DTLS_CERTIFICATE_PERSIST_KEY_PATH "cert/dtls_key.der"
+
+/* Uncomment to cache the signaling channel ARN, endpoints and ICE server configs, so a restart connects without resolving them first. */
+// #define SIGNALING_CACHE_FILE_PATH "signaling_cache.txt"
+
+/* Uncomment to use a local mock signaling server (WebRTCLinuxMockSignalingServer) instead of the region's
+ * control plane. AWS_CA_CERT_PATH must then point to the certificate the mock server is started with. */
+// #define AWS_KVS_CONTROL_PLANE_ENDPOINT "https://127.0.0.1:8443"
+
 /* Audio codec setting. */
 #define AUDIO_OPUS         1
 
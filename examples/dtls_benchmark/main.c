@@ -0,0 +1,453 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * DTLS handshake loopback benchmark.
+ *
+ * Runs full DTLS-SRTP handshakes between two in-process endpoints, a client
+ * and a server, each with its own certificate generated the same way as the
+ * peer connection does. Datagrams sent through the DTLS send hook are queued
+ * and fed to the peer's DTLS_ProcessPacket, so the time measured is the CPU
+ * time of the handshake without any network latency. Both ECDSA and RSA
+ * certificates are measured, and every handshake must export the same SRTP
+ * keying material on both sides. With METRIC_PRINT_ENABLED, the per-step CPU
+ * time and flight histograms of the DTLS transport are printed at the end.
+ *
+ * Usage: WebRTCLinuxDtlsBenchmark [-n handshakes_per_case]
+ *
+ * Exits with 1 if a handshake fails or the keying material doesn't match.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "transport_dtls_mbedtls.h"
+
+#if METRIC_PRINT_ENABLED
+#include "metric.h"
+#endif
+
+/* Handshakes run per certificate type, unless overridden by -n. */
+#define DTLS_BENCHMARK_DEFAULT_HANDSHAKES_PER_CASE ( 200 )
+
+/* Datagrams a flight can have in flight to one endpoint, a certificate flight is a few datagrams. */
+#define DTLS_BENCHMARK_MAX_QUEUED_DATAGRAMS        ( 32 )
+#define DTLS_BENCHMARK_MAX_DATAGRAM_LENGTH         ( 16384 + 512 )
+
+/* Flights exchanged before a handshake is considered stalled, a full handshake takes 4 to 6. */
+#define DTLS_BENCHMARK_MAX_ROUNDS                  ( 32 )
+
+typedef struct DtlsBenchmarkDatagram
+{
+    size_t length;
+    uint8_t data[ DTLS_BENCHMARK_MAX_DATAGRAM_LENGTH ];
+} DtlsBenchmarkDatagram_t;
+
+typedef struct DtlsBenchmarkQueue
+{
+    DtlsBenchmarkDatagram_t datagrams[ DTLS_BENCHMARK_MAX_QUEUED_DATAGRAMS ];
+    uint32_t count;
+    uint64_t sentDatagrams;
+    uint64_t sentBytes;
+} DtlsBenchmarkQueue_t;
+
+typedef struct DtlsBenchmarkEndpoint
+{
+    const char * pName;
+    uint8_t isServer;
+    mbedtls_x509_crt cert;
+    mbedtls_pk_context key;
+    DtlsSharedConfig_t sharedConfig;
+    DtlsSession_t session;
+    DtlsBenchmarkQueue_t inbound;
+    uint8_t isHandshakeComplete;
+} DtlsBenchmarkEndpoint_t;
+
+static DtlsBenchmarkEndpoint_t clientEndpoint = { .pName = "client", .isServer = 0U };
+static DtlsBenchmarkEndpoint_t serverEndpoint = { .pName = "server", .isServer = 1U };
+static uint8_t readBuffer[ DTLS_BENCHMARK_MAX_DATAGRAM_LENGTH ];
+
+/*----------------------------------------------------------------------------*/
+
+static uint64_t GetTimeNs( void )
+{
+    struct timespec now;
+
+    clock_gettime( CLOCK_MONOTONIC, &( now ) );
+
+    return ( uint64_t ) now.tv_sec * 1000000000ULL + ( uint64_t ) now.tv_nsec;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static int CompareUint64( const void * pA,
+                          const void * pB )
+{
+    uint64_t a = *( const uint64_t * ) pA;
+    uint64_t b = *( const uint64_t * ) pB;
+
+    return ( a > b ) - ( a < b );
+}
+
+/*----------------------------------------------------------------------------*/
+
+/* Queue the datagram to the peer, it's delivered once the sender returns from the DTLS call. */
+static int32_t OnDtlsSendHook( void * pCustomContext,
+                               const uint8_t * pInputBuffer,
+                               size_t inputBufferLength )
+{
+    int32_t ret = 0;
+    DtlsBenchmarkQueue_t * pQueue = ( DtlsBenchmarkQueue_t * ) pCustomContext;
+
+    if( ( pQueue->count >= DTLS_BENCHMARK_MAX_QUEUED_DATAGRAMS ) || ( inputBufferLength > DTLS_BENCHMARK_MAX_DATAGRAM_LENGTH ) )
+    {
+        printf( "Fail to queue a %lu bytes datagram, %u datagrams queued\n", ( unsigned long ) inputBufferLength, pQueue->count );
+        ret = -1;
+    }
+    else
+    {
+        memcpy( pQueue->datagrams[ pQueue->count ].data, pInputBuffer, inputBufferLength );
+        pQueue->datagrams[ pQueue->count ].length = inputBufferLength;
+        pQueue->count++;
+        pQueue->sentDatagrams++;
+        pQueue->sentBytes += inputBufferLength;
+        ret = ( int32_t ) inputBufferLength;
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static int InitEndpoint( DtlsBenchmarkEndpoint_t * pEndpoint,
+                         int generateRSACertificate )
+{
+    int ret = 0;
+
+    if( DTLS_CreateCertificateAndKey( GENERATED_CERTIFICATE_BITS,
+                                      generateRSACertificate,
+                                      &pEndpoint->cert,
+                                      &pEndpoint->key ) != DTLS_SUCCESS )
+    {
+        printf( "Fail to create the %s certificate\n", pEndpoint->pName );
+        ret = -1;
+    }
+    else if( DTLS_InitSharedConfig( &pEndpoint->sharedConfig,
+                                    &pEndpoint->cert,
+                                    &pEndpoint->key,
+                                    pEndpoint->isServer ) != DTLS_SUCCESS )
+    {
+        printf( "Fail to initialize the %s shared config\n", pEndpoint->pName );
+        ( void ) DTLS_FreeCertificateAndKey( &pEndpoint->cert, &pEndpoint->key );
+        ret = -1;
+    }
+    else
+    {
+        /* Empty else marker. */
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static void FreeEndpoint( DtlsBenchmarkEndpoint_t * pEndpoint )
+{
+    DTLS_FreeSharedConfig( &pEndpoint->sharedConfig );
+    ( void ) DTLS_FreeCertificateAndKey( &pEndpoint->cert, &pEndpoint->key );
+}
+
+/*----------------------------------------------------------------------------*/
+
+static int StartSession( DtlsBenchmarkEndpoint_t * pEndpoint,
+                         DtlsBenchmarkEndpoint_t * pPeer )
+{
+    int ret = 0;
+    DtlsSession_t * pSession = &pEndpoint->session;
+
+    memset( pSession, 0, sizeof( DtlsSession_t ) );
+    pSession->xDtlsNetworkContext.pParams = &pSession->xDtlsTransportParams;
+    pSession->xDtlsTransportParams.onDtlsSendHook = OnDtlsSendHook;
+    pSession->xDtlsTransportParams.pOnDtlsSendCustomContext = ( void * ) &pPeer->inbound;
+    pSession->xNetworkCredentials.disableSni = 1;
+    pSession->xNetworkCredentials.pSharedConfig = &pEndpoint->sharedConfig;
+    pEndpoint->inbound.count = 0U;
+    pEndpoint->isHandshakeComplete = 0U;
+
+    if( DTLS_Init( &pSession->xDtlsNetworkContext,
+                   &pSession->xNetworkCredentials,
+                   pEndpoint->isServer ) != DTLS_SUCCESS )
+    {
+        printf( "Fail to initialize the %s DTLS session\n", pEndpoint->pName );
+        ret = -1;
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+/* Feed every queued datagram to the endpoint, its answers are queued to the peer. */
+static int DeliverDatagrams( DtlsBenchmarkEndpoint_t * pEndpoint )
+{
+    int ret = 0;
+    DtlsTransportStatus_t dtlsStatus;
+    size_t readBufferSize;
+    uint32_t i;
+
+    for( i = 0; ( ret == 0 ) && ( i < pEndpoint->inbound.count ); i++ )
+    {
+        readBufferSize = sizeof( readBuffer );
+        dtlsStatus = DTLS_ProcessPacket( &pEndpoint->session.xDtlsNetworkContext,
+                                         pEndpoint->inbound.datagrams[ i ].data,
+                                         pEndpoint->inbound.datagrams[ i ].length,
+                                         readBuffer,
+                                         &readBufferSize );
+        if( dtlsStatus == DTLS_HANDSHAKE_COMPLETE )
+        {
+            pEndpoint->isHandshakeComplete = 1U;
+        }
+        else if( dtlsStatus != DTLS_SUCCESS )
+        {
+            printf( "The %s fails to process a DTLS datagram, return %d\n", pEndpoint->pName, dtlsStatus );
+            ret = -1;
+        }
+        else
+        {
+            /* Empty else marker. */
+        }
+    }
+    pEndpoint->inbound.count = 0U;
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static int RunHandshake( uint64_t * pHandshakeNs )
+{
+    int ret = 0;
+    uint32_t rounds = 0;
+    uint64_t startNs;
+    DtlsKeyingMaterial clientKeyingMaterial;
+    DtlsKeyingMaterial serverKeyingMaterial;
+
+    ret = StartSession( &serverEndpoint, &clientEndpoint );
+    if( ret == 0 )
+    {
+        ret = StartSession( &clientEndpoint, &serverEndpoint );
+    }
+
+    startNs = GetTimeNs();
+    if( ( ret == 0 ) && ( DTLS_ExecuteHandshake( &clientEndpoint.session.xDtlsNetworkContext ) != DTLS_SUCCESS ) )
+    {
+        printf( "Fail to start the client handshake\n" );
+        ret = -1;
+    }
+
+    while( ( ret == 0 ) && ( ( clientEndpoint.isHandshakeComplete == 0U ) || ( serverEndpoint.isHandshakeComplete == 0U ) ) )
+    {
+        if( ( ++rounds > DTLS_BENCHMARK_MAX_ROUNDS ) ||
+            ( ( serverEndpoint.inbound.count == 0U ) && ( clientEndpoint.inbound.count == 0U ) ) )
+        {
+            printf( "DTLS handshake stalls after %u rounds, client complete: %u, server complete: %u\n",
+                    rounds, clientEndpoint.isHandshakeComplete, serverEndpoint.isHandshakeComplete );
+            ret = -1;
+        }
+
+        if( ret == 0 )
+        {
+            ret = DeliverDatagrams( &serverEndpoint );
+        }
+
+        if( ret == 0 )
+        {
+            ret = DeliverDatagrams( &clientEndpoint );
+        }
+    }
+    *pHandshakeNs = GetTimeNs() - startNs;
+
+    /* Both sides must derive the same SRTP keys, as the peer connection does right after the handshake. */
+    if( ret == 0 )
+    {
+        memset( &clientKeyingMaterial, 0, sizeof( clientKeyingMaterial ) );
+        memset( &serverKeyingMaterial, 0, sizeof( serverKeyingMaterial ) );
+
+        if( ( DTLS_PopulateKeyingMaterial( &clientEndpoint.session.xDtlsTransportParams.dtlsSslContext, &clientKeyingMaterial ) != DTLS_SUCCESS ) ||
+            ( DTLS_PopulateKeyingMaterial( &serverEndpoint.session.xDtlsTransportParams.dtlsSslContext, &serverKeyingMaterial ) != DTLS_SUCCESS ) )
+        {
+            printf( "Fail to populate the keying material\n" );
+            ret = -1;
+        }
+        else if( ( clientKeyingMaterial.srtpProfile != serverKeyingMaterial.srtpProfile ) ||
+                 ( clientKeyingMaterial.key_length != serverKeyingMaterial.key_length ) ||
+                 ( memcmp( clientKeyingMaterial.clientWriteKey, serverKeyingMaterial.clientWriteKey, sizeof( clientKeyingMaterial.clientWriteKey ) ) != 0 ) ||
+                 ( memcmp( clientKeyingMaterial.serverWriteKey, serverKeyingMaterial.serverWriteKey, sizeof( clientKeyingMaterial.serverWriteKey ) ) != 0 ) )
+        {
+            printf( "Client and server keying material don't match\n" );
+            ret = -1;
+        }
+        else
+        {
+            /* Empty else marker. */
+        }
+    }
+
+    /* The close notify alerts are queued and dropped with the sessions. */
+    DTLS_Disconnect( &clientEndpoint.session.xDtlsNetworkContext );
+    DTLS_Disconnect( &serverEndpoint.session.xDtlsNetworkContext );
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static int RunCase( const char * pName,
+                    int generateRSACertificate,
+                    uint32_t handshakesPerCase )
+{
+    int ret = 0;
+    uint64_t * pHandshakeNs = NULL;
+    uint64_t totalNs = 0;
+    uint64_t sentDatagrams;
+    uint64_t sentBytes;
+    uint32_t handshakes = 0;
+    uint32_t i;
+
+    pHandshakeNs = ( uint64_t * ) malloc( handshakesPerCase * sizeof( uint64_t ) );
+    if( pHandshakeNs == NULL )
+    {
+        printf( "Fail to allocate %u handshake durations\n", handshakesPerCase );
+        ret = -1;
+    }
+
+    if( ret == 0 )
+    {
+        ret = InitEndpoint( &clientEndpoint, generateRSACertificate );
+    }
+
+    if( ret == 0 )
+    {
+        ret = InitEndpoint( &serverEndpoint, generateRSACertificate );
+        if( ret != 0 )
+        {
+            FreeEndpoint( &clientEndpoint );
+        }
+    }
+
+    if( ret == 0 )
+    {
+        clientEndpoint.inbound.sentDatagrams = 0U;
+        clientEndpoint.inbound.sentBytes = 0U;
+        serverEndpoint.inbound.sentDatagrams = 0U;
+        serverEndpoint.inbound.sentBytes = 0U;
+
+        for( handshakes = 0; ( ret == 0 ) && ( handshakes < handshakesPerCase ); handshakes++ )
+        {
+            ret = RunHandshake( &( pHandshakeNs[ handshakes ] ) );
+        }
+
+        FreeEndpoint( &clientEndpoint );
+        FreeEndpoint( &serverEndpoint );
+    }
+
+    if( ret == 0 )
+    {
+        for( i = 0; i < handshakes; i++ )
+        {
+            totalNs += pHandshakeNs[ i ];
+        }
+        qsort( pHandshakeNs, handshakes, sizeof( uint64_t ), CompareUint64 );
+
+        sentDatagrams = clientEndpoint.inbound.sentDatagrams + serverEndpoint.inbound.sentDatagrams;
+        sentBytes = clientEndpoint.inbound.sentBytes + serverEndpoint.inbound.sentBytes;
+
+        printf( "%-12s %10u %12.1f %10.1f %10.1f %10.1f %10.1f %10.1f\n",
+                pName,
+                handshakes,
+                ( double ) handshakes / ( ( double ) totalNs / 1e9 ),
+                ( double ) totalNs / handshakes / 1e6,
+                ( double ) pHandshakeNs[ handshakes / 2 ] / 1e6,
+                ( double ) pHandshakeNs[ ( handshakes * 99 ) / 100 ] / 1e6,
+                ( double ) pHandshakeNs[ handshakes - 1 ] / 1e6,
+                ( double ) sentBytes / handshakes );
+        printf( "%-12s %10.1f datagrams per handshake\n", "", ( double ) sentDatagrams / handshakes );
+    }
+
+    if( pHandshakeNs != NULL )
+    {
+        free( pHandshakeNs );
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+int main( int argc,
+          char * argv[] )
+{
+    int ret = 0;
+    int option;
+    uint32_t handshakesPerCase = DTLS_BENCHMARK_DEFAULT_HANDSHAKES_PER_CASE;
+
+    while( ( option = getopt( argc, argv, "n:" ) ) != -1 )
+    {
+        switch( option )
+        {
+            case 'n':
+                handshakesPerCase = ( uint32_t ) strtoul( optarg, NULL, 10 );
+                break;
+            default:
+                printf( "Usage: %s [-n handshakes_per_case]\n", argv[ 0 ] );
+                ret = -1;
+                break;
+        }
+    }
+
+    if( ( ret == 0 ) && ( handshakesPerCase == 0U ) )
+    {
+        printf( "Handshakes per case must be above 0\n" );
+        ret = -1;
+    }
+
+    if( ret == 0 )
+    {
+        #if METRIC_PRINT_ENABLED
+            Metric_Init();
+        #endif /* METRIC_PRINT_ENABLED */
+
+        printf( "%-12s %10s %12s %10s %10s %10s %10s %10s\n",
+                "certificate", "handshakes", "handshakes/s", "mean ms", "p50 ms", "p99 ms", "max ms", "bytes" );
+
+        ret = RunCase( "ecdsa", 0, handshakesPerCase );
+
+        if( ret == 0 )
+        {
+            ret = RunCase( "rsa", 1, handshakesPerCase );
+        }
+
+        #if METRIC_PRINT_ENABLED
+            Metric_PrintMetrics();
+        #endif /* METRIC_PRINT_ENABLED */
+    }
+
+    return ( ret == 0 ) ? 0 : 1;
+}
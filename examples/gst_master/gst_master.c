@@ -231,60 +231,47 @@ static int32_t OnMediaSinkHook( void * pCustom,
 {
     int32_t ret = 0;
     AppContext_t * pAppContext = ( AppContext_t * ) pCustom;
-    PeerConnectionResult_t peerConnectionResult;
-    Transceiver_t * pTransceiver = NULL;
-    PeerConnectionFrame_t peerConnectionFrame;
-    int i;
 
     if( ( pAppContext == NULL ) || ( pFrame == NULL ) )
     {
         LogError( ( "Invalid input, pCustom: %p, pFrame: %p", pCustom, pFrame ) );
         ret = -1;
     }
+    else if( ( pFrame->trackKind != TRANSCEIVER_TRACK_KIND_VIDEO ) &&
+             ( pFrame->trackKind != TRANSCEIVER_TRACK_KIND_AUDIO ) )
+    {
+        LogWarn( ( "Unknown track kind: %d", pFrame->trackKind ) );
+        ret = -2;
+    }
+    else
+    {
+        /* Empty else marker. */
+    }
 
     if( ret == 0 )
     {
-        peerConnectionFrame.version = PEER_CONNECTION_FRAME_CURRENT_VERSION;
-        peerConnectionFrame.presentationUs = pFrame->timestampUs;
-        peerConnectionFrame.pData = pFrame->pData;
-        peerConnectionFrame.dataLength = pFrame->size;
-
-        for( i = 0; i < AWS_MAX_VIEWER_NUM; i++ )
+        /* Hand the frame to the egress workers, so a slow viewer never stalls the media source. */
+        ret = AppEgress_PushFrame( &pAppContext->egressContext,
+                                   pFrame->trackKind,
+                                   pFrame->pData,
+                                   pFrame->size,
+                                   pFrame->timestampUs );
+        if( ret != 0 )
         {
-            if( pFrame->trackKind == TRANSCEIVER_TRACK_KIND_VIDEO )
-            {
-                pTransceiver = &pAppContext->appSessions[ i ].transceivers[ DEMO_TRANSCEIVER_MEDIA_INDEX_VIDEO ];
-            }
-            else if( pFrame->trackKind == TRANSCEIVER_TRACK_KIND_AUDIO )
-            {
-                pTransceiver = &pAppContext->appSessions[ i ].transceivers[ DEMO_TRANSCEIVER_MEDIA_INDEX_AUDIO ];
-            }
-            else
-            {
-                /* Unknown kind, skip that. */
-                LogWarn( ( "Unknown track kind: %d", pFrame->trackKind ) );
-                break;
-            }
-
-            if( pAppContext->appSessions[ i ].peerConnectionSession.state == PEER_CONNECTION_SESSION_STATE_CONNECTION_READY )
-            {
-                peerConnectionResult = PeerConnection_WriteFrame( &pAppContext->appSessions[ i ].peerConnectionSession,
-                                                                  pTransceiver,
-                                                                  &peerConnectionFrame );
-
-                if( peerConnectionResult != PEER_CONNECTION_RESULT_OK )
-                {
-                    LogError( ( "Fail to write %s frame, result: %d", ( pFrame->trackKind == TRANSCEIVER_TRACK_KIND_VIDEO ) ? "video" : "audio",
-                                peerConnectionResult ) );
-                    ret = -3;
-                }
-            }
+            LogError( ( "Fail to push %s frame to egress, result: %d", ( pFrame->trackKind == TRANSCEIVER_TRACK_KIND_VIDEO ) ? "video" : "audio",
+                        ret ) );
+            ret = -3;
         }
     }
 
     return ret;
 }
 
+static void RequestKeyFrame( void * pMediaContext )
+{
+    ( void ) GstMediaSource_RequestKeyFrame( ( GstMediaSourcesContext_t * ) pMediaContext );
+}
+
 static int32_t InitializeGstMediaSource( AppContext_t * pAppContext,
                                          GstMediaSourcesContext_t * pGstMediaSourceContext )
 {
@@ -304,6 +291,11 @@ static int32_t InitializeGstMediaSource( AppContext_t * pAppContext,
                                    pAppContext );
     }
 
+    if( ret == 0 )
+    {
+        pAppContext->requestKeyFrameFunc = RequestKeyFrame;
+    }
+
     #if ENABLE_TWCC_SUPPORT
         if( ret == 0 )
         {
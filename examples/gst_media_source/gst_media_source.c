@@ -420,6 +420,35 @@ static int32_t InitPipeline( GstMediaSourcesContext_t * pCtx )
     return ret;
 }
 
+int32_t GstMediaSource_RequestKeyFrame( GstMediaSourcesContext_t * pCtx )
+{
+    int32_t ret = 0;
+    GstEvent * pEvent = NULL;
+
+    if( ( pCtx == NULL ) || ( pCtx->videoContext.pAppsink == NULL ) )
+    {
+        LogError( ( "Invalid input, pCtx: %p", pCtx ) );
+        ret = -1;
+    }
+
+    if( ret == 0 )
+    {
+        // Send force key unit event upstream from the sink, so the encoder emits IDR with SPS/PPS
+        pEvent = gst_event_new_custom( GST_EVENT_CUSTOM_UPSTREAM,
+                                       gst_structure_new( "GstForceKeyUnit",
+                                                          "all-headers", G_TYPE_BOOLEAN, TRUE,
+                                                          NULL ) );
+        if( gst_element_send_event( pCtx->videoContext.pAppsink,
+                                    pEvent ) == FALSE )
+        {
+            LogWarn( ( "Failed to send force key unit event" ) );
+            ret = -1;
+        }
+    }
+
+    return ret;
+}
+
 int32_t GstMediaSource_Cleanup( GstMediaSourcesContext_t * pCtx )
 {
     int32_t ret = 0;
@@ -86,6 +86,11 @@ int32_t GstMediaSource_InitVideoTransceiver( GstMediaSourcesContext_t * pCtx,
 int32_t GstMediaSource_InitAudioTransceiver( GstMediaSourcesContext_t * pCtx,
                                              Transceiver_t * pAudioTranceiver );
 
+/**
+ * @brief Ask the video encoder to produce a keyframe as soon as possible
+ */
+int32_t GstMediaSource_RequestKeyFrame( GstMediaSourcesContext_t * pCtx );
+
 /**
  * @brief Cleanup media source context
  */
@@ -354,6 +354,11 @@ static void ProcessLocalCandidates( IceControllerContext_t * pCtx )
             {
                 result = IceControllerNet_ExecuteTlsHandshake( pCtx, pSocketContext, 1U );
             }
+            else if( pSocketContext == pCtx->pRestartSocketContext )
+            {
+                /* The path held over an ICE restart has no candidate in the current ICE context. */
+                continue;
+            }
             else if( pSocketContext->pLocalCandidate != NULL )
             {
                 stunBufferLength = ICE_CONTROLLER_STUN_MESSAGE_BUFFER_SIZE;
@@ -679,11 +684,70 @@ static void PrintCandidatePairsStatus( IceControllerContext_t * pCtx )
     }
 }
 
+static IceControllerSocketContext_t * SelectBackupSocketContext( IceControllerContext_t * pCtx,
+                                                                 IceControllerSocketContext_t * pChosenSocketContext )
+{
+    IceControllerSocketContext_t * pBackupSocketContext = NULL;
+    IceCandidatePair_t * pCandidatePair;
+    IceResult_t iceResult;
+    size_t count;
+    size_t i;
+
+    if( pthread_mutex_lock( &( pCtx->iceMutex ) ) == 0 )
+    {
+        iceResult = Ice_GetCandidatePairCount( &pCtx->iceContext,
+                                               &count );
+        if( iceResult != ICE_RESULT_OK )
+        {
+            LogError( ( "Fail to query valid candidate pair count, result: %d", iceResult ) );
+            count = 0;
+        }
+
+        /* Pick the first succeeded pair using a different non-relay socket as backup path. */
+        for( i = 0; i < count; i++ )
+        {
+            pCandidatePair = &pCtx->iceContext.pCandidatePairs[i];
+
+            if( ( pCandidatePair == pChosenSocketContext->pCandidatePair ) ||
+                ( pCandidatePair->state != ICE_CANDIDATE_PAIR_STATE_SUCCEEDED ) ||
+                ( pCandidatePair->pLocalCandidate == NULL ) ||
+                ( pCandidatePair->pLocalCandidate->candidateType == ICE_CANDIDATE_TYPE_RELAY ) )
+            {
+                continue;
+            }
+
+            pBackupSocketContext = FindSocketContextByLocalCandidate( pCtx,
+                                                                      pCandidatePair->pLocalCandidate );
+            if( ( pBackupSocketContext != NULL ) &&
+                ( pBackupSocketContext->socketFd != pChosenSocketContext->socketFd ) )
+            {
+                pBackupSocketContext->pRemoteCandidate = pCandidatePair->pRemoteCandidate;
+                pBackupSocketContext->pCandidatePair = pCandidatePair;
+                LogInfo( ( "Keep backup pair, local/remote candidate ID: 0x%04x / 0x%04x",
+                           pCandidatePair->pLocalCandidate->candidateId,
+                           pCandidatePair->pRemoteCandidate->candidateId ) );
+                break;
+            }
+
+            pBackupSocketContext = NULL;
+        }
+
+        pthread_mutex_unlock( &( pCtx->iceMutex ) );
+    }
+    else
+    {
+        LogError( ( "Failed to select backup pair: mutex lock acquisition." ) );
+    }
+
+    return pBackupSocketContext;
+}
+
 static void ReleaseOtherSockets( IceControllerContext_t * pCtx,
                                  IceControllerSocketContext_t * pChosenSocketContext )
 {
     uint8_t skipProcess = 0;
     int i;
+    IceControllerSocketContext_t * pBackupSocketContext = NULL;
 
     if( ( pCtx == NULL ) || ( pChosenSocketContext == NULL ) )
     {
@@ -693,10 +757,19 @@ static void ReleaseOtherSockets( IceControllerContext_t * pCtx,
 
     if( skipProcess == 0 )
     {
+        pBackupSocketContext = SelectBackupSocketContext( pCtx,
+                                                          pChosenSocketContext );
+        pCtx->pBackupSocketContext = pBackupSocketContext;
+
         LogDebug( ( "Closing sockets other than local candidate ID: 0x%04x", pChosenSocketContext->pLocalCandidate->candidateId ) );
         for( i = 0; i < pCtx->socketsContextsCount; i++ )
         {
-            if( pCtx->socketsContexts[i].socketFd != pChosenSocketContext->socketFd )
+            if( &pCtx->socketsContexts[i] == pBackupSocketContext )
+            {
+                /* Keep the backup socket for path migration. */
+                continue;
+            }
+            else if( pCtx->socketsContexts[i].socketFd != pChosenSocketContext->socketFd )
             {
                 if( ( pCtx->socketsContexts[i].pLocalCandidate != NULL ) && ( pCtx->socketsContexts[i].pLocalCandidate->candidateType == ICE_CANDIDATE_TYPE_RELAY ) )
                 {
@@ -728,7 +801,8 @@ static void ReleaseOtherSockets( IceControllerContext_t * pCtx,
     if( skipProcess == 0 )
     {
         IceController_CloseOtherCandidatePairs( pCtx,
-                                                pChosenSocketContext->pCandidatePair );
+                                                pChosenSocketContext->pCandidatePair,
+                                                ( pBackupSocketContext != NULL ) ? pBackupSocketContext->pCandidatePair : NULL );
     }
 }
 
@@ -744,6 +818,7 @@ void IceController_HandleEvent( IceControllerContext_t * pCtx,
         switch( event )
         {
             case ICE_CONTROLLER_EVENT_DTLS_HANDSHAKE_DONE:
+            case ICE_CONTROLLER_EVENT_ICE_RESTART_DONE:
             {
                 ReleaseOtherSockets( pCtx,
                                      pCtx->pNominatedSocketContext );
@@ -969,6 +1044,7 @@ IceControllerResult_t IceController_ProcessIceCandidatesAndPairs( IceControllerC
 IceControllerResult_t IceController_PeriodConnectionCheck( IceControllerContext_t * pCtx )
 {
     IceControllerResult_t ret = ICE_CONTROLLER_RESULT_OK;
+    IceControllerResult_t nominatedResult = ICE_CONTROLLER_RESULT_OK;
 
     if( pCtx == NULL )
     {
@@ -984,9 +1060,18 @@ IceControllerResult_t IceController_PeriodConnectionCheck( IceControllerContext_
             /* Check nominated candidated pair lifetime by calling Ice_CreateNextPairRequest. */
             if( pthread_mutex_lock( &( pCtx->iceMutex ) ) == 0 )
             {
-                ( void ) HandleCandidatePairRequest( pCtx,
-                                                     pCtx->pNominatedSocketContext,
-                                                     pCtx->pNominatedSocketContext->pCandidatePair );
+                nominatedResult = HandleCandidatePairRequest( pCtx,
+                                                              pCtx->pNominatedSocketContext,
+                                                              pCtx->pNominatedSocketContext->pCandidatePair );
+
+                /* Keep consent of backup pair fresh as well, so it's ready to take over. */
+                if( ( pCtx->pBackupSocketContext != NULL ) &&
+                    ( pCtx->pBackupSocketContext->pCandidatePair != NULL ) )
+                {
+                    ( void ) HandleCandidatePairRequest( pCtx,
+                                                         pCtx->pBackupSocketContext,
+                                                         pCtx->pBackupSocketContext->pCandidatePair );
+                }
                 pthread_mutex_unlock( &( pCtx->iceMutex ) );
             }
             else
@@ -1001,6 +1086,14 @@ IceControllerResult_t IceController_PeriodConnectionCheck( IceControllerContext_
         }
     }
 
+    if( ( ret == ICE_CONTROLLER_RESULT_OK ) &&
+        ( nominatedResult == ICE_CONTROLLER_RESULT_FAIL_CREATE_NEXT_PAIR_REQUEST ) )
+    {
+        /* Consent of nominated pair is lost, move media to backup path if there is one. */
+        LogWarn( ( "Lost consent on nominated pair, trying backup path." ) );
+        ( void ) IceController_MigrateToBackupPath( pCtx );
+    }
+
     if( ret == ICE_CONTROLLER_RESULT_OK )
     {
         /* Check local candidates to make sure all unused TURN session are released correctly. */
@@ -1530,15 +1623,29 @@ IceControllerResult_t IceController_Start( IceControllerContext_t * pCtx,
     {
         for( i = 0; i < ICE_CONTROLLER_MAX_LOCAL_CANDIDATE_COUNT; i++ )
         {
-            if( pCtx->socketsContexts[i].socketFd >= 0 )
+            if( ( pCtx->socketsContexts[i].socketFd >= 0 ) &&
+                ( &pCtx->socketsContexts[i] != pCtx->pRestartSocketContext ) )
             {
                 /* Force close socket before next round. */
                 IceControllerNet_FreeSocketContext( pCtx,
                                                     &pCtx->socketsContexts[i] );
             }
         }
-        pCtx->socketsContextsCount = 0;
-        pCtx->pNominatedSocketContext = NULL;
+
+        if( pthread_mutex_lock( &( pCtx->socketMutex ) ) == 0 )
+        {
+            /* The path held by IceController_Restart stays in the first slot, new sockets go after it. */
+            pCtx->socketsContextsCount = ( pCtx->pRestartSocketContext != NULL ) ? 1 : 0;
+            pCtx->pNominatedSocketContext = NULL;
+            pCtx->pBackupSocketContext = NULL;
+
+            pthread_mutex_unlock( &( pCtx->socketMutex ) );
+        }
+        else
+        {
+            LogError( ( "Failed to reset socket contexts: mutex lock acquisition." ) );
+            ret = ICE_CONTROLLER_RESULT_FAIL_MUTEX_TAKE;
+        }
     }
 
     if( ret == ICE_CONTROLLER_RESULT_OK )
@@ -1572,16 +1679,229 @@ IceControllerResult_t IceController_Start( IceControllerContext_t * pCtx,
     return ret;
 }
 
+/* Move the nominated socket context to the first slot, with its candidates and pair copied out of
+ * the ICE context, so it survives re-initializing the ICE agent. Returns 1 if the path is held. */
+static uint8_t HoldNominatedPath( IceControllerContext_t * pCtx )
+{
+    uint8_t isHeld = 0U;
+    IceControllerSocketContext_t * pNominatedSocketContext = NULL;
+    IceControllerSocketContext_t * pHeldSocketContext = &pCtx->socketsContexts[ 0 ];
+
+    /* Validate, release the first slot and move the nominated path into it in one critical section,
+     * so a concurrent nomination change can't observe or reuse a half-moved slot. */
+    if( pthread_mutex_lock( &( pCtx->socketMutex ) ) == 0 )
+    {
+        pNominatedSocketContext = pCtx->pNominatedSocketContext;
+
+        /* TURN allocations and channels live in the ICE context, a relay path can't outlive the restart. */
+        if( ( pNominatedSocketContext == NULL ) ||
+            ( pNominatedSocketContext->state != ICE_CONTROLLER_SOCKET_CONTEXT_STATE_SELECTED ) ||
+            ( pNominatedSocketContext->socketType != ICE_CONTROLLER_SOCKET_TYPE_UDP ) ||
+            ( pNominatedSocketContext->pLocalCandidate == NULL ) ||
+            ( pNominatedSocketContext->pRemoteCandidate == NULL ) ||
+            ( pNominatedSocketContext->pCandidatePair == NULL ) ||
+            ( pNominatedSocketContext->pLocalCandidate->candidateType == ICE_CANDIDATE_TYPE_RELAY ) )
+        {
+            pNominatedSocketContext = NULL;
+        }
+
+        if( pNominatedSocketContext != NULL )
+        {
+            memcpy( &pCtx->restartLocalCandidate, pNominatedSocketContext->pLocalCandidate, sizeof( IceCandidate_t ) );
+            memcpy( &pCtx->restartRemoteCandidate, pNominatedSocketContext->pRemoteCandidate, sizeof( IceCandidate_t ) );
+            memcpy( &pCtx->restartCandidatePair, pNominatedSocketContext->pCandidatePair, sizeof( IceCandidatePair_t ) );
+            pCtx->restartCandidatePair.pLocalCandidate = &pCtx->restartLocalCandidate;
+            pCtx->restartCandidatePair.pRemoteCandidate = &pCtx->restartRemoteCandidate;
+
+            if( pNominatedSocketContext != pHeldSocketContext )
+            {
+                IceControllerNet_FreeSocketContextLocked( pCtx,
+                                                          pHeldSocketContext );
+
+                memcpy( pHeldSocketContext, pNominatedSocketContext, sizeof( IceControllerSocketContext_t ) );
+                memset( pNominatedSocketContext, 0, sizeof( IceControllerSocketContext_t ) );
+                pNominatedSocketContext->socketFd = -1;
+            }
+
+            pHeldSocketContext->pLocalCandidate = &pCtx->restartLocalCandidate;
+            pHeldSocketContext->pRemoteCandidate = &pCtx->restartRemoteCandidate;
+            pHeldSocketContext->pCandidatePair = &pCtx->restartCandidatePair;
+            pHeldSocketContext->pIceServer = NULL;
+
+            pCtx->pRestartSocketContext = pHeldSocketContext;
+            pCtx->pNominatedSocketContext = NULL;
+            pCtx->pBackupSocketContext = NULL;
+            isHeld = 1U;
+        }
+
+        pthread_mutex_unlock( &( pCtx->socketMutex ) );
+    }
+    else
+    {
+        LogError( ( "Failed to hold nominated path: mutex lock acquisition." ) );
+    }
+
+    return isHeld;
+}
+
+IceControllerResult_t IceController_Restart( IceControllerContext_t * pCtx,
+                                             const char * pLocalUserName,
+                                             size_t localUserNameLength,
+                                             const char * pLocalPassword,
+                                             size_t localPasswordLength,
+                                             const char * pRemoteUserName,
+                                             size_t remoteUserNameLength,
+                                             const char * pRemotePassword,
+                                             size_t remotePasswordLength,
+                                             const char * pCombinedName,
+                                             size_t combinedNameLength )
+{
+    IceControllerResult_t ret = ICE_CONTROLLER_RESULT_OK;
+
+    if( pCtx == NULL )
+    {
+        LogError( ( "Invalid input, pCtx: %p", pCtx ) );
+        ret = ICE_CONTROLLER_RESULT_BAD_PARAMETER;
+    }
+
+    if( ret == ICE_CONTROLLER_RESULT_OK )
+    {
+        if( HoldNominatedPath( pCtx ) != 0U )
+        {
+            LogInfo( ( "Keep media on local/remote candidate ID: 0x%04x / 0x%04x during ICE restart",
+                       pCtx->restartLocalCandidate.candidateId,
+                       pCtx->restartRemoteCandidate.candidateId ) );
+        }
+        else
+        {
+            LogWarn( ( "No UDP non-relay nominated path to keep, media pauses until ICE restart completes." ) );
+        }
+
+        ret = IceController_Start( pCtx,
+                                   pLocalUserName,
+                                   localUserNameLength,
+                                   pLocalPassword,
+                                   localPasswordLength,
+                                   pRemoteUserName,
+                                   remoteUserNameLength,
+                                   pRemotePassword,
+                                   remotePasswordLength,
+                                   pCombinedName,
+                                   combinedNameLength );
+    }
+
+    return ret;
+}
+
+static IceControllerResult_t GetNominatedDestination( IceControllerContext_t * pCtx,
+                                                      IceControllerSocketContext_t ** ppSocketContext,
+                                                      IceEndpoint_t ** ppDestEndpoint )
+{
+    IceControllerResult_t ret = ICE_CONTROLLER_RESULT_OK;
+    IceControllerSocketContext_t * pSocketContext = pCtx->pNominatedSocketContext;
+
+    if( ( pSocketContext == NULL ) ||
+        ( pSocketContext->state < ICE_CONTROLLER_SOCKET_CONTEXT_STATE_SELECTED ) )
+    {
+        /* During ICE restart, keep sending on the previous path until a new pair is nominated. */
+        pSocketContext = pCtx->pRestartSocketContext;
+    }
+
+    if( ( pSocketContext == NULL ) ||
+        ( pSocketContext->state < ICE_CONTROLLER_SOCKET_CONTEXT_STATE_SELECTED ) )
+    {
+        LogWarn( ( "The connection of this session is not ready." ) );
+        ret = ICE_CONTROLLER_RESULT_FAIL_CONNECTION_NOT_READY;
+    }
+    else if( pSocketContext->pLocalCandidate == NULL )
+    {
+        LogWarn( ( "The connection of this session is not ready, local candidate pointer is NULL" ) );
+        ret = ICE_CONTROLLER_RESULT_FAIL_CONNECTION_NOT_READY;
+    }
+    else if( pSocketContext->pRemoteCandidate == NULL )
+    {
+        LogWarn( ( "The connection of this session is not ready, remote candidate pointer is NULL" ) );
+        ret = ICE_CONTROLLER_RESULT_FAIL_CONNECTION_NOT_READY;
+    }
+    else if( pSocketContext->pCandidatePair == NULL )
+    {
+        LogWarn( ( "The connection of this session is not ready, candidate pair pointer is NULL" ) );
+        ret = ICE_CONTROLLER_RESULT_FAIL_CONNECTION_NOT_READY;
+    }
+    else
+    {
+        *ppSocketContext = pSocketContext;
+        *ppDestEndpoint = &pSocketContext->pRemoteCandidate->endpoint;
+    }
+
+    return ret;
+}
+
+/* Prepend TURN channel data header in front of pBuffer. The caller must guarantee
+ * ICE_CONTROLLER_SEND_HEADROOM_LENGTH bytes are writable right before pBuffer. */
+static IceControllerResult_t PrependTurnChannelHeader( IceControllerContext_t * pCtx,
+                                                       IceControllerSocketContext_t * pSocketContext,
+                                                       uint8_t * pBuffer,
+                                                       size_t bufferLength,
+                                                       const uint8_t ** ppSendingBuffer,
+                                                       size_t * pSendingBufferLength,
+                                                       IceEndpoint_t ** ppDestEndpoint )
+{
+    IceControllerResult_t ret = ICE_CONTROLLER_RESULT_OK;
+    IceResult_t iceResult;
+    size_t turnBufferLength;
+
+    if( bufferLength + ICE_CONTROLLER_SEND_HEADROOM_LENGTH > ICE_CONTROLLER_MAX_MTU )
+    {
+        LogError( ( "The sending buffer is larger than MTU, length: %ld", bufferLength ) );
+        ret = ICE_CONTROLLER_RESULT_FAIL_EXCEED_MTU;
+    }
+    else if( pthread_mutex_lock( &( pCtx->iceMutex ) ) == 0 )
+    {
+        turnBufferLength = bufferLength + ICE_CONTROLLER_SEND_HEADROOM_LENGTH;
+        iceResult = Ice_CreateTurnChannelDataMessage( &pCtx->iceContext,
+                                                      pSocketContext->pCandidatePair,
+                                                      pBuffer,
+                                                      bufferLength,
+                                                      &turnBufferLength );
+        pthread_mutex_unlock( &( pCtx->iceMutex ) );
+
+        if( ( iceResult != ICE_RESULT_OK ) && ( iceResult != ICE_RESULT_TURN_CHANNEL_DATA_HEADER_NOT_REQUIRED ) )
+        {
+            LogError( ( "Fail to create TURN channel data, result: %d", iceResult ) );
+            ret = ICE_CONTROLLER_RESULT_FAIL_CREATE_TURN_CHANNEL_DATA;
+        }
+        else
+        {
+            /* Redirect the output to the TURN server instead of remote endpoint. */
+            *ppDestEndpoint = &( pSocketContext->pIceServer->iceEndpoint );
+
+            if( iceResult == ICE_RESULT_OK )
+            {
+                /* Move sending buffer back to the headroom since TURN channel header has been written there. */
+                *ppSendingBuffer = pBuffer - ICE_CONTROLLER_SEND_HEADROOM_LENGTH;
+                *pSendingBufferLength = turnBufferLength;
+            }
+        }
+    }
+    else
+    {
+        LogError( ( "Failed to create TURN channel data message: mutex lock acquisition." ) );
+        ret = ICE_CONTROLLER_RESULT_FAIL_MUTEX_TAKE;
+    }
+
+    return ret;
+}
+
 IceControllerResult_t IceController_SendToRemotePeer( IceControllerContext_t * pCtx,
                                                       const uint8_t * pBuffer,
                                                       size_t bufferLength )
 {
     IceControllerResult_t ret = ICE_CONTROLLER_RESULT_OK;
-    IceResult_t iceResult;
     const uint8_t * pSendingBuffer = pBuffer;
     size_t sendingBufferLength = bufferLength;
-    size_t turnBufferLength;
     IceEndpoint_t * pDestEndpoint = NULL;
+    IceControllerSocketContext_t * pSocketContext = NULL;
     uint8_t turnSendBuffer[ ICE_CONTROLLER_MAX_MTU ];
 
     if( ( pCtx == NULL ) ||
@@ -1593,81 +1913,35 @@ IceControllerResult_t IceController_SendToRemotePeer( IceControllerContext_t * p
 
     if( ret == ICE_CONTROLLER_RESULT_OK )
     {
-        if( ( pCtx->pNominatedSocketContext == NULL ) ||
-            ( pCtx->pNominatedSocketContext->state < ICE_CONTROLLER_SOCKET_CONTEXT_STATE_SELECTED ) )
-        {
-            LogWarn( ( "The connection of this session is not ready." ) );
-            ret = ICE_CONTROLLER_RESULT_FAIL_CONNECTION_NOT_READY;
-        }
-        else if( pCtx->pNominatedSocketContext->pLocalCandidate == NULL )
-        {
-            LogWarn( ( "The connection of this session is not ready, local candidate pointer is NULL" ) );
-            ret = ICE_CONTROLLER_RESULT_FAIL_CONNECTION_NOT_READY;
-        }
-        else if( pCtx->pNominatedSocketContext->pRemoteCandidate == NULL )
-        {
-            LogWarn( ( "The connection of this session is not ready, remote candidate pointer is NULL" ) );
-            ret = ICE_CONTROLLER_RESULT_FAIL_CONNECTION_NOT_READY;
-        }
-        else if( pCtx->pNominatedSocketContext->pCandidatePair == NULL )
-        {
-            LogWarn( ( "The connection of this session is not ready, candidate pair pointer is NULL" ) );
-            ret = ICE_CONTROLLER_RESULT_FAIL_CONNECTION_NOT_READY;
-        }
-        else
-        {
-            pDestEndpoint = &pCtx->pNominatedSocketContext->pRemoteCandidate->endpoint;
-        }
+        ret = GetNominatedDestination( pCtx,
+                                       &pSocketContext,
+                                       &pDestEndpoint );
     }
 
     if( ret == ICE_CONTROLLER_RESULT_OK )
     {
-        if( pCtx->pNominatedSocketContext->pLocalCandidate->candidateType == ICE_CANDIDATE_TYPE_RELAY )
+        if( pSocketContext->pLocalCandidate->candidateType == ICE_CANDIDATE_TYPE_RELAY )
         {
-            if( bufferLength + ICE_TURN_CHANNEL_DATA_MESSAGE_HEADER_LENGTH > ICE_CONTROLLER_MAX_MTU )
+            if( bufferLength + ICE_CONTROLLER_SEND_HEADROOM_LENGTH > ICE_CONTROLLER_MAX_MTU )
             {
                 LogError( ( "The sending buffer is larger than MTU, length: %ld", sendingBufferLength ) );
                 ret = ICE_CONTROLLER_RESULT_FAIL_EXCEED_MTU;
             }
             else
             {
-                memcpy( turnSendBuffer + ICE_TURN_CHANNEL_DATA_MESSAGE_HEADER_LENGTH,
+                /* The caller buffer has no headroom, copy it behind a local one. Use
+                 * IceController_SendToRemotePeerWithHeadroom() on hot paths to avoid this copy. */
+                memcpy( turnSendBuffer + ICE_CONTROLLER_SEND_HEADROOM_LENGTH,
                         pBuffer,
                         bufferLength );
 
-                if( pthread_mutex_lock( &( pCtx->iceMutex ) ) == 0 )
-                {
-                    turnBufferLength = ICE_CONTROLLER_MAX_MTU;
-                    iceResult = Ice_CreateTurnChannelDataMessage( &pCtx->iceContext,
-                                                                  pCtx->pNominatedSocketContext->pCandidatePair,
-                                                                  turnSendBuffer + ICE_TURN_CHANNEL_DATA_MESSAGE_HEADER_LENGTH,
-                                                                  bufferLength,
-                                                                  &turnBufferLength );
-                    pthread_mutex_unlock( &( pCtx->iceMutex ) );
-
-                    if( ( iceResult != ICE_RESULT_OK ) && ( iceResult != ICE_RESULT_TURN_CHANNEL_DATA_HEADER_NOT_REQUIRED ) )
-                    {
-                        LogError( ( "Fail to create TURN channel data, result: %d", iceResult ) );
-                        ret = ICE_CONTROLLER_RESULT_FAIL_CREATE_TURN_CHANNEL_DATA;
-                    }
-                    else
-                    {
-                        /* Redirect the output to the TURN server instead of remote endpoint. */
-                        pDestEndpoint = &( pCtx->pNominatedSocketContext->pIceServer->iceEndpoint );
-
-                        if( iceResult == ICE_RESULT_OK )
-                        {
-                            /* Set sending buffer/length to turn buffer since TURN channel header has been appended successfully. */
-                            pSendingBuffer = turnSendBuffer;
-                            sendingBufferLength = turnBufferLength;
-                        }
-                    }
-                }
-                else
-                {
-                    LogError( ( "Failed to create TURN channel data message: mutex lock acquisition." ) );
-                    ret = ICE_CONTROLLER_RESULT_FAIL_MUTEX_TAKE;
-                }
+                ret = PrependTurnChannelHeader( pCtx,
+                                                pSocketContext,
+                                                turnSendBuffer + ICE_CONTROLLER_SEND_HEADROOM_LENGTH,
+                                                bufferLength,
+                                                &pSendingBuffer,
+                                                &sendingBufferLength,
+                                                &pDestEndpoint );
             }
         }
     }
@@ -1675,7 +1949,58 @@ IceControllerResult_t IceController_SendToRemotePeer( IceControllerContext_t * p
     if( ret == ICE_CONTROLLER_RESULT_OK )
     {
         ret = IceControllerNet_SendPacket( pCtx,
-                                           pCtx->pNominatedSocketContext,
+                                           pSocketContext,
+                                           pDestEndpoint,
+                                           pSendingBuffer,
+                                           sendingBufferLength );
+    }
+
+    return ret;
+}
+
+IceControllerResult_t IceController_SendToRemotePeerWithHeadroom( IceControllerContext_t * pCtx,
+                                                                  uint8_t * pBuffer,
+                                                                  size_t bufferLength )
+{
+    IceControllerResult_t ret = ICE_CONTROLLER_RESULT_OK;
+    const uint8_t * pSendingBuffer = pBuffer;
+    size_t sendingBufferLength = bufferLength;
+    IceEndpoint_t * pDestEndpoint = NULL;
+    IceControllerSocketContext_t * pSocketContext = NULL;
+
+    if( ( pCtx == NULL ) ||
+        ( pBuffer == NULL ) )
+    {
+        LogError( ( "Invalid input, pCtx: %p, pBuffer: %p", pCtx, pBuffer ) );
+        ret = ICE_CONTROLLER_RESULT_BAD_PARAMETER;
+    }
+
+    if( ret == ICE_CONTROLLER_RESULT_OK )
+    {
+        ret = GetNominatedDestination( pCtx,
+                                       &pSocketContext,
+                                       &pDestEndpoint );
+    }
+
+    if( ret == ICE_CONTROLLER_RESULT_OK )
+    {
+        if( pSocketContext->pLocalCandidate->candidateType == ICE_CANDIDATE_TYPE_RELAY )
+        {
+            /* Write the TURN channel data header into the reserved headroom, no copy of payload needed. */
+            ret = PrependTurnChannelHeader( pCtx,
+                                            pSocketContext,
+                                            pBuffer,
+                                            bufferLength,
+                                            &pSendingBuffer,
+                                            &sendingBufferLength,
+                                            &pDestEndpoint );
+        }
+    }
+
+    if( ret == ICE_CONTROLLER_RESULT_OK )
+    {
+        ret = IceControllerNet_SendPacket( pCtx,
+                                           pSocketContext,
                                            pDestEndpoint,
                                            pSendingBuffer,
                                            sendingBufferLength );
@@ -1753,7 +2078,8 @@ IceControllerResult_t IceController_AddIceServerConfig( IceControllerContext_t *
 }
 
 void IceController_CloseOtherCandidatePairs( IceControllerContext_t * pCtx,
-                                             IceCandidatePair_t * pCandidatePair )
+                                             IceCandidatePair_t * pCandidatePair,
+                                             IceCandidatePair_t * pBackupCandidatePair )
 {
     uint8_t skipProcess = 0;
     uint8_t isLocked = 0U;
@@ -1795,7 +2121,8 @@ void IceController_CloseOtherCandidatePairs( IceControllerContext_t * pCtx,
     {
         for( i = 0; i < count; i++ )
         {
-            if( &pCtx->iceContext.pCandidatePairs[i] != pCandidatePair )
+            if( ( &pCtx->iceContext.pCandidatePairs[i] != pCandidatePair ) &&
+                ( &pCtx->iceContext.pCandidatePairs[i] != pBackupCandidatePair ) )
             {
                 iceResult = Ice_CloseCandidatePair( &pCtx->iceContext,
                                                     &pCtx->iceContext.pCandidatePairs[i] );
@@ -1814,6 +2141,97 @@ void IceController_CloseOtherCandidatePairs( IceControllerContext_t * pCtx,
     }
 }
 
+IceControllerResult_t IceController_MigrateToBackupPath( IceControllerContext_t * pCtx )
+{
+    IceControllerResult_t ret = ICE_CONTROLLER_RESULT_OK;
+    IceControllerSocketContext_t * pPreviousSocketContext = NULL;
+    uint32_t localCandidateId = 0U;
+    uint32_t remoteCandidateId = 0U;
+
+    if( pCtx == NULL )
+    {
+        LogError( ( "Invalid input, pCtx: %p", pCtx ) );
+        ret = ICE_CONTROLLER_RESULT_BAD_PARAMETER;
+    }
+
+    if( ret == ICE_CONTROLLER_RESULT_OK )
+    {
+        /* Tx, Rx and the periodic connection check update the nominated and backup
+         * contexts too, check and promote the backup in a single critical section. */
+        if( pthread_mutex_lock( &( pCtx->socketMutex ) ) == 0 )
+        {
+            if( ( pCtx->pBackupSocketContext == NULL ) ||
+                ( pCtx->pBackupSocketContext->state == ICE_CONTROLLER_SOCKET_CONTEXT_STATE_NONE ) )
+            {
+                LogInfo( ( "No backup path available for migration." ) );
+                ret = ICE_CONTROLLER_RESULT_FAIL_FIND_NOMINATED_CONTEXT;
+            }
+            else
+            {
+                pPreviousSocketContext = pCtx->pNominatedSocketContext;
+                pCtx->pNominatedSocketContext = pCtx->pBackupSocketContext;
+                pCtx->pNominatedSocketContext->state = ICE_CONTROLLER_SOCKET_CONTEXT_STATE_SELECTED;
+                pCtx->pBackupSocketContext = NULL;
+
+                if( pCtx->pNominatedSocketContext->pCandidatePair != NULL )
+                {
+                    localCandidateId = pCtx->pNominatedSocketContext->pCandidatePair->pLocalCandidate->candidateId;
+                    remoteCandidateId = pCtx->pNominatedSocketContext->pCandidatePair->pRemoteCandidate->candidateId;
+                }
+            }
+
+            pthread_mutex_unlock( &( pCtx->socketMutex ) );
+        }
+        else
+        {
+            LogError( ( "Failed to migrate path: mutex lock acquisition." ) );
+            ret = ICE_CONTROLLER_RESULT_FAIL_MUTEX_TAKE;
+        }
+    }
+
+    if( ret == ICE_CONTROLLER_RESULT_OK )
+    {
+        LogInfo( ( "Migrated to backup pair, local/remote candidate ID: 0x%04x / 0x%04x",
+                   localCandidateId,
+                   remoteCandidateId ) );
+
+        /* Release the failed path if it's still open. */
+        if( ( pPreviousSocketContext != NULL ) &&
+            ( pPreviousSocketContext->state != ICE_CONTROLLER_SOCKET_CONTEXT_STATE_NONE ) )
+        {
+            if( ( pPreviousSocketContext->pLocalCandidate != NULL ) &&
+                ( pPreviousSocketContext->pLocalCandidate->candidateType == ICE_CANDIDATE_TYPE_RELAY ) )
+            {
+                if( pthread_mutex_lock( &( pCtx->iceMutex ) ) == 0 )
+                {
+                    /* Keep the socket alive until TURN resource is terminated. */
+                    Ice_CloseCandidate( &pCtx->iceContext,
+                                        pPreviousSocketContext->pLocalCandidate );
+                    pthread_mutex_unlock( &( pCtx->iceMutex ) );
+                }
+                else
+                {
+                    LogError( ( "Failed to close ICE candidate: mutex lock acquisition." ) );
+                }
+            }
+            else
+            {
+                IceControllerNet_FreeSocketContext( pCtx,
+                                                    pPreviousSocketContext );
+            }
+        }
+
+        if( pCtx->onIceEventCallbackFunc )
+        {
+            ( void ) pCtx->onIceEventCallbackFunc( pCtx->pOnIceEventCustomContext,
+                                                   ICE_CONTROLLER_CB_EVENT_PATH_MIGRATED,
+                                                   NULL );
+        }
+    }
+
+    return ret;
+}
+
 void IceController_UpdateState( IceControllerContext_t * pCtx,
                                 IceControllerState_t newState )
 {
@@ -46,12 +46,28 @@ IceControllerResult_t IceController_Start( IceControllerContext_t * pCtx,
                                            size_t remotePasswordLength,
                                            const char * pCombinedName,
                                            size_t combinedNameLength );
+/* Same as IceController_Start with the new credentials, but a non-relay nominated path keeps carrying
+ * media until the restarted check list nominates a new pair, then ICE_CONTROLLER_EVENT_ICE_RESTART_DONE releases it. */
+IceControllerResult_t IceController_Restart( IceControllerContext_t * pCtx,
+                                             const char * pLocalUserName,
+                                             size_t localUserNameLength,
+                                             const char * pLocalPassword,
+                                             size_t localPasswordLength,
+                                             const char * pRemoteUserName,
+                                             size_t remoteUserNameLength,
+                                             const char * pRemotePassword,
+                                             size_t remotePasswordLength,
+                                             const char * pCombinedName,
+                                             size_t combinedNameLength );
 IceControllerResult_t IceController_AddRemoteCandidate( IceControllerContext_t * pCtx,
                                                         IceRemoteCandidateInfo_t * pRemoteCandidate );
 IceControllerResult_t IceController_ProcessIceCandidatesAndPairs( IceControllerContext_t * pCtx );
 IceControllerResult_t IceController_SendToRemotePeer( IceControllerContext_t * pCtx,
                                                       const uint8_t * pBuffer,
                                                       size_t bufferLength );
+IceControllerResult_t IceController_SendToRemotePeerWithHeadroom( IceControllerContext_t * pCtx,
+                                                                  uint8_t * pBuffer,
+                                                                  size_t bufferLength );
 IceControllerResult_t IceController_AddIceServerConfig( IceControllerContext_t * pCtx,
                                                         IceControllerIceServerConfig_t * pIceServersConfig );
 IceControllerResult_t IceController_PeriodConnectionCheck( IceControllerContext_t * pCtx );
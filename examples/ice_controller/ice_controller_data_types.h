@@ -82,6 +82,10 @@ extern "C" {
 
 #define ICE_CONTROLLER_MAX_MTU ( 1500 )
 
+/* Bytes that must be writable in front of a buffer passed to IceController_SendToRemotePeerWithHeadroom(),
+ * so the TURN channel data header can be prepended in place for relay connections. */
+#define ICE_CONTROLLER_SEND_HEADROOM_LENGTH ( ICE_TURN_CHANNEL_DATA_MESSAGE_HEADER_LENGTH )
+
 typedef enum IceControllerSocketType
 {
     ICE_CONTROLLER_SOCKET_TYPE_NONE = 0,
@@ -101,6 +105,7 @@ typedef enum IceControllerCallbackEvent
     ICE_CONTROLLER_CB_EVENT_ICE_CLOSING,
     ICE_CONTROLLER_CB_EVENT_ICE_CLOSED,
     ICE_CONTROLLER_CB_EVENT_ICE_CLOSE_NOTIFY,
+    ICE_CONTROLLER_CB_EVENT_PATH_MIGRATED,
     ICE_CONTROLLER_CB_EVENT_MAX,
 } IceControllerCallbackEvent_t;
 
@@ -118,6 +123,7 @@ typedef struct IceControllerCallbackContent
         /* NULL for ICE_CONTROLLER_CB_EVENT_PROCESS_ICE_CANDIDATES_AND_PAIRS */
         /* NULL for ICE_CONTROLLER_CB_EVENT_PEER_TO_PEER_CONNECTION_FOUND */
         /* NULL for ICE_CONTROLLER_CB_EVENT_PERIODIC_CONNECTION_CHECK */
+        /* NULL for ICE_CONTROLLER_CB_EVENT_PATH_MIGRATED */
     } iceControllerCallbackContent;
 } IceControllerCallbackContent_t;
 
@@ -192,6 +198,7 @@ typedef enum IceControllerEvent
 {
     ICE_CONTROLLER_EVENT_NONE = 0,
     ICE_CONTROLLER_EVENT_DTLS_HANDSHAKE_DONE,
+    ICE_CONTROLLER_EVENT_ICE_RESTART_DONE,
 } IceControllerEvent_t;
 
 /* https://developer.mozilla.org/en-US/docs/Web/API/RTCIceCandidate/candidate
@@ -352,6 +359,14 @@ typedef struct IceControllerContext
     IceControllerSocketContext_t socketsContexts[ ICE_CONTROLLER_MAX_LOCAL_CANDIDATE_COUNT ];
     size_t socketsContextsCount;
     IceControllerSocketContext_t * pNominatedSocketContext;
+    /* A succeeded pair kept alive with consent checks, so media can migrate to it when the nominated path fails. */
+    IceControllerSocketContext_t * pBackupSocketContext;
+    /* The nominated path before an ICE restart, media keeps using it until the restarted check list
+     * nominates a new pair. Its candidates and pair are copied out of the ICE context, which the restart re-initializes. */
+    IceControllerSocketContext_t * pRestartSocketContext;
+    IceCandidate_t restartLocalCandidate;
+    IceCandidate_t restartRemoteCandidate;
+    IceCandidatePair_t restartCandidatePair;
 
     /* For ICE component. */
     IceEndpoint_t localEndpoints[ ICE_CONTROLLER_MAX_LOCAL_CANDIDATE_COUNT ];
@@ -510,27 +510,48 @@ static IceControllerResult_t SendSocketPacket( IceControllerSocketContext_t * pS
     return ret;
 }
 
-void IceControllerNet_FreeSocketContext( IceControllerContext_t * pCtx,
-                                         IceControllerSocketContext_t * pSocketContext )
+void IceControllerNet_FreeSocketContextLocked( IceControllerContext_t * pCtx,
+                                               IceControllerSocketContext_t * pSocketContext )
 {
     TlsTransportStatus_t retTlsTransport;
 
+    /* Caller must hold socketMutex. */
     if( pSocketContext && ( pSocketContext->socketFd != -1 ) )
     {
-        if( pthread_mutex_lock( &( pCtx->socketMutex ) ) == 0 )
+        if( pSocketContext->socketType == ICE_CONTROLLER_SOCKET_TYPE_TLS )
         {
-            if( pSocketContext->socketType == ICE_CONTROLLER_SOCKET_TYPE_TLS )
+            retTlsTransport = TLS_FreeRTOS_Disconnect( &pSocketContext->tlsSession.xTlsNetworkContext );
+            if( retTlsTransport != TLS_TRANSPORT_SUCCESS )
             {
-                retTlsTransport = TLS_FreeRTOS_Disconnect( &pSocketContext->tlsSession.xTlsNetworkContext );
-                if( retTlsTransport != TLS_TRANSPORT_SUCCESS )
-                {
-                    LogWarn( ( "Fail to disconnect TLS session with return %d", retTlsTransport ) );
-                }
+                LogWarn( ( "Fail to disconnect TLS session with return %d", retTlsTransport ) );
             }
+        }
 
-            close( pSocketContext->socketFd );
-            pSocketContext->socketFd = -1;
-            pSocketContext->state = ICE_CONTROLLER_SOCKET_CONTEXT_STATE_NONE;
+        close( pSocketContext->socketFd );
+        pSocketContext->socketFd = -1;
+        pSocketContext->state = ICE_CONTROLLER_SOCKET_CONTEXT_STATE_NONE;
+
+        if( pSocketContext == pCtx->pBackupSocketContext )
+        {
+            pCtx->pBackupSocketContext = NULL;
+        }
+
+        if( pSocketContext == pCtx->pRestartSocketContext )
+        {
+            pCtx->pRestartSocketContext = NULL;
+        }
+    }
+}
+
+void IceControllerNet_FreeSocketContext( IceControllerContext_t * pCtx,
+                                         IceControllerSocketContext_t * pSocketContext )
+{
+    if( pSocketContext && ( pSocketContext->socketFd != -1 ) )
+    {
+        if( pthread_mutex_lock( &( pCtx->socketMutex ) ) == 0 )
+        {
+            IceControllerNet_FreeSocketContextLocked( pCtx,
+                                                      pSocketContext );
 
             pthread_mutex_unlock( &( pCtx->socketMutex ) );
         }
@@ -945,6 +966,55 @@ static IceControllerResult_t CheckNomination( IceControllerContext_t * pCtx,
     return ret;
 }
 
+/* The remote controlling agent picked a different succeeded pair with USE-CANDIDATE after we nominated,
+ * follow it. This is the only way an established nomination moves, media on other paths never moves it. */
+static void UpdateNomination( IceControllerContext_t * pCtx,
+                              IceControllerSocketContext_t * pSocketContext,
+                              IceCandidatePair_t * pCandidatePair )
+{
+    IceCandidatePair_t * pOriginalCandidatePair = NULL;
+
+    if( ( pCandidatePair != NULL ) &&
+        ( pCandidatePair->state == ICE_CANDIDATE_PAIR_STATE_SUCCEEDED ) )
+    {
+        if( pthread_mutex_lock( &( pCtx->socketMutex ) ) == 0 )
+        {
+            if( ( pCtx->pNominatedSocketContext != NULL ) &&
+                ( pCtx->pNominatedSocketContext->state == ICE_CONTROLLER_SOCKET_CONTEXT_STATE_SELECTED ) &&
+                ( pCtx->pNominatedSocketContext->pCandidatePair != pCandidatePair ) )
+            {
+                pOriginalCandidatePair = pCtx->pNominatedSocketContext->pCandidatePair;
+
+                if( pSocketContext == pCtx->pBackupSocketContext )
+                {
+                    pCtx->pBackupSocketContext = NULL;
+                }
+
+                pCtx->pNominatedSocketContext = pSocketContext;
+                pCtx->pNominatedSocketContext->pRemoteCandidate = pCandidatePair->pRemoteCandidate;
+                pCtx->pNominatedSocketContext->pCandidatePair = pCandidatePair;
+                pCtx->pNominatedSocketContext->state = ICE_CONTROLLER_SOCKET_CONTEXT_STATE_SELECTED;
+            }
+
+            /* We have finished accessing the shared resource.  Release the mutex. */
+            pthread_mutex_unlock( &( pCtx->socketMutex ) );
+        }
+        else
+        {
+            LogError( ( "Failed to update nomination: mutex lock acquisition." ) );
+        }
+    }
+
+    if( pOriginalCandidatePair != NULL )
+    {
+        LogInfo( ( "Remote nominated local/remote candidate ID: 0x%04x / 0x%04x, replacing local/remote candidate ID: 0x%04x / 0x%04x",
+                   pCandidatePair->pLocalCandidate->candidateId,
+                   pCandidatePair->pRemoteCandidate->candidateId,
+                   pOriginalCandidatePair->pLocalCandidate->candidateId,
+                   pOriginalCandidatePair->pRemoteCandidate->candidateId ) );
+    }
+}
+
 IceControllerResult_t IceControllerNet_ConvertIpString( const char * pIpAddr,
                                                         size_t ipAddrLength,
                                                         IceEndpoint_t * pDestinationIceEndpoint )
@@ -1095,10 +1165,22 @@ IceControllerResult_t IceControllerNet_SendPacket( IceControllerContext_t * pCtx
          * This typically indicates the remote peer closed the connection or WiFi disconnection.
          * Action required: Close the local socket to properly terminate the connection.
          */
-        ( void ) Ice_CloseCandidate( &pCtx->iceContext, pSocketContext->pLocalCandidate );
+        if( pSocketContext != pCtx->pRestartSocketContext )
+        {
+            /* The path held over an ICE restart has no candidate in the current ICE context. */
+            ( void ) Ice_CloseCandidate( &pCtx->iceContext, pSocketContext->pLocalCandidate );
+        }
         IceControllerNet_FreeSocketContext( pCtx, pSocketContext );
 
-        if( pSocketContext == pCtx->pNominatedSocketContext )
+        if( ( pSocketContext == pCtx->pNominatedSocketContext ) &&
+            ( IceController_MigrateToBackupPath( pCtx ) == ICE_CONTROLLER_RESULT_OK ) )
+        {
+            /* Media path has been moved to the backup pair, keep the session. */
+            LogWarn( ( "Unable to send packet through nominated socket, migrated to backup path for session: %.*s",
+                       ( int ) pCtx->iceContext.creds.combinedUsernameLength,
+                       pCtx->iceContext.creds.pCombinedUsername ) );
+        }
+        else if( pSocketContext == pCtx->pNominatedSocketContext )
         {
             /* Disconnecting nominated socket connection, closing. */
             LogWarn( ( "Unable to send packet through nominated socket, closing session: %.*s",
@@ -1405,8 +1487,25 @@ IceControllerResult_t IceControllerNet_HandleStunPacket( IceControllerContext_t
                     LogError( ( "Unable to send relay candidate ready message." ) );
                 }
                 break;
-            case ICE_HANDLE_STUN_PACKET_RESULT_SEND_TRIGGERED_CHECK:
             case ICE_HANDLE_STUN_PACKET_RESULT_SEND_RESPONSE_FOR_NOMINATION:
+                ret = SendBindingResponse( pCtx, pSocketContext, pCandidatePair, pTransactionIdBuffer );
+
+                if( ret == ICE_CONTROLLER_RESULT_OK )
+                {
+                    ret = CheckNomination( pCtx,
+                                           pSocketContext,
+                                           pCandidatePair );
+                }
+
+                if( ret == ICE_CONTROLLER_RESULT_OK )
+                {
+                    /* Explicit USE-CANDIDATE from the controlling agent. */
+                    UpdateNomination( pCtx,
+                                      pSocketContext,
+                                      pCandidatePair );
+                }
+                break;
+            case ICE_HANDLE_STUN_PACKET_RESULT_SEND_TRIGGERED_CHECK:
             case ICE_HANDLE_STUN_PACKET_RESULT_SEND_RESPONSE_FOR_REMOTE_REQUEST:
                 ret = SendBindingResponse( pCtx, pSocketContext, pCandidatePair, pTransactionIdBuffer );
 
@@ -34,7 +34,9 @@ void IceController_UpdateState( IceControllerContext_t * pCtx,
 void IceController_UpdateTimerInterval( IceControllerContext_t * pCtx,
                                         uint32_t newIntervalMs );
 void IceController_CloseOtherCandidatePairs( IceControllerContext_t * pCtx,
-                                             IceCandidatePair_t * pCandidatePair );
+                                             IceCandidatePair_t * pCandidatePair,
+                                             IceCandidatePair_t * pBackupCandidatePair );
+IceControllerResult_t IceController_MigrateToBackupPath( IceControllerContext_t * pCtx );
 IceControllerResult_t IceControllerNet_ConvertIpString( const char * pIpAddr,
                                                         size_t ipAddrLength,
                                                         IceEndpoint_t * pDestinationIceEndpoint );
@@ -56,6 +58,8 @@ IceControllerResult_t IceControllerNet_SendPacket( IceControllerContext_t * pCtx
                                                    size_t bufferLength );
 void IceControllerNet_FreeSocketContext( IceControllerContext_t * pCtx,
                                          IceControllerSocketContext_t * pSocketContext );
+void IceControllerNet_FreeSocketContextLocked( IceControllerContext_t * pCtx,
+                                               IceControllerSocketContext_t * pSocketContext );
 void IceControllerNet_UpdateSocketContext( IceControllerContext_t * pCtx,
                                            IceControllerSocketContext_t * pSocketContext,
                                            IceControllerSocketContextState_t newState,
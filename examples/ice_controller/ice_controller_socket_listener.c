@@ -110,144 +110,6 @@ static int32_t RecvPacketTls( IceControllerSocketContext_t * pSocketContext,
     return ret;
 }
 
-static IceCandidatePair_t * FindCandidatePairByRemoteIceEndpoint( IceControllerContext_t * pCtx,
-                                                                  IceControllerSocketContext_t * pSocketContext,
-                                                                  IceEndpoint_t * pRemoteIceEndpoint )
-{
-    IceControllerResult_t result = ICE_CONTROLLER_RESULT_OK;
-    IceCandidatePair_t * pCandidatePair = NULL;
-    IceResult_t iceResult;
-    size_t count;
-    size_t i;
-    uint8_t isLocked = 0U;
-
-    /* Take ice lock. */
-    if( pthread_mutex_lock( &( pCtx->iceMutex ) ) == 0 )
-    {
-        isLocked = 1U;
-    }
-    else
-    {
-        LogError( ( "Failed to process candidate pairs: mutex lock acquisition." ) );
-        result = ICE_CONTROLLER_RESULT_FAIL_MUTEX_TAKE;
-    }
-
-    if( result == ICE_CONTROLLER_RESULT_OK )
-    {
-        iceResult = Ice_GetCandidatePairCount( &pCtx->iceContext,
-                                               &count );
-        if( iceResult != ICE_RESULT_OK )
-        {
-            LogError( ( "Fail to query valid candidate pair count, result: %d", iceResult ) );
-            result = ICE_CONTROLLER_RESULT_FAIL_QUERY_CANDIDATE_PAIR_COUNT;
-        }
-    }
-
-    if( result == ICE_CONTROLLER_RESULT_OK )
-    {
-        for( i = 0; i < count; i++ )
-        {
-            if( ( memcmp( &pCtx->iceContext.pCandidatePairs[i].pLocalCandidate->endpoint.transportAddress,
-                          &pSocketContext->pLocalCandidate->endpoint.transportAddress,
-                          sizeof( IceTransportAddress_t ) ) == 0 ) &&
-                ( memcmp( &pCtx->iceContext.pCandidatePairs[i].pRemoteCandidate->endpoint.transportAddress,
-                          &pRemoteIceEndpoint->transportAddress,
-                          sizeof( IceTransportAddress_t ) ) == 0 ) )
-            {
-                pCandidatePair = &pCtx->iceContext.pCandidatePairs[i];
-                break;
-            }
-        }
-    }
-
-    if( isLocked != 0U )
-    {
-        pthread_mutex_unlock( &( pCtx->iceMutex ) );
-    }
-
-    return pCandidatePair;
-}
-
-static IceControllerResult_t UpdateNominatedSocketContext( IceControllerContext_t * pCtx,
-                                                           IceControllerSocketContext_t * pSocketContext,
-                                                           IceCandidatePair_t * pCandidatePair,
-                                                           IceEndpoint_t * pRemoteIceEndpoint )
-{
-    IceControllerResult_t ret = ICE_CONTROLLER_RESULT_OK;
-    IceCandidatePair_t * pOriginalCandidatePair = NULL;
-    #if LIBRARY_LOG_LEVEL >= LOG_INFO
-        char ipBuffer[ INET_ADDRSTRLEN ];
-    #endif
-
-    /* Find valid candidate pair pointer for current packet.
-     * There are two scenarios:
-     *   1. Host/Server Reflexive Candidates: The candidate pair pointer is NULL because we haven't mapped the remote endpoint.
-     *   2. Peer/Client Reflexive Candidates: The candidate pair must be valid because we should extract it from Ice_HandleTurnPacket.
-     */
-    if( ( pSocketContext->pLocalCandidate->candidateType == ICE_CANDIDATE_TYPE_HOST ) ||
-        ( pSocketContext->pLocalCandidate->candidateType == ICE_CANDIDATE_TYPE_SERVER_REFLEXIVE ) )
-    {
-        if( pCandidatePair == NULL )
-        {
-            pCandidatePair = FindCandidatePairByRemoteIceEndpoint( pCtx, pSocketContext, pRemoteIceEndpoint );
-            if( pCandidatePair == NULL )
-            {
-                LogWarn( ( "Invalid to find candidate pair for the remote endpoint." ) );
-
-                LogInfo( ( "Target remote endpoint IP address: %s, port: %u",
-                           IceControllerNet_LogIpAddressInfo( pRemoteIceEndpoint, ipBuffer, sizeof( ipBuffer ) ),
-                           pRemoteIceEndpoint->transportAddress.port ) );
-                ret = ICE_CONTROLLER_RESULT_INVALID_PACKET;
-            }
-        }
-        else
-        {
-            LogWarn( ( "ICE Candidate Pair Error: Host/Srflx candidate contains valid pair pointer when it should be NULL." ) );
-            ret = ICE_CONTROLLER_RESULT_BAD_PARAMETER;
-        }
-    }
-    else
-    {
-        /* Relay candidate. */
-        if( pCandidatePair == NULL )
-        {
-            LogWarn( ( "ICE Candidate Pair Error: Relay candidate contains NULL pair pointer when it should be valid." ) );
-            ret = ICE_CONTROLLER_RESULT_BAD_PARAMETER;
-        }
-    }
-
-    if( ret == ICE_CONTROLLER_RESULT_OK )
-    {
-        /* Update nominated socket context. */
-        if( pthread_mutex_lock( &( pCtx->socketMutex ) ) == 0 )
-        {
-            pOriginalCandidatePair = pCtx->pNominatedSocketContext->pCandidatePair;
-            pCtx->pNominatedSocketContext = pSocketContext;
-            pCtx->pNominatedSocketContext->pRemoteCandidate = pCandidatePair->pRemoteCandidate;
-            pCtx->pNominatedSocketContext->pCandidatePair = pCandidatePair;
-            pCtx->pNominatedSocketContext->state = ICE_CONTROLLER_SOCKET_CONTEXT_STATE_SELECTED;
-
-            ( void ) pOriginalCandidatePair;
-
-            /* We have finished accessing the shared resource.  Release the mutex. */
-            pthread_mutex_unlock( &( pCtx->socketMutex ) );
-
-            LogInfo( ( "Nominated pair is changed from local/remote candidate ID: 0x%04x / 0x%04x to local/remote candidate ID: 0x%04x / 0x%04x",
-                       pOriginalCandidatePair->pLocalCandidate->candidateId,
-                       pOriginalCandidatePair->pRemoteCandidate->candidateId,
-                       pCandidatePair->pLocalCandidate->candidateId,
-                       pCandidatePair->pRemoteCandidate->candidateId ) );
-        }
-        else
-        {
-            LogError( ( "Failed to update nominated socket context: mutex lock acquisition." ) );
-            ret = ICE_CONTROLLER_RESULT_FAIL_MUTEX_TAKE;
-        }
-    }
-
-    return ret;
-}
-
 static void HandleRxPacket( IceControllerContext_t * pCtx,
                             IceControllerSocketContext_t * pSocketContext,
                             OnRecvNonStunPacketCallback_t onRecvNonStunPacketFunc,
@@ -363,15 +225,16 @@ static void HandleRxPacket( IceControllerContext_t * pCtx,
             if( ( ( pProcessingBuffer[ 0 ] > 127 ) && ( pProcessingBuffer[ 0 ] < 192 ) ) ||
                 ( ( pProcessingBuffer[ 0 ] > 19 ) && ( pProcessingBuffer[ 0 ] < 64 ) ) )
             {
-                /* It's not STUN packet, deliever to peer connection to handle RTP or DTLS packet. */
-                /* When ICE controlling agent sends all binding requests with USE-CANDIDATE flag in connectivity stage,
-                 * it's possible to pick different agent between local and remote peer. Thus we update nominated pair pointer
-                 * to handle current packet. */
+                /* It's not STUN packet, deliever to peer connection to handle RTP or DTLS packet.
+                 * Only connectivity checks move the nomination, media on the backup path or on the path
+                 * held over ICE restart is delivered without changing it. */
                 if( onRecvNonStunPacketFunc )
                 {
-                    if( pCtx->pNominatedSocketContext != pSocketContext )
+                    if( ( pSocketContext != pCtx->pNominatedSocketContext ) &&
+                        ( pSocketContext != pCtx->pBackupSocketContext ) &&
+                        ( ( pCtx->pNominatedSocketContext != NULL ) || ( pCtx->pRestartSocketContext == NULL ) ) )
                     {
-                        ret = UpdateNominatedSocketContext( pCtx, pSocketContext, pCandidatePair, &remoteIceEndpoint );
+                        ret = ICE_CONTROLLER_RESULT_INVALID_PACKET;
                     }
 
                     if( ret == ICE_CONTROLLER_RESULT_OK )
@@ -390,6 +253,12 @@ static void HandleRxPacket( IceControllerContext_t * pCtx,
                     LogError( ( "No callback function to handle DTLS/RTP/RTCP packets." ) );
                 }
             }
+            else if( ( pProcessingBuffer[ 0 ] < 2 ) &&
+                     ( pSocketContext == pCtx->pRestartSocketContext ) )
+            {
+                /* Connectivity checks of the previous ICE generation, the restarted ICE context doesn't know this path. */
+                LogVerbose( ( "Drop STUN packet on the path held over ICE restart, length: %lu", processingBufferLength ) );
+            }
             else if( pProcessingBuffer[ 0 ] < 2 )
             {
                 /* STUN packet. */
@@ -454,8 +323,18 @@ static void HandleRxPacket( IceControllerContext_t * pCtx,
          * This typically indicates the remote peer closed the connection.
          * Action required: Close the local socket to properly terminate the connection.
          */
-        ( void ) Ice_CloseCandidate( &pCtx->iceContext, pSocketContext->pLocalCandidate );
+        if( pSocketContext != pCtx->pRestartSocketContext )
+        {
+            /* The path held over an ICE restart has no candidate in the current ICE context. */
+            ( void ) Ice_CloseCandidate( &pCtx->iceContext, pSocketContext->pLocalCandidate );
+        }
         IceControllerNet_FreeSocketContext( pCtx, pSocketContext );
+
+        if( pSocketContext == pCtx->pNominatedSocketContext )
+        {
+            /* Nominated path is broken, move media to backup path if there is one. */
+            ( void ) IceController_MigrateToBackupPath( pCtx );
+        }
     }
 }
 
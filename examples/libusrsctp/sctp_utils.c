@@ -18,7 +18,9 @@
 
 /* Standard includes. */
 #include <stdio.h>
+#include <stdlib.h>
 #include <unistd.h>
+#include <errno.h>
 
 /* Application includes. */
 #include "peer_connection.h"
@@ -65,6 +67,32 @@ static int OnSctpInboundPacket( struct socket * pSocket,
 
 static SctpUtilsResult_t SendOpenDataChannelAck( SctpSession_t * pSctpSession,
                                                  uint16_t channelId );
+
+static int OnSctpSendBufferAvailable( struct socket * pSocket,
+                                      uint32_t freeSize,
+                                      void * pUlpInfo );
+
+static uint8_t ReassembleMessage( SctpSession_t * pSctpSession,
+                                  const uint8_t * pData,
+                                  size_t length,
+                                  int flags );
+
+static int32_t SendToSctpStack( SctpSession_t * pSctpSession,
+                                struct sctp_sendv_spa * pSpa,
+                                uint8_t * pMessage,
+                                uint32_t messageLen );
+
+static SctpUtilsResult_t QueueMessage( SctpSession_t * pSctpSession,
+                                       SctpDataChannel_t * pDataChannel,
+                                       const struct sctp_sendv_spa * pSpa,
+                                       const uint8_t * pMessage,
+                                       uint32_t messageLen,
+                                       uint8_t isFirst );
+
+static void DrainSendQueue( SctpSession_t * pSctpSession );
+
+static void FreeSendQueue( SctpSession_t * pSctpSession,
+                           const SctpDataChannel_t * pDataChannel );
 /*-----------------------------------------------------------*/
 
 /* Configure the SCTP socket with default settings. */
@@ -76,6 +104,7 @@ static SctpUtilsResult_t ConfigureSctpSocket( struct socket * pSocket )
     struct sctp_initmsg initmsg;
     uint32_t i;
     uint32_t valueOn = 1;
+    int bufferSize = SCTP_SOCKET_BUFFER_SIZE;
     uint16_t eventTypes[] = { SCTP_ASSOC_CHANGE,
                               SCTP_PEER_ADDR_CHANGE,
                               SCTP_REMOTE_ERROR,
@@ -105,6 +134,26 @@ static SctpUtilsResult_t ConfigureSctpSocket( struct socket * pSocket )
         }
     }
 
+    if( retStatus == SCTP_UTILS_RESULT_OK )
+    {
+        /* A message is only accepted by the non-blocking socket once it fits
+         * into the send buffer as a whole. */
+        if( ( usrsctp_setsockopt( pSocket,
+                                  SOL_SOCKET,
+                                  SO_SNDBUF,
+                                  &( bufferSize ),
+                                  sizeof( bufferSize ) ) != 0 ) ||
+            ( usrsctp_setsockopt( pSocket,
+                                  SOL_SOCKET,
+                                  SO_RCVBUF,
+                                  &( bufferSize ),
+                                  sizeof( bufferSize ) ) != 0 ) )
+        {
+            LogError( ( "usrsctp_setsockopt failed: SOL_SOCKET, SO_SNDBUF/SO_RCVBUF!" ) );
+            retStatus = SCTP_UTILS_RESULT_FAIL;
+        }
+    }
+
     if( retStatus == SCTP_UTILS_RESULT_OK )
     {
         /* Packets are generally sent as soon as possible and no unnecessary
@@ -299,65 +348,428 @@ static int OnSctpInboundPacket( struct socket * pSocket,
     int retStatus = 1;
     SctpSession_t * pSctpSession = ( SctpSession_t * ) pUlpInfo;
     uint8_t isBinary = 0U;
+    uint8_t isMessageReady = 1U;
+    uint8_t isReassembled = 0U;
 
     ( void )( pSocket );
     ( void )( addr );
-    ( void )( flags );
 
     rcv.rcv_ppid = ntohl( rcv.rcv_ppid );
 
-    switch( rcv.rcv_ppid )
+    if( ( pSctpSession == NULL ) || ( pData == NULL ) || ( ( flags & MSG_NOTIFICATION ) != 0 ) )
     {
-        /* Process incoming DCEP messages. */
-        case SCTP_PPID_DCEP:
+        isMessageReady = 0U;
+    }
+    else if( ( ( flags & MSG_EOR ) == 0 ) ||
+             ( pSctpSession->receiveLength > 0U ) ||
+             ( pSctpSession->isReceiveDiscarding != 0U ) )
+    {
+        /* Large messages are handed over in parts, collect them until the
+         * end of record. */
+        isMessageReady = ReassembleMessage( pSctpSession, pData, length, flags );
+        if( isMessageReady != 0U )
+        {
+            isReassembled = 1U;
+            free( pData );
+            pData = pSctpSession->pReceiveBuffer;
+            length = pSctpSession->receiveLength;
+        }
+    }
+    else
+    {
+        /* Empty else marker. */
+    }
+
+    /* Skip notifications and parts of a large message. */
+    if( isMessageReady != 0U )
+    {
+        switch( rcv.rcv_ppid )
         {
-            if( HandleDcepMessage( pSctpSession,
-                                   rcv.rcv_sid,
-                                   pData,
-                                   length ) != SCTP_UTILS_RESULT_OK )
+            /* Process incoming DCEP messages. */
+            case SCTP_PPID_DCEP:
+            {
+                if( HandleDcepMessage( pSctpSession,
+                                       rcv.rcv_sid,
+                                       pData,
+                                       length ) != SCTP_UTILS_RESULT_OK )
+                {
+                    retStatus = 1;
+                }
+            }
+            break;
+
+            /* Process incoming application data. */
+            case SCTP_PPID_BINARY:
+            case SCTP_PPID_BINARY_EMPTY:
+                isBinary = true;
+            /* Intentional fallthrough. */
+            case SCTP_PPID_STRING:
+            case SCTP_PPID_STRING_EMPTY:
             {
-                retStatus = 1;
+
+                pSctpSession->sctpSessionCallbacks.dataChannelMessageCallback( pSctpSession->sctpSessionCallbacks.pUserData,
+                                                                               rcv.rcv_sid,
+                                                                               isBinary,
+                                                                               pData,
+                                                                               length );
             }
+            break;
+
+            default:
+            {
+                LogWarn( ( "Unhandled PPID on incoming SCTP message %ld", ( unsigned long ) rcv.rcv_ppid ) );
+            }
+            break;
         }
-        break;
+    }
+
+    if( isReassembled != 0U )
+    {
+        /* The reassembly buffer is kept for the next large message. */
+        pSctpSession->receiveLength = 0U;
+    }
+    else if( pData != NULL )
+    {
+        /*
+         * IMPORTANT!!! The allocation is done in the sctp library using default
+         * allocator, so we need to use the default free API.
+         */
+        free( pData );
+    }
+    else
+    {
+        /* Empty else marker. */
+    }
+
+    return retStatus;
+}
+/*-----------------------------------------------------------*/
+
+/* Collect a message delivered in parts by the SCTP stack, return 1 once the
+ * complete message is available in the reassembly buffer. Messages over
+ * SCTP_MAX_MESSAGE_SIZE are dropped. */
+static uint8_t ReassembleMessage( SctpSession_t * pSctpSession,
+                                  const uint8_t * pData,
+                                  size_t length,
+                                  int flags )
+{
+    uint8_t isComplete = 0U;
+    uint8_t * pNewBuffer;
+    size_t newSize;
 
-        /* Process incoming application data. */
-        case SCTP_PPID_BINARY:
-        case SCTP_PPID_BINARY_EMPTY:
-            isBinary = true;
-        /* Intentional fallthrough. */
-        case SCTP_PPID_STRING:
-        case SCTP_PPID_STRING_EMPTY:
+    if( pSctpSession->isReceiveDiscarding == 0U )
+    {
+        if( pSctpSession->receiveLength + length > SCTP_MAX_MESSAGE_SIZE )
+        {
+            LogWarn( ( "Drop incoming SCTP message larger than %u bytes", ( unsigned int ) SCTP_MAX_MESSAGE_SIZE ) );
+            pSctpSession->isReceiveDiscarding = 1U;
+            pSctpSession->receiveLength = 0U;
+        }
+        else if( pSctpSession->receiveLength + length > pSctpSession->receiveBufferSize )
         {
+            newSize = ( pSctpSession->receiveBufferSize == 0U ) ? SCTP_MTU : pSctpSession->receiveBufferSize;
+            while( newSize < pSctpSession->receiveLength + length )
+            {
+                newSize <<= 1;
+            }
+            if( newSize > SCTP_MAX_MESSAGE_SIZE )
+            {
+                newSize = SCTP_MAX_MESSAGE_SIZE;
+            }
 
-            pSctpSession->sctpSessionCallbacks.dataChannelMessageCallback( pSctpSession->sctpSessionCallbacks.pUserData,
-                                                                           rcv.rcv_sid,
-                                                                           isBinary,
-                                                                           pData,
-                                                                           length );
+            pNewBuffer = realloc( pSctpSession->pReceiveBuffer, newSize );
+            if( pNewBuffer == NULL )
+            {
+                LogError( ( "Fail to allocate %lu bytes for SCTP message reassembly", ( unsigned long ) newSize ) );
+                pSctpSession->isReceiveDiscarding = 1U;
+                pSctpSession->receiveLength = 0U;
+            }
+            else
+            {
+                pSctpSession->pReceiveBuffer = pNewBuffer;
+                pSctpSession->receiveBufferSize = newSize;
+            }
         }
-        break;
+        else
+        {
+            /* Empty else marker. */
+        }
+    }
+
+    if( pSctpSession->isReceiveDiscarding == 0U )
+    {
+        memcpy( &( pSctpSession->pReceiveBuffer[ pSctpSession->receiveLength ] ), pData, length );
+        pSctpSession->receiveLength += length;
+    }
+
+    if( ( flags & MSG_EOR ) != 0 )
+    {
+        isComplete = ( pSctpSession->isReceiveDiscarding == 0U ) ? 1U : 0U;
+        pSctpSession->isReceiveDiscarding = 0U;
+    }
+
+    return isComplete;
+}
+/*-----------------------------------------------------------*/
 
-        default:
+/* Called by the SCTP stack while processing a SACK once at least
+ * SCTP_SEND_BUFFER_THRESHOLD bytes are free. The queue is flushed after the
+ * stack returns since it must not be re-entered from its callbacks. */
+static int OnSctpSendBufferAvailable( struct socket * pSocket,
+                                      uint32_t freeSize,
+                                      void * pUlpInfo )
+{
+    SctpSession_t * pSctpSession = ( SctpSession_t * ) pUlpInfo;
+
+    ( void ) pSocket;
+    ( void ) freeSize;
+
+    if( pSctpSession != NULL )
+    {
+        pSctpSession->isSendBufferAvailable = 1U;
+    }
+
+    return 1;
+}
+/*-----------------------------------------------------------*/
+
+/* Hand a message to the SCTP stack. Return 0 on success, 1 if the send
+ * buffer has no room for it yet, or -1 on failure. */
+static int32_t SendToSctpStack( SctpSession_t * pSctpSession,
+                                struct sctp_sendv_spa * pSpa,
+                                uint8_t * pMessage,
+                                uint32_t messageLen )
+{
+    int32_t ret = 0;
+
+    if( usrsctp_sendv( pSctpSession->socket,
+                       pMessage,
+                       messageLen,
+                       NULL,
+                       0,
+                       pSpa,
+                       sizeof( struct sctp_sendv_spa ),
+                       SCTP_SENDV_SPA,
+                       0 ) < 0 )
+    {
+        if( ( errno == EWOULDBLOCK ) || ( errno == EAGAIN ) || ( errno == ENOBUFS ) )
+        {
+            ret = 1;
+        }
+        else
         {
-            LogWarn( ( "Unhandled PPID on incoming SCTP message %ld", ( unsigned long ) rcv.rcv_ppid ) );
+            LogError( ( "usrsctp_sendv failed, errno: %d", errno ) );
+            ret = -1;
         }
-        break;
     }
 
-    /*
-     * IMPORTANT!!! The allocation is done in the sctp library using default
-     * allocator, so we need to use the default free API.
-     */
-    if( pData != NULL )
+    return ret;
+}
+/*-----------------------------------------------------------*/
+
+/* Queue a message the SCTP stack had no room for, with sendQueueMutex held.
+ * A message that failed to go out directly goes first, anything queued while
+ * it was being sent comes after it. */
+static SctpUtilsResult_t QueueMessage( SctpSession_t * pSctpSession,
+                                       SctpDataChannel_t * pDataChannel,
+                                       const struct sctp_sendv_spa * pSpa,
+                                       const uint8_t * pMessage,
+                                       uint32_t messageLen,
+                                       uint8_t isFirst )
+{
+    SctpUtilsResult_t retStatus = SCTP_UTILS_RESULT_OK;
+    SctpPendingMessage_t * pPending = NULL;
+
+    if( pSctpSession->sendQueueSize + messageLen > SCTP_MAX_SEND_QUEUE_SIZE )
     {
-        free( pData );
+        LogWarn( ( "SCTP send queue is full, queued: %lu bytes", ( unsigned long ) pSctpSession->sendQueueSize ) );
+        retStatus = SCTP_UTILS_RESULT_SEND_QUEUE_FULL;
+    }
+    else
+    {
+        pPending = ( SctpPendingMessage_t * ) malloc( sizeof( SctpPendingMessage_t ) + messageLen );
+        if( pPending == NULL )
+        {
+            LogError( ( "Fail to allocate %u bytes to queue SCTP message", ( unsigned int ) messageLen ) );
+            retStatus = SCTP_UTILS_RESULT_SEND_QUEUE_FULL;
+        }
+    }
+
+    if( retStatus == SCTP_UTILS_RESULT_OK )
+    {
+        pPending->pNext = NULL;
+        pPending->pDataChannel = pDataChannel;
+        memcpy( &( pPending->spa ), pSpa, sizeof( struct sctp_sendv_spa ) );
+        pPending->messageLength = messageLen;
+        memcpy( pPending->message, pMessage, messageLen );
+
+        if( pSctpSession->pSendQueueTail == NULL )
+        {
+            pSctpSession->pSendQueueHead = pPending;
+            pSctpSession->pSendQueueTail = pPending;
+        }
+        else if( isFirst != 0U )
+        {
+            pPending->pNext = pSctpSession->pSendQueueHead;
+            pSctpSession->pSendQueueHead = pPending;
+        }
+        else
+        {
+            pSctpSession->pSendQueueTail->pNext = pPending;
+            pSctpSession->pSendQueueTail = pPending;
+        }
+        pSctpSession->sendQueueSize += messageLen;
+        pDataChannel->bufferedAmount += messageLen;
     }
 
     return retStatus;
 }
 /*-----------------------------------------------------------*/
 
+/* Send queued messages in order until the SCTP send buffer is full again,
+ * then report channels whose buffered amount dropped to the low threshold.
+ * The stack is called without sendQueueMutex, only one thread at a time
+ * hands messages to it so the order is kept. */
+static void DrainSendQueue( SctpSession_t * pSctpSession )
+{
+    SctpPendingMessage_t * pPending;
+    SctpDataChannel_t * pDataChannel;
+    uint16_t lowChannelIds[ SCTP_MAX_BUFFERED_AMOUNT_LOW_EVENTS ];
+    uint32_t lowChannelCount = 0;
+    uint32_t i;
+    int32_t sendResult;
+
+    if( ( pSctpSession->isSendQueueInitialized != 0U ) &&
+        ( pthread_mutex_lock( &( pSctpSession->sendQueueMutex ) ) == 0 ) )
+    {
+        if( pSctpSession->isSending != 0U )
+        {
+            /* The thread sending now drains the queue once it's done. */
+            pSctpSession->isDrainPending = 1U;
+        }
+        else
+        {
+            pSctpSession->isSending = 1U;
+
+            while( pSctpSession->pSendQueueHead != NULL )
+            {
+                pSctpSession->isDrainPending = 0U;
+
+                /* Unlink the head while it's being sent, it still counts in
+                 * the queue size and the buffered amount until it's out. */
+                pPending = pSctpSession->pSendQueueHead;
+                pSctpSession->pSendQueueHead = pPending->pNext;
+                if( pSctpSession->pSendQueueHead == NULL )
+                {
+                    pSctpSession->pSendQueueTail = NULL;
+                }
+
+                pthread_mutex_unlock( &( pSctpSession->sendQueueMutex ) );
+                sendResult = SendToSctpStack( pSctpSession,
+                                              &( pPending->spa ),
+                                              pPending->message,
+                                              pPending->messageLength );
+                pthread_mutex_lock( &( pSctpSession->sendQueueMutex ) );
+
+                if( sendResult == 1 )
+                {
+                    pPending->pNext = pSctpSession->pSendQueueHead;
+                    pSctpSession->pSendQueueHead = pPending;
+                    if( pSctpSession->pSendQueueTail == NULL )
+                    {
+                        pSctpSession->pSendQueueTail = pPending;
+                    }
+
+                    /* Retry only if the stack reported free space meanwhile. */
+                    if( pSctpSession->isDrainPending == 0U )
+                    {
+                        break;
+                    }
+                }
+                else
+                {
+                    if( sendResult < 0 )
+                    {
+                        LogWarn( ( "Drop queued message of %u bytes on channel %u",
+                                   ( unsigned int ) pPending->messageLength,
+                                   ( unsigned int ) pPending->pDataChannel->channelId ) );
+                    }
+
+                    pSctpSession->sendQueueSize -= pPending->messageLength;
+
+                    pDataChannel = pPending->pDataChannel;
+                    if( ( pDataChannel->bufferedAmount > pDataChannel->bufferedAmountLowThreshold ) &&
+                        ( pDataChannel->bufferedAmount - pPending->messageLength <= pDataChannel->bufferedAmountLowThreshold ) &&
+                        ( lowChannelCount < SCTP_MAX_BUFFERED_AMOUNT_LOW_EVENTS ) )
+                    {
+                        lowChannelIds[ lowChannelCount++ ] = pDataChannel->channelId;
+                    }
+                    pDataChannel->bufferedAmount -= pPending->messageLength;
+
+                    free( pPending );
+                }
+            }
+
+            pSctpSession->isSending = 0U;
+        }
+
+        pthread_mutex_unlock( &( pSctpSession->sendQueueMutex ) );
+    }
+
+    /* Report outside of the lock so the application can send from the callback. */
+    if( pSctpSession->sctpSessionCallbacks.dataChannelBufferedAmountLowCallback != NULL )
+    {
+        for( i = 0; i < lowChannelCount; i++ )
+        {
+            pSctpSession->sctpSessionCallbacks.dataChannelBufferedAmountLowCallback( pSctpSession->sctpSessionCallbacks.pUserData,
+                                                                                     lowChannelIds[ i ] );
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+/* Free queued messages of the given channel, or all of them if pDataChannel is NULL. */
+static void FreeSendQueue( SctpSession_t * pSctpSession,
+                           const SctpDataChannel_t * pDataChannel )
+{
+    SctpPendingMessage_t * pPending;
+    SctpPendingMessage_t * pPrev = NULL;
+    SctpPendingMessage_t * pNext;
+
+    pPending = pSctpSession->pSendQueueHead;
+    while( pPending != NULL )
+    {
+        pNext = pPending->pNext;
+
+        if( ( pDataChannel == NULL ) || ( pPending->pDataChannel == pDataChannel ) )
+        {
+            if( pPrev == NULL )
+            {
+                pSctpSession->pSendQueueHead = pNext;
+            }
+            else
+            {
+                pPrev->pNext = pNext;
+            }
+            if( pSctpSession->pSendQueueTail == pPending )
+            {
+                pSctpSession->pSendQueueTail = pPrev;
+            }
+
+            pSctpSession->sendQueueSize -= pPending->messageLength;
+            pPending->pDataChannel->bufferedAmount -= pPending->messageLength;
+            free( pPending );
+        }
+        else
+        {
+            pPrev = pPending;
+        }
+
+        pPending = pNext;
+    }
+}
+/*-----------------------------------------------------------*/
+
 static SctpUtilsResult_t SendOpenDataChannelAck( SctpSession_t * pSctpSession,
                                                  uint16_t channelId )
 {
@@ -440,7 +852,8 @@ void Sctp_DeInit( void )
 
 /* Create the SCTP session by connecting to the remote socket. */
 SctpUtilsResult_t Sctp_CreateSession( SctpSession_t * pSctpSession,
-                                      uint8_t isServer )
+                                      uint8_t isServer,
+                                      uint32_t remoteMaxMessageSize )
 {
     SctpUtilsResult_t retStatus = SCTP_UTILS_RESULT_OK;
     struct sockaddr_conn localConn, remoteConn;
@@ -452,6 +865,39 @@ SctpUtilsResult_t Sctp_CreateSession( SctpSession_t * pSctpSession,
         retStatus = SCTP_UTILS_RESULT_BAD_PARAM;
     }
 
+    if( retStatus == SCTP_UTILS_RESULT_OK )
+    {
+        /* 0 means the remote accepts any size, the whole message still has
+         * to fit into the send buffer. */
+        if( ( remoteMaxMessageSize == 0U ) || ( remoteMaxMessageSize > SCTP_SEND_BUFFER_THRESHOLD ) )
+        {
+            remoteMaxMessageSize = SCTP_SEND_BUFFER_THRESHOLD;
+        }
+        pSctpSession->maxSendMessageSize = remoteMaxMessageSize;
+
+        pSctpSession->pSendQueueHead = NULL;
+        pSctpSession->pSendQueueTail = NULL;
+        pSctpSession->sendQueueSize = 0U;
+        pSctpSession->isSendBufferAvailable = 0U;
+        pSctpSession->isSending = 0U;
+        pSctpSession->isDrainPending = 0U;
+        pSctpSession->pReceiveBuffer = NULL;
+        pSctpSession->receiveBufferSize = 0U;
+        pSctpSession->receiveLength = 0U;
+        pSctpSession->isReceiveDiscarding = 0U;
+
+        if( pthread_mutex_init( &( pSctpSession->sendQueueMutex ), NULL ) != 0 )
+        {
+            LogError( ( "Fail to create SCTP send queue mutex" ) );
+            pSctpSession->isSendQueueInitialized = 0U;
+            retStatus = SCTP_UTILS_RESULT_FAIL;
+        }
+        else
+        {
+            pSctpSession->isSendQueueInitialized = 1U;
+        }
+    }
+
     if( retStatus == SCTP_UTILS_RESULT_OK )
     {
         memset( &( params ), 0x00, sizeof( struct sctp_paddrparams ) );
@@ -470,8 +916,8 @@ SctpUtilsResult_t Sctp_CreateSession( SctpSession_t * pSctpSession,
                                                SOCK_STREAM,
                                                IPPROTO_SCTP,
                                                &OnSctpInboundPacket,
-                                               NULL,
-                                               0,
+                                               &OnSctpSendBufferAvailable,
+                                               SCTP_SEND_BUFFER_THRESHOLD,
                                                pSctpSession );
         if( pSctpSession->socket == NULL )
         {
@@ -587,6 +1033,21 @@ SctpUtilsResult_t Sctp_FreeSession( SctpSession_t * pSctpSession )
                 usleep( SCTP_TEARDOWN_POLLING_INTERVAL_USEC );
             }
         }
+
+        if( pSctpSession->isSendQueueInitialized != 0U )
+        {
+            FreeSendQueue( pSctpSession, NULL );
+            pthread_mutex_destroy( &( pSctpSession->sendQueueMutex ) );
+            pSctpSession->isSendQueueInitialized = 0U;
+        }
+
+        if( pSctpSession->pReceiveBuffer != NULL )
+        {
+            free( pSctpSession->pReceiveBuffer );
+            pSctpSession->pReceiveBuffer = NULL;
+            pSctpSession->receiveBufferSize = 0U;
+            pSctpSession->receiveLength = 0U;
+        }
     }
 
     return retStatus;
@@ -610,6 +1071,12 @@ SctpUtilsResult_t Sctp_ProcessMessage( SctpSession_t * pSctpSession,
     if( retStatus == SCTP_UTILS_RESULT_OK )
     {
         usrsctp_conninput( pSctpSession, pBuf, bufLen, 0 );
+
+        /* Acknowledged data may have freed send buffer for queued messages. */
+        if( __atomic_exchange_n( &( pSctpSession->isSendBufferAvailable ), 0U, __ATOMIC_ACQ_REL ) != 0U )
+        {
+            DrainSendQueue( pSctpSession );
+        }
     }
 
     return retStatus;
@@ -712,64 +1179,214 @@ SctpUtilsResult_t Sctp_OpenDataChannel( SctpSession_t * pSctpSession,
 
 /* Write SCTP message to the given session and stream. */
 SctpUtilsResult_t Sctp_SendMessage( SctpSession_t * pSctpSession,
-                                    const SctpDataChannel_t * pDataChannel,
+                                    SctpDataChannel_t * pDataChannel,
                                     uint8_t isBinary,
                                     uint8_t * pMessage,
                                     uint32_t messageLen )
 {
     SctpUtilsResult_t retStatus = SCTP_UTILS_RESULT_OK;
+    struct sctp_sendv_spa spa;
+    int32_t sendResult;
+    uint8_t isDirectSend = 0U;
+    uint8_t isDrainNeeded = 0U;
 
     if( ( pSctpSession == NULL ) ||
         ( pDataChannel == NULL ) ||
-        ( pMessage == NULL ) )
+        ( pMessage == NULL ) ||
+        ( pSctpSession->isSendQueueInitialized == 0U ) )
     {
         retStatus = SCTP_UTILS_RESULT_BAD_PARAM;
     }
-
+    else if( messageLen > pSctpSession->maxSendMessageSize )
+    {
+        LogError( ( "Message of %u bytes exceeds max message size %u",
+                    ( unsigned int ) messageLen,
+                    ( unsigned int ) pSctpSession->maxSendMessageSize ) );
+        retStatus = SCTP_UTILS_RESULT_MESSAGE_TOO_LARGE;
+    }
+    else
+    {
+        /* Empty else marker. */
+    }
 
     if( retStatus == SCTP_UTILS_RESULT_OK )
     {
-        memset( &( pSctpSession->spa ), 0x00, sizeof( struct sctp_sendv_spa ) );
+        /* The options are built per message since they're queued along with it. */
+        memset( &( spa ), 0x00, sizeof( struct sctp_sendv_spa ) );
 
-        pSctpSession->spa.sendv_flags |= SCTP_SEND_SNDINFO_VALID;
-        pSctpSession->spa.sendv_sndinfo.snd_sid = pDataChannel->channelId;
+        spa.sendv_flags |= SCTP_SEND_SNDINFO_VALID;
+        spa.sendv_sndinfo.snd_sid = pDataChannel->channelId;
 
         if( ( pDataChannel->channelType == DCEP_DATA_CHANNEL_RELIABLE_UNORDERED ) ||
             ( pDataChannel->channelType == DCEP_DATA_CHANNEL_PARTIAL_RELIABLE_REXMIT_UNORDERED ) ||
             ( pDataChannel->channelType == DCEP_DATA_CHANNEL_PARTIAL_RELIABLE_TIMED_UNORDERED ) )
         {
-            pSctpSession->spa.sendv_sndinfo.snd_flags |= SCTP_UNORDERED;
+            spa.sendv_sndinfo.snd_flags |= SCTP_UNORDERED;
         }
 
         if( ( pDataChannel->channelType == DCEP_DATA_CHANNEL_PARTIAL_RELIABLE_REXMIT ) ||
             ( pDataChannel->channelType == DCEP_DATA_CHANNEL_PARTIAL_RELIABLE_REXMIT_UNORDERED ) )
         {
-            pSctpSession->spa.sendv_prinfo.pr_policy = SCTP_PR_SCTP_RTX;
-            pSctpSession->spa.sendv_prinfo.pr_value = pDataChannel->numRetransmissions;
+            spa.sendv_prinfo.pr_policy = SCTP_PR_SCTP_RTX;
+            spa.sendv_prinfo.pr_value = pDataChannel->numRetransmissions;
         }
 
         if( ( pDataChannel->channelType == DCEP_DATA_CHANNEL_PARTIAL_RELIABLE_TIMED ) ||
             ( pDataChannel->channelType == DCEP_DATA_CHANNEL_PARTIAL_RELIABLE_TIMED_UNORDERED ) )
         {
-            pSctpSession->spa.sendv_prinfo.pr_policy = SCTP_PR_SCTP_TTL;
-            pSctpSession->spa.sendv_prinfo.pr_value = pDataChannel->maxLifetimeInMilliseconds;
+            spa.sendv_prinfo.pr_policy = SCTP_PR_SCTP_TTL;
+            spa.sendv_prinfo.pr_value = pDataChannel->maxLifetimeInMilliseconds;
         }
 
-        pSctpSession->spa.sendv_sndinfo.snd_ppid = isBinary ? ntohl( SCTP_PPID_BINARY ) : ntohl( SCTP_PPID_STRING );
+        spa.sendv_sndinfo.snd_ppid = isBinary ? ntohl( SCTP_PPID_BINARY ) : ntohl( SCTP_PPID_STRING );
 
-        if( usrsctp_sendv( pSctpSession->socket,
-                           pMessage,
-                           messageLen,
-                           NULL,
-                           0,
-                           &( pSctpSession->spa ),
-                           sizeof( pSctpSession->spa ),
-                           SCTP_SENDV_SPA,
-                           0 ) <= 0 )
+    }
+
+    if( ( retStatus == SCTP_UTILS_RESULT_OK ) &&
+        ( pthread_mutex_lock( &( pSctpSession->sendQueueMutex ) ) == 0 ) )
+    {
+        /* Keep the order, only bypass the queue when it's empty and no other
+         * thread is handing messages to the stack. */
+        if( ( pSctpSession->pSendQueueHead == NULL ) &&
+            ( pSctpSession->isSending == 0U ) )
         {
-            LogError( ( "usrsctp_sendv failed!" ) );
+            pSctpSession->isSending = 1U;
+            isDirectSend = 1U;
+        }
+        else
+        {
+            retStatus = QueueMessage( pSctpSession, pDataChannel, &( spa ), pMessage, messageLen, 0U );
+        }
+
+        pthread_mutex_unlock( &( pSctpSession->sendQueueMutex ) );
+    }
+    else if( retStatus == SCTP_UTILS_RESULT_OK )
+    {
+        LogError( ( "Fail to take SCTP send queue mutex" ) );
+        retStatus = SCTP_UTILS_RESULT_FAIL;
+    }
+    else
+    {
+        /* Empty else marker. */
+    }
+
+    if( isDirectSend != 0U )
+    {
+        /* The stack is called without sendQueueMutex, so the SCTP task and
+         * the other senders only wait for the queue, never for the stack. */
+        sendResult = SendToSctpStack( pSctpSession, &( spa ), pMessage, messageLen );
+
+        pthread_mutex_lock( &( pSctpSession->sendQueueMutex ) );
+
+        if( sendResult < 0 )
+        {
+            retStatus = SCTP_UTILS_RESULT_FAIL;
+        }
+        else if( sendResult == 1 )
+        {
+            retStatus = QueueMessage( pSctpSession, pDataChannel, &( spa ), pMessage, messageLen, 1U );
+        }
+        else
+        {
+            /* Empty else marker. */
+        }
+
+        /* Flush what was queued behind this message, or what a drain left
+         * to this thread while it was sending. */
+        if( ( pSctpSession->pSendQueueHead != NULL ) &&
+            ( ( sendResult == 0 ) || ( pSctpSession->isDrainPending != 0U ) ) )
+        {
+            isDrainNeeded = 1U;
+        }
+        pSctpSession->isSending = 0U;
+
+        pthread_mutex_unlock( &( pSctpSession->sendQueueMutex ) );
+
+        if( isDrainNeeded != 0U )
+        {
+            DrainSendQueue( pSctpSession );
+        }
+    }
+
+    return retStatus;
+}
+/*-----------------------------------------------------------*/
+
+/* Get the bytes of the channel still waiting in the send queue, plus the
+ * bytes the SCTP stack holds for the association until they're acknowledged.
+ * The stack doesn't account them per stream, so they're shared by all the
+ * channels of the session. */
+SctpUtilsResult_t Sctp_GetBufferedAmount( SctpSession_t * pSctpSession,
+                                          const SctpDataChannel_t * pDataChannel,
+                                          size_t * pBufferedAmount )
+{
+    SctpUtilsResult_t retStatus = SCTP_UTILS_RESULT_OK;
+    struct sctp_sockstat sockStat;
+    socklen_t sockStatLength = ( socklen_t ) sizeof( struct sctp_sockstat );
+
+    if( ( pSctpSession == NULL ) ||
+        ( pDataChannel == NULL ) ||
+        ( pBufferedAmount == NULL ) )
+    {
+        retStatus = SCTP_UTILS_RESULT_BAD_PARAM;
+    }
+    else if( pSctpSession->isSendQueueInitialized == 0U )
+    {
+        *pBufferedAmount = 0U;
+    }
+    else if( pthread_mutex_lock( &( pSctpSession->sendQueueMutex ) ) == 0 )
+    {
+        *pBufferedAmount = pDataChannel->bufferedAmount;
+        pthread_mutex_unlock( &( pSctpSession->sendQueueMutex ) );
+
+        memset( &( sockStat ), 0x00, sizeof( struct sctp_sockstat ) );
+        if( usrsctp_getsockopt( pSctpSession->socket,
+                                IPPROTO_SCTP,
+                                SCTP_GET_SNDBUF_USE,
+                                &( sockStat ),
+                                &( sockStatLength ) ) < 0 )
+        {
+            LogError( ( "Fail to get SCTP send buffer use, errno: %d", errno ) );
             retStatus = SCTP_UTILS_RESULT_FAIL;
         }
+        else
+        {
+            *pBufferedAmount += sockStat.ss_total_sndbuf;
+        }
+    }
+    else
+    {
+        retStatus = SCTP_UTILS_RESULT_FAIL;
+    }
+
+    return retStatus;
+}
+/*-----------------------------------------------------------*/
+
+/* The threshold is read by the send path, set it with the queue lock held. */
+SctpUtilsResult_t Sctp_SetBufferedAmountLowThreshold( SctpSession_t * pSctpSession,
+                                                      SctpDataChannel_t * pDataChannel,
+                                                      size_t threshold )
+{
+    SctpUtilsResult_t retStatus = SCTP_UTILS_RESULT_OK;
+
+    if( ( pSctpSession == NULL ) ||
+        ( pDataChannel == NULL ) )
+    {
+        retStatus = SCTP_UTILS_RESULT_BAD_PARAM;
+    }
+    else if( pSctpSession->isSendQueueInitialized == 0U )
+    {
+        pDataChannel->bufferedAmountLowThreshold = threshold;
+    }
+    else if( pthread_mutex_lock( &( pSctpSession->sendQueueMutex ) ) == 0 )
+    {
+        pDataChannel->bufferedAmountLowThreshold = threshold;
+        pthread_mutex_unlock( &( pSctpSession->sendQueueMutex ) );
+    }
+    else
+    {
+        retStatus = SCTP_UTILS_RESULT_FAIL;
     }
 
     return retStatus;
@@ -790,6 +1407,15 @@ SctpUtilsResult_t Sctp_CloseDataChannel( SctpSession_t * pSctpSession,
         retStatus = SCTP_UTILS_RESULT_BAD_PARAM;
     }
 
+    if( ( retStatus == SCTP_UTILS_RESULT_OK ) &&
+        ( pSctpSession->isSendQueueInitialized != 0U ) &&
+        ( pthread_mutex_lock( &( pSctpSession->sendQueueMutex ) ) == 0 ) )
+    {
+        /* The channel is going away, drop what it still has queued. */
+        FreeSendQueue( pSctpSession, pDataChannel );
+        pthread_mutex_unlock( &( pSctpSession->sendQueueMutex ) );
+    }
+
     if( retStatus == SCTP_UTILS_RESULT_OK )
     {
         len = sizeof( sctp_assoc_t ) + ( ( 2 + 1 ) * sizeof( uint16_t ) );
@@ -814,4 +1440,183 @@ SctpUtilsResult_t Sctp_CloseDataChannel( SctpSession_t * pSctpSession,
 }
 /*-----------------------------------------------------------*/
 
+SctpUtilsResult_t Sctp_InitReceiveQueue( SctpReceiveQueue_t * pReceiveQueue,
+                                         size_t maxQueueSize )
+{
+    SctpUtilsResult_t retStatus = SCTP_UTILS_RESULT_OK;
+
+    if( ( pReceiveQueue == NULL ) ||
+        ( maxQueueSize == 0U ) )
+    {
+        retStatus = SCTP_UTILS_RESULT_BAD_PARAM;
+    }
+
+    if( retStatus == SCTP_UTILS_RESULT_OK )
+    {
+        memset( pReceiveQueue, 0, sizeof( SctpReceiveQueue_t ) );
+        pReceiveQueue->maxQueueSize = maxQueueSize;
+
+        if( pthread_mutex_init( &( pReceiveQueue->queueMutex ), NULL ) != 0 )
+        {
+            LogError( ( "Fail to create SCTP receive queue mutex" ) );
+            retStatus = SCTP_UTILS_RESULT_FAIL;
+        }
+        else if( pthread_cond_init( &( pReceiveQueue->queueCond ), NULL ) != 0 )
+        {
+            LogError( ( "Fail to create SCTP receive queue condition" ) );
+            pthread_mutex_destroy( &( pReceiveQueue->queueMutex ) );
+            retStatus = SCTP_UTILS_RESULT_FAIL;
+        }
+        else
+        {
+            /* Empty else marker. */
+        }
+    }
+
+    return retStatus;
+}
+/*-----------------------------------------------------------*/
+
+/* Nothing may wait on the queue any more when it's freed. */
+void Sctp_FreeReceiveQueue( SctpReceiveQueue_t * pReceiveQueue )
+{
+    if( pReceiveQueue != NULL )
+    {
+        Sctp_FlushReceiveQueue( pReceiveQueue );
+        pthread_cond_destroy( &( pReceiveQueue->queueCond ) );
+        pthread_mutex_destroy( &( pReceiveQueue->queueMutex ) );
+    }
+}
+/*-----------------------------------------------------------*/
+
+/* Copy the packet to the tail of the queue. This runs on the network thread,
+ * so it never waits for the SCTP stack. */
+SctpUtilsResult_t Sctp_PushReceivedPacket( SctpReceiveQueue_t * pReceiveQueue,
+                                           const uint8_t * pPacket,
+                                           uint32_t packetLength )
+{
+    SctpUtilsResult_t retStatus = SCTP_UTILS_RESULT_OK;
+    SctpReceivedPacket_t * pReceived = NULL;
+
+    if( ( pReceiveQueue == NULL ) ||
+        ( pPacket == NULL ) ||
+        ( packetLength == 0U ) )
+    {
+        retStatus = SCTP_UTILS_RESULT_BAD_PARAM;
+    }
+
+    if( retStatus == SCTP_UTILS_RESULT_OK )
+    {
+        pReceived = ( SctpReceivedPacket_t * ) malloc( sizeof( SctpReceivedPacket_t ) + packetLength );
+        if( pReceived == NULL )
+        {
+            LogError( ( "Fail to allocate %u bytes to queue SCTP packet", ( unsigned int ) packetLength ) );
+            retStatus = SCTP_UTILS_RESULT_FAIL;
+        }
+        else
+        {
+            pReceived->pNext = NULL;
+            pReceived->packetLength = packetLength;
+            memcpy( pReceived->packet, pPacket, packetLength );
+        }
+    }
+
+    if( ( retStatus == SCTP_UTILS_RESULT_OK ) &&
+        ( pthread_mutex_lock( &( pReceiveQueue->queueMutex ) ) == 0 ) )
+    {
+        if( pReceiveQueue->queueSize + packetLength > pReceiveQueue->maxQueueSize )
+        {
+            pReceiveQueue->droppedPackets++;
+            retStatus = SCTP_UTILS_RESULT_RECEIVE_QUEUE_FULL;
+        }
+        else
+        {
+            if( pReceiveQueue->pTail == NULL )
+            {
+                pReceiveQueue->pHead = pReceived;
+            }
+            else
+            {
+                pReceiveQueue->pTail->pNext = pReceived;
+            }
+            pReceiveQueue->pTail = pReceived;
+            pReceiveQueue->queueSize += packetLength;
+            pReceived = NULL;
+
+            pthread_cond_signal( &( pReceiveQueue->queueCond ) );
+        }
+
+        pthread_mutex_unlock( &( pReceiveQueue->queueMutex ) );
+    }
+    else if( retStatus == SCTP_UTILS_RESULT_OK )
+    {
+        LogError( ( "Fail to take SCTP receive queue mutex" ) );
+        retStatus = SCTP_UTILS_RESULT_FAIL;
+    }
+    else
+    {
+        /* Empty else marker. */
+    }
+
+    /* Not queued. */
+    free( pReceived );
+
+    return retStatus;
+}
+/*-----------------------------------------------------------*/
+
+/* Wait for the next packet. The caller owns the returned packet and frees it. */
+SctpReceivedPacket_t * Sctp_PopReceivedPacket( SctpReceiveQueue_t * pReceiveQueue )
+{
+    SctpReceivedPacket_t * pReceived = NULL;
+
+    if( ( pReceiveQueue != NULL ) &&
+        ( pthread_mutex_lock( &( pReceiveQueue->queueMutex ) ) == 0 ) )
+    {
+        while( pReceiveQueue->pHead == NULL )
+        {
+            pthread_cond_wait( &( pReceiveQueue->queueCond ),
+                               &( pReceiveQueue->queueMutex ) );
+        }
+
+        pReceived = pReceiveQueue->pHead;
+        pReceiveQueue->pHead = pReceived->pNext;
+        if( pReceiveQueue->pHead == NULL )
+        {
+            pReceiveQueue->pTail = NULL;
+        }
+        pReceiveQueue->queueSize -= pReceived->packetLength;
+
+        pthread_mutex_unlock( &( pReceiveQueue->queueMutex ) );
+    }
+
+    return pReceived;
+}
+/*-----------------------------------------------------------*/
+
+void Sctp_FlushReceiveQueue( SctpReceiveQueue_t * pReceiveQueue )
+{
+    SctpReceivedPacket_t * pReceived;
+    SctpReceivedPacket_t * pNext;
+
+    if( ( pReceiveQueue != NULL ) &&
+        ( pthread_mutex_lock( &( pReceiveQueue->queueMutex ) ) == 0 ) )
+    {
+        pReceived = pReceiveQueue->pHead;
+        pReceiveQueue->pHead = NULL;
+        pReceiveQueue->pTail = NULL;
+        pReceiveQueue->queueSize = 0U;
+
+        pthread_mutex_unlock( &( pReceiveQueue->queueMutex ) );
+
+        while( pReceived != NULL )
+        {
+            pNext = pReceived->pNext;
+            free( pReceived );
+            pReceived = pNext;
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
 #endif /* ENABLE_SCTP_DATA_CHANNEL */
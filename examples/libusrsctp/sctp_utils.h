@@ -19,6 +19,7 @@
 
 /* Standard includes. */
 #include <stdbool.h>
+#include <pthread.h>
 
 /* libusrsctp includes. */
 #define INET  1
@@ -38,12 +39,47 @@
                                               MAX_DATA_CHANNEL_NAME_LEN + \
                                               MAX_DATA_CHANNEL_PROTOCOL_LEN + 2 )
 
+/* Largest message accepted from the remote, advertised in SDP as a=max-message-size. */
+#ifndef SCTP_MAX_MESSAGE_SIZE
+#define SCTP_MAX_MESSAGE_SIZE               ( 262144 )
+#endif
+
+/* Remote limit assumed when the remote SDP carries no max-message-size, see RFC 8841. */
+#define SCTP_DEFAULT_REMOTE_MAX_MESSAGE_SIZE ( 65536 )
+
+/* Send and receive buffer size of the SCTP socket. */
+#ifndef SCTP_SOCKET_BUFFER_SIZE
+#define SCTP_SOCKET_BUFFER_SIZE             ( 1048576 )
+#endif
+
+/* The SCTP stack reports free send buffer once this much is available, a
+ * message is never larger than this so it always fits at that point. */
+#define SCTP_SEND_BUFFER_THRESHOLD          ( SCTP_SOCKET_BUFFER_SIZE / 2 )
+
+/* Maximum bytes queued per session while the SCTP send buffer is full. */
+#ifndef SCTP_MAX_SEND_QUEUE_SIZE
+#define SCTP_MAX_SEND_QUEUE_SIZE            ( 4194304 )
+#endif
+
+/* Maximum bytes of inbound packets queued per session before the SCTP stack
+ * takes them. The remote has at most one receive window of DATA in flight, the
+ * rest covers packet headers and SACKs for our own sends. */
+#ifndef SCTP_MAX_RECEIVE_QUEUE_SIZE
+#define SCTP_MAX_RECEIVE_QUEUE_SIZE         ( SCTP_SOCKET_BUFFER_SIZE + ( SCTP_SOCKET_BUFFER_SIZE / 8 ) )
+#endif
+
+/* Maximum data channels reported by one drain of the send queue. */
+#define SCTP_MAX_BUFFERED_AMOUNT_LOW_EVENTS ( 8 )
+
 /*-----------------------------------------------------------*/
 
 typedef enum SctpUtilsResult
 {
     SCTP_UTILS_RESULT_OK = 0,
     SCTP_UTILS_RESULT_BAD_PARAM,
+    SCTP_UTILS_RESULT_MESSAGE_TOO_LARGE,
+    SCTP_UTILS_RESULT_SEND_QUEUE_FULL,
+    SCTP_UTILS_RESULT_RECEIVE_QUEUE_FULL,
     SCTP_UTILS_RESULT_FAIL
 } SctpUtilsResult_t;
 
@@ -83,6 +119,13 @@ typedef void ( * SctpSessionDataChannelMessage_t )( void * pUserData,
                                                     uint8_t * pData,
                                                     uint32_t dataLength );
 
+/*
+ * Callback that is fired when the buffered amount of a data channel drops to
+ * or below its low threshold.
+ */
+typedef void ( * SctpSessionDataChannelBufferedAmountLow_t )( void * pUserData,
+                                                              uint16_t channelId );
+
 /*-----------------------------------------------------------*/
 
 typedef struct SctpSessionCallbacks
@@ -92,8 +135,31 @@ typedef struct SctpSessionCallbacks
     SctpSessionDataChannelOpen_t dataChannelOpenCallback;
     SctpSessionDataChannelAck_t dataChannelOpenAckCallback;
     SctpSessionDataChannelMessage_t dataChannelMessageCallback;
+    SctpSessionDataChannelBufferedAmountLow_t dataChannelBufferedAmountLowCallback;
 } SctpSessionCallbacks_t;
 
+typedef struct SctpDataChannel
+{
+    DcepChannelType_t channelType;
+    uint32_t numRetransmissions;
+    uint32_t maxLifetimeInMilliseconds;
+    uint16_t channelId;
+
+    /* Bytes of this channel waiting in the session send queue. */
+    size_t bufferedAmount;
+    size_t bufferedAmountLowThreshold;
+} SctpDataChannel_t;
+
+/* A message the SCTP stack had no room for yet. */
+typedef struct SctpPendingMessage
+{
+    struct SctpPendingMessage * pNext;
+    SctpDataChannel_t * pDataChannel;
+    struct sctp_sendv_spa spa;
+    uint32_t messageLength;
+    uint8_t message[];
+} SctpPendingMessage_t;
+
 typedef struct SctpSession
 {
     volatile size_t shutdownStatus;
@@ -105,15 +171,51 @@ typedef struct SctpSession
 
     SctpSessionCallbacks_t sctpSessionCallbacks;
     uint16_t currentChannelId;
+
+    /* Largest message the remote accepts, negotiated through SDP. */
+    uint32_t maxSendMessageSize;
+
+    /* Messages are queued in order while the SCTP send buffer is full and
+     * flushed once the stack reports free space. */
+    pthread_mutex_t sendQueueMutex;
+    uint8_t isSendQueueInitialized;
+    SctpPendingMessage_t * pSendQueueHead;
+    SctpPendingMessage_t * pSendQueueTail;
+    size_t sendQueueSize;
+    volatile uint8_t isSendBufferAvailable;
+    /* Set while a thread hands messages to the stack without the lock, a
+     * drain requested meanwhile is left to that thread. */
+    uint8_t isSending;
+    uint8_t isDrainPending;
+
+    /* Message delivered in parts by the SCTP stack. */
+    uint8_t * pReceiveBuffer;
+    size_t receiveBufferSize;
+    size_t receiveLength;
+    uint8_t isReceiveDiscarding;
 } SctpSession_t;
 
-typedef struct SctpDataChannel
+/* An inbound packet waiting to be fed to the SCTP stack. */
+typedef struct SctpReceivedPacket
 {
-    DcepChannelType_t channelType;
-    uint32_t numRetransmissions;
-    uint32_t maxLifetimeInMilliseconds;
-    uint16_t channelId;
-} SctpDataChannel_t;
+    struct SctpReceivedPacket * pNext;
+    uint32_t packetLength;
+    uint8_t packet[];
+} SctpReceivedPacket_t;
+
+/* Hands inbound packets from the network thread to the thread running the
+ * SCTP stack. Pushing never blocks, packets are only dropped once the queued
+ * bytes exceed maxQueueSize. */
+typedef struct SctpReceiveQueue
+{
+    pthread_mutex_t queueMutex;
+    pthread_cond_t queueCond;
+    SctpReceivedPacket_t * pHead;
+    SctpReceivedPacket_t * pTail;
+    size_t queueSize;
+    size_t maxQueueSize;
+    uint32_t droppedPackets;
+} SctpReceiveQueue_t;
 
 typedef struct SctpDataChannelInitInfo
 {
@@ -131,7 +233,8 @@ SctpUtilsResult_t Sctp_Init( void );
 void Sctp_DeInit( void );
 
 SctpUtilsResult_t Sctp_CreateSession( SctpSession_t * pSctpSession,
-                                      uint8_t isServer );
+                                      uint8_t isServer,
+                                      uint32_t remoteMaxMessageSize );
 
 SctpUtilsResult_t Sctp_FreeSession( SctpSession_t * pSctpSession );
 
@@ -144,14 +247,35 @@ SctpUtilsResult_t Sctp_OpenDataChannel( SctpSession_t * pSctpSession,
                                         SctpDataChannel_t * pDataChannel );
 
 SctpUtilsResult_t Sctp_SendMessage( SctpSession_t * pSctpSession,
-                                    const SctpDataChannel_t * pDataChannel,
+                                    SctpDataChannel_t * pDataChannel,
                                     uint8_t isBinary,
                                     uint8_t * pMessage,
                                     uint32_t messageLen );
 
+SctpUtilsResult_t Sctp_GetBufferedAmount( SctpSession_t * pSctpSession,
+                                          const SctpDataChannel_t * pDataChannel,
+                                          size_t * pBufferedAmount );
+
+SctpUtilsResult_t Sctp_SetBufferedAmountLowThreshold( SctpSession_t * pSctpSession,
+                                                      SctpDataChannel_t * pDataChannel,
+                                                      size_t threshold );
+
 SctpUtilsResult_t Sctp_CloseDataChannel( SctpSession_t * pSctpSession,
                                          const SctpDataChannel_t * pDataChannel );
 
+SctpUtilsResult_t Sctp_InitReceiveQueue( SctpReceiveQueue_t * pReceiveQueue,
+                                         size_t maxQueueSize );
+
+void Sctp_FreeReceiveQueue( SctpReceiveQueue_t * pReceiveQueue );
+
+SctpUtilsResult_t Sctp_PushReceivedPacket( SctpReceiveQueue_t * pReceiveQueue,
+                                           const uint8_t * pPacket,
+                                           uint32_t packetLength );
+
+SctpReceivedPacket_t * Sctp_PopReceivedPacket( SctpReceiveQueue_t * pReceiveQueue );
+
+void Sctp_FlushReceiveQueue( SctpReceiveQueue_t * pReceiveQueue );
+
 /*-----------------------------------------------------------*/
 
 #endif /* DATA_CHANNEL_SCTP_H */
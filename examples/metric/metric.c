@@ -19,6 +19,7 @@
 #include "metric.h"
 #endif
 
+#include <stdio.h>
 #include <time.h>
 #include <unistd.h>
 
@@ -29,6 +30,9 @@ MetricContext_t context;
 /* Convert event ID enum into string. */
 static const char * ConvertEventToString( MetricEvent_t event );
 
+/* Convert histogram ID enum into string. */
+static const char * ConvertHistogramToString( MetricHistogram_t histogram );
+
 /* Calculate the duration in miliseconds from start & end time. */
 static uint64_t CalculateEventDurationMs( uint64_t startTimeUs,
                                           uint64_t endTimeUs );
@@ -85,6 +89,97 @@ static const char * ConvertEventToString( MetricEvent_t event )
     return pRet;
 }
 
+static const char * ConvertHistogramToString( MetricHistogram_t histogram )
+{
+    const char * pRet = "Unknown";
+    switch( histogram )
+    {
+        case METRIC_HISTOGRAM_DTLS_FLIGHT_DURATION:
+            pRet = "DTLS Flight Duration (us)";
+            break;
+        case METRIC_HISTOGRAM_DTLS_RETRANSMISSIONS:
+            pRet = "DTLS Retransmissions Per Handshake";
+            break;
+        case METRIC_HISTOGRAM_DTLS_CPU_HELLO:
+            pRet = "DTLS CPU Time Of Hello Step (us)";
+            break;
+        case METRIC_HISTOGRAM_DTLS_CPU_KEY_EXCHANGE:
+            pRet = "DTLS CPU Time Of Key Exchange Step (us)";
+            break;
+        case METRIC_HISTOGRAM_DTLS_CPU_CERTIFICATE_VERIFY:
+            pRet = "DTLS CPU Time Of Certificate Verify Step (us)";
+            break;
+        case METRIC_HISTOGRAM_DTLS_CPU_FINISHED:
+            pRet = "DTLS CPU Time Of Finished Step (us)";
+            break;
+        case METRIC_HISTOGRAM_DTLS_VERIFY_FINGERPRINT:
+            pRet = "DTLS Verify Remote Fingerprint (us)";
+            break;
+        case METRIC_HISTOGRAM_DTLS_SRTP_SETUP:
+            pRet = "DTLS Keying Material And SRTP Setup (us)";
+            break;
+        case METRIC_HISTOGRAM_SRTP_RTP_TX_LOCK_WAIT:
+            pRet = "SRTP RTP Tx Lock Wait (ns)";
+            break;
+        case METRIC_HISTOGRAM_SRTP_RTP_RX_LOCK_WAIT:
+            pRet = "SRTP RTP Rx Lock Wait (ns)";
+            break;
+        case METRIC_HISTOGRAM_SRTP_RTCP_TX_LOCK_WAIT:
+            pRet = "SRTP RTCP Tx Lock Wait (ns)";
+            break;
+        case METRIC_HISTOGRAM_SRTP_RTCP_RX_LOCK_WAIT:
+            pRet = "SRTP RTCP Rx Lock Wait (ns)";
+            break;
+        case METRIC_HISTOGRAM_SRTP_RTP_TX_LOCK_HOLD:
+            pRet = "SRTP RTP Tx Lock Hold (ns)";
+            break;
+        case METRIC_HISTOGRAM_SRTP_RTP_RX_LOCK_HOLD:
+            pRet = "SRTP RTP Rx Lock Hold (ns)";
+            break;
+        case METRIC_HISTOGRAM_SRTP_RTCP_TX_LOCK_HOLD:
+            pRet = "SRTP RTCP Tx Lock Hold (ns)";
+            break;
+        case METRIC_HISTOGRAM_SRTP_RTCP_RX_LOCK_HOLD:
+            pRet = "SRTP RTCP Rx Lock Hold (ns)";
+            break;
+        case METRIC_HISTOGRAM_EGRESS_QUEUE_DEPTH:
+            pRet = "Egress Queue Depth (frames)";
+            break;
+        case METRIC_HISTOGRAM_EGRESS_DROPPED_FRAMES:
+            pRet = "Egress Dropped Frames Per Session";
+            break;
+        case METRIC_HISTOGRAM_VIDEO_RESYNC_DROPPED_FRAMES:
+            pRet = "Video Resync Dropped Frames Per Session";
+            break;
+        case METRIC_HISTOGRAM_HTTP_CONNECT:
+            pRet = "HTTP Connect And TLS Handshake (us)";
+            break;
+        case METRIC_HISTOGRAM_HTTP_TIME_TO_FIRST_BYTE:
+            pRet = "HTTP Time To First Byte (us)";
+            break;
+        case METRIC_HISTOGRAM_HTTP_TOTAL:
+            pRet = "HTTP Request Total (us)";
+            break;
+        case METRIC_HISTOGRAM_HTTP_CONNECTION_REUSED:
+            pRet = "HTTP Connection Reused";
+            break;
+        case METRIC_HISTOGRAM_SIGNALING_RECONNECT:
+            pRet = "Signaling Reconnect (us)";
+            break;
+        case METRIC_HISTOGRAM_SIGNALING_RECONNECT_ATTEMPTS:
+            pRet = "Signaling Connect Attempts Per Reconnect";
+            break;
+        case METRIC_HISTOGRAM_SIGNALING_HELD_MESSAGES:
+            pRet = "Signaling Messages Held Per Reconnect";
+            break;
+        default:
+            pRet = "Unknown";
+            break;
+    }
+
+    return pRet;
+}
+
 static uint64_t CalculateEventDurationMs( uint64_t startTimeUs,
                                           uint64_t endTimeUs )
 {
@@ -149,6 +244,101 @@ void Metric_EndEvent( MetricEvent_t event )
     }
 }
 
+/* Must be called with mutex taken. */
+static void PrintHistogram( MetricHistogram_t histogram )
+{
+    MetricHistogramRecord_t * pRecord = &context.histogramRecords[ histogram ];
+    char bucketsBuffer[ 512 ];
+    int written = 0;
+    int i;
+
+    if( pRecord->count > 0U )
+    {
+        bucketsBuffer[ 0 ] = '\0';
+        for( i = 0; ( i < METRIC_HISTOGRAM_BUCKET_COUNT ) && ( written >= 0 ) && ( written < ( int ) sizeof( bucketsBuffer ) ); i++ )
+        {
+            if( pRecord->buckets[ i ] > 0U )
+            {
+                /* Print the exclusive upper bound of each non-empty bucket. */
+                written += snprintf( bucketsBuffer + written,
+                                     sizeof( bucketsBuffer ) - written,
+                                     " <%lu:%lu",
+                                     ( i == 0 ) ? 1UL : ( 1UL << i ),
+                                     pRecord->buckets[ i ] );
+            }
+        }
+
+        LogInfo( ( "Histogram of %s: count: %lu, avg: %lu, max: %lu, buckets:%s",
+                   ConvertHistogramToString( histogram ),
+                   pRecord->count,
+                   pRecord->sum / pRecord->count,
+                   pRecord->max,
+                   bucketsBuffer ) );
+    }
+}
+
+void Metric_AddHistogramSample( MetricHistogramRecord_t * pRecord,
+                                uint64_t value )
+{
+    uint32_t bucket = 0U;
+    uint64_t remaining = value;
+
+    if( pRecord != NULL )
+    {
+        while( ( remaining > 0U ) && ( bucket < METRIC_HISTOGRAM_BUCKET_COUNT - 1U ) )
+        {
+            remaining >>= 1;
+            bucket++;
+        }
+
+        pRecord->buckets[ bucket ]++;
+        pRecord->count++;
+        pRecord->sum += value;
+        if( value > pRecord->max )
+        {
+            pRecord->max = value;
+        }
+    }
+}
+
+void Metric_RecordHistogram( MetricHistogram_t histogram,
+                             uint64_t value )
+{
+    if( ( context.isInit == 1U ) && ( histogram < METRIC_HISTOGRAM_MAX ) &&
+        ( pthread_mutex_lock( &( context.mutex ) ) == 0 ) )
+    {
+        Metric_AddHistogramSample( &context.histogramRecords[ histogram ], value );
+
+        pthread_mutex_unlock( &( context.mutex ) );
+    }
+}
+
+void Metric_MergeHistogram( MetricHistogram_t histogram,
+                            const MetricHistogramRecord_t * pRecord )
+{
+    int i;
+    MetricHistogramRecord_t * pTarget;
+
+    if( ( context.isInit == 1U ) && ( histogram < METRIC_HISTOGRAM_MAX ) && ( pRecord != NULL ) &&
+        ( pthread_mutex_lock( &( context.mutex ) ) == 0 ) )
+    {
+        pTarget = &context.histogramRecords[ histogram ];
+
+        for( i = 0; i < METRIC_HISTOGRAM_BUCKET_COUNT; i++ )
+        {
+            pTarget->buckets[ i ] += pRecord->buckets[ i ];
+        }
+        pTarget->count += pRecord->count;
+        pTarget->sum += pRecord->sum;
+        if( pRecord->max > pTarget->max )
+        {
+            pTarget->max = pRecord->max;
+        }
+
+        pthread_mutex_unlock( &( context.mutex ) );
+    }
+}
+
 void Metric_PrintMetrics( void )
 {
     int i;
@@ -171,6 +361,11 @@ void Metric_PrintMetrics( void )
             }
         }
 
+        for( i = 0; i < METRIC_HISTOGRAM_MAX; i++ )
+        {
+            PrintHistogram( ( MetricHistogram_t ) i );
+        }
+
         //LogInfo( ( "Remaining free heap size: %u", xPortGetFreeHeapSize() ) );
 
         // vTaskGetRunTimeStats( runTimeStatsBuffer );
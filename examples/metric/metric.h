@@ -56,6 +56,68 @@ typedef enum MetricEvent
     METRIC_EVENT_MAX,
 } MetricEvent_t;
 
+/* Histograms aggregate samples of every session, they're not cleared by Metric_ResetEvent. */
+typedef enum MetricHistogram
+{
+    /* Time from sending a DTLS flight to receiving the next flight from peer, in us. */
+    METRIC_HISTOGRAM_DTLS_FLIGHT_DURATION = 0,
+    /* Number of retransmitted DTLS flights per handshake. */
+    METRIC_HISTOGRAM_DTLS_RETRANSMISSIONS,
+    /* CPU time per DTLS handshake step, in us. */
+    METRIC_HISTOGRAM_DTLS_CPU_HELLO,
+    METRIC_HISTOGRAM_DTLS_CPU_KEY_EXCHANGE,
+    METRIC_HISTOGRAM_DTLS_CPU_CERTIFICATE_VERIFY,
+    METRIC_HISTOGRAM_DTLS_CPU_FINISHED,
+    /* Time to verify remote certificate fingerprint, in us. */
+    METRIC_HISTOGRAM_DTLS_VERIFY_FINGERPRINT,
+    /* Time to export keying material and create SRTP sessions, in us. */
+    METRIC_HISTOGRAM_DTLS_SRTP_SETUP,
+    /* Time waiting for each SRTP path lock in ns, uncontended acquisitions count as 0. */
+    METRIC_HISTOGRAM_SRTP_RTP_TX_LOCK_WAIT,
+    METRIC_HISTOGRAM_SRTP_RTP_RX_LOCK_WAIT,
+    METRIC_HISTOGRAM_SRTP_RTCP_TX_LOCK_WAIT,
+    METRIC_HISTOGRAM_SRTP_RTCP_RX_LOCK_WAIT,
+    /* Time holding each SRTP path lock in ns. */
+    METRIC_HISTOGRAM_SRTP_RTP_TX_LOCK_HOLD,
+    METRIC_HISTOGRAM_SRTP_RTP_RX_LOCK_HOLD,
+    METRIC_HISTOGRAM_SRTP_RTCP_TX_LOCK_HOLD,
+    METRIC_HISTOGRAM_SRTP_RTCP_RX_LOCK_HOLD,
+    /* Depth of viewer egress queue sampled on every frame pushed. */
+    METRIC_HISTOGRAM_EGRESS_QUEUE_DEPTH,
+    /* Number of frames dropped per viewer session by egress queue. */
+    METRIC_HISTOGRAM_EGRESS_DROPPED_FRAMES,
+    /* Number of video frames dropped per session while waiting for keyframe to resync. */
+    METRIC_HISTOGRAM_VIDEO_RESYNC_DROPPED_FRAMES,
+    /* Time to connect and finish TLS handshake for control plane HTTP requests
+     * which couldn't reuse a keep-alive connection, in us. */
+    METRIC_HISTOGRAM_HTTP_CONNECT,
+    /* Time from sending HTTP request headers to receiving the response headers, in us. */
+    METRIC_HISTOGRAM_HTTP_TIME_TO_FIRST_BYTE,
+    /* Total time per HTTP request, in us. */
+    METRIC_HISTOGRAM_HTTP_TOTAL,
+    /* 1 for HTTP requests sent on a reused keep-alive connection, 0 otherwise. */
+    METRIC_HISTOGRAM_HTTP_CONNECTION_REUSED,
+    /* Time from losing the signaling websocket to having it back, in us. */
+    METRIC_HISTOGRAM_SIGNALING_RECONNECT,
+    /* Number of connect attempts per signaling reconnect. */
+    METRIC_HISTOGRAM_SIGNALING_RECONNECT_ATTEMPTS,
+    /* Number of signaling messages held while the websocket was down, per reconnect. */
+    METRIC_HISTOGRAM_SIGNALING_HELD_MESSAGES,
+
+    METRIC_HISTOGRAM_MAX,
+} MetricHistogram_t;
+
+/* Bucket 0 counts value 0, bucket N counts values in [2^(N-1), 2^N), the last bucket counts the rest. */
+#define METRIC_HISTOGRAM_BUCKET_COUNT ( 24 )
+
+typedef struct MetricHistogramRecord
+{
+    uint64_t count;
+    uint64_t sum;
+    uint64_t max;
+    uint64_t buckets[ METRIC_HISTOGRAM_BUCKET_COUNT ];
+} MetricHistogramRecord_t;
+
 typedef enum MetricEventState
 {
     METRIC_EVENT_STATE_NONE = 0,
@@ -74,6 +136,7 @@ typedef struct MetricContext
 {
     uint8_t isInit;
     MetricEventRecord_t eventRecords[ METRIC_EVENT_MAX ];
+    MetricHistogramRecord_t histogramRecords[ METRIC_HISTOGRAM_MAX ];
     pthread_mutex_t mutex;
 } MetricContext_t;
 
@@ -82,6 +145,13 @@ void Metric_StartEvent( MetricEvent_t event );
 void Metric_EndEvent( MetricEvent_t event );
 void Metric_PrintMetrics( void );
 void Metric_ResetEvent( void );
+void Metric_RecordHistogram( MetricHistogram_t histogram,
+                             uint64_t value );
+/* Add a sample to a caller owned record without locking, merge it later by Metric_MergeHistogram. */
+void Metric_AddHistogramSample( MetricHistogramRecord_t * pRecord,
+                                uint64_t value );
+void Metric_MergeHistogram( MetricHistogram_t histogram,
+                            const MetricHistogramRecord_t * pRecord );
 
 /* *INDENT-OFF* */
 #ifdef __cplusplus
@@ -0,0 +1,261 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Local mock of the signaling service, for end-to-end runs of the master
+ * without network access.
+ *
+ * Serves DescribeSignalingChannel, GetSignalingChannelEndpoint,
+ * GetIceServerConfig, the IoT credentials provider and the signaling
+ * websocket over TLS, plus a STUN/TURN server on UDP that answers binding and
+ * allocation requests. Synthetic viewers send an SDP offer and a host
+ * candidate each, and the time to the SDP answer is reported. A GO_AWAY and a
+ * RECONNECT_ICE_SERVER can be injected to measure the reconnect path.
+ *
+ * Point the master at it with, in demo_config.h:
+ *   #define AWS_KVS_CONTROL_PLANE_ENDPOINT "https://127.0.0.1:8443"
+ *   #define AWS_CA_CERT_PATH "<the -c certificate>"
+ * and AWS_CREDENTIALS_ENDPOINT "127.0.0.1:8443" for IoT credentials.
+ *
+ * Usage: WebRTCLinuxMockSignalingServer -c cert.pem -k key.pem [-a host]
+ *            [-p port] [-s stun_turn_port] [-n viewers] [-i offer_interval_ms]
+ *            [-g go_away_after_sec] [-r reconnect_ice_server_after_sec]
+ *            [-t ice_server_ttl_sec] [-e credentials_ttl_sec] [-d duration_sec]
+ *
+ * Exits with 0 if every viewer got an answer before the duration ran out.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include "logging.h"
+#include "networking_utils.h"
+#include "mock_signaling_server.h"
+#include "mock_stun_turn_server.h"
+
+#define MOCK_SERVER_DEFAULT_HOST                    "127.0.0.1"
+#define MOCK_SERVER_DEFAULT_PORT                    ( 8443 )
+#define MOCK_SERVER_DEFAULT_STUN_TURN_PORT          ( 3478 )
+#define MOCK_SERVER_DEFAULT_TURN_PASSWORD           "mock-turn-password"
+#define MOCK_SERVER_DEFAULT_VIEWERS                 ( 1 )
+#define MOCK_SERVER_DEFAULT_OFFER_INTERVAL_MS       ( 100 )
+#define MOCK_SERVER_DEFAULT_ICE_SERVER_TTL_SEC      ( 300 )
+#define MOCK_SERVER_DEFAULT_CREDENTIALS_TTL_SEC     ( 3600 )
+#define MOCK_SERVER_DEFAULT_DURATION_SEC            ( 60 )
+#define MOCK_SERVER_STATS_PERIOD_SEC                ( 5 )
+
+static volatile sig_atomic_t isInterrupted = 0;
+
+/*----------------------------------------------------------------------------*/
+
+static void HandleSignal( int signal )
+{
+    ( void ) signal;
+    isInterrupted = 1;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static void PrintStats( MockSignalingServerContext_t * pSignalingCtx,
+                        MockStunTurnServerContext_t * pStunTurnCtx )
+{
+    MockSignalingServerStats_t signalingStats;
+    MockStunTurnServerStats_t stunTurnStats;
+
+    MockSignalingServer_GetStats( pSignalingCtx, &( signalingStats ) );
+    MockStunTurnServer_GetStats( pStunTurnCtx, &( stunTurnStats ) );
+
+    printf( "http: %u (describe %u, endpoint %u, ice config %u, credentials %u), "
+            "ws connections: %u, reconnects: %u (last %lu us)\n",
+            signalingStats.httpRequests,
+            signalingStats.describeChannelRequests,
+            signalingStats.getEndpointRequests,
+            signalingStats.getIceServerConfigRequests,
+            signalingStats.credentialsRequests,
+            signalingStats.websocketConnections,
+            signalingStats.reconnects,
+            signalingStats.lastReconnectLatencyUs );
+    printf( "offers: %u, answers: %u, answer latency min/avg/max: %lu/%lu/%lu us, "
+            "candidates sent/received: %u/%u, go away: %u, reconnect ice server: %u\n",
+            signalingStats.offersSent,
+            signalingStats.answersReceived,
+            signalingStats.minAnswerLatencyUs,
+            signalingStats.answersReceived > 0U ? signalingStats.totalAnswerLatencyUs / signalingStats.answersReceived : 0U,
+            signalingStats.maxAnswerLatencyUs,
+            signalingStats.candidatesSent,
+            signalingStats.candidatesReceived,
+            signalingStats.goAwaysSent,
+            signalingStats.reconnectIceServersSent );
+    printf( "stun binding: %u, turn allocate/refresh/permission/channel bind: %u/%u/%u/%u, "
+            "401: %u, integrity failures: %u, dropped data: %u, allocations: %u\n",
+            stunTurnStats.bindingRequests,
+            stunTurnStats.allocateRequests,
+            stunTurnStats.refreshRequests,
+            stunTurnStats.createPermissionRequests,
+            stunTurnStats.channelBindRequests,
+            stunTurnStats.unauthorizedResponses,
+            stunTurnStats.integrityFailures,
+            stunTurnStats.dataPackets,
+            stunTurnStats.activeAllocations );
+}
+
+/*----------------------------------------------------------------------------*/
+
+int main( int argc,
+          char * argv[] )
+{
+    int ret = 0, option;
+    uint32_t durationSec = MOCK_SERVER_DEFAULT_DURATION_SEC;
+    uint64_t startTimeSec, currentTimeSec, lastStatsTimeSec;
+    uint8_t isStunTurnStarted = 0U, isSignalingStarted = 0U;
+    MockSignalingServerConfig_t config;
+    static MockSignalingServerContext_t signalingCtx;
+    static MockStunTurnServerContext_t stunTurnCtx;
+
+    memset( &( config ), 0, sizeof( MockSignalingServerConfig_t ) );
+    config.pHost = MOCK_SERVER_DEFAULT_HOST;
+    config.port = MOCK_SERVER_DEFAULT_PORT;
+    config.stunTurnPort = MOCK_SERVER_DEFAULT_STUN_TURN_PORT;
+    config.pTurnPassword = MOCK_SERVER_DEFAULT_TURN_PASSWORD;
+    config.iceServerTtlSec = MOCK_SERVER_DEFAULT_ICE_SERVER_TTL_SEC;
+    config.credentialsTtlSec = MOCK_SERVER_DEFAULT_CREDENTIALS_TTL_SEC;
+    config.viewerCount = MOCK_SERVER_DEFAULT_VIEWERS;
+    config.offerIntervalMs = MOCK_SERVER_DEFAULT_OFFER_INTERVAL_MS;
+
+    while( ( option = getopt( argc, argv, "a:p:c:k:s:n:i:g:r:t:e:d:" ) ) != -1 )
+    {
+        switch( option )
+        {
+            case 'a':
+                config.pHost = optarg;
+                break;
+            case 'p':
+                config.port = ( uint16_t ) strtoul( optarg, NULL, 10 );
+                break;
+            case 'c':
+                config.pCertPath = optarg;
+                break;
+            case 'k':
+                config.pKeyPath = optarg;
+                break;
+            case 's':
+                config.stunTurnPort = ( uint16_t ) strtoul( optarg, NULL, 10 );
+                break;
+            case 'n':
+                config.viewerCount = ( uint32_t ) strtoul( optarg, NULL, 10 );
+                break;
+            case 'i':
+                config.offerIntervalMs = ( uint32_t ) strtoul( optarg, NULL, 10 );
+                break;
+            case 'g':
+                config.goAwayAfterSec = ( uint32_t ) strtoul( optarg, NULL, 10 );
+                break;
+            case 'r':
+                config.reconnectIceServerAfterSec = ( uint32_t ) strtoul( optarg, NULL, 10 );
+                break;
+            case 't':
+                config.iceServerTtlSec = ( uint32_t ) strtoul( optarg, NULL, 10 );
+                break;
+            case 'e':
+                config.credentialsTtlSec = ( uint32_t ) strtoul( optarg, NULL, 10 );
+                break;
+            case 'd':
+                durationSec = ( uint32_t ) strtoul( optarg, NULL, 10 );
+                break;
+            default:
+                printf( "Usage: %s -c cert.pem -k key.pem [-a host] [-p port] [-s stun_turn_port] [-n viewers] "
+                        "[-i offer_interval_ms] [-g go_away_after_sec] [-r reconnect_ice_server_after_sec] "
+                        "[-t ice_server_ttl_sec] [-e credentials_ttl_sec] [-d duration_sec]\n",
+                        argv[ 0 ] );
+                ret = -1;
+                break;
+        }
+    }
+
+    if( ( ret == 0 ) && ( ( config.pCertPath == NULL ) || ( config.pKeyPath == NULL ) ) )
+    {
+        printf( "The TLS certificate (-c) and key (-k) are required\n" );
+        ret = -1;
+    }
+
+    if( ( ret == 0 ) && ( ( config.viewerCount == 0U ) || ( config.viewerCount > MOCK_SIGNALING_SERVER_MAX_VIEWERS ) ) )
+    {
+        printf( "Viewers must be between 1 and %d\n", MOCK_SIGNALING_SERVER_MAX_VIEWERS );
+        ret = -1;
+    }
+
+    if( ret == 0 )
+    {
+        signal( SIGINT, HandleSignal );
+        signal( SIGTERM, HandleSignal );
+
+        ret = MockStunTurnServer_Start( &( stunTurnCtx ), config.pHost, config.stunTurnPort, config.pTurnPassword );
+        isStunTurnStarted = ( ret == 0 ) ? 1U : 0U;
+    }
+
+    if( ret == 0 )
+    {
+        ret = MockSignalingServer_Start( &( signalingCtx ), &( config ) );
+        isSignalingStarted = ( ret == 0 ) ? 1U : 0U;
+    }
+
+    if( ret == 0 )
+    {
+        startTimeSec = NetworkingUtils_GetCurrentTimeSec( NULL );
+        lastStatsTimeSec = startTimeSec;
+
+        while( isInterrupted == 0 )
+        {
+            sleep( 1 );
+            currentTimeSec = NetworkingUtils_GetCurrentTimeSec( NULL );
+
+            if( currentTimeSec - lastStatsTimeSec >= MOCK_SERVER_STATS_PERIOD_SEC )
+            {
+                PrintStats( &( signalingCtx ), &( stunTurnCtx ) );
+                lastStatsTimeSec = currentTimeSec;
+            }
+
+            if( ( durationSec > 0U ) && ( currentTimeSec - startTimeSec >= durationSec ) )
+            {
+                break;
+            }
+        }
+
+        PrintStats( &( signalingCtx ), &( stunTurnCtx ) );
+
+        if( MockSignalingServer_IsAllAnswered( &( signalingCtx ) ) == 0 )
+        {
+            printf( "Not every viewer got an answer\n" );
+            ret = -1;
+        }
+    }
+
+    if( isSignalingStarted != 0U )
+    {
+        MockSignalingServer_Stop( &( signalingCtx ) );
+    }
+
+    if( isStunTurnStarted != 0U )
+    {
+        MockStunTurnServer_Stop( &( stunTurnCtx ) );
+    }
+
+    return ( ret == 0 ) ? 0 : 1;
+}
@@ -0,0 +1,921 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "logging.h"
+#include "base64.h"
+#include "core_json.h"
+#include "networking_utils.h"
+#include "mock_signaling_server.h"
+
+/*----------------------------------------------------------------------------*/
+
+#define MOCK_SIGNALING_SERVER_SCHEDULER_PERIOD_US       ( 10 * 1000 )
+#define MOCK_SIGNALING_SERVER_ISO8601_TIME_LENGTH       ( 20 )
+
+#define MOCK_SIGNALING_SERVER_PATH_DESCRIBE_CHANNEL     "/describeSignalingChannel"
+#define MOCK_SIGNALING_SERVER_PATH_GET_ENDPOINT         "/getSignalingChannelEndpoint"
+#define MOCK_SIGNALING_SERVER_PATH_GET_ICE_CONFIG       "/v1/get-ice-server-config"
+#define MOCK_SIGNALING_SERVER_PATH_JOIN_SESSION         "/joinStorageSession"
+#define MOCK_SIGNALING_SERVER_PATH_ROLE_ALIASES         "/role-aliases/"
+
+#define MOCK_SIGNALING_SERVER_EMPTY_PAYLOAD             "e30="
+
+/* A browser like offer, with audio and video bundled on one transport. The
+ * viewer index keeps the ICE credentials of the viewers apart. */
+#define MOCK_SIGNALING_SERVER_SDP_OFFER_TEMPLATE                                                                        \
+    "{\"type\":\"offer\",\"sdp\":\""                                                                                \
+    "v=0\\r\\n"                                                                                                     \
+    "o=- 4611731400430051%04u 2 IN IP4 127.0.0.1\\r\\n"                                                             \
+    "s=-\\r\\n"                                                                                                     \
+    "t=0 0\\r\\n"                                                                                                   \
+    "a=group:BUNDLE 0 1\\r\\n"                                                                                      \
+    "a=extmap-allow-mixed\\r\\n"                                                                                    \
+    "a=msid-semantic: WMS\\r\\n"                                                                                    \
+    "m=audio 9 UDP/TLS/RTP/SAVPF 111\\r\\n"                                                                         \
+    "c=IN IP4 0.0.0.0\\r\\n"                                                                                        \
+    "a=rtcp:9 IN IP4 0.0.0.0\\r\\n"                                                                                 \
+    "a=ice-ufrag:mv%04u\\r\\n"                                                                                      \
+    "a=ice-pwd:mockviewerpassword%06u\\r\\n"                                                                        \
+    "a=ice-options:trickle\\r\\n"                                                                                   \
+    "a=fingerprint:sha-256 "                                                                                        \
+    "5C:2E:3A:9B:1D:7F:60:44:8E:0A:F3:12:C9:B5:6D:71:2F:E8:90:4A:1C:D3:77:05:BB:36:E2:58:09:AF:14:C6\\r\\n"             \
+    "a=setup:actpass\\r\\n"                                                                                         \
+    "a=mid:0\\r\\n"                                                                                                 \
+    "a=sendrecv\\r\\n"                                                                                              \
+    "a=rtcp-mux\\r\\n"                                                                                              \
+    "a=rtpmap:111 opus/48000/2\\r\\n"                                                                               \
+    "a=rtcp-fb:111 transport-cc\\r\\n"                                                                              \
+    "a=fmtp:111 minptime=10;useinbandfec=1\\r\\n"                                                                   \
+    "a=ssrc:1000%04u cname:mockviewer\\r\\n"                                                                        \
+    "m=video 9 UDP/TLS/RTP/SAVPF 125\\r\\n"                                                                         \
+    "c=IN IP4 0.0.0.0\\r\\n"                                                                                        \
+    "a=rtcp:9 IN IP4 0.0.0.0\\r\\n"                                                                                 \
+    "a=ice-ufrag:mv%04u\\r\\n"                                                                                      \
+    "a=ice-pwd:mockviewerpassword%06u\\r\\n"                                                                        \
+    "a=ice-options:trickle\\r\\n"                                                                                   \
+    "a=fingerprint:sha-256 "                                                                                        \
+    "5C:2E:3A:9B:1D:7F:60:44:8E:0A:F3:12:C9:B5:6D:71:2F:E8:90:4A:1C:D3:77:05:BB:36:E2:58:09:AF:14:C6\\r\\n"             \
+    "a=setup:actpass\\r\\n"                                                                                         \
+    "a=mid:1\\r\\n"                                                                                                 \
+    "a=sendrecv\\r\\n"                                                                                              \
+    "a=rtcp-mux\\r\\n"                                                                                              \
+    "a=rtcp-rsize\\r\\n"                                                                                            \
+    "a=rtpmap:125 H264/90000\\r\\n"                                                                                 \
+    "a=rtcp-fb:125 goog-remb\\r\\n"                                                                                 \
+    "a=rtcp-fb:125 transport-cc\\r\\n"                                                                              \
+    "a=rtcp-fb:125 ccm fir\\r\\n"                                                                                   \
+    "a=rtcp-fb:125 nack\\r\\n"                                                                                      \
+    "a=rtcp-fb:125 nack pli\\r\\n"                                                                                  \
+    "a=fmtp:125 level-asymmetry-allowed=1;packetization-mode=1;profile-level-id=42e01f\\r\\n"                       \
+    "a=ssrc:2000%04u cname:mockviewer\\r\\n"                                                                        \
+    "\"}"
+
+#define MOCK_SIGNALING_SERVER_CANDIDATE_TEMPLATE \
+    "{\"candidate\":\"candidate:1 1 udp 2130706431 %s %u typ host\",\"sdpMid\":\"0\",\"sdpMLineIndex\":0}"
+
+/* Host candidates of the viewers, nothing listens there. */
+#define MOCK_SIGNALING_SERVER_VIEWER_BASE_PORT          ( 60000 )
+
+#define MOCK_SIGNALING_SERVER_MESSAGE_TEMPLATE \
+    "{\"messageType\":\"%s\",\"senderClientId\":\"%s\",\"messagePayload\":\"%.*s\"}"
+
+typedef struct MockSignalingSession
+{
+    char path[ MOCK_SIGNALING_SERVER_PATH_MAX_LENGTH ];
+    char body[ MOCK_SIGNALING_SERVER_BODY_MAX_LENGTH ];
+    size_t bodyLength;
+    uint8_t response[ LWS_PRE + MOCK_SIGNALING_SERVER_RESPONSE_MAX_LENGTH ];
+    size_t responseLength;
+    char message[ MOCK_SIGNALING_SERVER_MESSAGE_MAX_LENGTH ];
+    size_t messageLength;
+} MockSignalingSession_t;
+
+/*----------------------------------------------------------------------------*/
+
+static MockSignalingServerContext_t * GetContext( struct lws * pWsi )
+{
+    return ( MockSignalingServerContext_t * ) lws_context_user( lws_get_context( pWsi ) );
+}
+
+/*----------------------------------------------------------------------------*/
+
+static void GetIso8601Time( uint64_t timeSec,
+                            char * pBuffer,
+                            size_t bufferLength )
+{
+    time_t t = ( time_t ) timeSec;
+    struct tm utcTime;
+
+    ( void ) strftime( pBuffer, bufferLength, "%Y-%m-%dT%H:%M:%SZ", gmtime_r( &( t ), &( utcTime ) ) );
+}
+
+/*----------------------------------------------------------------------------*/
+
+static int BuildHttpResponse( MockSignalingServerContext_t * pCtx,
+                              MockSignalingSession_t * pSession )
+{
+    int ret = 0, written = -1;
+    char * pResponse = ( char * ) &( pSession->response[ LWS_PRE ] );
+    char * pChannelName = NULL;
+    size_t channelNameLength = 0;
+    char expiration[ MOCK_SIGNALING_SERVER_ISO8601_TIME_LENGTH + 1 ];
+    uint64_t currentTimeSec = NetworkingUtils_GetCurrentTimeSec( NULL );
+    const MockSignalingServerConfig_t * pConfig = &( pCtx->config );
+
+    pthread_mutex_lock( &( pCtx->mutex ) );
+    {
+        pCtx->stats.httpRequests++;
+    }
+    pthread_mutex_unlock( &( pCtx->mutex ) );
+
+    if( strcmp( pSession->path, MOCK_SIGNALING_SERVER_PATH_DESCRIBE_CHANNEL ) == 0 )
+    {
+        if( JSON_Search( pSession->body,
+                         pSession->bodyLength,
+                         "ChannelName",
+                         strlen( "ChannelName" ),
+                         &( pChannelName ),
+                         &( channelNameLength ) ) != JSONSuccess )
+        {
+            pChannelName = "mock-channel";
+            channelNameLength = strlen( pChannelName );
+        }
+
+        written = snprintf( pResponse,
+                            MOCK_SIGNALING_SERVER_RESPONSE_MAX_LENGTH,
+                            "{\"ChannelInfo\":{\"ChannelARN\":\"" MOCK_SIGNALING_SERVER_CHANNEL_ARN_PREFIX "%.*s/1700000000000\","
+                            "\"ChannelName\":\"%.*s\",\"ChannelStatus\":\"ACTIVE\",\"ChannelType\":\"SINGLE_MASTER\","
+                            "\"CreationTime\":1700000000.0,\"SingleMasterConfiguration\":{\"MessageTtlSeconds\":60},"
+                            "\"Version\":\"mock\"}}",
+                            ( int ) channelNameLength,
+                            pChannelName,
+                            ( int ) channelNameLength,
+                            pChannelName );
+
+        pthread_mutex_lock( &( pCtx->mutex ) );
+        {
+            pCtx->stats.describeChannelRequests++;
+        }
+        pthread_mutex_unlock( &( pCtx->mutex ) );
+    }
+    else if( strcmp( pSession->path, MOCK_SIGNALING_SERVER_PATH_GET_ENDPOINT ) == 0 )
+    {
+        written = snprintf( pResponse,
+                            MOCK_SIGNALING_SERVER_RESPONSE_MAX_LENGTH,
+                            "{\"ResourceEndpointList\":["
+                            "{\"Protocol\":\"HTTPS\",\"ResourceEndpoint\":\"https://%s:%u\"},"
+                            "{\"Protocol\":\"WSS\",\"ResourceEndpoint\":\"wss://%s:%u\"},"
+                            "{\"Protocol\":\"WEBRTC\",\"ResourceEndpoint\":\"https://%s:%u\"}]}",
+                            pConfig->pHost,
+                            pConfig->port,
+                            pConfig->pHost,
+                            pConfig->port,
+                            pConfig->pHost,
+                            pConfig->port );
+
+        pthread_mutex_lock( &( pCtx->mutex ) );
+        {
+            pCtx->stats.getEndpointRequests++;
+        }
+        pthread_mutex_unlock( &( pCtx->mutex ) );
+    }
+    else if( strcmp( pSession->path, MOCK_SIGNALING_SERVER_PATH_GET_ICE_CONFIG ) == 0 )
+    {
+        written = snprintf( pResponse,
+                            MOCK_SIGNALING_SERVER_RESPONSE_MAX_LENGTH,
+                            "{\"IceServerList\":[{\"Password\":\"%s\",\"Ttl\":%u,"
+                            "\"Uris\":[\"turn:%s:%u?transport=udp\"],\"Username\":\"%lu:mock-master\"}]}",
+                            pConfig->pTurnPassword,
+                            pConfig->iceServerTtlSec,
+                            pConfig->pHost,
+                            pConfig->stunTurnPort,
+                            currentTimeSec + pConfig->iceServerTtlSec );
+
+        pthread_mutex_lock( &( pCtx->mutex ) );
+        {
+            pCtx->stats.getIceServerConfigRequests++;
+        }
+        pthread_mutex_unlock( &( pCtx->mutex ) );
+    }
+    else if( strcmp( pSession->path, MOCK_SIGNALING_SERVER_PATH_JOIN_SESSION ) == 0 )
+    {
+        written = snprintf( pResponse, MOCK_SIGNALING_SERVER_RESPONSE_MAX_LENGTH, "{}" );
+    }
+    else if( strncmp( pSession->path, MOCK_SIGNALING_SERVER_PATH_ROLE_ALIASES, strlen( MOCK_SIGNALING_SERVER_PATH_ROLE_ALIASES ) ) == 0 )
+    {
+        GetIso8601Time( currentTimeSec + pConfig->credentialsTtlSec, expiration, sizeof( expiration ) );
+
+        written = snprintf( pResponse,
+                            MOCK_SIGNALING_SERVER_RESPONSE_MAX_LENGTH,
+                            "{\"credentials\":{\"accessKeyId\":\"AKIDMOCKSIGNALING\","
+                            "\"secretAccessKey\":\"mockSecretAccessKeyForLocalSignalingOnly\","
+                            "\"sessionToken\":\"mockSessionToken%lu\",\"expiration\":\"%s\"}}",
+                            currentTimeSec,
+                            expiration );
+
+        pthread_mutex_lock( &( pCtx->mutex ) );
+        {
+            pCtx->stats.credentialsRequests++;
+        }
+        pthread_mutex_unlock( &( pCtx->mutex ) );
+    }
+    else
+    {
+        LogWarn( ( "Unknown path: %s", pSession->path ) );
+        ret = -1;
+    }
+
+    if( ret == 0 )
+    {
+        if( ( written < 0 ) || ( written >= MOCK_SIGNALING_SERVER_RESPONSE_MAX_LENGTH ) )
+        {
+            LogError( ( "Response of %s does not fit, written: %d", pSession->path, written ) );
+            ret = -1;
+        }
+        else
+        {
+            pSession->responseLength = ( size_t ) written;
+        }
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static int SendHttpResponse( MockSignalingServerContext_t * pCtx,
+                             struct lws * pWsi,
+                             MockSignalingSession_t * pSession )
+{
+    int ret = 0;
+    unsigned int status = HTTP_STATUS_OK;
+    uint8_t headers[ LWS_PRE + 512 ];
+    uint8_t * pStart = &( headers[ LWS_PRE ] );
+    uint8_t * pCurrent = pStart;
+    uint8_t * pEnd = &( headers[ sizeof( headers ) - 1 ] );
+
+    if( BuildHttpResponse( pCtx, pSession ) != 0 )
+    {
+        status = HTTP_STATUS_NOT_FOUND;
+        pSession->responseLength = 0;
+    }
+
+    if( ( lws_add_http_common_headers( pWsi, status, "application/json", pSession->responseLength, &( pCurrent ), pEnd ) != 0 ) ||
+        ( lws_finalize_write_http_header( pWsi, pStart, &( pCurrent ), pEnd ) != 0 ) )
+    {
+        LogError( ( "Fail to write the HTTP headers of %s.", pSession->path ) );
+        ret = -1;
+    }
+    else
+    {
+        lws_callback_on_writable( pWsi );
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+/* Must be called with the mutex held. */
+static void EnqueueMessage( MockSignalingServerContext_t * pCtx,
+                            const char * pMessageType,
+                            const char * pSenderClientId,
+                            const char * pPayload,
+                            size_t payloadLength )
+{
+    char base64Payload[ MOCK_SIGNALING_SERVER_MESSAGE_MAX_LENGTH ];
+    size_t base64PayloadLength = sizeof( base64Payload );
+    char * pMessage = NULL;
+    int written = -1;
+
+    if( pPayload == NULL )
+    {
+        memcpy( base64Payload, MOCK_SIGNALING_SERVER_EMPTY_PAYLOAD, strlen( MOCK_SIGNALING_SERVER_EMPTY_PAYLOAD ) );
+        base64PayloadLength = strlen( MOCK_SIGNALING_SERVER_EMPTY_PAYLOAD );
+    }
+    else if( Base64_Encode( pPayload, payloadLength, base64Payload, &( base64PayloadLength ) ) != BASE64_RESULT_OK )
+    {
+        LogError( ( "Fail to encode the %s payload.", pMessageType ) );
+        base64PayloadLength = 0;
+    }
+    else
+    {
+        /* Empty else marker. */
+    }
+
+    if( ( base64PayloadLength > 0U ) && ( pCtx->queueCount < MOCK_SIGNALING_SERVER_MAX_QUEUED_MESSAGES ) )
+    {
+        pMessage = ( char * ) malloc( LWS_PRE + MOCK_SIGNALING_SERVER_MESSAGE_MAX_LENGTH );
+    }
+    else if( base64PayloadLength > 0U )
+    {
+        LogWarn( ( "Message queue is full, dropping %s.", pMessageType ) );
+    }
+    else
+    {
+        /* Empty else marker. */
+    }
+
+    if( pMessage != NULL )
+    {
+        written = snprintf( &( pMessage[ LWS_PRE ] ),
+                            MOCK_SIGNALING_SERVER_MESSAGE_MAX_LENGTH,
+                            MOCK_SIGNALING_SERVER_MESSAGE_TEMPLATE,
+                            pMessageType,
+                            pSenderClientId,
+                            ( int ) base64PayloadLength,
+                            base64Payload );
+
+        if( ( written < 0 ) || ( written >= MOCK_SIGNALING_SERVER_MESSAGE_MAX_LENGTH ) )
+        {
+            LogError( ( "%s message does not fit, written: %d", pMessageType, written ) );
+            free( pMessage );
+        }
+        else
+        {
+            pCtx->pQueuedMessages[ ( pCtx->queueHead + pCtx->queueCount ) % MOCK_SIGNALING_SERVER_MAX_QUEUED_MESSAGES ] = pMessage;
+            pCtx->queuedMessageLengths[ ( pCtx->queueHead + pCtx->queueCount ) % MOCK_SIGNALING_SERVER_MAX_QUEUED_MESSAGES ] = ( size_t ) written;
+            pCtx->queueCount++;
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+/* Must be called with the mutex held. */
+static void ClearQueue( MockSignalingServerContext_t * pCtx )
+{
+    while( pCtx->queueCount > 0U )
+    {
+        free( pCtx->pQueuedMessages[ pCtx->queueHead ] );
+        pCtx->pQueuedMessages[ pCtx->queueHead ] = NULL;
+        pCtx->queueHead = ( pCtx->queueHead + 1U ) % MOCK_SIGNALING_SERVER_MAX_QUEUED_MESSAGES;
+        pCtx->queueCount--;
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+/* Must be called with the mutex held. */
+static void SendOffer( MockSignalingServerContext_t * pCtx,
+                       uint32_t viewerIndex )
+{
+    char payload[ MOCK_SIGNALING_SERVER_MESSAGE_MAX_LENGTH / 2 ];
+    int written;
+    MockSignalingViewer_t * pViewer = &( pCtx->viewers[ viewerIndex ] );
+
+    written = snprintf( payload,
+                        sizeof( payload ),
+                        MOCK_SIGNALING_SERVER_SDP_OFFER_TEMPLATE,
+                        viewerIndex,
+                        viewerIndex,
+                        viewerIndex,
+                        viewerIndex,
+                        viewerIndex,
+                        viewerIndex,
+                        viewerIndex );
+
+    if( ( written > 0 ) && ( written < ( int ) sizeof( payload ) ) )
+    {
+        EnqueueMessage( pCtx, "SDP_OFFER", pViewer->clientId, payload, ( size_t ) written );
+        pViewer->offerSentTimeUs = NetworkingUtils_GetCurrentTimeUs( NULL );
+        pViewer->isOfferSent = 1U;
+        pCtx->stats.offersSent++;
+
+        written = snprintf( payload,
+                            sizeof( payload ),
+                            MOCK_SIGNALING_SERVER_CANDIDATE_TEMPLATE,
+                            pCtx->config.pHost,
+                            MOCK_SIGNALING_SERVER_VIEWER_BASE_PORT + viewerIndex );
+        EnqueueMessage( pCtx, "ICE_CANDIDATE", pViewer->clientId, payload, ( size_t ) written );
+        pCtx->stats.candidatesSent++;
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+static void HandleMasterMessage( MockSignalingServerContext_t * pCtx,
+                                 char * pMessage,
+                                 size_t messageLength )
+{
+    char * pAction = NULL, * pRecipientClientId = NULL;
+    size_t actionLength = 0, recipientClientIdLength = 0;
+    uint64_t latencyUs;
+    uint32_t i;
+
+    if( ( JSON_Search( pMessage, messageLength, "action", strlen( "action" ), &( pAction ), &( actionLength ) ) != JSONSuccess ) ||
+        ( JSON_Search( pMessage, messageLength, "RecipientClientId", strlen( "RecipientClientId" ), &( pRecipientClientId ), &( recipientClientIdLength ) ) != JSONSuccess ) )
+    {
+        LogWarn( ( "Unexpected message from master: %.*s", ( int ) messageLength, pMessage ) );
+    }
+    else if( ( actionLength == strlen( "SDP_ANSWER" ) ) && ( strncmp( pAction, "SDP_ANSWER", actionLength ) == 0 ) )
+    {
+        pthread_mutex_lock( &( pCtx->mutex ) );
+        {
+            for( i = 0; i < pCtx->config.viewerCount; i++ )
+            {
+                if( ( strlen( pCtx->viewers[ i ].clientId ) == recipientClientIdLength ) &&
+                    ( strncmp( pCtx->viewers[ i ].clientId, pRecipientClientId, recipientClientIdLength ) == 0 ) )
+                {
+                    break;
+                }
+            }
+
+            if( ( i < pCtx->config.viewerCount ) && ( pCtx->viewers[ i ].isOfferSent != 0U ) && ( pCtx->viewers[ i ].isAnswered == 0U ) )
+            {
+                latencyUs = NetworkingUtils_GetCurrentTimeUs( NULL ) - pCtx->viewers[ i ].offerSentTimeUs;
+                pCtx->viewers[ i ].isAnswered = 1U;
+
+                pCtx->stats.answersReceived++;
+                pCtx->stats.totalAnswerLatencyUs += latencyUs;
+                if( ( pCtx->stats.minAnswerLatencyUs == 0U ) || ( latencyUs < pCtx->stats.minAnswerLatencyUs ) )
+                {
+                    pCtx->stats.minAnswerLatencyUs = latencyUs;
+                }
+                if( latencyUs > pCtx->stats.maxAnswerLatencyUs )
+                {
+                    pCtx->stats.maxAnswerLatencyUs = latencyUs;
+                }
+
+                LogInfo( ( "Answer to %s after %lu us.", pCtx->viewers[ i ].clientId, latencyUs ) );
+            }
+        }
+        pthread_mutex_unlock( &( pCtx->mutex ) );
+    }
+    else if( ( actionLength == strlen( "ICE_CANDIDATE" ) ) && ( strncmp( pAction, "ICE_CANDIDATE", actionLength ) == 0 ) )
+    {
+        pthread_mutex_lock( &( pCtx->mutex ) );
+        {
+            pCtx->stats.candidatesReceived++;
+        }
+        pthread_mutex_unlock( &( pCtx->mutex ) );
+    }
+    else
+    {
+        LogDebug( ( "Ignoring %.*s from master.", ( int ) actionLength, pAction ) );
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+static int WriteQueuedMessage( MockSignalingServerContext_t * pCtx,
+                               struct lws * pWsi )
+{
+    int ret = 0;
+    char * pMessage = NULL;
+    size_t messageLength = 0;
+    uint8_t hasMore = 0U;
+
+    pthread_mutex_lock( &( pCtx->mutex ) );
+    {
+        if( ( pWsi == pCtx->pMasterWsi ) && ( pCtx->queueCount > 0U ) )
+        {
+            pMessage = pCtx->pQueuedMessages[ pCtx->queueHead ];
+            messageLength = pCtx->queuedMessageLengths[ pCtx->queueHead ];
+            pCtx->pQueuedMessages[ pCtx->queueHead ] = NULL;
+            pCtx->queueHead = ( pCtx->queueHead + 1U ) % MOCK_SIGNALING_SERVER_MAX_QUEUED_MESSAGES;
+            pCtx->queueCount--;
+            hasMore = pCtx->queueCount > 0U ? 1U : 0U;
+        }
+    }
+    pthread_mutex_unlock( &( pCtx->mutex ) );
+
+    if( pMessage != NULL )
+    {
+        if( lws_write( pWsi, ( unsigned char * ) &( pMessage[ LWS_PRE ] ), messageLength, LWS_WRITE_TEXT ) < ( int ) messageLength )
+        {
+            LogError( ( "lws_write failed for the master." ) );
+            ret = -1;
+        }
+
+        free( pMessage );
+    }
+
+    if( ( ret == 0 ) && ( hasMore != 0U ) )
+    {
+        lws_callback_on_writable( pWsi );
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static int LwsCallback( struct lws * pWsi,
+                        enum lws_callback_reasons reason,
+                        void * pUser,
+                        void * pIn,
+                        size_t inLength )
+{
+    int ret = 0;
+    MockSignalingSession_t * pSession = ( MockSignalingSession_t * ) pUser;
+    MockSignalingServerContext_t * pCtx = GetContext( pWsi );
+    uint64_t currentTimeUs;
+    uint32_t i;
+
+    switch( reason )
+    {
+        case LWS_CALLBACK_HTTP:
+            snprintf( pSession->path, sizeof( pSession->path ), "%s", ( const char * ) pIn );
+            pSession->bodyLength = 0;
+            pSession->responseLength = 0;
+
+            /* GET requests carry no body, answer them now. */
+            if( lws_hdr_total_length( pWsi, WSI_TOKEN_POST_URI ) <= 0 )
+            {
+                ret = SendHttpResponse( pCtx, pWsi, pSession );
+            }
+            break;
+
+        case LWS_CALLBACK_HTTP_BODY:
+            if( pSession->bodyLength + inLength > sizeof( pSession->body ) )
+            {
+                LogError( ( "Body of %s is too large.", pSession->path ) );
+                ret = -1;
+            }
+            else
+            {
+                memcpy( &( pSession->body[ pSession->bodyLength ] ), pIn, inLength );
+                pSession->bodyLength += inLength;
+            }
+            break;
+
+        case LWS_CALLBACK_HTTP_BODY_COMPLETION:
+            ret = SendHttpResponse( pCtx, pWsi, pSession );
+            break;
+
+        case LWS_CALLBACK_HTTP_WRITEABLE:
+            if( ( pSession->responseLength > 0U ) &&
+                ( lws_write( pWsi, &( pSession->response[ LWS_PRE ] ), pSession->responseLength, LWS_WRITE_HTTP_FINAL ) < ( int ) pSession->responseLength ) )
+            {
+                ret = -1;
+            }
+            else if( lws_http_transaction_completed( pWsi ) != 0 )
+            {
+                ret = -1;
+            }
+            else
+            {
+                pSession->responseLength = 0;
+            }
+            break;
+
+        case LWS_CALLBACK_ESTABLISHED:
+            currentTimeUs = NetworkingUtils_GetCurrentTimeUs( NULL );
+            pSession->messageLength = 0;
+
+            pthread_mutex_lock( &( pCtx->mutex ) );
+            {
+                if( pCtx->pMasterWsi != NULL )
+                {
+                    LogWarn( ( "A second master connected, the first one stops getting offers." ) );
+                }
+
+                pCtx->pMasterWsi = pWsi;
+                pCtx->stats.websocketConnections++;
+
+                if( pCtx->firstConnectTimeUs == 0U )
+                {
+                    pCtx->firstConnectTimeUs = currentTimeUs;
+                }
+                else
+                {
+                    pCtx->stats.reconnects++;
+                    pCtx->stats.lastReconnectLatencyUs = currentTimeUs - pCtx->disconnectTimeUs;
+                    LogInfo( ( "Master reconnected after %lu us.", pCtx->stats.lastReconnectLatencyUs ) );
+                }
+            }
+            pthread_mutex_unlock( &( pCtx->mutex ) );
+            break;
+
+        case LWS_CALLBACK_CLOSED:
+            pthread_mutex_lock( &( pCtx->mutex ) );
+            {
+                if( pCtx->pMasterWsi == pWsi )
+                {
+                    pCtx->pMasterWsi = NULL;
+                    pCtx->disconnectTimeUs = NetworkingUtils_GetCurrentTimeUs( NULL );
+                    ClearQueue( pCtx );
+
+                    /* The peer connections of unanswered offers are gone with
+                     * the connection, offer them again after the reconnect. */
+                    for( i = 0; i < pCtx->config.viewerCount; i++ )
+                    {
+                        if( pCtx->viewers[ i ].isAnswered == 0U )
+                        {
+                            pCtx->viewers[ i ].isOfferSent = 0U;
+                        }
+                    }
+                }
+            }
+            pthread_mutex_unlock( &( pCtx->mutex ) );
+            break;
+
+        case LWS_CALLBACK_RECEIVE:
+            if( lws_is_first_fragment( pWsi ) )
+            {
+                pSession->messageLength = 0;
+            }
+
+            if( pSession->messageLength + inLength > sizeof( pSession->message ) )
+            {
+                LogError( ( "Message from master is too large." ) );
+                ret = -1;
+            }
+            else
+            {
+                memcpy( &( pSession->message[ pSession->messageLength ] ), pIn, inLength );
+                pSession->messageLength += inLength;
+
+                if( lws_is_final_fragment( pWsi ) && ( lws_remaining_packet_payload( pWsi ) == 0U ) )
+                {
+                    HandleMasterMessage( pCtx, pSession->message, pSession->messageLength );
+                    pSession->messageLength = 0;
+                }
+            }
+            break;
+
+        case LWS_CALLBACK_SERVER_WRITEABLE:
+            ret = WriteQueuedMessage( pCtx, pWsi );
+            break;
+
+        case LWS_CALLBACK_EVENT_WAIT_CANCELLED:
+            /* The scheduler queued messages, lws_callback_on_writable is only
+             * safe on the service thread. */
+            pthread_mutex_lock( &( pCtx->mutex ) );
+            {
+                if( ( pCtx->pMasterWsi != NULL ) && ( pCtx->queueCount > 0U ) )
+                {
+                    lws_callback_on_writable( pCtx->pMasterWsi );
+                }
+            }
+            pthread_mutex_unlock( &( pCtx->mutex ) );
+            break;
+
+        default:
+            ret = lws_callback_http_dummy( pWsi, reason, pUser, pIn, inLength );
+            break;
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static void * ServiceTask( void * pParameter )
+{
+    MockSignalingServerContext_t * pCtx = ( MockSignalingServerContext_t * ) pParameter;
+
+    while( __atomic_load_n( &( pCtx->isStopRequested ), __ATOMIC_ACQUIRE ) == 0U )
+    {
+        ( void ) lws_service( pCtx->pLwsContext, 0 );
+    }
+
+    return NULL;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static void * SchedulerTask( void * pParameter )
+{
+    MockSignalingServerContext_t * pCtx = ( MockSignalingServerContext_t * ) pParameter;
+    uint64_t currentTimeUs, nextOfferTimeUs = 0;
+    uint64_t offerIntervalUs = ( uint64_t ) pCtx->config.offerIntervalMs * 1000U;
+    uint8_t isQueued;
+    uint32_t i;
+
+    while( __atomic_load_n( &( pCtx->isStopRequested ), __ATOMIC_ACQUIRE ) == 0U )
+    {
+        usleep( MOCK_SIGNALING_SERVER_SCHEDULER_PERIOD_US );
+        currentTimeUs = NetworkingUtils_GetCurrentTimeUs( NULL );
+        isQueued = 0U;
+
+        pthread_mutex_lock( &( pCtx->mutex ) );
+        {
+            if( pCtx->pMasterWsi != NULL )
+            {
+                if( currentTimeUs >= nextOfferTimeUs )
+                {
+                    for( i = 0; i < pCtx->config.viewerCount; i++ )
+                    {
+                        if( pCtx->viewers[ i ].isOfferSent == 0U )
+                        {
+                            SendOffer( pCtx, i );
+                            nextOfferTimeUs = currentTimeUs + offerIntervalUs;
+                            isQueued = 1U;
+                            break;
+                        }
+                    }
+                }
+
+                if( ( pCtx->config.goAwayAfterSec > 0U ) &&
+                    ( pCtx->isGoAwaySent == 0U ) &&
+                    ( currentTimeUs - pCtx->firstConnectTimeUs >= ( uint64_t ) pCtx->config.goAwayAfterSec * 1000U * 1000U ) )
+                {
+                    EnqueueMessage( pCtx, "GO_AWAY", "", NULL, 0 );
+                    pCtx->isGoAwaySent = 1U;
+                    pCtx->stats.goAwaysSent++;
+                    isQueued = 1U;
+                }
+
+                if( ( pCtx->config.reconnectIceServerAfterSec > 0U ) &&
+                    ( pCtx->isReconnectIceServerSent == 0U ) &&
+                    ( currentTimeUs - pCtx->firstConnectTimeUs >= ( uint64_t ) pCtx->config.reconnectIceServerAfterSec * 1000U * 1000U ) )
+                {
+                    EnqueueMessage( pCtx, "RECONNECT_ICE_SERVER", "", NULL, 0 );
+                    pCtx->isReconnectIceServerSent = 1U;
+                    pCtx->stats.reconnectIceServersSent++;
+                    isQueued = 1U;
+                }
+            }
+        }
+        pthread_mutex_unlock( &( pCtx->mutex ) );
+
+        if( isQueued != 0U )
+        {
+            /* This will cause a LWS_CALLBACK_EVENT_WAIT_CANCELLED in the lws
+             * service thread. */
+            lws_cancel_service( pCtx->pLwsContext );
+        }
+    }
+
+    return NULL;
+}
+
+/*----------------------------------------------------------------------------*/
+
+int MockSignalingServer_Start( MockSignalingServerContext_t * pCtx,
+                               const MockSignalingServerConfig_t * pConfig )
+{
+    int ret = 0;
+    struct lws_context_creation_info creationInfo;
+    uint32_t i;
+
+    memset( pCtx, 0, sizeof( MockSignalingServerContext_t ) );
+    pCtx->config = *pConfig;
+
+    if( pCtx->config.viewerCount > MOCK_SIGNALING_SERVER_MAX_VIEWERS )
+    {
+        LogError( ( "At most %d viewers are supported.", MOCK_SIGNALING_SERVER_MAX_VIEWERS ) );
+        ret = -1;
+    }
+
+    if( ret == 0 )
+    {
+        for( i = 0; i < pCtx->config.viewerCount; i++ )
+        {
+            snprintf( pCtx->viewers[ i ].clientId, sizeof( pCtx->viewers[ i ].clientId ), "viewer-%u", i );
+        }
+
+        if( pthread_mutex_init( &( pCtx->mutex ), NULL ) != 0 )
+        {
+            LogError( ( "Failed to initialize mock signaling mutex!" ) );
+            ret = -1;
+        }
+    }
+
+    if( ret == 0 )
+    {
+        /* One protocol serves the control plane requests and the signaling
+         * websocket, the client asks for the "wss" protocol on upgrade. */
+        pCtx->protocols[ 0 ].name = "wss";
+        pCtx->protocols[ 0 ].callback = LwsCallback;
+        pCtx->protocols[ 0 ].per_session_data_size = sizeof( MockSignalingSession_t );
+        pCtx->protocols[ 0 ].rx_buffer_size = MOCK_SIGNALING_SERVER_MESSAGE_MAX_LENGTH;
+        pCtx->protocols[ 1 ].callback = NULL;
+
+        memset( &( creationInfo ), 0, sizeof( struct lws_context_creation_info ) );
+        creationInfo.options = LWS_SERVER_OPTION_DO_SSL_GLOBAL_INIT;
+        creationInfo.port = pCtx->config.port;
+        creationInfo.iface = pCtx->config.pHost;
+        creationInfo.protocols = pCtx->protocols;
+        creationInfo.ssl_cert_filepath = pCtx->config.pCertPath;
+        creationInfo.ssl_private_key_filepath = pCtx->config.pKeyPath;
+        creationInfo.user = pCtx;
+
+        pCtx->pLwsContext = lws_create_context( &( creationInfo ) );
+
+        if( pCtx->pLwsContext == NULL )
+        {
+            LogError( ( "lws_create_context failed!" ) );
+            ret = -1;
+        }
+    }
+
+    if( ret == 0 )
+    {
+        if( pthread_create( &( pCtx->serviceTask ), NULL, ServiceTask, pCtx ) != 0 )
+        {
+            LogError( ( "Fail to create mock signaling service task." ) );
+            ret = -1;
+        }
+        else
+        {
+            pCtx->isServiceTaskStarted = 1U;
+        }
+    }
+
+    if( ret == 0 )
+    {
+        if( pthread_create( &( pCtx->schedulerTask ), NULL, SchedulerTask, pCtx ) != 0 )
+        {
+            LogError( ( "Fail to create mock signaling scheduler task." ) );
+            ret = -1;
+        }
+        else
+        {
+            pCtx->isSchedulerTaskStarted = 1U;
+            LogInfo( ( "Mock signaling server listening on https://%s:%u.", pCtx->config.pHost, pCtx->config.port ) );
+        }
+    }
+
+    if( ret != 0 )
+    {
+        MockSignalingServer_Stop( pCtx );
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+void MockSignalingServer_Stop( MockSignalingServerContext_t * pCtx )
+{
+    __atomic_store_n( &( pCtx->isStopRequested ), 1U, __ATOMIC_RELEASE );
+
+    if( pCtx->isSchedulerTaskStarted != 0U )
+    {
+        pthread_join( pCtx->schedulerTask, NULL );
+        pCtx->isSchedulerTaskStarted = 0U;
+    }
+
+    if( pCtx->isServiceTaskStarted != 0U )
+    {
+        lws_cancel_service( pCtx->pLwsContext );
+        pthread_join( pCtx->serviceTask, NULL );
+        pCtx->isServiceTaskStarted = 0U;
+    }
+
+    if( pCtx->pLwsContext != NULL )
+    {
+        lws_context_destroy( pCtx->pLwsContext );
+        pCtx->pLwsContext = NULL;
+    }
+
+    ClearQueue( pCtx );
+}
+
+/*----------------------------------------------------------------------------*/
+
+void MockSignalingServer_GetStats( MockSignalingServerContext_t * pCtx,
+                                   MockSignalingServerStats_t * pStats )
+{
+    pthread_mutex_lock( &( pCtx->mutex ) );
+    {
+        *pStats = pCtx->stats;
+    }
+    pthread_mutex_unlock( &( pCtx->mutex ) );
+}
+
+/*----------------------------------------------------------------------------*/
+
+int MockSignalingServer_IsAllAnswered( MockSignalingServerContext_t * pCtx )
+{
+    int ret = 1;
+    uint32_t i;
+
+    pthread_mutex_lock( &( pCtx->mutex ) );
+    {
+        for( i = 0; i < pCtx->config.viewerCount; i++ )
+        {
+            if( pCtx->viewers[ i ].isAnswered == 0U )
+            {
+                ret = 0;
+                break;
+            }
+        }
+    }
+    pthread_mutex_unlock( &( pCtx->mutex ) );
+
+    return ret;
+}
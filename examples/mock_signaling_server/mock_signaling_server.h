@@ -0,0 +1,139 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MOCK_SIGNALING_SERVER_H
+#define MOCK_SIGNALING_SERVER_H
+
+/* Standard includes. */
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#include "libwebsockets.h"
+
+#define MOCK_SIGNALING_SERVER_MAX_VIEWERS           ( 64 )
+#define MOCK_SIGNALING_SERVER_CLIENT_ID_MAX_LENGTH  ( 32 )
+#define MOCK_SIGNALING_SERVER_PATH_MAX_LENGTH       ( 256 )
+#define MOCK_SIGNALING_SERVER_BODY_MAX_LENGTH       ( 4096 )
+#define MOCK_SIGNALING_SERVER_RESPONSE_MAX_LENGTH   ( 4096 )
+#define MOCK_SIGNALING_SERVER_MESSAGE_MAX_LENGTH    ( 16384 )
+#define MOCK_SIGNALING_SERVER_MAX_QUEUED_MESSAGES   ( 2 * MOCK_SIGNALING_SERVER_MAX_VIEWERS + 4 )
+
+#define MOCK_SIGNALING_SERVER_CHANNEL_ARN_PREFIX    "arn:aws:kinesisvideo:us-west-2:123456789012:channel/"
+
+/*----------------------------------------------------------------------------*/
+
+typedef struct MockSignalingServerConfig
+{
+    /* IPv4 address to listen on, also handed out in the endpoints. */
+    const char * pHost;
+    uint16_t port;
+    const char * pCertPath;
+    const char * pKeyPath;
+
+    /* TURN server handed out in the ICE server configs. */
+    uint16_t stunTurnPort;
+    const char * pTurnPassword;
+    uint32_t iceServerTtlSec;
+    uint32_t credentialsTtlSec;
+
+    /* Synthetic viewers sending offers to the master. */
+    uint32_t viewerCount;
+    uint32_t offerIntervalMs;
+
+    /* Send a GO_AWAY or RECONNECT_ICE_SERVER once after that many seconds of
+     * the first connection, 0 disables. */
+    uint32_t goAwayAfterSec;
+    uint32_t reconnectIceServerAfterSec;
+} MockSignalingServerConfig_t;
+
+typedef struct MockSignalingServerStats
+{
+    uint32_t httpRequests;
+    uint32_t describeChannelRequests;
+    uint32_t getEndpointRequests;
+    uint32_t getIceServerConfigRequests;
+    uint32_t credentialsRequests;
+    uint32_t websocketConnections;
+    uint32_t reconnects;
+    uint32_t offersSent;
+    uint32_t answersReceived;
+    uint32_t candidatesSent;
+    uint32_t candidatesReceived;
+    uint32_t goAwaysSent;
+    uint32_t reconnectIceServersSent;
+    uint64_t minAnswerLatencyUs;
+    uint64_t maxAnswerLatencyUs;
+    uint64_t totalAnswerLatencyUs;
+    uint64_t lastReconnectLatencyUs;
+} MockSignalingServerStats_t;
+
+typedef struct MockSignalingViewer
+{
+    char clientId[ MOCK_SIGNALING_SERVER_CLIENT_ID_MAX_LENGTH ];
+    uint64_t offerSentTimeUs;
+    uint8_t isOfferSent;
+    uint8_t isAnswered;
+} MockSignalingViewer_t;
+
+typedef struct MockSignalingServerContext
+{
+    MockSignalingServerConfig_t config;
+    struct lws_context * pLwsContext;
+    struct lws_protocols protocols[ 2 ];
+
+    pthread_t serviceTask;
+    pthread_t schedulerTask;
+    uint8_t isServiceTaskStarted;
+    uint8_t isSchedulerTaskStarted;
+    uint8_t isStopRequested;
+
+    /* Guards everything below. */
+    pthread_mutex_t mutex;
+    struct lws * pMasterWsi;
+    uint64_t firstConnectTimeUs;
+    uint64_t disconnectTimeUs;
+    uint8_t isGoAwaySent;
+    uint8_t isReconnectIceServerSent;
+    MockSignalingViewer_t viewers[ MOCK_SIGNALING_SERVER_MAX_VIEWERS ];
+
+    /* Messages to the master, each allocated with LWS_PRE bytes in front. */
+    char * pQueuedMessages[ MOCK_SIGNALING_SERVER_MAX_QUEUED_MESSAGES ];
+    size_t queuedMessageLengths[ MOCK_SIGNALING_SERVER_MAX_QUEUED_MESSAGES ];
+    size_t queueHead;
+    size_t queueCount;
+
+    MockSignalingServerStats_t stats;
+} MockSignalingServerContext_t;
+
+/*----------------------------------------------------------------------------*/
+
+/* Serve the signaling control plane, the IoT credentials provider and the
+ * signaling websocket over TLS on pConfig->port. Returns 0 on success. */
+int MockSignalingServer_Start( MockSignalingServerContext_t * pCtx,
+                               const MockSignalingServerConfig_t * pConfig );
+
+void MockSignalingServer_Stop( MockSignalingServerContext_t * pCtx );
+
+void MockSignalingServer_GetStats( MockSignalingServerContext_t * pCtx,
+                                   MockSignalingServerStats_t * pStats );
+
+/* Returns 1 once every viewer got an answer to its offer. */
+int MockSignalingServer_IsAllAnswered( MockSignalingServerContext_t * pCtx );
+
+/*----------------------------------------------------------------------------*/
+
+#endif /* MOCK_SIGNALING_SERVER_H */
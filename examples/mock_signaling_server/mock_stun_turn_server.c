@@ -0,0 +1,741 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+#include "mbedtls/md.h"
+#include "mbedtls/md5.h"
+
+#include "logging.h"
+#include "networking_utils.h"
+#include "mock_stun_turn_server.h"
+
+/*----------------------------------------------------------------------------*/
+
+#define STUN_HEADER_LENGTH                  ( 20 )
+#define STUN_ATTRIBUTE_HEADER_LENGTH        ( 4 )
+#define STUN_MAGIC_COOKIE                   ( 0x2112A442 )
+#define STUN_TRANSACTION_ID_LENGTH          ( 12 )
+#define STUN_HMAC_SHA1_LENGTH               ( 20 )
+#define STUN_LONG_TERM_KEY_LENGTH           ( 16 )
+#define STUN_FINGERPRINT_XOR_VALUE          ( 0x5354554E )
+
+#define STUN_CLASS_MASK                     ( 0x0110 )
+#define STUN_CLASS_REQUEST                  ( 0x0000 )
+#define STUN_CLASS_INDICATION               ( 0x0010 )
+#define STUN_CLASS_SUCCESS_RESPONSE         ( 0x0100 )
+#define STUN_CLASS_ERROR_RESPONSE           ( 0x0110 )
+
+#define STUN_METHOD_BINDING                 ( 0x0001 )
+#define STUN_METHOD_ALLOCATE                ( 0x0003 )
+#define STUN_METHOD_REFRESH                 ( 0x0004 )
+#define STUN_METHOD_SEND                    ( 0x0006 )
+#define STUN_METHOD_CREATE_PERMISSION       ( 0x0008 )
+#define STUN_METHOD_CHANNEL_BIND            ( 0x0009 )
+
+#define STUN_ATTRIBUTE_USERNAME             ( 0x0006 )
+#define STUN_ATTRIBUTE_MESSAGE_INTEGRITY    ( 0x0008 )
+#define STUN_ATTRIBUTE_ERROR_CODE           ( 0x0009 )
+#define STUN_ATTRIBUTE_LIFETIME             ( 0x000D )
+#define STUN_ATTRIBUTE_REALM                ( 0x0014 )
+#define STUN_ATTRIBUTE_NONCE                ( 0x0015 )
+#define STUN_ATTRIBUTE_XOR_RELAYED_ADDRESS  ( 0x0016 )
+#define STUN_ATTRIBUTE_XOR_MAPPED_ADDRESS   ( 0x0020 )
+#define STUN_ATTRIBUTE_FINGERPRINT          ( 0x8028 )
+
+#define STUN_ADDRESS_FAMILY_IPV4            ( 0x01 )
+#define STUN_ERROR_UNAUTHORIZED             ( 401 )
+
+/* ChannelData messages start with a channel number in 0x4000 - 0x7FFF. */
+#define TURN_CHANNEL_DATA_MASK              ( 0xC0 )
+#define TURN_CHANNEL_DATA_PREFIX            ( 0x40 )
+
+#define MOCK_STUN_TURN_SERVER_POLL_TIMEOUT_MS ( 100 )
+
+#define READ_UINT16( pBuffer ) ( ( uint16_t ) ( ( ( uint16_t ) ( pBuffer )[ 0 ] << 8 ) | ( pBuffer )[ 1 ] ) )
+#define READ_UINT32( pBuffer ) ( ( ( uint32_t ) ( pBuffer )[ 0 ] << 24 ) | ( ( uint32_t ) ( pBuffer )[ 1 ] << 16 ) | \
+                                 ( ( uint32_t ) ( pBuffer )[ 2 ] << 8 ) | ( uint32_t ) ( pBuffer )[ 3 ] )
+
+typedef struct MockStunRequest
+{
+    uint16_t method;
+    uint16_t messageClass;
+    const uint8_t * pTransactionId;
+    const uint8_t * pUserName;
+    size_t userNameLength;
+    /* Offset of the MESSAGE-INTEGRITY attribute, 0 if absent. */
+    size_t integrityOffset;
+    uint32_t lifetime;
+    uint8_t hasLifetime;
+} MockStunRequest_t;
+
+typedef struct MockStunWriter
+{
+    uint8_t buffer[ MOCK_STUN_TURN_SERVER_PACKET_LENGTH ];
+    size_t length;
+} MockStunWriter_t;
+
+/*----------------------------------------------------------------------------*/
+
+static uint32_t CalculateCrc32( const uint8_t * pBuffer,
+                                size_t length )
+{
+    uint32_t crc = 0xFFFFFFFF;
+    size_t i;
+    int bit;
+
+    for( i = 0; i < length; i++ )
+    {
+        crc ^= pBuffer[ i ];
+
+        for( bit = 0; bit < 8; bit++ )
+        {
+            crc = ( crc >> 1 ) ^ ( 0xEDB88320 & ( 0U - ( crc & 1U ) ) );
+        }
+    }
+
+    return crc ^ 0xFFFFFFFF;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static int ParseRequest( const uint8_t * pPacket,
+                         size_t length,
+                         MockStunRequest_t * pRequest )
+{
+    int ret = 0;
+    uint16_t messageType, attributeType, attributeLength;
+    size_t offset;
+
+    memset( pRequest, 0, sizeof( MockStunRequest_t ) );
+
+    if( ( length < STUN_HEADER_LENGTH ) ||
+        ( ( pPacket[ 0 ] & 0xC0 ) != 0 ) ||
+        ( READ_UINT32( &( pPacket[ 4 ] ) ) != STUN_MAGIC_COOKIE ) ||
+        ( ( size_t ) STUN_HEADER_LENGTH + READ_UINT16( &( pPacket[ 2 ] ) ) != length ) )
+    {
+        ret = -1;
+    }
+
+    if( ret == 0 )
+    {
+        messageType = READ_UINT16( &( pPacket[ 0 ] ) );
+        pRequest->messageClass = messageType & STUN_CLASS_MASK;
+        pRequest->method = messageType & ~STUN_CLASS_MASK;
+        pRequest->pTransactionId = &( pPacket[ 8 ] );
+
+        for( offset = STUN_HEADER_LENGTH; offset + STUN_ATTRIBUTE_HEADER_LENGTH <= length; )
+        {
+            attributeType = READ_UINT16( &( pPacket[ offset ] ) );
+            attributeLength = READ_UINT16( &( pPacket[ offset + 2 ] ) );
+
+            if( offset + STUN_ATTRIBUTE_HEADER_LENGTH + attributeLength > length )
+            {
+                ret = -1;
+                break;
+            }
+
+            switch( attributeType )
+            {
+                case STUN_ATTRIBUTE_USERNAME:
+                    pRequest->pUserName = &( pPacket[ offset + STUN_ATTRIBUTE_HEADER_LENGTH ] );
+                    pRequest->userNameLength = attributeLength;
+                    break;
+                case STUN_ATTRIBUTE_MESSAGE_INTEGRITY:
+                    pRequest->integrityOffset = offset;
+                    break;
+                case STUN_ATTRIBUTE_LIFETIME:
+                    if( attributeLength == 4U )
+                    {
+                        pRequest->lifetime = READ_UINT32( &( pPacket[ offset + STUN_ATTRIBUTE_HEADER_LENGTH ] ) );
+                        pRequest->hasLifetime = 1U;
+                    }
+                    break;
+                default:
+                    break;
+            }
+
+            /* Attributes are padded to 4 bytes. */
+            offset += STUN_ATTRIBUTE_HEADER_LENGTH + ( ( attributeLength + 3U ) & ~3U );
+        }
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static void WriteHeader( MockStunWriter_t * pWriter,
+                         uint16_t messageType,
+                         const uint8_t * pTransactionId )
+{
+    pWriter->buffer[ 0 ] = ( uint8_t ) ( messageType >> 8 );
+    pWriter->buffer[ 1 ] = ( uint8_t ) messageType;
+    pWriter->buffer[ 2 ] = 0;
+    pWriter->buffer[ 3 ] = 0;
+    pWriter->buffer[ 4 ] = ( uint8_t ) ( STUN_MAGIC_COOKIE >> 24 );
+    pWriter->buffer[ 5 ] = ( uint8_t ) ( STUN_MAGIC_COOKIE >> 16 );
+    pWriter->buffer[ 6 ] = ( uint8_t ) ( STUN_MAGIC_COOKIE >> 8 );
+    pWriter->buffer[ 7 ] = ( uint8_t ) STUN_MAGIC_COOKIE;
+    memcpy( &( pWriter->buffer[ 8 ] ), pTransactionId, STUN_TRANSACTION_ID_LENGTH );
+    pWriter->length = STUN_HEADER_LENGTH;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static void SetMessageLength( MockStunWriter_t * pWriter,
+                              size_t messageLength )
+{
+    pWriter->buffer[ 2 ] = ( uint8_t ) ( messageLength >> 8 );
+    pWriter->buffer[ 3 ] = ( uint8_t ) messageLength;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static void AppendAttribute( MockStunWriter_t * pWriter,
+                             uint16_t attributeType,
+                             const void * pValue,
+                             size_t valueLength )
+{
+    size_t paddedLength = ( valueLength + 3U ) & ~3U;
+
+    /* Responses are small, the buffer holds any of them. */
+    pWriter->buffer[ pWriter->length ] = ( uint8_t ) ( attributeType >> 8 );
+    pWriter->buffer[ pWriter->length + 1 ] = ( uint8_t ) attributeType;
+    pWriter->buffer[ pWriter->length + 2 ] = ( uint8_t ) ( valueLength >> 8 );
+    pWriter->buffer[ pWriter->length + 3 ] = ( uint8_t ) valueLength;
+    memcpy( &( pWriter->buffer[ pWriter->length + STUN_ATTRIBUTE_HEADER_LENGTH ] ), pValue, valueLength );
+    memset( &( pWriter->buffer[ pWriter->length + STUN_ATTRIBUTE_HEADER_LENGTH + valueLength ] ), 0, paddedLength - valueLength );
+
+    pWriter->length += STUN_ATTRIBUTE_HEADER_LENGTH + paddedLength;
+    SetMessageLength( pWriter, pWriter->length - STUN_HEADER_LENGTH );
+}
+
+/*----------------------------------------------------------------------------*/
+
+static void AppendUint32Attribute( MockStunWriter_t * pWriter,
+                                   uint16_t attributeType,
+                                   uint32_t value )
+{
+    uint8_t buffer[ 4 ];
+
+    buffer[ 0 ] = ( uint8_t ) ( value >> 24 );
+    buffer[ 1 ] = ( uint8_t ) ( value >> 16 );
+    buffer[ 2 ] = ( uint8_t ) ( value >> 8 );
+    buffer[ 3 ] = ( uint8_t ) value;
+
+    AppendAttribute( pWriter, attributeType, buffer, sizeof( buffer ) );
+}
+
+/*----------------------------------------------------------------------------*/
+
+static void AppendXorAddress( MockStunWriter_t * pWriter,
+                              uint16_t attributeType,
+                              struct in_addr address,
+                              uint16_t port )
+{
+    uint8_t buffer[ 8 ];
+    uint16_t xorPort = port ^ ( uint16_t ) ( STUN_MAGIC_COOKIE >> 16 );
+    uint32_t xorAddress = ntohl( address.s_addr ) ^ STUN_MAGIC_COOKIE;
+
+    buffer[ 0 ] = 0;
+    buffer[ 1 ] = STUN_ADDRESS_FAMILY_IPV4;
+    buffer[ 2 ] = ( uint8_t ) ( xorPort >> 8 );
+    buffer[ 3 ] = ( uint8_t ) xorPort;
+    buffer[ 4 ] = ( uint8_t ) ( xorAddress >> 24 );
+    buffer[ 5 ] = ( uint8_t ) ( xorAddress >> 16 );
+    buffer[ 6 ] = ( uint8_t ) ( xorAddress >> 8 );
+    buffer[ 7 ] = ( uint8_t ) xorAddress;
+
+    AppendAttribute( pWriter, attributeType, buffer, sizeof( buffer ) );
+}
+
+/*----------------------------------------------------------------------------*/
+
+static int CalculateIntegrity( const uint8_t * pKey,
+                               const uint8_t * pMessage,
+                               size_t messageLength,
+                               uint8_t * pHmac )
+{
+    int ret;
+
+    ret = mbedtls_md_hmac( mbedtls_md_info_from_type( MBEDTLS_MD_SHA1 ),
+                           pKey,
+                           STUN_LONG_TERM_KEY_LENGTH,
+                           pMessage,
+                           messageLength,
+                           pHmac );
+
+    if( ret != 0 )
+    {
+        LogError( ( "mbedtls_md_hmac fails, return=%d.", ret ) );
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static int AppendIntegrityAndFingerprint( MockStunWriter_t * pWriter,
+                                          const uint8_t * pKey )
+{
+    int ret = 0;
+    uint8_t hmac[ STUN_HMAC_SHA1_LENGTH ];
+
+    if( pKey != NULL )
+    {
+        /* The length covers MESSAGE-INTEGRITY but not what follows it. */
+        SetMessageLength( pWriter, pWriter->length - STUN_HEADER_LENGTH + STUN_ATTRIBUTE_HEADER_LENGTH + STUN_HMAC_SHA1_LENGTH );
+        ret = CalculateIntegrity( pKey, pWriter->buffer, pWriter->length, hmac );
+
+        if( ret == 0 )
+        {
+            AppendAttribute( pWriter, STUN_ATTRIBUTE_MESSAGE_INTEGRITY, hmac, sizeof( hmac ) );
+        }
+    }
+
+    if( ret == 0 )
+    {
+        SetMessageLength( pWriter, pWriter->length - STUN_HEADER_LENGTH + STUN_ATTRIBUTE_HEADER_LENGTH + 4U );
+        AppendUint32Attribute( pWriter,
+                               STUN_ATTRIBUTE_FINGERPRINT,
+                               CalculateCrc32( pWriter->buffer, pWriter->length ) ^ STUN_FINGERPRINT_XOR_VALUE );
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static int GetLongTermKey( MockStunTurnServerContext_t * pCtx,
+                           const MockStunRequest_t * pRequest,
+                           uint8_t * pKey )
+{
+    int ret = 0, written;
+    char keyInput[ 512 ];
+
+    /* key = MD5( username ":" realm ":" password ) */
+    written = snprintf( keyInput,
+                        sizeof( keyInput ),
+                        "%.*s:%s:%s",
+                        ( int ) pRequest->userNameLength,
+                        ( const char * ) pRequest->pUserName,
+                        MOCK_STUN_TURN_SERVER_REALM,
+                        pCtx->pPassword );
+
+    if( ( written < 0 ) || ( written >= ( int ) sizeof( keyInput ) ) )
+    {
+        ret = -1;
+    }
+    else
+    {
+        ret = mbedtls_md5_ret( ( const uint8_t * ) keyInput, written, pKey );
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static int VerifyIntegrity( const uint8_t * pPacket,
+                            const MockStunRequest_t * pRequest,
+                            const uint8_t * pKey )
+{
+    int ret = 0;
+    uint8_t message[ MOCK_STUN_TURN_SERVER_PACKET_LENGTH ];
+    uint8_t hmac[ STUN_HMAC_SHA1_LENGTH ];
+    size_t messageLength = pRequest->integrityOffset - STUN_HEADER_LENGTH + STUN_ATTRIBUTE_HEADER_LENGTH + STUN_HMAC_SHA1_LENGTH;
+
+    /* The HMAC covers everything before MESSAGE-INTEGRITY, with the length
+     * in the header ending at MESSAGE-INTEGRITY. */
+    memcpy( message, pPacket, pRequest->integrityOffset );
+    message[ 2 ] = ( uint8_t ) ( messageLength >> 8 );
+    message[ 3 ] = ( uint8_t ) messageLength;
+
+    ret = CalculateIntegrity( pKey, message, pRequest->integrityOffset, hmac );
+
+    if( ( ret == 0 ) &&
+        ( memcmp( hmac, &( pPacket[ pRequest->integrityOffset + STUN_ATTRIBUTE_HEADER_LENGTH ] ), STUN_HMAC_SHA1_LENGTH ) != 0 ) )
+    {
+        ret = -1;
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static void WriteUnauthorized( MockStunTurnServerContext_t * pCtx,
+                               const MockStunRequest_t * pRequest,
+                               MockStunWriter_t * pWriter )
+{
+    uint8_t errorCode[ 4 + sizeof( "Unauthorized" ) - 1 ];
+
+    errorCode[ 0 ] = 0;
+    errorCode[ 1 ] = 0;
+    errorCode[ 2 ] = STUN_ERROR_UNAUTHORIZED / 100;
+    errorCode[ 3 ] = STUN_ERROR_UNAUTHORIZED % 100;
+    memcpy( &( errorCode[ 4 ] ), "Unauthorized", sizeof( "Unauthorized" ) - 1 );
+
+    WriteHeader( pWriter, pRequest->method | STUN_CLASS_ERROR_RESPONSE, pRequest->pTransactionId );
+    AppendAttribute( pWriter, STUN_ATTRIBUTE_ERROR_CODE, errorCode, sizeof( errorCode ) );
+    AppendAttribute( pWriter, STUN_ATTRIBUTE_REALM, MOCK_STUN_TURN_SERVER_REALM, strlen( MOCK_STUN_TURN_SERVER_REALM ) );
+    AppendAttribute( pWriter, STUN_ATTRIBUTE_NONCE, MOCK_STUN_TURN_SERVER_NONCE, strlen( MOCK_STUN_TURN_SERVER_NONCE ) );
+    ( void ) AppendIntegrityAndFingerprint( pWriter, NULL );
+
+    pCtx->stats.unauthorizedResponses++;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static MockTurnAllocation_t * GetAllocation( MockStunTurnServerContext_t * pCtx,
+                                             const struct sockaddr_in * pClientAddress,
+                                             uint8_t create )
+{
+    MockTurnAllocation_t * pAllocation = NULL, * pFree = NULL;
+    uint64_t currentTimeSec = NetworkingUtils_GetCurrentTimeSec( NULL );
+    size_t i;
+
+    /* Must be called with the mutex held. */
+    pCtx->stats.activeAllocations = 0;
+
+    for( i = 0; i < MOCK_STUN_TURN_SERVER_MAX_ALLOCATIONS; i++ )
+    {
+        if( pCtx->allocations[ i ].expirationSec <= currentTimeSec )
+        {
+            if( pFree == NULL )
+            {
+                pFree = &( pCtx->allocations[ i ] );
+            }
+        }
+        else
+        {
+            pCtx->stats.activeAllocations++;
+
+            if( ( pCtx->allocations[ i ].clientAddress.sin_addr.s_addr == pClientAddress->sin_addr.s_addr ) &&
+                ( pCtx->allocations[ i ].clientAddress.sin_port == pClientAddress->sin_port ) )
+            {
+                pAllocation = &( pCtx->allocations[ i ] );
+            }
+        }
+    }
+
+    if( ( pAllocation == NULL ) && ( create != 0U ) && ( pFree != NULL ) )
+    {
+        pAllocation = pFree;
+        pAllocation->clientAddress = *pClientAddress;
+        pAllocation->relayPort = ( uint16_t ) ( MOCK_STUN_TURN_SERVER_RELAY_BASE_PORT + ( pFree - &( pCtx->allocations[ 0 ] ) ) );
+        pCtx->stats.activeAllocations++;
+    }
+
+    return pAllocation;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static int HandleTurnRequest( MockStunTurnServerContext_t * pCtx,
+                              const MockStunRequest_t * pRequest,
+                              const struct sockaddr_in * pClientAddress,
+                              const uint8_t * pKey,
+                              MockStunWriter_t * pWriter )
+{
+    int ret = 0;
+    MockTurnAllocation_t * pAllocation;
+    uint32_t lifetime = pRequest->hasLifetime != 0U ? pRequest->lifetime : MOCK_STUN_TURN_SERVER_DEFAULT_LIFETIME;
+
+    WriteHeader( pWriter, pRequest->method | STUN_CLASS_SUCCESS_RESPONSE, pRequest->pTransactionId );
+
+    switch( pRequest->method )
+    {
+        case STUN_METHOD_ALLOCATE:
+            pCtx->stats.allocateRequests++;
+            pAllocation = GetAllocation( pCtx, pClientAddress, 1U );
+
+            if( pAllocation == NULL )
+            {
+                LogWarn( ( "No free TURN allocation." ) );
+                ret = -1;
+            }
+            else
+            {
+                pAllocation->expirationSec = NetworkingUtils_GetCurrentTimeSec( NULL ) + lifetime;
+                AppendXorAddress( pWriter, STUN_ATTRIBUTE_XOR_RELAYED_ADDRESS, pCtx->relayAddress, pAllocation->relayPort );
+                AppendXorAddress( pWriter, STUN_ATTRIBUTE_XOR_MAPPED_ADDRESS, pClientAddress->sin_addr, ntohs( pClientAddress->sin_port ) );
+                AppendUint32Attribute( pWriter, STUN_ATTRIBUTE_LIFETIME, lifetime );
+            }
+            break;
+
+        case STUN_METHOD_REFRESH:
+            pCtx->stats.refreshRequests++;
+            pAllocation = GetAllocation( pCtx, pClientAddress, 0U );
+
+            if( pAllocation != NULL )
+            {
+                /* A lifetime of 0 deletes the allocation. */
+                pAllocation->expirationSec = NetworkingUtils_GetCurrentTimeSec( NULL ) + lifetime;
+            }
+
+            AppendUint32Attribute( pWriter, STUN_ATTRIBUTE_LIFETIME, lifetime );
+            break;
+
+        case STUN_METHOD_CREATE_PERMISSION:
+            pCtx->stats.createPermissionRequests++;
+            break;
+
+        case STUN_METHOD_CHANNEL_BIND:
+            pCtx->stats.channelBindRequests++;
+            break;
+
+        default:
+            ret = -1;
+            break;
+    }
+
+    if( ret == 0 )
+    {
+        ret = AppendIntegrityAndFingerprint( pWriter, pKey );
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static int HandlePacket( MockStunTurnServerContext_t * pCtx,
+                         const uint8_t * pPacket,
+                         size_t length,
+                         const struct sockaddr_in * pClientAddress,
+                         MockStunWriter_t * pWriter )
+{
+    int ret = 0;
+    MockStunRequest_t request;
+    uint8_t key[ STUN_LONG_TERM_KEY_LENGTH ];
+
+    if( ( length > 0U ) && ( ( pPacket[ 0 ] & TURN_CHANNEL_DATA_MASK ) == TURN_CHANNEL_DATA_PREFIX ) )
+    {
+        /* Nothing is relayed, peers are not reachable through the mock. */
+        pCtx->stats.dataPackets++;
+        ret = -1;
+    }
+    else if( ParseRequest( pPacket, length, &( request ) ) != 0 )
+    {
+        LogDebug( ( "Ignoring a malformed STUN packet of %lu bytes.", length ) );
+        ret = -1;
+    }
+    else if( ( request.messageClass == STUN_CLASS_INDICATION ) && ( request.method == STUN_METHOD_SEND ) )
+    {
+        pCtx->stats.dataPackets++;
+        ret = -1;
+    }
+    else if( request.messageClass != STUN_CLASS_REQUEST )
+    {
+        ret = -1;
+    }
+    else if( request.method == STUN_METHOD_BINDING )
+    {
+        pCtx->stats.bindingRequests++;
+        WriteHeader( pWriter, STUN_METHOD_BINDING | STUN_CLASS_SUCCESS_RESPONSE, request.pTransactionId );
+        AppendXorAddress( pWriter, STUN_ATTRIBUTE_XOR_MAPPED_ADDRESS, pClientAddress->sin_addr, ntohs( pClientAddress->sin_port ) );
+        ret = AppendIntegrityAndFingerprint( pWriter, NULL );
+    }
+    else if( ( request.integrityOffset == 0U ) || ( request.pUserName == NULL ) )
+    {
+        /* The first request of a TURN client has no credential, the realm and
+         * nonce in the challenge let it build one. */
+        WriteUnauthorized( pCtx, &( request ), pWriter );
+    }
+    else if( ( GetLongTermKey( pCtx, &( request ), key ) != 0 ) ||
+             ( VerifyIntegrity( pPacket, &( request ), key ) != 0 ) )
+    {
+        LogWarn( ( "TURN request with a bad MESSAGE-INTEGRITY from user %.*s.",
+                   ( int ) request.userNameLength,
+                   ( const char * ) request.pUserName ) );
+        pCtx->stats.integrityFailures++;
+        WriteUnauthorized( pCtx, &( request ), pWriter );
+    }
+    else
+    {
+        ret = HandleTurnRequest( pCtx, &( request ), pClientAddress, key, pWriter );
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static void * StunTurnTask( void * pParameter )
+{
+    MockStunTurnServerContext_t * pCtx = ( MockStunTurnServerContext_t * ) pParameter;
+    uint8_t packet[ MOCK_STUN_TURN_SERVER_PACKET_LENGTH ];
+    MockStunWriter_t writer;
+    struct sockaddr_in clientAddress;
+    socklen_t clientAddressLength;
+    ssize_t length;
+    int ret;
+
+    while( __atomic_load_n( &( pCtx->isStopRequested ), __ATOMIC_ACQUIRE ) == 0U )
+    {
+        clientAddressLength = sizeof( clientAddress );
+        length = recvfrom( pCtx->socketFd,
+                           packet,
+                           sizeof( packet ),
+                           0,
+                           ( struct sockaddr * ) &( clientAddress ),
+                           &( clientAddressLength ) );
+
+        if( length <= 0 )
+        {
+            /* Receive timeout, check for stop. */
+            continue;
+        }
+
+        pthread_mutex_lock( &( pCtx->mutex ) );
+        {
+            ret = HandlePacket( pCtx, packet, ( size_t ) length, &( clientAddress ), &( writer ) );
+        }
+        pthread_mutex_unlock( &( pCtx->mutex ) );
+
+        if( ret == 0 )
+        {
+            ( void ) sendto( pCtx->socketFd,
+                             writer.buffer,
+                             writer.length,
+                             0,
+                             ( const struct sockaddr * ) &( clientAddress ),
+                             clientAddressLength );
+        }
+    }
+
+    return NULL;
+}
+
+/*----------------------------------------------------------------------------*/
+
+int MockStunTurnServer_Start( MockStunTurnServerContext_t * pCtx,
+                              const char * pHost,
+                              uint16_t port,
+                              const char * pPassword )
+{
+    int ret = 0;
+    struct sockaddr_in address;
+    struct timeval timeout;
+
+    memset( pCtx, 0, sizeof( MockStunTurnServerContext_t ) );
+    pCtx->socketFd = -1;
+    pCtx->pPassword = pPassword;
+
+    memset( &( address ), 0, sizeof( address ) );
+    address.sin_family = AF_INET;
+    address.sin_port = htons( port );
+
+    if( inet_pton( AF_INET, pHost, &( address.sin_addr ) ) != 1 )
+    {
+        LogError( ( "STUN/TURN host must be an IPv4 address: %s", pHost ) );
+        ret = -1;
+    }
+
+    if( ret == 0 )
+    {
+        pCtx->relayAddress = address.sin_addr;
+        pCtx->socketFd = socket( AF_INET, SOCK_DGRAM, 0 );
+
+        if( pCtx->socketFd < 0 )
+        {
+            LogError( ( "Fail to create STUN/TURN socket." ) );
+            ret = -1;
+        }
+    }
+
+    if( ret == 0 )
+    {
+        timeout.tv_sec = 0;
+        timeout.tv_usec = MOCK_STUN_TURN_SERVER_POLL_TIMEOUT_MS * 1000;
+
+        if( ( setsockopt( pCtx->socketFd, SOL_SOCKET, SO_RCVTIMEO, &( timeout ), sizeof( timeout ) ) != 0 ) ||
+            ( bind( pCtx->socketFd, ( struct sockaddr * ) &( address ), sizeof( address ) ) != 0 ) )
+        {
+            LogError( ( "Fail to bind STUN/TURN socket to %s:%u.", pHost, port ) );
+            ret = -1;
+        }
+    }
+
+    if( ret == 0 )
+    {
+        if( pthread_mutex_init( &( pCtx->mutex ), NULL ) != 0 )
+        {
+            LogError( ( "Failed to initialize STUN/TURN mutex!" ) );
+            ret = -1;
+        }
+    }
+
+    if( ret == 0 )
+    {
+        if( pthread_create( &( pCtx->task ), NULL, StunTurnTask, pCtx ) != 0 )
+        {
+            LogError( ( "Fail to create STUN/TURN task." ) );
+            ret = -1;
+        }
+        else
+        {
+            pCtx->isTaskStarted = 1U;
+            LogInfo( ( "STUN/TURN server listening on udp %s:%u.", pHost, port ) );
+        }
+    }
+
+    if( ( ret != 0 ) && ( pCtx->socketFd >= 0 ) )
+    {
+        close( pCtx->socketFd );
+        pCtx->socketFd = -1;
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+void MockStunTurnServer_Stop( MockStunTurnServerContext_t * pCtx )
+{
+    if( pCtx->isTaskStarted != 0U )
+    {
+        __atomic_store_n( &( pCtx->isStopRequested ), 1U, __ATOMIC_RELEASE );
+        pthread_join( pCtx->task, NULL );
+        pCtx->isTaskStarted = 0U;
+    }
+
+    if( pCtx->socketFd >= 0 )
+    {
+        close( pCtx->socketFd );
+        pCtx->socketFd = -1;
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+void MockStunTurnServer_GetStats( MockStunTurnServerContext_t * pCtx,
+                                  MockStunTurnServerStats_t * pStats )
+{
+    pthread_mutex_lock( &( pCtx->mutex ) );
+    {
+        *pStats = pCtx->stats;
+    }
+    pthread_mutex_unlock( &( pCtx->mutex ) );
+}
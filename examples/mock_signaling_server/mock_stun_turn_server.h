@@ -0,0 +1,90 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MOCK_STUN_TURN_SERVER_H
+#define MOCK_STUN_TURN_SERVER_H
+
+/* Standard includes. */
+#include <stdint.h>
+#include <pthread.h>
+#include <netinet/in.h>
+
+#define MOCK_STUN_TURN_SERVER_REALM             "mock.kinesisvideo"
+#define MOCK_STUN_TURN_SERVER_NONCE             "6d6f636b6e6f6e6365"
+#define MOCK_STUN_TURN_SERVER_MAX_ALLOCATIONS   ( 64 )
+#define MOCK_STUN_TURN_SERVER_DEFAULT_LIFETIME  ( 600 )
+
+/* Relayed addresses are handed out from this port up, nothing is relayed. */
+#define MOCK_STUN_TURN_SERVER_RELAY_BASE_PORT   ( 50000 )
+
+#define MOCK_STUN_TURN_SERVER_PACKET_LENGTH     ( 1500 )
+
+/*----------------------------------------------------------------------------*/
+
+typedef struct MockTurnAllocation
+{
+    struct sockaddr_in clientAddress;
+    uint16_t relayPort;
+    uint64_t expirationSec;
+} MockTurnAllocation_t;
+
+typedef struct MockStunTurnServerStats
+{
+    uint32_t bindingRequests;
+    uint32_t allocateRequests;
+    uint32_t refreshRequests;
+    uint32_t createPermissionRequests;
+    uint32_t channelBindRequests;
+    uint32_t unauthorizedResponses;
+    uint32_t integrityFailures;
+    uint32_t dataPackets;
+    uint32_t activeAllocations;
+} MockStunTurnServerStats_t;
+
+typedef struct MockStunTurnServerContext
+{
+    int socketFd;
+    struct in_addr relayAddress;
+    const char * pPassword;
+
+    pthread_t task;
+    uint8_t isTaskStarted;
+    uint8_t isStopRequested;
+
+    /* Guards the allocations and the statistics. */
+    pthread_mutex_t mutex;
+    MockTurnAllocation_t allocations[ MOCK_STUN_TURN_SERVER_MAX_ALLOCATIONS ];
+    MockStunTurnServerStats_t stats;
+} MockStunTurnServerContext_t;
+
+/*----------------------------------------------------------------------------*/
+
+/* Answer STUN binding requests and TURN allocate, refresh, create permission
+ * and channel bind requests on the UDP port, with the long term credential of
+ * any user name and the given password. Returns 0 on success. */
+int MockStunTurnServer_Start( MockStunTurnServerContext_t * pCtx,
+                              const char * pHost,
+                              uint16_t port,
+                              const char * pPassword );
+
+void MockStunTurnServer_Stop( MockStunTurnServerContext_t * pCtx );
+
+void MockStunTurnServer_GetStats( MockStunTurnServerContext_t * pCtx,
+                                  MockStunTurnServerStats_t * pStats );
+
+/*----------------------------------------------------------------------------*/
+
+#endif /* MOCK_STUN_TURN_SERVER_H */
@@ -19,9 +19,16 @@
 /* Standard includes. */
 #include <string.h>
 #include <assert.h>
+#include <stdio.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <pthread.h>
 
 #include "mbedtls/config.h"
 #include "mbedtls/pem.h"
+#include "mbedtls/platform_util.h"
 #include "mbedtls/sha256.h"
 #include "mbedtls/ssl.h"
 #include "mbedtls/version.h"
@@ -43,6 +50,10 @@
 /* OS specific port header. */
 #include "transport_dtls_mbedtls_port.h"
 
+#if METRIC_PRINT_ENABLED
+#include "metric.h"
+#endif
+
 /*-----------------------------------------------------------*/
 
 /**  https://tools.ietf.org/html/rfc5764#section-4.1.2 */
@@ -58,6 +69,123 @@ mbedtls_ssl_srtp_profile DTLS_SRTP_SUPPORTED_PROFILES[] = {
     #endif
 };
 
+/* Process-wide random number generator shared by all DTLS sessions, it's seeded only once. */
+static mbedtls_entropy_context dtlsSharedEntropyContext;
+static mbedtls_ctr_drbg_context dtlsSharedCtrDrbgContext;
+static pthread_mutex_t dtlsSharedDrbgMutex = PTHREAD_MUTEX_INITIALIZER;
+static uint8_t dtlsSharedDrbgInitialized = 0U;
+
+/* The SSL context running handshake on this thread, used to export keys
+ * because the export callback is registered on the shared configuration. */
+static __thread DtlsSSLContext_t * pHandshakingSslContext = NULL;
+
+#if METRIC_PRINT_ENABLED
+static uint64_t DtlsTraceGetTimeUs( clockid_t clockId )
+{
+    struct timespec ts;
+
+    clock_gettime( clockId, &ts );
+
+    return ( ( uint64_t ) ts.tv_sec * 1000000ULL ) + ( ( uint64_t ) ts.tv_nsec / 1000ULL );
+}
+
+static DtlsTraceStep_t DtlsTraceGetStep( int sslState )
+{
+    DtlsTraceStep_t step;
+
+    switch( sslState )
+    {
+        case MBEDTLS_SSL_HELLO_REQUEST:
+        case MBEDTLS_SSL_CLIENT_HELLO:
+        case MBEDTLS_SSL_SERVER_HELLO:
+        case MBEDTLS_SSL_SERVER_HELLO_VERIFY_REQUEST_SENT:
+            step = DTLS_TRACE_STEP_HELLO;
+            break;
+        case MBEDTLS_SSL_SERVER_CERTIFICATE:
+        case MBEDTLS_SSL_SERVER_KEY_EXCHANGE:
+        case MBEDTLS_SSL_CERTIFICATE_REQUEST:
+        case MBEDTLS_SSL_SERVER_HELLO_DONE:
+        case MBEDTLS_SSL_CLIENT_CERTIFICATE:
+        case MBEDTLS_SSL_CLIENT_KEY_EXCHANGE:
+            step = DTLS_TRACE_STEP_KEY_EXCHANGE;
+            break;
+        case MBEDTLS_SSL_CERTIFICATE_VERIFY:
+            step = DTLS_TRACE_STEP_CERTIFICATE_VERIFY;
+            break;
+        default:
+            step = DTLS_TRACE_STEP_FINISHED;
+            break;
+    }
+
+    return step;
+}
+
+/* Called after every call that drives the handshake, datagrams sent in that call form one flight. */
+static void DtlsTraceOnHandshakeDriven( DtlsHandshakeTrace_t * pTrace,
+                                        uint32_t prevDatagramCount,
+                                        uint8_t isRetransmission )
+{
+    if( pTrace->datagramCount == prevDatagramCount )
+    {
+        /* Nothing sent. */
+    }
+    else if( isRetransmission != 0U )
+    {
+        pTrace->retransmissionCount++;
+    }
+    else
+    {
+        if( pTrace->flightCount < DTLS_TRACE_MAX_FLIGHTS )
+        {
+            pTrace->flightSentTimeUs[ pTrace->flightCount ] = DtlsTraceGetTimeUs( CLOCK_MONOTONIC );
+        }
+        pTrace->flightCount++;
+        pTrace->isAwaitingPeerFlight = 1U;
+    }
+}
+
+static void DtlsTraceOnPeerPacket( DtlsHandshakeTrace_t * pTrace )
+{
+    uint32_t lastFlight;
+
+    /* Only the first datagram of the peer flight ends the wait. */
+    if( ( pTrace->isAwaitingPeerFlight != 0U ) && ( pTrace->flightCount > 0U ) )
+    {
+        lastFlight = pTrace->flightCount < DTLS_TRACE_MAX_FLIGHTS ? pTrace->flightCount - 1U : DTLS_TRACE_MAX_FLIGHTS - 1U;
+        Metric_RecordHistogram( METRIC_HISTOGRAM_DTLS_FLIGHT_DURATION,
+                                DtlsTraceGetTimeUs( CLOCK_MONOTONIC ) - pTrace->flightSentTimeUs[ lastFlight ] );
+        pTrace->isAwaitingPeerFlight = 0U;
+    }
+}
+
+static void DtlsTraceOnHandshakeComplete( DtlsHandshakeTrace_t * pTrace )
+{
+    uint32_t i;
+
+    Metric_RecordHistogram( METRIC_HISTOGRAM_DTLS_RETRANSMISSIONS, pTrace->retransmissionCount );
+    Metric_RecordHistogram( METRIC_HISTOGRAM_DTLS_CPU_HELLO, pTrace->cpuTimeUs[ DTLS_TRACE_STEP_HELLO ] );
+    Metric_RecordHistogram( METRIC_HISTOGRAM_DTLS_CPU_KEY_EXCHANGE, pTrace->cpuTimeUs[ DTLS_TRACE_STEP_KEY_EXCHANGE ] );
+    Metric_RecordHistogram( METRIC_HISTOGRAM_DTLS_CPU_CERTIFICATE_VERIFY, pTrace->cpuTimeUs[ DTLS_TRACE_STEP_CERTIFICATE_VERIFY ] );
+    Metric_RecordHistogram( METRIC_HISTOGRAM_DTLS_CPU_FINISHED, pTrace->cpuTimeUs[ DTLS_TRACE_STEP_FINISHED ] );
+
+    LogInfo( ( "DTLS handshake done in %lu us, flights: %u, datagrams: %u, retransmissions: %u, "
+               "CPU time (us) hello: %lu, key exchange: %lu, certificate verify: %lu, finished: %lu",
+               DtlsTraceGetTimeUs( CLOCK_MONOTONIC ) - pTrace->handshakeStartTimeUs,
+               pTrace->flightCount,
+               pTrace->datagramCount,
+               pTrace->retransmissionCount,
+               pTrace->cpuTimeUs[ DTLS_TRACE_STEP_HELLO ],
+               pTrace->cpuTimeUs[ DTLS_TRACE_STEP_KEY_EXCHANGE ],
+               pTrace->cpuTimeUs[ DTLS_TRACE_STEP_CERTIFICATE_VERIFY ],
+               pTrace->cpuTimeUs[ DTLS_TRACE_STEP_FINISHED ] ) );
+
+    for( i = 0; ( i < pTrace->flightCount ) && ( i < DTLS_TRACE_MAX_FLIGHTS ); i++ )
+    {
+        LogDebug( ( "DTLS flight %u sent at +%lu us", i, pTrace->flightSentTimeUs[ i ] - pTrace->handshakeStartTimeUs ) );
+    }
+}
+#endif /* METRIC_PRINT_ENABLED */
+
 /**
  * @brief Utility for converting the high-level code in an mbedTLS error to
  * string, if the code-contains a high-level code; otherwise, using a default
@@ -89,20 +217,21 @@ static void DtlsSslContextInit( DtlsSSLContext_t * pSslContext );
 static void DtlsSslContextFree( DtlsSSLContext_t * pSslContext );
 
 /**
- * @brief Passes DTLS credentials to the OpenSSL library.
+ * @brief Passes DTLS credentials to the shared SSL configuration.
  *
- * Provides the root CA certificate, client certificate, and private key to the
- * OpenSSL library. If the client certificate or private key is not NULL, mutual
- * authentication is used when performing the DTLS handshake.
+ * Provides the local certificate and private key, SRTP profiles and the
+ * shared random number generator to the configuration.
  *
- * @param[out] pSslContext SSL context to which the credentials are to be
- * imported.
- * @param[in] pNetworkCredentials DTLS credentials to be imported.
+ * @param[out] pSharedConfig Shared configuration to which the credentials are
+ * to be imported.
+ * @param[in] pCert Local certificate.
+ * @param[in] pKey Local private key.
  *
  * @return 0 on success; otherwise, failure;
  */
-static int32_t setCredentials( DtlsSSLContext_t * pSslContext,
-                               DtlsNetworkCredentials_t * pNetworkCredentials );
+static int32_t setCredentials( DtlsSharedConfig_t * pSharedConfig,
+                               mbedtls_x509_crt * pCert,
+                               mbedtls_pk_context * pKey );
 
 /**
  * @brief Setup DTLS by initializing contexts and setting configurations.
@@ -118,17 +247,11 @@ static DtlsTransportStatus_t dtlsSetup( DtlsNetworkContext_t * pDtlsNetworkConte
                                         DtlsNetworkCredentials_t * pNetworkCredentials );
 
 /**
- * @brief Initialize mbedTLS.
- *
- * @param[out] entropyContext mbed DTLS entropy context for generation of random
- * numbers.
- * @param[out] ctrDrbgContext mbed DTLS CTR DRBG context for generation of
- * random numbers.
+ * @brief Initialize mbedTLS and seed the shared random number generator once.
  *
  * @return #DTLS_SUCCESS, or #DTLS_TRANSPORT_INTERNAL_ERROR.
  */
-static DtlsTransportStatus_t initMbedtls( mbedtls_entropy_context * pEntropyContext,
-                                          mbedtls_ctr_drbg_context * pCtrDrbgContext );
+static DtlsTransportStatus_t initMbedtls( void );
 
 /*-----------------------------------------------------------*/
 
@@ -166,6 +289,13 @@ static int DtlsUdpSendWrap( void * pCustomCtx,
         if( pDtlsTransportParams->onDtlsSendHook != NULL )
         {
             ret = pDtlsTransportParams->onDtlsSendHook( pDtlsTransportParams->pOnDtlsSendCustomContext, pBuf, len );
+
+            #if METRIC_PRINT_ENABLED
+            if( ret >= 0 )
+            {
+                pDtlsTransportParams->handshakeTrace.datagramCount++;
+            }
+            #endif /* METRIC_PRINT_ENABLED */
         }
         else
         {
@@ -244,14 +374,7 @@ static void DtlsSslContextInit( DtlsSSLContext_t * pSslContext )
 {
     assert( pSslContext != NULL );
 
-    mbedtls_ssl_config_init( &( pSslContext->config ) );
     mbedtls_ssl_init( &( pSslContext->context ) );
-    #ifdef MBEDTLS_DEBUG_C
-        mbedtls_debug_set_threshold( 1 );
-        mbedtls_ssl_conf_dbg( &( pSslContext->config ),
-                              dtls_mbedtls_string_printf,
-                              NULL );
-    #endif /* MBEDTLS_DEBUG_C */
 }
 /*-----------------------------------------------------------*/
 
@@ -259,10 +382,27 @@ static void DtlsSslContextFree( DtlsSSLContext_t * pSslContext )
 {
     assert( pSslContext != NULL );
 
-    mbedtls_ssl_config_free( &( pSslContext->config ) );
     mbedtls_ssl_free( &( pSslContext->context ) );
-    mbedtls_entropy_free( &( pSslContext->entropyContext ) );
-    mbedtls_ctr_drbg_free( &( pSslContext->ctrDrbgContext ) );
+}
+/*-----------------------------------------------------------*/
+
+static int dtlsSharedDrbgRandom( void * pCustomContext,
+                                 unsigned char * pBuf,
+                                 size_t bufSize )
+{
+    int ret = MBEDTLS_ERR_CTR_DRBG_ENTROPY_SOURCE_FAILED;
+
+    ( void ) pCustomContext;
+
+    if( pthread_mutex_lock( &dtlsSharedDrbgMutex ) == 0 )
+    {
+        ret = mbedtls_ctr_drbg_random( &dtlsSharedCtrDrbgContext,
+                                       pBuf,
+                                       bufSize );
+        pthread_mutex_unlock( &dtlsSharedDrbgMutex );
+    }
+
+    return ret;
 }
 /*-----------------------------------------------------------*/
 
@@ -276,12 +416,21 @@ int dtlsSessionKeyDerivationCallback( void * customData,
                                       const unsigned char serverRandom[MAX_DTLS_RANDOM_BYTES_LEN],
                                       mbedtls_tls_prf_types tlsProfile )
 {
+    ( ( void ) customData );
     ( ( void ) pKeyBlock );
     ( ( void ) maclen );
     ( ( void  )keylen );
     ( ( void ) ivlen );
-    DtlsSSLContext_t * pSslContext = ( DtlsSSLContext_t * )customData;
-    TlsKeys * pKeys = ( TlsKeys * ) &pSslContext->tlsKeys;
+    DtlsSSLContext_t * pSslContext = pHandshakingSslContext;
+    TlsKeys * pKeys = NULL;
+
+    if( pSslContext == NULL )
+    {
+        LogError( ( "No handshaking SSL context to export keys." ) );
+        return -1;
+    }
+
+    pKeys = ( TlsKeys * ) &pSslContext->tlsKeys;
 
     memcpy( pKeys->masterSecret,
             pMasterSecret,
@@ -298,41 +447,41 @@ int dtlsSessionKeyDerivationCallback( void * customData,
 }
 
 /*-----------------------------------------------------------*/
-static int32_t setCredentials( DtlsSSLContext_t * pSslContext,
-                               DtlsNetworkCredentials_t * pNetworkCredentials )
+static int32_t setCredentials( DtlsSharedConfig_t * pSharedConfig,
+                               mbedtls_x509_crt * pCert,
+                               mbedtls_pk_context * pKey )
 {
     int32_t mbedtlsError = 0;
 
-    assert( pSslContext != NULL );
-    assert( pNetworkCredentials != NULL );
+    assert( pSharedConfig != NULL );
 
     /* Set up the certificate security profile, starting from the default value.
      */
-    pSslContext->certProfile = mbedtls_x509_crt_profile_default;
+    pSharedConfig->certProfile = mbedtls_x509_crt_profile_default;
 
     /* Set SSL authmode and the RNG context. */
-    mbedtls_ssl_conf_authmode( &( pSslContext->config ),
+    mbedtls_ssl_conf_authmode( &( pSharedConfig->config ),
                                MBEDTLS_SSL_VERIFY_OPTIONAL );
-    mbedtls_ssl_conf_rng( &( pSslContext->config ),
-                          mbedtls_ctr_drbg_random,
-                          &( pSslContext->ctrDrbgContext ) );
-    mbedtls_ssl_conf_cert_profile( &( pSslContext->config ),
-                                   &( pSslContext->certProfile ) );
+    mbedtls_ssl_conf_rng( &( pSharedConfig->config ),
+                          dtlsSharedDrbgRandom,
+                          NULL );
+    mbedtls_ssl_conf_cert_profile( &( pSharedConfig->config ),
+                                   &( pSharedConfig->certProfile ) );
 
-    if( pNetworkCredentials->pClientCert != NULL )
+    if( pCert != NULL )
     {
-        if( pNetworkCredentials->pPrivateKey != NULL )
+        if( pKey != NULL )
         {
             if( mbedtlsError == 0 )
             {
-                mbedtlsError = mbedtls_ssl_conf_own_cert( &( pSslContext->config ),
-                                                          pNetworkCredentials->pClientCert,
-                                                          pNetworkCredentials->pPrivateKey );
+                mbedtlsError = mbedtls_ssl_conf_own_cert( &( pSharedConfig->config ),
+                                                          pCert,
+                                                          pKey );
             }
 
             if( mbedtlsError == 0 )
             {
-                mbedtls_ssl_conf_dtls_cookies( &( pSslContext->config ),
+                mbedtls_ssl_conf_dtls_cookies( &( pSharedConfig->config ),
                                                NULL,
                                                NULL,
                                                NULL );
@@ -340,7 +489,7 @@ static int32_t setCredentials( DtlsSSLContext_t * pSslContext,
 
             if( mbedtlsError == 0 )
             {
-                mbedtlsError = mbedtls_ssl_conf_dtls_srtp_protection_profiles( &pSslContext->config,
+                mbedtlsError = mbedtls_ssl_conf_dtls_srtp_protection_profiles( &pSharedConfig->config,
                                                                                DTLS_SRTP_SUPPORTED_PROFILES );
                 if( mbedtlsError != 0 )
                 {
@@ -350,20 +499,21 @@ static int32_t setCredentials( DtlsSSLContext_t * pSslContext,
             }
             if( mbedtlsError == 0 )
             {
-                mbedtls_ssl_conf_export_keys_ext_cb( &pSslContext->config,
+                /* Keys are stored into the SSL context handshaking on current thread, see pHandshakingSslContext. */
+                mbedtls_ssl_conf_export_keys_ext_cb( &pSharedConfig->config,
                                                      dtlsSessionKeyDerivationCallback,
-                                                     pSslContext );
+                                                     NULL );
             }
         }
         else
         {
-            LogError( ( "pNetworkCredentials->pPrivateKey == NULL" ) );
+            LogError( ( "pKey == NULL" ) );
             mbedtlsError = -1;
         }
     }
     else
     {
-        LogError( ( "pNetworkCredentials->pClientCert == NULL" ) );
+        LogError( ( "pCert == NULL" ) );
         mbedtlsError = -1;
     }
 
@@ -381,115 +531,180 @@ static DtlsTransportStatus_t dtlsSetup( DtlsNetworkContext_t * pNetworkContext,
     assert( pNetworkContext != NULL );
     assert( pNetworkContext->pParams != NULL );
     assert( pNetworkCredentials != NULL );
-    // assert( pNetworkCredentials->pRootCa != NULL );
+    assert( pNetworkCredentials->pSharedConfig != NULL );
 
     pDtlsTransportParams = pNetworkContext->pParams;
     /* Initialize the mbed DTLS context structures. */
     DtlsSslContextInit( &( pDtlsTransportParams->dtlsSslContext ) );
 
-    mbedtlsError = mbedtls_ssl_config_defaults( &( pDtlsTransportParams->dtlsSslContext.config ),
-                                                MBEDTLS_SSL_IS_CLIENT,
-                                                MBEDTLS_SSL_TRANSPORT_DATAGRAM,
-                                                MBEDTLS_SSL_PRESET_DEFAULT );
+    /* Initialize the mbed DTLS secured connection context, the configuration is shared and read-only. */
+    mbedtlsError = mbedtls_ssl_setup( &( pDtlsTransportParams->dtlsSslContext.context ),
+                                      &( pNetworkCredentials->pSharedConfig->config ) );
 
     if( mbedtlsError != 0 )
     {
-        LogError( ( "Failed to set default SSL configuration: mbedTLSError= %s : %s.", mbedtlsHighLevelCodeOrDefault( mbedtlsError ), mbedtlsLowLevelCodeOrDefault( mbedtlsError ) ) );
-
-        /* Per mbed DTLS docs, mbedtls_ssl_config_defaults only fails on memory
-         * allocation. */
-        returnStatus = DTLS_TRANSPORT_INSUFFICIENT_MEMORY;
+        LogError( ( "Failed to set up mbed DTLS SSL context: mbedTLSError=-0x%x %s : %s.",
+                    mbedtlsError,
+                    mbedtlsHighLevelCodeOrDefault( mbedtlsError ),
+                    mbedtlsLowLevelCodeOrDefault( mbedtlsError ) ) );
+        DtlsSslContextFree( &( pDtlsTransportParams->dtlsSslContext ) );
+        returnStatus = DTLS_TRANSPORT_INTERNAL_ERROR;
     }
 
-    if( returnStatus == DTLS_SUCCESS )
-    {
-        mbedtlsError = setCredentials( &( pDtlsTransportParams->dtlsSslContext ),
-                                       pNetworkCredentials );
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
 
-        if( mbedtlsError != 0 )
-        {
-            returnStatus = DTLS_TRANSPORT_INVALID_CREDENTIALS;
-        }
-    }
+static DtlsTransportStatus_t initMbedtls( void )
+{
+    DtlsTransportStatus_t returnStatus = DTLS_SUCCESS;
+    int32_t mbedtlsError = 0;
 
-    if( returnStatus == DTLS_SUCCESS )
+    if( pthread_mutex_lock( &dtlsSharedDrbgMutex ) != 0 )
     {
-        pDtlsTransportParams = pNetworkContext->pParams;
+        LogError( ( "Failed to initialize mbedTLS: mutex lock acquisition." ) );
+        returnStatus = DTLS_TRANSPORT_INTERNAL_ERROR;
+    }
+    else if( dtlsSharedDrbgInitialized != 0U )
+    {
+        /* Entropy is gathered only once for the whole process. */
+        pthread_mutex_unlock( &dtlsSharedDrbgMutex );
+    }
+    else
+    {
+        #if defined( MBEDTLS_THREADING_ALT )
+            /* Set the mutex functions for mbed DTLS thread safety. */
+            mbedtls_platform_threading_init();
+        #endif
 
-        /* Initialize the mbed DTLS secured connection context. */
-        mbedtlsError = mbedtls_ssl_setup( &( pDtlsTransportParams->dtlsSslContext.context ),
-                                          &( pDtlsTransportParams->dtlsSslContext.config ) );
+        /* Initialize contexts for random number generation. */
+        mbedtls_entropy_init( &dtlsSharedEntropyContext );
+        mbedtls_ctr_drbg_init( &dtlsSharedCtrDrbgContext );
 
-        if( mbedtlsError != 0 )
+        #ifdef MBEDTLS_PSA_CRYPTO_C
+            if( returnStatus == DTLS_SUCCESS )
+            {
+                mbedtlsError = psa_crypto_init();
+
+                if( mbedtlsError != PSA_SUCCESS )
+                {
+                    LogError( ( "Failed to initialize PSA Crypto implementation: %d", ( int )mbedtlsError ) );
+                    returnStatus = DTLS_TRANSPORT_INTERNAL_ERROR;
+                }
+            }
+        #endif /* MBEDTLS_PSA_CRYPTO_C */
+
+        if( returnStatus == DTLS_SUCCESS )
         {
-            LogError( ( "Failed to set up mbed DTLS SSL context: mbedTLSError=-0x%x %s : %s.",
-                        mbedtlsError,
-                        mbedtlsHighLevelCodeOrDefault( mbedtlsError ),
-                        mbedtlsLowLevelCodeOrDefault( mbedtlsError ) ) );
-            returnStatus = DTLS_TRANSPORT_INTERNAL_ERROR;
+            /* Seed the random number generator. */
+            mbedtlsError = mbedtls_ctr_drbg_seed( &dtlsSharedCtrDrbgContext,
+                                                  mbedtls_entropy_func,
+                                                  &dtlsSharedEntropyContext,
+                                                  NULL,
+                                                  0 );
+
+            if( mbedtlsError != 0 )
+            {
+                LogError( ( "Failed to seed PRNG: mbedTLSError= %s : %s.", mbedtlsHighLevelCodeOrDefault( mbedtlsError ), mbedtlsLowLevelCodeOrDefault( mbedtlsError ) ) );
+                returnStatus = DTLS_TRANSPORT_INTERNAL_ERROR;
+            }
+        }
+
+        if( returnStatus == DTLS_SUCCESS )
+        {
+            dtlsSharedDrbgInitialized = 1U;
+            LogDebug( ( "Successfully initialized mbedTLS." ) );
+        }
+        else
+        {
+            mbedtls_ctr_drbg_free( &dtlsSharedCtrDrbgContext );
+            mbedtls_entropy_free( &dtlsSharedEntropyContext );
         }
+
+        pthread_mutex_unlock( &dtlsSharedDrbgMutex );
     }
 
     return returnStatus;
 }
 /*-----------------------------------------------------------*/
 
-static DtlsTransportStatus_t initMbedtls( mbedtls_entropy_context * pEntropyContext,
-                                          mbedtls_ctr_drbg_context * pCtrDrbgContext )
+DtlsTransportStatus_t DTLS_InitSharedConfig( DtlsSharedConfig_t * pSharedConfig,
+                                             mbedtls_x509_crt * pCert,
+                                             mbedtls_pk_context * pKey,
+                                             uint8_t isServer )
 {
     DtlsTransportStatus_t returnStatus = DTLS_SUCCESS;
     int32_t mbedtlsError = 0;
 
-    #if defined( MBEDTLS_THREADING_ALT )
-        /* Set the mutex functions for mbed DTLS thread safety. */
-        mbedtls_platform_threading_init();
-    #endif
-
-    /* Initialize contexts for random number generation. */
-    mbedtls_entropy_init( pEntropyContext );
-    mbedtls_ctr_drbg_init( pCtrDrbgContext );
+    if( ( pSharedConfig == NULL ) || ( pCert == NULL ) || ( pKey == NULL ) )
+    {
+        LogError( ( "Invalid input, pSharedConfig: %p, pCert: %p, pKey: %p", pSharedConfig, pCert, pKey ) );
+        returnStatus = DTLS_INVALID_PARAMETER;
+    }
 
-    if( mbedtlsError != 0 )
+    if( returnStatus == DTLS_SUCCESS )
     {
-        LogError( ( "Failed to add entropy source: mbedTLSError= %s : %s.", mbedtlsHighLevelCodeOrDefault( mbedtlsError ), mbedtlsLowLevelCodeOrDefault( mbedtlsError ) ) );
-        returnStatus = DTLS_TRANSPORT_INTERNAL_ERROR;
+        pSharedConfig->isInitialized = 0U;
+        returnStatus = initMbedtls();
     }
 
-    #ifdef MBEDTLS_PSA_CRYPTO_C
+    if( returnStatus == DTLS_SUCCESS )
+    {
+        mbedtls_ssl_config_init( &( pSharedConfig->config ) );
+        #ifdef MBEDTLS_DEBUG_C
+            mbedtls_debug_set_threshold( 1 );
+            mbedtls_ssl_conf_dbg( &( pSharedConfig->config ),
+                                  dtls_mbedtls_string_printf,
+                                  NULL );
+        #endif /* MBEDTLS_DEBUG_C */
+
+        mbedtlsError = mbedtls_ssl_config_defaults( &( pSharedConfig->config ),
+                                                    ( isServer != 0U ) ? MBEDTLS_SSL_IS_SERVER : MBEDTLS_SSL_IS_CLIENT,
+                                                    MBEDTLS_SSL_TRANSPORT_DATAGRAM,
+                                                    MBEDTLS_SSL_PRESET_DEFAULT );
+
+        if( mbedtlsError != 0 )
+        {
+            LogError( ( "Failed to set default SSL configuration: mbedTLSError= %s : %s.", mbedtlsHighLevelCodeOrDefault( mbedtlsError ), mbedtlsLowLevelCodeOrDefault( mbedtlsError ) ) );
+
+            /* Per mbed DTLS docs, mbedtls_ssl_config_defaults only fails on memory
+             * allocation. */
+            returnStatus = DTLS_TRANSPORT_INSUFFICIENT_MEMORY;
+        }
+
         if( returnStatus == DTLS_SUCCESS )
         {
-            mbedtlsError = psa_crypto_init();
+            mbedtlsError = setCredentials( pSharedConfig,
+                                           pCert,
+                                           pKey );
 
-            if( mbedtlsError != PSA_SUCCESS )
+            if( mbedtlsError != 0 )
             {
-                LogError( ( "Failed to initialize PSA Crypto implementation: %d", ( int )mbedtlsError ) );
-                returnStatus = DTLS_TRANSPORT_INTERNAL_ERROR;
+                returnStatus = DTLS_TRANSPORT_INVALID_CREDENTIALS;
             }
         }
-    #endif /* MBEDTLS_PSA_CRYPTO_C */
 
-    if( returnStatus == DTLS_SUCCESS )
-    {
-        /* Seed the random number generator. */
-        mbedtlsError = mbedtls_ctr_drbg_seed( pCtrDrbgContext,
-                                              mbedtls_entropy_func,
-                                              pEntropyContext,
-                                              NULL,
-                                              0 );
-
-        if( mbedtlsError != 0 )
+        if( returnStatus == DTLS_SUCCESS )
         {
-            LogError( ( "Failed to seed PRNG: mbedTLSError= %s : %s.", mbedtlsHighLevelCodeOrDefault( mbedtlsError ), mbedtlsLowLevelCodeOrDefault( mbedtlsError ) ) );
-            returnStatus = DTLS_TRANSPORT_INTERNAL_ERROR;
+            pSharedConfig->isInitialized = 1U;
+        }
+        else
+        {
+            mbedtls_ssl_config_free( &( pSharedConfig->config ) );
         }
     }
 
-    if( returnStatus == DTLS_SUCCESS )
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+void DTLS_FreeSharedConfig( DtlsSharedConfig_t * pSharedConfig )
+{
+    if( ( pSharedConfig != NULL ) && ( pSharedConfig->isInitialized != 0U ) )
     {
-        LogDebug( ( "Successfully initialized mbedTLS." ) );
+        mbedtls_ssl_config_free( &( pSharedConfig->config ) );
+        pSharedConfig->isInitialized = 0U;
     }
-
-    return returnStatus;
 }
 /*-----------------------------------------------------------*/
 
@@ -795,13 +1010,14 @@ int32_t DTLS_PopulateKeyingMaterial( DtlsSSLContext_t * pSslContext,
 {
     int32_t retStatus = 0;
     uint32_t offset = 0;
+    uint32_t keyLength = 0;
+    uint32_t saltLength = 0;
+    uint16_t chosenProfile = 0;
 
     TlsKeys * pKeys = NULL;
-    uint8_t keyingMaterialBuffer[MAX_SRTP_MASTER_KEY_LEN * 2 + MAX_SRTP_SALT_KEY_LEN * 2];
+    uint8_t keyingMaterialBuffer[ MAX_DTLS_SRTP_KEYING_MATERIAL_LEN ];
     #if ( MBEDTLS_VERSION_NUMBER > 0x02100600 )
         mbedtls_dtls_srtp_info negotiatedSRTPProfile;
-    #else /* #if ( MBEDTLS_VERSION_NUMBER > 0x02100600 ) */
-        mbedtls_ssl_srtp_profile negotiatedSRTPProfile;
     #endif /* #if ( MBEDTLS_VERSION_NUMBER > 0x02100600 ) */
 
     if( ( pSslContext == NULL ) || ( pDtlsKeyingMaterial == NULL ) )
@@ -814,77 +1030,80 @@ int32_t DTLS_PopulateKeyingMaterial( DtlsSSLContext_t * pSslContext,
         /* Empty else marker. */
     }
 
-    pKeys = ( TlsKeys * ) &pSslContext->tlsKeys;
+    if( retStatus == 0 )
+    {
+        /* The negotiated profile decides the key and salt lengths to export. */
+        #if ( MBEDTLS_VERSION_NUMBER > 0x02100600 )
+            mbedtls_ssl_get_dtls_srtp_negotiation_result( &pSslContext->context, &negotiatedSRTPProfile );
+            chosenProfile = ( uint16_t ) negotiatedSRTPProfile.chosen_dtls_srtp_profile;
+        #else /* #if ( MBEDTLS_VERSION_NUMBER > 0x02100600 ) */
+            chosenProfile = ( uint16_t ) mbedtls_ssl_get_dtls_srtp_protection_profile( &pSslContext->context );
+        #endif /* #if ( MBEDTLS_VERSION_NUMBER > 0x02100600 ) */
 
-    // https://mbed-tls.readthedocs.io/en/latest/kb/how-to/tls_prf/
-    retStatus = mbedtls_ssl_tls_prf( pKeys->tlsProfile,
-                                     pKeys->masterSecret,
-                                     ARRAY_SIZE( pKeys->masterSecret ),
-                                     KEYING_EXTRACTOR_LABEL,
-                                     pKeys->randBytes,
-                                     ARRAY_SIZE( pKeys->randBytes ),
-                                     keyingMaterialBuffer,
-                                     ARRAY_SIZE( keyingMaterialBuffer ) );
-    if( retStatus != 0 )
-    {
-        LogError( ( "Failed TLS-PRF function for key derivation, funct: %d", pKeys->tlsProfile ) );
-        MBEDTLS_ERROR_DESCRIPTION( retStatus );
-        retStatus = -1;
+        switch( chosenProfile )
+        {
+            case KVS_SRTP_PROFILE_AES128_CM_HMAC_SHA1_80:
+            case KVS_SRTP_PROFILE_AES128_CM_HMAC_SHA1_32:
+                keyLength = DTLS_SRTP_AES_128_KEY_LEN;
+                saltLength = DTLS_SRTP_AES_CM_SALT_LEN;
+                break;
+            default:
+                LogError( ( "DTLS_SSL_UNKNOWN_SRTP_PROFILE: 0x%04x", chosenProfile ) );
+                retStatus = DTLS_SSL_UNKNOWN_SRTP_PROFILE;
+                break;
+        }
     }
-    else
+
+    if( retStatus == 0 )
     {
-        /* Empty else marker. */
+        pKeys = ( TlsKeys * ) &pSslContext->tlsKeys;
+
+        // https://mbed-tls.readthedocs.io/en/latest/kb/how-to/tls_prf/
+        retStatus = mbedtls_ssl_tls_prf( pKeys->tlsProfile,
+                                         pKeys->masterSecret,
+                                         ARRAY_SIZE( pKeys->masterSecret ),
+                                         KEYING_EXTRACTOR_LABEL,
+                                         pKeys->randBytes,
+                                         ARRAY_SIZE( pKeys->randBytes ),
+                                         keyingMaterialBuffer,
+                                         ( keyLength + saltLength ) * 2 );
+        if( retStatus != 0 )
+        {
+            LogError( ( "Failed TLS-PRF function for key derivation, funct: %d", pKeys->tlsProfile ) );
+            MBEDTLS_ERROR_DESCRIPTION( retStatus );
+            retStatus = -1;
+        }
     }
 
     if( retStatus == 0 )
     {
-        pDtlsKeyingMaterial->key_length = MAX_SRTP_MASTER_KEY_LEN + MAX_SRTP_SALT_KEY_LEN;
+        /* Keying material is client key | server key | client salt | server salt,
+         * libsrtp expects the salt right after the key. */
+        pDtlsKeyingMaterial->srtpProfile = ( KVS_SRTP_PROFILE ) chosenProfile;
+        pDtlsKeyingMaterial->key_length = keyLength + saltLength;
 
         memcpy( pDtlsKeyingMaterial->clientWriteKey,
                 &keyingMaterialBuffer[offset],
-                MAX_SRTP_MASTER_KEY_LEN );
-        offset += MAX_SRTP_MASTER_KEY_LEN;
+                keyLength );
+        offset += keyLength;
 
         memcpy( pDtlsKeyingMaterial->serverWriteKey,
                 &keyingMaterialBuffer[offset],
-                MAX_SRTP_MASTER_KEY_LEN );
-        offset += MAX_SRTP_MASTER_KEY_LEN;
+                keyLength );
+        offset += keyLength;
 
-        memcpy( pDtlsKeyingMaterial->clientWriteKey + MAX_SRTP_MASTER_KEY_LEN,
+        memcpy( pDtlsKeyingMaterial->clientWriteKey + keyLength,
                 &keyingMaterialBuffer[offset],
-                MAX_SRTP_SALT_KEY_LEN );
-        offset += MAX_SRTP_SALT_KEY_LEN;
+                saltLength );
+        offset += saltLength;
 
-        memcpy( pDtlsKeyingMaterial->serverWriteKey + MAX_SRTP_MASTER_KEY_LEN,
+        memcpy( pDtlsKeyingMaterial->serverWriteKey + keyLength,
                 &keyingMaterialBuffer[offset],
-                MAX_SRTP_SALT_KEY_LEN );
-
-        #if ( MBEDTLS_VERSION_NUMBER > 0x02100600 )
-            mbedtls_ssl_get_dtls_srtp_negotiation_result( &pSslContext->context, &negotiatedSRTPProfile );
-            switch( negotiatedSRTPProfile.chosen_dtls_srtp_profile )
-            {
-                case MBEDTLS_TLS_SRTP_AES128_CM_HMAC_SHA1_80:
-        #else /* #if ( MBEDTLS_VERSION_NUMBER > 0x02100600 ) */
-            negotiatedSRTPProfile = mbedtls_ssl_get_dtls_srtp_protection_profile( &pSslContext->context );
-            switch( negotiatedSRTPProfile )
-            {
-                case MBEDTLS_TLS_SRTP_AES128_CM_HMAC_SHA1_80:
-                    #endif /* #if ( MBEDTLS_VERSION_NUMBER > 0x02100600 ) */
-                    pDtlsKeyingMaterial->srtpProfile = KVS_SRTP_PROFILE_AES128_CM_HMAC_SHA1_80;
-                    break;
-
-                    #if ( MBEDTLS_VERSION_NUMBER == 0x03000000 || MBEDTLS_VERSION_NUMBER == 0x03020100 )
-                        case MBEDTLS_TLS_SRTP_AES128_CM_HMAC_SHA1_32:
-                    #else /* #if ( MBEDTLS_VERSION_NUMBER == 0x03000000 || MBEDTLS_VERSION_NUMBER == 0x03020100 ) */
-                        case MBEDTLS_TLS_SRTP_AES128_CM_HMAC_SHA1_32:
-                            #endif /* #if ( MBEDTLS_VERSION_NUMBER == 0x03000000 || MBEDTLS_VERSION_NUMBER == 0x03020100 ) */
-                            pDtlsKeyingMaterial->srtpProfile = KVS_SRTP_PROFILE_AES128_CM_HMAC_SHA1_32;
-                            break;
-                        default:
-                            LogError( ( "DTLS_SSL_UNKNOWN_SRTP_PROFILE" ) );
-                            retStatus = DTLS_SSL_UNKNOWN_SRTP_PROFILE;
-            }
+                saltLength );
     }
+
+    mbedtls_platform_zeroize( keyingMaterialBuffer, sizeof( keyingMaterialBuffer ) );
+
     return retStatus;
 }
 /*-----------------------------------------------------------*/
@@ -1201,6 +1420,257 @@ int32_t DTLS_FreeCertificateAndKey( mbedtls_x509_crt * pCert,
 }
 /*-----------------------------------------------------------*/
 
+int32_t DTLS_WriteCertificateAndKey( const mbedtls_x509_crt * pCert,
+                                     mbedtls_pk_context * pKey,
+                                     const char * pCertPath,
+                                     const char * pKeyPath )
+{
+    int32_t dtlsStatus = DTLS_SUCCESS;
+    unsigned char * pKeyBuf = NULL;
+    int keyLength = 0;
+    FILE * pFile = NULL;
+    int fd = -1;
+
+    if( ( pCert == NULL ) || ( pKey == NULL ) || ( pCertPath == NULL ) || ( pKeyPath == NULL ) )
+    {
+        LogError( ( "Invalid input, pCert: %p, pKey: %p, pCertPath: %p, pKeyPath: %p", pCert, pKey, pCertPath, pKeyPath ) );
+        dtlsStatus = DTLS_INVALID_PARAMETER;
+    }
+
+    if( dtlsStatus == DTLS_SUCCESS )
+    {
+        pKeyBuf = ( unsigned char * ) malloc( GENERATED_CERTIFICATE_MAX_SIZE );
+        if( pKeyBuf == NULL )
+        {
+            LogError( ( "Fail to allocate key buffer" ) );
+            dtlsStatus = DTLS_OUT_OF_MEMORY;
+        }
+    }
+
+    if( dtlsStatus == DTLS_SUCCESS )
+    {
+        /* mbedtls_pk_write_key_der writes from the end of buffer. */
+        keyLength = mbedtls_pk_write_key_der( pKey,
+                                              pKeyBuf,
+                                              GENERATED_CERTIFICATE_MAX_SIZE );
+        if( keyLength <= 0 )
+        {
+            LogError( ( "mbedtls_pk_write_key_der failed, return: %d", keyLength ) );
+            dtlsStatus = DTLS_WRITE_CERT_FILE_FAILURE;
+        }
+    }
+
+    if( dtlsStatus == DTLS_SUCCESS )
+    {
+        pFile = fopen( pCertPath,
+                       "wb" );
+        if( ( pFile == NULL ) ||
+            ( fwrite( pCert->raw.p,
+                      1,
+                      pCert->raw.len,
+                      pFile ) != pCert->raw.len ) )
+        {
+            LogError( ( "Fail to write certificate file: %s", pCertPath ) );
+            dtlsStatus = DTLS_WRITE_CERT_FILE_FAILURE;
+        }
+
+        if( pFile != NULL )
+        {
+            fclose( pFile );
+            pFile = NULL;
+        }
+    }
+
+    if( dtlsStatus == DTLS_SUCCESS )
+    {
+        /* Private key must not be readable by others, the mode only applies
+         * on creation so an existing key file is restricted too. */
+        fd = open( pKeyPath,
+                   O_WRONLY | O_CREAT | O_TRUNC,
+                   S_IRUSR | S_IWUSR );
+        if( ( fd >= 0 ) && ( fchmod( fd, S_IRUSR | S_IWUSR ) == 0 ) )
+        {
+            pFile = fdopen( fd,
+                            "wb" );
+        }
+
+        if( ( pFile == NULL ) ||
+            ( fwrite( pKeyBuf + GENERATED_CERTIFICATE_MAX_SIZE - keyLength,
+                      1,
+                      keyLength,
+                      pFile ) != ( size_t ) keyLength ) )
+        {
+            LogError( ( "Fail to write key file: %s", pKeyPath ) );
+            dtlsStatus = DTLS_WRITE_CERT_FILE_FAILURE;
+        }
+
+        if( pFile != NULL )
+        {
+            fclose( pFile );
+        }
+        else if( fd >= 0 )
+        {
+            close( fd );
+        }
+        else
+        {
+            /* Empty else marker. */
+        }
+    }
+
+    if( pKeyBuf != NULL )
+    {
+        mbedtls_platform_zeroize( pKeyBuf,
+                                  GENERATED_CERTIFICATE_MAX_SIZE );
+        free( pKeyBuf );
+    }
+
+    return dtlsStatus;
+}
+/*-----------------------------------------------------------*/
+
+int32_t DTLS_ReadCertificateAndKey( const char * pCertPath,
+                                    const char * pKeyPath,
+                                    mbedtls_x509_crt * pCert,
+                                    mbedtls_pk_context * pKey )
+{
+    int32_t dtlsStatus = DTLS_SUCCESS;
+    int mbedtlsRet = 0;
+
+    if( ( pCert == NULL ) || ( pKey == NULL ) || ( pCertPath == NULL ) || ( pKeyPath == NULL ) )
+    {
+        LogError( ( "Invalid input, pCert: %p, pKey: %p, pCertPath: %p, pKeyPath: %p", pCert, pKey, pCertPath, pKeyPath ) );
+        dtlsStatus = DTLS_INVALID_PARAMETER;
+    }
+
+    if( dtlsStatus == DTLS_SUCCESS )
+    {
+        mbedtls_x509_crt_init( pCert );
+        mbedtls_pk_init( pKey );
+
+        /* Key parsing and checking use the shared DRBG for blinding. */
+        dtlsStatus = initMbedtls();
+    }
+
+    if( dtlsStatus == DTLS_SUCCESS )
+    {
+        mbedtlsRet = mbedtls_x509_crt_parse_file( pCert,
+                                                  pCertPath );
+        if( mbedtlsRet != 0 )
+        {
+            LogInfo( ( "No valid certificate in file: %s, return: -0x%04x", pCertPath, ( unsigned int ) -mbedtlsRet ) );
+            dtlsStatus = DTLS_READ_CERT_FILE_FAILURE;
+        }
+    }
+
+    if( dtlsStatus == DTLS_SUCCESS )
+    {
+        #if MBEDTLS_VERSION_NUMBER < 0x03000000
+            mbedtlsRet = mbedtls_pk_parse_keyfile( pKey,
+                                                   pKeyPath,
+                                                   NULL );
+        #else
+            mbedtlsRet = mbedtls_pk_parse_keyfile( pKey,
+                                                   pKeyPath,
+                                                   NULL,
+                                                   dtlsSharedDrbgRandom,
+                                                   NULL );
+        #endif /* if MBEDTLS_VERSION_NUMBER < 0x03000000 */
+        if( mbedtlsRet != 0 )
+        {
+            LogWarn( ( "No valid key in file: %s, return: -0x%04x", pKeyPath, ( unsigned int ) -mbedtlsRet ) );
+            dtlsStatus = DTLS_READ_CERT_FILE_FAILURE;
+        }
+    }
+
+    if( dtlsStatus == DTLS_SUCCESS )
+    {
+        /* Make sure the key really belongs to the certificate. */
+        #if MBEDTLS_VERSION_NUMBER < 0x03000000
+            mbedtlsRet = mbedtls_pk_check_pair( &pCert->pk,
+                                                pKey );
+        #else
+            mbedtlsRet = mbedtls_pk_check_pair( &pCert->pk,
+                                                pKey,
+                                                dtlsSharedDrbgRandom,
+                                                NULL );
+        #endif /* if MBEDTLS_VERSION_NUMBER < 0x03000000 */
+        if( mbedtlsRet != 0 )
+        {
+            LogWarn( ( "Certificate and key from files do not match, return: -0x%04x", ( unsigned int ) -mbedtlsRet ) );
+            dtlsStatus = DTLS_READ_CERT_FILE_FAILURE;
+        }
+    }
+
+    if( ( dtlsStatus != DTLS_SUCCESS ) && ( dtlsStatus != DTLS_INVALID_PARAMETER ) )
+    {
+        DTLS_FreeCertificateAndKey( pCert,
+                                    pKey );
+    }
+
+    return dtlsStatus;
+}
+/*-----------------------------------------------------------*/
+
+static int32_t dtlsConvertX509Time( const mbedtls_x509_time * pX509Time,
+                                    uint64_t * pTimeSec )
+{
+    int32_t dtlsStatus = DTLS_SUCCESS;
+    struct tm tmTime;
+    time_t timeT;
+
+    memset( &tmTime,
+            0,
+            sizeof( struct tm ) );
+    tmTime.tm_year = pX509Time->year - 1900;
+    tmTime.tm_mon = pX509Time->mon - 1;
+    tmTime.tm_mday = pX509Time->day;
+    tmTime.tm_hour = pX509Time->hour;
+    tmTime.tm_min = pX509Time->min;
+    tmTime.tm_sec = pX509Time->sec;
+
+    /* X509 time is always in UTC. */
+    timeT = timegm( &tmTime );
+    if( timeT == ( time_t ) -1 )
+    {
+        dtlsStatus = DTLS_GET_CERT_VALIDITY_FAILURE;
+    }
+    else
+    {
+        *pTimeSec = ( uint64_t ) timeT;
+    }
+
+    return dtlsStatus;
+}
+
+int32_t DTLS_GetCertificateValidity( const mbedtls_x509_crt * pCert,
+                                     uint64_t * pNotBeforeSec,
+                                     uint64_t * pNotAfterSec )
+{
+    int32_t dtlsStatus = DTLS_SUCCESS;
+
+    if( ( pCert == NULL ) || ( pNotBeforeSec == NULL ) || ( pNotAfterSec == NULL ) )
+    {
+        LogError( ( "Invalid input, pCert: %p, pNotBeforeSec: %p, pNotAfterSec: %p", pCert, pNotBeforeSec, pNotAfterSec ) );
+        dtlsStatus = DTLS_INVALID_PARAMETER;
+    }
+
+    if( dtlsStatus == DTLS_SUCCESS )
+    {
+        dtlsStatus = dtlsConvertX509Time( &pCert->valid_from,
+                                          pNotBeforeSec );
+    }
+
+    if( dtlsStatus == DTLS_SUCCESS )
+    {
+        dtlsStatus = dtlsConvertX509Time( &pCert->valid_to,
+                                          pNotAfterSec );
+    }
+
+    return dtlsStatus;
+}
+/*-----------------------------------------------------------*/
+
 DtlsTransportStatus_t DTLS_Init( DtlsNetworkContext_t * pNetworkContext,
                                  DtlsNetworkCredentials_t * pNetworkCredentials,
                                  uint8_t isServer )
@@ -1217,14 +1687,10 @@ DtlsTransportStatus_t DTLS_Init( DtlsNetworkContext_t * pNetworkContext,
                     pNetworkCredentials ) );
         returnStatus = DTLS_INVALID_PARAMETER;
     }
-    else if( NULL == pNetworkCredentials->pClientCert )
+    else if( ( NULL == pNetworkCredentials->pSharedConfig ) ||
+             ( pNetworkCredentials->pSharedConfig->isInitialized == 0U ) )
     {
-        LogError( ( "NULL == pNetworkCredentials->pClientCert" ) );
-        returnStatus = DTLS_INVALID_PARAMETER;
-    }
-    else if( NULL == pNetworkCredentials->pPrivateKey )
-    {
-        LogError( ( "NULL == pNetworkCredentials->pPrivateKey" ) );
+        LogError( ( "Shared SSL configuration is not initialized, pSharedConfig=%p", pNetworkCredentials->pSharedConfig ) );
         returnStatus = DTLS_INVALID_PARAMETER;
     }
     else if( pNetworkContext->pParams == NULL )
@@ -1237,14 +1703,15 @@ DtlsTransportStatus_t DTLS_Init( DtlsNetworkContext_t * pNetworkContext,
         /* Empty else marker. */
     }
 
-    /* Initialize mbedtls. */
     if( returnStatus == DTLS_SUCCESS )
     {
         pNetworkContext->state = DTLS_STATE_NEW;
         pDtlsTransportParams = pNetworkContext->pParams;
 
-        returnStatus = initMbedtls( &( pDtlsTransportParams->dtlsSslContext.entropyContext ),
-                                    &( pDtlsTransportParams->dtlsSslContext.ctrDrbgContext ) );
+        #if METRIC_PRINT_ENABLED
+        memset( &pDtlsTransportParams->handshakeTrace, 0, sizeof( DtlsHandshakeTrace_t ) );
+        pDtlsTransportParams->handshakeTrace.handshakeStartTimeUs = DtlsTraceGetTimeUs( CLOCK_MONOTONIC );
+        #endif /* METRIC_PRINT_ENABLED */
     }
 
     /* Initialize DTLS contexts and set credentials. */
@@ -1288,6 +1755,48 @@ DtlsTransportStatus_t DTLS_Init( DtlsNetworkContext_t * pNetworkContext,
 }
 /*-----------------------------------------------------------*/
 
+/* Same as mbedtls_ssl_handshake(), but steps through states one by one so the trace can account CPU time per step. */
+static int32_t DtlsHandshake( DtlsTransportParams_t * pDtlsTransportParams,
+                              uint8_t isTimerDriven )
+{
+    int32_t mbedtlsError = 0;
+    mbedtls_ssl_context * pSslContext = &( pDtlsTransportParams->dtlsSslContext.context );
+    #if METRIC_PRINT_ENABLED
+    DtlsHandshakeTrace_t * pTrace = &pDtlsTransportParams->handshakeTrace;
+    uint32_t prevDatagramCount = pTrace->datagramCount;
+    int prevSslState = pSslContext->state;
+    DtlsTraceStep_t step;
+    uint64_t cpuStartTimeUs;
+    #endif /* METRIC_PRINT_ENABLED */
+
+    pHandshakingSslContext = &( pDtlsTransportParams->dtlsSslContext );
+    while( ( mbedtlsError == 0 ) && ( pSslContext->state != MBEDTLS_SSL_HANDSHAKE_OVER ) )
+    {
+        #if METRIC_PRINT_ENABLED
+        step = DtlsTraceGetStep( pSslContext->state );
+        cpuStartTimeUs = DtlsTraceGetTimeUs( CLOCK_THREAD_CPUTIME_ID );
+        #endif /* METRIC_PRINT_ENABLED */
+
+        mbedtlsError = mbedtls_ssl_handshake_step( pSslContext );
+
+        #if METRIC_PRINT_ENABLED
+        pTrace->cpuTimeUs[ step ] += DtlsTraceGetTimeUs( CLOCK_THREAD_CPUTIME_ID ) - cpuStartTimeUs;
+        #endif /* METRIC_PRINT_ENABLED */
+    }
+    pHandshakingSslContext = NULL;
+
+    #if METRIC_PRINT_ENABLED
+    DtlsTraceOnHandshakeDriven( pTrace,
+                                prevDatagramCount,
+                                ( ( isTimerDriven != 0U ) && ( pTrace->flightCount > 0U ) && ( prevSslState == pSslContext->state ) ) ? 1U : 0U );
+    #else
+    ( void ) isTimerDriven;
+    #endif /* METRIC_PRINT_ENABLED */
+
+    return mbedtlsError;
+}
+/*-----------------------------------------------------------*/
+
 DtlsTransportStatus_t DTLS_ProcessPacket( DtlsNetworkContext_t * pNetworkContext,
                                           void * pDtlsPacket,
                                           size_t dtlsPacketLength,
@@ -1319,12 +1828,30 @@ DtlsTransportStatus_t DTLS_ProcessPacket( DtlsNetworkContext_t * pNetworkContext
         pDtlsTransportParams->receivedPacketLength = dtlsPacketLength;
         pDtlsTransportParams->receivedPacketOffset = 0;
 
+        #if METRIC_PRINT_ENABLED
+        if( pNetworkContext->state == DTLS_STATE_HANDSHAKING )
+        {
+            DtlsTraceOnPeerPacket( &pDtlsTransportParams->handshakeTrace );
+        }
+        #endif /* METRIC_PRINT_ENABLED */
+
         while( mbedtlsError == MBEDTLS_ERR_SSL_WANT_READ && pDtlsTransportParams->pReceivedPacket != NULL )
         {
-            /* Perform read function. Mbedtls would execute mbedtls_ssl_handshake inside if the handshake is not done. */
-            mbedtlsError = mbedtls_ssl_read( &( pDtlsTransportParams->dtlsSslContext.context ),
-                                             readBuffer + readOffset,
-                                             *pReadBufferSize - readOffset );
+            if( pDtlsTransportParams->dtlsSslContext.context.state != MBEDTLS_SSL_HANDSHAKE_OVER )
+            {
+                /* Drive the handshake step by step, then read the remaining application data if any. */
+                mbedtlsError = DtlsHandshake( pDtlsTransportParams, 0U );
+                if( mbedtlsError == 0 )
+                {
+                    mbedtlsError = MBEDTLS_ERR_SSL_WANT_READ;
+                }
+            }
+            else
+            {
+                mbedtlsError = mbedtls_ssl_read( &( pDtlsTransportParams->dtlsSslContext.context ),
+                                                 readBuffer + readOffset,
+                                                 *pReadBufferSize - readOffset );
+            }
 
             if( ( mbedtlsError == MBEDTLS_ERR_SSL_TIMEOUT ) || ( mbedtlsError == MBEDTLS_ERR_SSL_WANT_READ ) || ( mbedtlsError == MBEDTLS_ERR_SSL_WANT_WRITE ) )
             {
@@ -1369,6 +1896,10 @@ DtlsTransportStatus_t DTLS_ProcessPacket( DtlsNetworkContext_t * pNetworkContext
                 /* Update the state to connected. */
                 pNetworkContext->state = DTLS_STATE_READY;
                 returnStatus = DTLS_HANDSHAKE_COMPLETE;
+
+                #if METRIC_PRINT_ENABLED
+                DtlsTraceOnHandshakeComplete( &pDtlsTransportParams->handshakeTrace );
+                #endif /* METRIC_PRINT_ENABLED */
             }
         }
     }
@@ -1405,10 +1936,11 @@ DtlsTransportStatus_t DTLS_ExecuteHandshake( DtlsNetworkContext_t * pNetworkCont
     {
         pDtlsTransportParams = pNetworkContext->pParams;
 
-        /* Continuously loop while the local side should trigger the handshake. */
+        /* Continuously loop while the local side should trigger the handshake.
+         * Without incoming packet, anything sent after the first flight is a retransmission. */
         do
         {
-            mbedtlsError = mbedtls_ssl_handshake( &( pDtlsTransportParams->dtlsSslContext.context ) );
+            mbedtlsError = DtlsHandshake( pDtlsTransportParams, 1U );
         } while( mbedtlsError == MBEDTLS_ERR_SSL_WANT_WRITE );
 
         if( mbedtlsError == MBEDTLS_ERR_SSL_WANT_READ )
@@ -1427,6 +1959,10 @@ DtlsTransportStatus_t DTLS_ExecuteHandshake( DtlsNetworkContext_t * pNetworkCont
         {
             pNetworkContext->state = DTLS_STATE_READY;
             returnStatus = DTLS_HANDSHAKE_COMPLETE;
+
+            #if METRIC_PRINT_ENABLED
+            DtlsTraceOnHandshakeComplete( &pDtlsTransportParams->handshakeTrace );
+            #endif /* METRIC_PRINT_ENABLED */
         }
     }
 
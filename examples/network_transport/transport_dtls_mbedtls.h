@@ -48,6 +48,11 @@
 #define CERTIFICATE_FINGERPRINT_LENGTH 160
 #define MAX_SRTP_MASTER_KEY_LEN 16
 #define MAX_SRTP_SALT_KEY_LEN 14
+#define MAX_DTLS_SRTP_KEYING_MATERIAL_LEN ( MAX_SRTP_MASTER_KEY_LEN * 2 + MAX_SRTP_SALT_KEY_LEN * 2 )
+
+/* Master key and salt lengths of each SRTP profile, see RFC 5764. */
+#define DTLS_SRTP_AES_128_KEY_LEN 16
+#define DTLS_SRTP_AES_CM_SALT_LEN 14
 #define MAX_DTLS_RANDOM_BYTES_LEN 32
 #define MAX_DTLS_MASTER_KEY_LEN 48
 
@@ -86,20 +91,27 @@ typedef struct
     mbedtls_tls_prf_types tlsProfile;
 } TlsKeys;
 
+/**
+ * @brief SSL configuration shared by all DTLS sessions using the same certificate.
+ *
+ * It's never modified after DTLS_InitSharedConfig, so sessions can set up
+ * their SSL contexts from it concurrently. Random numbers come from the
+ * process-wide DRBG.
+ */
+typedef struct DtlsSharedConfig
+{
+    uint8_t isInitialized;
+    mbedtls_ssl_config config;               /**< @brief SSL connection configuration. */
+    mbedtls_x509_crt_profile certProfile;    /**< @brief Certificate security profile for the connections. */
+} DtlsSharedConfig_t;
+
 /**
  * @brief Secured connection context.
  */
 typedef struct DtlsSSLContext
 {
-    mbedtls_ssl_config config;               /**< @brief SSL connection configuration. */
     mbedtls_ssl_context context;             /**< @brief SSL connection context */
-    mbedtls_x509_crt_profile certProfile;    /**< @brief Certificate security profile for this connection. */
-    mbedtls_x509_crt rootCa;                 /**< @brief Root CA certificate context. */
-    mbedtls_x509_crt clientCert;             /**< @brief Client certificate context. */
-    mbedtls_pk_context privKey;              /**< @brief Client private key context. */
     TlsKeys tlsKeys;                         /**< @brief Client private key context. */
-    mbedtls_entropy_context entropyContext;  /**< @brief Entropy context for random number generation. */
-    mbedtls_ctr_drbg_context ctrDrbgContext; /**< @brief CTR DRBG context for random number generation. */
 } DtlsSSLContext_t;
 
 typedef void (* mbedtls_set_delay_fptr)( void *,
@@ -123,6 +135,32 @@ typedef struct DtlsRetransmissionParams
     uint32_t dtlsSessionSetupTime;
 } DtlsRetransmission_t;
 
+#if METRIC_PRINT_ENABLED
+/* Handshake steps that CPU time is accounted to, grouped by mbedtls handshake states. */
+typedef enum DtlsTraceStep
+{
+    DTLS_TRACE_STEP_HELLO = 0,          /* Hello and hello verify request. */
+    DTLS_TRACE_STEP_KEY_EXCHANGE,       /* Peer certificate, signature verification and ECDHE. */
+    DTLS_TRACE_STEP_CERTIFICATE_VERIFY, /* Signing with local private key. */
+    DTLS_TRACE_STEP_FINISHED,           /* Change cipher spec and finished messages. */
+    DTLS_TRACE_STEP_MAX,
+} DtlsTraceStep_t;
+
+#define DTLS_TRACE_MAX_FLIGHTS ( 8 )
+
+typedef struct DtlsHandshakeTrace
+{
+    uint64_t handshakeStartTimeUs;
+    /* Time that each local flight is sent, the flights beyond DTLS_TRACE_MAX_FLIGHTS are counted only. */
+    uint64_t flightSentTimeUs[ DTLS_TRACE_MAX_FLIGHTS ];
+    uint32_t flightCount;
+    uint32_t datagramCount;
+    uint32_t retransmissionCount;
+    uint8_t isAwaitingPeerFlight;
+    uint64_t cpuTimeUs[ DTLS_TRACE_STEP_MAX ];
+} DtlsHandshakeTrace_t;
+#endif /* METRIC_PRINT_ENABLED */
+
 /**
  * @brief Parameters for the network context of the transport interface
  * implementation that uses mbedTLS and UDP sockets.
@@ -138,6 +176,10 @@ typedef struct DtlsTransportParams
     uint8_t * pReceivedPacket;
     size_t receivedPacketLength;
     size_t receivedPacketOffset;
+
+    #if METRIC_PRINT_ENABLED
+    DtlsHandshakeTrace_t handshakeTrace;
+    #endif /* METRIC_PRINT_ENABLED */
 } DtlsTransportParams_t;
 
 typedef enum DtlsState
@@ -197,8 +239,7 @@ typedef struct DtlsNetworkCredentials
 
     const uint8_t * pRootCa;     /**< @brief String representing a trusted server root certificate. */
     size_t rootCaSize;          /**< @brief Size associated with #NetworkCredentials.pRootCa. */
-    mbedtls_x509_crt * pClientCert;             /**< @brief Client certificate context. */
-    mbedtls_pk_context * pPrivateKey;
+    DtlsSharedConfig_t * pSharedConfig;         /**< @brief Shared SSL configuration holding local certificate and key. */
 
     DtlsKeyingMaterial dtlsKeyingMaterial; /**< @brief derivated SRTP keys */
 } DtlsNetworkCredentials_t;
@@ -241,6 +282,9 @@ typedef enum DtlsTransportStatus
     DTLS_GENERATE_TIMESTAMP_STRING_FAILURE,          /**< Fail to generate timestamp string. */
     DTLS_READ_BINARY_FAILURE,                        /**< Fail to read binary. */
     DTLS_GENERATE_RANDOM_BITS_FAILURE,               /**< Fail to generate random bits. */
+    DTLS_READ_CERT_FILE_FAILURE,                     /**< Fail to read certificate or key from file. */
+    DTLS_WRITE_CERT_FILE_FAILURE,                    /**< Fail to write certificate or key to file. */
+    DTLS_GET_CERT_VALIDITY_FAILURE,                  /**< Fail to convert certificate validity period. */
 
     DTLS_SSL_REMOTE_CERTIFICATE_VERIFICATION_FAILED, /**< The remote certificate failed verification. */
     DTLS_SSL_UNKNOWN_SRTP_PROFILE,                   /**< The SRTP profile is unknown. */
@@ -285,6 +329,32 @@ DtlsTransportStatus_t DTLS_Init( DtlsNetworkContext_t * pNetworkContext,
                                  DtlsNetworkCredentials_t * pNetworkCredentials,
                                  uint8_t isServer );
 
+/**
+ * @brief Initialize the SSL configuration shared by DTLS sessions.
+ *
+ * @param[out] pSharedConfig The shared configuration to initialize.
+ * @param[in] pCert The local certificate, it must outlive the shared configuration.
+ * @param[in] pKey The local key, it must outlive the shared configuration.
+ * @param[in] isServer Boolean flag indicating the DTLS role of the sessions:
+ *                     - 0: Sessions are DTLS clients
+ *                     - 1: Sessions are DTLS servers
+ *
+ * @return DtlsTransportStatus_t Returns the status of the initialization:
+ *         - DTLS_SUCCESS if initialization is successful
+ *         - Other specific error codes in case of failure
+ */
+DtlsTransportStatus_t DTLS_InitSharedConfig( DtlsSharedConfig_t * pSharedConfig,
+                                             mbedtls_x509_crt * pCert,
+                                             mbedtls_pk_context * pKey,
+                                             uint8_t isServer );
+
+/**
+ * @brief Free the shared SSL configuration after all sessions using it are freed.
+ *
+ * @param[in] pSharedConfig The shared configuration to free.
+ */
+void DTLS_FreeSharedConfig( DtlsSharedConfig_t * pSharedConfig );
+
 /**
  * @brief Gracefully disconnect an established DTLS connection.
  *
@@ -387,6 +457,55 @@ int32_t DTLS_CreateCertificateAndKey( int32_t certificateBits,
 int32_t DTLS_FreeCertificateAndKey( mbedtls_x509_crt * pCert,
                                     mbedtls_pk_context * pKey );
 
+/**
+ * @brief Write certificate and key to files in DER format.
+ *
+ * @param[in] pCert The DTLS certificate to be written.
+ * @param[in] pKey The DTLS key to be written.
+ * @param[in] pCertPath The path of certificate file.
+ * @param[in] pKeyPath The path of key file, it's created with owner-only permission.
+ *
+ * @return DtlsTransportStatus_t Returns the status of the write:
+ *         - DTLS_SUCCESS if both files are written.
+ *         - Other specific error codes in case of failure
+ */
+int32_t DTLS_WriteCertificateAndKey( const mbedtls_x509_crt * pCert,
+                                     mbedtls_pk_context * pKey,
+                                     const char * pCertPath,
+                                     const char * pKeyPath );
+
+/**
+ * @brief Read certificate and key from files written by DTLS_WriteCertificateAndKey.
+ *
+ * @param[in] pCertPath The path of certificate file.
+ * @param[in] pKeyPath The path of key file.
+ * @param[out] pCert The DTLS certificate loaded.
+ * @param[out] pKey The DTLS key loaded.
+ *
+ * @return DtlsTransportStatus_t Returns the status of the read:
+ *         - DTLS_SUCCESS if certificate and key are loaded.
+ *         - Other specific error codes in case of failure
+ */
+int32_t DTLS_ReadCertificateAndKey( const char * pCertPath,
+                                    const char * pKeyPath,
+                                    mbedtls_x509_crt * pCert,
+                                    mbedtls_pk_context * pKey );
+
+/**
+ * @brief Get the validity period of certificate in seconds since epoch.
+ *
+ * @param[in] pCert The DTLS certificate.
+ * @param[out] pNotBeforeSec The start time of validity period.
+ * @param[out] pNotAfterSec The end time of validity period.
+ *
+ * @return DtlsTransportStatus_t Returns the status of the conversion:
+ *         - DTLS_SUCCESS if validity period is retrieved.
+ *         - Other specific error codes in case of failure
+ */
+int32_t DTLS_GetCertificateValidity( const mbedtls_x509_crt * pCert,
+                                     uint64_t * pNotBeforeSec,
+                                     uint64_t * pNotAfterSec );
+
 /**
  * @brief Generates a fingerprint of the certificate.
  *
@@ -17,8 +17,10 @@
 /* Interface includes. */
 #include "networking.h"
 
-/* SigV4 headers. */
-#include "sigv4.h"
+#if METRIC_PRINT_ENABLED
+#include "metric.h"
+#endif
+#include "networking_utils.h"
 
 /*----------------------------------------------------------------------------*/
 
@@ -31,18 +33,6 @@
 #define MAX( a, b ) ( ( ( a ) > ( b ) ) ? ( a ) : ( b ) )
 #endif
 
-#define NETWORKING_USE_OPENSSL ( 0 )
-#define NETWORKING_USE_MBEDTLS ( 1 )
-
-/*----------------------------------------------------------------------------*/
-
-#if NETWORKING_USE_MBEDTLS
-    /**
-     *  @brief mbedTLS Hash Context passed to SigV4 crypto interface for generating the hash digest.
-     */
-    static mbedtls_sha256_context xHashContext = { 0 };
-#endif /* NETWORKING_USE_MBEDTLS */
-
 /*----------------------------------------------------------------------------*/
 
 static int LwsHttpCallback( struct lws * pWsi,
@@ -59,105 +49,6 @@ static int LwsWebsocketCallback( struct lws * pWsi,
 
 /*----------------------------------------------------------------------------*/
 
-#if NETWORKING_USE_OPENSSL
-    static int32_t Sha256Init( void * pHashContext )
-    {
-        int32_t ret = 0;
-        const EVP_MD * md = EVP_sha256();
-
-        ret = EVP_DigestInit( pHashContext, md );
-
-        if( ret != 1 )
-        {
-            LogError( ( "Failed to initialize EVP_sha256!" ) );
-        }
-
-        return ret == 1 ? 0 : -1;
-    }
-
-/*----------------------------------------------------------------------------*/
-
-    static int32_t Sha256Update( void * pHashContext,
-                                 const uint8_t * pInput,
-                                 size_t inputLen )
-    {
-        int32_t ret = 0;
-
-        ret = EVP_DigestUpdate( pHashContext, pInput, inputLen );
-
-        if( ret != 1 )
-        {
-            LogError( ( "Failed to update EVP_sha256!" ) );
-        }
-
-        return ret == 1 ? 0 : -1;
-    }
-
-/*----------------------------------------------------------------------------*/
-
-    static int32_t Sha256Final( void * pHashContext,
-                                uint8_t * pOutput,
-                                size_t outputLen )
-    {
-        int32_t ret = 0;
-        unsigned int outLength = outputLen;
-
-        ret = EVP_DigestFinal( pHashContext, pOutput, &( outLength ) );
-
-        if( ret != 1 )
-        {
-            LogError( ( "Failed to finalize EVP_sha256!" ) );
-        }
-
-        return ret == 1 ? 0 : -1;
-    }
-
-/*----------------------------------------------------------------------------*/
-
-#elif NETWORKING_USE_MBEDTLS /* if NETWORKING_USE_OPENSSL */
-    static int32_t Sha256Init( void * hashContext )
-    {
-        mbedtls_sha256_init( ( mbedtls_sha256_context * ) hashContext );
-        mbedtls_sha256_starts( hashContext, 0 );
-
-        return 0;
-    }
-
-/*----------------------------------------------------------------------------*/
-
-    static int32_t Sha256Update( void * hashContext,
-                                 const uint8_t * pInput,
-                                 size_t inputLen )
-    {
-        mbedtls_sha256_update( hashContext, pInput, inputLen );
-
-        return 0;
-    }
-
-/*----------------------------------------------------------------------------*/
-
-    static int32_t Sha256Final( void * hashContext,
-                                uint8_t * pOutput,
-                                size_t outputLen )
-    {
-        int32_t ret = 0;
-
-        if( outputLen < 32 )
-        {
-            LogError( ( "Invalid output length (%lu) for SHA256!", outputLen ) );
-            ret = -1;
-        }
-        else
-        {
-            mbedtls_sha256_finish( hashContext, pOutput );
-        }
-
-        return ret;
-    }
-#endif /* elif NETWORKING_USE_MBEDTLS */
-
-/*----------------------------------------------------------------------------*/
-
 static int GetHostFromUrl( const char * pUrl,
                            size_t urlLength,
                            const char ** ppHost,
@@ -222,6 +113,56 @@ static int GetHostFromUrl( const char * pUrl,
 
 /*----------------------------------------------------------------------------*/
 
+static int GetPortFromUrl( const char * pUrl,
+                           size_t urlLength,
+                           uint16_t * pPort )
+{
+    int ret = 0;
+    const char * pHost = NULL, * pCurPtr, * pEnd = pUrl + urlLength;
+    size_t hostLength = 0;
+    uint32_t port = 0;
+
+    ret = GetHostFromUrl( pUrl, urlLength, &( pHost ), &( hostLength ) );
+
+    if( ret == 0 )
+    {
+        pCurPtr = pHost + hostLength;
+
+        if( ( pCurPtr < pEnd ) && ( *pCurPtr == ':' ) )
+        {
+            /* An explicit port, e.g. a local test server. */
+            for( pCurPtr++; ( pCurPtr < pEnd ) && ( *pCurPtr >= '0' ) && ( *pCurPtr <= '9' ); pCurPtr++ )
+            {
+                port = port * 10U + ( uint32_t ) ( *pCurPtr - '0' );
+
+                if( port > UINT16_MAX )
+                {
+                    ret = -1;
+                    break;
+                }
+            }
+
+            if( port == 0U )
+            {
+                ret = -1;
+            }
+        }
+        else
+        {
+            port = NETWORKING_DEFAULT_TLS_PORT;
+        }
+    }
+
+    if( ret == 0 )
+    {
+        *pPort = ( uint16_t ) port;
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
 static int GetPathFromUrl( const char * pUrl,
                            size_t urlLength,
                            const char ** ppPath,
@@ -238,6 +179,17 @@ static int GetPathFromUrl( const char * pUrl,
     {
         pPathStart = pHost + hostLength;
 
+        /* Skip the port, if any. */
+        if( *pPathStart == ':' )
+        {
+            pPathStart++;
+
+            while( ( *pPathStart >= '0' ) && ( *pPathStart <= '9' ) )
+            {
+                pPathStart++;
+            }
+        }
+
         /* Query portion starts with '?'. */
         pQueryStart = strchr( pPathStart, '?' );
 
@@ -263,24 +215,32 @@ static int GetPathFromUrl( const char * pUrl,
 /*----------------------------------------------------------------------------*/
 
 static int GetCurrentTimeInIso8601Format( char * pBuf,
-                                          size_t * pBufLength )
+                                          size_t * pBufLength,
+                                          time_t * pFormattedTime )
 {
     int ret = 0;
     time_t now;
     size_t timeLength = 0;
+    struct tm utcTime;
 
     time( &( now ) );
-    timeLength = strftime( pBuf, *pBufLength, "%Y%m%dT%H%M%SZ", gmtime( &( now ) ) );
 
-    if( timeLength <= 0 )
+    /* Requests within the same second share the formatted time. */
+    if( now != *pFormattedTime )
     {
-        LogError( ( "Fail to strftime, length: %lu", timeLength ) );
-        ret = -1;
-    }
+        timeLength = strftime( pBuf, ISO8601_TIME_LENGTH, "%Y%m%dT%H%M%SZ", gmtime_r( &( now ), &( utcTime ) ) );
 
-    if( ret == 0 )
-    {
-        *pBufLength = timeLength;
+        if( timeLength <= 0 )
+        {
+            LogError( ( "Fail to strftime, length: %lu", timeLength ) );
+            ret = -1;
+        }
+
+        if( ret == 0 )
+        {
+            *pBufLength = timeLength;
+            *pFormattedTime = now;
+        }
     }
 
     return ret;
@@ -288,170 +248,177 @@ static int GetCurrentTimeInIso8601Format( char * pBuf,
 
 /*----------------------------------------------------------------------------*/
 
-static int UriEncode( const char * pSrc,
-                      size_t srcLength,
-                      char * pDst,
-                      size_t * pDstLength )
+static int SignHttpRequest( NetworkingHttpContext_t * pHttpCtx,
+                            HttpRequest_t * pRequest,
+                            const AwsCredentials_t * pAwsCredentials,
+                            const AwsConfig_t * pAwsConfig )
 {
-    int ret = 0;
-    char ch;
-    size_t i, j, remainingLength = *pDstLength;
-    const char alpha[ 17 ] = "0123456789ABCDEF";
+    int ret = 0, snprintfRetVal;
+    size_t writtenLength = 0, remainingLength = SIGV4_METADATA_BUFFER_LENGTH, encodedLength;
+    char signature[ NETWORKING_SIGV4_HEX_DIGEST_LENGTH ];
+    char payloadHash[ NETWORKING_SIGV4_HEX_DIGEST_LENGTH ];
+    const HttpRequestHeader_t * pUserAgentHeader = &( pHttpCtx->requiredHeaders[ REQUIRED_HEADER_USER_AGENT_IDX ] );
+    const HttpRequestHeader_t * pDateHeader = &( pHttpCtx->requiredHeaders[ REQUIRED_HEADER_ISO8601_TIME_IDX ] );
+
+    /* Signing key is only derived again when the day or the credentials change. */
+    ret = NetworkingSigV4_PrepareCache( &( pHttpCtx->sigV4Cache ),
+                                        pDateHeader->pValue,
+                                        pAwsCredentials->pAccessKeyId,
+                                        pAwsCredentials->accessKeyIdLen,
+                                        pAwsCredentials->pSecretAccessKey,
+                                        pAwsCredentials->secretAccessKeyLen,
+                                        pAwsConfig->pRegion,
+                                        pAwsConfig->regionLen,
+                                        pAwsConfig->pService,
+                                        pAwsConfig->serviceLen );
+
+    if( ret != 0 )
+    {
+        LogError( ( "Failed to prepare SigV4 signing key!" ) );
+    }
+
+    /* Write HTTP method and canonical URI. */
+    if( ret == 0 )
+    {
+        snprintfRetVal = snprintf( &( pHttpCtx->sigV4Metadata[ writtenLength ] ),
+                                   remainingLength,
+                                   "%s\n",
+                                   ( pRequest->verb == HTTP_POST ) ? "POST" : "GET" );
+
+        if( ( snprintfRetVal < 0 ) || ( snprintfRetVal >= remainingLength ) )
+        {
+            ret = -1;
+        }
+        else
+        {
+            writtenLength += snprintfRetVal;
+            remainingLength -= snprintfRetVal;
+        }
+    }
 
-    for( i = 0, j = 0; i < srcLength; i++ )
+    if( ret == 0 )
+    {
+        encodedLength = remainingLength;
+        ret = NetworkingSigV4_CanonicalizePath( &( pHttpCtx->uriPath[ 0 ] ),
+                                                pHttpCtx->uriPathLength,
+                                                &( pHttpCtx->sigV4Metadata[ writtenLength ] ),
+                                                &( encodedLength ) );
+        if( ret == 0 )
+        {
+            writtenLength += encodedLength;
+            remainingLength -= encodedLength;
+        }
+        else
+        {
+            LogError( ( "Failed to write canonical URI!" ) );
+        }
+    }
+
+    /* Write empty query and canonical headers, which are in sorted order. */
+    if( ret == 0 )
     {
-        ch = pSrc[ i ];
+        snprintfRetVal = snprintf( &( pHttpCtx->sigV4Metadata[ writtenLength ] ),
+                                   remainingLength,
+                                   "\n\nhost:%.*s\n%s:",
+                                   ( int ) pHttpCtx->uriHostLength,
+                                   &( pHttpCtx->uriHost[ 0 ] ),
+                                   pUserAgentHeader->pName );
 
-        if( ( ( ch >= 'A' ) && ( ch <= 'Z' ) ) ||
-            ( ( ch >= 'a' ) && ( ch <= 'z' ) ) ||
-            ( ( ch >= '0' ) && ( ch <= '9' ) ) ||
-            ( ch == '_' ) ||
-            ( ch == '-' ) ||
-            ( ch == '~' ) ||
-            ( ch == '.' ) )
+        if( ( snprintfRetVal < 0 ) || ( snprintfRetVal >= remainingLength ) )
         {
-            if( remainingLength < 1 )
-            {
-                ret = -1;
-                break;
-            }
-            else
-            {
-                pDst[ j ] = ch;
-                j++;
-                remainingLength -= 1;
-            }
+            ret = -1;
         }
-        else if( ch == '/' )
+        else
         {
-            if( remainingLength < 3 )
-            {
-                ret = -1;
-                break;
-            }
-            else
-            {
-                pDst[ j ] = '%';
-                pDst[ j + 1 ] = '2';
-                pDst[ j + 2 ] = 'F';
-                j += 3;
-                remainingLength -= 3;
-            }
+            writtenLength += snprintfRetVal;
+            remainingLength -= snprintfRetVal;
+        }
+    }
+
+    if( ret == 0 )
+    {
+        encodedLength = remainingLength;
+        ret = NetworkingSigV4_CanonicalizeHeaderValue( pUserAgentHeader->pValue,
+                                                       pUserAgentHeader->valueLength,
+                                                       &( pHttpCtx->sigV4Metadata[ writtenLength ] ),
+                                                       &( encodedLength ) );
+        if( ret == 0 )
+        {
+            writtenLength += encodedLength;
+            remainingLength -= encodedLength;
         }
         else
         {
-            if( remainingLength < 3 )
-            {
-                ret = -1;
-                break;
-            }
-            else
-            {
-                pDst[ j ] = '%';
-                pDst[ j + 1 ] = alpha[ ch >> 4 ];
-                pDst[ j + 2 ] = alpha[ ch & 0x0F ];
-                j += 3;
-                remainingLength -= 3;
-            }
+            LogError( ( "Failed to write user agent header!" ) );
         }
     }
 
     if( ret == 0 )
     {
-        *pDstLength = j;
+        ret = NetworkingSigV4_HexHash( ( const uint8_t * ) pRequest->pBody,
+                                       pRequest->bodyLength,
+                                       &( payloadHash[ 0 ] ) );
     }
 
-    return ret;
-}
+    /* Write date header, signed headers and payload hash. */
+    if( ret == 0 )
+    {
+        snprintfRetVal = snprintf( &( pHttpCtx->sigV4Metadata[ writtenLength ] ),
+                                   remainingLength,
+                                   "\n%s:%.*s\n\nhost;%s;%s\n%.*s",
+                                   pDateHeader->pName,
+                                   ( int ) pDateHeader->valueLength,
+                                   pDateHeader->pValue,
+                                   pUserAgentHeader->pName,
+                                   pDateHeader->pName,
+                                   NETWORKING_SIGV4_HEX_DIGEST_LENGTH,
+                                   &( payloadHash[ 0 ] ) );
 
-/*----------------------------------------------------------------------------*/
+        if( ( snprintfRetVal < 0 ) || ( snprintfRetVal >= remainingLength ) )
+        {
+            ret = -1;
+        }
+        else
+        {
+            writtenLength += snprintfRetVal;
+            remainingLength -= snprintfRetVal;
+        }
+    }
 
-static int SignHttpRequest( NetworkingHttpContext_t * pHttpCtx,
-                            HttpRequest_t * pRequest,
-                            const AwsCredentials_t * pAwsCredentials,
-                            const AwsConfig_t * pAwsConfig )
-{
-    int ret = 0, snprintfRetVal;
-    char * pSignature;
-    size_t signatureLength;
-    SigV4HttpParameters_t sigv4HttpParams;
-    SigV4Parameters_t sigv4Params;
-    SigV4Credentials_t sigv4Credentials;
-    SigV4CryptoInterface_t sigv4CryptoInterface;
-
-    snprintfRetVal = snprintf( &( pHttpCtx->sigV4Metadata[ 0 ] ),
-                               SIGV4_METADATA_BUFFER_LENGTH,
-                               "host: %.*s\r\n%s: %.*s\r\n%s: %.*s\r\n",
-                               ( int ) pHttpCtx->uriHostLength,
-                               &( pHttpCtx->uriHost[ 0 ] ),
-                               pHttpCtx->requiredHeaders[ REQUIRED_HEADER_USER_AGENT_IDX ].pName,
-                               ( int ) pHttpCtx->requiredHeaders[ REQUIRED_HEADER_USER_AGENT_IDX ].valueLength,
-                               pHttpCtx->requiredHeaders[ REQUIRED_HEADER_USER_AGENT_IDX ].pValue,
-                               pHttpCtx->requiredHeaders[ REQUIRED_HEADER_ISO8601_TIME_IDX ].pName,
-                               ( int ) pHttpCtx->requiredHeaders[ REQUIRED_HEADER_ISO8601_TIME_IDX ].valueLength,
-                               pHttpCtx->requiredHeaders[ REQUIRED_HEADER_ISO8601_TIME_IDX ].pValue );
-
-    if( ( snprintfRetVal < 0 ) || ( snprintfRetVal == SIGV4_METADATA_BUFFER_LENGTH ) )
+    if( ret == 0 )
     {
-        ret = -1;
+        if( NetworkingSigV4_Sign( &( pHttpCtx->sigV4Cache ),
+                                  pDateHeader->pValue,
+                                  &( pHttpCtx->sigV4Metadata[ 0 ] ),
+                                  writtenLength,
+                                  &( signature[ 0 ] ) ) != 0 )
+        {
+            LogError( ( "Failed to generate SigV4 signature!" ) );
+            ret = -1;
+        }
     }
 
     if( ret == 0 )
     {
-        sigv4HttpParams.pHttpMethod = ( pRequest->verb == HTTP_POST ) ? "POST" : "GET";
-        sigv4HttpParams.httpMethodLen = strlen( sigv4HttpParams.pHttpMethod );
-        sigv4HttpParams.flags = 0;
-        sigv4HttpParams.pPath = &( pHttpCtx->uriPath[ 0 ] );
-        sigv4HttpParams.pathLen = pHttpCtx->uriPathLength;
-        sigv4HttpParams.pQuery = NULL;
-        sigv4HttpParams.queryLen = 0;
-        sigv4HttpParams.pHeaders = &( pHttpCtx->sigV4Metadata[ 0 ] );
-        sigv4HttpParams.headersLen = snprintfRetVal;
-        sigv4HttpParams.pPayload = pRequest->pBody;
-        sigv4HttpParams.payloadLen = pRequest->bodyLength;
-
-        sigv4Credentials.pAccessKeyId = pAwsCredentials->pAccessKeyId;
-        sigv4Credentials.accessKeyIdLen = pAwsCredentials->accessKeyIdLen;
-        sigv4Credentials.pSecretAccessKey = pAwsCredentials->pSecretAccessKey;
-        sigv4Credentials.secretAccessKeyLen = pAwsCredentials->secretAccessKeyLen;
-
-        sigv4CryptoInterface.hashInit = Sha256Init;
-        sigv4CryptoInterface.hashUpdate = Sha256Update;
-        sigv4CryptoInterface.hashFinal = Sha256Final;
-        #if NETWORKING_USE_OPENSSL
-            sigv4CryptoInterface.pHashContext = EVP_MD_CTX_new();
-        #elif NETWORKING_USE_MBEDTLS /* if NETWORKING_USE_OPENSSL */
-            sigv4CryptoInterface.pHashContext = &xHashContext;
-        #endif /* elif NETWORKING_USE_MBEDTLS */
-        sigv4CryptoInterface.hashBlockLen = 64;
-        sigv4CryptoInterface.hashDigestLen = 32;
-
-        sigv4Params.pCredentials = &( sigv4Credentials );
-        sigv4Params.pDateIso8601 = pHttpCtx->requiredHeaders[ REQUIRED_HEADER_ISO8601_TIME_IDX ].pValue;
-        sigv4Params.pAlgorithm = NULL;
-        sigv4Params.algorithmLen = 0;
-        sigv4Params.pRegion = pAwsConfig->pRegion;
-        sigv4Params.regionLen = pAwsConfig->regionLen;
-        sigv4Params.pService = pAwsConfig->pService;
-        sigv4Params.serviceLen = pAwsConfig->serviceLen;
-        sigv4Params.pCryptoInterface = &( sigv4CryptoInterface );
-        sigv4Params.pHttpParameters = &( sigv4HttpParams );
-
-        pHttpCtx->sigv4AuthorizationHeaderLength = SIGV4_AUTHORIZATION_HEADER_BUFFER_LENGTH;
-
-        if( SigV4_GenerateHTTPAuthorization( &( sigv4Params ),
-                                             &( pHttpCtx->sigv4AuthorizationHeader[ 0 ] ),
-                                             &( pHttpCtx->sigv4AuthorizationHeaderLength ),
-                                             &( pSignature ),
-                                             &( signatureLength ) ) != SigV4Success )
+        snprintfRetVal = snprintf( &( pHttpCtx->sigv4AuthorizationHeader[ 0 ] ),
+                                   SIGV4_AUTHORIZATION_HEADER_BUFFER_LENGTH,
+                                   NETWORKING_SIGV4_ALGORITHM " Credential=%.*s, SignedHeaders=host;%s;%s, Signature=%.*s",
+                                   ( int ) pHttpCtx->sigV4Cache.credentialLength,
+                                   &( pHttpCtx->sigV4Cache.credential[ 0 ] ),
+                                   pUserAgentHeader->pName,
+                                   pDateHeader->pName,
+                                   NETWORKING_SIGV4_HEX_DIGEST_LENGTH,
+                                   &( signature[ 0 ] ) );
+
+        if( ( snprintfRetVal < 0 ) || ( snprintfRetVal >= SIGV4_AUTHORIZATION_HEADER_BUFFER_LENGTH ) )
         {
             LogError( ( "Failed to generate SigV4 authorization header!" ) );
             ret = -1;
         }
-
-        #if NETWORKING_USE_OPENSSL
-            EVP_MD_CTX_free( sigv4CryptoInterface.pHashContext );
-        #endif /* NETWORKING_USE_OPENSSL */
+        else
+        {
+            pHttpCtx->sigv4AuthorizationHeaderLength = snprintfRetVal;
+        }
     }
 
     if( ret == 0 )
@@ -466,327 +433,142 @@ static int SignHttpRequest( NetworkingHttpContext_t * pHttpCtx,
 
 /*----------------------------------------------------------------------------*/
 
-static int SignWebsocketRequest( NetworkingWebsocketContext_t * pWebsocketCtx,
-                                 const WebsocketConnectInfo_t * pConnectInfo,
-                                 const AwsCredentials_t * pAwsCredentials,
-                                 const AwsConfig_t * pAwsConfig )
+static int UpdateEncodedChannelArn( NetworkingWebsocketContext_t * pWebsocketCtx,
+                                    const WebsocketConnectInfo_t * pConnectInfo )
 {
-    int ret = 0, snprintfRetVal;
-    const char * pPath, * pQueryStart, * pUrlEnd, * pEqualSign, * pChannelArnValue;
-    char * pSignature;
-    size_t pathLength, queryLength, remainingLength, writtenLength, signatureLength;
-    size_t channelArnValueLength, encodedLength, canonicalQueryStringLength, canonicalHeadersLength;
-    SigV4HttpParameters_t sigv4HttpParams;
-    SigV4Parameters_t sigv4Params;
-    SigV4Credentials_t sigv4Credentials;
-    SigV4CryptoInterface_t sigv4CryptoInterface;
-
-    writtenLength = 0;
-    remainingLength = SIGV4_METADATA_BUFFER_LENGTH;
-
-    /* Write X-Amz-Algorithm. */
-    snprintfRetVal = snprintf( &( pWebsocketCtx->sigV4Metadata[ writtenLength ] ),
-                               remainingLength,
-                               "X-Amz-Algorithm=AWS4-HMAC-SHA256" );
+    int ret = 0;
+    const char * pPath, * pQueryStart, * pUrlEnd, * pEqualSign, * pChannelArnValue = NULL;
+    size_t pathLength, queryLength = 0, channelArnValueLength = 0, encodedLength;
 
-    if( ( snprintfRetVal < 0 ) || ( snprintfRetVal == remainingLength ) )
-    {
-        LogError( ( "Failed to write X-Amz-Algorithm!" ) );
-        ret = -1;
-    }
-    else
-    {
-        writtenLength += snprintfRetVal;
-        remainingLength -= snprintfRetVal;
-    }
+    ret = GetPathFromUrl( pConnectInfo->pUrl,
+                          pConnectInfo->urlLength,
+                          &( pPath ),
+                          &( pathLength ) );
 
-    /* Write X-Amz-ChannelARN. */
     if( ret == 0 )
     {
-        ret = GetPathFromUrl( pConnectInfo->pUrl,
-                              pConnectInfo->urlLength,
-                              &( pPath ),
-                              &( pathLength ) );
+        pQueryStart = pPath + pathLength + 1; /* +1 to skip '?' mark. */
+        pUrlEnd = pConnectInfo->pUrl + pConnectInfo->urlLength;
 
-        if( ret == 0 )
+        if( pQueryStart < pUrlEnd )
         {
-            pQueryStart = pPath + pathLength + 1; /* +1 to skip '?' mark. */
-            pUrlEnd = pConnectInfo->pUrl + pConnectInfo->urlLength;
-
-            if( pQueryStart < pUrlEnd )
-            {
-                queryLength = pUrlEnd - pQueryStart;
-            }
-            else
-            {
-                LogError( ( "Cannot find query string in the URL!" ) );
-                ret = -1;
-            }
+            queryLength = pUrlEnd - pQueryStart;
         }
         else
         {
-            LogError( ( "Failed to extract path from the URL!" ) );
+            LogError( ( "Cannot find query string in the URL!" ) );
             ret = -1;
         }
+    }
+    else
+    {
+        LogError( ( "Failed to extract path from the URL!" ) );
+        ret = -1;
+    }
 
-        if( ret == 0 )
+    if( ret == 0 )
+    {
+        if( ( queryLength < strlen( "X-Amz-ChannelARN" ) ) ||
+            ( strncmp( pQueryStart, "X-Amz-ChannelARN", strlen( "X-Amz-ChannelARN" ) ) != 0 ) )
         {
-            if( ( queryLength < strlen( "X-Amz-ChannelARN" ) ) ||
-                ( strncmp( pQueryStart, "X-Amz-ChannelARN", strlen( "X-Amz-ChannelARN" ) ) != 0 ) )
-            {
-                LogError( ( "Cannot find X-Amz-ChannelARN in the query string!" ) );
-                ret = -1;
-            }
+            LogError( ( "Cannot find X-Amz-ChannelARN in the query string!" ) );
+            ret = -1;
         }
+    }
 
-        if( ret == 0 )
-        {
-            pEqualSign = strchr( pQueryStart, '=' );
-
-            if( pEqualSign != NULL )
-            {
-                pChannelArnValue = pEqualSign + 1;
-                channelArnValueLength = pQueryStart + queryLength - pChannelArnValue;
-            }
-            else
-            {
-                LogError( ( "Cannot find = after X-Amz-ChannelARN in the query string!" ) );
-                ret = -1;
-            }
-        }
+    if( ret == 0 )
+    {
+        pEqualSign = strchr( pQueryStart, '=' );
 
-        if( ret == 0 )
+        if( pEqualSign != NULL )
         {
-            snprintfRetVal = snprintf( &( pWebsocketCtx->sigV4Metadata[ writtenLength ] ),
-                                       remainingLength,
-                                       "&X-Amz-ChannelARN=" );
-            if( ( snprintfRetVal < 0 ) || ( snprintfRetVal == remainingLength ) )
-            {
-                LogError( ( "Failed to write X-Amz-ChannelARN key!" ) );
-                ret = -1;
-            }
-            else
-            {
-                writtenLength += snprintfRetVal;
-                remainingLength -= snprintfRetVal;
-            }
+            pChannelArnValue = pEqualSign + 1;
+            channelArnValueLength = pQueryStart + queryLength - pChannelArnValue;
         }
-
-        if( ret == 0 )
+        else
         {
-            encodedLength = remainingLength;
-            ret = UriEncode( pChannelArnValue,
-                             channelArnValueLength,
-                             &( pWebsocketCtx->sigV4Metadata[ writtenLength ] ),
-                             &( encodedLength ) );
-            if( ret == 0 )
-            {
-                writtenLength += encodedLength;
-                remainingLength -= encodedLength;
-            }
-            else
-            {
-                LogError( ( "Failed to write X-Amz-ChannelARN value!" ) );
-                ret = -1;
-            }
+            LogError( ( "Cannot find = after X-Amz-ChannelARN in the query string!" ) );
+            ret = -1;
         }
     }
 
-    /* Write X-Amz-Credential. */
     if( ret == 0 )
     {
-        snprintfRetVal = snprintf( &( pWebsocketCtx->sigV4Metadata[ writtenLength ] ),
-                                   remainingLength,
-                                   "&X-Amz-Credential=" );
-        if( ( snprintfRetVal < 0 ) || ( snprintfRetVal == remainingLength ) )
+        if( channelArnValueLength > WEBSOCKET_CHANNEL_ARN_BUFFER_LENGTH )
         {
-            LogError( ( "Failed to write X-Amz-Credential key!" ) );
+            LogError( ( "Channel ARN is too long: %lu", channelArnValueLength ) );
             ret = -1;
         }
-        else
-        {
-            writtenLength += snprintfRetVal;
-            remainingLength -= snprintfRetVal;
-        }
-
-        if( ret == 0 )
-        {
-            encodedLength = remainingLength;
-            ret = UriEncode( pAwsCredentials->pAccessKeyId,
-                             pAwsCredentials->accessKeyIdLen,
-                             &( pWebsocketCtx->sigV4Metadata[ writtenLength ] ),
-                             &( encodedLength ) );
-            if( ret == 0 )
-            {
-                writtenLength += encodedLength;
-                remainingLength -= encodedLength;
-            }
-            else
-            {
-                LogError( ( "Failed to write X-Amz-Credential access key!" ) );
-                ret = -1;
-            }
-        }
+    }
 
+    /* Reconnects use the same channel, so it's only encoded once. */
+    if( ( ret == 0 ) &&
+        ( ( pWebsocketCtx->channelArnLength != channelArnValueLength ) ||
+          ( memcmp( &( pWebsocketCtx->channelArn[ 0 ] ), pChannelArnValue, channelArnValueLength ) != 0 ) ) )
+    {
+        encodedLength = 3 * WEBSOCKET_CHANNEL_ARN_BUFFER_LENGTH;
+        ret = NetworkingSigV4_UriEncode( pChannelArnValue,
+                                         channelArnValueLength,
+                                         &( pWebsocketCtx->encodedChannelArn[ 0 ] ),
+                                         &( encodedLength ) );
         if( ret == 0 )
         {
-            encodedLength = remainingLength;
-            ret = UriEncode( "/",
-                             1,
-                             &( pWebsocketCtx->sigV4Metadata[ writtenLength ] ),
-                             &( encodedLength ) );
-            if( ret == 0 )
-            {
-                writtenLength += encodedLength;
-                remainingLength -= encodedLength;
-            }
-            else
-            {
-                LogError( ( "Failed to write X-Amz-Credential separator!" ) );
-                ret = -1;
-            }
+            memcpy( &( pWebsocketCtx->channelArn[ 0 ] ), pChannelArnValue, channelArnValueLength );
+            pWebsocketCtx->channelArnLength = channelArnValueLength;
+            pWebsocketCtx->encodedChannelArnLength = encodedLength;
         }
-
-        if( ret == 0 )
+        else
         {
-            encodedLength = remainingLength;
-            ret = UriEncode( &( pWebsocketCtx->iso8601Time[ 0 ] ),
-                             8, /* Only the date part. */
-                             &( pWebsocketCtx->sigV4Metadata[ writtenLength ] ),
-                             &( encodedLength ) );
-            if( ret == 0 )
-            {
-                writtenLength += encodedLength;
-                remainingLength -= encodedLength;
-            }
-            else
-            {
-                LogError( ( "Failed to write X-Amz-Credential date!" ) );
-                ret = -1;
-            }
+            LogError( ( "Failed to encode X-Amz-ChannelARN value!" ) );
+            pWebsocketCtx->channelArnLength = 0;
         }
+    }
 
-        if( ret == 0 )
-        {
-            encodedLength = remainingLength;
-            ret = UriEncode( "/",
-                             1,
-                             &( pWebsocketCtx->sigV4Metadata[ writtenLength ] ),
-                             &( encodedLength ) );
-            if( ret == 0 )
-            {
-                writtenLength += encodedLength;
-                remainingLength -= encodedLength;
-            }
-            else
-            {
-                LogError( ( "Failed to write X-Amz-Credential separator!" ) );
-                ret = -1;
-            }
-        }
+    return ret;
+}
 
-        if( ret == 0 )
-        {
-            encodedLength = remainingLength;
-            ret = UriEncode( pAwsConfig->pRegion,
-                             pAwsConfig->regionLen,
-                             &( pWebsocketCtx->sigV4Metadata[ writtenLength ] ),
-                             &( encodedLength ) );
-            if( ret == 0 )
-            {
-                writtenLength += encodedLength;
-                remainingLength -= encodedLength;
-            }
-            else
-            {
-                LogError( ( "Failed to write X-Amz-Credential region!" ) );
-                ret = -1;
-            }
-        }
+/*----------------------------------------------------------------------------*/
 
-        if( ret == 0 )
-        {
-            encodedLength = remainingLength;
-            ret = UriEncode( "/",
-                             1,
-                             &( pWebsocketCtx->sigV4Metadata[ writtenLength ] ),
-                             &( encodedLength ) );
-            if( ret == 0 )
-            {
-                writtenLength += encodedLength;
-                remainingLength -= encodedLength;
-            }
-            else
-            {
-                LogError( ( "Failed to write X-Amz-Credential separator!" ) );
-                ret = -1;
-            }
-        }
+static int SignWebsocketRequest( NetworkingWebsocketContext_t * pWebsocketCtx,
+                                 const WebsocketConnectInfo_t * pConnectInfo,
+                                 const AwsCredentials_t * pAwsCredentials,
+                                 const AwsConfig_t * pAwsConfig )
+{
+    int ret = 0, snprintfRetVal;
+    char signature[ NETWORKING_SIGV4_HEX_DIGEST_LENGTH ];
+    size_t remainingLength, writtenLength, encodedLength;
+    size_t canonicalQueryStringStart = 0, canonicalQueryStringLength = 0;
+    uint64_t expirationSeconds = STATIC_CRED_EXPIRES_SECONDS;
 
-        if( ret == 0 )
-        {
-            encodedLength = remainingLength;
-            ret = UriEncode( pAwsConfig->pService,
-                             pAwsConfig->serviceLen,
-                             &( pWebsocketCtx->sigV4Metadata[ writtenLength ] ),
-                             &( encodedLength ) );
-            if( ret == 0 )
-            {
-                writtenLength += encodedLength;
-                remainingLength -= encodedLength;
-            }
-            else
-            {
-                LogError( ( "Failed to write X-Amz-Credential service!" ) );
-                ret = -1;
-            }
-        }
+    writtenLength = 0;
+    remainingLength = SIGV4_METADATA_BUFFER_LENGTH;
 
-        if( ret == 0 )
-        {
-            encodedLength = remainingLength;
-            ret = UriEncode( "/aws4_request",
-                             strlen( "/aws4_request" ),
-                             &( pWebsocketCtx->sigV4Metadata[ writtenLength ] ),
-                             &( encodedLength ) );
-            if( ret == 0 )
-            {
-                writtenLength += encodedLength;
-                remainingLength -= encodedLength;
-            }
-            else
-            {
-                LogError( ( "Failed to write X-Amz-Credential aws4_request!" ) );
-                ret = -1;
-            }
-        }
-    }
+    ret = UpdateEncodedChannelArn( pWebsocketCtx, pConnectInfo );
 
-    /* Write X-Amz-Date. */
     if( ret == 0 )
     {
-        snprintfRetVal = snprintf( &( pWebsocketCtx->sigV4Metadata[ writtenLength ] ),
-                                   remainingLength,
-                                   "&X-Amz-Date=%.*s",
-                                   ( int ) pWebsocketCtx->iso8601TimeLength,
-                                   &( pWebsocketCtx->iso8601Time[ 0 ] ) );
-        if( ( snprintfRetVal < 0 ) || ( snprintfRetVal == remainingLength ) )
-        {
-            LogError( ( "Failed to write X-Amz-Date!" ) );
-            ret = -1;
-        }
-        else
-        {
-            writtenLength += snprintfRetVal;
-            remainingLength -= snprintfRetVal;
+        ret = NetworkingSigV4_PrepareCache( &( pWebsocketCtx->sigV4Cache ),
+                                            &( pWebsocketCtx->iso8601Time[ 0 ] ),
+                                            pAwsCredentials->pAccessKeyId,
+                                            pAwsCredentials->accessKeyIdLen,
+                                            pAwsCredentials->pSecretAccessKey,
+                                            pAwsCredentials->secretAccessKeyLen,
+                                            pAwsConfig->pRegion,
+                                            pAwsConfig->regionLen,
+                                            pAwsConfig->pService,
+                                            pAwsConfig->serviceLen );
+
+        if( ret != 0 )
+        {
+            LogError( ( "Failed to prepare SigV4 signing key!" ) );
         }
     }
 
-    /* Write X-Amz-Expires. */
+    /* The canonical request is built in place, the query string in the
+     * middle of it is copied to the URI path afterwards. The websocket URL
+     * has no path, so the canonical URI is always "/". */
     if( ret == 0 )
     {
-        uint64_t expirationSeconds = STATIC_CRED_EXPIRES_SECONDS;
-
         if( pAwsCredentials->expirationSeconds != 0 )
         {
             expirationSeconds = MIN( STATIC_CRED_EXPIRES_SECONDS,
@@ -794,13 +576,27 @@ static int SignWebsocketRequest( NetworkingWebsocketContext_t * pWebsocketCtx,
             expirationSeconds = MAX( expirationSeconds, 1 );
         }
 
+        canonicalQueryStringStart = strlen( "GET\n/\n" );
+
         snprintfRetVal = snprintf( &( pWebsocketCtx->sigV4Metadata[ writtenLength ] ),
                                    remainingLength,
+                                   "GET\n/\n"
+                                   "X-Amz-Algorithm=" NETWORKING_SIGV4_ALGORITHM
+                                   "&X-Amz-ChannelARN=%.*s"
+                                   "&X-Amz-Credential=%.*s"
+                                   "&X-Amz-Date=%.*s"
                                    "&X-Amz-Expires=%lu",
+                                   ( int ) pWebsocketCtx->encodedChannelArnLength,
+                                   &( pWebsocketCtx->encodedChannelArn[ 0 ] ),
+                                   ( int ) pWebsocketCtx->sigV4Cache.encodedCredentialLength,
+                                   &( pWebsocketCtx->sigV4Cache.encodedCredential[ 0 ] ),
+                                   ( int ) pWebsocketCtx->iso8601TimeLength,
+                                   &( pWebsocketCtx->iso8601Time[ 0 ] ),
                                    expirationSeconds );
-        if( ( snprintfRetVal < 0 ) || ( snprintfRetVal == remainingLength ) )
+
+        if( ( snprintfRetVal < 0 ) || ( snprintfRetVal >= remainingLength ) )
         {
-            LogError( ( "Failed to write X-Amz-Expires!" ) );
+            LogError( ( "Failed to write canonical query string!" ) );
             ret = -1;
         }
         else
@@ -818,7 +614,7 @@ static int SignWebsocketRequest( NetworkingWebsocketContext_t * pWebsocketCtx,
         snprintfRetVal = snprintf( &( pWebsocketCtx->sigV4Metadata[ writtenLength ] ),
                                    remainingLength,
                                    "&X-Amz-Security-Token=" );
-        if( ( snprintfRetVal < 0 ) || ( snprintfRetVal == remainingLength ) )
+        if( ( snprintfRetVal < 0 ) || ( snprintfRetVal >= remainingLength ) )
         {
             LogError( ( "Failed to write X-Amz-Security-Token key!" ) );
             ret = -1;
@@ -832,10 +628,10 @@ static int SignWebsocketRequest( NetworkingWebsocketContext_t * pWebsocketCtx,
         if( ret == 0 )
         {
             encodedLength = remainingLength;
-            ret = UriEncode( pAwsCredentials->pSessionToken,
-                             pAwsCredentials->sessionTokenLength,
-                             &( pWebsocketCtx->sigV4Metadata[ writtenLength ] ),
-                             &( encodedLength ) );
+            ret = NetworkingSigV4_UriEncode( pAwsCredentials->pSessionToken,
+                                             pAwsCredentials->sessionTokenLength,
+                                             &( pWebsocketCtx->sigV4Metadata[ writtenLength ] ),
+                                             &( encodedLength ) );
             if( ret == 0 )
             {
                 writtenLength += encodedLength;
@@ -849,13 +645,13 @@ static int SignWebsocketRequest( NetworkingWebsocketContext_t * pWebsocketCtx,
         }
     }
 
-    /* Write X-Amz-SignedHeaders. */
+    /* Write X-Amz-SignedHeaders, canonical headers and the empty payload hash. */
     if( ret == 0 )
     {
         snprintfRetVal = snprintf( &( pWebsocketCtx->sigV4Metadata[ writtenLength ] ),
                                    remainingLength,
                                    "&X-Amz-SignedHeaders=host" );
-        if( ( snprintfRetVal < 0 ) || ( snprintfRetVal == remainingLength ) )
+        if( ( snprintfRetVal < 0 ) || ( snprintfRetVal >= remainingLength ) )
         {
             LogError( ( "Failed to write X-Amz-SignedHeaders!" ) );
             ret = -1;
@@ -864,136 +660,181 @@ static int SignWebsocketRequest( NetworkingWebsocketContext_t * pWebsocketCtx,
         {
             writtenLength += snprintfRetVal;
             remainingLength -= snprintfRetVal;
+            canonicalQueryStringLength = writtenLength - canonicalQueryStringStart;
         }
     }
 
-    /* Write canonical headers. */
     if( ret == 0 )
     {
-        canonicalQueryStringLength = writtenLength;
-
         snprintfRetVal = snprintf( &( pWebsocketCtx->sigV4Metadata[ writtenLength ] ),
                                    remainingLength,
-                                   "%s: %.*s\r\n",
-                                   "host",
+                                   "\nhost:%.*s\n\nhost\n" NETWORKING_SIGV4_EMPTY_PAYLOAD_HASH,
                                    ( int ) pWebsocketCtx->uriHostLength,
                                    &( pWebsocketCtx->uriHost[ 0 ] ) );
 
-        if( ( snprintfRetVal < 0 ) || ( snprintfRetVal == remainingLength ) )
+        if( ( snprintfRetVal < 0 ) || ( snprintfRetVal >= remainingLength ) )
         {
             LogError( ( "Failed to write canonical headers!" ) );
             ret = -1;
         }
         else
         {
-            canonicalHeadersLength = snprintfRetVal;
+            writtenLength += snprintfRetVal;
+            remainingLength -= snprintfRetVal;
         }
     }
 
     /* Generate signature. */
     if( ret == 0 )
     {
-        sigv4HttpParams.pHttpMethod = "GET";
-        sigv4HttpParams.httpMethodLen = 3;
-        sigv4HttpParams.flags = SIGV4_HTTP_QUERY_IS_CANONICAL_FLAG;
-        sigv4HttpParams.pPath = pPath;
-        sigv4HttpParams.pathLen = pathLength;
-        sigv4HttpParams.pQuery = &( pWebsocketCtx->sigV4Metadata[ 0 ] );
-        sigv4HttpParams.queryLen = canonicalQueryStringLength;
-        sigv4HttpParams.pHeaders = &( pWebsocketCtx->sigV4Metadata[ canonicalQueryStringLength ] );
-        sigv4HttpParams.headersLen = canonicalHeadersLength;
-        sigv4HttpParams.pPayload = NULL;
-        sigv4HttpParams.payloadLen = 0;
-
-        sigv4Credentials.pAccessKeyId = pAwsCredentials->pAccessKeyId;
-        sigv4Credentials.accessKeyIdLen = pAwsCredentials->accessKeyIdLen;
-        sigv4Credentials.pSecretAccessKey = pAwsCredentials->pSecretAccessKey;
-        sigv4Credentials.secretAccessKeyLen = pAwsCredentials->secretAccessKeyLen;
-
-        sigv4CryptoInterface.hashInit = Sha256Init;
-        sigv4CryptoInterface.hashUpdate = Sha256Update;
-        sigv4CryptoInterface.hashFinal = Sha256Final;
-        #if NETWORKING_USE_OPENSSL
-            sigv4CryptoInterface.pHashContext = EVP_MD_CTX_new();
-        #elif NETWORKING_USE_MBEDTLS /* if NETWORKING_USE_OPENSSL */
-            sigv4CryptoInterface.pHashContext = &xHashContext;
-        #endif /* elif NETWORKING_USE_MBEDTLS */
-        sigv4CryptoInterface.hashBlockLen = 64;
-        sigv4CryptoInterface.hashDigestLen = 32;
-
-        sigv4Params.pCredentials = &( sigv4Credentials );
-        sigv4Params.pDateIso8601 = &( pWebsocketCtx->iso8601Time[ 0 ] );
-        sigv4Params.pAlgorithm = NULL;
-        sigv4Params.algorithmLen = 0;
-        sigv4Params.pRegion = pAwsConfig->pRegion;
-        sigv4Params.regionLen = pAwsConfig->regionLen;
-        sigv4Params.pService = pAwsConfig->pService;
-        sigv4Params.serviceLen = pAwsConfig->serviceLen;
-        sigv4Params.pCryptoInterface = &( sigv4CryptoInterface );
-        sigv4Params.pHttpParameters = &( sigv4HttpParams );
-
-        pWebsocketCtx->sigv4AuthorizationHeaderLength = SIGV4_AUTHORIZATION_HEADER_BUFFER_LENGTH;
-
-        if( SigV4_GenerateHTTPAuthorization( &( sigv4Params ),
-                                             &( pWebsocketCtx->sigv4AuthorizationHeader[ 0 ] ),
-                                             &( pWebsocketCtx->sigv4AuthorizationHeaderLength ),
-                                             &( pSignature ),
-                                             &( signatureLength ) ) != SigV4Success )
+        if( NetworkingSigV4_Sign( &( pWebsocketCtx->sigV4Cache ),
+                                  &( pWebsocketCtx->iso8601Time[ 0 ] ),
+                                  &( pWebsocketCtx->sigV4Metadata[ 0 ] ),
+                                  writtenLength,
+                                  &( signature[ 0 ] ) ) != 0 )
         {
             LogError( ( "Failed to generate SigV4 authorization!" ) );
             ret = -1;
         }
-
-        #if NETWORKING_USE_OPENSSL
-            EVP_MD_CTX_free( sigv4CryptoInterface.pHashContext );
-        #endif /* NETWORKING_USE_OPENSSL */
     }
 
-    /* Append signature. */
+    /* Update UriPath buffer with the query and the signature. This will be
+     * used during connect. */
     if( ret == 0 )
     {
-        writtenLength = canonicalQueryStringLength;
-        remainingLength = SIGV4_METADATA_BUFFER_LENGTH - canonicalQueryStringLength;
+        writtenLength = canonicalQueryStringLength + 2;
 
-        snprintfRetVal = snprintf( &( pWebsocketCtx->sigV4Metadata[ writtenLength ] ),
-                                   remainingLength,
-                                   "&X-Amz-Signature=%.*s",
-                                   ( int ) signatureLength,
-                                   pSignature );
+        if( ( writtenLength + strlen( "&X-Amz-Signature=" ) + NETWORKING_SIGV4_HEX_DIGEST_LENGTH ) <= WEBSOCKET_URI_PATH_BUFFER_LENGTH )
+        {
+            pWebsocketCtx->uriPath[ 0 ] = '/';
+            pWebsocketCtx->uriPath[ 1 ] = '?';
+            memcpy( &( pWebsocketCtx->uriPath[ 2 ] ),
+                    &( pWebsocketCtx->sigV4Metadata[ canonicalQueryStringStart ] ),
+                    canonicalQueryStringLength );
+            memcpy( &( pWebsocketCtx->uriPath[ writtenLength ] ),
+                    "&X-Amz-Signature=",
+                    strlen( "&X-Amz-Signature=" ) );
+            writtenLength += strlen( "&X-Amz-Signature=" );
+            memcpy( &( pWebsocketCtx->uriPath[ writtenLength ] ),
+                    &( signature[ 0 ] ),
+                    NETWORKING_SIGV4_HEX_DIGEST_LENGTH );
+            writtenLength += NETWORKING_SIGV4_HEX_DIGEST_LENGTH;
+
+            pWebsocketCtx->uriPathLength = writtenLength;
+            pWebsocketCtx->uriPath[ pWebsocketCtx->uriPathLength ] = '\0';
+        }
+        else
+        {
+            LogError( ( "Failed to update UriPath buffer!" ) );
+            ret = -1;
+        }
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
 
-        if( ( snprintfRetVal < 0 ) || ( snprintfRetVal == remainingLength ) )
+static int AppendHttpResponse( NetworkingHttpContext_t * pHttpCtx,
+                               const char * pData,
+                               size_t dataLength )
+{
+    int ret = 0;
+    HttpResponse_t * pResponse = pHttpCtx->pResponse;
+    size_t requiredLength = pResponse->contentLength + dataLength + 1U;
+    size_t newCapacity;
+    char * pNewBuffer;
+    uint8_t isOwnBuffer;
+
+    /* Switch to the context owned buffer, or grow it, when the response
+     * doesn't fit. One byte is left for the caller to NULL terminate. */
+    if( requiredLength > pResponse->contentMaxCapacity )
+    {
+        if( requiredLength > HTTP_MAX_RESPONSE_LENGTH )
         {
-            LogError( ( "Failed to write X-Amz-Signature!" ) );
+            LogError( ( "HTTP response is larger than %d bytes!", HTTP_MAX_RESPONSE_LENGTH ) );
             ret = -1;
         }
         else
         {
-            writtenLength += snprintfRetVal;
-            remainingLength -= snprintfRetVal;
+            newCapacity = MAX( MAX( pHttpCtx->responseBufferCapacity, HTTP_RX_BUFFER_LENGTH ), pResponse->contentMaxCapacity );
+            while( newCapacity < requiredLength )
+            {
+                newCapacity *= 2U;
+            }
+            newCapacity = MIN( newCapacity, HTTP_MAX_RESPONSE_LENGTH );
+
+            isOwnBuffer = ( pResponse->pContent == pHttpCtx->pResponseBuffer ) ? 1U : 0U;
+            pNewBuffer = realloc( pHttpCtx->pResponseBuffer, newCapacity );
+
+            if( ( pNewBuffer != NULL ) && ( isOwnBuffer == 0U ) )
+            {
+                memcpy( pNewBuffer, pResponse->pContent, pResponse->contentLength );
+            }
+
+            if( pNewBuffer == NULL )
+            {
+                LogError( ( "Fail to grow HTTP response buffer to %lu bytes!", newCapacity ) );
+                ret = -1;
+            }
+            else
+            {
+                LogDebug( ( "HTTP response buffer grown to %lu bytes.", newCapacity ) );
+                pHttpCtx->pResponseBuffer = pNewBuffer;
+                pHttpCtx->responseBufferCapacity = newCapacity;
+                pResponse->pContent = pNewBuffer;
+                pResponse->contentMaxCapacity = newCapacity;
+            }
         }
     }
 
-    /* Update UriPath buffer. This will be used during connect. */
     if( ret == 0 )
     {
-        if( ( writtenLength + 2 ) <= WEBSOCKET_URI_PATH_BUFFER_LENGTH )
+        memcpy( &( pResponse->pContent[ pResponse->contentLength ] ), pData, dataLength );
+        pResponse->contentLength += dataLength;
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static NetworkingHttpPooledHost_t * GetPooledHost( NetworkingHttpContext_t * pHttpCtx )
+{
+    NetworkingHttpPooledHost_t * pPooledHost = NULL, * pOldest = &( pHttpCtx->pooledHosts[ 0 ] );
+    size_t i;
+
+    for( i = 0; i < HTTP_MAX_POOLED_HOSTS; i++ )
+    {
+        if( ( pHttpCtx->pooledHosts[ i ].hostLength == pHttpCtx->uriHostLength ) &&
+            ( pHttpCtx->pooledHosts[ i ].port == pHttpCtx->uriPort ) &&
+            ( memcmp( &( pHttpCtx->pooledHosts[ i ].host[ 0 ] ), &( pHttpCtx->uriHost[ 0 ] ), pHttpCtx->uriHostLength ) == 0 ) )
         {
-            pWebsocketCtx->uriPathLength = writtenLength + 2;
-            pWebsocketCtx->uriPath[ 0 ] = '/';
-            pWebsocketCtx->uriPath[ 1 ] = '?';
-            memcpy( &( pWebsocketCtx->uriPath[ 2 ] ),
-                    &( pWebsocketCtx->sigV4Metadata[ 0 ] ),
-                    pWebsocketCtx->uriPathLength );
-            pWebsocketCtx->uriPath[ pWebsocketCtx->uriPathLength ] = '\0';
+            pPooledHost = &( pHttpCtx->pooledHosts[ i ] );
+            break;
         }
-        else
+
+        if( pHttpCtx->pooledHosts[ i ].lastUsedTimeUs < pOldest->lastUsedTimeUs )
         {
-            LogError( ( "Failed to update UriPath buffer!" ) );
-            ret = -1;
+            pOldest = &( pHttpCtx->pooledHosts[ i ] );
         }
     }
 
-    return ret;
+    /* Replace the least recently used host, LWS closes its idle connection
+     * by the idle policy. */
+    if( pPooledHost == NULL )
+    {
+        pPooledHost = pOldest;
+        memset( pPooledHost, 0, sizeof( NetworkingHttpPooledHost_t ) );
+        memcpy( &( pPooledHost->host[ 0 ] ), &( pHttpCtx->uriHost[ 0 ] ), pHttpCtx->uriHostLength );
+        pPooledHost->hostLength = pHttpCtx->uriHostLength;
+        pPooledHost->port = pHttpCtx->uriPort;
+    }
+
+    pPooledHost->requestCount++;
+    pPooledHost->lastUsedTimeUs = NetworkingUtils_GetCurrentTimeUs( NULL );
+
+    return pPooledHost;
 }
 
 /*----------------------------------------------------------------------------*/
@@ -1007,197 +848,209 @@ static int LwsHttpCallback( struct lws * pWsi,
     int ret = 0, bufferLength, writtenBodyLength, lwsStatus = 0;
     unsigned char * pEnd;
     unsigned char ** ppStart;
+    char * pRxBuffer;
     size_t i;
     const struct lws_protocols * pLwsProtocol = NULL;
     NetworkingHttpContext_t * pHttpContext = NULL;
     char contentLengthStr[ 11 ];
     size_t contentLengthStrLength;
 
-    switch( reason )
-    {
-        case LWS_CALLBACK_CLIENT_CONNECTION_ERROR:
-        {
-            pLwsProtocol = lws_get_protocol( pWsi );
-            pHttpContext = ( NetworkingHttpContext_t * ) pLwsProtocol->user;
-            pHttpContext->httpStatusCode = -1;
-            LogError( ( "HTTP connection error!" ) );
-        }
-        break;
+    pLwsProtocol = lws_get_protocol( pWsi );
 
-        case LWS_CALLBACK_CLOSED_CLIENT_HTTP:
-        {
-            pLwsProtocol = lws_get_protocol( pWsi );
-            pHttpContext = ( NetworkingHttpContext_t * ) pLwsProtocol->user;
-            LogDebug( ( "HTTP connection closed." ) );
-        }
-        break;
+    if( ( pLwsProtocol != NULL ) && ( pLwsProtocol->user != NULL ) )
+    {
+        pHttpContext = ( NetworkingHttpContext_t * ) pLwsProtocol->user;
 
-        case LWS_CALLBACK_ESTABLISHED_CLIENT_HTTP:
+        /* Pooled connections outlive the request which opened them, only the
+         * wsi of the current request may complete it. */
+        if( ( uintptr_t ) lws_get_opaque_user_data( pWsi ) != pHttpContext->transactionId )
         {
-            pLwsProtocol = lws_get_protocol( pWsi );
-            pHttpContext = ( NetworkingHttpContext_t * ) pLwsProtocol->user;
-            pHttpContext->httpStatusCode = lws_http_client_http_response( pWsi );
-            LogDebug( ( "Connected with HTTP server. Response: %d.", pHttpContext->httpStatusCode ) );
+            pHttpContext = NULL;
         }
-        break;
+    }
 
-        case LWS_CALLBACK_RECEIVE_CLIENT_HTTP_READ:
+    if( pHttpContext != NULL )
+    {
+        switch( reason )
         {
-            pLwsProtocol = lws_get_protocol( pWsi );
-            pHttpContext = ( NetworkingHttpContext_t * ) pLwsProtocol->user;
-
-            LogDebug( ( "Received HTTP %lu bytes.", dataLength ) );
-            LogVerbose( ( "Received HTTP data: %.*s", ( int ) dataLength, ( const char * ) pData ) );
+            case LWS_CALLBACK_CLIENT_CONNECTION_ERROR:
+            {
+                pHttpContext->httpStatusCode = -1;
+                pHttpContext->transactionCompleted = 1U;
+                LogError( ( "HTTP connection error!" ) );
+            }
+            break;
 
-            if( dataLength != 0 )
+            case LWS_CALLBACK_CONNECTING:
             {
-                if( dataLength >= pHttpContext->pResponse->contentMaxCapacity )
+                /* Only called when a new connection is made for the request. */
+                pHttpContext->lastMetrics.connectionReused = 0U;
+                if( pHttpContext->pCurrentHost != NULL )
                 {
-                    /* Receive data is larger than buffer size. */
-                    ret = -2;
-                    LogError( ( "Received HTTP data cannot fit in the response buffer!" ) );
+                    pHttpContext->pCurrentHost->connectionCount++;
                 }
-                else
+                LogDebug( ( "New HTTP connection." ) );
+            }
+            break;
+
+            case LWS_CALLBACK_CLOSED_CLIENT_HTTP:
+            {
+                LogDebug( ( "HTTP connection closed." ) );
+            }
+            break;
+
+            case LWS_CALLBACK_ESTABLISHED_CLIENT_HTTP:
+            {
+                pHttpContext->lastMetrics.timeToFirstByteUs = NetworkingUtils_GetCurrentTimeUs( NULL ) - pHttpContext->headersSentTimeUs;
+                pHttpContext->httpStatusCode = lws_http_client_http_response( pWsi );
+                LogDebug( ( "Connected with HTTP server. Response: %d.", pHttpContext->httpStatusCode ) );
+            }
+            break;
+
+            case LWS_CALLBACK_RECEIVE_CLIENT_HTTP_READ:
+            {
+                LogDebug( ( "Received HTTP %lu bytes.", dataLength ) );
+                LogVerbose( ( "Received HTTP data: %.*s", ( int ) dataLength, ( const char * ) pData ) );
+
+                if( dataLength != 0 )
                 {
-                    memcpy( pHttpContext->pResponse->pContent, pData, dataLength );
-                    pHttpContext->pResponse->contentLength = dataLength;
+                    if( AppendHttpResponse( pHttpContext,
+                                            ( const char * ) pData,
+                                            dataLength ) != 0 )
+                    {
+                        ret = -2;
+                        LogError( ( "Received HTTP data cannot fit in the response buffer!" ) );
+                    }
                 }
             }
-        }
-        break;
+            break;
 
-        case LWS_CALLBACK_RECEIVE_CLIENT_HTTP:
-        {
-            pLwsProtocol = lws_get_protocol( pWsi );
-            pHttpContext = ( NetworkingHttpContext_t * ) pLwsProtocol->user;
+            case LWS_CALLBACK_RECEIVE_CLIENT_HTTP:
+            {
+                LogDebug( ( "LWS_CALLBACK_RECEIVE_CLIENT_HTTP callback." ) );
 
-            LogDebug( ( "LWS_CALLBACK_RECEIVE_CLIENT_HTTP callback." ) );
+                pRxBuffer = &( pHttpContext->rxBuffer[ 0 ] );
+                bufferLength = HTTP_RX_BUFFER_LENGTH;
 
-            bufferLength = HTTP_RX_BUFFER_LENGTH;
+                if( lws_http_client_read( pWsi, &( pRxBuffer ), &( bufferLength ) ) < 0 )
+                {
+                    LogError( ( "lws_http_client_read failed!" ) );
+                    ret = -1;
+                }
+            }
+            break;
 
-            if( lws_http_client_read( pWsi, ( char ** ) pHttpContext->rxBuffer, &( bufferLength ) ) < 0 )
+            case LWS_CALLBACK_COMPLETED_CLIENT_HTTP:
             {
-                LogError( ( "lws_http_client_read failed!" ) );
-                ret = -1;
+                LogDebug( ( "LWS_CALLBACK_COMPLETED_CLIENT_HTTP callback. Keeping the connection." ) );
+
+                pHttpContext->transactionCompleted = 1U;
             }
-        }
-        break;
+            break;
 
-        case LWS_CALLBACK_COMPLETED_CLIENT_HTTP:
-        {
-            pLwsProtocol = lws_get_protocol( pWsi );
-            pHttpContext = ( NetworkingHttpContext_t * ) pLwsProtocol->user;
+            case LWS_CALLBACK_CLIENT_APPEND_HANDSHAKE_HEADER:
+            {
+                LogDebug( ( "LWS_CALLBACK_CLIENT_APPEND_HANDSHAKE_HEADER callback." ) );
 
-            LogDebug( ( "LWS_CALLBACK_COMPLETED_CLIENT_HTTP callback. Closing the connection." ) );
+                /* The connection is ready, with TLS done, once headers are written. */
+                pHttpContext->headersSentTimeUs = NetworkingUtils_GetCurrentTimeUs( NULL );
+                if( pHttpContext->lastMetrics.connectionReused == 0U )
+                {
+                    pHttpContext->lastMetrics.connectTimeUs = pHttpContext->headersSentTimeUs - pHttpContext->requestStartTimeUs;
+                }
 
-            pHttpContext->connectionClosed = 1U;
-        }
-        break;
+                ppStart = ( unsigned char ** ) pData;
+                pEnd = *ppStart + dataLength - 1;
 
-        case LWS_CALLBACK_CLIENT_APPEND_HANDSHAKE_HEADER:
-        {
-            pLwsProtocol = lws_get_protocol( pWsi );
-            pHttpContext = ( NetworkingHttpContext_t * ) pLwsProtocol->user;
+                for( i = 0; i < NUM_REQUIRED_HEADERS; i++ )
+                {
+                    if( pHttpContext->requiredHeaders[ i ].valueLength > 0 )
+                    {
+                        lwsStatus = lws_add_http_header_by_name( pWsi,
+                                                                 ( const unsigned char * ) pHttpContext->requiredHeaders[ i ].pName,
+                                                                 ( const unsigned char * ) pHttpContext->requiredHeaders[ i ].pValue,
+                                                                 pHttpContext->requiredHeaders[ i ].valueLength,
+                                                                 ppStart,
+                                                                 pEnd );
+                    }
+                }
 
-            LogDebug( ( "LWS_CALLBACK_CLIENT_APPEND_HANDSHAKE_HEADER callback." ) );
+                lwsStatus = lws_add_http_header_by_name( pWsi,
+                                                         ( const unsigned char * ) "content-type",
+                                                         ( const unsigned char * ) "application/json",
+                                                         strlen( "application/json" ),
+                                                         ppStart,
+                                                         pEnd );
 
-            ppStart = ( unsigned char ** ) pData;
-            pEnd = *ppStart + dataLength - 1;
+                contentLengthStrLength = snprintf( &( contentLengthStr[ 0 ] ), 11, "%lu", pHttpContext->pRequest->bodyLength );
+                lwsStatus = lws_add_http_header_by_name( pWsi,
+                                                         ( const unsigned char * ) "content-length",
+                                                         ( const unsigned char * ) &( contentLengthStr[ 0 ] ),
+                                                         contentLengthStrLength,
+                                                         ppStart,
+                                                         pEnd );
 
-            for( i = 0; i < NUM_REQUIRED_HEADERS; i++ )
-            {
-                if( pHttpContext->requiredHeaders[ i ].valueLength > 0 )
+                for( i = 0; i < pHttpContext->pRequest->numHeaders; i++ )
                 {
                     lwsStatus = lws_add_http_header_by_name( pWsi,
-                                                             ( const unsigned char * ) pHttpContext->requiredHeaders[ i ].pName,
-                                                             ( const unsigned char * ) pHttpContext->requiredHeaders[ i ].pValue,
-                                                             pHttpContext->requiredHeaders[ i ].valueLength,
+                                                             ( const unsigned char * ) pHttpContext->pRequest->pHeaders[ i ].pName,
+                                                             ( const unsigned char * ) pHttpContext->pRequest->pHeaders[ i ].pValue,
+                                                             pHttpContext->pRequest->pHeaders[ i ].valueLength,
                                                              ppStart,
                                                              pEnd );
                 }
-            }
 
-            lwsStatus = lws_add_http_header_by_name( pWsi,
-                                                     ( const unsigned char * ) "content-type",
-                                                     ( const unsigned char * ) "application/json",
-                                                     strlen( "application/json" ),
-                                                     ppStart,
-                                                     pEnd );
-
-            contentLengthStrLength = snprintf( &( contentLengthStr[ 0 ] ), 11, "%lu", pHttpContext->pRequest->bodyLength );
-            lwsStatus = lws_add_http_header_by_name( pWsi,
-                                                     ( const unsigned char * ) "content-length",
-                                                     ( const unsigned char * ) &( contentLengthStr[ 0 ] ),
-                                                     contentLengthStrLength,
-                                                     ppStart,
-                                                     pEnd );
-
-            for( i = 0; i < pHttpContext->pRequest->numHeaders; i++ )
-            {
-                lwsStatus = lws_add_http_header_by_name( pWsi,
-                                                         ( const unsigned char * ) pHttpContext->pRequest->pHeaders[ i ].pName,
-                                                         ( const unsigned char * ) pHttpContext->pRequest->pHeaders[ i ].pValue,
-                                                         pHttpContext->pRequest->pHeaders[ i ].valueLength,
-                                                         ppStart,
-                                                         pEnd );
+                lws_client_http_body_pending( pWsi, 1 );
+                lws_callback_on_writable( pWsi );
             }
+            break;
 
-            lws_client_http_body_pending( pWsi, 1 );
-            lws_callback_on_writable( pWsi );
-        }
-        break;
-
-        case LWS_CALLBACK_CLIENT_HTTP_WRITEABLE:
-        {
-            pLwsProtocol = lws_get_protocol( pWsi );
-            pHttpContext = ( NetworkingHttpContext_t * ) pLwsProtocol->user;
-
-            LogDebug( ( "LWS_CALLBACK_CLIENT_HTTP_WRITEABLE callback." ) );
+            case LWS_CALLBACK_CLIENT_HTTP_WRITEABLE:
+            {
+                LogDebug( ( "LWS_CALLBACK_CLIENT_HTTP_WRITEABLE callback." ) );
 
-            writtenBodyLength = lws_write( pWsi,
-                                           ( unsigned char * ) pHttpContext->pRequest->pBody,
-                                           pHttpContext->pRequest->bodyLength,
-                                           LWS_WRITE_TEXT );
+                writtenBodyLength = lws_write( pWsi,
+                                               ( unsigned char * ) pHttpContext->pRequest->pBody,
+                                               pHttpContext->pRequest->bodyLength,
+                                               LWS_WRITE_TEXT );
 
-            if( writtenBodyLength != pHttpContext->pRequest->bodyLength )
-            {
-                if( writtenBodyLength > 0 )
+                if( writtenBodyLength != pHttpContext->pRequest->bodyLength )
                 {
-                    /* Schedule again. */
-                    lws_client_http_body_pending( pWsi, 1 );
-                    lws_callback_on_writable( pWsi );
+                    if( writtenBodyLength > 0 )
+                    {
+                        /* Schedule again. */
+                        lws_client_http_body_pending( pWsi, 1 );
+                        lws_callback_on_writable( pWsi );
+                    }
+                    else
+                    {
+                        /* Quit. */
+                        ret = 1;
+                        LogError( ( "lws_write failed!" ) );
+                    }
                 }
                 else
                 {
-                    /* Quit. */
-                    ret = 1;
-                    LogError( ( "lws_write failed!" ) );
+                    /* Finished sending the body. */
+                    lws_client_http_body_pending( pWsi, 0 );
                 }
             }
-            else
-            {
-                /* Finished sending the body. */
-                lws_client_http_body_pending( pWsi, 0 );
-            }
-        }
-        break;
+            break;
 
-        case LWS_CALLBACK_WSI_DESTROY:
-        {
-            pLwsProtocol = lws_get_protocol( pWsi );
-            pHttpContext = ( NetworkingHttpContext_t * ) pLwsProtocol->user;
+            case LWS_CALLBACK_WSI_DESTROY:
+            {
+                LogDebug( ( "LWS_CALLBACK_WSI_DESTROY callback." ) );
 
-            LogDebug( ( "LWS_CALLBACK_WSI_DESTROY callback." ) );
+                pHttpContext->transactionCompleted = 1U;
 
-            pHttpContext->connectionClosed = 1;
+                /* Abort poll wait. */
+                lws_cancel_service( pHttpContext->pLwsContext );
+            }
+            break;
 
-            /* Abort poll wait. */
-            lws_cancel_service( pHttpContext->pLwsContext );
+            default:
+                break;
         }
-        break;
-
-        default:
-            break;
     }
 
     if( ( lwsStatus != 0 ) && ( ret == 0 ) )
@@ -1323,7 +1176,7 @@ static int LwsWebsocketCallback( struct lws * pWsi,
                      * that we receive an SDP Offer which is large because it
                      * contains ICE Candidates (non-trickle functionality).
                      * Increasing the Macro WEBSOCKET_RX_BUFFER_LENGTH to a
-                     * larger value (such as 13 * 1024) may help in this case. */
+                     * larger value may help in this case. */
                     LogWarn( ( "WSS RX buffer is not large enough for received message. Message size: %lu.",
                                pWebsocketContext->dataLengthInRxBuffer + dataLength ) );
                     ret = 1;
@@ -1498,8 +1351,15 @@ static NetworkingResult_t CreateHttpLwsContext( NetworkingHttpContext_t * pHttpC
     creationInfo.ka_probes = 1;
     creationInfo.ka_interval = 1;
     creationInfo.retry_and_idle_policy = &( httpRetryPolicy );
-    creationInfo.fd_limit_per_thread = 3;
+    /* Event pipe plus a keep-alive connection per pooled host and one spare
+     * for a pipelined request moving onto it. */
+    creationInfo.fd_limit_per_thread = 2 + HTTP_MAX_POOLED_HOSTS + 1;
     creationInfo.alpn = "http/1.1";
+    #if defined( LWS_WITH_TLS_SESSIONS )
+        /* Resume TLS sessions when a pooled connection has to be made again. */
+        creationInfo.tls_session_timeout = HTTP_TLS_SESSION_TIMEOUT_SECONDS;
+        creationInfo.tls_session_cache_max = HTTP_MAX_POOLED_HOSTS;
+    #endif /* defined( LWS_WITH_TLS_SESSIONS ) */
 
     if( ( pHttpCtx->sslCreds.pDeviceCertPath != NULL ) && ( pHttpCtx->sslCreds.pDeviceKeyPath != NULL ) )
     {
@@ -1554,6 +1414,27 @@ NetworkingResult_t Networking_HttpInit( NetworkingHttpContext_t * pHttpCtx,
 
 /*----------------------------------------------------------------------------*/
 
+void Networking_HttpDeinit( NetworkingHttpContext_t * pHttpCtx )
+{
+    if( pHttpCtx != NULL )
+    {
+        if( pHttpCtx->pLwsContext != NULL )
+        {
+            lws_context_destroy( pHttpCtx->pLwsContext );
+            pHttpCtx->pLwsContext = NULL;
+        }
+
+        free( pHttpCtx->pResponseBuffer );
+        pHttpCtx->pResponseBuffer = NULL;
+        pHttpCtx->responseBufferCapacity = 0;
+
+        memset( &( pHttpCtx->pooledHosts[ 0 ] ), 0, sizeof( pHttpCtx->pooledHosts ) );
+        pHttpCtx->pCurrentHost = NULL;
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
 NetworkingResult_t Networking_WebsocketInit( NetworkingWebsocketContext_t * pWebsocketCtx,
                                              const SSLCredentials_t * pCreds )
 {
@@ -1608,7 +1489,7 @@ NetworkingResult_t Networking_HttpSend( NetworkingHttpContext_t * pHttpCtx,
     size_t hostLength = 0;
     size_t pathLength = 0;
     struct lws_client_connect_info connectInfo;
-    struct lws * clientLws;
+    struct lws * clientLws = NULL;
 
     if( ( pHttpCtx == NULL ) ||
         ( pRequest == NULL ) ||
@@ -1617,11 +1498,22 @@ NetworkingResult_t Networking_HttpSend( NetworkingHttpContext_t * pHttpCtx,
         ret = NETWORKING_RESULT_BAD_PARAM;
     }
 
-    if( ret == NETWORKING_RESULT_OK )
+    /* The context, and the connections it keeps alive, is created on first
+     * use and reused until a request fails. */
+    if( ( ret == NETWORKING_RESULT_OK ) &&
+        ( pHttpCtx->pLwsContext == NULL ) )
     {
         ret = CreateHttpLwsContext( pHttpCtx );
     }
 
+    if( ret == NETWORKING_RESULT_OK )
+    {
+        pHttpCtx->requestStartTimeUs = NetworkingUtils_GetCurrentTimeUs( NULL );
+        pHttpCtx->headersSentTimeUs = pHttpCtx->requestStartTimeUs;
+        memset( &( pHttpCtx->lastMetrics ), 0, sizeof( NetworkingHttpMetrics_t ) );
+        pHttpCtx->lastMetrics.connectionReused = 1U;
+    }
+
     /* Fill up required headers. */
     if( ret == NETWORKING_RESULT_OK )
     {
@@ -1657,10 +1549,20 @@ NetworkingResult_t Networking_HttpSend( NetworkingHttpContext_t * pHttpCtx,
 
     if( ret == NETWORKING_RESULT_OK )
     {
-        pHttpCtx->iso8601TimeLength = ISO8601_TIME_LENGTH;
+        if( GetPortFromUrl( pRequest->pUrl,
+                            pRequest->urlLength,
+                            &( pHttpCtx->uriPort ) ) != 0 )
+        {
+            LogError( ( "Failed to extract port from the URL!" ) );
+            ret = NETWORKING_RESULT_FAIL;
+        }
+    }
 
+    if( ret == NETWORKING_RESULT_OK )
+    {
         if( GetCurrentTimeInIso8601Format( &( pHttpCtx->iso8601Time[ 0 ] ),
-                                           &( pHttpCtx->iso8601TimeLength ) ) == 0 )
+                                           &( pHttpCtx->iso8601TimeLength ),
+                                           &( pHttpCtx->iso8601TimeSeconds ) ) == 0 )
         {
             pHttpCtx->requiredHeaders[ REQUIRED_HEADER_ISO8601_TIME_IDX ].pName = "x-amz-date";
             pHttpCtx->requiredHeaders[ REQUIRED_HEADER_ISO8601_TIME_IDX ].pValue = &( pHttpCtx->iso8601Time[ 0 ] );
@@ -1745,35 +1647,75 @@ NetworkingResult_t Networking_HttpSend( NetworkingHttpContext_t * pHttpCtx,
 
         /* HTTP status code (200, 403, etc) would be stored in this variable. */
         pHttpCtx->httpStatusCode = 0;
+        pResponse->contentLength = 0;
+
+        pHttpCtx->pCurrentHost = GetPooledHost( pHttpCtx );
+        pHttpCtx->transactionId++;
+        pHttpCtx->transactionCompleted = 0U;
 
         memset( &( connectInfo ), 0, sizeof( struct lws_client_connect_info ) );
 
         connectInfo.context = pHttpCtx->pLwsContext;
-        connectInfo.ssl_connection = LCCSCF_USE_SSL;
-        connectInfo.port = 443;
+        /* Queue on an idle keep-alive connection to the same host if any. */
+        connectInfo.ssl_connection = LCCSCF_USE_SSL | LCCSCF_PIPELINE;
+        connectInfo.port = pHttpCtx->uriPort;
         connectInfo.address = &( pHttpCtx->uriHost[ 0 ] );
         connectInfo.path = &( pHttpCtx->uriPath[ 0 ] );
         connectInfo.host = connectInfo.address;
         connectInfo.pwsi = &( clientLws );
-        connectInfo.opaque_user_data = NULL;
+        connectInfo.opaque_user_data = ( void * ) pHttpCtx->transactionId;
         connectInfo.method = pRequest->verb == HTTP_GET ? "GET" : "POST";
         connectInfo.protocol = "https";
 
-        ( void ) lws_client_connect_via_info( &( connectInfo ) );
+        if( lws_client_connect_via_info( &( connectInfo ) ) == NULL )
+        {
+            LogError( ( "lws_client_connect_via_info failed!" ) );
+            pHttpCtx->httpStatusCode = -1;
+            pHttpCtx->transactionCompleted = 1U;
+        }
 
-        pHttpCtx->connectionClosed = 0U;
-        while( pHttpCtx->connectionClosed == 0U )
+        while( pHttpCtx->transactionCompleted == 0U )
         {
             ( void ) lws_service( pHttpCtx->pLwsContext, 0 );
         }
 
-        lws_context_destroy( pHttpCtx->pLwsContext );
+        pHttpCtx->lastMetrics.totalTimeUs = NetworkingUtils_GetCurrentTimeUs( NULL ) - pHttpCtx->requestStartTimeUs;
+
+        LogDebug( ( "HTTP %.*s: reused: %u, connect: %lu us, TTFB: %lu us, total: %lu us, requests: %u, connections: %u",
+                    ( int ) pHttpCtx->uriHostLength,
+                    &( pHttpCtx->uriHost[ 0 ] ),
+                    pHttpCtx->lastMetrics.connectionReused,
+                    pHttpCtx->lastMetrics.connectTimeUs,
+                    pHttpCtx->lastMetrics.timeToFirstByteUs,
+                    pHttpCtx->lastMetrics.totalTimeUs,
+                    pHttpCtx->pCurrentHost->requestCount,
+                    pHttpCtx->pCurrentHost->connectionCount ) );
+
+        #if METRIC_PRINT_ENABLED
+        if( pHttpCtx->lastMetrics.connectionReused == 0U )
+        {
+            Metric_RecordHistogram( METRIC_HISTOGRAM_HTTP_CONNECT, pHttpCtx->lastMetrics.connectTimeUs );
+        }
+        Metric_RecordHistogram( METRIC_HISTOGRAM_HTTP_TIME_TO_FIRST_BYTE, pHttpCtx->lastMetrics.timeToFirstByteUs );
+        Metric_RecordHistogram( METRIC_HISTOGRAM_HTTP_TOTAL, pHttpCtx->lastMetrics.totalTimeUs );
+        Metric_RecordHistogram( METRIC_HISTOGRAM_HTTP_CONNECTION_REUSED, pHttpCtx->lastMetrics.connectionReused );
+        #endif
+
+        pHttpCtx->pCurrentHost = NULL;
 
         if( pHttpCtx->httpStatusCode != 200 )
         {
             LogWarn( ( "HTTP status code = %d", pHttpCtx->httpStatusCode ) );
             ret = NETWORKING_RESULT_FAIL;
         }
+
+        /* No response means the connection may be broken, so the retry
+         * starts from a fresh context instead of reusing it. */
+        if( pHttpCtx->httpStatusCode <= 0 )
+        {
+            lws_context_destroy( pHttpCtx->pLwsContext );
+            pHttpCtx->pLwsContext = NULL;
+        }
     }
 
     return ret;
@@ -1813,6 +1755,13 @@ NetworkingResult_t Networking_WebsocketConnect( NetworkingWebsocketContext_t * p
                 break;
             }
 
+            /* Clean the lws context of the previous connection. */
+            if( pWebsocketCtx->pLwsContext != NULL )
+            {
+                lws_context_destroy( pWebsocketCtx->pLwsContext );
+                pWebsocketCtx->pLwsContext = NULL;
+            }
+
             memset( &retryPolicy, 0, sizeof( lws_retry_bo_t ) );
             retryPolicy.secs_since_valid_ping = 10;
             retryPolicy.secs_since_valid_hangup = 7200;
@@ -1878,10 +1827,19 @@ NetworkingResult_t Networking_WebsocketConnect( NetworkingWebsocketContext_t * p
                 break;
             }
 
+            if( GetPortFromUrl( pConnectInfo->pUrl,
+                                pConnectInfo->urlLength,
+                                &( pWebsocketCtx->uriPort ) ) != 0 )
+            {
+                LogError( ( "Failed to extract port from the URL!" ) );
+                ret = NETWORKING_RESULT_FAIL;
+                break;
+            }
+
             /* Get current time in ISO8601 format. */
-            pWebsocketCtx->iso8601TimeLength = ISO8601_TIME_LENGTH;
             if( GetCurrentTimeInIso8601Format( &( pWebsocketCtx->iso8601Time[ 0 ] ),
-                                               &( pWebsocketCtx->iso8601TimeLength ) ) != 0 )
+                                               &( pWebsocketCtx->iso8601TimeLength ),
+                                               &( pWebsocketCtx->iso8601TimeSeconds ) ) != 0 )
             {
                 LogError( ( "Failed to get ISO8601 time!" ) );
                 ret = NETWORKING_RESULT_FAIL;
@@ -1907,7 +1865,7 @@ NetworkingResult_t Networking_WebsocketConnect( NetworkingWebsocketContext_t * p
 
                 connectInfo.context = pWebsocketCtx->pLwsContext;
                 connectInfo.ssl_connection = LCCSCF_USE_SSL;
-                connectInfo.port = 443;
+                connectInfo.port = pWebsocketCtx->uriPort;
                 connectInfo.address = &( pWebsocketCtx->uriHost[ 0 ] );
                 connectInfo.path = &( pWebsocketCtx->uriPath[ 0 ] );
                 connectInfo.host = connectInfo.address;
@@ -1944,6 +1902,26 @@ NetworkingResult_t Networking_WebsocketConnect( NetworkingWebsocketContext_t * p
 NetworkingResult_t Networking_WebsocketSend( NetworkingWebsocketContext_t * pWebsocketCtx,
                                              const char * pMessage,
                                              size_t messageLength )
+{
+    NetworkingResult_t ret;
+
+    ret = Networking_WebsocketQueue( pWebsocketCtx,
+                                     pMessage,
+                                     messageLength );
+
+    if( ret == NETWORKING_RESULT_OK )
+    {
+        ret = Networking_WebsocketFlush( pWebsocketCtx );
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+NetworkingResult_t Networking_WebsocketQueue( NetworkingWebsocketContext_t * pWebsocketCtx,
+                                              const char * pMessage,
+                                              size_t messageLength )
 {
     NetworkingResult_t ret = NETWORKING_RESULT_OK;
     char * pWebsocketMessage;
@@ -1982,6 +1960,20 @@ NetworkingResult_t Networking_WebsocketSend( NetworkingWebsocketContext_t * pWeb
         }
     }
 
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+NetworkingResult_t Networking_WebsocketFlush( NetworkingWebsocketContext_t * pWebsocketCtx )
+{
+    NetworkingResult_t ret = NETWORKING_RESULT_OK;
+
+    if( pWebsocketCtx == NULL )
+    {
+        ret = NETWORKING_RESULT_BAD_PARAM;
+    }
+
     if( ret == NETWORKING_RESULT_OK )
     {
         /* This will cause a LWS_CALLBACK_EVENT_WAIT_CANCELLED in the lws
@@ -2033,10 +2025,8 @@ NetworkingResult_t Networking_WebsocketSignal( NetworkingWebsocketContext_t * pW
 
         if( pWebsocketCtx->connectionClosed == 1 )
         {
-            /* Clean lws context. */
-            lws_context_destroy( pWebsocketCtx->pLwsContext );
-            pWebsocketCtx->pLwsContext = NULL;
-
+            /* The lws context is destroyed by the next connect, other threads
+             * may still flush to it until they learn about the close. */
             LogWarn( ( "Websocket connection is closed!" ) );
             ret = NETWORKING_RESULT_FAIL;
         }
@@ -16,6 +16,7 @@
 
 /* Standard includes. */
 #include <stdlib.h>
+#include <time.h>
 
 /* LWS includes. */
 #include "libwebsockets.h"
@@ -23,6 +24,9 @@
 /* Ring buffer includes. */
 #include "ring_buffer.h"
 
+/* SigV4 includes. */
+#include "networking_sigv4.h"
+
 /* Logging includes. */
 #include "logging.h"
 
@@ -34,7 +38,24 @@
 #define SIGV4_METADATA_BUFFER_LENGTH                4096
 #define SIGV4_AUTHORIZATION_HEADER_BUFFER_LENGTH    2048
 #define HTTP_RX_BUFFER_LENGTH                       2048
-#define WEBSOCKET_RX_BUFFER_LENGTH                  ( 12 * 1024 )
+/* Signaling messages are decoded in place here, so this bounds the SDP offer
+ * size. Browser offers with many codecs and candidates go past 10 KB. */
+#define WEBSOCKET_RX_BUFFER_LENGTH                  ( 64 * 1024 )
+#define WEBSOCKET_CHANNEL_ARN_BUFFER_LENGTH         256
+
+/* Hosts tracked by the HTTP keep-alive pool. The control plane, the IoT
+ * credential provider and the storage endpoint are the usual ones. */
+#define HTTP_MAX_POOLED_HOSTS                       4
+
+/* Responses larger than the caller buffer are accumulated in a buffer owned
+ * by the HTTP context, up to this size. */
+#define HTTP_MAX_RESPONSE_LENGTH                    ( 64 * 1024 )
+
+/* TLS sessions kept for resumption, in seconds. */
+#define HTTP_TLS_SESSION_TIMEOUT_SECONDS            300
+
+/* Used unless the URL has an explicit port. */
+#define NETWORKING_DEFAULT_TLS_PORT                 443
 
 /*----------------------------------------------------------------------------*/
 
@@ -130,6 +151,27 @@ typedef struct WebsocketConnectInfo
     void * pRxCallbackData;
 } WebsocketConnectInfo_t;
 
+typedef struct NetworkingHttpMetrics
+{
+    /* Time to get a connection ready to send, including TCP connect and TLS
+     * handshake. Zero when an idle keep-alive connection is reused. */
+    uint64_t connectTimeUs;
+    /* Time from sending the request headers to receiving the response headers. */
+    uint64_t timeToFirstByteUs;
+    uint64_t totalTimeUs;
+    uint8_t connectionReused;
+} NetworkingHttpMetrics_t;
+
+typedef struct NetworkingHttpPooledHost
+{
+    char host[ HTTP_URI_HOST_BUFFER_LENGTH + 1 ];
+    size_t hostLength;
+    uint16_t port;
+    uint32_t requestCount;
+    uint32_t connectionCount;
+    uint64_t lastUsedTimeUs;
+} NetworkingHttpPooledHost_t;
+
 typedef struct NetworkingHttpContext
 {
     struct lws_context * pLwsContext;
@@ -139,10 +181,12 @@ typedef struct NetworkingHttpContext
     /* Current time in ISO8601 format. */
     char iso8601Time[ ISO8601_TIME_LENGTH ];
     size_t iso8601TimeLength;
+    time_t iso8601TimeSeconds;
 
     /* Host portion of the URI. */
     char uriHost[ HTTP_URI_HOST_BUFFER_LENGTH + 1 ];
     size_t uriHostLength;
+    uint16_t uriPort;
 
     /* Path portion of the URI. */
     char uriPath[ HTTP_URI_PATH_BUFFER_LENGTH + 1 ];
@@ -154,13 +198,31 @@ typedef struct NetworkingHttpContext
 
     /* Used in SigV4 calculation. */
     char sigV4Metadata[ SIGV4_METADATA_BUFFER_LENGTH ];
+    NetworkingSigV4Cache_t sigV4Cache;
 
     HttpRequestHeader_t requiredHeaders[ NUM_REQUIRED_HEADERS ];
     HttpRequest_t * pRequest;
     HttpResponse_t * pResponse;
     char rxBuffer[ HTTP_RX_BUFFER_LENGTH ];
-    uint8_t connectionClosed;
     int httpStatusCode;
+
+    /* The LWS context lives across requests so that its connections to each
+     * host are kept alive and reused. Every request gets a new transaction
+     * ID, which is the opaque user data of its wsi, to ignore callbacks of
+     * connections that belong to earlier requests. */
+    uintptr_t transactionId;
+    uint8_t transactionCompleted;
+    NetworkingHttpPooledHost_t pooledHosts[ HTTP_MAX_POOLED_HOSTS ];
+    NetworkingHttpPooledHost_t * pCurrentHost;
+
+    /* Grown when a response doesn't fit in the caller buffer. */
+    char * pResponseBuffer;
+    size_t responseBufferCapacity;
+
+    /* Timing of the last request. */
+    uint64_t requestStartTimeUs;
+    uint64_t headersSentTimeUs;
+    NetworkingHttpMetrics_t lastMetrics;
 } NetworkingHttpContext_t;
 
 typedef struct NetworkingWebsocketContext
@@ -173,10 +235,12 @@ typedef struct NetworkingWebsocketContext
     /* Current time in ISO8601 format. */
     char iso8601Time[ ISO8601_TIME_LENGTH ];
     size_t iso8601TimeLength;
+    time_t iso8601TimeSeconds;
 
     /* Host portion of the URI. */
     char uriHost[ WEBSOCKET_URI_HOST_BUFFER_LENGTH + 1 ];
     size_t uriHostLength;
+    uint16_t uriPort;
 
     /* Path portion of the URI. */
     char uriPath[ WEBSOCKET_URI_PATH_BUFFER_LENGTH + 1 ];
@@ -188,6 +252,14 @@ typedef struct NetworkingWebsocketContext
 
     /* Used in SigV4 calculation. */
     char sigV4Metadata[ SIGV4_METADATA_BUFFER_LENGTH ];
+    NetworkingSigV4Cache_t sigV4Cache;
+
+    /* Channel ARN of the last connect and its URI encoded form. */
+    char channelArn[ WEBSOCKET_CHANNEL_ARN_BUFFER_LENGTH ];
+    size_t channelArnLength;
+    char encodedChannelArn[ 3 * WEBSOCKET_CHANNEL_ARN_BUFFER_LENGTH ];
+    size_t encodedChannelArnLength;
+
     WebsocketMessageReceivedCallback_t rxCallback;
     void * pRxCallbackData;
     char rxBuffer[ WEBSOCKET_RX_BUFFER_LENGTH ];
@@ -203,9 +275,16 @@ typedef struct NetworkingWebsocketContext
 NetworkingResult_t Networking_HttpInit( NetworkingHttpContext_t * pHttpCtx,
                                         const SSLCredentials_t * pCreds );
 
+/* Destroy the LWS context, closing the pooled connections, and free the
+ * response buffer. The context can be initialized again afterwards. */
+void Networking_HttpDeinit( NetworkingHttpContext_t * pHttpCtx );
+
 NetworkingResult_t Networking_WebsocketInit( NetworkingWebsocketContext_t * pWebsocketCtx,
                                              const SSLCredentials_t * pCreds );
 
+/* Connections are kept alive between calls. If the response doesn't fit in
+ * pResponse->pContent, it's replaced by a buffer owned by pHttpCtx which stays
+ * valid until the next call. */
 NetworkingResult_t Networking_HttpSend( NetworkingHttpContext_t * pHttpCtx,
                                         HttpRequest_t * pRequest,
                                         const AwsCredentials_t * pAwsCredentials,
@@ -223,6 +302,14 @@ NetworkingResult_t Networking_WebsocketSend( NetworkingWebsocketContext_t * pWeb
                                              const char * pMessage,
                                              size_t messageLength );
 
+/* Queue a message without waking up the service thread, call
+ * Networking_WebsocketFlush once after queuing a batch. */
+NetworkingResult_t Networking_WebsocketQueue( NetworkingWebsocketContext_t * pWebsocketCtx,
+                                              const char * pMessage,
+                                              size_t messageLength );
+
+NetworkingResult_t Networking_WebsocketFlush( NetworkingWebsocketContext_t * pWebsocketCtx );
+
 NetworkingResult_t Networking_WebsocketSignal( NetworkingWebsocketContext_t * pWebsocketCtx );
 
 /*----------------------------------------------------------------------------*/
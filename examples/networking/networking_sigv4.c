@@ -0,0 +1,631 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <string.h>
+
+/* MbedTLS includes. */
+#include "mbedtls/md.h"
+#include "mbedtls/sha256.h"
+
+/* Logging includes. */
+#include "logging.h"
+
+/* Interface includes. */
+#include "networking_sigv4.h"
+
+/*----------------------------------------------------------------------------*/
+
+#define SIGV4_KEY_PREFIX            "AWS4"
+#define SIGV4_KEY_BUFFER_LENGTH     ( 4 + 128 )
+#define SIGV4_SCOPE_TERMINATOR      "aws4_request"
+#define SIGV4_STRING_TO_SIGN_LENGTH ( sizeof( NETWORKING_SIGV4_ALGORITHM ) + NETWORKING_SIGV4_ISO8601_TIME_LENGTH + NETWORKING_SIGV4_SCOPE_BUFFER_LENGTH + NETWORKING_SIGV4_HEX_DIGEST_LENGTH + 3 )
+
+/*----------------------------------------------------------------------------*/
+
+static int HmacSha256( const uint8_t * pKey,
+                       size_t keyLength,
+                       const uint8_t * pData,
+                       size_t dataLength,
+                       uint8_t * pOutput );
+
+static int Sha256( const uint8_t * pData,
+                   size_t dataLength,
+                   uint8_t * pOutput );
+
+static void ToHex( const uint8_t * pDigest,
+                   char * pHex );
+
+static int DeriveSigningKey( NetworkingSigV4Cache_t * pCache,
+                             const char * pSecretAccessKey,
+                             size_t secretAccessKeyLength,
+                             const char * pRegion,
+                             size_t regionLength,
+                             const char * pService,
+                             size_t serviceLength );
+
+/*----------------------------------------------------------------------------*/
+
+static int HmacSha256( const uint8_t * pKey,
+                       size_t keyLength,
+                       const uint8_t * pData,
+                       size_t dataLength,
+                       uint8_t * pOutput )
+{
+    int ret = 0;
+
+    if( mbedtls_md_hmac( mbedtls_md_info_from_type( MBEDTLS_MD_SHA256 ),
+                         pKey,
+                         keyLength,
+                         pData,
+                         dataLength,
+                         pOutput ) != 0 )
+    {
+        LogError( ( "Fail to calculate HMAC-SHA256" ) );
+        ret = -1;
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static int Sha256( const uint8_t * pData,
+                   size_t dataLength,
+                   uint8_t * pOutput )
+{
+    mbedtls_sha256_context hashContext;
+
+    mbedtls_sha256_init( &( hashContext ) );
+    mbedtls_sha256_starts( &( hashContext ), 0 );
+    mbedtls_sha256_update( &( hashContext ), pData, dataLength );
+    mbedtls_sha256_finish( &( hashContext ), pOutput );
+    mbedtls_sha256_free( &( hashContext ) );
+
+    return 0;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static void ToHex( const uint8_t * pDigest,
+                   char * pHex )
+{
+    const char alpha[ 17 ] = "0123456789abcdef";
+    size_t i;
+
+    for( i = 0; i < NETWORKING_SIGV4_DIGEST_LENGTH; i++ )
+    {
+        pHex[ 2 * i ] = alpha[ pDigest[ i ] >> 4 ];
+        pHex[ 2 * i + 1 ] = alpha[ pDigest[ i ] & 0x0F ];
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+static int DeriveSigningKey( NetworkingSigV4Cache_t * pCache,
+                             const char * pSecretAccessKey,
+                             size_t secretAccessKeyLength,
+                             const char * pRegion,
+                             size_t regionLength,
+                             const char * pService,
+                             size_t serviceLength )
+{
+    int ret = 0;
+    uint8_t key[ SIGV4_KEY_BUFFER_LENGTH ];
+    uint8_t kDate[ NETWORKING_SIGV4_DIGEST_LENGTH ];
+    uint8_t kRegion[ NETWORKING_SIGV4_DIGEST_LENGTH ];
+
+    if( secretAccessKeyLength + strlen( SIGV4_KEY_PREFIX ) > SIGV4_KEY_BUFFER_LENGTH )
+    {
+        LogError( ( "Secret access key is too long: %lu", secretAccessKeyLength ) );
+        ret = -1;
+    }
+
+    /* kSecret = "AWS4" + secret, kDate = HMAC( kSecret, date ). */
+    if( ret == 0 )
+    {
+        memcpy( key, SIGV4_KEY_PREFIX, strlen( SIGV4_KEY_PREFIX ) );
+        memcpy( &( key[ strlen( SIGV4_KEY_PREFIX ) ] ), pSecretAccessKey, secretAccessKeyLength );
+
+        ret = HmacSha256( key,
+                          strlen( SIGV4_KEY_PREFIX ) + secretAccessKeyLength,
+                          ( const uint8_t * ) &( pCache->scope[ 0 ] ),
+                          NETWORKING_SIGV4_DATE_LENGTH,
+                          kDate );
+
+        memset( key, 0, sizeof( key ) );
+    }
+
+    /* kRegion = HMAC( kDate, region ). */
+    if( ret == 0 )
+    {
+        ret = HmacSha256( kDate,
+                          NETWORKING_SIGV4_DIGEST_LENGTH,
+                          ( const uint8_t * ) pRegion,
+                          regionLength,
+                          kRegion );
+    }
+
+    /* kService = HMAC( kRegion, service ), reusing the kDate buffer. */
+    if( ret == 0 )
+    {
+        ret = HmacSha256( kRegion,
+                          NETWORKING_SIGV4_DIGEST_LENGTH,
+                          ( const uint8_t * ) pService,
+                          serviceLength,
+                          kDate );
+    }
+
+    /* kSigning = HMAC( kService, "aws4_request" ). */
+    if( ret == 0 )
+    {
+        ret = HmacSha256( kDate,
+                          NETWORKING_SIGV4_DIGEST_LENGTH,
+                          ( const uint8_t * ) SIGV4_SCOPE_TERMINATOR,
+                          strlen( SIGV4_SCOPE_TERMINATOR ),
+                          &( pCache->signingKey[ 0 ] ) );
+    }
+
+    memset( kDate, 0, sizeof( kDate ) );
+    memset( kRegion, 0, sizeof( kRegion ) );
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+int NetworkingSigV4_PrepareCache( NetworkingSigV4Cache_t * pCache,
+                                  const char * pIso8601Time,
+                                  const char * pAccessKeyId,
+                                  size_t accessKeyIdLength,
+                                  const char * pSecretAccessKey,
+                                  size_t secretAccessKeyLength,
+                                  const char * pRegion,
+                                  size_t regionLength,
+                                  const char * pService,
+                                  size_t serviceLength )
+{
+    int ret = 0, snprintfRetVal;
+    char scope[ NETWORKING_SIGV4_SCOPE_BUFFER_LENGTH ];
+    size_t scopeLength = 0, encodedLength;
+    uint8_t secretAccessKeyDigest[ NETWORKING_SIGV4_DIGEST_LENGTH ];
+
+    if( ( pCache == NULL ) ||
+        ( pIso8601Time == NULL ) ||
+        ( pAccessKeyId == NULL ) ||
+        ( pSecretAccessKey == NULL ) ||
+        ( pRegion == NULL ) ||
+        ( pService == NULL ) )
+    {
+        LogError( ( "Invalid input, pCache: %p, pIso8601Time: %p, pAccessKeyId: %p, pSecretAccessKey: %p, pRegion: %p, pService: %p",
+                    pCache, pIso8601Time, pAccessKeyId, pSecretAccessKey, pRegion, pService ) );
+        ret = -1;
+    }
+    else if( accessKeyIdLength >= NETWORKING_SIGV4_ACCESS_KEY_ID_BUFFER_LENGTH )
+    {
+        LogError( ( "Access key ID is too long: %lu", accessKeyIdLength ) );
+        ret = -1;
+    }
+    else
+    {
+        /* Empty else marker. */
+    }
+
+    if( ret == 0 )
+    {
+        snprintfRetVal = snprintf( scope,
+                                   NETWORKING_SIGV4_SCOPE_BUFFER_LENGTH,
+                                   "%.*s/%.*s/%.*s/" SIGV4_SCOPE_TERMINATOR,
+                                   NETWORKING_SIGV4_DATE_LENGTH,
+                                   pIso8601Time,
+                                   ( int ) regionLength,
+                                   pRegion,
+                                   ( int ) serviceLength,
+                                   pService );
+
+        if( ( snprintfRetVal < 0 ) || ( snprintfRetVal >= NETWORKING_SIGV4_SCOPE_BUFFER_LENGTH ) )
+        {
+            LogError( ( "Fail to write credential scope" ) );
+            ret = -1;
+        }
+        else
+        {
+            scopeLength = snprintfRetVal;
+        }
+    }
+
+    if( ret == 0 )
+    {
+        ret = Sha256( ( const uint8_t * ) pSecretAccessKey,
+                      secretAccessKeyLength,
+                      secretAccessKeyDigest );
+    }
+
+    /* Same day, region, service and credentials, nothing to do. */
+    if( ( ret == 0 ) &&
+        ( pCache->isValid != 0U ) &&
+        ( pCache->scopeLength == scopeLength ) &&
+        ( memcmp( pCache->scope, scope, scopeLength ) == 0 ) &&
+        ( pCache->accessKeyIdLength == accessKeyIdLength ) &&
+        ( memcmp( pCache->accessKeyId, pAccessKeyId, accessKeyIdLength ) == 0 ) &&
+        ( memcmp( pCache->secretAccessKeyDigest, secretAccessKeyDigest, NETWORKING_SIGV4_DIGEST_LENGTH ) == 0 ) )
+    {
+        pCache->hitCount++;
+    }
+    else if( ret == 0 )
+    {
+        pCache->isValid = 0U;
+        pCache->missCount++;
+
+        memcpy( pCache->scope, scope, scopeLength );
+        pCache->scope[ scopeLength ] = '\0';
+        pCache->scopeLength = scopeLength;
+        memcpy( pCache->accessKeyId, pAccessKeyId, accessKeyIdLength );
+        pCache->accessKeyId[ accessKeyIdLength ] = '\0';
+        pCache->accessKeyIdLength = accessKeyIdLength;
+        memcpy( pCache->secretAccessKeyDigest, secretAccessKeyDigest, NETWORKING_SIGV4_DIGEST_LENGTH );
+
+        ret = DeriveSigningKey( pCache,
+                                pSecretAccessKey,
+                                secretAccessKeyLength,
+                                pRegion,
+                                regionLength,
+                                pService,
+                                serviceLength );
+
+        if( ret == 0 )
+        {
+            snprintfRetVal = snprintf( pCache->credential,
+                                       NETWORKING_SIGV4_CREDENTIAL_BUFFER_LENGTH,
+                                       "%.*s/%.*s",
+                                       ( int ) accessKeyIdLength,
+                                       pAccessKeyId,
+                                       ( int ) scopeLength,
+                                       scope );
+
+            if( ( snprintfRetVal < 0 ) || ( snprintfRetVal >= NETWORKING_SIGV4_CREDENTIAL_BUFFER_LENGTH ) )
+            {
+                LogError( ( "Fail to write credential" ) );
+                ret = -1;
+            }
+            else
+            {
+                pCache->credentialLength = snprintfRetVal;
+            }
+        }
+
+        if( ret == 0 )
+        {
+            encodedLength = NETWORKING_SIGV4_CREDENTIAL_BUFFER_LENGTH - 1;
+            ret = NetworkingSigV4_UriEncode( pCache->credential,
+                                             pCache->credentialLength,
+                                             pCache->encodedCredential,
+                                             &( encodedLength ) );
+            if( ret == 0 )
+            {
+                pCache->encodedCredential[ encodedLength ] = '\0';
+                pCache->encodedCredentialLength = encodedLength;
+            }
+            else
+            {
+                LogError( ( "Fail to encode credential" ) );
+            }
+        }
+
+        if( ret == 0 )
+        {
+            pCache->isValid = 1U;
+            LogDebug( ( "Derived SigV4 signing key for scope: %s", pCache->scope ) );
+        }
+    }
+    else
+    {
+        /* Empty else marker. */
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+void NetworkingSigV4_InvalidateCache( NetworkingSigV4Cache_t * pCache )
+{
+    if( pCache != NULL )
+    {
+        pCache->isValid = 0U;
+        memset( pCache->signingKey, 0, NETWORKING_SIGV4_DIGEST_LENGTH );
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+int NetworkingSigV4_Sign( const NetworkingSigV4Cache_t * pCache,
+                          const char * pIso8601Time,
+                          const char * pCanonicalRequest,
+                          size_t canonicalRequestLength,
+                          char * pSignature )
+{
+    int ret = 0;
+    char stringToSign[ SIGV4_STRING_TO_SIGN_LENGTH ];
+    char * pCurrent = &( stringToSign[ 0 ] );
+    uint8_t digest[ NETWORKING_SIGV4_DIGEST_LENGTH ];
+
+    if( ( pCache == NULL ) ||
+        ( pIso8601Time == NULL ) ||
+        ( pCanonicalRequest == NULL ) ||
+        ( pSignature == NULL ) )
+    {
+        LogError( ( "Invalid input, pCache: %p, pIso8601Time: %p, pCanonicalRequest: %p, pSignature: %p",
+                    pCache, pIso8601Time, pCanonicalRequest, pSignature ) );
+        ret = -1;
+    }
+    else if( pCache->isValid == 0U )
+    {
+        LogError( ( "SigV4 cache is not prepared" ) );
+        ret = -1;
+    }
+    else
+    {
+        /* Empty else marker. */
+    }
+
+    /* AWS4-HMAC-SHA256\n<time>\n<scope>\n<hex hash of canonical request>. */
+    if( ret == 0 )
+    {
+        memcpy( pCurrent, NETWORKING_SIGV4_ALGORITHM, strlen( NETWORKING_SIGV4_ALGORITHM ) );
+        pCurrent += strlen( NETWORKING_SIGV4_ALGORITHM );
+        *pCurrent++ = '\n';
+        memcpy( pCurrent, pIso8601Time, NETWORKING_SIGV4_ISO8601_TIME_LENGTH );
+        pCurrent += NETWORKING_SIGV4_ISO8601_TIME_LENGTH;
+        *pCurrent++ = '\n';
+        memcpy( pCurrent, pCache->scope, pCache->scopeLength );
+        pCurrent += pCache->scopeLength;
+        *pCurrent++ = '\n';
+
+        ret = Sha256( ( const uint8_t * ) pCanonicalRequest,
+                      canonicalRequestLength,
+                      digest );
+    }
+
+    if( ret == 0 )
+    {
+        ToHex( digest, pCurrent );
+        pCurrent += NETWORKING_SIGV4_HEX_DIGEST_LENGTH;
+
+        ret = HmacSha256( pCache->signingKey,
+                          NETWORKING_SIGV4_DIGEST_LENGTH,
+                          ( const uint8_t * ) stringToSign,
+                          pCurrent - stringToSign,
+                          digest );
+    }
+
+    if( ret == 0 )
+    {
+        ToHex( digest, pSignature );
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+int NetworkingSigV4_HexHash( const uint8_t * pData,
+                             size_t dataLength,
+                             char * pHexDigest )
+{
+    int ret;
+    uint8_t digest[ NETWORKING_SIGV4_DIGEST_LENGTH ];
+
+    ret = Sha256( pData, dataLength, digest );
+
+    if( ret == 0 )
+    {
+        ToHex( digest, pHexDigest );
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+int NetworkingSigV4_UriEncode( const char * pSrc,
+                               size_t srcLength,
+                               char * pDst,
+                               size_t * pDstLength )
+{
+    int ret = 0;
+    uint8_t ch;
+    size_t i, j, remainingLength = *pDstLength;
+    const char alpha[ 17 ] = "0123456789ABCDEF";
+
+    for( i = 0, j = 0; i < srcLength; i++ )
+    {
+        ch = ( uint8_t ) pSrc[ i ];
+
+        if( ( ( ch >= 'A' ) && ( ch <= 'Z' ) ) ||
+            ( ( ch >= 'a' ) && ( ch <= 'z' ) ) ||
+            ( ( ch >= '0' ) && ( ch <= '9' ) ) ||
+            ( ch == '_' ) ||
+            ( ch == '-' ) ||
+            ( ch == '~' ) ||
+            ( ch == '.' ) )
+        {
+            if( remainingLength < 1 )
+            {
+                ret = -1;
+                break;
+            }
+            else
+            {
+                pDst[ j ] = ch;
+                j++;
+                remainingLength -= 1;
+            }
+        }
+        else
+        {
+            if( remainingLength < 3 )
+            {
+                ret = -1;
+                break;
+            }
+            else
+            {
+                pDst[ j ] = '%';
+                pDst[ j + 1 ] = alpha[ ch >> 4 ];
+                pDst[ j + 2 ] = alpha[ ch & 0x0F ];
+                j += 3;
+                remainingLength -= 3;
+            }
+        }
+    }
+
+    if( ret == 0 )
+    {
+        *pDstLength = j;
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+int NetworkingSigV4_CanonicalizePath( const char * pPath,
+                                      size_t pathLength,
+                                      char * pDst,
+                                      size_t * pDstLength )
+{
+    int ret = 0;
+    char encodedSegment[ 3 * 256 ];
+    size_t i, segmentStart, encodedLength, secondLength;
+    size_t writtenLength = 0, remainingLength = *pDstLength;
+
+    if( pathLength == 0 )
+    {
+        if( remainingLength < 1 )
+        {
+            ret = -1;
+        }
+        else
+        {
+            pDst[ 0 ] = '/';
+            writtenLength = 1;
+        }
+    }
+
+    for( i = 0, segmentStart = 0; ( ret == 0 ) && ( i <= pathLength ); i++ )
+    {
+        if( ( i < pathLength ) && ( pPath[ i ] != '/' ) )
+        {
+            continue;
+        }
+
+        /* Encode the segment once in the scratch buffer, then again in the output. */
+        encodedLength = sizeof( encodedSegment );
+        ret = NetworkingSigV4_UriEncode( &( pPath[ segmentStart ] ),
+                                         i - segmentStart,
+                                         encodedSegment,
+                                         &( encodedLength ) );
+
+        if( ret == 0 )
+        {
+            secondLength = remainingLength;
+            ret = NetworkingSigV4_UriEncode( encodedSegment,
+                                             encodedLength,
+                                             &( pDst[ writtenLength ] ),
+                                             &( secondLength ) );
+        }
+
+        if( ret == 0 )
+        {
+            writtenLength += secondLength;
+            remainingLength -= secondLength;
+
+            if( i < pathLength )
+            {
+                if( remainingLength < 1 )
+                {
+                    ret = -1;
+                }
+                else
+                {
+                    pDst[ writtenLength ] = '/';
+                    writtenLength++;
+                    remainingLength--;
+                }
+            }
+        }
+
+        segmentStart = i + 1;
+    }
+
+    if( ret == 0 )
+    {
+        *pDstLength = writtenLength;
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+int NetworkingSigV4_CanonicalizeHeaderValue( const char * pValue,
+                                              size_t valueLength,
+                                              char * pDst,
+                                              size_t * pDstLength )
+{
+    int ret = 0;
+    size_t i, j = 0;
+    uint8_t pendingSpace = 0U;
+
+    /* Trim leading and trailing whitespace and fold each run in between,
+     * obsolete line folding included, into a single space. */
+    for( i = 0; i < valueLength; i++ )
+    {
+        if( ( pValue[ i ] == ' ' ) ||
+            ( pValue[ i ] == '\t' ) ||
+            ( pValue[ i ] == '\r' ) ||
+            ( pValue[ i ] == '\n' ) )
+        {
+            pendingSpace = ( j > 0 ) ? 1U : 0U;
+            continue;
+        }
+
+        if( j + pendingSpace + 1 > *pDstLength )
+        {
+            ret = -1;
+            break;
+        }
+
+        if( pendingSpace != 0U )
+        {
+            pDst[ j++ ] = ' ';
+            pendingSpace = 0U;
+        }
+
+        pDst[ j++ ] = pValue[ i ];
+    }
+
+    if( ret == 0 )
+    {
+        *pDstLength = j;
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
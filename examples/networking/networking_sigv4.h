@@ -0,0 +1,119 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef NETWORKING_SIGV4_H
+#define NETWORKING_SIGV4_H
+
+/* Standard includes. */
+#include <stdint.h>
+#include <stddef.h>
+
+/*----------------------------------------------------------------------------*/
+
+#define NETWORKING_SIGV4_ALGORITHM                  "AWS4-HMAC-SHA256"
+#define NETWORKING_SIGV4_EMPTY_PAYLOAD_HASH         "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"
+#define NETWORKING_SIGV4_DIGEST_LENGTH              32
+#define NETWORKING_SIGV4_HEX_DIGEST_LENGTH          64
+#define NETWORKING_SIGV4_ISO8601_TIME_LENGTH        16
+#define NETWORKING_SIGV4_DATE_LENGTH                8
+#define NETWORKING_SIGV4_SCOPE_BUFFER_LENGTH        128
+#define NETWORKING_SIGV4_ACCESS_KEY_ID_BUFFER_LENGTH 128
+#define NETWORKING_SIGV4_CREDENTIAL_BUFFER_LENGTH   ( 3 * ( NETWORKING_SIGV4_ACCESS_KEY_ID_BUFFER_LENGTH + NETWORKING_SIGV4_SCOPE_BUFFER_LENGTH ) )
+
+/*----------------------------------------------------------------------------*/
+
+/* The signing key only depends on the date, region, service and secret key,
+ * so it's derived once and reused until one of them changes. The secret key
+ * itself isn't stored, only its digest to detect credential refresh. */
+typedef struct NetworkingSigV4Cache
+{
+    uint8_t isValid;
+
+    /* <date>/<region>/<service>/aws4_request */
+    char scope[ NETWORKING_SIGV4_SCOPE_BUFFER_LENGTH ];
+    size_t scopeLength;
+
+    char accessKeyId[ NETWORKING_SIGV4_ACCESS_KEY_ID_BUFFER_LENGTH ];
+    size_t accessKeyIdLength;
+    uint8_t secretAccessKeyDigest[ NETWORKING_SIGV4_DIGEST_LENGTH ];
+
+    uint8_t signingKey[ NETWORKING_SIGV4_DIGEST_LENGTH ];
+
+    /* <access key ID>/<scope>, plain for the Authorization header and URI
+     * encoded for the X-Amz-Credential query parameter. */
+    char credential[ NETWORKING_SIGV4_CREDENTIAL_BUFFER_LENGTH ];
+    size_t credentialLength;
+    char encodedCredential[ NETWORKING_SIGV4_CREDENTIAL_BUFFER_LENGTH ];
+    size_t encodedCredentialLength;
+
+    uint32_t hitCount;
+    uint32_t missCount;
+} NetworkingSigV4Cache_t;
+
+/*----------------------------------------------------------------------------*/
+
+/* Make sure the cache holds the signing key for the date of pIso8601Time and
+ * the given region, service and credentials. Returns 0 on success. */
+int NetworkingSigV4_PrepareCache( NetworkingSigV4Cache_t * pCache,
+                                  const char * pIso8601Time,
+                                  const char * pAccessKeyId,
+                                  size_t accessKeyIdLength,
+                                  const char * pSecretAccessKey,
+                                  size_t secretAccessKeyLength,
+                                  const char * pRegion,
+                                  size_t regionLength,
+                                  const char * pService,
+                                  size_t serviceLength );
+
+/* Force the signing key to be derived again on next use. */
+void NetworkingSigV4_InvalidateCache( NetworkingSigV4Cache_t * pCache );
+
+/* Sign the canonical request with the prepared cache, pSignature receives
+ * NETWORKING_SIGV4_HEX_DIGEST_LENGTH hex characters. */
+int NetworkingSigV4_Sign( const NetworkingSigV4Cache_t * pCache,
+                          const char * pIso8601Time,
+                          const char * pCanonicalRequest,
+                          size_t canonicalRequestLength,
+                          char * pSignature );
+
+/* Write the lower case hex SHA-256 of the data, used for the payload hash. */
+int NetworkingSigV4_HexHash( const uint8_t * pData,
+                             size_t dataLength,
+                             char * pHexDigest );
+
+/* URI encode per SigV4, '/' is encoded too. */
+int NetworkingSigV4_UriEncode( const char * pSrc,
+                               size_t srcLength,
+                               char * pDst,
+                               size_t * pDstLength );
+
+/* Write the canonical URI of the path, each segment is encoded twice as
+ * required for every service but S3. */
+int NetworkingSigV4_CanonicalizePath( const char * pPath,
+                                      size_t pathLength,
+                                      char * pDst,
+                                      size_t * pDstLength );
+
+/* Write the canonical form of a header value, leading and trailing whitespace
+ * is trimmed and each run of whitespace, line folds included, becomes one space. */
+int NetworkingSigV4_CanonicalizeHeaderValue( const char * pValue,
+                                             size_t valueLength,
+                                             char * pDst,
+                                             size_t * pDstLength );
+
+/*----------------------------------------------------------------------------*/
+
+#endif /* NETWORKING_SIGV4_H */
@@ -27,9 +27,9 @@ RingBufferResult_t RingBuffer_Init( RingBuffer_t * pRingBuffer )
 
     if( ret == RING_BUFFER_RESULT_OK )
     {
-        pRingBuffer->pHead = NULL;
-        pRingBuffer->pTail = NULL;
-        pthread_mutex_init( &( pRingBuffer->lock ), NULL );
+        pRingBuffer->stub.pNext = NULL;
+        pRingBuffer->pHead = &( pRingBuffer->stub );
+        pRingBuffer->pTail = &( pRingBuffer->stub );
     }
 
     return ret;
@@ -43,6 +43,7 @@ RingBufferResult_t RingBuffer_Insert( RingBuffer_t * pRingBuffer,
 {
     RingBufferResult_t ret = RING_BUFFER_RESULT_OK;
     RingBufferElementInternal_t * pElement;
+    RingBufferElementInternal_t * pPrevious;
 
     if( ( pRingBuffer == NULL ) ||
         ( pBuffer == NULL ) ||
@@ -68,19 +69,10 @@ RingBufferResult_t RingBuffer_Insert( RingBuffer_t * pRingBuffer,
         pElement->element.currentIndex = 0;
         pElement->pNext = NULL;
 
-        pthread_mutex_lock( &( pRingBuffer->lock ) );
-        {
-            if( pRingBuffer->pHead == NULL )
-            {
-                pRingBuffer->pHead = pRingBuffer->pTail = pElement;
-            }
-            else
-            {
-                pRingBuffer->pTail->pNext = pElement;
-                pRingBuffer->pTail = pElement;
-            }
-        }
-        pthread_mutex_unlock( &( pRingBuffer->lock ) );
+        /* Claim the tail first, then link. Until the link is published the
+         * consumer sees the queue ending at the previous node. */
+        pPrevious = __atomic_exchange_n( &( pRingBuffer->pTail ), pElement, __ATOMIC_ACQ_REL );
+        __atomic_store_n( &( pPrevious->pNext ), pElement, __ATOMIC_RELEASE );
     }
 
     return ret;
@@ -92,6 +84,7 @@ RingBufferResult_t RingBuffer_GetHeadEntry( RingBuffer_t * pRingBuffer,
                                             RingBufferElement_t ** ppElement )
 {
     RingBufferResult_t ret = RING_BUFFER_RESULT_OK;
+    RingBufferElementInternal_t * pNext;
 
     if( ( pRingBuffer == NULL ) ||
         ( ppElement == NULL ) )
@@ -101,18 +94,16 @@ RingBufferResult_t RingBuffer_GetHeadEntry( RingBuffer_t * pRingBuffer,
 
     if( ret == RING_BUFFER_RESULT_OK )
     {
-        pthread_mutex_lock( &( pRingBuffer->lock ) );
+        pNext = __atomic_load_n( &( pRingBuffer->pHead->pNext ), __ATOMIC_ACQUIRE );
+
+        if( pNext == NULL )
         {
-            if( pRingBuffer->pHead == NULL )
-            {
-                ret = RING_BUFFER_RESULT_EMPTY;
-            }
-            else
-            {
-                *ppElement = &( pRingBuffer->pHead->element );
-            }
+            ret = RING_BUFFER_RESULT_EMPTY;
+        }
+        else
+        {
+            *ppElement = &( pNext->element );
         }
-        pthread_mutex_unlock( &( pRingBuffer->lock ) );
     }
 
     return ret;
@@ -125,6 +116,7 @@ RingBufferResult_t RingBuffer_RemoveHeadEntry( RingBuffer_t * pRingBuffer,
 {
     RingBufferResult_t ret = RING_BUFFER_RESULT_OK;
     RingBufferElementInternal_t * pOldHead = NULL;
+    RingBufferElementInternal_t * pNext;
 
     if( ( pRingBuffer == NULL ) ||
         ( pElement == NULL ) )
@@ -134,21 +126,23 @@ RingBufferResult_t RingBuffer_RemoveHeadEntry( RingBuffer_t * pRingBuffer,
 
     if( ret == RING_BUFFER_RESULT_OK )
     {
-        pthread_mutex_lock( &( pRingBuffer->lock ) );
+        pNext = __atomic_load_n( &( pRingBuffer->pHead->pNext ), __ATOMIC_ACQUIRE );
+
+        if( ( pNext == NULL ) || ( &( pNext->element ) != pElement ) )
         {
-            if( &( pRingBuffer->pHead->element ) != pElement )
-            {
-                ret = RING_BUFFER_RESULT_INCONSISTENT;
-            }
-            else
+            ret = RING_BUFFER_RESULT_INCONSISTENT;
+        }
+        else
+        {
+            /* The removed entry's node becomes the new placeholder head. */
+            pOldHead = pRingBuffer->pHead;
+            pRingBuffer->pHead = pNext;
+
+            if( pOldHead != &( pRingBuffer->stub ) )
             {
-                pOldHead = pRingBuffer->pHead;
-                pRingBuffer->pHead = pRingBuffer->pHead->pNext;
+                free( pOldHead );
             }
         }
-        pthread_mutex_unlock( &( pRingBuffer->lock ) );
-
-        free( pOldHead );
     }
 
     return ret;
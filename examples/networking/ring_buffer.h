@@ -16,7 +16,6 @@
 
 #include <stdint.h>
 #include <stdlib.h>
-#include <pthread.h>
 /*----------------------------------------------------------------------------*/
 
 typedef enum RingBufferResult
@@ -43,9 +42,13 @@ typedef struct RingBufferElementInternal
     struct RingBufferElementInternal * pNext;
 } RingBufferElementInternal_t;
 
+/* Lock-free queue for multiple producers and a single consumer. Insert may be
+ * called from any thread, GetHeadEntry and RemoveHeadEntry only from the
+ * consumer thread. The head node is always a consumed placeholder, the first
+ * entry is the one after it. */
 typedef struct RingBuffer
 {
-    pthread_mutex_t lock;
+    RingBufferElementInternal_t stub;
     RingBufferElementInternal_t * pHead;
     RingBufferElementInternal_t * pTail;
 } RingBuffer_t;
@@ -24,6 +24,9 @@
 #include "peer_connection_srtp.h"
 #include "peer_connection_srtcp.h"
 #include "peer_connection_sdp.h"
+#include "peer_connection_certificate.h"
+#include "peer_connection_keyframe_cache.h"
+#include "peer_connection_sdp_template.h"
 #include "rtp_api.h"
 #include "rtcp_api.h"
 #include "peer_connection_rolling_buffer.h"
@@ -51,8 +54,6 @@
 #define PEER_CONNECTION_MAX_QUEUE_MSG_NUM ( 10 )
 #define PEER_CONNECTION_RTCP_REPORT_TIMER_INTERVAL_MS ( 5000 )
 
-#define PEER_CONNECTION_MAX_DTLS_DECRYPTED_DATA_LENGTH ( 2048 )
-
 PeerConnectionContext_t peerConnectionContext = { 0 };
 
 extern void * IceControllerSocketListener_Task( void * pParameter );
@@ -136,7 +137,9 @@ static void SessionProcessEndlessLoop( PeerConnectionSession_t * pSession )
         }
 
         /* Check connection inactivity timeout. */
+        /* During ICE restart the previous path may be the one failing, the ICE connectivity timeout decides instead. */
         if( ( pSession->state == PEER_CONNECTION_SESSION_STATE_CONNECTION_READY ) &&
+            ( pSession->isIceRestarting == 0U ) &&
             ( ( NetworkingUtils_GetCurrentTimeUs( NULL ) / 1000 ) > pSession->inactiveConnectionTimeoutMs ) )
         {
             LogInfo( ( "Detect inactive connection, closing peer connection session: %s.",
@@ -749,14 +752,32 @@ static int32_t HandleIceEventCallback( void * pCustomContext,
                 ret = OnIceEventProcessIceCandidatesAndPairs( pSession );
                 break;
             case ICE_CONTROLLER_CB_EVENT_PEER_TO_PEER_CONNECTION_FOUND:
-                /* Start DTLS handshaking. */
-                #if METRIC_PRINT_ENABLED
-                Metric_StartEvent( METRIC_EVENT_PC_DTLS_HANDSHAKING );
-                #endif
-                ret = StartDtlsHandshake( pSession );
-
-                /* This must set after StartDtlsHandshake, or the other thread might execute handshake earlier than expectation. */
-                pSession->state = PEER_CONNECTION_SESSION_STATE_P2P_CONNECTION_FOUND;
+                if( pSession->isIceRestarting != 0U )
+                {
+                    /* ICE restart found a new path, DTLS/SRTP sessions are still valid so resume media directly. */
+                    LogInfo( ( "ICE restart completed, resume media on the new path." ) );
+                    pSession->isIceRestarting = 0U;
+                    pSession->inactiveConnectionTimeoutMs = ( NetworkingUtils_GetCurrentTimeUs( NULL ) / 1000 ) + PEER_CONNECTION_INACTIVE_CONNECTION_TIMEOUT_MS;
+                    pSession->state = PEER_CONNECTION_SESSION_STATE_CONNECTION_READY;
+                    IceController_HandleEvent( &pSession->iceControllerContext,
+                                               ICE_CONTROLLER_EVENT_ICE_RESTART_DONE );
+                }
+                else
+                {
+                    /* Start DTLS handshaking. */
+                    #if METRIC_PRINT_ENABLED
+                    Metric_StartEvent( METRIC_EVENT_PC_DTLS_HANDSHAKING );
+                    #endif
+                    ret = StartDtlsHandshake( pSession );
+
+                    /* This must set after StartDtlsHandshake, or the other thread might execute handshake earlier than expectation. */
+                    pSession->state = PEER_CONNECTION_SESSION_STATE_P2P_CONNECTION_FOUND;
+                }
+                break;
+            case ICE_CONTROLLER_CB_EVENT_PATH_MIGRATED:
+                /* Media moved to the backup path, give it a full inactivity window before judging it. */
+                LogInfo( ( "Nominated path migrated to backup path." ) );
+                pSession->inactiveConnectionTimeoutMs = ( NetworkingUtils_GetCurrentTimeUs( NULL ) / 1000 ) + PEER_CONNECTION_INACTIVE_CONNECTION_TIMEOUT_MS;
                 break;
             case ICE_CONTROLLER_CB_EVENT_PERIODIC_CONNECTION_CHECK:
                 ret = OnIceEventPeriodicConnectionCheck( pSession );
@@ -813,18 +834,16 @@ static int32_t StartDtlsHandshake( PeerConnectionSession_t * pSession )
 
     if( ret == 0 )
     {
-        if( NULL == pSession->pCtx->dtlsContext.localCert.raw.p )
+        if( ( pSession->pDtlsCertificate == NULL ) ||
+            ( NULL == pSession->pDtlsCertificate->localCert.raw.p ) )
         {
-            LogError( ( "Fail to get answer cert: NULL == pSession->pCtx->dtlsContext.localCert.raw.p" ) );
+            LogError( ( "Fail to get answer cert, pDtlsCertificate: %p", pSession->pDtlsCertificate ) );
             ret = -23;
         }
         else
         {
-            /* Assign local cert to the DTLS session. */
-            pDtlsSession->xNetworkCredentials.pClientCert = &pSession->pCtx->dtlsContext.localCert;
-
-            // /* Assign local key to the DTLS session. */
-            pDtlsSession->xNetworkCredentials.pPrivateKey = &pSession->pCtx->dtlsContext.localKey;
+            /* Assign the shared SSL configuration holding local cert/key to the DTLS session. */
+            pDtlsSession->xNetworkCredentials.pSharedConfig = &pSession->pDtlsCertificate->sharedConfig;
 
             /* Attempt to create a DTLS connection. */
             xNetworkStatus = DTLS_Init( &pDtlsSession->xDtlsNetworkContext,
@@ -950,6 +969,9 @@ static int32_t OnDtlsHandshakeComplete( PeerConnectionSession_t * pSession )
     DtlsTransportStatus_t xNetworkStatus = DTLS_SUCCESS;
     PeerConnectionResult_t retPc;
     uint32_t i;
+    #if METRIC_PRINT_ENABLED
+    uint64_t stepStartTimeUs = NetworkingUtils_GetCurrentTimeUs( NULL );
+    #endif
 
     LogDebug( ( "Complete DTLS handshaking." ) );
     #if METRIC_PRINT_ENABLED
@@ -967,6 +989,12 @@ static int32_t OnDtlsHandshakeComplete( PeerConnectionSession_t * pSession )
         ret = -0x1001;
     }
 
+    #if METRIC_PRINT_ENABLED
+    Metric_RecordHistogram( METRIC_HISTOGRAM_DTLS_VERIFY_FINGERPRINT,
+                            NetworkingUtils_GetCurrentTimeUs( NULL ) - stepStartTimeUs );
+    stepStartTimeUs = NetworkingUtils_GetCurrentTimeUs( NULL );
+    #endif
+
     if( ret == 0 )
     {
         /* Retrieve key material into DTLS session. */
@@ -995,6 +1023,14 @@ static int32_t OnDtlsHandshakeComplete( PeerConnectionSession_t * pSession )
         }
     }
 
+    #if METRIC_PRINT_ENABLED
+    if( ret == 0 )
+    {
+        Metric_RecordHistogram( METRIC_HISTOGRAM_DTLS_SRTP_SETUP,
+                                NetworkingUtils_GetCurrentTimeUs( NULL ) - stepStartTimeUs );
+    }
+    #endif
+
     #if ENABLE_SCTP_DATA_CHANNEL
         if( ret == 0 )
         {
@@ -1018,6 +1054,8 @@ static int32_t OnDtlsHandshakeComplete( PeerConnectionSession_t * pSession )
 
     if( ret == 0 )
     {
+        /* Replay the cached keyframe before the first video frame of this viewer. */
+        __atomic_store_n( &pSession->isKeyFrameReplayPending, 1U, __ATOMIC_RELAXED );
         pSession->state = PEER_CONNECTION_SESSION_STATE_CONNECTION_READY;
         pSession->inactiveConnectionTimeoutMs = ( NetworkingUtils_GetCurrentTimeUs( NULL ) / 1000 ) + PEER_CONNECTION_INACTIVE_CONNECTION_TIMEOUT_MS;
         for( i = 0; i < pSession->transceiverCount; i++ )
@@ -1342,77 +1380,216 @@ static PeerConnectionResult_t PeerConnection_ResetTimer( PeerConnectionSession_t
     return ret;
 }
 
-static PeerConnectionResult_t AllocateTransceiver( PeerConnectionSession_t * pSession,
-                                                   Transceiver_t * pTransceiver )
+static void RequestVideoResync( PeerConnectionSession_t * pSession,
+                                const Transceiver_t * pTransceiver )
 {
-    PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
+    uint32_t requestCount;
 
-    if( pSession == NULL )
+    requestCount = __atomic_fetch_add( &pSession->videoResync.requestCount, 1U, __ATOMIC_ACQ_REL );
+
+    /* Only the first request of a resync asks for keyframe, the following ones wait for the same keyframe. */
+    if( requestCount == __atomic_load_n( &pSession->videoResync.servedCount, __ATOMIC_ACQUIRE ) )
     {
-        LogError( ( "Invalid input, pSession: %p", pSession ) );
-        ret = PEER_CONNECTION_RESULT_BAD_PARAMETER;
+        __atomic_add_fetch( &pSession->videoResync.resyncCount, 1U, __ATOMIC_RELAXED );
+        LogInfo( ( "Start video resync, drop frames until next keyframe, ssrc: %u", pTransceiver->ssrc ) );
+
+        if( pSession->onKeyFrameRequestCallback != NULL )
+        {
+            pSession->onKeyFrameRequestCallback( pSession->pKeyFrameRequestUserContext,
+                                                 pTransceiver->ssrc );
+        }
+    }
+}
+
+/* Decide whether the video frame is dropped to resync, called by the sending thread only. */
+static uint8_t ShouldDropVideoFrame( PeerConnectionSession_t * pSession,
+                                     PeerConnectionVideoFrameType_t frameType )
+{
+    uint8_t isDropped = 0U;
+    uint32_t requestCount;
+
+    requestCount = __atomic_load_n( &pSession->videoResync.requestCount, __ATOMIC_ACQUIRE );
+    if( requestCount == pSession->videoResync.servedCount )
+    {
+        /* Not resyncing. */
     }
+    else if( frameType == PEER_CONNECTION_VIDEO_FRAME_TYPE_KEY )
+    {
+        /* Requests arriving after the load above are served by the next keyframe. */
+        __atomic_store_n( &pSession->videoResync.servedCount, requestCount, __ATOMIC_RELEASE );
+        LogInfo( ( "Video resynced at keyframe, total dropped frames: %u", pSession->videoResync.framesDroppedToResync ) );
+    }
+    else
+    {
+        isDropped = 1U;
+        pSession->videoResync.framesDroppedToResync++;
+        LogVerbose( ( "Drop video frame to resync, frame type: %d", frameType ) );
+    }
+
+    return isDropped;
+}
+
+static PeerConnectionResult_t UpdateKeyFrameCache( const Transceiver_t * pTransceiver,
+                                                   const PeerConnectionFrame_t * pFrame,
+                                                   GetVideoFrameTypeFunc_t getVideoFrameTypeFunc,
+                                                   GetVideoParameterSetsFunc_t getVideoParameterSetsFunc )
+{
+    PeerConnectionResult_t ret;
+    PeerConnectionVideoFrameType_t frameType = PEER_CONNECTION_VIDEO_FRAME_TYPE_REFERENCE;
+    uint8_t parameterSets[ PEER_CONNECTION_KEYFRAME_CACHE_PARAMETER_SETS_MAX_LENGTH ];
+    size_t parameterSetsLength = sizeof( parameterSets );
+
+    ret = getVideoFrameTypeFunc( pFrame,
+                                 &frameType );
 
     if( ret == PEER_CONNECTION_RESULT_OK )
     {
-        if( pSession->transceiverCount < PEER_CONNECTION_TRANSCEIVER_MAX_COUNT )
+        ret = getVideoParameterSetsFunc( pFrame,
+                                         parameterSets,
+                                         &parameterSetsLength );
+    }
+
+    if( ( ret == PEER_CONNECTION_RESULT_OK ) &&
+        ( ( frameType == PEER_CONNECTION_VIDEO_FRAME_TYPE_KEY ) || ( parameterSetsLength > 0U ) ) )
+    {
+        ret = PeerConnectionKeyFrameCache_Update( &peerConnectionContext.keyFrameCache,
+                                                  pTransceiver,
+                                                  pFrame,
+                                                  ( frameType == PEER_CONNECTION_VIDEO_FRAME_TYPE_KEY ) ? 1U : 0U,
+                                                  parameterSets,
+                                                  parameterSetsLength );
+    }
+
+    return ret;
+}
+
+/* Give a new viewer a picture right away instead of waiting for the next keyframe from source.
+ * Return 1 if the cached keyframe is sent. */
+static uint8_t ReplayCachedKeyFrame( PeerConnectionSession_t * pSession,
+                                     Transceiver_t * pTransceiver,
+                                     WriteVideoFrameFunc_t writeVideoFrameFunc,
+                                     const PeerConnectionFrame_t * pFrame )
+{
+    PeerConnectionResult_t ret;
+    PeerConnectionCachedFrame_t * pKeyFrame = NULL;
+    PeerConnectionFrame_t keyFrame;
+    uint8_t isReplayed = 0U;
+
+    ret = PeerConnectionKeyFrameCache_Acquire( &pSession->pCtx->keyFrameCache,
+                                               pTransceiver,
+                                               pFrame->presentationUs,
+                                               &pKeyFrame );
+
+    if( ( ret == PEER_CONNECTION_RESULT_OK ) &&
+        ( pKeyFrame != NULL ) )
+    {
+        keyFrame.version = PEER_CONNECTION_FRAME_CURRENT_VERSION;
+        keyFrame.pData = pKeyFrame->data;
+        keyFrame.dataLength = pKeyFrame->dataLength;
+        keyFrame.presentationUs = pKeyFrame->presentationUs;
+
+        ret = writeVideoFrameFunc( pSession,
+                                   pTransceiver,
+                                   &keyFrame );
+        if( ret != PEER_CONNECTION_RESULT_OK )
         {
-            pTransceiver->ssrc = ( uint32_t ) rand();
-            pTransceiver->rtxSsrc = ( uint32_t ) rand();
-            pSession->pTransceivers[ pSession->transceiverCount ] = pTransceiver;
-            pSession->transceiverCount++;
+            LogWarn( ( "Fail to replay cached keyframe, result: %d", ret ) );
         }
         else
         {
-            LogWarn( ( "No space to add transceiver" ) );
-            ret = PEER_CONNECTION_RESULT_NO_FREE_TRANSCEIVER;
+            isReplayed = 1U;
+            LogInfo( ( "Replayed cached keyframe, size: %lu, age: %lu us",
+                       pKeyFrame->dataLength,
+                       pFrame->presentationUs - pKeyFrame->presentationUs ) );
         }
     }
 
-    return ret;
+    PeerConnectionKeyFrameCache_Release( pKeyFrame );
+
+    return isReplayed;
 }
 
-static PeerConnectionResult_t InitializeDtlsContext( PeerConnectionDtlsContext_t * pDtlsContext )
+static PeerConnectionResult_t WriteVideoFrame( PeerConnectionSession_t * pSession,
+                                               Transceiver_t * pTransceiver,
+                                               const PeerConnectionFrame_t * pFrame,
+                                               GetVideoFrameTypeFunc_t getVideoFrameTypeFunc,
+                                               WriteVideoFrameFunc_t writeVideoFrameFunc )
 {
-    PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
-    DtlsTransportStatus_t xNetworkStatus = DTLS_SUCCESS;
+    PeerConnectionResult_t ret;
+    PeerConnectionVideoFrameType_t frameType = PEER_CONNECTION_VIDEO_FRAME_TYPE_REFERENCE;
+    uint8_t isDropped = 0U;
 
-    if( pDtlsContext == NULL )
-    {
-        LogError( ( "Invalid input, pDtlsContext: %p", pDtlsContext ) );
-        ret = PEER_CONNECTION_RESULT_BAD_PARAMETER;
-    }
+    ret = getVideoFrameTypeFunc( pFrame,
+                                 &frameType );
 
-    /* Generate local cert in DER format. */
     if( ret == PEER_CONNECTION_RESULT_OK )
     {
-        xNetworkStatus = DTLS_CreateCertificateAndKey( GENERATED_CERTIFICATE_BITS,
-                                                       0,
-                                                       &pDtlsContext->localCert,
-                                                       &pDtlsContext->localKey );
-        if( xNetworkStatus != DTLS_SUCCESS )
+        if( frameType == PEER_CONNECTION_VIDEO_FRAME_TYPE_KEY )
+        {
+            __atomic_store_n( &pSession->isKeyFrameReplayPending, 0U, __ATOMIC_RELAXED );
+        }
+        else if( ( __atomic_exchange_n( &pSession->isKeyFrameReplayPending, 0U, __ATOMIC_RELAXED ) != 0U ) &&
+                 ( ReplayCachedKeyFrame( pSession,
+                                         pTransceiver,
+                                         writeVideoFrameFunc,
+                                         pFrame ) == 0U ) )
+        {
+            /* No fresh keyframe to start from, wait for the next one from source. */
+            RequestVideoResync( pSession,
+                                pTransceiver );
+        }
+        else
         {
-            LogError( ( "Fail to DTLS_CreateCertificateAndKey, return %d", xNetworkStatus ) );
-            ret = PEER_CONNECTION_RESULT_FAIL_CREATE_CERT_AND_KEY;
+            /* Empty else marker. */
         }
+
+        isDropped = ShouldDropVideoFrame( pSession,
+                                          frameType );
     }
 
-    // Generate cert fingerprint
-    if( ret == PEER_CONNECTION_RESULT_OK )
+    if( ( ret == PEER_CONNECTION_RESULT_OK ) && ( isDropped == 0U ) )
     {
-        xNetworkStatus = DTLS_CreateCertificateFingerprint( &pDtlsContext->localCert,
-                                                            pDtlsContext->localCertFingerprint,
-                                                            CERTIFICATE_FINGERPRINT_LENGTH );
-        if( xNetworkStatus != DTLS_SUCCESS )
+        ret = writeVideoFrameFunc( pSession,
+                                   pTransceiver,
+                                   pFrame );
+
+        /* A frame sent partially breaks every frame referencing it, unless no one references it. */
+        if( ( ret == PEER_CONNECTION_RESULT_FAIL_ICE_CONTROLLER_SEND_RTP_PACKET ) &&
+            ( frameType != PEER_CONNECTION_VIDEO_FRAME_TYPE_NON_REFERENCE ) )
         {
-            LogError( ( "Fail to dtlsCertificateFingerprint answer cert, return %d", xNetworkStatus ) );
-            ret = PEER_CONNECTION_RESULT_FAIL_CREATE_CERT_FINGERPRINT;
+            RequestVideoResync( pSession,
+                                pTransceiver );
         }
     }
 
+    return ret;
+}
+
+static PeerConnectionResult_t AllocateTransceiver( PeerConnectionSession_t * pSession,
+                                                   Transceiver_t * pTransceiver )
+{
+    PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
+
+    if( pSession == NULL )
+    {
+        LogError( ( "Invalid input, pSession: %p", pSession ) );
+        ret = PEER_CONNECTION_RESULT_BAD_PARAMETER;
+    }
+
     if( ret == PEER_CONNECTION_RESULT_OK )
     {
-        pDtlsContext->isInitialized = 1;
+        if( pSession->transceiverCount < PEER_CONNECTION_TRANSCEIVER_MAX_COUNT )
+        {
+            pTransceiver->ssrc = ( uint32_t ) rand();
+            pTransceiver->rtxSsrc = ( uint32_t ) rand();
+            pSession->pTransceivers[ pSession->transceiverCount ] = pTransceiver;
+            pSession->transceiverCount++;
+        }
+        else
+        {
+            LogWarn( ( "No space to add transceiver" ) );
+            ret = PEER_CONNECTION_RESULT_NO_FREE_TRANSCEIVER;
+        }
     }
 
     return ret;
@@ -1539,7 +1716,7 @@ PeerConnectionResult_t PeerConnection_Init( PeerConnectionSession_t * pSession,
                                  PEER_CONNECTION_CNAME_LENGTH );
         peerConnectionContext.localCname[ PEER_CONNECTION_CNAME_LENGTH ] = '\0';
 
-        /* Generate answer cert in DER format */
+        /* Generate DTLS cert in background, so the key generation is off the critical path of first viewer. */
         if( peerConnectionContext.dtlsContext.isInitialized == 0 )
         {
             /* Initialize DTLS session. */
@@ -1548,8 +1725,18 @@ PeerConnectionResult_t PeerConnection_Init( PeerConnectionSession_t * pSession,
                     0,
                     sizeof( DtlsSession_t ) );
 
-            /* pCtx->dtlsContext.isInitialized would be set to 1 in InitializeDtlsContext(). */
-            ret = InitializeDtlsContext( &peerConnectionContext.dtlsContext );
+            /* pCtx->dtlsContext.isInitialized would be set to 1 in PeerConnectionCertificate_Init(). */
+            ret = PeerConnectionCertificate_Init( &peerConnectionContext.dtlsContext );
+        }
+
+        if( ret == PEER_CONNECTION_RESULT_OK )
+        {
+            ret = PeerConnectionKeyFrameCache_Init( &peerConnectionContext.keyFrameCache );
+        }
+
+        if( ret == PEER_CONNECTION_RESULT_OK )
+        {
+            ret = PeerConnectionSdpTemplate_Init( &peerConnectionContext.sdpTemplateCache );
         }
     }
 
@@ -1559,6 +1746,16 @@ PeerConnectionResult_t PeerConnection_Init( PeerConnectionSession_t * pSession,
                 0,
                 sizeof( PeerConnectionSession_t ) );
 
+        if( pthread_mutex_init( &( pSession->remoteSdpMutex ),
+                                NULL ) != 0 )
+        {
+            LogError( ( "Fail to create mutex for remote SDP." ) );
+            ret = PEER_CONNECTION_RESULT_FAIL_CREATE_REMOTE_SDP_MUTEX;
+        }
+    }
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
         /* Initialize request queue. */
         ( void ) snprintf( tempName,
                            sizeof( tempName ),
@@ -1583,11 +1780,7 @@ PeerConnectionResult_t PeerConnection_Init( PeerConnectionSession_t * pSession,
 
     if( ret == PEER_CONNECTION_RESULT_OK )
     {
-        if( pthread_mutex_init( &( pSession->srtpSessionMutex ), NULL ) != 0 )
-        {
-            LogError( ( "Fail to create mutex of SRTP session." ) );
-            ret = PEER_CONNECTION_RESULT_FAIL_CREATE_SRTP_MUTEX;
-        }
+        ret = PeerConnectionSrtp_InitSessionLocks( pSession );
     }
 
     if( ret == PEER_CONNECTION_RESULT_OK )
@@ -1627,6 +1820,14 @@ PeerConnectionResult_t PeerConnection_Init( PeerConnectionSession_t * pSession,
                                        pSessionConfig );
     }
 
+    #if ENABLE_SCTP_DATA_CHANNEL
+        if( ret == PEER_CONNECTION_RESULT_OK )
+        {
+            ret = PeerConnectionSCTP_InitSession( pSession,
+                                                  initSeq );
+        }
+    #endif /* ENABLE_SCTP_DATA_CHANNEL */
+
     if( ret == PEER_CONNECTION_RESULT_OK )
     {
         ( void ) snprintf( tempName,
@@ -1737,6 +1938,29 @@ PeerConnectionResult_t PeerConnection_Start( PeerConnectionSession_t * pSession
         /* Clear all message queue because of new session is coming. */
         EmptyMessageQueue( &pSession->requestQueue );
         pSession->state = PEER_CONNECTION_SESSION_STATE_START;
+
+        /* New session starts with the default local credentials, ICE restart may replace them later. */
+        pSession->isIceRestarting = 0U;
+        memset( &pSession->videoResync,
+                0,
+                sizeof( PeerConnectionVideoResync_t ) );
+        pSession->isKeyFrameReplayPending = 0U;
+        memcpy( pSession->localUserName,
+                pSession->pCtx->localUserName,
+                sizeof( pSession->localUserName ) );
+        memcpy( pSession->localPassword,
+                pSession->pCtx->localPassword,
+                sizeof( pSession->localPassword ) );
+
+        /* Pin the DTLS certificate, rotation never changes it under a live session. */
+        if( pSession->pDtlsCertificate != NULL )
+        {
+            PeerConnectionCertificate_Release( &pSession->pCtx->dtlsContext,
+                                               pSession->pDtlsCertificate );
+            pSession->pDtlsCertificate = NULL;
+        }
+        ret = PeerConnectionCertificate_Acquire( &pSession->pCtx->dtlsContext,
+                                                 &pSession->pDtlsCertificate );
     }
 
     return ret;
@@ -1771,9 +1995,12 @@ PeerConnectionResult_t PeerConnection_SetRemoteDescription( PeerConnectionSessio
     RtpResult_t resultRtp;
     RtcpResult_t resultRtcp;
     PeerConnectionBufferSessionDescription_t * pTargetRemoteSdp = NULL;
+    char * pNewRemoteSdpBuffer = NULL;
+    size_t newRemoteSdpBufferSize;
     uint8_t i;
     uint64_t signalStartUpBarrier = 1;
     ssize_t retWrite;
+    uint8_t isIceRestart = 0U;
 
     if( ( pSession == NULL ) ||
         ( pBufferSessionDescription == NULL ) )
@@ -1782,7 +2009,7 @@ PeerConnectionResult_t PeerConnection_SetRemoteDescription( PeerConnectionSessio
         ret = PEER_CONNECTION_RESULT_BAD_PARAMETER;
     }
     else if( ( pBufferSessionDescription->pSdpBuffer == NULL ) ||
-             ( pBufferSessionDescription->sdpBufferLength > PEER_CONNECTION_SDP_DESCRIPTION_BUFFER_MAX_LENGTH ) )
+             ( pBufferSessionDescription->sdpBufferLength == 0U ) )
     {
         LogError( ( "Invalid input, pBufferSessionDescription->pSdpBuffer: %p, pBufferSessionDescription->sdpBufferLength: %lu",
                     pBufferSessionDescription->pSdpBuffer, pBufferSessionDescription->sdpBufferLength ) );
@@ -1800,14 +2027,33 @@ PeerConnectionResult_t PeerConnection_SetRemoteDescription( PeerConnectionSessio
         }
     #endif /* ENABLE_SCTP_DATA_CHANNEL */
 
+    /* The current description points into pRemoteSdpBuffer, so the new SDP is
+     * parsed into the pending buffer, which nothing else points into. */
+    if( ( ret == PEER_CONNECTION_RESULT_OK ) &&
+        ( pBufferSessionDescription->sdpBufferLength > pSession->pendingRemoteSdpBufferSize ) )
+    {
+        pNewRemoteSdpBuffer = ( char * ) realloc( pSession->pPendingRemoteSdpBuffer,
+                                                  pBufferSessionDescription->sdpBufferLength );
+        if( pNewRemoteSdpBuffer == NULL )
+        {
+            LogError( ( "Fail to allocate %lu bytes for remote SDP", pBufferSessionDescription->sdpBufferLength ) );
+            ret = PEER_CONNECTION_RESULT_FAIL_REMOTE_SDP_NO_ENOUGH_MEMORY;
+        }
+        else
+        {
+            pSession->pPendingRemoteSdpBuffer = pNewRemoteSdpBuffer;
+            pSession->pendingRemoteSdpBufferSize = pBufferSessionDescription->sdpBufferLength;
+        }
+    }
+
     /* Use SDP controller to parse SDP message into data structure. */
     if( ret == PEER_CONNECTION_RESULT_OK )
     {
-        pTargetRemoteSdp = &pSession->remoteSessionDescription;
+        pTargetRemoteSdp = &pSession->pendingRemoteSessionDescription;
         memset( pTargetRemoteSdp,
                 0,
                 sizeof( PeerConnectionBufferSessionDescription_t ) );
-        pTargetRemoteSdp->pSdpBuffer = pSession->remoteSdpBuffer;
+        pTargetRemoteSdp->pSdpBuffer = pSession->pPendingRemoteSdpBuffer;
         pTargetRemoteSdp->sdpBufferLength = pBufferSessionDescription->sdpBufferLength;
         pTargetRemoteSdp->type = pBufferSessionDescription->type;
         memcpy( pTargetRemoteSdp->pSdpBuffer,
@@ -1845,6 +2091,63 @@ PeerConnectionResult_t PeerConnection_SetRemoteDescription( PeerConnectionSessio
         }
     }
 
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        /* The new description is valid, swap it in. The previous buffer
+         * becomes the pending one for the next remote SDP. */
+        if( pthread_mutex_lock( &( pSession->remoteSdpMutex ) ) == 0 )
+        {
+            pNewRemoteSdpBuffer = pSession->pRemoteSdpBuffer;
+            newRemoteSdpBufferSize = pSession->remoteSdpBufferSize;
+
+            pSession->pRemoteSdpBuffer = pSession->pPendingRemoteSdpBuffer;
+            pSession->remoteSdpBufferSize = pSession->pendingRemoteSdpBufferSize;
+            memcpy( &( pSession->remoteSessionDescription ),
+                    pTargetRemoteSdp,
+                    sizeof( PeerConnectionBufferSessionDescription_t ) );
+
+            pSession->pPendingRemoteSdpBuffer = pNewRemoteSdpBuffer;
+            pSession->pendingRemoteSdpBufferSize = newRemoteSdpBufferSize;
+            memset( pTargetRemoteSdp,
+                    0,
+                    sizeof( PeerConnectionBufferSessionDescription_t ) );
+
+            pthread_mutex_unlock( &( pSession->remoteSdpMutex ) );
+
+            pTargetRemoteSdp = &pSession->remoteSessionDescription;
+        }
+        else
+        {
+            LogError( ( "Fail to take remote SDP mutex" ) );
+            ret = PEER_CONNECTION_RESULT_FAIL_TAKE_REMOTE_SDP_MUTEX;
+        }
+    }
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        /* A re-offer carrying a new ufrag on an established session means the remote peer restarts ICE.
+         * Re-gather candidates with new local credentials but keep the DTLS/SRTP sessions. */
+        if( ( pSession->state == PEER_CONNECTION_SESSION_STATE_CONNECTION_READY ) &&
+            ( ( strlen( pSession->remoteUserName ) != pTargetRemoteSdp->sdpDescription.quickAccess.iceUfragLength ) ||
+              ( strncmp( pSession->remoteUserName,
+                         pTargetRemoteSdp->sdpDescription.quickAccess.pIceUfrag,
+                         pTargetRemoteSdp->sdpDescription.quickAccess.iceUfragLength ) != 0 ) ) )
+        {
+            LogInfo( ( "Remote ufrag changed from %s to %.*s, restarting ICE.",
+                       pSession->remoteUserName,
+                       ( int ) pTargetRemoteSdp->sdpDescription.quickAccess.iceUfragLength,
+                       pTargetRemoteSdp->sdpDescription.quickAccess.pIceUfrag ) );
+            isIceRestart = 1U;
+
+            generateJSONValidString( pSession->localUserName,
+                                     PEER_CONNECTION_USER_NAME_LENGTH );
+            pSession->localUserName[ PEER_CONNECTION_USER_NAME_LENGTH ] = '\0';
+            generateJSONValidString( pSession->localPassword,
+                                     PEER_CONNECTION_PASSWORD_LENGTH );
+            pSession->localPassword[ PEER_CONNECTION_PASSWORD_LENGTH ] = '\0';
+        }
+    }
+
     if( ret == PEER_CONNECTION_RESULT_OK )
     {
         memcpy( pSession->remoteUserName,
@@ -1861,32 +2164,57 @@ PeerConnectionResult_t PeerConnection_SetRemoteDescription( PeerConnectionSessio
                   ( int ) pTargetRemoteSdp->sdpDescription.quickAccess.iceUfragLength,
                   pSession->remoteUserName,
                   PEER_CONNECTION_USER_NAME_LENGTH,
-                  peerConnectionContext.localUserName );
+                  pSession->localUserName );
         memcpy( pSession->remoteCertFingerprint,
                 pTargetRemoteSdp->sdpDescription.quickAccess.pFingerprint,
                 pTargetRemoteSdp->sdpDescription.quickAccess.fingerprintLength );
         pSession->remoteCertFingerprint[ pTargetRemoteSdp->sdpDescription.quickAccess.fingerprintLength ] = '\0';
         pSession->remoteCertFingerprintLength = pTargetRemoteSdp->sdpDescription.quickAccess.fingerprintLength;
 
-        iceControllerResult = IceController_Start( &pSession->iceControllerContext,
-                                                   peerConnectionContext.localUserName,
-                                                   PEER_CONNECTION_USER_NAME_LENGTH,
-                                                   peerConnectionContext.localPassword,
-                                                   PEER_CONNECTION_PASSWORD_LENGTH,
-                                                   pSession->remoteUserName,
-                                                   pTargetRemoteSdp->sdpDescription.quickAccess.iceUfragLength,
-                                                   pSession->remotePassword,
-                                                   pTargetRemoteSdp->sdpDescription.quickAccess.icePwdLength,
-                                                   pSession->combinedName,
-                                                   strlen( pSession->combinedName ) );
+        if( isIceRestart != 0U )
+        {
+            /* Mark the restart before the ICE controller touches the sockets. The session stays ready,
+             * media keeps flowing on the previous path until the restarted check list nominates a new pair.
+             * RTP/RTCP contexts and sequence numbers continue, and the session task is already running. */
+            pSession->isIceRestarting = 1U;
+
+            iceControllerResult = IceController_Restart( &pSession->iceControllerContext,
+                                                         pSession->localUserName,
+                                                         PEER_CONNECTION_USER_NAME_LENGTH,
+                                                         pSession->localPassword,
+                                                         PEER_CONNECTION_PASSWORD_LENGTH,
+                                                         pSession->remoteUserName,
+                                                         pTargetRemoteSdp->sdpDescription.quickAccess.iceUfragLength,
+                                                         pSession->remotePassword,
+                                                         pTargetRemoteSdp->sdpDescription.quickAccess.icePwdLength,
+                                                         pSession->combinedName,
+                                                         strlen( pSession->combinedName ) );
+        }
+        else
+        {
+            iceControllerResult = IceController_Start( &pSession->iceControllerContext,
+                                                       pSession->localUserName,
+                                                       PEER_CONNECTION_USER_NAME_LENGTH,
+                                                       pSession->localPassword,
+                                                       PEER_CONNECTION_PASSWORD_LENGTH,
+                                                       pSession->remoteUserName,
+                                                       pTargetRemoteSdp->sdpDescription.quickAccess.iceUfragLength,
+                                                       pSession->remotePassword,
+                                                       pTargetRemoteSdp->sdpDescription.quickAccess.icePwdLength,
+                                                       pSession->combinedName,
+                                                       strlen( pSession->combinedName ) );
+        }
+
         if( iceControllerResult != ICE_CONTROLLER_RESULT_OK )
         {
             LogWarn( ( "IceController_Start fail, result: %d.", iceControllerResult ) );
+            pSession->isIceRestarting = 0U;
             ret = PEER_CONNECTION_RESULT_FAIL_ICE_CONTROLLER_START;
         }
     }
 
-    if( ret == PEER_CONNECTION_RESULT_OK )
+    if( ( ret == PEER_CONNECTION_RESULT_OK ) &&
+        ( isIceRestart == 0U ) )
     {
         resultRtp = Rtp_Init( &peerConnectionContext.rtpContext );
         if( resultRtp != RTP_RESULT_OK )
@@ -1896,7 +2224,8 @@ PeerConnectionResult_t PeerConnection_SetRemoteDescription( PeerConnectionSessio
         }
     }
 
-    if( ret == PEER_CONNECTION_RESULT_OK )
+    if( ( ret == PEER_CONNECTION_RESULT_OK ) &&
+        ( isIceRestart == 0U ) )
     {
         resultRtcp = Rtcp_Init( &peerConnectionContext.rtcpContext );
         if( resultRtcp != RTCP_RESULT_OK )
@@ -1906,7 +2235,8 @@ PeerConnectionResult_t PeerConnection_SetRemoteDescription( PeerConnectionSessio
         }
     }
 
-    if( ret == PEER_CONNECTION_RESULT_OK )
+    if( ( ret == PEER_CONNECTION_RESULT_OK ) &&
+        ( isIceRestart == 0U ) )
     {
         pSession->rtpConfig.videoRtxSequenceNumber = 0U;
         pSession->rtpConfig.audioRtxSequenceNumber = 0U;
@@ -1915,7 +2245,8 @@ PeerConnectionResult_t PeerConnection_SetRemoteDescription( PeerConnectionSessio
         pSession->rtpConfig.remoteAudioSsrc = pTargetRemoteSdp->sdpDescription.quickAccess.audioSsrc;
     }
 
-    if( ret == PEER_CONNECTION_RESULT_OK )
+    if( ( ret == PEER_CONNECTION_RESULT_OK ) &&
+        ( isIceRestart == 0U ) )
     {
         pSession->state = PEER_CONNECTION_SESSION_STATE_FIND_CONNECTION;
 
@@ -2121,13 +2452,15 @@ PeerConnectionResult_t PeerConnection_CloseSession( PeerConnectionSession_t * pS
     /* Update session state and notify transceivers. */
     if( ret == PEER_CONNECTION_RESULT_OK )
     {
-        if( pSession->state == PEER_CONNECTION_SESSION_STATE_CONNECTION_READY )
+        if( ( pSession->state == PEER_CONNECTION_SESSION_STATE_CONNECTION_READY ) ||
+            ( pSession->isIceRestarting != 0U ) )
         {
             /* We only notify traceiver when start is triggered. */
             notifyTransceiver = 1U;
         }
 
         pSession->state = PEER_CONNECTION_SESSION_STATE_CLOSING;
+        pSession->isIceRestarting = 0U;
 
         if( notifyTransceiver != 0U )
         {
@@ -2181,6 +2514,54 @@ PeerConnectionResult_t PeerConnection_CloseSession( PeerConnectionSession_t * pS
         }
     }
 
+    if( ( ret == PEER_CONNECTION_RESULT_OK ) &&
+        ( pSession->pDtlsCertificate != NULL ) )
+    {
+        PeerConnectionCertificate_Release( &pSession->pCtx->dtlsContext,
+                                           pSession->pDtlsCertificate );
+        pSession->pDtlsCertificate = NULL;
+    }
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        if( pthread_mutex_lock( &( pSession->remoteSdpMutex ) ) == 0 )
+        {
+            memset( &( pSession->remoteSessionDescription ),
+                    0,
+                    sizeof( PeerConnectionBufferSessionDescription_t ) );
+            free( pSession->pRemoteSdpBuffer );
+            pSession->pRemoteSdpBuffer = NULL;
+            pSession->remoteSdpBufferSize = 0;
+
+            memset( &( pSession->pendingRemoteSessionDescription ),
+                    0,
+                    sizeof( PeerConnectionBufferSessionDescription_t ) );
+            free( pSession->pPendingRemoteSdpBuffer );
+            pSession->pPendingRemoteSdpBuffer = NULL;
+            pSession->pendingRemoteSdpBufferSize = 0;
+
+            pthread_mutex_unlock( &( pSession->remoteSdpMutex ) );
+        }
+        else
+        {
+            LogError( ( "Fail to take remote SDP mutex" ) );
+            ret = PEER_CONNECTION_RESULT_FAIL_TAKE_REMOTE_SDP_MUTEX;
+        }
+    }
+
+    if( ( ret == PEER_CONNECTION_RESULT_OK ) &&
+        ( pSession->videoResync.resyncCount > 0U ) )
+    {
+        LogInfo( ( "Video resynced %u times, dropped %u frames to resync",
+                   pSession->videoResync.resyncCount,
+                   pSession->videoResync.framesDroppedToResync ) );
+    }
+
+    #if METRIC_PRINT_ENABLED
+    Metric_RecordHistogram( METRIC_HISTOGRAM_VIDEO_RESYNC_DROPPED_FRAMES,
+                            pSession->videoResync.framesDroppedToResync );
+    #endif
+
     if( ret == PEER_CONNECTION_RESULT_OK )
     {
         /* Reset metrics. */
@@ -2226,9 +2607,11 @@ PeerConnectionResult_t PeerConnection_WriteFrame( PeerConnectionSession_t * pSes
         else if( TRANSCEIVER_IS_CODEC_ENABLED( pTransceiver->codecBitMap,
                                                TRANSCEIVER_RTC_CODEC_H264_PROFILE_42E01F_LEVEL_ASYMMETRY_ALLOWED_PACKETIZATION_BIT ) )
         {
-            ret = PeerConnectionSrtp_WriteH264Frame( pSession,
-                                                     pTransceiver,
-                                                     pFrame );
+            ret = WriteVideoFrame( pSession,
+                                   pTransceiver,
+                                   pFrame,
+                                   GetH264FrameType,
+                                   PeerConnectionSrtp_WriteH264Frame );
         }
         else if( TRANSCEIVER_IS_CODEC_ENABLED( pTransceiver->codecBitMap,
                                                TRANSCEIVER_RTC_CODEC_OPUS_BIT ) )
@@ -2259,9 +2642,11 @@ PeerConnectionResult_t PeerConnection_WriteFrame( PeerConnectionSession_t * pSes
         else if( TRANSCEIVER_IS_CODEC_ENABLED( pTransceiver->codecBitMap,
                                                TRANSCEIVER_RTC_CODEC_H265_BIT ) )
         {
-            ret = PeerConnectionSrtp_WriteH265Frame( pSession,
-                                                     pTransceiver,
-                                                     pFrame );
+            ret = WriteVideoFrame( pSession,
+                                   pTransceiver,
+                                   pFrame,
+                                   GetH265FrameType,
+                                   PeerConnectionSrtp_WriteH265Frame );
         }
         else
         {
@@ -2347,11 +2732,21 @@ PeerConnectionResult_t PeerConnection_CreateAnswer( PeerConnectionSession_t * pS
 
     if( ret == PEER_CONNECTION_RESULT_OK )
     {
-        ret = PeerConnectionSdp_PopulateSessionDescription( pSession,
-                                                            &pSession->remoteSessionDescription,
-                                                            pOutputBufferSessionDescription,
-                                                            pOutputSerializedSdpMessage,
-                                                            pOutputSerializedSdpMessageLength );
+        /* The answer is built from the remote description, keep it from being swapped. */
+        if( pthread_mutex_lock( &( pSession->remoteSdpMutex ) ) == 0 )
+        {
+            ret = PeerConnectionSdp_PopulateSessionDescription( pSession,
+                                                                &pSession->remoteSessionDescription,
+                                                                pOutputBufferSessionDescription,
+                                                                pOutputSerializedSdpMessage,
+                                                                pOutputSerializedSdpMessageLength );
+            pthread_mutex_unlock( &( pSession->remoteSdpMutex ) );
+        }
+        else
+        {
+            LogError( ( "Fail to take remote SDP mutex" ) );
+            ret = PEER_CONNECTION_RESULT_FAIL_TAKE_REMOTE_SDP_MUTEX;
+        }
     }
 
     return ret;
@@ -2438,7 +2833,7 @@ static PeerConnectionResult_t PeerConnection_OnRtcpSenderReportCallback( PeerCon
         ret = PEER_CONNECTION_RESULT_BAD_PARAMETER;
     }
 
-    if( ( ret == PEER_CONNECTION_RESULT_OK ) && ( pSession->srtpTransmitSession != NULL ) && ( currentTimeUs - pTransceiver->rtpSender.rtpFirstFrameWallClockTimeUs >= 2500 * 1000 ) )
+    if( ( ret == PEER_CONNECTION_RESULT_OK ) && ( pSession->srtpSessions[ PEER_CONNECTION_SRTP_PATH_RTCP_TX ].session != NULL ) && ( currentTimeUs - pTransceiver->rtpSender.rtpFirstFrameWallClockTimeUs >= 2500 * 1000 ) )
     {
         readyToSend = 1;
     }
@@ -2519,6 +2914,104 @@ PeerConnectionResult_t PeerConnection_SetPictureLossIndicationCallback( PeerConn
     return ret;
 }
 
+PeerConnectionResult_t PeerConnection_SetKeyFrameRequestCallback( PeerConnectionSession_t * pSession,
+                                                                  OnKeyFrameRequestCallback_t onKeyFrameRequestCallback,
+                                                                  void * pUserContext )
+{
+    PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
+
+    if( ( pSession == NULL ) || ( onKeyFrameRequestCallback == NULL ) )
+    {
+        LogError( ( "Invalid input, pSession: %p, onKeyFrameRequestCallback: %p", pSession, onKeyFrameRequestCallback ) );
+        ret = PEER_CONNECTION_RESULT_BAD_PARAMETER;
+    }
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        pSession->onKeyFrameRequestCallback = onKeyFrameRequestCallback;
+        pSession->pKeyFrameRequestUserContext = pUserContext;
+    }
+
+    return ret;
+}
+
+PeerConnectionResult_t PeerConnection_RequestVideoResync( PeerConnectionSession_t * pSession,
+                                                          const Transceiver_t * pTransceiver )
+{
+    PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
+
+    if( ( pSession == NULL ) || ( pTransceiver == NULL ) )
+    {
+        LogError( ( "Invalid input, pSession: %p, pTransceiver: %p", pSession, pTransceiver ) );
+        ret = PEER_CONNECTION_RESULT_BAD_PARAMETER;
+    }
+    else if( pTransceiver->trackKind != TRANSCEIVER_TRACK_KIND_VIDEO )
+    {
+        LogError( ( "Invalid track kind: %d", pTransceiver->trackKind ) );
+        ret = PEER_CONNECTION_RESULT_BAD_PARAMETER;
+    }
+    else
+    {
+        /* Empty else marker. */
+    }
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        RequestVideoResync( pSession,
+                            pTransceiver );
+    }
+
+    return ret;
+}
+
+PeerConnectionResult_t PeerConnection_UpdateKeyFrameCache( const Transceiver_t * pTransceiver,
+                                                           const PeerConnectionFrame_t * pFrame )
+{
+    PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
+
+    if( ( pTransceiver == NULL ) || ( pFrame == NULL ) )
+    {
+        LogError( ( "Invalid input, pTransceiver: %p, pFrame: %p", pTransceiver, pFrame ) );
+        ret = PEER_CONNECTION_RESULT_BAD_PARAMETER;
+    }
+    else if( pTransceiver->trackKind != TRANSCEIVER_TRACK_KIND_VIDEO )
+    {
+        LogError( ( "Invalid track kind: %d", pTransceiver->trackKind ) );
+        ret = PEER_CONNECTION_RESULT_BAD_PARAMETER;
+    }
+    else
+    {
+        /* Empty else marker. */
+    }
+
+    /* Pick the codec in the same order as PeerConnection_WriteFrame. */
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        if( TRANSCEIVER_IS_CODEC_ENABLED( pTransceiver->codecBitMap,
+                                          TRANSCEIVER_RTC_CODEC_H264_PROFILE_42E01F_LEVEL_ASYMMETRY_ALLOWED_PACKETIZATION_BIT ) )
+        {
+            ret = UpdateKeyFrameCache( pTransceiver,
+                                       pFrame,
+                                       GetH264FrameType,
+                                       GetH264ParameterSets );
+        }
+        else if( TRANSCEIVER_IS_CODEC_ENABLED( pTransceiver->codecBitMap,
+                                               TRANSCEIVER_RTC_CODEC_H265_BIT ) )
+        {
+            ret = UpdateKeyFrameCache( pTransceiver,
+                                       pFrame,
+                                       GetH265FrameType,
+                                       GetH265ParameterSets );
+        }
+        else
+        {
+            /* Only H.264 and H.265 keyframes are replayed. */
+        }
+    }
+
+    return ret;
+}
+
 #if ENABLE_TWCC_SUPPORT
     PeerConnectionResult_t PeerConnection_SetSenderBandwidthEstimationCallback( PeerConnectionSession_t * pSession,
                                                                                 OnBandwidthEstimationCallback_t onBandwidthEstimationCallback,
@@ -68,6 +68,7 @@ extern "C" {
     PeerConnectionResult_t PeerConnection_WriteFrame( PeerConnectionSession_t * pSession,
                                                       Transceiver_t * pTransceiver,
                                                       const PeerConnectionFrame_t * pFrame );
+    /* Returns PEER_CONNECTION_RESULT_FAIL_SDP_BUFFER_TOO_SMALL if the answer doesn't fit, retry with larger buffers. */
     PeerConnectionResult_t PeerConnection_CreateAnswer( PeerConnectionSession_t * pSession,
                                                         PeerConnectionBufferSessionDescription_t * pOutputBufferSessionDescription,
                                                         char * pOutputSerializedSdpMessage,
@@ -84,6 +85,16 @@ extern "C" {
     PeerConnectionResult_t PeerConnection_SetPictureLossIndicationCallback( PeerConnectionSession_t * pSession,
                                                                             OnPictureLossIndicationCallback_t onPictureLossIndicationCallback,
                                                                             void * pUserContext );
+    PeerConnectionResult_t PeerConnection_SetKeyFrameRequestCallback( PeerConnectionSession_t * pSession,
+                                                                      OnKeyFrameRequestCallback_t onKeyFrameRequestCallback,
+                                                                      void * pUserContext );
+    /* Drop video frames until the next keyframe, call it when frames are lost before reaching the session. */
+    PeerConnectionResult_t PeerConnection_RequestVideoResync( PeerConnectionSession_t * pSession,
+                                                              const Transceiver_t * pTransceiver );
+    /* Keep the latest keyframe and parameter sets of a video track for new viewers, call it once per source frame
+     * before the frame is written to the sessions. Sessions match the cache by track ID. */
+    PeerConnectionResult_t PeerConnection_UpdateKeyFrameCache( const Transceiver_t * pTransceiver,
+                                                               const PeerConnectionFrame_t * pFrame );
 
 #ifdef __cplusplus
 }
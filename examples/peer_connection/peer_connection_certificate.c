@@ -0,0 +1,553 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "logging.h"
+#include "peer_connection_certificate.h"
+
+/*-----------------------------------------------------------*/
+
+#if defined( DTLS_CERTIFICATE_PERSIST_CERT_PATH ) && defined( DTLS_CERTIFICATE_PERSIST_KEY_PATH )
+#define PEER_CONNECTION_DTLS_CERTIFICATE_PERSIST_ENABLED ( 1 )
+#else
+#define PEER_CONNECTION_DTLS_CERTIFICATE_PERSIST_ENABLED ( 0 )
+#endif
+
+static uint64_t GetWallClockTimeSec( void )
+{
+    struct timespec nowTime;
+
+    clock_gettime( CLOCK_REALTIME,
+                   &nowTime );
+
+    return ( uint64_t ) nowTime.tv_sec;
+}
+
+static uint64_t GetMonotonicTimeSec( void )
+{
+    struct timespec nowTime;
+
+    clock_gettime( CLOCK_MONOTONIC,
+                   &nowTime );
+
+    return ( uint64_t ) nowTime.tv_sec;
+}
+
+static void FreeCertificate( PeerConnectionDtlsCertificate_t * pCertificate )
+{
+    DTLS_FreeSharedConfig( &pCertificate->sharedConfig );
+    ( void ) DTLS_FreeCertificateAndKey( &pCertificate->localCert,
+                                         &pCertificate->localKey );
+    pCertificate->isValid = 0U;
+    pCertificate->refCount = 0U;
+    pCertificate->rotateTimeSec = 0U;
+}
+
+/* Calculate fingerprint and rotation time for a certificate just loaded or generated. */
+static PeerConnectionResult_t PrepareCertificate( PeerConnectionDtlsCertificate_t * pCertificate )
+{
+    PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
+    int32_t dtlsStatus;
+    uint64_t notBeforeSec = 0U;
+    uint64_t notAfterSec = 0U;
+    uint64_t rotateWallTimeSec;
+    uint64_t nowWallTimeSec;
+
+    dtlsStatus = DTLS_CreateCertificateFingerprint( &pCertificate->localCert,
+                                                    pCertificate->localCertFingerprint,
+                                                    CERTIFICATE_FINGERPRINT_LENGTH );
+    if( dtlsStatus != DTLS_SUCCESS )
+    {
+        LogError( ( "Fail to DTLS_CreateCertificateFingerprint, return %d", dtlsStatus ) );
+        ret = PEER_CONNECTION_RESULT_FAIL_CREATE_CERT_FINGERPRINT;
+    }
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        dtlsStatus = DTLS_GetCertificateValidity( &pCertificate->localCert,
+                                                  &notBeforeSec,
+                                                  &notAfterSec );
+        if( ( dtlsStatus != DTLS_SUCCESS ) ||
+            ( notAfterSec <= notBeforeSec + PEER_CONNECTION_DTLS_CERTIFICATE_ROTATE_MARGIN_SEC ) )
+        {
+            LogError( ( "Invalid certificate validity, return %d, notBefore: %lu, notAfter: %lu", dtlsStatus, notBeforeSec, notAfterSec ) );
+            ret = PEER_CONNECTION_RESULT_FAIL_CREATE_CERT_AND_KEY;
+        }
+    }
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        /* Validity is in wall clock time, convert the rotation deadline to the monotonic clock
+         * so wall clock steps don't rotate too early or never. */
+        rotateWallTimeSec = notBeforeSec + PEER_CONNECTION_DTLS_CERTIFICATE_LIFETIME_SEC;
+        if( rotateWallTimeSec > notAfterSec - PEER_CONNECTION_DTLS_CERTIFICATE_ROTATE_MARGIN_SEC )
+        {
+            rotateWallTimeSec = notAfterSec - PEER_CONNECTION_DTLS_CERTIFICATE_ROTATE_MARGIN_SEC;
+        }
+
+        nowWallTimeSec = GetWallClockTimeSec();
+        pCertificate->rotateTimeSec = GetMonotonicTimeSec();
+        if( rotateWallTimeSec > nowWallTimeSec )
+        {
+            pCertificate->rotateTimeSec += rotateWallTimeSec - nowWallTimeSec;
+        }
+    }
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        /* Build the SSL configuration once here, so DTLS sessions only set up their own SSL context. */
+        dtlsStatus = DTLS_InitSharedConfig( &pCertificate->sharedConfig,
+                                            &pCertificate->localCert,
+                                            &pCertificate->localKey,
+                                            0U );
+        if( dtlsStatus != DTLS_SUCCESS )
+        {
+            LogError( ( "Fail to DTLS_InitSharedConfig, return %d", dtlsStatus ) );
+            ret = PEER_CONNECTION_RESULT_FAIL_CREATE_CERT_AND_KEY;
+        }
+    }
+
+    return ret;
+}
+
+#if PEER_CONNECTION_DTLS_CERTIFICATE_PERSIST_ENABLED
+static PeerConnectionResult_t LoadCertificate( PeerConnectionDtlsCertificate_t * pCertificate )
+{
+    PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
+    int32_t dtlsStatus;
+
+    dtlsStatus = DTLS_ReadCertificateAndKey( DTLS_CERTIFICATE_PERSIST_CERT_PATH,
+                                             DTLS_CERTIFICATE_PERSIST_KEY_PATH,
+                                             &pCertificate->localCert,
+                                             &pCertificate->localKey );
+    if( dtlsStatus != DTLS_SUCCESS )
+    {
+        ret = PEER_CONNECTION_RESULT_FAIL_CREATE_CERT_AND_KEY;
+    }
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        ret = PrepareCertificate( pCertificate );
+        if( ret != PEER_CONNECTION_RESULT_OK )
+        {
+            FreeCertificate( pCertificate );
+        }
+    }
+
+    if( ( ret == PEER_CONNECTION_RESULT_OK ) &&
+        ( GetMonotonicTimeSec() >= pCertificate->rotateTimeSec ) )
+    {
+        LogInfo( ( "Persisted DTLS certificate is due for rotation, generating a new one." ) );
+        FreeCertificate( pCertificate );
+        ret = PEER_CONNECTION_RESULT_FAIL_CREATE_CERT_AND_KEY;
+    }
+
+    return ret;
+}
+
+static void SaveCertificate( PeerConnectionDtlsCertificate_t * pCertificate )
+{
+    int32_t dtlsStatus;
+
+    dtlsStatus = DTLS_WriteCertificateAndKey( &pCertificate->localCert,
+                                              &pCertificate->localKey,
+                                              DTLS_CERTIFICATE_PERSIST_CERT_PATH,
+                                              DTLS_CERTIFICATE_PERSIST_KEY_PATH );
+    if( dtlsStatus != DTLS_SUCCESS )
+    {
+        LogWarn( ( "Fail to persist DTLS certificate, return %d", dtlsStatus ) );
+    }
+}
+#endif /* #if PEER_CONNECTION_DTLS_CERTIFICATE_PERSIST_ENABLED */
+
+static PeerConnectionResult_t GenerateCertificate( PeerConnectionDtlsCertificate_t * pCertificate )
+{
+    PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
+    int32_t dtlsStatus;
+
+    /* ECDSA P-256, generateRSACertificate = 0. */
+    dtlsStatus = DTLS_CreateCertificateAndKey( GENERATED_CERTIFICATE_BITS,
+                                               0,
+                                               &pCertificate->localCert,
+                                               &pCertificate->localKey );
+    if( dtlsStatus != DTLS_SUCCESS )
+    {
+        LogError( ( "Fail to DTLS_CreateCertificateAndKey, return %d", dtlsStatus ) );
+        ret = PEER_CONNECTION_RESULT_FAIL_CREATE_CERT_AND_KEY;
+    }
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        ret = PrepareCertificate( pCertificate );
+        if( ret != PEER_CONNECTION_RESULT_OK )
+        {
+            FreeCertificate( pCertificate );
+        }
+    }
+
+    return ret;
+}
+
+static void ActivateCertificate( PeerConnectionDtlsContext_t * pDtlsContext,
+                                 PeerConnectionDtlsCertificate_t * pCertificate )
+{
+    PeerConnectionDtlsCertificate_t * pPrevious = NULL;
+
+    if( pthread_mutex_lock( &( pDtlsContext->certificateMutex ) ) == 0 )
+    {
+        pCertificate->refCount = 0U;
+        pCertificate->isValid = 1U;
+        pPrevious = pDtlsContext->pActiveCertificate;
+        pDtlsContext->pActiveCertificate = pCertificate;
+
+        /* Sessions using the previous certificate keep it until they release it. */
+        if( ( pPrevious != NULL ) && ( pPrevious->refCount == 0U ) )
+        {
+            FreeCertificate( pPrevious );
+        }
+
+        pthread_cond_broadcast( &( pDtlsContext->certificateReadyCond ) );
+        pthread_mutex_unlock( &( pDtlsContext->certificateMutex ) );
+
+        LogInfo( ( "DTLS certificate activated, fingerprint: %.*s",
+                   CERTIFICATE_FINGERPRINT_LENGTH,
+                   pCertificate->localCertFingerprint ) );
+    }
+    else
+    {
+        LogError( ( "Fail to activate DTLS certificate: mutex lock acquisition." ) );
+        FreeCertificate( pCertificate );
+    }
+}
+
+static PeerConnectionDtlsCertificate_t * GetCertificateToRotate( PeerConnectionDtlsContext_t * pDtlsContext )
+{
+    PeerConnectionDtlsCertificate_t * pFreeSlot = NULL;
+    uint8_t needRotate = 0U;
+    int i;
+
+    if( pthread_mutex_lock( &( pDtlsContext->certificateMutex ) ) == 0 )
+    {
+        if( ( pDtlsContext->pActiveCertificate == NULL ) ||
+            ( GetMonotonicTimeSec() >= pDtlsContext->pActiveCertificate->rotateTimeSec ) )
+        {
+            needRotate = 1U;
+        }
+
+        for( i = 0; ( needRotate != 0U ) && ( i < PEER_CONNECTION_DTLS_CERTIFICATE_SLOT_COUNT ); i++ )
+        {
+            if( pDtlsContext->certificates[ i ].isValid == 0U )
+            {
+                pFreeSlot = &pDtlsContext->certificates[ i ];
+                break;
+            }
+        }
+
+        pthread_mutex_unlock( &( pDtlsContext->certificateMutex ) );
+
+        if( ( needRotate != 0U ) && ( pFreeSlot == NULL ) )
+        {
+            LogWarn( ( "DTLS certificate is due for rotation but the previous one is still used by sessions." ) );
+        }
+    }
+    else
+    {
+        LogError( ( "Fail to check DTLS certificate rotation: mutex lock acquisition." ) );
+    }
+
+    return pFreeSlot;
+}
+
+/* Sleep until the active certificate is due for rotation, a slot is freed or shutdown is requested,
+ * at most the check interval. Returns 1 if the task should exit. */
+static uint8_t WaitForNextCheck( PeerConnectionDtlsContext_t * pDtlsContext )
+{
+    uint8_t isShutdown = 0U;
+    struct timespec deadline;
+    uint64_t deadlineSec;
+
+    if( pthread_mutex_lock( &( pDtlsContext->certificateMutex ) ) == 0 )
+    {
+        clock_gettime( CLOCK_MONOTONIC,
+                       &deadline );
+        deadlineSec = ( uint64_t ) deadline.tv_sec + PEER_CONNECTION_DTLS_CERTIFICATE_CHECK_INTERVAL_SEC;
+
+        if( ( pDtlsContext->pActiveCertificate != NULL ) &&
+            ( pDtlsContext->pActiveCertificate->rotateTimeSec > ( uint64_t ) deadline.tv_sec ) &&
+            ( pDtlsContext->pActiveCertificate->rotateTimeSec < deadlineSec ) )
+        {
+            deadlineSec = pDtlsContext->pActiveCertificate->rotateTimeSec;
+        }
+        deadline.tv_sec = ( time_t ) deadlineSec;
+
+        /* A single wait, an early wake up only costs one extra rotation check. */
+        if( pDtlsContext->isShutdown == 0U )
+        {
+            ( void ) pthread_cond_timedwait( &( pDtlsContext->certificateTaskCond ),
+                                             &( pDtlsContext->certificateMutex ),
+                                             &deadline );
+        }
+
+        isShutdown = pDtlsContext->isShutdown;
+        pthread_mutex_unlock( &( pDtlsContext->certificateMutex ) );
+    }
+    else
+    {
+        LogError( ( "Fail to wait DTLS certificate check: mutex lock acquisition." ) );
+        sleep( PEER_CONNECTION_DTLS_CERTIFICATE_CHECK_INTERVAL_SEC );
+    }
+
+    return isShutdown;
+}
+
+static void * PeerConnectionCertificate_Task( void * pParameter )
+{
+    PeerConnectionDtlsContext_t * pDtlsContext = ( PeerConnectionDtlsContext_t * ) pParameter;
+    PeerConnectionDtlsCertificate_t * pCertificate = NULL;
+
+    #if PEER_CONNECTION_DTLS_CERTIFICATE_PERSIST_ENABLED
+        /* Reuse the certificate from previous boot to skip key generation. */
+        pCertificate = &pDtlsContext->certificates[ 0 ];
+        if( LoadCertificate( pCertificate ) == PEER_CONNECTION_RESULT_OK )
+        {
+            ActivateCertificate( pDtlsContext,
+                                 pCertificate );
+        }
+    #endif /* #if PEER_CONNECTION_DTLS_CERTIFICATE_PERSIST_ENABLED */
+
+    for( ;; )
+    {
+        /* Only this task fills free slots, so the slot is safe to use without holding the mutex. */
+        pCertificate = GetCertificateToRotate( pDtlsContext );
+
+        if( pCertificate != NULL )
+        {
+            if( GenerateCertificate( pCertificate ) == PEER_CONNECTION_RESULT_OK )
+            {
+                #if PEER_CONNECTION_DTLS_CERTIFICATE_PERSIST_ENABLED
+                    SaveCertificate( pCertificate );
+                #endif /* #if PEER_CONNECTION_DTLS_CERTIFICATE_PERSIST_ENABLED */
+
+                ActivateCertificate( pDtlsContext,
+                                     pCertificate );
+            }
+            else
+            {
+                LogWarn( ( "Fail to generate DTLS certificate, retry in %d seconds.", PEER_CONNECTION_DTLS_CERTIFICATE_CHECK_INTERVAL_SEC ) );
+            }
+        }
+
+        if( WaitForNextCheck( pDtlsContext ) != 0U )
+        {
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+PeerConnectionResult_t PeerConnectionCertificate_Init( PeerConnectionDtlsContext_t * pDtlsContext )
+{
+    PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
+    pthread_condattr_t condAttr;
+
+    if( pDtlsContext == NULL )
+    {
+        LogError( ( "Invalid input, pDtlsContext: %p", pDtlsContext ) );
+        ret = PEER_CONNECTION_RESULT_BAD_PARAMETER;
+    }
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        memset( pDtlsContext->certificates,
+                0,
+                sizeof( pDtlsContext->certificates ) );
+        pDtlsContext->pActiveCertificate = NULL;
+        pDtlsContext->isShutdown = 0U;
+
+        if( ( pthread_condattr_init( &condAttr ) != 0 ) ||
+            ( pthread_condattr_setclock( &condAttr, CLOCK_MONOTONIC ) != 0 ) ||
+            ( pthread_mutex_init( &( pDtlsContext->certificateMutex ), NULL ) != 0 ) ||
+            ( pthread_cond_init( &( pDtlsContext->certificateReadyCond ), NULL ) != 0 ) ||
+            ( pthread_cond_init( &( pDtlsContext->certificateTaskCond ), &condAttr ) != 0 ) )
+        {
+            LogError( ( "Fail to create mutex/condition of DTLS certificate." ) );
+            ret = PEER_CONNECTION_RESULT_FAIL_CREATE_CERT_TASK;
+        }
+
+        ( void ) pthread_condattr_destroy( &condAttr );
+    }
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        if( pthread_create( &( pDtlsContext->certificateTask ),
+                            NULL,
+                            PeerConnectionCertificate_Task,
+                            pDtlsContext ) != 0 )
+        {
+            LogError( ( "Fail to create DTLS certificate task." ) );
+            ret = PEER_CONNECTION_RESULT_FAIL_CREATE_CERT_TASK;
+        }
+    }
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        pDtlsContext->isInitialized = 1U;
+    }
+
+    return ret;
+}
+
+PeerConnectionResult_t PeerConnectionCertificate_Acquire( PeerConnectionDtlsContext_t * pDtlsContext,
+                                                          PeerConnectionDtlsCertificate_t ** ppCertificate )
+{
+    PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
+    struct timespec deadline;
+    int waitResult = 0;
+
+    if( ( pDtlsContext == NULL ) || ( ppCertificate == NULL ) )
+    {
+        LogError( ( "Invalid input, pDtlsContext: %p, ppCertificate: %p", pDtlsContext, ppCertificate ) );
+        ret = PEER_CONNECTION_RESULT_BAD_PARAMETER;
+    }
+    else if( pDtlsContext->isInitialized == 0U )
+    {
+        LogError( ( "DTLS certificate manager is not initialized." ) );
+        ret = PEER_CONNECTION_RESULT_BAD_PARAMETER;
+    }
+    else
+    {
+        /* Empty else marker. */
+    }
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        clock_gettime( CLOCK_REALTIME,
+                       &deadline );
+        deadline.tv_sec += PEER_CONNECTION_DTLS_CERTIFICATE_WAIT_TIMEOUT_MS / 1000;
+
+        if( pthread_mutex_lock( &( pDtlsContext->certificateMutex ) ) == 0 )
+        {
+            /* Only the very first sessions after boot might wait for the background generation. */
+            while( ( pDtlsContext->pActiveCertificate == NULL ) && ( waitResult == 0 ) )
+            {
+                waitResult = pthread_cond_timedwait( &( pDtlsContext->certificateReadyCond ),
+                                                     &( pDtlsContext->certificateMutex ),
+                                                     &deadline );
+            }
+
+            if( pDtlsContext->pActiveCertificate != NULL )
+            {
+                pDtlsContext->pActiveCertificate->refCount++;
+                *ppCertificate = pDtlsContext->pActiveCertificate;
+            }
+            else
+            {
+                LogError( ( "Timeout waiting DTLS certificate, result: %d", waitResult ) );
+                ret = PEER_CONNECTION_RESULT_FAIL_WAIT_CERT;
+            }
+
+            pthread_mutex_unlock( &( pDtlsContext->certificateMutex ) );
+        }
+        else
+        {
+            LogError( ( "Fail to acquire DTLS certificate: mutex lock acquisition." ) );
+            ret = PEER_CONNECTION_RESULT_FAIL_WAIT_CERT;
+        }
+    }
+
+    return ret;
+}
+
+void PeerConnectionCertificate_Release( PeerConnectionDtlsContext_t * pDtlsContext,
+                                        PeerConnectionDtlsCertificate_t * pCertificate )
+{
+    if( ( pDtlsContext == NULL ) || ( pCertificate == NULL ) )
+    {
+        LogError( ( "Invalid input, pDtlsContext: %p, pCertificate: %p", pDtlsContext, pCertificate ) );
+    }
+    else if( pthread_mutex_lock( &( pDtlsContext->certificateMutex ) ) == 0 )
+    {
+        if( pCertificate->refCount > 0U )
+        {
+            pCertificate->refCount--;
+        }
+
+        /* Free the retired certificate once the last session using it is gone. */
+        if( ( pCertificate->refCount == 0U ) &&
+            ( pCertificate->isValid != 0U ) &&
+            ( pCertificate != pDtlsContext->pActiveCertificate ) )
+        {
+            FreeCertificate( pCertificate );
+
+            /* A rotation may be waiting for this slot. */
+            pthread_cond_signal( &( pDtlsContext->certificateTaskCond ) );
+        }
+
+        pthread_mutex_unlock( &( pDtlsContext->certificateMutex ) );
+    }
+    else
+    {
+        LogError( ( "Fail to release DTLS certificate: mutex lock acquisition." ) );
+    }
+}
+
+void PeerConnectionCertificate_DeInit( PeerConnectionDtlsContext_t * pDtlsContext )
+{
+    int i;
+
+    if( pDtlsContext == NULL )
+    {
+        LogError( ( "Invalid input, pDtlsContext: %p", pDtlsContext ) );
+    }
+    else if( pDtlsContext->isInitialized == 0U )
+    {
+        /* Nothing to release. */
+    }
+    else if( pthread_mutex_lock( &( pDtlsContext->certificateMutex ) ) == 0 )
+    {
+        pDtlsContext->isShutdown = 1U;
+        pthread_cond_signal( &( pDtlsContext->certificateTaskCond ) );
+        pthread_mutex_unlock( &( pDtlsContext->certificateMutex ) );
+
+        /* Waits for an ongoing key generation to finish. */
+        pthread_join( pDtlsContext->certificateTask,
+                      NULL );
+
+        for( i = 0; i < PEER_CONNECTION_DTLS_CERTIFICATE_SLOT_COUNT; i++ )
+        {
+            if( pDtlsContext->certificates[ i ].isValid != 0U )
+            {
+                FreeCertificate( &pDtlsContext->certificates[ i ] );
+            }
+        }
+        pDtlsContext->pActiveCertificate = NULL;
+
+        pthread_cond_destroy( &( pDtlsContext->certificateTaskCond ) );
+        pthread_cond_destroy( &( pDtlsContext->certificateReadyCond ) );
+        pthread_mutex_destroy( &( pDtlsContext->certificateMutex ) );
+        pDtlsContext->isInitialized = 0U;
+    }
+    else
+    {
+        LogError( ( "Fail to stop DTLS certificate task: mutex lock acquisition." ) );
+    }
+}
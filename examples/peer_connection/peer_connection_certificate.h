@@ -0,0 +1,66 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PEER_CONNECTION_CERTIFICATE_H
+#define PEER_CONNECTION_CERTIFICATE_H
+
+#pragma once
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+extern "C" {
+#endif
+/* *INDENT-ON* */
+
+/* Standard includes. */
+#include <stdint.h>
+
+#include "peer_connection_data_types.h"
+
+/* How long a certificate serves new sessions before it's rotated. */
+#ifndef PEER_CONNECTION_DTLS_CERTIFICATE_LIFETIME_SEC
+#define PEER_CONNECTION_DTLS_CERTIFICATE_LIFETIME_SEC ( 7 * DTLS_SECONDS_IN_A_DAY )
+#endif
+
+/* Rotate at least this long before the certificate expires. */
+#define PEER_CONNECTION_DTLS_CERTIFICATE_ROTATE_MARGIN_SEC ( DTLS_SECONDS_IN_A_DAY )
+
+/* Longest the background task waits between checks, used to retry failed generation or a busy slot. */
+#define PEER_CONNECTION_DTLS_CERTIFICATE_CHECK_INTERVAL_SEC ( 60 )
+
+/* Maximum time for a new session to wait for the first certificate. */
+#define PEER_CONNECTION_DTLS_CERTIFICATE_WAIT_TIMEOUT_MS ( 30000 )
+
+/* Start the background task which loads or generates the certificate and rotates it afterwards. */
+PeerConnectionResult_t PeerConnectionCertificate_Init( PeerConnectionDtlsContext_t * pDtlsContext );
+
+/* Pin the active certificate for a session, it stays valid until released even if rotated. */
+PeerConnectionResult_t PeerConnectionCertificate_Acquire( PeerConnectionDtlsContext_t * pDtlsContext,
+                                                          PeerConnectionDtlsCertificate_t ** ppCertificate );
+
+void PeerConnectionCertificate_Release( PeerConnectionDtlsContext_t * pDtlsContext,
+                                        PeerConnectionDtlsCertificate_t * pCertificate );
+
+/* Stop and join the background task, then free the certificates. Sessions must have released them. */
+void PeerConnectionCertificate_DeInit( PeerConnectionDtlsContext_t * pDtlsContext );
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+}
+#endif
+/* *INDENT-ON* */
+
+#endif /* PEER_CONNECTION_CERTIFICATE_H */
@@ -147,7 +147,7 @@ PeerConnectionResult_t PeerConnectionSrtp_WriteG711Frame( PeerConnectionSession_
     G711PacketizerContext_t g711PacketizerContext;
     G711Result_t resultG711;
     G711Packet_t packetG711;
-    uint8_t rtpBuffer[ PEER_CONNECTION_SRTP_RTP_PACKET_MAX_LENGTH ];
+    uint8_t rtpBuffer[ ICE_CONTROLLER_SEND_HEADROOM_LENGTH + PEER_CONNECTION_SRTP_RTP_PACKET_MAX_LENGTH ];
     PeerConnectionRollingBufferPacket_t * pRollingBufferPacket = NULL;
     uint8_t * pSrtpPacket = NULL;
     size_t srtpPacketLength = 0;
@@ -240,8 +240,8 @@ PeerConnectionResult_t PeerConnectionSrtp_WriteG711Frame( PeerConnectionSession_
             packetG711.pPacketData = pRollingBufferPacket->pPacketBuffer + PEER_CONNECTION_SRTP_RTX_WRITE_RESERVED_BYTES;
             packetG711.packetDataLength = pRollingBufferPacket->packetBufferLength - PEER_CONNECTION_SRTP_RTX_WRITE_RESERVED_BYTES;
 
-            /* Using local buffer for SRTP packet, use the entire packet length. */
-            pSrtpPacket = rtpBuffer;
+            /* Using local buffer for SRTP packet, use the entire packet length after the reserved headroom. */
+            pSrtpPacket = rtpBuffer + ICE_CONTROLLER_SEND_HEADROOM_LENGTH;
             srtpPacketLength = PEER_CONNECTION_SRTP_RTP_PACKET_MAX_LENGTH;
         }
         else
@@ -342,9 +342,9 @@ PeerConnectionResult_t PeerConnectionSrtp_WriteG711Frame( PeerConnectionSession_
         /* Write the constructed RTP packets through network. */
         if( ret == PEER_CONNECTION_RESULT_OK )
         {
-            resultIceController = IceController_SendToRemotePeer( &pSession->iceControllerContext,
-                                                                  pSrtpPacket,
-                                                                  srtpPacketLength );
+            resultIceController = IceController_SendToRemotePeerWithHeadroom( &pSession->iceControllerContext,
+                                                                              pSrtpPacket,
+                                                                              srtpPacketLength );
             if( resultIceController != ICE_CONTROLLER_RESULT_OK )
             {
                 LogWarn( ( "Fail to send RTP packet, ret: %d", resultIceController ) );
@@ -18,6 +18,37 @@
 #include "h264_packetizer.h"
 #include "h264_depacketizer.h"
 
+#define PEER_CONNECTION_H264_NALU_TYPE_MASK ( 0x1F )
+#define PEER_CONNECTION_H264_NALU_REF_IDC_MASK ( 0x60 )
+#define PEER_CONNECTION_H264_NALU_TYPE_SLICE_MIN ( 1 )
+#define PEER_CONNECTION_H264_NALU_TYPE_IDR ( 5 )
+#define PEER_CONNECTION_H264_NALU_TYPE_SPS ( 7 )
+#define PEER_CONNECTION_H264_NALU_TYPE_PPS ( 8 )
+
+static PeerConnectionResult_t AppendParameterSet( uint8_t * pBuffer,
+                                                  size_t bufferSize,
+                                                  size_t * pBufferLength,
+                                                  const uint8_t * pNalu,
+                                                  size_t naluLength )
+{
+    PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
+    static const uint8_t startCode[] = { 0x00, 0x00, 0x00, 0x01 };
+
+    if( *pBufferLength + sizeof( startCode ) + naluLength > bufferSize )
+    {
+        LogWarn( ( "Parameter sets don't fit in buffer, size: %lu", bufferSize ) );
+        ret = PEER_CONNECTION_RESULT_FAIL_KEYFRAME_CACHE_PARAMETER_SETS_TOO_LARGE;
+    }
+    else
+    {
+        memcpy( &pBuffer[ *pBufferLength ], startCode, sizeof( startCode ) );
+        memcpy( &pBuffer[ *pBufferLength + sizeof( startCode ) ], pNalu, naluLength );
+        *pBufferLength += sizeof( startCode ) + naluLength;
+    }
+
+    return ret;
+}
+
 PeerConnectionResult_t GetH264PacketProperty( PeerConnectionJitterBufferPacket_t * pPacket,
                                               uint8_t * pIsStartPacket )
 {
@@ -139,6 +170,129 @@ PeerConnectionResult_t FillFrameH264( PeerConnectionJitterBuffer_t * pJitterBuff
     return ret;
 }
 
+PeerConnectionResult_t GetH264FrameType( const PeerConnectionFrame_t * pFrame,
+                                         PeerConnectionVideoFrameType_t * pFrameType )
+{
+    PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
+    uint8_t naluHeader;
+    uint8_t isSliceFound = 0U;
+    uint8_t isReferenceFound = 0U;
+    uint8_t isIdrFound = 0U;
+    size_t i;
+
+    if( ( pFrame == NULL ) ||
+        ( pFrame->pData == NULL ) ||
+        ( pFrameType == NULL ) )
+    {
+        LogError( ( "Invalid input, pFrame: %p, pFrameType: %p", pFrame, pFrameType ) );
+        ret = PEER_CONNECTION_RESULT_BAD_PARAMETER;
+    }
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        for( i = 0; ( i + 3U < pFrame->dataLength ) && ( isIdrFound == 0U ); i++ )
+        {
+            if( ( pFrame->pData[ i ] != 0x00 ) || ( pFrame->pData[ i + 1U ] != 0x00 ) || ( pFrame->pData[ i + 2U ] != 0x01 ) )
+            {
+                continue;
+            }
+
+            naluHeader = pFrame->pData[ i + 3U ];
+            if( ( naluHeader & PEER_CONNECTION_H264_NALU_TYPE_MASK ) == PEER_CONNECTION_H264_NALU_TYPE_IDR )
+            {
+                isIdrFound = 1U;
+            }
+            else if( ( ( naluHeader & PEER_CONNECTION_H264_NALU_TYPE_MASK ) >= PEER_CONNECTION_H264_NALU_TYPE_SLICE_MIN ) &&
+                     ( ( naluHeader & PEER_CONNECTION_H264_NALU_TYPE_MASK ) < PEER_CONNECTION_H264_NALU_TYPE_IDR ) )
+            {
+                isSliceFound = 1U;
+                if( ( naluHeader & PEER_CONNECTION_H264_NALU_REF_IDC_MASK ) != 0U )
+                {
+                    isReferenceFound = 1U;
+                }
+            }
+            else
+            {
+                /* Parameter sets and SEI don't decide the frame type. */
+            }
+        }
+
+        if( isIdrFound != 0U )
+        {
+            *pFrameType = PEER_CONNECTION_VIDEO_FRAME_TYPE_KEY;
+        }
+        else if( ( isSliceFound != 0U ) && ( isReferenceFound == 0U ) )
+        {
+            /* nal_ref_idc is zero in every slice. */
+            *pFrameType = PEER_CONNECTION_VIDEO_FRAME_TYPE_NON_REFERENCE;
+        }
+        else
+        {
+            *pFrameType = PEER_CONNECTION_VIDEO_FRAME_TYPE_REFERENCE;
+        }
+    }
+
+    return ret;
+}
+
+PeerConnectionResult_t GetH264ParameterSets( const PeerConnectionFrame_t * pFrame,
+                                             uint8_t * pBuffer,
+                                             size_t * pBufferLength )
+{
+    PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
+    uint8_t naluType;
+    uint8_t isParameterSet = 0U;
+    uint8_t isSliceFound = 0U;
+    size_t bufferSize;
+    size_t naluStart = 0;
+    size_t naluEnd;
+    size_t i;
+
+    if( ( pFrame == NULL ) ||
+        ( pFrame->pData == NULL ) ||
+        ( pBuffer == NULL ) ||
+        ( pBufferLength == NULL ) )
+    {
+        LogError( ( "Invalid input, pFrame: %p, pBuffer: %p, pBufferLength: %p", pFrame, pBuffer, pBufferLength ) );
+        ret = PEER_CONNECTION_RESULT_BAD_PARAMETER;
+    }
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        bufferSize = *pBufferLength;
+        *pBufferLength = 0;
+
+        /* Parameter sets precede the slices of an access unit, so stop at the first slice. */
+        for( i = 0; ( i + 3U < pFrame->dataLength ) && ( isSliceFound == 0U ) && ( ret == PEER_CONNECTION_RESULT_OK ); i++ )
+        {
+            if( ( pFrame->pData[ i ] != 0x00 ) || ( pFrame->pData[ i + 1U ] != 0x00 ) || ( pFrame->pData[ i + 2U ] != 0x01 ) )
+            {
+                continue;
+            }
+
+            if( isParameterSet != 0U )
+            {
+                /* The zero byte of a 4-byte start code belongs to the next NAL unit. */
+                naluEnd = ( ( i > naluStart ) && ( pFrame->pData[ i - 1U ] == 0x00 ) ) ? i - 1U : i;
+                ret = AppendParameterSet( pBuffer, bufferSize, pBufferLength, &pFrame->pData[ naluStart ], naluEnd - naluStart );
+            }
+
+            naluType = pFrame->pData[ i + 3U ] & PEER_CONNECTION_H264_NALU_TYPE_MASK;
+            isParameterSet = ( ( naluType == PEER_CONNECTION_H264_NALU_TYPE_SPS ) || ( naluType == PEER_CONNECTION_H264_NALU_TYPE_PPS ) ) ? 1U : 0U;
+            isSliceFound = ( ( naluType >= PEER_CONNECTION_H264_NALU_TYPE_SLICE_MIN ) && ( naluType <= PEER_CONNECTION_H264_NALU_TYPE_IDR ) ) ? 1U : 0U;
+            naluStart = i + 3U;
+            i += 2U;
+        }
+
+        if( ( ret == PEER_CONNECTION_RESULT_OK ) && ( isParameterSet != 0U ) )
+        {
+            ret = AppendParameterSet( pBuffer, bufferSize, pBufferLength, &pFrame->pData[ naluStart ], pFrame->dataLength - naluStart );
+        }
+    }
+
+    return ret;
+}
+
 PeerConnectionResult_t PeerConnectionSrtp_WriteH264Frame( PeerConnectionSession_t * pSession,
                                                           Transceiver_t * pTransceiver,
                                                           const PeerConnectionFrame_t * pFrame )
@@ -147,7 +301,7 @@ PeerConnectionResult_t PeerConnectionSrtp_WriteH264Frame( PeerConnectionSession_
     H264PacketizerContext_t h264PacketizerContext;
     H264Result_t resultH264;
     H264Packet_t packetH264;
-    uint8_t rtpBuffer[ PEER_CONNECTION_SRTP_RTP_PACKET_MAX_LENGTH ];
+    uint8_t rtpBuffer[ ICE_CONTROLLER_SEND_HEADROOM_LENGTH + PEER_CONNECTION_SRTP_RTP_PACKET_MAX_LENGTH ];
     PeerConnectionRollingBufferPacket_t * pRollingBufferPacket = NULL;
     uint8_t * pSrtpPacket = NULL;
     size_t srtpPacketLength = 0;
@@ -253,8 +407,8 @@ PeerConnectionResult_t PeerConnectionSrtp_WriteH264Frame( PeerConnectionSession_
             packetH264.pPacketData = pRollingBufferPacket->pPacketBuffer + PEER_CONNECTION_SRTP_RTX_WRITE_RESERVED_BYTES;
             packetH264.packetDataLength = pRollingBufferPacket->packetBufferLength - PEER_CONNECTION_SRTP_RTX_WRITE_RESERVED_BYTES;
 
-            /* Using local buffer for SRTP packet, use the entire packet length. */
-            pSrtpPacket = rtpBuffer;
+            /* Using local buffer for SRTP packet, use the entire packet length after the reserved headroom. */
+            pSrtpPacket = rtpBuffer + ICE_CONTROLLER_SEND_HEADROOM_LENGTH;
             srtpPacketLength = PEER_CONNECTION_SRTP_RTP_PACKET_MAX_LENGTH;
         }
         else
@@ -357,9 +511,9 @@ PeerConnectionResult_t PeerConnectionSrtp_WriteH264Frame( PeerConnectionSession_
         /* Write the constructed RTP packets through network. */
         if( ret == PEER_CONNECTION_RESULT_OK )
         {
-            resultIceController = IceController_SendToRemotePeer( &pSession->iceControllerContext,
-                                                                  pSrtpPacket,
-                                                                  srtpPacketLength );
+            resultIceController = IceController_SendToRemotePeerWithHeadroom( &pSession->iceControllerContext,
+                                                                              pSrtpPacket,
+                                                                              srtpPacketLength );
             if( resultIceController != ICE_CONTROLLER_RESULT_OK )
             {
                 LogWarn( ( "Fail to send RTP packet, ret: %d", resultIceController ) );
@@ -32,6 +32,15 @@ PeerConnectionResult_t FillFrameH264( PeerConnectionJitterBuffer_t * pJitterBuff
                                       size_t * pOutBufferLength,
                                       uint32_t * pRtpTimestamp );
 
+/* Classify an Annex-B frame by its NAL unit types. */
+PeerConnectionResult_t GetH264FrameType( const PeerConnectionFrame_t * pFrame,
+                                         PeerConnectionVideoFrameType_t * pFrameType );
+
+/* Copy the parameter set NAL units of an Annex-B frame with 4-byte start codes, *pBufferLength is 0 if there is none. */
+PeerConnectionResult_t GetH264ParameterSets( const PeerConnectionFrame_t * pFrame,
+                                             uint8_t * pBuffer,
+                                             size_t * pBufferLength );
+
 PeerConnectionResult_t PeerConnectionSrtp_WriteH264Frame( PeerConnectionSession_t * pSession,
                                                           Transceiver_t * pTransceiver,
                                                           const PeerConnectionFrame_t * pFrame );
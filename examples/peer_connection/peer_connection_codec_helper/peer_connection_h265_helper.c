@@ -18,6 +18,37 @@
 #include "h265_packetizer.h"
 #include "h265_depacketizer.h"
 
+#define PEER_CONNECTION_H265_GET_NALU_TYPE( naluHeader ) ( ( ( naluHeader ) >> 1 ) & 0x3F )
+/* BLA, IDR, CRA and the reserved IRAP types. */
+#define PEER_CONNECTION_H265_NALU_TYPE_IRAP_MIN ( 16 )
+#define PEER_CONNECTION_H265_NALU_TYPE_IRAP_MAX ( 23 )
+#define PEER_CONNECTION_H265_NALU_TYPE_VPS ( 32 )
+#define PEER_CONNECTION_H265_NALU_TYPE_PPS ( 34 )
+
+static PeerConnectionResult_t AppendParameterSet( uint8_t * pBuffer,
+                                                  size_t bufferSize,
+                                                  size_t * pBufferLength,
+                                                  const uint8_t * pNalu,
+                                                  size_t naluLength )
+{
+    PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
+    static const uint8_t startCode[] = { 0x00, 0x00, 0x00, 0x01 };
+
+    if( *pBufferLength + sizeof( startCode ) + naluLength > bufferSize )
+    {
+        LogWarn( ( "Parameter sets don't fit in buffer, size: %lu", bufferSize ) );
+        ret = PEER_CONNECTION_RESULT_FAIL_KEYFRAME_CACHE_PARAMETER_SETS_TOO_LARGE;
+    }
+    else
+    {
+        memcpy( &pBuffer[ *pBufferLength ], startCode, sizeof( startCode ) );
+        memcpy( &pBuffer[ *pBufferLength + sizeof( startCode ) ], pNalu, naluLength );
+        *pBufferLength += sizeof( startCode ) + naluLength;
+    }
+
+    return ret;
+}
+
 PeerConnectionResult_t GetH265PacketProperty( PeerConnectionJitterBufferPacket_t * pPacket,
                                               uint8_t * pIsStartPacket )
 {
@@ -140,6 +171,129 @@ PeerConnectionResult_t FillFrameH265( PeerConnectionJitterBuffer_t * pJitterBuff
     return ret;
 }
 
+PeerConnectionResult_t GetH265FrameType( const PeerConnectionFrame_t * pFrame,
+                                         PeerConnectionVideoFrameType_t * pFrameType )
+{
+    PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
+    uint8_t naluType;
+    uint8_t isSliceFound = 0U;
+    uint8_t isReferenceFound = 0U;
+    uint8_t isIrapFound = 0U;
+    size_t i;
+
+    if( ( pFrame == NULL ) ||
+        ( pFrame->pData == NULL ) ||
+        ( pFrameType == NULL ) )
+    {
+        LogError( ( "Invalid input, pFrame: %p, pFrameType: %p", pFrame, pFrameType ) );
+        ret = PEER_CONNECTION_RESULT_BAD_PARAMETER;
+    }
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        for( i = 0; ( i + 3U < pFrame->dataLength ) && ( isIrapFound == 0U ); i++ )
+        {
+            if( ( pFrame->pData[ i ] != 0x00 ) || ( pFrame->pData[ i + 1U ] != 0x00 ) || ( pFrame->pData[ i + 2U ] != 0x01 ) )
+            {
+                continue;
+            }
+
+            naluType = PEER_CONNECTION_H265_GET_NALU_TYPE( pFrame->pData[ i + 3U ] );
+            if( ( naluType >= PEER_CONNECTION_H265_NALU_TYPE_IRAP_MIN ) &&
+                ( naluType <= PEER_CONNECTION_H265_NALU_TYPE_IRAP_MAX ) )
+            {
+                isIrapFound = 1U;
+            }
+            else if( naluType < PEER_CONNECTION_H265_NALU_TYPE_IRAP_MIN )
+            {
+                /* Even VCL types below IRAP (TRAIL_N, TSA_N, RADL_N...) are sub-layer non-reference pictures. */
+                isSliceFound = 1U;
+                if( ( naluType & 0x01 ) != 0U )
+                {
+                    isReferenceFound = 1U;
+                }
+            }
+            else
+            {
+                /* Parameter sets and SEI don't decide the frame type. */
+            }
+        }
+
+        if( isIrapFound != 0U )
+        {
+            *pFrameType = PEER_CONNECTION_VIDEO_FRAME_TYPE_KEY;
+        }
+        else if( ( isSliceFound != 0U ) && ( isReferenceFound == 0U ) )
+        {
+            *pFrameType = PEER_CONNECTION_VIDEO_FRAME_TYPE_NON_REFERENCE;
+        }
+        else
+        {
+            *pFrameType = PEER_CONNECTION_VIDEO_FRAME_TYPE_REFERENCE;
+        }
+    }
+
+    return ret;
+}
+
+PeerConnectionResult_t GetH265ParameterSets( const PeerConnectionFrame_t * pFrame,
+                                             uint8_t * pBuffer,
+                                             size_t * pBufferLength )
+{
+    PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
+    uint8_t naluType;
+    uint8_t isParameterSet = 0U;
+    uint8_t isSliceFound = 0U;
+    size_t bufferSize;
+    size_t naluStart = 0;
+    size_t naluEnd;
+    size_t i;
+
+    if( ( pFrame == NULL ) ||
+        ( pFrame->pData == NULL ) ||
+        ( pBuffer == NULL ) ||
+        ( pBufferLength == NULL ) )
+    {
+        LogError( ( "Invalid input, pFrame: %p, pBuffer: %p, pBufferLength: %p", pFrame, pBuffer, pBufferLength ) );
+        ret = PEER_CONNECTION_RESULT_BAD_PARAMETER;
+    }
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        bufferSize = *pBufferLength;
+        *pBufferLength = 0;
+
+        /* Parameter sets precede the slices of an access unit, so stop at the first slice. */
+        for( i = 0; ( i + 3U < pFrame->dataLength ) && ( isSliceFound == 0U ) && ( ret == PEER_CONNECTION_RESULT_OK ); i++ )
+        {
+            if( ( pFrame->pData[ i ] != 0x00 ) || ( pFrame->pData[ i + 1U ] != 0x00 ) || ( pFrame->pData[ i + 2U ] != 0x01 ) )
+            {
+                continue;
+            }
+
+            if( isParameterSet != 0U )
+            {
+                /* The zero byte of a 4-byte start code belongs to the next NAL unit. */
+                naluEnd = ( ( i > naluStart ) && ( pFrame->pData[ i - 1U ] == 0x00 ) ) ? i - 1U : i;
+                ret = AppendParameterSet( pBuffer, bufferSize, pBufferLength, &pFrame->pData[ naluStart ], naluEnd - naluStart );
+            }
+
+            naluType = PEER_CONNECTION_H265_GET_NALU_TYPE( pFrame->pData[ i + 3U ] );
+            isParameterSet = ( ( naluType >= PEER_CONNECTION_H265_NALU_TYPE_VPS ) && ( naluType <= PEER_CONNECTION_H265_NALU_TYPE_PPS ) ) ? 1U : 0U;
+            isSliceFound = ( naluType < PEER_CONNECTION_H265_NALU_TYPE_VPS ) ? 1U : 0U;
+            naluStart = i + 3U;
+            i += 2U;
+        }
+
+        if( ( ret == PEER_CONNECTION_RESULT_OK ) && ( isParameterSet != 0U ) )
+        {
+            ret = AppendParameterSet( pBuffer, bufferSize, pBufferLength, &pFrame->pData[ naluStart ], pFrame->dataLength - naluStart );
+        }
+    }
+
+    return ret;
+}
+
 PeerConnectionResult_t PeerConnectionSrtp_WriteH265Frame( PeerConnectionSession_t * pSession,
                                                           Transceiver_t * pTransceiver,
                                                           const PeerConnectionFrame_t * pFrame )
@@ -148,7 +302,7 @@ PeerConnectionResult_t PeerConnectionSrtp_WriteH265Frame( PeerConnectionSession_
     H265PacketizerContext_t h265PacketizerContext;
     H265Result_t resulth265;
     H265Packet_t packeth265;
-    uint8_t rtpBuffer[ PEER_CONNECTION_SRTP_RTP_PACKET_MAX_LENGTH ];
+    uint8_t rtpBuffer[ ICE_CONTROLLER_SEND_HEADROOM_LENGTH + PEER_CONNECTION_SRTP_RTP_PACKET_MAX_LENGTH ];
     PeerConnectionRollingBufferPacket_t * pRollingBufferPacket = NULL;
     uint8_t * pSrtpPacket = NULL;
     size_t srtpPacketLength = 0;
@@ -254,8 +408,8 @@ PeerConnectionResult_t PeerConnectionSrtp_WriteH265Frame( PeerConnectionSession_
             packeth265.pPacketData = pRollingBufferPacket->pPacketBuffer + PEER_CONNECTION_SRTP_RTX_WRITE_RESERVED_BYTES;
             packeth265.packetDataLength = pRollingBufferPacket->packetBufferLength - PEER_CONNECTION_SRTP_RTX_WRITE_RESERVED_BYTES;
 
-            /* Using local buffer for SRTP packet, use the entire packet length. */
-            pSrtpPacket = rtpBuffer;
+            /* Using local buffer for SRTP packet, use the entire packet length after the reserved headroom. */
+            pSrtpPacket = rtpBuffer + ICE_CONTROLLER_SEND_HEADROOM_LENGTH;
             srtpPacketLength = PEER_CONNECTION_SRTP_RTP_PACKET_MAX_LENGTH;
         }
         else
@@ -360,9 +514,9 @@ PeerConnectionResult_t PeerConnectionSrtp_WriteH265Frame( PeerConnectionSession_
         /* Write the constructed RTP packets through network. */
         if( ret == PEER_CONNECTION_RESULT_OK )
         {
-            resultIceController = IceController_SendToRemotePeer( &pSession->iceControllerContext,
-                                                                  pSrtpPacket,
-                                                                  srtpPacketLength );
+            resultIceController = IceController_SendToRemotePeerWithHeadroom( &pSession->iceControllerContext,
+                                                                              pSrtpPacket,
+                                                                              srtpPacketLength );
             if( resultIceController != ICE_CONTROLLER_RESULT_OK )
             {
                 LogWarn( ( "Fail to send RTP packet, ret: %d", resultIceController ) );
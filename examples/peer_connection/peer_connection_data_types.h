@@ -38,6 +38,10 @@ extern "C" {
 
 #include "srtp.h"
 
+#if METRIC_PRINT_ENABLED
+#include "metric.h"
+#endif
+
 #if ENABLE_SCTP_DATA_CHANNEL
 #include "sctp_utils.h"
 #endif /* ENABLE_SCTP_DATA_CHANNEL */
@@ -61,11 +65,30 @@ extern "C" {
 
 #define PEER_CONNECTION_RTCP_TWCC_MAX_ARRAY ( 100 )
 
-#define PEER_CONNECTION_MAX_DTLS_DECRYPTED_DATA_LENGTH ( 2048 )
+/* Maximum number of video tracks with a cached keyframe, tracks are matched by track ID. */
+#define PEER_CONNECTION_KEYFRAME_CACHE_MAX_TRACK_NUM ( 2 )
+/* A cached keyframe older than this is not replayed, the viewer waits for a fresh one instead. */
+#define PEER_CONNECTION_KEYFRAME_CACHE_MAX_AGE_US ( 2000000 )
+/* Latest parameter sets of each track, prepended to keyframes that don't carry them in-band. */
+#define PEER_CONNECTION_KEYFRAME_CACHE_PARAMETER_SETS_MAX_LENGTH ( 256 )
+
+/* Maximum number of cached SDP answer templates, one per distinct offer shape. */
+#define PEER_CONNECTION_SDP_TEMPLATE_MAX_COUNT ( 8 )
+/* Per-session values in one answer: session ID, ICE credentials of each m-line
+ * and the SSRC lines of each transceiver. */
+#define PEER_CONNECTION_SDP_TEMPLATE_MAX_SLOT_COUNT ( 48 )
+/* Largest answer the template cache or a grown answer buffer would hold. */
+#define PEER_CONNECTION_SDP_TEMPLATE_MAX_LENGTH ( 64 * 1024 )
+
+/* Large enough for the payload of one full DTLS record (2^14 bytes). */
+#define PEER_CONNECTION_MAX_DTLS_DECRYPTED_DATA_LENGTH ( 16384 )
 
 #define MAX_SCTP_DATA_CHANNELS          4
 #define PEER_CONNECTION_MAX_SCTP_DATA_CHANNELS_PER_PEER 2
 
+/* Maximum size of an inbound SCTP packet handed to the SCTP task. */
+#define PEER_CONNECTION_SCTP_MAX_PACKET_LENGTH ( 4096 )
+
 #define PEER_CONNECTION_TWCC_BITRATE_ADJUSTMENT_INTERVAL_US        1000 * 10000  //1,000,000 microseconds.
 #define PEER_CONNECTION_MIN_VIDEO_BITRATE_KBPS                     512     // Unit kilobits/sec. Value could change based on codec.
 #define PEER_CONNECTION_MAX_VIDEO_BITRATE_KBPS                     2048000 // Unit kilobits/sec. Value could change based on codec.
@@ -76,6 +99,8 @@ extern "C" {
 #define PEER_CONNECTION_INACTIVE_CONNECTION_TIMEOUT_MS ( 30000 )
 #define PEER_CONNECTION_DTLS_HANDSHAKING_TIMEOUT_MS    ( 12000 )
 
+#define PEER_CONNECTION_DTLS_CERTIFICATE_SLOT_COUNT ( 2 )
+
 typedef enum PeerConnectionResult
 {
     PEER_CONNECTION_RESULT_OK = 0,
@@ -84,6 +109,7 @@ typedef enum PeerConnectionResult
     PEER_CONNECTION_RESULT_NO_FREE_TRANSCEIVER,
     PEER_CONNECTION_RESULT_FAIL_CREATE_TASK_ICE_CONTROLLER,
     PEER_CONNECTION_RESULT_FAIL_CREATE_TASK_ICE_SOCK_LISTENER,
+    PEER_CONNECTION_RESULT_FAIL_CREATE_TASK_SCTP,
     PEER_CONNECTION_RESULT_FAIL_CREATE_STARTUP_BARRIER,
     PEER_CONNECTION_RESULT_FAIL_SIGNAL_STARTUP_BARRIER,
     PEER_CONNECTION_RESULT_FAIL_ICE_CONTROLLER_INIT,
@@ -100,6 +126,8 @@ typedef enum PeerConnectionResult
     PEER_CONNECTION_RESULT_FAIL_ICE_CONTROLLER_ADD_ICE_SERVER_CONFIG,
     PEER_CONNECTION_RESULT_FAIL_CREATE_CERT_AND_KEY,
     PEER_CONNECTION_RESULT_FAIL_CREATE_CERT_FINGERPRINT,
+    PEER_CONNECTION_RESULT_FAIL_CREATE_CERT_TASK,
+    PEER_CONNECTION_RESULT_FAIL_WAIT_CERT,
     PEER_CONNECTION_RESULT_FAIL_MQ_INIT,
     PEER_CONNECTION_RESULT_FAIL_MQ_SEND,
     PEER_CONNECTION_RESULT_FAIL_CREATE_SRTP_RX_SESSION,
@@ -133,6 +161,21 @@ typedef enum PeerConnectionResult
     PEER_CONNECTION_RESULT_FAIL_TAKE_SENDER_MUTEX,
     PEER_CONNECTION_RESULT_FAIL_CREATE_SRTP_MUTEX,
     PEER_CONNECTION_RESULT_FAIL_TAKE_SRTP_MUTEX,
+    PEER_CONNECTION_RESULT_FAIL_CREATE_KEYFRAME_CACHE_MUTEX,
+    PEER_CONNECTION_RESULT_FAIL_TAKE_KEYFRAME_CACHE_MUTEX,
+    PEER_CONNECTION_RESULT_FAIL_CREATE_SCTP_MUTEX,
+    PEER_CONNECTION_RESULT_FAIL_SCTP_RECEIVE_QUEUE_INIT,
+    PEER_CONNECTION_RESULT_FAIL_SCTP_GET_BUFFERED_AMOUNT,
+    PEER_CONNECTION_RESULT_FAIL_SCTP_SET_BUFFERED_AMOUNT_LOW,
+    PEER_CONNECTION_RESULT_FAIL_KEYFRAME_CACHE_NO_ENOUGH_MEMORY,
+    PEER_CONNECTION_RESULT_NO_FREE_KEYFRAME_CACHE,
+    PEER_CONNECTION_RESULT_FAIL_KEYFRAME_CACHE_PARAMETER_SETS_TOO_LARGE,
+    PEER_CONNECTION_RESULT_FAIL_CREATE_SDP_TEMPLATE_CACHE_MUTEX,
+    PEER_CONNECTION_RESULT_FAIL_TAKE_SDP_TEMPLATE_CACHE_MUTEX,
+    PEER_CONNECTION_RESULT_FAIL_SDP_TEMPLATE_NO_ENOUGH_MEMORY,
+    PEER_CONNECTION_RESULT_FAIL_SDP_TEMPLATE_TOO_MANY_SLOTS,
+    PEER_CONNECTION_RESULT_FAIL_SDP_TEMPLATE_MISMATCH,
+    PEER_CONNECTION_RESULT_SDP_TEMPLATE_NOT_FOUND,
     PEER_CONNECTION_RESULT_FAIL_PACKET_INFO_NO_ENOUGH_MEMORY,
     PEER_CONNECTION_RESULT_FAIL_RTP_PACKET_QUEUE_INIT,
     PEER_CONNECTION_RESULT_FAIL_RTP_PACKET_QUEUE_RETRIEVE,
@@ -150,6 +193,10 @@ typedef enum PeerConnectionResult
     PEER_CONNECTION_RESULT_FAIL_SDP_SET_PAYLOAD_TYPE,
     PEER_CONNECTION_RESULT_FAIL_SDP_POPULATE_SINGLE_MEDIA_DESCRIPTION,
     PEER_CONNECTION_RESULT_FAIL_SDP_POPULATE_SESSION_DESCRIPTION,
+    PEER_CONNECTION_RESULT_FAIL_SDP_BUFFER_TOO_SMALL,
+    PEER_CONNECTION_RESULT_FAIL_REMOTE_SDP_NO_ENOUGH_MEMORY,
+    PEER_CONNECTION_RESULT_FAIL_CREATE_REMOTE_SDP_MUTEX,
+    PEER_CONNECTION_RESULT_FAIL_TAKE_REMOTE_SDP_MUTEX,
     PEER_CONNECTION_RESULT_INVALID_REMOTE_USERNAME,
     PEER_CONNECTION_RESULT_INVALID_REMOTE_PASSWORD,
     PEER_CONNECTION_RESULT_UNKNOWN_SRTP_PROFILE,
@@ -163,6 +210,8 @@ typedef enum PeerConnectionResult
     PEER_CONNECTION_RESULT_FAIL_SCTP_WRITE,
     PEER_CONNECTION_RESULT_FAIL_SCTP_READ,
     PEER_CONNECTION_RESULT_FAIL_SCTP_CLOSE,
+    PEER_CONNECTION_RESULT_FAIL_SCTP_MESSAGE_TOO_LARGE,
+    PEER_CONNECTION_RESULT_FAIL_SCTP_SEND_QUEUE_FULL,
 } PeerConnectionResult_t;
 
 /*
@@ -192,6 +241,10 @@ typedef void (* OnIceCandidateReadyCallback_t)( void * pCustomContext,
 typedef void ( * OnPictureLossIndicationCallback_t )( void * pCustomContext,
                                                       RtcpPliPacket_t * pRtcpPliPacket );
 
+/* Called when the session starts dropping video to resync, the media source should produce a keyframe soon. */
+typedef void ( * OnKeyFrameRequestCallback_t )( void * pCustomContext,
+                                                uint32_t ssrc );
+
 /*
  * Media relates data structures.
  */
@@ -203,6 +256,16 @@ typedef struct PeerConnectionFrame
     uint64_t presentationUs;
 } PeerConnectionFrame_t;
 
+typedef enum PeerConnectionVideoFrameType
+{
+    /* IDR (H.264) or IRAP (H.265) frame, decoding can start from here. */
+    PEER_CONNECTION_VIDEO_FRAME_TYPE_KEY = 0,
+    /* Frame which might be referenced by following frames. */
+    PEER_CONNECTION_VIDEO_FRAME_TYPE_REFERENCE,
+    /* Frame never referenced by other frames, losing it doesn't break decoding. */
+    PEER_CONNECTION_VIDEO_FRAME_TYPE_NON_REFERENCE,
+} PeerConnectionVideoFrameType_t;
+
 typedef struct PeerConnectionJitterBufferPacket PeerConnectionJitterBufferPacket_t;
 typedef struct PeerConnectionJitterBuffer PeerConnectionJitterBuffer_t;
 
@@ -222,6 +285,11 @@ typedef PeerConnectionResult_t (* FillFrameFunc_t)( PeerConnectionJitterBuffer_t
                                                     uint8_t * pOutBuffer,
                                                     size_t * pOutBufferLength,
                                                     uint32_t * pRtpTimestamp );
+typedef PeerConnectionResult_t (* GetVideoFrameTypeFunc_t)( const PeerConnectionFrame_t * pFrame,
+                                                            PeerConnectionVideoFrameType_t * pFrameType );
+typedef PeerConnectionResult_t (* GetVideoParameterSetsFunc_t)( const PeerConnectionFrame_t * pFrame,
+                                                                uint8_t * pBuffer,
+                                                                size_t * pBufferLength );
 
 typedef struct PeerConnectionRollingBufferPacket
 {
@@ -336,6 +404,30 @@ typedef struct PeerConnectionRtpConfig
     uint32_t remoteAudioSsrc;
 } PeerConnectionRtpConfig_t;
 
+/* Each path has its own SRTP session and lock, so encrypting never waits for decrypting and vice versa. */
+typedef enum PeerConnectionSrtpPath
+{
+    PEER_CONNECTION_SRTP_PATH_RTP_TX = 0,
+    PEER_CONNECTION_SRTP_PATH_RTP_RX,
+    PEER_CONNECTION_SRTP_PATH_RTCP_TX,
+    PEER_CONNECTION_SRTP_PATH_RTCP_RX,
+    PEER_CONNECTION_SRTP_PATH_MAX,
+} PeerConnectionSrtpPath_t;
+
+typedef struct PeerConnectionSrtpSession
+{
+    /* The mutex guards both the use and the lifetime of the session. */
+    pthread_mutex_t mutex;
+    srtp_t session;
+
+    #if METRIC_PRINT_ENABLED
+    /* Lock statistics, updated with the mutex taken and merged into metrics on SRTP de-init. */
+    uint64_t lockAcquiredTimeNs;
+    MetricHistogramRecord_t lockWaitRecord;
+    MetricHistogramRecord_t lockHoldRecord;
+    #endif /* METRIC_PRINT_ENABLED */
+} PeerConnectionSrtpSession_t;
+
 typedef struct PeerConnectionSrtpSender
 {
     /* RTP Tx rolling buffer. */
@@ -346,6 +438,18 @@ typedef struct PeerConnectionSrtpSender
     uint8_t isSenderMutexInit;
 } PeerConnectionSrtpSender_t;
 
+/* Resync video after backpressure by dropping frames until the next keyframe.
+ * Any thread may request a resync, only the sending thread serves it. */
+typedef struct PeerConnectionVideoResync
+{
+    uint32_t requestCount;
+    uint32_t servedCount;
+    /* Number of times the session started resyncing. */
+    uint32_t resyncCount;
+    /* Number of frames dropped while waiting for the keyframe. */
+    uint32_t framesDroppedToResync;
+} PeerConnectionVideoResync_t;
+
 typedef struct PeerConnectionSrtpReceiver
 {
     /* RTP Rx jitter buffer. */
@@ -370,13 +474,21 @@ typedef struct PeerConnectionSrtpReceiver
 
 typedef struct PeerConnectionContext PeerConnectionContext_t;
 typedef struct PeerConnectionSession PeerConnectionSession_t;
+typedef struct PeerConnectionDtlsCertificate PeerConnectionDtlsCertificate_t;
 typedef struct PeerConnectionDataChannel PeerConnectionDataChannel_t;
 
+typedef PeerConnectionResult_t (* WriteVideoFrameFunc_t)( PeerConnectionSession_t * pSession,
+                                                          Transceiver_t * pTransceiver,
+                                                          const PeerConnectionFrame_t * pFrame );
+
 typedef void (* OnDataChannelMessageReceived_t)( PeerConnectionDataChannel_t * pDataChannel,
                                                  uint8_t isBinary,
                                                  uint8_t * pMessage,
                                                  uint32_t pMessageLen );
 
+typedef void (* OnDataChannelBufferedAmountLow_t)( PeerConnectionDataChannel_t * pDataChannel,
+                                                   void * pCustomContext );
+
 #if ENABLE_SCTP_DATA_CHANNEL
     typedef struct PeerConnectionDataChannel
     {
@@ -389,8 +501,22 @@ typedef void (* OnDataChannelMessageReceived_t)( PeerConnectionDataChannel_t * p
         void * onMessageCustomData;
         void * onOpenCustomData;
         OnDataChannelMessageReceived_t onDataChannelMessage;
+        OnDataChannelBufferedAmountLow_t onBufferedAmountLow;
+        void * pBufferedAmountLowCustomContext;
         struct PeerConnectionDataChannel * pxNext;
     } PeerConnectionDataChannel_t;
+
+    /* A data channel callback raised while the SCTP task processes a packet,
+     * it is run once the task has released sctpSessionMutex. */
+    typedef struct PeerConnectionSctpEvent
+    {
+        struct PeerConnectionSctpEvent * pNext;
+        uint16_t channelId;
+        uint8_t isBufferedAmountLow;
+        uint8_t isBinary;
+        uint32_t messageLength;
+        uint8_t message[];
+    } PeerConnectionSctpEvent_t;
 #endif /* ENABLE_SCTP_DATA_CHANNEL */
 
 typedef struct PeerConnectionSession
@@ -405,6 +531,11 @@ typedef struct PeerConnectionSession
      * (username/password) are obtained from SDP. */
     int startupBarrier;
 
+    /* The local user name/password used by this session. They're re-generated on ICE restart. */
+    char localUserName[ PEER_CONNECTION_USER_NAME_LENGTH + 1 ];
+    char localPassword[ PEER_CONNECTION_PASSWORD_LENGTH + 1 ];
+    /* Set while ICE is restarting with new credentials, DTLS and SRTP sessions are kept. */
+    uint8_t isIceRestarting;
     /* The remote user name, representing the remote peer, from SDP message. */
     char remoteUserName[ PEER_CONNECTION_USER_NAME_LENGTH + 1 ];
     /* The remote password, representing password of the remote peer, from SDP message. */
@@ -425,10 +556,10 @@ typedef struct PeerConnectionSession
 
     /* DTLS session. */
     DtlsSession_t dtlsSession;
-    /* SRTP sessions. */
-    pthread_mutex_t srtpSessionMutex;
-    srtp_t srtpTransmitSession;
-    srtp_t srtpReceiveSession;
+    /* The certificate pinned by this session, its fingerprint is the one in local SDP. */
+    PeerConnectionDtlsCertificate_t * pDtlsCertificate;
+    /* SRTP sessions, indexed by PeerConnectionSrtpPath_t. */
+    PeerConnectionSrtpSession_t srtpSessions[ PEER_CONNECTION_SRTP_PATH_MAX ];
     /* RTP config. */
     PeerConnectionRtpConfig_t rtpConfig;
     /* Store the original transceiver setting. */
@@ -437,14 +568,29 @@ typedef struct PeerConnectionSession
     /* Store the transceiver sequence to match m-lines. */
     const Transceiver_t * pMLinesTransceivers[ PEER_CONNECTION_TRANSCEIVER_MAX_COUNT ];
     uint32_t mLinesTransceiverCount;
-    /* Remote SDP description. */
-    char remoteSdpBuffer[ PEER_CONNECTION_SDP_DESCRIPTION_BUFFER_MAX_LENGTH ];
+    /* Remote SDP description, the parsed description points into its buffer.
+     * A new remote SDP is parsed into the pending buffer and swapped in with
+     * remoteSdpMutex held once it is valid, so the current description never
+     * points into a buffer being reallocated. Both are freed on close. */
+    char * pRemoteSdpBuffer;
+    size_t remoteSdpBufferSize;
     PeerConnectionBufferSessionDescription_t remoteSessionDescription;
+    char * pPendingRemoteSdpBuffer;
+    size_t pendingRemoteSdpBufferSize;
+    PeerConnectionBufferSessionDescription_t pendingRemoteSessionDescription;
+    pthread_mutex_t remoteSdpMutex;
 
     /* PLI callback and context */
     OnPictureLossIndicationCallback_t onPictureLossIndicationCallback;
     void * pPictureLossIndicationUserContext;
 
+    /* Keyframe request callback and context */
+    OnKeyFrameRequestCallback_t onKeyFrameRequestCallback;
+    void * pKeyFrameRequestUserContext;
+    PeerConnectionVideoResync_t videoResync;
+    /* Set when the connection gets ready, the first video frame sent replays the cached keyframe. */
+    uint8_t isKeyFrameReplayPending;
+
     #if ENABLE_SCTP_DATA_CHANNEL
         uint8_t ucEnableDataChannelLocal;
         uint8_t ucEnableDataChannelRemote;
@@ -453,6 +599,17 @@ typedef struct PeerConnectionSession
         /* Data channel configs */
         PeerConnectionDataChannel_t * pDataChannels;
         uint32_t uKvsDataChannelCount;
+
+        /* Inbound SCTP packets are processed by a dedicated task, so data channel
+         * bursts and callbacks never hold up media on the socket listener. */
+        pthread_t pSctpTask;
+        SctpReceiveQueue_t sctpReceiveQueue;
+        /* Serializes the SCTP task with session allocation and teardown. */
+        pthread_mutex_t sctpSessionMutex;
+        uint8_t isSctpSessionReady;
+        /* Callbacks deferred by the SCTP task, only touched by that task. */
+        PeerConnectionSctpEvent_t * pSctpEventHead;
+        PeerConnectionSctpEvent_t * pSctpEventTail;
     #endif /* ENABLE_SCTP_DATA_CHANNEL */
 
     PeerConnectionSrtpSender_t videoSrtpSender;
@@ -498,15 +655,115 @@ typedef struct PeerConnectionSessionConfiguration
 /*
  * Peer connection general instances.
  */
-typedef struct PeerConnectionDtlsContext
+typedef struct PeerConnectionDtlsCertificate
 {
-    uint8_t isInitialized;
+    uint8_t isValid;
+    /* Number of sessions still using this certificate. */
+    uint32_t refCount;
+    /* Monotonic time in seconds to replace this certificate for new sessions. */
+    uint64_t rotateTimeSec;
     mbedtls_x509_crt localCert;
     mbedtls_pk_context localKey;
     char localCertFingerprint[CERTIFICATE_FINGERPRINT_LENGTH];
+    /* SSL configuration shared by all DTLS sessions using this certificate. */
+    DtlsSharedConfig_t sharedConfig;
+} PeerConnectionDtlsCertificate_t;
+
+typedef struct PeerConnectionDtlsContext
+{
+    uint8_t isInitialized;
+    /* Protects certificates, pActiveCertificate and reference counts. */
+    pthread_mutex_t certificateMutex;
+    pthread_cond_t certificateReadyCond;
+    /* Wakes the certificate task on the monotonic clock, for rotation, a freed slot or shutdown. */
+    pthread_cond_t certificateTaskCond;
+    uint8_t isShutdown;
+    pthread_t certificateTask;
+    /* One slot serves new sessions while the other one is generated or retired. */
+    PeerConnectionDtlsCertificate_t certificates[ PEER_CONNECTION_DTLS_CERTIFICATE_SLOT_COUNT ];
+    PeerConnectionDtlsCertificate_t * pActiveCertificate;
     unsigned char privateKeyPcsPem[PRIVATE_KEY_PCS_PEM_SIZE];
 } PeerConnectionDtlsContext_t;
 
+/* Keyframe shared by all sessions, freed when the cache and the last session release it. */
+typedef struct PeerConnectionCachedFrame
+{
+    uint32_t refCount;
+    uint64_t presentationUs;
+    size_t dataLength;
+    uint8_t data[];
+} PeerConnectionCachedFrame_t;
+
+typedef struct PeerConnectionKeyFrameCacheEntry
+{
+    char trackId[ TRANSCEIVER_TRACK_ID_MAX_LENGTH ];
+    size_t trackIdLength;
+    PeerConnectionCachedFrame_t * pKeyFrame;
+    uint8_t parameterSets[ PEER_CONNECTION_KEYFRAME_CACHE_PARAMETER_SETS_MAX_LENGTH ];
+    size_t parameterSetsLength;
+} PeerConnectionKeyFrameCacheEntry_t;
+
+typedef struct PeerConnectionKeyFrameCache
+{
+    uint8_t isInitialized;
+    /* Protects entries, sessions hold their own reference while sending a cached frame. */
+    pthread_mutex_t cacheMutex;
+    PeerConnectionKeyFrameCacheEntry_t entries[ PEER_CONNECTION_KEYFRAME_CACHE_MAX_TRACK_NUM ];
+    uint32_t entryCount;
+} PeerConnectionKeyFrameCache_t;
+
+typedef enum PeerConnectionSdpTemplateSlotType
+{
+    PEER_CONNECTION_SDP_TEMPLATE_SLOT_SESSION_ID = 0,
+    PEER_CONNECTION_SDP_TEMPLATE_SLOT_USER_NAME,
+    PEER_CONNECTION_SDP_TEMPLATE_SLOT_PASSWORD,
+    PEER_CONNECTION_SDP_TEMPLATE_SLOT_SSRC,
+    PEER_CONNECTION_SDP_TEMPLATE_SLOT_RTX_SSRC,
+} PeerConnectionSdpTemplateSlotType_t;
+
+/* A per-session value cut out of the template, inserted at offset of the template text. */
+typedef struct PeerConnectionSdpTemplateSlot
+{
+    PeerConnectionSdpTemplateSlotType_t type;
+    uint32_t mLineIndex;
+    size_t offset;
+} PeerConnectionSdpTemplateSlot_t;
+
+/* Serialized answer with the per-session values removed. */
+typedef struct PeerConnectionSdpTemplate
+{
+    uint64_t key;
+    char * pText;
+    size_t textLength;
+    PeerConnectionSdpTemplateSlot_t slots[ PEER_CONNECTION_SDP_TEMPLATE_MAX_SLOT_COUNT ];
+    uint32_t slotCount;
+} PeerConnectionSdpTemplate_t;
+
+/* The values filled into the slots of a template. */
+typedef struct PeerConnectionSdpTemplateValues
+{
+    uint64_t sessionId;
+    const char * pUserName;
+    size_t userNameLength;
+    const char * pPassword;
+    size_t passwordLength;
+    uint32_t ssrc[ PEER_CONNECTION_TRANSCEIVER_MAX_COUNT ];
+    uint32_t rtxSsrc[ PEER_CONNECTION_TRANSCEIVER_MAX_COUNT ];
+} PeerConnectionSdpTemplateValues_t;
+
+typedef struct PeerConnectionSdpTemplateCache
+{
+    uint8_t isInitialized;
+    /* Protects templates, answers are rendered with the mutex held. */
+    pthread_mutex_t cacheMutex;
+    PeerConnectionSdpTemplate_t templates[ PEER_CONNECTION_SDP_TEMPLATE_MAX_COUNT ];
+    uint32_t templateCount;
+    /* Templates are replaced round robin once the cache is full. */
+    uint32_t nextReplaceIndex;
+    uint64_t hitCount;
+    uint64_t missCount;
+} PeerConnectionSdpTemplateCache_t;
+
 typedef struct PeerConnectionContext
 {
     uint8_t isInited;
@@ -519,6 +776,10 @@ typedef struct PeerConnectionContext
     PeerConnectionDtlsContext_t dtlsContext;
     RtpContext_t rtpContext;
     RtcpContext_t rtcpContext;
+    /* Most recent keyframe of each video track, replayed to new viewers. */
+    PeerConnectionKeyFrameCache_t keyFrameCache;
+    /* Answers already serialized for an offer of the same shape. */
+    PeerConnectionSdpTemplateCache_t sdpTemplateCache;
 
     #if ENABLE_TWCC_SUPPORT
         RtcpTwccManager_t rtcpTwccManager;
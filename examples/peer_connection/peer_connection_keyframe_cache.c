@@ -0,0 +1,281 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "logging.h"
+#include "peer_connection_keyframe_cache.h"
+
+/*-----------------------------------------------------------*/
+
+/* Find the entry of the track, or allocate a new one if isCreate is set. Called with cache mutex held. */
+static PeerConnectionKeyFrameCacheEntry_t * GetCacheEntry( PeerConnectionKeyFrameCache_t * pCache,
+                                                           const Transceiver_t * pTransceiver,
+                                                           uint8_t isCreate )
+{
+    PeerConnectionKeyFrameCacheEntry_t * pEntry = NULL;
+    uint32_t i;
+
+    for( i = 0; i < pCache->entryCount; i++ )
+    {
+        if( ( pCache->entries[ i ].trackIdLength == pTransceiver->trackIdLength ) &&
+            ( memcmp( pCache->entries[ i ].trackId,
+                      pTransceiver->trackId,
+                      pTransceiver->trackIdLength ) == 0 ) )
+        {
+            pEntry = &pCache->entries[ i ];
+            break;
+        }
+    }
+
+    if( ( pEntry == NULL ) &&
+        ( isCreate != 0U ) &&
+        ( pCache->entryCount < PEER_CONNECTION_KEYFRAME_CACHE_MAX_TRACK_NUM ) &&
+        ( pTransceiver->trackIdLength <= sizeof( pEntry->trackId ) ) )
+    {
+        pEntry = &pCache->entries[ pCache->entryCount++ ];
+        memcpy( pEntry->trackId,
+                pTransceiver->trackId,
+                pTransceiver->trackIdLength );
+        pEntry->trackIdLength = pTransceiver->trackIdLength;
+        pEntry->pKeyFrame = NULL;
+        pEntry->parameterSetsLength = 0;
+    }
+
+    return pEntry;
+}
+
+PeerConnectionResult_t PeerConnectionKeyFrameCache_Init( PeerConnectionKeyFrameCache_t * pCache )
+{
+    PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
+
+    if( pCache == NULL )
+    {
+        LogError( ( "Invalid input, pCache: %p", pCache ) );
+        ret = PEER_CONNECTION_RESULT_BAD_PARAMETER;
+    }
+
+    if( ( ret == PEER_CONNECTION_RESULT_OK ) &&
+        ( pCache->isInitialized == 0U ) )
+    {
+        memset( pCache,
+                0,
+                sizeof( PeerConnectionKeyFrameCache_t ) );
+
+        if( pthread_mutex_init( &pCache->cacheMutex,
+                                NULL ) != 0 )
+        {
+            LogError( ( "Fail to create keyframe cache mutex" ) );
+            ret = PEER_CONNECTION_RESULT_FAIL_CREATE_KEYFRAME_CACHE_MUTEX;
+        }
+        else
+        {
+            pCache->isInitialized = 1U;
+        }
+    }
+
+    return ret;
+}
+
+PeerConnectionResult_t PeerConnectionKeyFrameCache_Update( PeerConnectionKeyFrameCache_t * pCache,
+                                                           const Transceiver_t * pTransceiver,
+                                                           const PeerConnectionFrame_t * pFrame,
+                                                           uint8_t isKeyFrame,
+                                                           const uint8_t * pParameterSets,
+                                                           size_t parameterSetsLength )
+{
+    PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
+    PeerConnectionKeyFrameCacheEntry_t * pEntry = NULL;
+    PeerConnectionCachedFrame_t * pKeyFrame = NULL;
+    PeerConnectionCachedFrame_t * pOldKeyFrame = NULL;
+    size_t prependLength = 0;
+    uint8_t isLocked = 0U;
+
+    if( ( pCache == NULL ) ||
+        ( pTransceiver == NULL ) ||
+        ( pFrame == NULL ) ||
+        ( ( pParameterSets == NULL ) && ( parameterSetsLength > 0U ) ) )
+    {
+        LogError( ( "Invalid input, pCache: %p, pTransceiver: %p, pFrame: %p, pParameterSets: %p", pCache, pTransceiver, pFrame, pParameterSets ) );
+        ret = PEER_CONNECTION_RESULT_BAD_PARAMETER;
+    }
+    else if( pCache->isInitialized == 0U )
+    {
+        LogError( ( "Keyframe cache is not initialized" ) );
+        ret = PEER_CONNECTION_RESULT_BAD_PARAMETER;
+    }
+    else if( parameterSetsLength > PEER_CONNECTION_KEYFRAME_CACHE_PARAMETER_SETS_MAX_LENGTH )
+    {
+        LogWarn( ( "Parameter sets too large to cache, length: %lu", parameterSetsLength ) );
+        ret = PEER_CONNECTION_RESULT_FAIL_KEYFRAME_CACHE_PARAMETER_SETS_TOO_LARGE;
+    }
+    else
+    {
+        /* Empty else marker. */
+    }
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        if( pthread_mutex_lock( &pCache->cacheMutex ) == 0 )
+        {
+            isLocked = 1U;
+        }
+        else
+        {
+            LogError( ( "Fail to take keyframe cache mutex" ) );
+            ret = PEER_CONNECTION_RESULT_FAIL_TAKE_KEYFRAME_CACHE_MUTEX;
+        }
+    }
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        pEntry = GetCacheEntry( pCache,
+                                pTransceiver,
+                                1U );
+        if( pEntry == NULL )
+        {
+            LogWarn( ( "No free keyframe cache for track: %.*s", ( int ) pTransceiver->trackIdLength, pTransceiver->trackId ) );
+            ret = PEER_CONNECTION_RESULT_NO_FREE_KEYFRAME_CACHE;
+        }
+        else
+        {
+            if( parameterSetsLength > 0U )
+            {
+                /* Sources sending parameter sets out-of-band only repeat them when they change. */
+                memcpy( pEntry->parameterSets,
+                        pParameterSets,
+                        parameterSetsLength );
+                pEntry->parameterSetsLength = parameterSetsLength;
+            }
+
+            if( ( isKeyFrame == 0U ) ||
+                ( ( pEntry->pKeyFrame != NULL ) &&
+                  ( pEntry->pKeyFrame->presentationUs == pFrame->presentationUs ) ) )
+            {
+                pEntry = NULL;
+            }
+            else if( parameterSetsLength == 0U )
+            {
+                /* A viewer can't decode the keyframe without parameter sets, so replay it with the latest ones. */
+                prependLength = pEntry->parameterSetsLength;
+            }
+            else
+            {
+                /* Empty else marker. */
+            }
+        }
+    }
+
+    if( ( ret == PEER_CONNECTION_RESULT_OK ) && ( pEntry != NULL ) )
+    {
+        pKeyFrame = ( PeerConnectionCachedFrame_t * ) malloc( sizeof( PeerConnectionCachedFrame_t ) + prependLength + pFrame->dataLength );
+        if( pKeyFrame == NULL )
+        {
+            LogError( ( "Fail to allocate cached keyframe, size: %lu", prependLength + pFrame->dataLength ) );
+            ret = PEER_CONNECTION_RESULT_FAIL_KEYFRAME_CACHE_NO_ENOUGH_MEMORY;
+        }
+        else
+        {
+            /* The cache holds one reference. */
+            pKeyFrame->refCount = 1U;
+            pKeyFrame->presentationUs = pFrame->presentationUs;
+            pKeyFrame->dataLength = prependLength + pFrame->dataLength;
+            memcpy( pKeyFrame->data,
+                    pEntry->parameterSets,
+                    prependLength );
+            memcpy( &pKeyFrame->data[ prependLength ],
+                    pFrame->pData,
+                    pFrame->dataLength );
+
+            pOldKeyFrame = pEntry->pKeyFrame;
+            pEntry->pKeyFrame = pKeyFrame;
+        }
+    }
+
+    if( isLocked != 0U )
+    {
+        pthread_mutex_unlock( &pCache->cacheMutex );
+    }
+
+    if( pOldKeyFrame != NULL )
+    {
+        PeerConnectionKeyFrameCache_Release( pOldKeyFrame );
+    }
+
+    return ret;
+}
+
+PeerConnectionResult_t PeerConnectionKeyFrameCache_Acquire( PeerConnectionKeyFrameCache_t * pCache,
+                                                            const Transceiver_t * pTransceiver,
+                                                            uint64_t presentationUs,
+                                                            PeerConnectionCachedFrame_t ** ppKeyFrame )
+{
+    PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
+    PeerConnectionKeyFrameCacheEntry_t * pEntry = NULL;
+
+    if( ( pCache == NULL ) ||
+        ( pTransceiver == NULL ) ||
+        ( ppKeyFrame == NULL ) )
+    {
+        LogError( ( "Invalid input, pCache: %p, pTransceiver: %p, ppKeyFrame: %p", pCache, pTransceiver, ppKeyFrame ) );
+        ret = PEER_CONNECTION_RESULT_BAD_PARAMETER;
+    }
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        *ppKeyFrame = NULL;
+
+        if( pthread_mutex_lock( &pCache->cacheMutex ) == 0 )
+        {
+            pEntry = GetCacheEntry( pCache,
+                                    pTransceiver,
+                                    0U );
+            if( ( pEntry == NULL ) || ( pEntry->pKeyFrame == NULL ) )
+            {
+                /* Nothing cached yet. */
+            }
+            else if( ( pEntry->pKeyFrame->presentationUs > presentationUs ) ||
+                     ( presentationUs - pEntry->pKeyFrame->presentationUs > PEER_CONNECTION_KEYFRAME_CACHE_MAX_AGE_US ) )
+            {
+                LogDebug( ( "Cached keyframe is stale, cached at: %lu us, now: %lu us", pEntry->pKeyFrame->presentationUs, presentationUs ) );
+            }
+            else
+            {
+                __atomic_add_fetch( &pEntry->pKeyFrame->refCount, 1U, __ATOMIC_RELAXED );
+                *ppKeyFrame = pEntry->pKeyFrame;
+            }
+
+            pthread_mutex_unlock( &pCache->cacheMutex );
+        }
+        else
+        {
+            LogError( ( "Fail to take keyframe cache mutex" ) );
+            ret = PEER_CONNECTION_RESULT_FAIL_TAKE_KEYFRAME_CACHE_MUTEX;
+        }
+    }
+
+    return ret;
+}
+
+void PeerConnectionKeyFrameCache_Release( PeerConnectionCachedFrame_t * pKeyFrame )
+{
+    if( ( pKeyFrame != NULL ) &&
+        ( __atomic_sub_fetch( &pKeyFrame->refCount, 1U, __ATOMIC_ACQ_REL ) == 0U ) )
+    {
+        free( pKeyFrame );
+    }
+}
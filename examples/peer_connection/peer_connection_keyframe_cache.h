@@ -0,0 +1,59 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PEER_CONNECTION_KEYFRAME_CACHE_H
+#define PEER_CONNECTION_KEYFRAME_CACHE_H
+
+#pragma once
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+extern "C" {
+#endif
+/* *INDENT-ON* */
+
+/* Standard includes. */
+#include <stdint.h>
+
+#include "peer_connection_data_types.h"
+
+PeerConnectionResult_t PeerConnectionKeyFrameCache_Init( PeerConnectionKeyFrameCache_t * pCache );
+
+/* Remember the parameter sets found in the frame, and replace the cached keyframe of the track if it is one.
+ * A keyframe without parameter sets is cached with the latest ones seen on the track. */
+PeerConnectionResult_t PeerConnectionKeyFrameCache_Update( PeerConnectionKeyFrameCache_t * pCache,
+                                                           const Transceiver_t * pTransceiver,
+                                                           const PeerConnectionFrame_t * pFrame,
+                                                           uint8_t isKeyFrame,
+                                                           const uint8_t * pParameterSets,
+                                                           size_t parameterSetsLength );
+
+/* Take a reference to the cached keyframe of the track, *ppKeyFrame is NULL if nothing cached yet,
+ * or if the keyframe is more than PEER_CONNECTION_KEYFRAME_CACHE_MAX_AGE_US older than presentationUs. */
+PeerConnectionResult_t PeerConnectionKeyFrameCache_Acquire( PeerConnectionKeyFrameCache_t * pCache,
+                                                            const Transceiver_t * pTransceiver,
+                                                            uint64_t presentationUs,
+                                                            PeerConnectionCachedFrame_t ** ppKeyFrame );
+
+void PeerConnectionKeyFrameCache_Release( PeerConnectionCachedFrame_t * pKeyFrame );
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+}
+#endif
+/* *INDENT-ON* */
+
+#endif /* PEER_CONNECTION_KEYFRAME_CACHE_H */
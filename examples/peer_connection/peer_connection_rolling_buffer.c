@@ -153,8 +153,9 @@ PeerConnectionResult_t PeerConnectionRollingBuffer_GetRtpSequenceBuffer( PeerCon
     }
     else
     {
-        *ppPacket = ( PeerConnectionRollingBufferPacket_t * )malloc( sizeof( PeerConnectionRollingBufferPacket_t ) + pRollingBuffer->maxSizePerPacket );
-        ( *ppPacket )->pPacketBuffer = ( uint8_t * )( ( *ppPacket ) + 1 );
+        /* Reserve headroom in front of packet buffer, so the TURN channel data header can be written in place while sending. */
+        *ppPacket = ( PeerConnectionRollingBufferPacket_t * )malloc( sizeof( PeerConnectionRollingBufferPacket_t ) + ICE_CONTROLLER_SEND_HEADROOM_LENGTH + pRollingBuffer->maxSizePerPacket );
+        ( *ppPacket )->pPacketBuffer = ( uint8_t * )( ( *ppPacket ) + 1 ) + ICE_CONTROLLER_SEND_HEADROOM_LENGTH;
         ( *ppPacket )->packetBufferLength = pRollingBuffer->maxSizePerPacket;
     }
 
@@ -16,13 +16,22 @@
 
 #if ENABLE_SCTP_DATA_CHANNEL
 
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <unistd.h>
 
 #include "ice_controller_data_types.h"
 #include "peer_connection_sctp.h"
 /*-----------------------------------------------------------*/
 
+#define PEER_CONNECTION_SCTP_TASK_NAME "PcSctpTsk"
+
+/* The SCTP task backs off this long if it can't pop the receive queue. */
+#define PEER_CONNECTION_SCTP_POP_RETRY_DELAY_US ( 10000 )
+/*-----------------------------------------------------------*/
+
 static PeerConnectionDataChannel_t globalDataChannels[MAX_SCTP_DATA_CHANNELS];
 static int uKVSDataChannelCount = 0;
 /*-----------------------------------------------------------*/
@@ -41,6 +50,18 @@ static void OnSCTPSessionDataChannelMessage( void * customData,
                                              uint32_t pMessageLen );
 static SctpUtilsResult_t OnSCTPSessionDataChannelAckOpen( void * customData,
                                                           uint16_t channelId );
+static void OnSCTPSessionDataChannelBufferedAmountLow( void * customData,
+                                                       uint16_t channelId );
+PeerConnectionDataChannel_t * pxGetDataChannelWithID( PeerConnectionSession_t * pSession,
+                                                      uint32_t channelId );
+static void QueueSctpEvent( PeerConnectionSession_t * pSession,
+                            uint16_t channelId,
+                            uint8_t isBufferedAmountLow,
+                            uint8_t isBinary,
+                            const uint8_t * pMessage,
+                            uint32_t messageLength );
+static void RunSctpEvents( PeerConnectionSession_t * pSession );
+static void * PeerConnectionSCTP_Task( void * pParameter );
 
 /*-----------------------------------------------------------*/
 
@@ -191,6 +212,7 @@ PeerConnectionResult_t PeerConnectionSCTP_DataChannelSend( PeerConnectionDataCha
 {
     PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
     SctpSession_t * pSctpSession;
+    SctpUtilsResult_t retSctp;
 
 
     if( ( pMessage == NULL ) || ( pChannel == NULL ) )
@@ -203,11 +225,87 @@ PeerConnectionResult_t PeerConnectionSCTP_DataChannelSend( PeerConnectionDataCha
 
         pSctpSession = &( pChannel->pPeerConnection->sctpSession );
 
-        if( Sctp_SendMessage( pSctpSession, &( pChannel->dataChannel ), isBinary, pMessage, pMessageLen ) != SCTP_UTILS_RESULT_OK )
+        /* The message is queued if the SCTP send buffer is full, it never
+         * blocks the caller. */
+        retSctp = Sctp_SendMessage( pSctpSession, &( pChannel->dataChannel ), isBinary, pMessage, pMessageLen );
+        if( retSctp == SCTP_UTILS_RESULT_MESSAGE_TOO_LARGE )
+        {
+            ret = PEER_CONNECTION_RESULT_FAIL_SCTP_MESSAGE_TOO_LARGE;
+        }
+        else if( retSctp == SCTP_UTILS_RESULT_SEND_QUEUE_FULL )
+        {
+            ret = PEER_CONNECTION_RESULT_FAIL_SCTP_SEND_QUEUE_FULL;
+        }
+        else if( retSctp != SCTP_UTILS_RESULT_OK )
         {
             LogError( ( "SCTP_WriteMessageSCTPSession error" ) );
             ret = PEER_CONNECTION_RESULT_FAIL_SCTP_WRITE;
         }
+        else
+        {
+            /* Empty else marker. */
+        }
+    }
+
+    return ret;
+}
+/*-----------------------------------------------------------*/
+
+PeerConnectionResult_t PeerConnectionSCTP_GetBufferedAmount( PeerConnectionDataChannel_t * pChannel,
+                                                             size_t * pBufferedAmount )
+{
+    PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
+
+    if( ( pChannel == NULL ) || ( pBufferedAmount == NULL ) )
+    {
+        LogError( ( "Invalid input, pChannel: %p, pBufferedAmount: %p", pChannel, pBufferedAmount ) );
+        ret = PEER_CONNECTION_RESULT_BAD_PARAMETER;
+    }
+    else if( Sctp_GetBufferedAmount( &( pChannel->pPeerConnection->sctpSession ),
+                                     &( pChannel->dataChannel ),
+                                     pBufferedAmount ) != SCTP_UTILS_RESULT_OK )
+    {
+        ret = PEER_CONNECTION_RESULT_FAIL_SCTP_GET_BUFFERED_AMOUNT;
+    }
+    else
+    {
+        /* Empty else marker. */
+    }
+
+    return ret;
+}
+/*-----------------------------------------------------------*/
+
+PeerConnectionResult_t PeerConnectionSCTP_SetBufferedAmountLowCallback( PeerConnectionDataChannel_t * pChannel,
+                                                                        size_t threshold,
+                                                                        OnDataChannelBufferedAmountLow_t onBufferedAmountLow,
+                                                                        void * pCustomContext )
+{
+    PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
+
+    if( pChannel == NULL )
+    {
+        LogError( ( "Invalid input, pChannel: %p", pChannel ) );
+        ret = PEER_CONNECTION_RESULT_BAD_PARAMETER;
+    }
+    else if( Sctp_SetBufferedAmountLowThreshold( &( pChannel->pPeerConnection->sctpSession ),
+                                                 &( pChannel->dataChannel ),
+                                                 threshold ) != SCTP_UTILS_RESULT_OK )
+    {
+        LogError( ( "Fail to set buffered amount low threshold" ) );
+        ret = PEER_CONNECTION_RESULT_FAIL_SCTP_SET_BUFFERED_AMOUNT_LOW;
+    }
+    else if( pthread_mutex_lock( &( pChannel->pPeerConnection->sctpSessionMutex ) ) == 0 )
+    {
+        /* The callback is read with sctpSessionMutex held when it's raised. */
+        pChannel->pBufferedAmountLowCustomContext = pCustomContext;
+        pChannel->onBufferedAmountLow = onBufferedAmountLow;
+        pthread_mutex_unlock( &( pChannel->pPeerConnection->sctpSessionMutex ) );
+    }
+    else
+    {
+        LogError( ( "Fail to take SCTP session mutex" ) );
+        ret = PEER_CONNECTION_RESULT_FAIL_SCTP_SET_BUFFERED_AMOUNT_LOW;
     }
 
     return ret;
@@ -256,21 +354,41 @@ PeerConnectionResult_t PeerConnectionSCTP_AllocateSCTP( PeerConnectionSession_t
 {
 
     PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_BAD_PARAMETER;
+    uint32_t remoteMaxMessageSize = SCTP_DEFAULT_REMOTE_MAX_MESSAGE_SIZE;
+
+    if( pthread_mutex_lock( &( pSession->remoteSdpMutex ) ) == 0 )
+    {
+        if( pSession->remoteSessionDescription.sdpDescription.quickAccess.isMaxMessageSizeSet != 0U )
+        {
+            remoteMaxMessageSize = pSession->remoteSessionDescription.sdpDescription.quickAccess.maxMessageSize;
+        }
+
+        pthread_mutex_unlock( &( pSession->remoteSdpMutex ) );
+    }
 
     /* Create the SCTP Session */
     pSession->sctpSession.sctpSessionCallbacks.outboundPacketCallback = OnSCTPSessionOutboundPacket;
     pSession->sctpSession.sctpSessionCallbacks.dataChannelMessageCallback = OnSCTPSessionDataChannelMessage;
     pSession->sctpSession.sctpSessionCallbacks.dataChannelOpenCallback = OnSCTPSessionDataChannelOpen;
     pSession->sctpSession.sctpSessionCallbacks.dataChannelOpenAckCallback = OnSCTPSessionDataChannelAckOpen;
+    pSession->sctpSession.sctpSessionCallbacks.dataChannelBufferedAmountLowCallback = OnSCTPSessionDataChannelBufferedAmountLow;
     pSession->sctpSession.sctpSessionCallbacks.pUserData = ( void * ) pSession;
 
+    if( pthread_mutex_lock( &( pSession->sctpSessionMutex ) ) != 0 )
+    {
+        LogError( ( "Fail to take SCTP session mutex" ) );
+    }
     /* TODO: As viewer is not supported currently this side is always DTLS
      * client. */
-    if( Sctp_CreateSession( &( pSession->sctpSession ), 0 ) == SCTP_UTILS_RESULT_OK )
+    else if( Sctp_CreateSession( &( pSession->sctpSession ), 0, remoteMaxMessageSize ) == SCTP_UTILS_RESULT_OK )
     {
         uint32_t ulChannelsCreateFailed = 0;
         PeerConnectionDataChannel_t * pxIterator = pSession->pDataChannels;
 
+        /* Let the SCTP task feed inbound packets once the data channels
+         * below are set up. */
+        pSession->isSctpSessionReady = 1U;
+
         /* Create the data channels initialized by the application, if any */
         while( pxIterator != NULL )
         {
@@ -306,6 +424,11 @@ PeerConnectionResult_t PeerConnectionSCTP_AllocateSCTP( PeerConnectionSession_t
             ret = PEER_CONNECTION_RESULT_OK;
         }
 
+        pthread_mutex_unlock( &( pSession->sctpSessionMutex ) );
+    }
+    else
+    {
+        pthread_mutex_unlock( &( pSession->sctpSessionMutex ) );
     }
 
 
@@ -314,17 +437,243 @@ PeerConnectionResult_t PeerConnectionSCTP_AllocateSCTP( PeerConnectionSession_t
 }
 /*-----------------------------------------------------------*/
 
-/* Decrypt the incoming DTLS packet and feed it to the SCTP stack. */
+/* Hand a decrypted SCTP packet over to the SCTP task. This runs on the socket
+ * listener, so it never blocks. The queue holds a full receive window, packets
+ * are only dropped if the remote overruns it. */
 void PeerConnectionSCTP_ProcessSCTPData( PeerConnectionSession_t * pSession,
                                          uint8_t * receiveBuffer,
                                          int readBytes )
 {
+    SctpUtilsResult_t retSctp;
+
+    if( ( readBytes <= 0 ) || ( readBytes > PEER_CONNECTION_SCTP_MAX_PACKET_LENGTH ) )
+    {
+        LogWarn( ( "Drop SCTP packet with unexpected length: %d", readBytes ) );
+    }
+    else
+    {
+        retSctp = Sctp_PushReceivedPacket( &( pSession->sctpReceiveQueue ),
+                                           receiveBuffer,
+                                           ( uint32_t ) readBytes );
+        if( retSctp == SCTP_UTILS_RESULT_RECEIVE_QUEUE_FULL )
+        {
+            LogDebug( ( "SCTP receive queue is full, dropped packets: %u", ( unsigned int ) pSession->sctpReceiveQueue.droppedPackets ) );
+        }
+        else if( retSctp != SCTP_UTILS_RESULT_OK )
+        {
+            LogWarn( ( "Fail to queue SCTP packet, result: %d", retSctp ) );
+        }
+        else
+        {
+            /* Empty else marker. */
+        }
+    }
+
+}
+/*-----------------------------------------------------------*/
+
+/* Keep a data channel callback raised on the SCTP task, sctpSessionMutex is
+ * held there and the application may send or close channels from it. */
+static void QueueSctpEvent( PeerConnectionSession_t * pSession,
+                            uint16_t channelId,
+                            uint8_t isBufferedAmountLow,
+                            uint8_t isBinary,
+                            const uint8_t * pMessage,
+                            uint32_t messageLength )
+{
+    PeerConnectionSctpEvent_t * pEvent;
+
+    pEvent = ( PeerConnectionSctpEvent_t * ) malloc( sizeof( PeerConnectionSctpEvent_t ) + messageLength );
+    if( pEvent == NULL )
+    {
+        LogError( ( "Fail to allocate SCTP event, dropped message of length: %u", ( unsigned int ) messageLength ) );
+    }
+    else
+    {
+        pEvent->pNext = NULL;
+        pEvent->channelId = channelId;
+        pEvent->isBufferedAmountLow = isBufferedAmountLow;
+        pEvent->isBinary = isBinary;
+        pEvent->messageLength = messageLength;
+        if( messageLength > 0U )
+        {
+            memcpy( &( pEvent->message[ 0 ] ), pMessage, messageLength );
+        }
+
+        if( pSession->pSctpEventTail == NULL )
+        {
+            pSession->pSctpEventHead = pEvent;
+        }
+        else
+        {
+            pSession->pSctpEventTail->pNext = pEvent;
+        }
+        pSession->pSctpEventTail = pEvent;
+    }
+}
+/*-----------------------------------------------------------*/
+
+/* Run the callbacks queued while processing a packet, without sctpSessionMutex. */
+static void RunSctpEvents( PeerConnectionSession_t * pSession )
+{
+    PeerConnectionSctpEvent_t * pEvent;
+    PeerConnectionDataChannel_t * pChannel;
+    OnDataChannelMessageReceived_t onDataChannelMessage;
+    OnDataChannelBufferedAmountLow_t onBufferedAmountLow;
+    void * pBufferedAmountLowCustomContext;
+
+    while( pSession->pSctpEventHead != NULL )
+    {
+        pEvent = pSession->pSctpEventHead;
+        pSession->pSctpEventHead = pEvent->pNext;
+        if( pSession->pSctpEventHead == NULL )
+        {
+            pSession->pSctpEventTail = NULL;
+        }
+
+        pChannel = NULL;
+        onDataChannelMessage = NULL;
+        onBufferedAmountLow = NULL;
+        pBufferedAmountLowCustomContext = NULL;
+
+        /* The channel may have been closed since the event was raised. */
+        if( pthread_mutex_lock( &( pSession->sctpSessionMutex ) ) == 0 )
+        {
+            if( pSession->isSctpSessionReady != 0U )
+            {
+                pChannel = pxGetDataChannelWithID( pSession, pEvent->channelId );
+            }
+
+            if( pChannel != NULL )
+            {
+                onDataChannelMessage = pChannel->onDataChannelMessage;
+                onBufferedAmountLow = pChannel->onBufferedAmountLow;
+                pBufferedAmountLowCustomContext = pChannel->pBufferedAmountLowCustomContext;
+            }
+
+            pthread_mutex_unlock( &( pSession->sctpSessionMutex ) );
+        }
+
+        if( pChannel == NULL )
+        {
+            LogWarn( ( "Drop SCTP event for closed channel: %u", ( unsigned int ) pEvent->channelId ) );
+        }
+        else if( pEvent->isBufferedAmountLow != 0U )
+        {
+            if( onBufferedAmountLow != NULL )
+            {
+                onBufferedAmountLow( pChannel, pBufferedAmountLowCustomContext );
+            }
+        }
+        else if( onDataChannelMessage != NULL )
+        {
+            onDataChannelMessage( pChannel, pEvent->isBinary, &( pEvent->message[ 0 ] ), pEvent->messageLength );
+        }
+        else
+        {
+            LogError( ( "No message handler found for channel: %u", ( unsigned int ) pEvent->channelId ) );
+        }
+
+        free( pEvent );
+    }
+}
+/*-----------------------------------------------------------*/
+
+/* Feed queued SCTP packets to the SCTP stack. The data channel callbacks
+ * raised by a packet run on this task once sctpSessionMutex is released. */
+static void * PeerConnectionSCTP_Task( void * pParameter )
+{
+    PeerConnectionSession_t * pSession = ( PeerConnectionSession_t * ) pParameter;
+    SctpReceivedPacket_t * pReceived;
+
+    for( ; ; )
+    {
+        pReceived = Sctp_PopReceivedPacket( &( pSession->sctpReceiveQueue ) );
+        if( pReceived == NULL )
+        {
+            /* The pop blocks until a packet arrives, it only fails if the
+             * queue mutex does, so back off instead of spinning on it. */
+            LogError( ( "Fail to receive SCTP packet from receive queue" ) );
+            usleep( PEER_CONNECTION_SCTP_POP_RETRY_DELAY_US );
+            continue;
+        }
+
+        if( pthread_mutex_lock( &( pSession->sctpSessionMutex ) ) == 0 )
+        {
+            /* Packets queued before teardown are dropped here. */
+            if( ( pSession->isSctpSessionReady != 0U ) &&
+                ( Sctp_ProcessMessage( &( pSession->sctpSession ),
+                                       pReceived->packet,
+                                       pReceived->packetLength ) != SCTP_UTILS_RESULT_OK ) )
+            {
+                LogWarn( ( "Failed to process SCTP packet" ) );
+            }
+
+            pthread_mutex_unlock( &( pSession->sctpSessionMutex ) );
+        }
+
+        free( pReceived );
+
+        RunSctpEvents( pSession );
+    }
+
+    return NULL;
+}
+/*-----------------------------------------------------------*/
+
+PeerConnectionResult_t PeerConnectionSCTP_InitSession( PeerConnectionSession_t * pSession,
+                                                       uint32_t initSeq )
+{
+    PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
+    char tempName[ 20 ];
+
+    if( pSession == NULL )
+    {
+        LogError( ( "Invalid input, pSession: %p", pSession ) );
+        ret = PEER_CONNECTION_RESULT_BAD_PARAMETER;
+    }
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        pSession->isSctpSessionReady = 0U;
+
+        if( pthread_mutex_init( &( pSession->sctpSessionMutex ),
+                                NULL ) != 0 )
+        {
+            LogError( ( "Fail to create SCTP session mutex" ) );
+            ret = PEER_CONNECTION_RESULT_FAIL_CREATE_SCTP_MUTEX;
+        }
+    }
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        if( Sctp_InitReceiveQueue( &( pSession->sctpReceiveQueue ),
+                                   SCTP_MAX_RECEIVE_QUEUE_SIZE ) != SCTP_UTILS_RESULT_OK )
+        {
+            LogError( ( "Fail to create SCTP receive queue" ) );
+            ret = PEER_CONNECTION_RESULT_FAIL_SCTP_RECEIVE_QUEUE_INIT;
+        }
+    }
 
-    if( Sctp_ProcessMessage( &( pSession->sctpSession ), receiveBuffer, readBytes ) != SCTP_UTILS_RESULT_OK )
+    if( ret == PEER_CONNECTION_RESULT_OK )
     {
-        LogWarn( ( "Failed to process SCTP packet" ) );
+        ( void ) snprintf( tempName,
+                           sizeof( tempName ),
+                           "%s%02u",
+                           PEER_CONNECTION_SCTP_TASK_NAME,
+                           ( unsigned int ) initSeq );
+
+        if( pthread_create( &( pSession->pSctpTask ),
+                            NULL,
+                            PeerConnectionSCTP_Task,
+                            pSession ) != 0 )
+        {
+            LogError( ( "pthread_create(%s) failed", tempName ) );
+            ret = PEER_CONNECTION_RESULT_FAIL_CREATE_TASK_SCTP;
+        }
     }
 
+    return ret;
 }
 /*-----------------------------------------------------------*/
 
@@ -392,6 +741,13 @@ static void OnSCTPSessionDataChannelMessage( void * customData,
         return;
     }
 
+    if( pthread_equal( pthread_self(), pPeerConnectionSession->pSctpTask ) != 0 )
+    {
+        /* Run by the SCTP task once it releases sctpSessionMutex. */
+        QueueSctpEvent( pPeerConnectionSession, channelId, 0U, isBinary, pMessage, pMessageLen );
+        return;
+    }
+
     pChannel = pxGetDataChannelWithID( pPeerConnectionSession, channelId );
 
     if( pChannel != NULL )
@@ -431,6 +787,48 @@ static SctpUtilsResult_t OnSCTPSessionDataChannelAckOpen( void * customData,
 }
 /*-----------------------------------------------------------*/
 
+/* The queued data of a channel has been handed to the SCTP stack down to its
+ * low threshold, let the application send more. */
+static void OnSCTPSessionDataChannelBufferedAmountLow( void * customData,
+                                                       uint16_t channelId )
+{
+    PeerConnectionSession_t * pPeerConnectionSession = ( PeerConnectionSession_t * ) customData;
+    PeerConnectionDataChannel_t * pChannel = NULL;
+    OnDataChannelBufferedAmountLow_t onBufferedAmountLow = NULL;
+    void * pBufferedAmountLowCustomContext = NULL;
+
+    if( customData == NULL )
+    {
+        LogError( ( "No context found" ) );
+        return;
+    }
+
+    if( pthread_equal( pthread_self(), pPeerConnectionSession->pSctpTask ) != 0 )
+    {
+        /* Run by the SCTP task once it releases sctpSessionMutex. */
+        QueueSctpEvent( pPeerConnectionSession, channelId, 1U, 0U, NULL, 0U );
+        return;
+    }
+
+    if( pthread_mutex_lock( &( pPeerConnectionSession->sctpSessionMutex ) ) == 0 )
+    {
+        pChannel = pxGetDataChannelWithID( pPeerConnectionSession, channelId );
+        if( pChannel != NULL )
+        {
+            onBufferedAmountLow = pChannel->onBufferedAmountLow;
+            pBufferedAmountLowCustomContext = pChannel->pBufferedAmountLowCustomContext;
+        }
+        pthread_mutex_unlock( &( pPeerConnectionSession->sctpSessionMutex ) );
+    }
+
+    if( onBufferedAmountLow != NULL )
+    {
+        onBufferedAmountLow( pChannel, pBufferedAmountLowCustomContext );
+    }
+
+}
+/*-----------------------------------------------------------*/
+
 /* Callback to allocate and initialise a data channel when there is a valid
  * incoming DCEP DATA_CHANNEL_OPEN Message from the remote. */
 static void OnSCTPSessionDataChannelOpen( void * customData,
@@ -562,18 +960,39 @@ PeerConnectionResult_t PeerConnectionSCTP_DeallocateSCTP( PeerConnectionSession_
     PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
     PeerConnectionDataChannel_t * pxIterator = pSession->pDataChannels;
 
-    while( pxIterator != NULL )
+    if( pthread_mutex_lock( &( pSession->sctpSessionMutex ) ) != 0 )
     {
-        Sctp_CloseDataChannel( &( pSession->sctpSession ), &( pxIterator->dataChannel ) );
-        PeerConnectionSCTP_DeallocateDataChannel( pxIterator );
-        pxIterator = pxIterator->pxNext;
+        LogError( ( "Fail to take SCTP session mutex" ) );
+        ret = PEER_CONNECTION_RESULT_FAIL_SCTP_CLOSE;
+    }
+    else
+    {
+        /* Stop the SCTP task from touching the session before it's freed. */
+        pSession->isSctpSessionReady = 0U;
+
+        while( pxIterator != NULL )
+        {
+            Sctp_CloseDataChannel( &( pSession->sctpSession ), &( pxIterator->dataChannel ) );
+            PeerConnectionSCTP_DeallocateDataChannel( pxIterator );
+            pxIterator = pxIterator->pxNext;
+        }
+
+        pSession->pDataChannels = NULL;
+
+        if( Sctp_FreeSession( &( pSession->sctpSession ) ) != SCTP_UTILS_RESULT_OK )
+        {
+            ret = PEER_CONNECTION_RESULT_FAIL_SCTP_CLOSE;
+        }
+
+        pthread_mutex_unlock( &( pSession->sctpSessionMutex ) );
     }
 
-    pSession->pDataChannels = NULL;
+    Sctp_FlushReceiveQueue( &( pSession->sctpReceiveQueue ) );
 
-    if( Sctp_FreeSession( &( pSession->sctpSession ) ) != SCTP_UTILS_RESULT_OK )
+    if( pSession->sctpReceiveQueue.droppedPackets > 0U )
     {
-        ret = PEER_CONNECTION_RESULT_FAIL_SCTP_CLOSE;
+        LogInfo( ( "SCTP packets dropped on full receive queue: %u", ( unsigned int ) pSession->sctpReceiveQueue.droppedPackets ) );
+        pSession->sctpReceiveQueue.droppedPackets = 0U;
     }
 
     return ret;
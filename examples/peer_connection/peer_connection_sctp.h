@@ -54,6 +54,21 @@ PeerConnectionResult_t PeerConnectionSCTP_DataChannelSend( PeerConnectionDataCha
                                                            uint8_t * pMessage,
                                                            uint32_t pMessageLen );
 
+/* Get the bytes sent on the channel but still queued because of SCTP backpressure,
+ * plus the bytes the SCTP stack holds for the session until they're acknowledged. */
+PeerConnectionResult_t PeerConnectionSCTP_GetBufferedAmount( PeerConnectionDataChannel_t * pChannel,
+                                                             size_t * pBufferedAmount );
+
+/* Fire onBufferedAmountLow once the buffered amount drops to or below the threshold. */
+PeerConnectionResult_t PeerConnectionSCTP_SetBufferedAmountLowCallback( PeerConnectionDataChannel_t * pChannel,
+                                                                        size_t threshold,
+                                                                        OnDataChannelBufferedAmountLow_t onBufferedAmountLow,
+                                                                        void * pCustomContext );
+
+/* Create the SCTP task and its packet queue, called once when the session is initialized. */
+PeerConnectionResult_t PeerConnectionSCTP_InitSession( PeerConnectionSession_t * pSession,
+                                                       uint32_t initSeq );
+
 PeerConnectionResult_t PeerConnectionSCTP_AllocateSCTP( PeerConnectionSession_t * pSession );
 
 PeerConnectionResult_t PeerConnectionSCTP_DeallocateSCTP( PeerConnectionSession_t * pSession );
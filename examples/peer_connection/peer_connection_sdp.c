@@ -21,6 +21,7 @@
 #include "sdp_controller.h"
 #include "string_utils.h"
 #include "peer_connection_sdp.h"
+#include "peer_connection_sdp_template.h"
 
 #define PEER_CONNECTION_SDP_ORIGIN_DEFAULT_USER_NAME "-"
 #define PEER_CONNECTION_SDP_ORIGIN_DEFAULT_SESSION_VERSION ( 2 )
@@ -741,9 +742,26 @@ static PeerConnectionResult_t SetPayloadType( PeerConnectionSession_t * pSession
     return ret;
 }
 
+static PeerConnectionResult_t GetSdpControllerFailResult( SdpControllerResult_t retSdpController,
+                                                          PeerConnectionResult_t failResult )
+{
+    PeerConnectionResult_t ret = failResult;
+
+    /* The SDP serializer fails to add a line only if the output buffer is full. */
+    if( ( retSdpController == SDP_CONTROLLER_RESULT_SDP_POPULATE_BUFFER_TOO_SMALL ) ||
+        ( retSdpController == SDP_CONTROLLER_RESULT_SDP_CONVERTED_BUFFER_TOO_SMALL ) ||
+        ( retSdpController == SDP_CONTROLLER_RESULT_SDP_FAIL_SERIALIZER_ADD ) )
+    {
+        ret = PEER_CONNECTION_RESULT_FAIL_SDP_BUFFER_TOO_SMALL;
+    }
+
+    return ret;
+}
+
 static PeerConnectionResult_t PopulateMediaDescriptions( PeerConnectionSession_t * pSession,
                                                          PeerConnectionBufferSessionDescription_t * pRemoteBufferSessionDescription,
                                                          PeerConnectionBufferSessionDescription_t * pLocalBufferSessionDescription,
+                                                         const PeerConnectionSdpTemplateValues_t * pSentinelValues,
                                                          char ** ppBuffer,
                                                          size_t * pBufferLength )
 {
@@ -751,20 +769,30 @@ static PeerConnectionResult_t PopulateMediaDescriptions( PeerConnectionSession_t
     int i;
     SdpControllerResult_t retSdpController;
     SdpControllerPopulateMediaConfiguration_t populateConfiguration;
+    Transceiver_t sentinelTransceiver;
 
     memset( &populateConfiguration, 0, sizeof( SdpControllerPopulateMediaConfiguration_t ) );
     populateConfiguration.canTrickleIce = 1U;
 
     populateConfiguration.pCname = pSession->pCtx->localCname;
     populateConfiguration.cnameLength = strlen( pSession->pCtx->localCname );
-    populateConfiguration.pUserName = pSession->pCtx->localUserName;
-    populateConfiguration.userNameLength = strlen( pSession->pCtx->localUserName );
-    populateConfiguration.pPassword = pSession->pCtx->localPassword;
-    populateConfiguration.passwordLength = strlen( pSession->pCtx->localPassword );
+    populateConfiguration.pUserName = pSession->localUserName;
+    populateConfiguration.userNameLength = strlen( pSession->localUserName );
+    populateConfiguration.pPassword = pSession->localPassword;
+    populateConfiguration.passwordLength = strlen( pSession->localPassword );
 
-    populateConfiguration.pLocalFingerprint = pSession->pCtx->dtlsContext.localCertFingerprint;
+    populateConfiguration.pLocalFingerprint = pSession->pDtlsCertificate->localCertFingerprint;
     populateConfiguration.localFingerprintLength = CERTIFICATE_FINGERPRINT_LENGTH;
 
+    /* Building an answer template, the per-session values are replaced by sentinels. */
+    if( pSentinelValues != NULL )
+    {
+        populateConfiguration.pUserName = pSentinelValues->pUserName;
+        populateConfiguration.userNameLength = pSentinelValues->userNameLength;
+        populateConfiguration.pPassword = pSentinelValues->pPassword;
+        populateConfiguration.passwordLength = pSentinelValues->passwordLength;
+    }
+
     if( pRemoteBufferSessionDescription == NULL )
     {
         /* Populating SDP offer. */
@@ -795,7 +823,8 @@ static PeerConnectionResult_t PopulateMediaDescriptions( PeerConnectionSession_t
             if( retSdpController != SDP_CONTROLLER_RESULT_OK )
             {
                 LogError( ( "Fail to populate single media description, result: %d", retSdpController ) );
-                ret = PEER_CONNECTION_RESULT_FAIL_SDP_POPULATE_SINGLE_MEDIA_DESCRIPTION;
+                ret = GetSdpControllerFailResult( retSdpController,
+                                                  PEER_CONNECTION_RESULT_FAIL_SDP_POPULATE_SINGLE_MEDIA_DESCRIPTION );
                 break;
             }
             else
@@ -810,6 +839,7 @@ static PeerConnectionResult_t PopulateMediaDescriptions( PeerConnectionSession_t
                 if( i < SDP_CONTROLLER_MAX_SDP_MEDIA_DESCRIPTIONS_COUNT )
                 {
                     populateConfiguration.pTransceiver = NULL;
+                    populateConfiguration.maxMessageSize = SCTP_MAX_MESSAGE_SIZE;
                     retSdpController = SdpController_PopulateSingleMedia( NULL,
                                                                           populateConfiguration,
                                                                           &pLocalBufferSessionDescription->sdpDescription.mediaDescriptions[ i ],
@@ -820,7 +850,8 @@ static PeerConnectionResult_t PopulateMediaDescriptions( PeerConnectionSession_t
                     if( retSdpController != SDP_CONTROLLER_RESULT_OK )
                     {
                         LogError( ( "Fail to populate single media data channel description, result: %d", retSdpController ) );
-                        ret = PEER_CONNECTION_RESULT_FAIL_SDP_POPULATE_SINGLE_MEDIA_DESCRIPTION;
+                        ret = GetSdpControllerFailResult( retSdpController,
+                                                          PEER_CONNECTION_RESULT_FAIL_SDP_POPULATE_SINGLE_MEDIA_DESCRIPTION );
                     }
                     else
                     {
@@ -843,6 +874,16 @@ static PeerConnectionResult_t PopulateMediaDescriptions( PeerConnectionSession_t
         for( i = 0; i < pSession->mLinesTransceiverCount; i++ )
         {
             populateConfiguration.pTransceiver = pSession->pMLinesTransceivers[i];
+            if( pSentinelValues != NULL )
+            {
+                /* Work on a copy, the transceiver is shared with the media threads. */
+                memcpy( &sentinelTransceiver,
+                        pSession->pMLinesTransceivers[i],
+                        sizeof( Transceiver_t ) );
+                sentinelTransceiver.ssrc = pSentinelValues->ssrc[ i ];
+                sentinelTransceiver.rtxSsrc = pSentinelValues->rtxSsrc[ i ];
+                populateConfiguration.pTransceiver = &sentinelTransceiver;
+            }
             if( populateConfiguration.pTransceiver->trackKind == TRANSCEIVER_TRACK_KIND_VIDEO )
             {
                 populateConfiguration.payloadType = pSession->rtpConfig.videoCodecPayload;
@@ -864,7 +905,8 @@ static PeerConnectionResult_t PopulateMediaDescriptions( PeerConnectionSession_t
             if( retSdpController != SDP_CONTROLLER_RESULT_OK )
             {
                 LogError( ( "Fail to populate single media description, result: %d", retSdpController ) );
-                ret = PEER_CONNECTION_RESULT_FAIL_SDP_POPULATE_SINGLE_MEDIA_DESCRIPTION;
+                ret = GetSdpControllerFailResult( retSdpController,
+                                                  PEER_CONNECTION_RESULT_FAIL_SDP_POPULATE_SINGLE_MEDIA_DESCRIPTION );
                 break;
             }
             else
@@ -877,6 +919,7 @@ static PeerConnectionResult_t PopulateMediaDescriptions( PeerConnectionSession_t
             if( ( ret == PEER_CONNECTION_RESULT_OK ) && ( pSession->ucEnableDataChannelRemote == 1 ) && ( i < SDP_CONTROLLER_MAX_SDP_MEDIA_DESCRIPTIONS_COUNT ) )
             {
                 populateConfiguration.pTransceiver = NULL;
+                populateConfiguration.maxMessageSize = SCTP_MAX_MESSAGE_SIZE;
                 retSdpController = SdpController_PopulateSingleMedia( &pRemoteBufferSessionDescription->sdpDescription.mediaDescriptions[ i ],
                                                                       populateConfiguration,
                                                                       &pLocalBufferSessionDescription->sdpDescription.mediaDescriptions[ i ],
@@ -887,7 +930,8 @@ static PeerConnectionResult_t PopulateMediaDescriptions( PeerConnectionSession_t
                 if( retSdpController != SDP_CONTROLLER_RESULT_OK )
                 {
                     LogError( ( "Fail to populate single media data channel description, result: %d", retSdpController ) );
-                    ret = PEER_CONNECTION_RESULT_FAIL_SDP_POPULATE_SINGLE_MEDIA_DESCRIPTION;
+                    ret = GetSdpControllerFailResult( retSdpController,
+                                                      PEER_CONNECTION_RESULT_FAIL_SDP_POPULATE_SINGLE_MEDIA_DESCRIPTION );
                 }
                 else
                 {
@@ -932,7 +976,8 @@ static PeerConnectionResult_t PopulateSessionDescription( PeerConnectionSession_
     if( retSdpController != SDP_CONTROLLER_RESULT_OK )
     {
         LogWarn( ( "Fail to populate session description, result: %d", retSdpController ) );
-        ret = PEER_CONNECTION_RESULT_FAIL_SDP_POPULATE_SESSION_DESCRIPTION;
+        ret = GetSdpControllerFailResult( retSdpController,
+                                          PEER_CONNECTION_RESULT_FAIL_SDP_POPULATE_SESSION_DESCRIPTION );
     }
 
     return ret;
@@ -1117,6 +1162,147 @@ PeerConnectionResult_t PeerConnectionSdp_SetPayloadTypes( PeerConnectionSession_
     return ret;
 }
 
+/* Populate the local description and serialize it. With pSentinelValues set, the per-session
+ * values are replaced by the sentinels to build an answer template. */
+static PeerConnectionResult_t SerializeSessionDescription( PeerConnectionSession_t * pSession,
+                                                           PeerConnectionBufferSessionDescription_t * pRemoteBufferSessionDescription,
+                                                           PeerConnectionBufferSessionDescription_t * pLocalBufferSessionDescription,
+                                                           const PeerConnectionSdpTemplateValues_t * pSentinelValues,
+                                                           char * pOutputSerializedSdpMessage,
+                                                           size_t * pOutputSerializedSdpMessageLength )
+{
+    PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
+    char * pBuffer = NULL;
+    size_t bufferLength = 0;
+    SdpControllerResult_t retSdpController;
+
+    /* Add media descriptions, use the temp buffer to store SDP content for pointers to refer to. */
+    pBuffer = pLocalBufferSessionDescription->pSdpBuffer;
+    bufferLength = pLocalBufferSessionDescription->sdpBufferLength;
+    ret = PopulateMediaDescriptions( pSession, pRemoteBufferSessionDescription, pLocalBufferSessionDescription, pSentinelValues, &pBuffer, &bufferLength );
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        /* Add session descriptions.
+         * Note that we need to session media count to populate session group attribute,
+         * so this have to do after populate media sessions. */
+        ret = PopulateSessionDescription( pSession, pRemoteBufferSessionDescription, pLocalBufferSessionDescription, &pBuffer, &bufferLength );
+    }
+
+    if( ( ret == PEER_CONNECTION_RESULT_OK ) && ( pSentinelValues != NULL ) )
+    {
+        pLocalBufferSessionDescription->sdpDescription.origin.sessionId = pSentinelValues->sessionId;
+    }
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        /* Serialize the content into the buffer in pLocalBufferSessionDescription. */
+        pBuffer = pOutputSerializedSdpMessage;
+        bufferLength = *pOutputSerializedSdpMessageLength;
+        retSdpController = SdpController_SerializeSdpMessageByDescription( pLocalBufferSessionDescription->type,
+                                                                           &pLocalBufferSessionDescription->sdpDescription,
+                                                                           pBuffer,
+                                                                           &bufferLength );
+        if( retSdpController != SDP_CONTROLLER_RESULT_OK )
+        {
+            LogWarn( ( "Fail to serialize session description, result: %d", retSdpController ) );
+            ret = GetSdpControllerFailResult( retSdpController,
+                                              PEER_CONNECTION_RESULT_FAIL_SDP_POPULATE_SESSION_DESCRIPTION );
+        }
+        else
+        {
+            *pOutputSerializedSdpMessageLength = bufferLength;
+        }
+    }
+
+    return ret;
+}
+
+static void GetSessionValues( const PeerConnectionSession_t * pSession,
+                              uint64_t sessionId,
+                              PeerConnectionSdpTemplateValues_t * pValues )
+{
+    uint32_t i;
+
+    memset( pValues,
+            0,
+            sizeof( PeerConnectionSdpTemplateValues_t ) );
+    pValues->sessionId = sessionId;
+    pValues->pUserName = pSession->localUserName;
+    pValues->userNameLength = strlen( pSession->localUserName );
+    pValues->pPassword = pSession->localPassword;
+    pValues->passwordLength = strlen( pSession->localPassword );
+    for( i = 0; i < pSession->mLinesTransceiverCount; i++ )
+    {
+        pValues->ssrc[ i ] = pSession->pMLinesTransceivers[ i ]->ssrc;
+        pValues->rtxSsrc[ i ] = pSession->pMLinesTransceivers[ i ]->rtxSsrc;
+    }
+}
+
+/* Serialize the answer again with the sentinel values and cache the template made from it. */
+static void BuildAnswerTemplate( PeerConnectionSession_t * pSession,
+                                 PeerConnectionBufferSessionDescription_t * pRemoteBufferSessionDescription,
+                                 PeerConnectionBufferSessionDescription_t * pLocalBufferSessionDescription,
+                                 uint64_t key,
+                                 const char * pAnswer,
+                                 size_t answerLength )
+{
+    PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
+    PeerConnectionBufferSessionDescription_t * pSentinelDescription = NULL;
+    char * pSentinelAnswer = NULL;
+    size_t sentinelAnswerLength = PEER_CONNECTION_SDP_TEMPLATE_MAX_LENGTH;
+    PeerConnectionSdpTemplateValues_t values;
+
+    /* Only needed for the first answer to each offer shape, the temp buffer and the output follow the description. */
+    pSentinelDescription = ( PeerConnectionBufferSessionDescription_t * ) malloc( sizeof( PeerConnectionBufferSessionDescription_t ) +
+                                                                                 2 * PEER_CONNECTION_SDP_TEMPLATE_MAX_LENGTH );
+    if( pSentinelDescription == NULL )
+    {
+        LogWarn( ( "No memory to build SDP answer template" ) );
+        ret = PEER_CONNECTION_RESULT_FAIL_SDP_TEMPLATE_NO_ENOUGH_MEMORY;
+    }
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        memset( pSentinelDescription,
+                0,
+                sizeof( PeerConnectionBufferSessionDescription_t ) );
+        pSentinelDescription->type = pLocalBufferSessionDescription->type;
+        pSentinelDescription->pSdpBuffer = ( char * ) ( pSentinelDescription + 1 );
+        pSentinelDescription->sdpBufferLength = PEER_CONNECTION_SDP_TEMPLATE_MAX_LENGTH;
+        pSentinelAnswer = pSentinelDescription->pSdpBuffer + PEER_CONNECTION_SDP_TEMPLATE_MAX_LENGTH;
+
+        PeerConnectionSdpTemplate_GetSentinelValues( &values );
+        ret = SerializeSessionDescription( pSession,
+                                           pRemoteBufferSessionDescription,
+                                           pSentinelDescription,
+                                           &values,
+                                           pSentinelAnswer,
+                                           &sentinelAnswerLength );
+    }
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        GetSessionValues( pSession,
+                          pLocalBufferSessionDescription->sdpDescription.origin.sessionId,
+                          &values );
+        ret = PeerConnectionSdpTemplate_Insert( &pSession->pCtx->sdpTemplateCache,
+                                                key,
+                                                pSentinelAnswer,
+                                                sentinelAnswerLength,
+                                                &values,
+                                                pAnswer,
+                                                answerLength );
+    }
+
+    if( ret != PEER_CONNECTION_RESULT_OK )
+    {
+        LogInfo( ( "SDP answer not cached as template, result: %d", ret ) );
+    }
+
+    free( pSentinelDescription );
+}
+
 PeerConnectionResult_t PeerConnectionSdp_PopulateSessionDescription( PeerConnectionSession_t * pSession,
                                                                      PeerConnectionBufferSessionDescription_t * pRemoteBufferSessionDescription,
                                                                      PeerConnectionBufferSessionDescription_t * pLocalBufferSessionDescription,
@@ -1124,9 +1310,10 @@ PeerConnectionResult_t PeerConnectionSdp_PopulateSessionDescription( PeerConnect
                                                                      size_t * pOutputSerializedSdpMessageLength )
 {
     PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
-    char * pBuffer = NULL;
-    size_t bufferLength = 0;
-    SdpControllerResult_t retSdpController;
+    uint8_t isTemplateUsed = 0U;
+    uint8_t isRendered = 0U;
+    uint64_t templateKey = 0;
+    PeerConnectionSdpTemplateValues_t values;
 
     if( ( pSession == NULL ) ||
         ( pLocalBufferSessionDescription == NULL ) ||
@@ -1154,39 +1341,56 @@ PeerConnectionResult_t PeerConnectionSdp_PopulateSessionDescription( PeerConnect
         /* Empty else marker. */
     }
 
-    if( ret == PEER_CONNECTION_RESULT_OK )
-    {
-        /* Add media descriptions, use the temp buffer to store SDP content for pointers to refer to. */
-        pBuffer = pLocalBufferSessionDescription->pSdpBuffer;
-        bufferLength = pLocalBufferSessionDescription->sdpBufferLength;
-        ret = PopulateMediaDescriptions( pSession, pRemoteBufferSessionDescription, pLocalBufferSessionDescription, &pBuffer, &bufferLength );
-    }
-
-    if( ret == PEER_CONNECTION_RESULT_OK )
-    {
-        /* Add session descriptions.
-         * Note that we need to session media count to populate session group attribute,
-         * so this have to do after populate media sessions. */
-        ret = PopulateSessionDescription( pSession, pRemoteBufferSessionDescription, pLocalBufferSessionDescription, &pBuffer, &bufferLength );
-    }
-
-    if( ret == PEER_CONNECTION_RESULT_OK )
+    /* Answers to offers of the same shape only differ in the per-session values,
+     * so they're rendered from the template of the first one. */
+    if( ( ret == PEER_CONNECTION_RESULT_OK ) &&
+        ( pRemoteBufferSessionDescription != NULL ) &&
+        ( pLocalBufferSessionDescription->type != SDP_CONTROLLER_MESSAGE_TYPE_OFFER ) &&
+        ( pSession->pCtx->sdpTemplateCache.isInitialized != 0U ) )
     {
-        /* Serialize the content into the buffer in pLocalBufferSessionDescription. */
-        pBuffer = pOutputSerializedSdpMessage;
-        bufferLength = *pOutputSerializedSdpMessageLength;
-        retSdpController = SdpController_SerializeSdpMessageByDescription( pLocalBufferSessionDescription->type,
-                                                                           &pLocalBufferSessionDescription->sdpDescription,
-                                                                           pBuffer,
-                                                                           &bufferLength );
-        if( retSdpController != SDP_CONTROLLER_RESULT_OK )
+        isTemplateUsed = 1U;
+        templateKey = PeerConnectionSdpTemplate_GetKey( pSession,
+                                                        pRemoteBufferSessionDescription );
+        GetSessionValues( pSession,
+                          ( uint64_t ) rand(),
+                          &values );
+        ret = PeerConnectionSdpTemplate_Render( &pSession->pCtx->sdpTemplateCache,
+                                                templateKey,
+                                                &values,
+                                                pOutputSerializedSdpMessage,
+                                                pOutputSerializedSdpMessageLength );
+        if( ret == PEER_CONNECTION_RESULT_OK )
         {
-            LogWarn( ( "Fail to serialize session description, result: %d", retSdpController ) );
-            ret = PEER_CONNECTION_RESULT_FAIL_SDP_POPULATE_SESSION_DESCRIPTION;
+            isRendered = 1U;
+        }
+        else if( ret != PEER_CONNECTION_RESULT_FAIL_SDP_BUFFER_TOO_SMALL )
+        {
+            /* Not cached yet, serialize it in full. */
+            ret = PEER_CONNECTION_RESULT_OK;
         }
         else
         {
-            *pOutputSerializedSdpMessageLength = bufferLength;
+            /* Empty else marker. */
+        }
+    }
+
+    if( ( ret == PEER_CONNECTION_RESULT_OK ) && ( isRendered == 0U ) )
+    {
+        ret = SerializeSessionDescription( pSession,
+                                           pRemoteBufferSessionDescription,
+                                           pLocalBufferSessionDescription,
+                                           NULL,
+                                           pOutputSerializedSdpMessage,
+                                           pOutputSerializedSdpMessageLength );
+
+        if( ( ret == PEER_CONNECTION_RESULT_OK ) && ( isTemplateUsed != 0U ) )
+        {
+            BuildAnswerTemplate( pSession,
+                                 pRemoteBufferSessionDescription,
+                                 pLocalBufferSessionDescription,
+                                 templateKey,
+                                 pOutputSerializedSdpMessage,
+                                 *pOutputSerializedSdpMessageLength );
         }
     }
 
@@ -33,6 +33,8 @@ extern "C" {
 PeerConnectionResult_t PeerConnectionSdp_DeserializeSdpMessage( PeerConnectionBufferSessionDescription_t * pBufferSessionDescription );
 PeerConnectionResult_t PeerConnectionSdp_SetPayloadTypes( PeerConnectionSession_t * pSession,
                                                           PeerConnectionBufferSessionDescription_t * pRemoteBufferSessionDescription );
+/* An answer rendered from a cached template leaves pLocalBufferSessionDescription->sdpDescription unpopulated.
+ * Returns PEER_CONNECTION_RESULT_FAIL_SDP_BUFFER_TOO_SMALL if either buffer is too small. */
 PeerConnectionResult_t PeerConnectionSdp_PopulateSessionDescription( PeerConnectionSession_t * pSession,
                                                                      PeerConnectionBufferSessionDescription_t * pRemoteBufferSessionDescription,
                                                                      PeerConnectionBufferSessionDescription_t * pLocalBufferSessionDescription,
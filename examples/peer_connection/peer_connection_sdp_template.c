@@ -0,0 +1,685 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "logging.h"
+#include "peer_connection_sdp_template.h"
+
+/* 64-bit FNV-1a. */
+#define PEER_CONNECTION_SDP_TEMPLATE_KEY_OFFSET_BASIS ( 14695981039346656037ULL )
+#define PEER_CONNECTION_SDP_TEMPLATE_KEY_PRIME ( 1099511628211ULL )
+
+/* The SSRC of m-line i is SSRC_BASE + 2 * i, the RTX SSRC is the one after it. */
+#define PEER_CONNECTION_SDP_TEMPLATE_SENTINEL_SESSION_ID ( 9182736455463728190ULL )
+#define PEER_CONNECTION_SDP_TEMPLATE_SENTINEL_SSRC_BASE ( 3987654320U )
+#define PEER_CONNECTION_SDP_TEMPLATE_SENTINEL_USER_NAME "{{ice-ufrag}}"
+#define PEER_CONNECTION_SDP_TEMPLATE_SENTINEL_PASSWORD "{{ice-pwd}}"
+
+/* Enough for the decimal string of a uint64_t. */
+#define PEER_CONNECTION_SDP_TEMPLATE_NUMBER_MAX_LENGTH ( 21 )
+
+#define PEER_CONNECTION_SDP_TEMPLATE_IS_DIGIT( c ) ( ( ( c ) >= '0' ) && ( ( c ) <= '9' ) )
+
+/* Remote attributes that differ between viewers but never make it into the answer. */
+static const char * const excludedRemoteAttributes[] = {
+    "ice-ufrag",
+    "ice-pwd",
+    "fingerprint",
+    "candidate",
+    "end-of-candidates",
+    "ssrc",
+    "ssrc-group",
+    "msid",
+};
+
+/*-----------------------------------------------------------*/
+
+static uint64_t HashBytes( uint64_t key,
+                           const void * pData,
+                           size_t dataLength )
+{
+    const uint8_t * pBytes = ( const uint8_t * ) pData;
+    uint64_t length = dataLength;
+    size_t i;
+
+    /* Hash the length first, so adjacent fields can't shift into each other. */
+    for( i = 0; i < sizeof( length ); i++ )
+    {
+        key ^= ( length >> ( i * 8 ) ) & 0xFF;
+        key *= PEER_CONNECTION_SDP_TEMPLATE_KEY_PRIME;
+    }
+
+    for( i = 0; i < dataLength; i++ )
+    {
+        key ^= pBytes[ i ];
+        key *= PEER_CONNECTION_SDP_TEMPLATE_KEY_PRIME;
+    }
+
+    return key;
+}
+
+static uint64_t HashValue( uint64_t key,
+                           uint64_t value )
+{
+    return HashBytes( key,
+                      &value,
+                      sizeof( value ) );
+}
+
+static uint8_t IsExcludedRemoteAttribute( const SdpControllerAttributes_t * pAttribute )
+{
+    uint8_t isExcluded = 0U;
+    size_t i;
+
+    for( i = 0; i < sizeof( excludedRemoteAttributes ) / sizeof( excludedRemoteAttributes[ 0 ] ); i++ )
+    {
+        if( ( pAttribute->attributeNameLength == strlen( excludedRemoteAttributes[ i ] ) ) &&
+            ( strncmp( pAttribute->pAttributeName,
+                       excludedRemoteAttributes[ i ],
+                       pAttribute->attributeNameLength ) == 0 ) )
+        {
+            isExcluded = 1U;
+            break;
+        }
+    }
+
+    return isExcluded;
+}
+
+static uint64_t HashRemoteAttributes( uint64_t key,
+                                      const SdpControllerAttributes_t * pAttributes,
+                                      uint32_t attributeCount )
+{
+    uint32_t i;
+
+    for( i = 0; i < attributeCount; i++ )
+    {
+        if( IsExcludedRemoteAttribute( &pAttributes[ i ] ) == 0U )
+        {
+            key = HashBytes( key,
+                             pAttributes[ i ].pAttributeName,
+                             pAttributes[ i ].attributeNameLength );
+            key = HashBytes( key,
+                             pAttributes[ i ].pAttributeValue,
+                             pAttributes[ i ].attributeValueLength );
+        }
+    }
+
+    return key;
+}
+
+/* Returns the value of the slot, numbers are formatted into pNumberBuffer. */
+static const char * GetSlotValue( const PeerConnectionSdpTemplateSlot_t * pSlot,
+                                  const PeerConnectionSdpTemplateValues_t * pValues,
+                                  char pNumberBuffer[ PEER_CONNECTION_SDP_TEMPLATE_NUMBER_MAX_LENGTH ],
+                                  size_t * pValueLength )
+{
+    const char * pValue = pNumberBuffer;
+    int written = 0;
+
+    switch( pSlot->type )
+    {
+        case PEER_CONNECTION_SDP_TEMPLATE_SLOT_SESSION_ID:
+            written = snprintf( pNumberBuffer,
+                                PEER_CONNECTION_SDP_TEMPLATE_NUMBER_MAX_LENGTH,
+                                "%" PRIu64,
+                                pValues->sessionId );
+            break;
+        case PEER_CONNECTION_SDP_TEMPLATE_SLOT_USER_NAME:
+            pValue = pValues->pUserName;
+            written = ( int ) pValues->userNameLength;
+            break;
+        case PEER_CONNECTION_SDP_TEMPLATE_SLOT_PASSWORD:
+            pValue = pValues->pPassword;
+            written = ( int ) pValues->passwordLength;
+            break;
+        case PEER_CONNECTION_SDP_TEMPLATE_SLOT_SSRC:
+            written = snprintf( pNumberBuffer,
+                                PEER_CONNECTION_SDP_TEMPLATE_NUMBER_MAX_LENGTH,
+                                "%" PRIu32,
+                                pValues->ssrc[ pSlot->mLineIndex ] );
+            break;
+        case PEER_CONNECTION_SDP_TEMPLATE_SLOT_RTX_SSRC:
+        default:
+            written = snprintf( pNumberBuffer,
+                                PEER_CONNECTION_SDP_TEMPLATE_NUMBER_MAX_LENGTH,
+                                "%" PRIu32,
+                                pValues->rtxSsrc[ pSlot->mLineIndex ] );
+            break;
+    }
+
+    *pValueLength = ( written > 0 ) ? ( size_t ) written : 0U;
+
+    return pValue;
+}
+
+static PeerConnectionResult_t RenderTemplate( const PeerConnectionSdpTemplate_t * pTemplate,
+                                              const PeerConnectionSdpTemplateValues_t * pValues,
+                                              char * pOutput,
+                                              size_t * pOutputLength )
+{
+    PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
+    char numberBuffer[ PEER_CONNECTION_SDP_TEMPLATE_NUMBER_MAX_LENGTH ];
+    const char * pValue;
+    size_t valueLength;
+    size_t textOffset = 0;
+    size_t outputOffset = 0;
+    size_t pieceLength;
+    uint32_t i;
+
+    for( i = 0; i <= pTemplate->slotCount; i++ )
+    {
+        /* The text before the slot, or the tail after the last slot. */
+        pieceLength = ( i < pTemplate->slotCount ? pTemplate->slots[ i ].offset : pTemplate->textLength ) - textOffset;
+        if( outputOffset + pieceLength > *pOutputLength )
+        {
+            ret = PEER_CONNECTION_RESULT_FAIL_SDP_BUFFER_TOO_SMALL;
+            break;
+        }
+        memcpy( &pOutput[ outputOffset ],
+                &pTemplate->pText[ textOffset ],
+                pieceLength );
+        outputOffset += pieceLength;
+        textOffset += pieceLength;
+
+        if( i < pTemplate->slotCount )
+        {
+            pValue = GetSlotValue( &pTemplate->slots[ i ],
+                                   pValues,
+                                   numberBuffer,
+                                   &valueLength );
+            if( outputOffset + valueLength > *pOutputLength )
+            {
+                ret = PEER_CONNECTION_RESULT_FAIL_SDP_BUFFER_TOO_SMALL;
+                break;
+            }
+            memcpy( &pOutput[ outputOffset ],
+                    pValue,
+                    valueLength );
+            outputOffset += valueLength;
+        }
+    }
+
+    /* Keep the space for the terminator, the same as the SDP serializer does. */
+    if( ( ret == PEER_CONNECTION_RESULT_OK ) && ( outputOffset >= *pOutputLength ) )
+    {
+        ret = PEER_CONNECTION_RESULT_FAIL_SDP_BUFFER_TOO_SMALL;
+    }
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        pOutput[ outputOffset ] = '\0';
+        *pOutputLength = outputOffset;
+    }
+
+    return ret;
+}
+
+/* Returns 1 if rendering the template with pValues gives exactly pAnswer. */
+static uint8_t IsTemplateMatched( const PeerConnectionSdpTemplate_t * pTemplate,
+                                  const PeerConnectionSdpTemplateValues_t * pValues,
+                                  const char * pAnswer,
+                                  size_t answerLength )
+{
+    uint8_t isMatched = 1U;
+    char numberBuffer[ PEER_CONNECTION_SDP_TEMPLATE_NUMBER_MAX_LENGTH ];
+    const char * pValue;
+    size_t valueLength;
+    size_t textOffset = 0;
+    size_t answerOffset = 0;
+    size_t pieceLength;
+    uint32_t i;
+
+    for( i = 0; i <= pTemplate->slotCount; i++ )
+    {
+        pieceLength = ( i < pTemplate->slotCount ? pTemplate->slots[ i ].offset : pTemplate->textLength ) - textOffset;
+        if( ( answerOffset + pieceLength > answerLength ) ||
+            ( memcmp( &pAnswer[ answerOffset ],
+                      &pTemplate->pText[ textOffset ],
+                      pieceLength ) != 0 ) )
+        {
+            isMatched = 0U;
+            break;
+        }
+        answerOffset += pieceLength;
+        textOffset += pieceLength;
+
+        if( i < pTemplate->slotCount )
+        {
+            pValue = GetSlotValue( &pTemplate->slots[ i ],
+                                   pValues,
+                                   numberBuffer,
+                                   &valueLength );
+            if( ( answerOffset + valueLength > answerLength ) ||
+                ( memcmp( &pAnswer[ answerOffset ],
+                          pValue,
+                          valueLength ) != 0 ) )
+            {
+                isMatched = 0U;
+                break;
+            }
+            answerOffset += valueLength;
+        }
+    }
+
+    if( answerOffset != answerLength )
+    {
+        isMatched = 0U;
+    }
+
+    return isMatched;
+}
+
+/* Cut the sentinel values out of the answer, numbers only match as a whole. */
+static PeerConnectionResult_t BuildTemplate( PeerConnectionSdpTemplate_t * pTemplate,
+                                             const char * pSentinelAnswer,
+                                             size_t sentinelAnswerLength )
+{
+    PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
+    PeerConnectionSdpTemplateValues_t sentinelValues;
+    PeerConnectionSdpTemplateSlot_t slot;
+    char numbers[ 1 + 2 * PEER_CONNECTION_TRANSCEIVER_MAX_COUNT ][ PEER_CONNECTION_SDP_TEMPLATE_NUMBER_MAX_LENGTH ];
+    size_t numberLengths[ 1 + 2 * PEER_CONNECTION_TRANSCEIVER_MAX_COUNT ];
+    size_t i = 0;
+    size_t runLength;
+    size_t matchedLength;
+    uint32_t j;
+
+    PeerConnectionSdpTemplate_GetSentinelValues( &sentinelValues );
+
+    /* numbers[ 0 ] is the session ID, followed by the SSRC and RTX SSRC of each m-line. */
+    numberLengths[ 0 ] = ( size_t ) snprintf( numbers[ 0 ],
+                                              PEER_CONNECTION_SDP_TEMPLATE_NUMBER_MAX_LENGTH,
+                                              "%" PRIu64,
+                                              sentinelValues.sessionId );
+    for( j = 0; j < PEER_CONNECTION_TRANSCEIVER_MAX_COUNT; j++ )
+    {
+        numberLengths[ 1 + 2 * j ] = ( size_t ) snprintf( numbers[ 1 + 2 * j ],
+                                                          PEER_CONNECTION_SDP_TEMPLATE_NUMBER_MAX_LENGTH,
+                                                          "%" PRIu32,
+                                                          sentinelValues.ssrc[ j ] );
+        numberLengths[ 2 + 2 * j ] = ( size_t ) snprintf( numbers[ 2 + 2 * j ],
+                                                          PEER_CONNECTION_SDP_TEMPLATE_NUMBER_MAX_LENGTH,
+                                                          "%" PRIu32,
+                                                          sentinelValues.rtxSsrc[ j ] );
+    }
+
+    memset( pTemplate,
+            0,
+            sizeof( PeerConnectionSdpTemplate_t ) );
+    pTemplate->pText = ( char * ) malloc( sentinelAnswerLength );
+    if( pTemplate->pText == NULL )
+    {
+        LogError( ( "Fail to allocate SDP template of length %lu", sentinelAnswerLength ) );
+        ret = PEER_CONNECTION_RESULT_FAIL_SDP_TEMPLATE_NO_ENOUGH_MEMORY;
+    }
+
+    while( ( ret == PEER_CONNECTION_RESULT_OK ) && ( i < sentinelAnswerLength ) )
+    {
+        matchedLength = 0;
+        runLength = 0;
+
+        if( ( sentinelAnswerLength - i >= sentinelValues.userNameLength ) &&
+            ( memcmp( &pSentinelAnswer[ i ], sentinelValues.pUserName, sentinelValues.userNameLength ) == 0 ) )
+        {
+            slot.type = PEER_CONNECTION_SDP_TEMPLATE_SLOT_USER_NAME;
+            slot.mLineIndex = 0;
+            matchedLength = sentinelValues.userNameLength;
+        }
+        else if( ( sentinelAnswerLength - i >= sentinelValues.passwordLength ) &&
+                 ( memcmp( &pSentinelAnswer[ i ], sentinelValues.pPassword, sentinelValues.passwordLength ) == 0 ) )
+        {
+            slot.type = PEER_CONNECTION_SDP_TEMPLATE_SLOT_PASSWORD;
+            slot.mLineIndex = 0;
+            matchedLength = sentinelValues.passwordLength;
+        }
+        else if( PEER_CONNECTION_SDP_TEMPLATE_IS_DIGIT( pSentinelAnswer[ i ] ) )
+        {
+            /* i is always at the start of a number here, the rest of a number is copied along with its start. */
+            while( ( i + runLength < sentinelAnswerLength ) &&
+                   PEER_CONNECTION_SDP_TEMPLATE_IS_DIGIT( pSentinelAnswer[ i + runLength ] ) )
+            {
+                runLength++;
+            }
+
+            for( j = 0; j < 1 + 2 * PEER_CONNECTION_TRANSCEIVER_MAX_COUNT; j++ )
+            {
+                if( ( runLength == numberLengths[ j ] ) &&
+                    ( memcmp( &pSentinelAnswer[ i ], numbers[ j ], runLength ) == 0 ) )
+                {
+                    slot.type = ( j == 0 ) ? PEER_CONNECTION_SDP_TEMPLATE_SLOT_SESSION_ID :
+                                ( ( j % 2 ) == 1 ) ? PEER_CONNECTION_SDP_TEMPLATE_SLOT_SSRC : PEER_CONNECTION_SDP_TEMPLATE_SLOT_RTX_SSRC;
+                    slot.mLineIndex = ( j == 0 ) ? 0 : ( j - 1 ) / 2;
+                    matchedLength = runLength;
+                    break;
+                }
+            }
+        }
+        else
+        {
+            /* Empty else marker. */
+        }
+
+        if( matchedLength > 0 )
+        {
+            if( pTemplate->slotCount >= PEER_CONNECTION_SDP_TEMPLATE_MAX_SLOT_COUNT )
+            {
+                LogWarn( ( "Too many per-session values in SDP answer to build template" ) );
+                ret = PEER_CONNECTION_RESULT_FAIL_SDP_TEMPLATE_TOO_MANY_SLOTS;
+            }
+            else
+            {
+                slot.offset = pTemplate->textLength;
+                pTemplate->slots[ pTemplate->slotCount++ ] = slot;
+                i += matchedLength;
+            }
+        }
+        else if( runLength > 0 )
+        {
+            memcpy( &pTemplate->pText[ pTemplate->textLength ],
+                    &pSentinelAnswer[ i ],
+                    runLength );
+            pTemplate->textLength += runLength;
+            i += runLength;
+        }
+        else
+        {
+            pTemplate->pText[ pTemplate->textLength++ ] = pSentinelAnswer[ i++ ];
+        }
+    }
+
+    if( ret != PEER_CONNECTION_RESULT_OK )
+    {
+        free( pTemplate->pText );
+        pTemplate->pText = NULL;
+    }
+
+    return ret;
+}
+
+PeerConnectionResult_t PeerConnectionSdpTemplate_Init( PeerConnectionSdpTemplateCache_t * pCache )
+{
+    PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
+
+    if( pCache == NULL )
+    {
+        LogError( ( "Invalid input, pCache: %p", pCache ) );
+        ret = PEER_CONNECTION_RESULT_BAD_PARAMETER;
+    }
+
+    if( ( ret == PEER_CONNECTION_RESULT_OK ) &&
+        ( pCache->isInitialized == 0U ) )
+    {
+        memset( pCache,
+                0,
+                sizeof( PeerConnectionSdpTemplateCache_t ) );
+
+        if( pthread_mutex_init( &pCache->cacheMutex,
+                                NULL ) != 0 )
+        {
+            LogError( ( "Fail to create SDP template cache mutex" ) );
+            ret = PEER_CONNECTION_RESULT_FAIL_CREATE_SDP_TEMPLATE_CACHE_MUTEX;
+        }
+        else
+        {
+            pCache->isInitialized = 1U;
+        }
+    }
+
+    return ret;
+}
+
+uint64_t PeerConnectionSdpTemplate_GetKey( const PeerConnectionSession_t * pSession,
+                                           const PeerConnectionBufferSessionDescription_t * pRemoteBufferSessionDescription )
+{
+    uint64_t key = PEER_CONNECTION_SDP_TEMPLATE_KEY_OFFSET_BASIS;
+    const SdpControllerSdpDescription_t * pRemoteDescription = &pRemoteBufferSessionDescription->sdpDescription;
+    const Transceiver_t * pTransceiver;
+    uint8_t isDataChannelEnabled = 0U;
+    uint32_t i;
+
+    /* Local side: the transceivers matched to the m-lines, the codecs picked and the DTLS certificate. */
+    key = HashValue( key, pSession->mLinesTransceiverCount );
+    for( i = 0; i < pSession->mLinesTransceiverCount; i++ )
+    {
+        pTransceiver = pSession->pMLinesTransceivers[ i ];
+        key = HashValue( key, pTransceiver->trackKind );
+        key = HashValue( key, pTransceiver->direction );
+        key = HashValue( key, pTransceiver->codecBitMap );
+        key = HashBytes( key, pTransceiver->streamId, pTransceiver->streamIdLength );
+        key = HashBytes( key, pTransceiver->trackId, pTransceiver->trackIdLength );
+    }
+    key = HashValue( key, pSession->rtpConfig.videoCodecPayload );
+    key = HashValue( key, pSession->rtpConfig.videoCodecRtxPayload );
+    key = HashValue( key, pSession->rtpConfig.audioCodecPayload );
+    key = HashValue( key, pSession->rtpConfig.audioCodecRtxPayload );
+    #if ENABLE_SCTP_DATA_CHANNEL
+        isDataChannelEnabled = pSession->ucEnableDataChannelRemote;
+    #endif /* ENABLE_SCTP_DATA_CHANNEL */
+    key = HashValue( key, isDataChannelEnabled );
+    key = HashBytes( key, pSession->pCtx->localCname, strlen( pSession->pCtx->localCname ) );
+    key = HashBytes( key, pSession->pDtlsCertificate->localCertFingerprint, CERTIFICATE_FINGERPRINT_LENGTH );
+
+    /* Remote side: everything but the per-viewer attributes, mids and fmtp lines are copied into the answer. */
+    key = HashValue( key, pRemoteDescription->quickAccess.twccExtId );
+    key = HashRemoteAttributes( key,
+                                pRemoteDescription->attributes,
+                                pRemoteDescription->sessionAttributesCount );
+    key = HashValue( key, pRemoteDescription->mediaCount );
+    for( i = 0; i < pRemoteDescription->mediaCount; i++ )
+    {
+        key = HashBytes( key,
+                         pRemoteDescription->mediaDescriptions[ i ].pMediaName,
+                         pRemoteDescription->mediaDescriptions[ i ].mediaNameLength );
+        key = HashRemoteAttributes( key,
+                                    pRemoteDescription->mediaDescriptions[ i ].attributes,
+                                    pRemoteDescription->mediaDescriptions[ i ].mediaAttributesCount );
+    }
+
+    return key;
+}
+
+void PeerConnectionSdpTemplate_GetSentinelValues( PeerConnectionSdpTemplateValues_t * pValues )
+{
+    uint32_t i;
+
+    memset( pValues,
+            0,
+            sizeof( PeerConnectionSdpTemplateValues_t ) );
+    pValues->sessionId = PEER_CONNECTION_SDP_TEMPLATE_SENTINEL_SESSION_ID;
+    pValues->pUserName = PEER_CONNECTION_SDP_TEMPLATE_SENTINEL_USER_NAME;
+    pValues->userNameLength = strlen( PEER_CONNECTION_SDP_TEMPLATE_SENTINEL_USER_NAME );
+    pValues->pPassword = PEER_CONNECTION_SDP_TEMPLATE_SENTINEL_PASSWORD;
+    pValues->passwordLength = strlen( PEER_CONNECTION_SDP_TEMPLATE_SENTINEL_PASSWORD );
+    for( i = 0; i < PEER_CONNECTION_TRANSCEIVER_MAX_COUNT; i++ )
+    {
+        pValues->ssrc[ i ] = PEER_CONNECTION_SDP_TEMPLATE_SENTINEL_SSRC_BASE + 2 * i;
+        pValues->rtxSsrc[ i ] = PEER_CONNECTION_SDP_TEMPLATE_SENTINEL_SSRC_BASE + 2 * i + 1;
+    }
+}
+
+PeerConnectionResult_t PeerConnectionSdpTemplate_Render( PeerConnectionSdpTemplateCache_t * pCache,
+                                                         uint64_t key,
+                                                         const PeerConnectionSdpTemplateValues_t * pValues,
+                                                         char * pOutput,
+                                                         size_t * pOutputLength )
+{
+    PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
+    uint32_t i;
+
+    if( ( pCache == NULL ) ||
+        ( pValues == NULL ) ||
+        ( pOutput == NULL ) ||
+        ( pOutputLength == NULL ) )
+    {
+        LogError( ( "Invalid input, pCache: %p, pValues: %p, pOutput: %p, pOutputLength: %p",
+                    pCache, pValues, pOutput, pOutputLength ) );
+        ret = PEER_CONNECTION_RESULT_BAD_PARAMETER;
+    }
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        if( pthread_mutex_lock( &pCache->cacheMutex ) != 0 )
+        {
+            LogError( ( "Fail to take SDP template cache mutex" ) );
+            ret = PEER_CONNECTION_RESULT_FAIL_TAKE_SDP_TEMPLATE_CACHE_MUTEX;
+        }
+    }
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        ret = PEER_CONNECTION_RESULT_SDP_TEMPLATE_NOT_FOUND;
+        for( i = 0; i < pCache->templateCount; i++ )
+        {
+            if( pCache->templates[ i ].key == key )
+            {
+                ret = RenderTemplate( &pCache->templates[ i ],
+                                      pValues,
+                                      pOutput,
+                                      pOutputLength );
+                break;
+            }
+        }
+
+        if( ret == PEER_CONNECTION_RESULT_SDP_TEMPLATE_NOT_FOUND )
+        {
+            pCache->missCount++;
+        }
+        else
+        {
+            pCache->hitCount++;
+        }
+        LogDebug( ( "SDP template cache, key: 0x%016" PRIx64 ", hits: %" PRIu64 ", misses: %" PRIu64,
+                    key, pCache->hitCount, pCache->missCount ) );
+
+        pthread_mutex_unlock( &pCache->cacheMutex );
+    }
+
+    return ret;
+}
+
+PeerConnectionResult_t PeerConnectionSdpTemplate_Insert( PeerConnectionSdpTemplateCache_t * pCache,
+                                                         uint64_t key,
+                                                         const char * pSentinelAnswer,
+                                                         size_t sentinelAnswerLength,
+                                                         const PeerConnectionSdpTemplateValues_t * pValues,
+                                                         const char * pAnswer,
+                                                         size_t answerLength )
+{
+    PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
+    PeerConnectionSdpTemplate_t newTemplate;
+    PeerConnectionSdpTemplate_t * pTarget = NULL;
+    uint32_t i;
+
+    memset( &newTemplate,
+            0,
+            sizeof( PeerConnectionSdpTemplate_t ) );
+
+    if( ( pCache == NULL ) ||
+        ( pSentinelAnswer == NULL ) ||
+        ( pValues == NULL ) ||
+        ( pAnswer == NULL ) )
+    {
+        LogError( ( "Invalid input, pCache: %p, pSentinelAnswer: %p, pValues: %p, pAnswer: %p",
+                    pCache, pSentinelAnswer, pValues, pAnswer ) );
+        ret = PEER_CONNECTION_RESULT_BAD_PARAMETER;
+    }
+    else if( ( sentinelAnswerLength == 0U ) ||
+             ( sentinelAnswerLength > PEER_CONNECTION_SDP_TEMPLATE_MAX_LENGTH ) )
+    {
+        LogWarn( ( "Skip SDP template of length %lu", sentinelAnswerLength ) );
+        ret = PEER_CONNECTION_RESULT_FAIL_SDP_TEMPLATE_NO_ENOUGH_MEMORY;
+    }
+    else
+    {
+        /* Empty else marker. */
+    }
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        ret = BuildTemplate( &newTemplate,
+                             pSentinelAnswer,
+                             sentinelAnswerLength );
+    }
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        newTemplate.key = key;
+
+        /* A sentinel left in place or a value cut out of the wrong place shows up here,
+         * such a template is never used. */
+        if( IsTemplateMatched( &newTemplate,
+                               pValues,
+                               pAnswer,
+                               answerLength ) == 0U )
+        {
+            LogWarn( ( "SDP template doesn't reproduce the answer, key: 0x%016" PRIx64, key ) );
+            ret = PEER_CONNECTION_RESULT_FAIL_SDP_TEMPLATE_MISMATCH;
+        }
+    }
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        if( pthread_mutex_lock( &pCache->cacheMutex ) != 0 )
+        {
+            LogError( ( "Fail to take SDP template cache mutex" ) );
+            ret = PEER_CONNECTION_RESULT_FAIL_TAKE_SDP_TEMPLATE_CACHE_MUTEX;
+        }
+    }
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        /* Another worker might have built the same template meanwhile. */
+        for( i = 0; i < pCache->templateCount; i++ )
+        {
+            if( pCache->templates[ i ].key == key )
+            {
+                pTarget = &pCache->templates[ i ];
+                break;
+            }
+        }
+
+        if( pTarget == NULL )
+        {
+            if( pCache->templateCount < PEER_CONNECTION_SDP_TEMPLATE_MAX_COUNT )
+            {
+                pTarget = &pCache->templates[ pCache->templateCount++ ];
+            }
+            else
+            {
+                pTarget = &pCache->templates[ pCache->nextReplaceIndex ];
+                pCache->nextReplaceIndex = ( pCache->nextReplaceIndex + 1 ) % PEER_CONNECTION_SDP_TEMPLATE_MAX_COUNT;
+            }
+        }
+
+        free( pTarget->pText );
+        *pTarget = newTemplate;
+        newTemplate.pText = NULL;
+
+        LogInfo( ( "Cached SDP answer template, key: 0x%016" PRIx64 ", length: %lu, slots: %u",
+                   key, pTarget->textLength, pTarget->slotCount ) );
+
+        pthread_mutex_unlock( &pCache->cacheMutex );
+    }
+
+    free( newTemplate.pText );
+
+    return ret;
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PEER_CONNECTION_SDP_TEMPLATE_H
+#define PEER_CONNECTION_SDP_TEMPLATE_H
+
+#pragma once
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+extern "C" {
+#endif
+/* *INDENT-ON* */
+
+/* Standard includes. */
+#include <stdint.h>
+
+#include "peer_connection_data_types.h"
+
+PeerConnectionResult_t PeerConnectionSdpTemplate_Init( PeerConnectionSdpTemplateCache_t * pCache );
+
+/* Hash everything the serialized answer depends on except the per-session values,
+ * answers to offers with the same key only differ in the template slots. */
+uint64_t PeerConnectionSdpTemplate_GetKey( const PeerConnectionSession_t * pSession,
+                                           const PeerConnectionBufferSessionDescription_t * pRemoteBufferSessionDescription );
+
+/* The values to serialize an answer with while building a template, each one is
+ * unlikely enough to be found in the answer at any other place. */
+void PeerConnectionSdpTemplate_GetSentinelValues( PeerConnectionSdpTemplateValues_t * pValues );
+
+/* Render the template of the key with the given values. Returns PEER_CONNECTION_RESULT_SDP_TEMPLATE_NOT_FOUND
+ * if no template cached, PEER_CONNECTION_RESULT_FAIL_SDP_BUFFER_TOO_SMALL if the output doesn't fit. */
+PeerConnectionResult_t PeerConnectionSdpTemplate_Render( PeerConnectionSdpTemplateCache_t * pCache,
+                                                         uint64_t key,
+                                                         const PeerConnectionSdpTemplateValues_t * pValues,
+                                                         char * pOutput,
+                                                         size_t * pOutputLength );
+
+/* Build a template from the answer serialized with the sentinel values. It's cached only if rendering it
+ * with pValues reproduces pAnswer, the answer serialized with these values. */
+PeerConnectionResult_t PeerConnectionSdpTemplate_Insert( PeerConnectionSdpTemplateCache_t * pCache,
+                                                         uint64_t key,
+                                                         const char * pSentinelAnswer,
+                                                         size_t sentinelAnswerLength,
+                                                         const PeerConnectionSdpTemplateValues_t * pValues,
+                                                         const char * pAnswer,
+                                                         size_t answerLength );
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+}
+#endif
+/* *INDENT-ON* */
+
+#endif /* PEER_CONNECTION_SDP_TEMPLATE_H */
@@ -80,7 +80,7 @@ static PeerConnectionResult_t ResendSrtpPacket( PeerConnectionSession_t * pSessi
     PeerConnectionRollingBufferPacket_t * pRollingBufferPacket = NULL;
     IceControllerResult_t resultIceController;
     uint8_t bufferAfterEncrypt = 1;
-    uint8_t srtpBuffer[ PEER_CONNECTION_SRTP_RTP_PACKET_MAX_LENGTH ];
+    uint8_t srtpBuffer[ ICE_CONTROLLER_SEND_HEADROOM_LENGTH + PEER_CONNECTION_SRTP_RTP_PACKET_MAX_LENGTH ];
     uint8_t * pSrtpPacket = NULL;
     size_t srtpPacketLength = 0;
     uint32_t payloadType;
@@ -178,7 +178,8 @@ static PeerConnectionResult_t ResendSrtpPacket( PeerConnectionSession_t * pSessi
             pRollingBufferPacket->rtpPacket.payloadLength = pRollingBufferPacket->packetBufferLength + 2;
             pRollingBufferPacket->rtpPacket.pPayload = pRollingBufferPacket->pPacketBuffer;
 
-            pSrtpPacket = srtpBuffer;
+            /* Leave headroom in front of SRTP packet for TURN channel data header. */
+            pSrtpPacket = srtpBuffer + ICE_CONTROLLER_SEND_HEADROOM_LENGTH;
             srtpPacketLength = PEER_CONNECTION_SRTP_RTP_PACKET_MAX_LENGTH;
 
             /* ConstructSrtpPacket() serializes RTP packet and encrypt it. */
@@ -196,9 +197,9 @@ static PeerConnectionResult_t ResendSrtpPacket( PeerConnectionSession_t * pSessi
 
     if( ret == PEER_CONNECTION_RESULT_OK )
     {
-        resultIceController = IceController_SendToRemotePeer( &pSession->iceControllerContext,
-                                                              pSrtpPacket,
-                                                              srtpPacketLength );
+        resultIceController = IceController_SendToRemotePeerWithHeadroom( &pSession->iceControllerContext,
+                                                                          pSrtpPacket,
+                                                                          srtpPacketLength );
 
         if( resultIceController != ICE_CONTROLLER_RESULT_OK )
         {
@@ -809,23 +810,24 @@ PeerConnectionResult_t PeerConnectionSrtcp_ConstructSenderReportPacket( PeerConn
 
     if( ret == PEER_CONNECTION_RESULT_OK )
     {
-        if( pthread_mutex_lock( &( pSession->srtpSessionMutex ) ) == 0 )
+        ret = PeerConnectionSrtp_LockSession( pSession,
+                                              PEER_CONNECTION_SRTP_PATH_RTCP_TX );
+        if( ret == PEER_CONNECTION_RESULT_OK )
         {
             isLocked = 1U;
         }
         else
         {
             LogError( ( "Fail to take SRTP session mutex to construct SRTCP packet." ) );
-            ret = PEER_CONNECTION_RESULT_FAIL_TAKE_SRTP_MUTEX;
         }
     }
 
     /* Encrypt it by SRTP. */
     if( ret == PEER_CONNECTION_RESULT_OK )
     {
-        if( pSession->srtpTransmitSession != NULL )
+        if( pSession->srtpSessions[ PEER_CONNECTION_SRTP_PATH_RTCP_TX ].session != NULL )
         {
-            errorStatus = srtp_protect_rtcp( pSession->srtpTransmitSession,
+            errorStatus = srtp_protect_rtcp( pSession->srtpSessions[ PEER_CONNECTION_SRTP_PATH_RTCP_TX ].session,
                                              pOutputSrtcpPacket,
                                              rtcpBufferLength,
                                              pOutputSrtcpPacket,
@@ -846,7 +848,8 @@ PeerConnectionResult_t PeerConnectionSrtcp_ConstructSenderReportPacket( PeerConn
 
     if( isLocked != 0U )
     {
-        pthread_mutex_unlock( &( pSession->srtpSessionMutex ) );
+        PeerConnectionSrtp_UnlockSession( pSession,
+                                          PEER_CONNECTION_SRTP_PATH_RTCP_TX );
     }
 
     return ret;
@@ -875,23 +878,24 @@ PeerConnectionResult_t PeerConnectionSrtp_HandleSrtcpPacket( PeerConnectionSessi
 
     if( ret == PEER_CONNECTION_RESULT_OK )
     {
-        if( pthread_mutex_lock( &( pSession->srtpSessionMutex ) ) == 0 )
+        ret = PeerConnectionSrtp_LockSession( pSession,
+                                              PEER_CONNECTION_SRTP_PATH_RTCP_RX );
+        if( ret == PEER_CONNECTION_RESULT_OK )
         {
             isLocked = 1U;
         }
         else
         {
             LogError( ( "Fail to take SRTP session mutex to decrypt SRTCP packet." ) );
-            ret = PEER_CONNECTION_RESULT_FAIL_TAKE_SRTP_MUTEX;
         }
     }
 
     /* Decrypt it by SRTP. */
     if( ret == PEER_CONNECTION_RESULT_OK )
     {
-        if( pSession->srtpReceiveSession != NULL )
+        if( pSession->srtpSessions[ PEER_CONNECTION_SRTP_PATH_RTCP_RX ].session != NULL )
         {
-            errorStatus = srtp_unprotect_rtcp( pSession->srtpReceiveSession,
+            errorStatus = srtp_unprotect_rtcp( pSession->srtpSessions[ PEER_CONNECTION_SRTP_PATH_RTCP_RX ].session,
                                                pBuffer,
                                                bufferLength,
                                                rtcpBuffer,
@@ -916,7 +920,8 @@ PeerConnectionResult_t PeerConnectionSrtp_HandleSrtcpPacket( PeerConnectionSessi
 
     if( isLocked != 0U )
     {
-        pthread_mutex_unlock( &( pSession->srtpSessionMutex ) );
+        PeerConnectionSrtp_UnlockSession( pSession,
+                                          PEER_CONNECTION_SRTP_PATH_RTCP_RX );
     }
 
 
@@ -15,6 +15,7 @@
  */
 
 #include <stdlib.h>
+#include <time.h>
 #include "logging.h"
 #include "peer_connection.h"
 #include "peer_connection_srtp.h"
@@ -116,6 +117,98 @@ static PeerConnectionResult_t OnJitterBufferFrameDrop( void * pCustomContext,
     return ret;
 }
 
+#if METRIC_PRINT_ENABLED
+static const MetricHistogram_t srtpLockWaitHistograms[ PEER_CONNECTION_SRTP_PATH_MAX ] = {
+    METRIC_HISTOGRAM_SRTP_RTP_TX_LOCK_WAIT,
+    METRIC_HISTOGRAM_SRTP_RTP_RX_LOCK_WAIT,
+    METRIC_HISTOGRAM_SRTP_RTCP_TX_LOCK_WAIT,
+    METRIC_HISTOGRAM_SRTP_RTCP_RX_LOCK_WAIT,
+};
+
+static const MetricHistogram_t srtpLockHoldHistograms[ PEER_CONNECTION_SRTP_PATH_MAX ] = {
+    METRIC_HISTOGRAM_SRTP_RTP_TX_LOCK_HOLD,
+    METRIC_HISTOGRAM_SRTP_RTP_RX_LOCK_HOLD,
+    METRIC_HISTOGRAM_SRTP_RTCP_TX_LOCK_HOLD,
+    METRIC_HISTOGRAM_SRTP_RTCP_RX_LOCK_HOLD,
+};
+
+static uint64_t GetMonotonicTimeNs( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+
+    return ( ( uint64_t ) ts.tv_sec * 1000000000ULL ) + ( uint64_t ) ts.tv_nsec;
+}
+#endif /* METRIC_PRINT_ENABLED */
+
+PeerConnectionResult_t PeerConnectionSrtp_InitSessionLocks( PeerConnectionSession_t * pSession )
+{
+    PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
+    int i;
+
+    for( i = 0; i < PEER_CONNECTION_SRTP_PATH_MAX; i++ )
+    {
+        memset( &pSession->srtpSessions[ i ], 0, sizeof( PeerConnectionSrtpSession_t ) );
+        if( pthread_mutex_init( &( pSession->srtpSessions[ i ].mutex ), NULL ) != 0 )
+        {
+            LogError( ( "Fail to create mutex of SRTP session, path: %d", i ) );
+            ret = PEER_CONNECTION_RESULT_FAIL_CREATE_SRTP_MUTEX;
+            break;
+        }
+    }
+
+    return ret;
+}
+
+PeerConnectionResult_t PeerConnectionSrtp_LockSession( PeerConnectionSession_t * pSession,
+                                                       PeerConnectionSrtpPath_t path )
+{
+    PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
+    PeerConnectionSrtpSession_t * pSrtpSession = &pSession->srtpSessions[ path ];
+    #if METRIC_PRINT_ENABLED
+    uint64_t waitStartTimeNs = 0U;
+
+    if( pthread_mutex_trylock( &( pSrtpSession->mutex ) ) == 0 )
+    {
+        pSrtpSession->lockAcquiredTimeNs = GetMonotonicTimeNs();
+        Metric_AddHistogramSample( &pSrtpSession->lockWaitRecord, 0U );
+    }
+    else
+    {
+        waitStartTimeNs = GetMonotonicTimeNs();
+        if( pthread_mutex_lock( &( pSrtpSession->mutex ) ) == 0 )
+        {
+            pSrtpSession->lockAcquiredTimeNs = GetMonotonicTimeNs();
+            Metric_AddHistogramSample( &pSrtpSession->lockWaitRecord, pSrtpSession->lockAcquiredTimeNs - waitStartTimeNs );
+        }
+        else
+        {
+            ret = PEER_CONNECTION_RESULT_FAIL_TAKE_SRTP_MUTEX;
+        }
+    }
+    #else
+    if( pthread_mutex_lock( &( pSrtpSession->mutex ) ) != 0 )
+    {
+        ret = PEER_CONNECTION_RESULT_FAIL_TAKE_SRTP_MUTEX;
+    }
+    #endif /* METRIC_PRINT_ENABLED */
+
+    return ret;
+}
+
+void PeerConnectionSrtp_UnlockSession( PeerConnectionSession_t * pSession,
+                                       PeerConnectionSrtpPath_t path )
+{
+    PeerConnectionSrtpSession_t * pSrtpSession = &pSession->srtpSessions[ path ];
+
+    #if METRIC_PRINT_ENABLED
+    Metric_AddHistogramSample( &pSrtpSession->lockHoldRecord, GetMonotonicTimeNs() - pSrtpSession->lockAcquiredTimeNs );
+    #endif /* METRIC_PRINT_ENABLED */
+
+    pthread_mutex_unlock( &( pSrtpSession->mutex ) );
+}
+
 PeerConnectionResult_t PeerConnectionSrtp_ConstructSrtpPacket( PeerConnectionSession_t * pSession,
                                                                RtpPacket_t * pPacketRtp,
                                                                uint8_t * pOutputSrtpPacket,
@@ -162,23 +255,24 @@ PeerConnectionResult_t PeerConnectionSrtp_ConstructSrtpPacket( PeerConnectionSes
 
     if( ret == PEER_CONNECTION_RESULT_OK )
     {
-        if( pthread_mutex_lock( &( pSession->srtpSessionMutex ) ) == 0 )
+        ret = PeerConnectionSrtp_LockSession( pSession,
+                                              PEER_CONNECTION_SRTP_PATH_RTP_TX );
+        if( ret == PEER_CONNECTION_RESULT_OK )
         {
             isLocked = 1U;
         }
         else
         {
             LogError( ( "Fail to take SRTP session mutex to construct SRTP packet." ) );
-            ret = PEER_CONNECTION_RESULT_FAIL_TAKE_SRTP_MUTEX;
         }
     }
 
     /* Encrypt it by SRTP. */
     if( ret == PEER_CONNECTION_RESULT_OK )
     {
-        if( pSession->srtpTransmitSession != NULL )
+        if( pSession->srtpSessions[ PEER_CONNECTION_SRTP_PATH_RTP_TX ].session != NULL )
         {
-            errorStatus = srtp_protect( pSession->srtpTransmitSession,
+            errorStatus = srtp_protect( pSession->srtpSessions[ PEER_CONNECTION_SRTP_PATH_RTP_TX ].session,
                                         pOutputSrtpPacket,
                                         rtpBufferLength,
                                         pOutputSrtpPacket,
@@ -198,7 +292,8 @@ PeerConnectionResult_t PeerConnectionSrtp_ConstructSrtpPacket( PeerConnectionSes
 
     if( isLocked != 0U )
     {
-        pthread_mutex_unlock( &( pSession->srtpSessionMutex ) );
+        PeerConnectionSrtp_UnlockSession( pSession,
+                                          PEER_CONNECTION_SRTP_PATH_RTP_TX );
     }
 
     return ret;
@@ -215,7 +310,8 @@ PeerConnectionResult_t PeerConnectionSrtp_Init( PeerConnectionSession_t * pSessi
     PeerConnectionSrtpReceiver_t * pSrtpReceiver = NULL;
     int i;
     size_t maxSizePerPacket = PEER_CONNECTION_SRTP_RTP_PACKET_MAX_LENGTH;
-    uint8_t isLocked = 0U;
+    srtp_t newSessions[ PEER_CONNECTION_SRTP_PATH_MAX ] = { NULL };
+    uint8_t isRx;
 
     if( pSession == NULL )
     {
@@ -242,19 +338,6 @@ PeerConnectionResult_t PeerConnectionSrtp_Init( PeerConnectionSession_t * pSessi
         }
     }
 
-    if( ret == PEER_CONNECTION_RESULT_OK )
-    {
-        if( pthread_mutex_lock( &( pSession->srtpSessionMutex ) ) == 0 )
-        {
-            isLocked = 1U;
-        }
-        else
-        {
-            LogError( ( "Fail to take SRTP session mutex to create SRTP session instance." ) );
-            ret = PEER_CONNECTION_RESULT_FAIL_TAKE_SRTP_MUTEX;
-        }
-    }
-
     if( ret == PEER_CONNECTION_RESULT_OK )
     {
         memset( &receivePolicy, 0, sizeof( receivePolicy ) );
@@ -265,17 +348,6 @@ PeerConnectionResult_t PeerConnectionSrtp_Init( PeerConnectionSession_t * pSessi
         receivePolicy.ssrc.type = ssrc_any_inbound;
         receivePolicy.next = NULL;
 
-        errorStatus = srtp_create( &( pSession->srtpReceiveSession ),
-                                   &receivePolicy );
-        if( errorStatus != srtp_err_status_ok )
-        {
-            LogError( ( "Fail to create Rx SRTP session, errorStatus: %d", errorStatus ) );
-            ret = PEER_CONNECTION_RESULT_FAIL_CREATE_SRTP_RX_SESSION;
-        }
-    }
-
-    if( ret == PEER_CONNECTION_RESULT_OK )
-    {
         memset( &transmitPolicy, 0, sizeof( transmitPolicy ) );
         srtp_policy_setter( &transmitPolicy.rtp );
         srtcp_policy_setter( &transmitPolicy.rtcp );
@@ -284,18 +356,47 @@ PeerConnectionResult_t PeerConnectionSrtp_Init( PeerConnectionSession_t * pSessi
         transmitPolicy.ssrc.type = ssrc_any_outbound;
         transmitPolicy.next = NULL;
 
-        errorStatus = srtp_create( &( pSession->srtpTransmitSession ),
-                                   &transmitPolicy );
-        if( errorStatus != srtp_err_status_ok )
+        /* RTP and RTCP use separate sessions with the same keys, the SRTP and SRTCP
+         * indexes are independent so no state needs to be shared between them. */
+        for( i = 0; i < PEER_CONNECTION_SRTP_PATH_MAX; i++ )
         {
-            LogError( ( "Fail to create Tx SRTP session, errorStatus: %d", errorStatus ) );
-            ret = PEER_CONNECTION_RESULT_FAIL_CREATE_SRTP_TX_SESSION;
+            isRx = ( i == PEER_CONNECTION_SRTP_PATH_RTP_RX ) || ( i == PEER_CONNECTION_SRTP_PATH_RTCP_RX );
+            errorStatus = srtp_create( &( newSessions[ i ] ),
+                                       isRx ? &receivePolicy : &transmitPolicy );
+            if( errorStatus != srtp_err_status_ok )
+            {
+                LogError( ( "Fail to create %s SRTP session, path: %d, errorStatus: %d", isRx ? "Rx" : "Tx", i, errorStatus ) );
+                ret = isRx ? PEER_CONNECTION_RESULT_FAIL_CREATE_SRTP_RX_SESSION : PEER_CONNECTION_RESULT_FAIL_CREATE_SRTP_TX_SESSION;
+                break;
+            }
         }
     }
 
-    if( isLocked != 0U )
+    if( ret == PEER_CONNECTION_RESULT_OK )
     {
-        pthread_mutex_unlock( &( pSession->srtpSessionMutex ) );
+        for( i = 0; i < PEER_CONNECTION_SRTP_PATH_MAX; i++ )
+        {
+            if( PeerConnectionSrtp_LockSession( pSession, ( PeerConnectionSrtpPath_t ) i ) == PEER_CONNECTION_RESULT_OK )
+            {
+                pSession->srtpSessions[ i ].session = newSessions[ i ];
+                newSessions[ i ] = NULL;
+                PeerConnectionSrtp_UnlockSession( pSession, ( PeerConnectionSrtpPath_t ) i );
+            }
+            else
+            {
+                LogError( ( "Fail to take SRTP session mutex to set SRTP session instance, path: %d", i ) );
+                ret = PEER_CONNECTION_RESULT_FAIL_TAKE_SRTP_MUTEX;
+            }
+        }
+    }
+
+    /* Free the SRTP sessions that are not handed over on failure. */
+    for( i = 0; i < PEER_CONNECTION_SRTP_PATH_MAX; i++ )
+    {
+        if( newSessions[ i ] != NULL )
+        {
+            ( void ) srtp_dealloc( newSessions[ i ] );
+        }
     }
 
     if( ret == PEER_CONNECTION_RESULT_OK )
@@ -423,7 +524,7 @@ PeerConnectionResult_t PeerConnectionSrtp_DeInit( PeerConnectionSession_t * pSes
 {
     PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
     srtp_err_status_t errorStatus;
-    uint8_t isLocked = 0U;
+    int i;
 
     if( pSession == NULL )
     {
@@ -433,46 +534,34 @@ PeerConnectionResult_t PeerConnectionSrtp_DeInit( PeerConnectionSession_t * pSes
 
     if( ret == PEER_CONNECTION_RESULT_OK )
     {
-        if( pthread_mutex_lock( &( pSession->srtpSessionMutex ) ) == 0 )
+        /* Clean up SRTP sessions, each path is released under its own lock. */
+        for( i = 0; i < PEER_CONNECTION_SRTP_PATH_MAX; i++ )
         {
-            isLocked = 1U;
-        }
-        else
-        {
-            LogError( ( "Fail to take SRTP session mutex to release SRTP session." ) );
-        }
-    }
-
-    if( ret == PEER_CONNECTION_RESULT_OK )
-    {
-        /* Clean up SRTP sessions */
-        if( pSession->srtpReceiveSession != NULL )
-        {
-            errorStatus = srtp_dealloc( pSession->srtpReceiveSession );
-            if( errorStatus != srtp_err_status_ok )
+            if( PeerConnectionSrtp_LockSession( pSession, ( PeerConnectionSrtpPath_t ) i ) != PEER_CONNECTION_RESULT_OK )
             {
-                LogError( ( "Fail to deallocate Rx SRTP session, errorStatus: %d", errorStatus ) );
+                LogError( ( "Fail to take SRTP session mutex to release SRTP session, path: %d", i ) );
+                continue;
             }
-            pSession->srtpReceiveSession = NULL;
-        }
-    }
 
-    if( ret == PEER_CONNECTION_RESULT_OK )
-    {
-        if( pSession->srtpTransmitSession != NULL )
-        {
-            errorStatus = srtp_dealloc( pSession->srtpTransmitSession );
-            if( errorStatus != srtp_err_status_ok )
+            if( pSession->srtpSessions[ i ].session != NULL )
             {
-                LogError( ( "Fail to deallocate Tx SRTP session, errorStatus: %d", errorStatus ) );
+                errorStatus = srtp_dealloc( pSession->srtpSessions[ i ].session );
+                if( errorStatus != srtp_err_status_ok )
+                {
+                    LogError( ( "Fail to deallocate SRTP session, path: %d, errorStatus: %d", i, errorStatus ) );
+                }
+                pSession->srtpSessions[ i ].session = NULL;
             }
-            pSession->srtpTransmitSession = NULL;
-        }
-    }
 
-    if( isLocked != 0U )
-    {
-        pthread_mutex_unlock( &( pSession->srtpSessionMutex ) );
+            #if METRIC_PRINT_ENABLED
+            Metric_MergeHistogram( srtpLockWaitHistograms[ i ], &pSession->srtpSessions[ i ].lockWaitRecord );
+            Metric_MergeHistogram( srtpLockHoldHistograms[ i ], &pSession->srtpSessions[ i ].lockHoldRecord );
+            memset( &pSession->srtpSessions[ i ].lockWaitRecord, 0, sizeof( MetricHistogramRecord_t ) );
+            memset( &pSession->srtpSessions[ i ].lockHoldRecord, 0, sizeof( MetricHistogramRecord_t ) );
+            #endif /* METRIC_PRINT_ENABLED */
+
+            PeerConnectionSrtp_UnlockSession( pSession, ( PeerConnectionSrtpPath_t ) i );
+        }
     }
 
     if( ret == PEER_CONNECTION_RESULT_OK )
@@ -537,23 +626,24 @@ PeerConnectionResult_t PeerConnectionSrtp_HandleSrtpPacket( PeerConnectionSessio
 
     if( ret == PEER_CONNECTION_RESULT_OK )
     {
-        if( pthread_mutex_lock( &( pSession->srtpSessionMutex ) ) == 0 )
+        ret = PeerConnectionSrtp_LockSession( pSession,
+                                              PEER_CONNECTION_SRTP_PATH_RTP_RX );
+        if( ret == PEER_CONNECTION_RESULT_OK )
         {
             isLocked = 1U;
         }
         else
         {
-            LogError( ( "Fail to take SRTP session mutex to construct SRTCP packet." ) );
-            ret = PEER_CONNECTION_RESULT_FAIL_TAKE_SRTP_MUTEX;
+            LogError( ( "Fail to take SRTP session mutex to decrypt SRTP packet." ) );
         }
     }
 
     /* Decrypt it by SRTP. */
     if( ret == PEER_CONNECTION_RESULT_OK )
     {
-        if( pSession->srtpReceiveSession != NULL )
+        if( pSession->srtpSessions[ PEER_CONNECTION_SRTP_PATH_RTP_RX ].session != NULL )
         {
-            errorStatus = srtp_unprotect( pSession->srtpReceiveSession,
+            errorStatus = srtp_unprotect( pSession->srtpSessions[ PEER_CONNECTION_SRTP_PATH_RTP_RX ].session,
                                           pBuffer,
                                           bufferLength,
                                           rtpBuffer,
@@ -577,7 +667,8 @@ PeerConnectionResult_t PeerConnectionSrtp_HandleSrtpPacket( PeerConnectionSessio
 
     if( isLocked != 0U )
     {
-        pthread_mutex_unlock( &( pSession->srtpSessionMutex ) );
+        PeerConnectionSrtp_UnlockSession( pSession,
+                                          PEER_CONNECTION_SRTP_PATH_RTP_RX );
     }
 
     if( ret == PEER_CONNECTION_RESULT_OK )
@@ -32,6 +32,12 @@ extern "C" {
 
 #define PEER_CONNECTION_SRTP_RTP_PACKET_MAX_LENGTH      ( 1400 )
 
+PeerConnectionResult_t PeerConnectionSrtp_InitSessionLocks( PeerConnectionSession_t * pSession );
+/* Take the lock of one SRTP path, the session of that path stays valid until unlocked. */
+PeerConnectionResult_t PeerConnectionSrtp_LockSession( PeerConnectionSession_t * pSession,
+                                                       PeerConnectionSrtpPath_t path );
+void PeerConnectionSrtp_UnlockSession( PeerConnectionSession_t * pSession,
+                                       PeerConnectionSrtpPath_t path );
 PeerConnectionResult_t PeerConnectionSrtp_Init( PeerConnectionSession_t * pSession );
 PeerConnectionResult_t PeerConnectionSrtp_DeInit( PeerConnectionSession_t * pSession );
 PeerConnectionResult_t PeerConnectionSrtp_HandleSrtpPacket( PeerConnectionSession_t * pSession,
@@ -0,0 +1,899 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Data channel throughput and latency benchmark.
+ *
+ * Two SCTP sessions in the same process are connected through their outbound
+ * packet callbacks over a simulated link with optional one-way delay and
+ * random loss. Packets sent by the SCTP stack are queued on the link and fed
+ * to the other session by the event loop, which also drives the SCTP timers.
+ * No network access is needed.
+ *
+ * The saturation scenario keeps a reliable channel saturated while media
+ * probes share the link. A listener thread receives both, like the ICE socket
+ * listener, and reports how long media waits behind the data channel: once
+ * with SCTP processed inline on the listener, once with SCTP packets handed to
+ * a separate task through the SCTP receive queue.
+ *
+ * Usage: WebRTCLinuxSctpBenchmark [-d delay_ms] [-l loss_percent] [-b bytes_per_case] [-t timeout_sec] [-s saturation_sec]
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "logging.h"
+#include "networking_utils.h"
+#include "sctp_utils.h"
+
+/* Upper bound of packets in flight per link direction. */
+#define SCTP_BENCHMARK_LINK_QUEUE_LENGTH ( 8192 )
+
+/* Largest packet the SCTP stack hands to the outbound callback. */
+#define SCTP_BENCHMARK_MAX_PACKET_LENGTH ( 1500 )
+
+/* Bytes sent per channel type and message size, unless overridden by -b. */
+#define SCTP_BENCHMARK_DEFAULT_BYTES_PER_CASE ( 16 * 1024 * 1024 )
+
+/* Messages sent per case are clamped to this range. */
+#define SCTP_BENCHMARK_MIN_MESSAGES_PER_CASE ( 200 )
+#define SCTP_BENCHMARK_MAX_MESSAGES_PER_CASE ( 100000 )
+
+/* A case is abandoned if it doesn't complete in this time, unless overridden by -t. */
+#define SCTP_BENCHMARK_DEFAULT_TIMEOUT_SEC ( 60 )
+
+/* Partially reliable settings used for the PR-SCTP cases. */
+#define SCTP_BENCHMARK_PR_MAX_RETRANSMISSIONS ( 2 )
+#define SCTP_BENCHMARK_PR_MAX_LIFETIME_MS ( 200 )
+
+/* Every message starts with the send timestamp in microseconds. */
+#define SCTP_BENCHMARK_TIMESTAMP_LENGTH ( sizeof( uint64_t ) )
+
+/* Duration of each saturation mode, unless overridden by -s. */
+#define SCTP_BENCHMARK_DEFAULT_SATURATION_SEC ( 5 )
+
+/* Message size keeping the channel saturated. */
+#define SCTP_BENCHMARK_SATURATION_MESSAGE_SIZE ( 65536 )
+
+/* A media probe is sent every 20 ms, the length of an audio frame. */
+#define SCTP_BENCHMARK_MEDIA_INTERVAL_US ( 20000 )
+#define SCTP_BENCHMARK_MEDIA_PACKET_LENGTH ( 1200 )
+
+typedef struct SctpBenchmarkPacket
+{
+    uint64_t deliverTimeUs;
+    size_t length;
+    /* Media probes share the link but never reach the SCTP stack. */
+    uint8_t isMedia;
+    uint8_t data[ SCTP_BENCHMARK_MAX_PACKET_LENGTH ];
+} SctpBenchmarkPacket_t;
+
+/* One direction of the simulated link, packets are delivered in order. */
+typedef struct SctpBenchmarkLink
+{
+    SctpBenchmarkPacket_t packets[ SCTP_BENCHMARK_LINK_QUEUE_LENGTH ];
+    uint32_t head;
+    uint32_t count;
+    uint32_t droppedPackets;
+} SctpBenchmarkLink_t;
+
+typedef struct SctpBenchmarkEndpoint
+{
+    SctpSession_t sctpSession;
+    /* Packets sent by this endpoint. */
+    SctpBenchmarkLink_t link;
+
+    uint8_t isChannelAcked;
+
+    /* Receive statistics of the running case. */
+    uint32_t receivedMessages;
+    uint64_t receivedBytes;
+    uint64_t lastReceiveTimeUs;
+    uint64_t * pLatenciesUs;
+    uint32_t latencyCount;
+    uint32_t latencyCapacity;
+} SctpBenchmarkEndpoint_t;
+
+typedef struct SctpBenchmarkChannelCase
+{
+    const char * pName;
+    DcepChannelType_t channelType;
+    uint32_t numRetransmissions;
+    uint32_t maxLifetimeInMilliseconds;
+} SctpBenchmarkChannelCase_t;
+
+typedef struct SctpBenchmarkSaturationMode
+{
+    const char * pName;
+    /* Hand SCTP packets to the SCTP task instead of processing them on the listener. */
+    uint8_t useSctpTask;
+} SctpBenchmarkSaturationMode_t;
+
+static SctpBenchmarkEndpoint_t offerer;
+static SctpBenchmarkEndpoint_t answerer;
+
+static uint64_t linkDelayUs = 0;
+static uint32_t linkLossPercent = 0;
+static uint64_t lastTimerUs = 0;
+
+/* The SCTP stack is only entered with sctpMutex held, links are guarded by linkMutex. */
+static pthread_mutex_t sctpMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t linkMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* State of the running saturation mode. */
+static SctpReceiveQueue_t receiveQueue;
+static volatile uint8_t isListenerRunning = 0U;
+static volatile uint8_t isListenerStopping = 0U;
+static volatile uint8_t isSctpTaskStopping = 0U;
+static uint8_t useSctpTask = 0U;
+static uint64_t * pMediaDelaysUs = NULL;
+static uint32_t mediaDelayCount = 0;
+static uint32_t mediaDelayCapacity = 0;
+
+static const SctpBenchmarkChannelCase_t channelCases[] = {
+    { "reliable", DCEP_DATA_CHANNEL_RELIABLE, 0, 0 },
+    { "reliable-unordered", DCEP_DATA_CHANNEL_RELIABLE_UNORDERED, 0, 0 },
+    { "pr-rexmit", DCEP_DATA_CHANNEL_PARTIAL_RELIABLE_REXMIT, SCTP_BENCHMARK_PR_MAX_RETRANSMISSIONS, 0 },
+    { "pr-timed", DCEP_DATA_CHANNEL_PARTIAL_RELIABLE_TIMED, 0, SCTP_BENCHMARK_PR_MAX_LIFETIME_MS },
+};
+
+static const SctpBenchmarkSaturationMode_t saturationModes[] = {
+    { "inline", 0U },
+    { "sctp-task", 1U },
+};
+
+static const uint32_t messageSizes[] = { 64, 1024, 16384, 65536, 262144 };
+/*-----------------------------------------------------------*/
+
+static void PushPacket( SctpBenchmarkLink_t * pLink,
+                        const uint8_t * pPacket,
+                        uint32_t packetLength,
+                        uint8_t isMedia )
+{
+    SctpBenchmarkPacket_t * pTarget;
+
+    pthread_mutex_lock( &linkMutex );
+
+    if( ( packetLength > SCTP_BENCHMARK_MAX_PACKET_LENGTH ) ||
+        ( pLink->count == SCTP_BENCHMARK_LINK_QUEUE_LENGTH ) )
+    {
+        pLink->droppedPackets++;
+    }
+    else
+    {
+        pTarget = &( pLink->packets[ ( pLink->head + pLink->count ) % SCTP_BENCHMARK_LINK_QUEUE_LENGTH ] );
+        pTarget->deliverTimeUs = NetworkingUtils_GetCurrentTimeUs( NULL ) + linkDelayUs;
+        pTarget->length = packetLength;
+        pTarget->isMedia = isMedia;
+        memcpy( pTarget->data, pPacket, packetLength );
+        pLink->count++;
+    }
+
+    pthread_mutex_unlock( &linkMutex );
+}
+/*-----------------------------------------------------------*/
+
+/* Copy out the oldest packet of the link if it's due. */
+static uint8_t PopDuePacket( SctpBenchmarkLink_t * pLink,
+                             uint64_t currentTimeUs,
+                             SctpBenchmarkPacket_t * pPacket )
+{
+    uint8_t isPopped = 0U;
+
+    pthread_mutex_lock( &linkMutex );
+
+    if( ( pLink->count > 0U ) &&
+        ( pLink->packets[ pLink->head ].deliverTimeUs <= currentTimeUs ) )
+    {
+        memcpy( pPacket, &( pLink->packets[ pLink->head ] ), offsetof( SctpBenchmarkPacket_t, data ) + pLink->packets[ pLink->head ].length );
+        pLink->head = ( pLink->head + 1 ) % SCTP_BENCHMARK_LINK_QUEUE_LENGTH;
+        pLink->count--;
+        isPopped = 1U;
+    }
+
+    pthread_mutex_unlock( &linkMutex );
+
+    return isPopped;
+}
+/*-----------------------------------------------------------*/
+
+static void OnOutboundPacket( void * pUserData,
+                              uint8_t * pPacket,
+                              uint32_t packetLength )
+{
+    SctpBenchmarkLink_t * pLink = &( ( ( SctpBenchmarkEndpoint_t * ) pUserData )->link );
+
+    /* This runs inside the SCTP stack, so only queue the packet here. */
+    if( ( linkLossPercent > 0U ) && ( ( uint32_t ) ( rand() % 100 ) < linkLossPercent ) )
+    {
+        pthread_mutex_lock( &linkMutex );
+        pLink->droppedPackets++;
+        pthread_mutex_unlock( &linkMutex );
+    }
+    else
+    {
+        PushPacket( pLink, pPacket, packetLength, 0U );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void OnDataChannelOpen( void * pUserData,
+                               uint16_t channelId,
+                               const uint8_t * pName,
+                               uint16_t nameLength )
+{
+    ( void ) pUserData;
+
+    LogDebug( ( "Remote opened channel %u: %.*s", ( unsigned int ) channelId, ( int ) nameLength, pName ) );
+}
+/*-----------------------------------------------------------*/
+
+static SctpUtilsResult_t OnDataChannelAck( void * pUserData,
+                                           uint16_t channelId )
+{
+    ( void ) channelId;
+
+    ( ( SctpBenchmarkEndpoint_t * ) pUserData )->isChannelAcked = 1U;
+
+    return SCTP_UTILS_RESULT_OK;
+}
+/*-----------------------------------------------------------*/
+
+static void OnDataChannelMessage( void * pUserData,
+                                  uint16_t channelId,
+                                  uint8_t isBinary,
+                                  uint8_t * pData,
+                                  uint32_t dataLength )
+{
+    SctpBenchmarkEndpoint_t * pEndpoint = ( SctpBenchmarkEndpoint_t * ) pUserData;
+    uint64_t sendTimeUs;
+
+    ( void ) channelId;
+    ( void ) isBinary;
+
+    pEndpoint->lastReceiveTimeUs = NetworkingUtils_GetCurrentTimeUs( NULL );
+    pEndpoint->receivedMessages++;
+    pEndpoint->receivedBytes += dataLength;
+
+    if( ( dataLength >= SCTP_BENCHMARK_TIMESTAMP_LENGTH ) &&
+        ( pEndpoint->latencyCount < pEndpoint->latencyCapacity ) )
+    {
+        memcpy( &sendTimeUs, pData, SCTP_BENCHMARK_TIMESTAMP_LENGTH );
+        pEndpoint->pLatenciesUs[ pEndpoint->latencyCount++ ] = pEndpoint->lastReceiveTimeUs - sendTimeUs;
+    }
+}
+/*-----------------------------------------------------------*/
+
+/* Deliver due packets in both directions and run the SCTP timers. While the
+ * listener runs, it owns the offerer to answerer direction. */
+static void PumpLink( void )
+{
+    SctpBenchmarkEndpoint_t * endpoints[ 2 ] = { &offerer, &answerer };
+    SctpBenchmarkEndpoint_t * pPeer;
+    SctpBenchmarkLink_t * pLink;
+    static SctpBenchmarkPacket_t packet;
+    uint64_t currentTimeUs = NetworkingUtils_GetCurrentTimeUs( NULL );
+    uint32_t i;
+
+    for( i = ( isListenerRunning != 0U ) ? 1U : 0U; i < 2; i++ )
+    {
+        pLink = &( endpoints[ i ]->link );
+        pPeer = endpoints[ 1 - i ];
+
+        while( PopDuePacket( pLink, currentTimeUs, &packet ) != 0U )
+        {
+            /* The peer may queue more packets on this link while processing. */
+            pthread_mutex_lock( &sctpMutex );
+            ( void ) Sctp_ProcessMessage( &( pPeer->sctpSession ), packet.data, packet.length );
+            pthread_mutex_unlock( &sctpMutex );
+        }
+    }
+
+    if( currentTimeUs - lastTimerUs >= 1000U )
+    {
+        pthread_mutex_lock( &sctpMutex );
+        usrsctp_handle_timers( ( uint32_t ) ( ( currentTimeUs - lastTimerUs ) / 1000U ) );
+        pthread_mutex_unlock( &sctpMutex );
+        lastTimerUs = currentTimeUs;
+    }
+}
+/*-----------------------------------------------------------*/
+
+/* Pump the link until the condition holds or the timeout expires. */
+static uint8_t PumpUntil( volatile uint8_t * pCondition,
+                          uint64_t timeoutUs )
+{
+    uint64_t deadlineUs = NetworkingUtils_GetCurrentTimeUs( NULL ) + timeoutUs;
+
+    while( ( *pCondition == 0U ) && ( NetworkingUtils_GetCurrentTimeUs( NULL ) < deadlineUs ) )
+    {
+        PumpLink();
+        if( ( offerer.link.count == 0U ) && ( answerer.link.count == 0U ) )
+        {
+            usleep( 100 );
+        }
+    }
+
+    return *pCondition;
+}
+/*-----------------------------------------------------------*/
+
+static void InitEndpoint( SctpBenchmarkEndpoint_t * pEndpoint )
+{
+    memset( pEndpoint, 0, sizeof( SctpBenchmarkEndpoint_t ) );
+
+    pEndpoint->sctpSession.sctpSessionCallbacks.pUserData = pEndpoint;
+    pEndpoint->sctpSession.sctpSessionCallbacks.outboundPacketCallback = OnOutboundPacket;
+    pEndpoint->sctpSession.sctpSessionCallbacks.dataChannelOpenCallback = OnDataChannelOpen;
+    pEndpoint->sctpSession.sctpSessionCallbacks.dataChannelOpenAckCallback = OnDataChannelAck;
+    pEndpoint->sctpSession.sctpSessionCallbacks.dataChannelMessageCallback = OnDataChannelMessage;
+    pEndpoint->sctpSession.sctpSessionCallbacks.dataChannelBufferedAmountLowCallback = NULL;
+}
+/*-----------------------------------------------------------*/
+
+static int CompareLatency( const void * pA,
+                           const void * pB )
+{
+    uint64_t a = *( const uint64_t * ) pA;
+    uint64_t b = *( const uint64_t * ) pB;
+
+    return ( a > b ) - ( a < b );
+}
+/*-----------------------------------------------------------*/
+
+static SctpUtilsResult_t OpenChannel( const SctpDataChannelInitInfo_t * pInitInfo,
+                                      SctpDataChannel_t * pDataChannel )
+{
+    SctpUtilsResult_t retSctp;
+
+    pthread_mutex_lock( &sctpMutex );
+    retSctp = Sctp_OpenDataChannel( &( offerer.sctpSession ), pInitInfo, pDataChannel );
+    pthread_mutex_unlock( &sctpMutex );
+
+    return retSctp;
+}
+/*-----------------------------------------------------------*/
+
+static int32_t RunCase( const SctpBenchmarkChannelCase_t * pChannelCase,
+                        uint32_t messageSize,
+                        uint64_t bytesPerCase,
+                        uint64_t timeoutUs )
+{
+    int32_t ret = 0;
+    SctpDataChannelInitInfo_t initInfo;
+    SctpDataChannel_t dataChannel;
+    SctpUtilsResult_t retSctp;
+    uint8_t * pMessage = NULL;
+    uint32_t messageCount;
+    uint32_t sentMessages = 0;
+    uint64_t startTimeUs;
+    uint64_t deadlineUs;
+    uint64_t sendTimeUs;
+    double elapsedSec;
+    uint64_t p50Us = 0;
+    uint64_t p99Us = 0;
+
+    messageCount = ( uint32_t ) ( bytesPerCase / messageSize );
+    if( messageCount < SCTP_BENCHMARK_MIN_MESSAGES_PER_CASE )
+    {
+        messageCount = SCTP_BENCHMARK_MIN_MESSAGES_PER_CASE;
+    }
+    else if( messageCount > SCTP_BENCHMARK_MAX_MESSAGES_PER_CASE )
+    {
+        messageCount = SCTP_BENCHMARK_MAX_MESSAGES_PER_CASE;
+    }
+    else
+    {
+        /* Empty else marker. */
+    }
+
+    pMessage = ( uint8_t * ) malloc( messageSize );
+    answerer.pLatenciesUs = ( uint64_t * ) malloc( messageCount * sizeof( uint64_t ) );
+    if( ( pMessage == NULL ) || ( answerer.pLatenciesUs == NULL ) )
+    {
+        LogError( ( "Fail to allocate benchmark buffers" ) );
+        ret = -1;
+    }
+
+    if( ret == 0 )
+    {
+        memset( pMessage, 0xA5, messageSize );
+        answerer.latencyCapacity = messageCount;
+        answerer.latencyCount = 0;
+        answerer.receivedMessages = 0;
+        answerer.receivedBytes = 0;
+        offerer.isChannelAcked = 0U;
+
+        memset( &initInfo, 0, sizeof( SctpDataChannelInitInfo_t ) );
+        initInfo.channelType = pChannelCase->channelType;
+        initInfo.numRetransmissions = pChannelCase->numRetransmissions;
+        initInfo.maxLifetimeInMilliseconds = pChannelCase->maxLifetimeInMilliseconds;
+        initInfo.pChannelName = pChannelCase->pName;
+        initInfo.channelNameLen = strlen( pChannelCase->pName );
+        memset( &dataChannel, 0, sizeof( SctpDataChannel_t ) );
+
+        if( ( OpenChannel( &initInfo, &dataChannel ) != SCTP_UTILS_RESULT_OK ) ||
+            ( PumpUntil( &( offerer.isChannelAcked ), timeoutUs ) == 0U ) )
+        {
+            LogError( ( "Fail to open %s channel", pChannelCase->pName ) );
+            ret = -1;
+        }
+    }
+
+    if( ret == 0 )
+    {
+        startTimeUs = NetworkingUtils_GetCurrentTimeUs( NULL );
+        deadlineUs = startTimeUs + timeoutUs;
+
+        while( ( sentMessages < messageCount ) && ( NetworkingUtils_GetCurrentTimeUs( NULL ) < deadlineUs ) )
+        {
+            sendTimeUs = NetworkingUtils_GetCurrentTimeUs( NULL );
+            memcpy( pMessage, &sendTimeUs, messageSize < SCTP_BENCHMARK_TIMESTAMP_LENGTH ? messageSize : SCTP_BENCHMARK_TIMESTAMP_LENGTH );
+
+            pthread_mutex_lock( &sctpMutex );
+            retSctp = Sctp_SendMessage( &( offerer.sctpSession ), &dataChannel, 1U, pMessage, messageSize );
+            pthread_mutex_unlock( &sctpMutex );
+            if( retSctp == SCTP_UTILS_RESULT_OK )
+            {
+                sentMessages++;
+            }
+            else if( retSctp != SCTP_UTILS_RESULT_SEND_QUEUE_FULL )
+            {
+                LogError( ( "Sctp_SendMessage failed, result: %d", retSctp ) );
+                ret = -1;
+                break;
+            }
+            else
+            {
+                /* Backpressure, let the link drain before retrying. */
+            }
+
+            PumpLink();
+        }
+
+        /* Wait for the tail, lost partially reliable messages never arrive. */
+        answerer.lastReceiveTimeUs = NetworkingUtils_GetCurrentTimeUs( NULL );
+        while( ( answerer.receivedMessages < sentMessages ) &&
+               ( NetworkingUtils_GetCurrentTimeUs( NULL ) < deadlineUs ) &&
+               ( NetworkingUtils_GetCurrentTimeUs( NULL ) - answerer.lastReceiveTimeUs < 2U * ( linkDelayUs + 1000000U ) ) )
+        {
+            PumpLink();
+        }
+
+        elapsedSec = ( double ) ( answerer.lastReceiveTimeUs - startTimeUs ) / 1000000.0;
+        if( elapsedSec <= 0.0 )
+        {
+            elapsedSec = 1e-6;
+        }
+
+        if( answerer.latencyCount > 0U )
+        {
+            qsort( answerer.pLatenciesUs, answerer.latencyCount, sizeof( uint64_t ), CompareLatency );
+            p50Us = answerer.pLatenciesUs[ answerer.latencyCount / 2 ];
+            p99Us = answerer.pLatenciesUs[ ( answerer.latencyCount * 99 ) / 100 ];
+        }
+
+        printf( "%-20s %8u %8u/%-8u %12.0f %10.2f %12.3f %12.3f\n",
+                pChannelCase->pName,
+                ( unsigned int ) messageSize,
+                ( unsigned int ) answerer.receivedMessages,
+                ( unsigned int ) sentMessages,
+                answerer.receivedMessages / elapsedSec,
+                answerer.receivedBytes / elapsedSec / ( 1024.0 * 1024.0 ),
+                p50Us / 1000.0,
+                p99Us / 1000.0 );
+
+        pthread_mutex_lock( &sctpMutex );
+        ( void ) Sctp_CloseDataChannel( &( offerer.sctpSession ), &dataChannel );
+        pthread_mutex_unlock( &sctpMutex );
+    }
+
+    free( pMessage );
+    free( answerer.pLatenciesUs );
+    answerer.pLatenciesUs = NULL;
+    answerer.latencyCapacity = 0;
+
+    return ret;
+}
+/*-----------------------------------------------------------*/
+
+/* Receives the offerer to answerer direction, like the ICE socket listener:
+ * media probes are delivered right away, SCTP packets either go through the
+ * SCTP stack inline or are handed to the SCTP task. */
+static void * ListenerTask( void * pParameter )
+{
+    static SctpBenchmarkPacket_t packet;
+    uint64_t currentTimeUs;
+    uint8_t isIdle;
+
+    ( void ) pParameter;
+
+    while( isListenerStopping == 0U )
+    {
+        isIdle = 1U;
+        currentTimeUs = NetworkingUtils_GetCurrentTimeUs( NULL );
+
+        while( PopDuePacket( &( offerer.link ), currentTimeUs, &packet ) != 0U )
+        {
+            isIdle = 0U;
+
+            if( packet.isMedia != 0U )
+            {
+                if( mediaDelayCount < mediaDelayCapacity )
+                {
+                    pMediaDelaysUs[ mediaDelayCount++ ] = NetworkingUtils_GetCurrentTimeUs( NULL ) - packet.deliverTimeUs;
+                }
+            }
+            else if( useSctpTask != 0U )
+            {
+                /* Dropped packets are counted by the queue and recovered by SCTP. */
+                ( void ) Sctp_PushReceivedPacket( &receiveQueue, packet.data, ( uint32_t ) packet.length );
+            }
+            else
+            {
+                pthread_mutex_lock( &sctpMutex );
+                ( void ) Sctp_ProcessMessage( &( answerer.sctpSession ), packet.data, ( uint32_t ) packet.length );
+                pthread_mutex_unlock( &sctpMutex );
+            }
+        }
+
+        if( isIdle != 0U )
+        {
+            usleep( 50 );
+        }
+    }
+
+    return NULL;
+}
+/*-----------------------------------------------------------*/
+
+/* Same as PeerConnectionSCTP_Task, feeds queued packets to the answerer. */
+static void * SctpTask( void * pParameter )
+{
+    SctpReceivedPacket_t * pReceived;
+
+    ( void ) pParameter;
+
+    for( ; ; )
+    {
+        pReceived = Sctp_PopReceivedPacket( &receiveQueue );
+        if( ( pReceived == NULL ) || ( isSctpTaskStopping != 0U ) )
+        {
+            free( pReceived );
+            break;
+        }
+
+        pthread_mutex_lock( &sctpMutex );
+        ( void ) Sctp_ProcessMessage( &( answerer.sctpSession ), pReceived->packet, pReceived->packetLength );
+        pthread_mutex_unlock( &sctpMutex );
+
+        free( pReceived );
+    }
+
+    return NULL;
+}
+/*-----------------------------------------------------------*/
+
+/* Let packets still in flight settle before the next mode starts. */
+static void DrainLink( void )
+{
+    uint64_t deadlineUs = NetworkingUtils_GetCurrentTimeUs( NULL ) + 2U * linkDelayUs + 1000000U;
+
+    while( NetworkingUtils_GetCurrentTimeUs( NULL ) < deadlineUs )
+    {
+        PumpLink();
+        usleep( 100 );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static int32_t RunSaturationMode( const SctpBenchmarkSaturationMode_t * pMode,
+                                  uint64_t durationUs,
+                                  uint64_t timeoutUs )
+{
+    int32_t ret = 0;
+    SctpDataChannelInitInfo_t initInfo;
+    SctpDataChannel_t dataChannel;
+    SctpUtilsResult_t retSctp;
+    uint8_t * pMessage = NULL;
+    uint8_t mediaPacket[ SCTP_BENCHMARK_MEDIA_PACKET_LENGTH ];
+    pthread_t listenerTask;
+    pthread_t sctpTask;
+    uint8_t isListenerCreated = 0U;
+    uint8_t isSctpTaskCreated = 0U;
+    uint8_t isQueueInitialized = 0U;
+    uint64_t startTimeUs;
+    uint64_t endTimeUs;
+    uint64_t nextMediaUs;
+    uint64_t currentTimeUs;
+    uint64_t startReceivedBytes = 0;
+    uint64_t p50Us = 0;
+    uint64_t p99Us = 0;
+    uint64_t maxUs = 0;
+    uint32_t mediaSent = 0;
+    uint8_t wakeByte = 0;
+
+    mediaDelayCapacity = ( uint32_t ) ( durationUs / SCTP_BENCHMARK_MEDIA_INTERVAL_US ) + 1U;
+    mediaDelayCount = 0;
+    pMediaDelaysUs = ( uint64_t * ) malloc( mediaDelayCapacity * sizeof( uint64_t ) );
+    pMessage = ( uint8_t * ) malloc( SCTP_BENCHMARK_SATURATION_MESSAGE_SIZE );
+    if( ( pMessage == NULL ) || ( pMediaDelaysUs == NULL ) )
+    {
+        LogError( ( "Fail to allocate saturation buffers" ) );
+        ret = -1;
+    }
+
+    if( ret == 0 )
+    {
+        memset( pMessage, 0x5A, SCTP_BENCHMARK_SATURATION_MESSAGE_SIZE );
+        memset( mediaPacket, 0x80, sizeof( mediaPacket ) );
+        offerer.isChannelAcked = 0U;
+
+        memset( &initInfo, 0, sizeof( SctpDataChannelInitInfo_t ) );
+        initInfo.channelType = DCEP_DATA_CHANNEL_RELIABLE;
+        initInfo.pChannelName = pMode->pName;
+        initInfo.channelNameLen = strlen( pMode->pName );
+        memset( &dataChannel, 0, sizeof( SctpDataChannel_t ) );
+
+        if( ( OpenChannel( &initInfo, &dataChannel ) != SCTP_UTILS_RESULT_OK ) ||
+            ( PumpUntil( &( offerer.isChannelAcked ), timeoutUs ) == 0U ) )
+        {
+            LogError( ( "Fail to open saturation channel" ) );
+            ret = -1;
+        }
+    }
+
+    if( ( ret == 0 ) && ( pMode->useSctpTask != 0U ) )
+    {
+        if( Sctp_InitReceiveQueue( &receiveQueue, SCTP_MAX_RECEIVE_QUEUE_SIZE ) != SCTP_UTILS_RESULT_OK )
+        {
+            ret = -1;
+        }
+        else
+        {
+            isQueueInitialized = 1U;
+            isSctpTaskStopping = 0U;
+            if( pthread_create( &sctpTask, NULL, SctpTask, NULL ) != 0 )
+            {
+                LogError( ( "Fail to create SCTP task" ) );
+                ret = -1;
+            }
+            else
+            {
+                isSctpTaskCreated = 1U;
+            }
+        }
+    }
+
+    if( ret == 0 )
+    {
+        useSctpTask = pMode->useSctpTask;
+        isListenerStopping = 0U;
+        isListenerRunning = 1U;
+        if( pthread_create( &listenerTask, NULL, ListenerTask, NULL ) != 0 )
+        {
+            LogError( ( "Fail to create listener task" ) );
+            isListenerRunning = 0U;
+            ret = -1;
+        }
+        else
+        {
+            isListenerCreated = 1U;
+        }
+    }
+
+    if( ret == 0 )
+    {
+        startReceivedBytes = answerer.receivedBytes;
+        startTimeUs = NetworkingUtils_GetCurrentTimeUs( NULL );
+        endTimeUs = startTimeUs + durationUs;
+        nextMediaUs = startTimeUs;
+
+        while( ( currentTimeUs = NetworkingUtils_GetCurrentTimeUs( NULL ) ) < endTimeUs )
+        {
+            if( currentTimeUs >= nextMediaUs )
+            {
+                PushPacket( &( offerer.link ), mediaPacket, sizeof( mediaPacket ), 1U );
+                mediaSent++;
+                nextMediaUs += SCTP_BENCHMARK_MEDIA_INTERVAL_US;
+            }
+
+            /* Keep the send queue full. */
+            do
+            {
+                pthread_mutex_lock( &sctpMutex );
+                retSctp = Sctp_SendMessage( &( offerer.sctpSession ), &dataChannel, 1U, pMessage, SCTP_BENCHMARK_SATURATION_MESSAGE_SIZE );
+                pthread_mutex_unlock( &sctpMutex );
+            } while( retSctp == SCTP_UTILS_RESULT_OK );
+
+            if( retSctp != SCTP_UTILS_RESULT_SEND_QUEUE_FULL )
+            {
+                LogError( ( "Sctp_SendMessage failed, result: %d", retSctp ) );
+                ret = -1;
+                break;
+            }
+
+            PumpLink();
+        }
+    }
+
+    if( isListenerCreated != 0U )
+    {
+        isListenerStopping = 1U;
+        pthread_join( listenerTask, NULL );
+        isListenerRunning = 0U;
+    }
+
+    if( isSctpTaskCreated != 0U )
+    {
+        isSctpTaskStopping = 1U;
+        /* Wake the task up if the queue is empty. */
+        ( void ) Sctp_PushReceivedPacket( &receiveQueue, &wakeByte, 1U );
+        pthread_join( sctpTask, NULL );
+    }
+
+    if( ret == 0 )
+    {
+        if( mediaDelayCount > 0U )
+        {
+            qsort( pMediaDelaysUs, mediaDelayCount, sizeof( uint64_t ), CompareLatency );
+            p50Us = pMediaDelaysUs[ mediaDelayCount / 2 ];
+            p99Us = pMediaDelaysUs[ ( mediaDelayCount * 99 ) / 100 ];
+            maxUs = pMediaDelaysUs[ mediaDelayCount - 1 ];
+        }
+
+        printf( "%-20s %10.2f %8u/%-8u %12.3f %12.3f %12.3f %12u\n",
+                pMode->pName,
+                ( answerer.receivedBytes - startReceivedBytes ) / ( durationUs / 1000000.0 ) / ( 1024.0 * 1024.0 ),
+                ( unsigned int ) mediaDelayCount,
+                ( unsigned int ) mediaSent,
+                p50Us / 1000.0,
+                p99Us / 1000.0,
+                maxUs / 1000.0,
+                ( unsigned int ) ( ( isQueueInitialized != 0U ) ? receiveQueue.droppedPackets : 0U ) );
+
+        pthread_mutex_lock( &sctpMutex );
+        ( void ) Sctp_CloseDataChannel( &( offerer.sctpSession ), &dataChannel );
+        pthread_mutex_unlock( &sctpMutex );
+
+        DrainLink();
+    }
+
+    if( isQueueInitialized != 0U )
+    {
+        Sctp_FreeReceiveQueue( &receiveQueue );
+    }
+
+    free( pMessage );
+    free( pMediaDelaysUs );
+    pMediaDelaysUs = NULL;
+    mediaDelayCapacity = 0;
+
+    return ret;
+}
+/*-----------------------------------------------------------*/
+
+int main( int argc,
+          char * argv[] )
+{
+    int32_t ret = 0;
+    int option;
+    uint64_t bytesPerCase = SCTP_BENCHMARK_DEFAULT_BYTES_PER_CASE;
+    uint64_t timeoutUs = SCTP_BENCHMARK_DEFAULT_TIMEOUT_SEC * 1000000ULL;
+    uint64_t saturationUs = SCTP_BENCHMARK_DEFAULT_SATURATION_SEC * 1000000ULL;
+    uint8_t isSctpInitialized = 0U;
+    uint32_t i;
+    uint32_t j;
+
+    while( ( option = getopt( argc, argv, "d:l:b:t:s:" ) ) != -1 )
+    {
+        switch( option )
+        {
+            case 'd':
+                linkDelayUs = strtoull( optarg, NULL, 10 ) * 1000U;
+                break;
+            case 'l':
+                linkLossPercent = ( uint32_t ) strtoul( optarg, NULL, 10 );
+                break;
+            case 'b':
+                bytesPerCase = strtoull( optarg, NULL, 10 );
+                break;
+            case 't':
+                timeoutUs = strtoull( optarg, NULL, 10 ) * 1000000ULL;
+                break;
+            case 's':
+                saturationUs = strtoull( optarg, NULL, 10 ) * 1000000ULL;
+                break;
+            default:
+                printf( "Usage: %s [-d delay_ms] [-l loss_percent] [-b bytes_per_case] [-t timeout_sec] [-s saturation_sec]\n", argv[ 0 ] );
+                ret = -1;
+                break;
+        }
+    }
+
+    if( ( ret == 0 ) && ( ( linkLossPercent >= 100U ) || ( bytesPerCase == 0U ) ) )
+    {
+        printf( "Loss must be below 100%% and bytes per case above 0\n" );
+        ret = -1;
+    }
+
+    if( ret == 0 )
+    {
+        srand( 1 );
+        ( void ) Sctp_Init();
+        isSctpInitialized = 1U;
+        lastTimerUs = NetworkingUtils_GetCurrentTimeUs( NULL );
+
+        InitEndpoint( &offerer );
+        InitEndpoint( &answerer );
+
+        /* Both sides connect, SCTP resolves the simultaneous open. */
+        if( ( Sctp_CreateSession( &( offerer.sctpSession ), 0, SCTP_MAX_MESSAGE_SIZE ) != SCTP_UTILS_RESULT_OK ) ||
+            ( Sctp_CreateSession( &( answerer.sctpSession ), 1, SCTP_MAX_MESSAGE_SIZE ) != SCTP_UTILS_RESULT_OK ) )
+        {
+            LogError( ( "Fail to create SCTP sessions" ) );
+            ret = -1;
+        }
+    }
+
+    if( ret == 0 )
+    {
+        printf( "Link: one-way delay %llu ms, loss %u%%\n",
+                ( unsigned long long ) ( linkDelayUs / 1000U ),
+                ( unsigned int ) linkLossPercent );
+        printf( "%-20s %8s %17s %12s %10s %12s %12s\n",
+                "channel", "size", "recv/sent", "msg/s", "MB/s", "p50 ms", "p99 ms" );
+
+        for( i = 0; ( ret == 0 ) && ( i < sizeof( channelCases ) / sizeof( channelCases[ 0 ] ) ); i++ )
+        {
+            for( j = 0; ( ret == 0 ) && ( j < sizeof( messageSizes ) / sizeof( messageSizes[ 0 ] ) ); j++ )
+            {
+                ret = RunCase( &( channelCases[ i ] ), messageSizes[ j ], bytesPerCase, timeoutUs );
+            }
+        }
+
+        if( ( ret == 0 ) && ( saturationUs > 0U ) )
+        {
+            printf( "Saturated reliable channel with a media probe every %u ms, media delay at the listener:\n",
+                    ( unsigned int ) ( SCTP_BENCHMARK_MEDIA_INTERVAL_US / 1000U ) );
+            printf( "%-20s %10s %17s %12s %12s %12s %12s\n",
+                    "mode", "MB/s", "media recv/sent", "p50 ms", "p99 ms", "max ms", "queue drops" );
+
+            for( i = 0; ( ret == 0 ) && ( i < sizeof( saturationModes ) / sizeof( saturationModes[ 0 ] ) ); i++ )
+            {
+                ret = RunSaturationMode( &( saturationModes[ i ] ), saturationUs, timeoutUs );
+            }
+        }
+
+        printf( "Dropped packets, offerer: %u, answerer: %u\n",
+                ( unsigned int ) offerer.link.droppedPackets,
+                ( unsigned int ) answerer.link.droppedPackets );
+    }
+
+    if( isSctpInitialized != 0U )
+    {
+        ( void ) Sctp_FreeSession( &( offerer.sctpSession ) );
+        ( void ) Sctp_FreeSession( &( answerer.sctpSession ) );
+        Sctp_DeInit();
+    }
+
+    return ( ret == 0 ) ? 0 : 1;
+}
@@ -126,6 +126,8 @@
 #define SDP_CONTROLLER_DATA_CHANNEL_ATTRIBUTE_NAME_SCTP_PORT_LENGTH ( 9 )
 #define SDP_CONTROLLER_DATA_CHANNEL_ATTRIBUTE_VALUE_SCTP_PORT "5000"
 #define SDP_CONTROLLER_DATA_CHANNEL_ATTRIBUTE_VALUE_SCTP_PORT_LENGTH ( 4 )
+#define SDP_CONTROLLER_DATA_CHANNEL_ATTRIBUTE_NAME_MAX_MESSAGE_SIZE "max-message-size"
+#define SDP_CONTROLLER_DATA_CHANNEL_ATTRIBUTE_NAME_MAX_MESSAGE_SIZE_LENGTH ( 16 )
 
 // profile-level-id:
 //   A base16 [7] (hexadecimal) representation of the following
@@ -286,7 +288,7 @@ static SdpControllerResult_t ParseExtraAttributes( SdpControllerSdpDescription_t
         {
             /* Found setup, store it as extra info. */
             if( ( pAttribute->attributeValueLength == SDP_CONTROLLER_MEDIA_DTLS_ROLE_ACTIVE_LENGTH ) &&
-                ( strncmp( SDP_CONTROLLER_MEDIA_DTLS_ROLE_ACTIVE, pAttribute->pAttributeName, SDP_CONTROLLER_MEDIA_DTLS_ROLE_ACTIVE_LENGTH ) == 0 ) )
+                ( strncmp( SDP_CONTROLLER_MEDIA_DTLS_ROLE_ACTIVE, pAttribute->pAttributeValue, SDP_CONTROLLER_MEDIA_DTLS_ROLE_ACTIVE_LENGTH ) == 0 ) )
             {
                 pOffer->quickAccess.dtlsRole = SDP_CONTROLLER_DTLS_ROLE_ACTIVE;
             }
@@ -339,6 +341,22 @@ static SdpControllerResult_t ParseExtraAttributes( SdpControllerSdpDescription_t
                 }
             }
         }
+        else if( ( pAttribute->attributeNameLength == SDP_CONTROLLER_DATA_CHANNEL_ATTRIBUTE_NAME_MAX_MESSAGE_SIZE_LENGTH ) &&
+                 ( strncmp( SDP_CONTROLLER_DATA_CHANNEL_ATTRIBUTE_NAME_MAX_MESSAGE_SIZE, pAttribute->pAttributeName, SDP_CONTROLLER_DATA_CHANNEL_ATTRIBUTE_NAME_MAX_MESSAGE_SIZE_LENGTH ) == 0 ) )
+        {
+            /* RFC 8841: 0 means the remote can receive messages of any size. */
+            stringResult = StringUtils_ConvertStringToUl( pAttribute->pAttributeValue, pAttribute->attributeValueLength, &pOffer->quickAccess.maxMessageSize );
+            if( stringResult != STRING_UTILS_RESULT_OK )
+            {
+                LogWarn( ( "Ignore invalid max-message-size: %.*s",
+                           ( int ) pAttribute->attributeValueLength, pAttribute->pAttributeValue ) );
+                pOffer->quickAccess.maxMessageSize = 0U;
+            }
+            else
+            {
+                pOffer->quickAccess.isMaxMessageSizeSet = 1U;
+            }
+        }
         else if( ( pAttribute->attributeNameLength == SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_CANDIDATE_LENGTH ) &&
                  ( strncmp( SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_CANDIDATE, pAttribute->pAttributeName, SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_CANDIDATE_LENGTH ) == 0 ) )
         {
@@ -721,7 +739,7 @@ static SdpControllerResult_t PopulateTransceiverSsrc( char ** ppBuffer,
             ret = SDP_CONTROLLER_RESULT_SDP_FAIL_SNPRINTF;
             LogError( ( "snprintf return unexpected value %d", written ) );
         }
-        else if( written == remainSize )
+        else if( ( size_t ) written >= remainSize )
         {
             ret = SDP_CONTROLLER_RESULT_SDP_POPULATE_BUFFER_TOO_SMALL;
             LogError( ( "buffer has no space for SSRC CNAME" ) );
@@ -753,7 +771,7 @@ static SdpControllerResult_t PopulateTransceiverSsrc( char ** ppBuffer,
             ret = SDP_CONTROLLER_RESULT_SDP_FAIL_SNPRINTF;
             LogError( ( "snprintf return unexpected value %d", written ) );
         }
-        else if( written == remainSize )
+        else if( ( size_t ) written >= remainSize )
         {
             ret = SDP_CONTROLLER_RESULT_SDP_POPULATE_BUFFER_TOO_SMALL;
             LogError( ( "buffer has no space for SSRC msid" ) );
@@ -784,7 +802,7 @@ static SdpControllerResult_t PopulateTransceiverSsrc( char ** ppBuffer,
             ret = SDP_CONTROLLER_RESULT_SDP_FAIL_SNPRINTF;
             LogError( ( "snprintf return unexpected value %d", written ) );
         }
-        else if( written == remainSize )
+        else if( ( size_t ) written >= remainSize )
         {
             ret = SDP_CONTROLLER_RESULT_SDP_POPULATE_BUFFER_TOO_SMALL;
             LogError( ( "buffer has no space for SSRC mslabel" ) );
@@ -815,7 +833,7 @@ static SdpControllerResult_t PopulateTransceiverSsrc( char ** ppBuffer,
             ret = SDP_CONTROLLER_RESULT_SDP_FAIL_SNPRINTF;
             LogError( ( "snprintf return unexpected value %d", written ) );
         }
-        else if( written == remainSize )
+        else if( ( size_t ) written >= remainSize )
         {
             ret = SDP_CONTROLLER_RESULT_SDP_POPULATE_BUFFER_TOO_SMALL;
             LogError( ( "buffer has no space for SSRC label" ) );
@@ -846,7 +864,7 @@ static SdpControllerResult_t PopulateTransceiverSsrc( char ** ppBuffer,
             ret = SDP_CONTROLLER_RESULT_SDP_FAIL_SNPRINTF;
             LogError( ( "snprintf return unexpected value %d", written ) );
         }
-        else if( written == remainSize )
+        else if( ( size_t ) written >= remainSize )
         {
             ret = SDP_CONTROLLER_RESULT_SDP_POPULATE_BUFFER_TOO_SMALL;
             LogError( ( "buffer has no space for RTX SSRC CNAME" ) );
@@ -878,7 +896,7 @@ static SdpControllerResult_t PopulateTransceiverSsrc( char ** ppBuffer,
             ret = SDP_CONTROLLER_RESULT_SDP_FAIL_SNPRINTF;
             LogError( ( "snprintf return unexpected value %d", written ) );
         }
-        else if( written == remainSize )
+        else if( ( size_t ) written >= remainSize )
         {
             ret = SDP_CONTROLLER_RESULT_SDP_POPULATE_BUFFER_TOO_SMALL;
             LogError( ( "buffer has no space for RTX SSRC msid" ) );
@@ -909,7 +927,7 @@ static SdpControllerResult_t PopulateTransceiverSsrc( char ** ppBuffer,
             ret = SDP_CONTROLLER_RESULT_SDP_FAIL_SNPRINTF;
             LogError( ( "snprintf return unexpected value %d", written ) );
         }
-        else if( written == remainSize )
+        else if( ( size_t ) written >= remainSize )
         {
             ret = SDP_CONTROLLER_RESULT_SDP_POPULATE_BUFFER_TOO_SMALL;
             LogError( ( "buffer has no space for RTX SSRC mslabel" ) );
@@ -940,7 +958,7 @@ static SdpControllerResult_t PopulateTransceiverSsrc( char ** ppBuffer,
             ret = SDP_CONTROLLER_RESULT_SDP_FAIL_SNPRINTF;
             LogError( ( "snprintf return unexpected value %d", written ) );
         }
-        else if( written == remainSize )
+        else if( ( size_t ) written >= remainSize )
         {
             ret = SDP_CONTROLLER_RESULT_SDP_POPULATE_BUFFER_TOO_SMALL;
             LogError( ( "buffer has no space for RTX SSRC label" ) );
@@ -1007,7 +1025,7 @@ static SdpControllerResult_t PopulateRtcpFb( uint32_t payload,
             ret = SDP_CONTROLLER_RESULT_SDP_FAIL_SNPRINTF;
             LogError( ( "snprintf return unexpected value %d", written ) );
         }
-        else if( written == remainSize )
+        else if( ( size_t ) written >= remainSize )
         {
             ret = SDP_CONTROLLER_RESULT_SDP_POPULATE_BUFFER_TOO_SMALL;
             LogError( ( "buffer has no space for rtcp-fb H264 value" ) );
@@ -1038,7 +1056,7 @@ static SdpControllerResult_t PopulateRtcpFb( uint32_t payload,
             ret = SDP_CONTROLLER_RESULT_SDP_FAIL_SNPRINTF;
             LogError( ( "snprintf return unexpected value %d", written ) );
         }
-        else if( written == remainSize )
+        else if( ( size_t ) written >= remainSize )
         {
             ret = SDP_CONTROLLER_RESULT_SDP_POPULATE_BUFFER_TOO_SMALL;
             LogError( ( "buffer has no space for rtcp-fb transport-cc" ) );
@@ -1097,7 +1115,7 @@ static SdpControllerResult_t PopulateCodecAttributesH264Profile42E01FLevelAsymme
         ret = SDP_CONTROLLER_RESULT_SDP_FAIL_SNPRINTF;
         LogError( ( "snprintf return unexpected value %d", written ) );
     }
-    else if( written == remainSize )
+    else if( ( size_t ) written >= remainSize )
     {
         ret = SDP_CONTROLLER_RESULT_SDP_POPULATE_BUFFER_TOO_SMALL;
         LogError( ( "buffer has no space for rtpmap H264 value" ) );
@@ -1127,7 +1145,7 @@ static SdpControllerResult_t PopulateCodecAttributesH264Profile42E01FLevelAsymme
             ret = SDP_CONTROLLER_RESULT_SDP_FAIL_SNPRINTF;
             LogError( ( "snprintf return unexpected value %d", written ) );
         }
-        else if( written == remainSize )
+        else if( ( size_t ) written >= remainSize )
         {
             ret = SDP_CONTROLLER_RESULT_SDP_POPULATE_BUFFER_TOO_SMALL;
             LogError( ( "buffer has no space for rtcp-fb H264 value" ) );
@@ -1180,7 +1198,7 @@ static SdpControllerResult_t PopulateCodecAttributesH264Profile42E01FLevelAsymme
                 ret = SDP_CONTROLLER_RESULT_SDP_FAIL_SNPRINTF;
                 LogError( ( "snprintf return unexpected value %d", written ) );
             }
-            else if( written == remainSize )
+            else if( ( size_t ) written >= remainSize )
             {
                 ret = SDP_CONTROLLER_RESULT_SDP_POPULATE_BUFFER_TOO_SMALL;
                 LogError( ( "buffer has no space for fmtp" ) );
@@ -1214,7 +1232,7 @@ static SdpControllerResult_t PopulateCodecAttributesH264Profile42E01FLevelAsymme
                 ret = SDP_CONTROLLER_RESULT_SDP_FAIL_SNPRINTF;
                 LogError( ( "snprintf return unexpected value %d", written ) );
             }
-            else if( written == remainSize )
+            else if( ( size_t ) written >= remainSize )
             {
                 ret = SDP_CONTROLLER_RESULT_SDP_POPULATE_BUFFER_TOO_SMALL;
                 LogError( ( "buffer has no space for rtpmap H264 RTX value" ) );
@@ -1249,7 +1267,7 @@ static SdpControllerResult_t PopulateCodecAttributesH264Profile42E01FLevelAsymme
                 ret = SDP_CONTROLLER_RESULT_SDP_FAIL_SNPRINTF;
                 LogError( ( "snprintf return unexpected value %d", written ) );
             }
-            else if( written == remainSize )
+            else if( ( size_t ) written >= remainSize )
             {
                 ret = SDP_CONTROLLER_RESULT_SDP_POPULATE_BUFFER_TOO_SMALL;
                 LogError( ( "buffer has no space for RTX fmtp" ) );
@@ -1309,7 +1327,7 @@ static SdpControllerResult_t PopulateCodecAttributesOpus( SdpControllerMediaDesc
         ret = SDP_CONTROLLER_RESULT_SDP_FAIL_SNPRINTF;
         LogError( ( "snprintf return unexpected value %d", written ) );
     }
-    else if( written == remainSize )
+    else if( ( size_t ) written >= remainSize )
     {
         ret = SDP_CONTROLLER_RESULT_SDP_POPULATE_BUFFER_TOO_SMALL;
         LogError( ( "buffer has no space for rtpmap OPUS" ) );
@@ -1370,7 +1388,7 @@ static SdpControllerResult_t PopulateCodecAttributesOpus( SdpControllerMediaDesc
                 ret = SDP_CONTROLLER_RESULT_SDP_FAIL_SNPRINTF;
                 LogError( ( "snprintf return unexpected value %d", written ) );
             }
-            else if( written == remainSize )
+            else if( ( size_t ) written >= remainSize )
             {
                 ret = SDP_CONTROLLER_RESULT_SDP_POPULATE_BUFFER_TOO_SMALL;
                 LogError( ( "buffer has no space for fmtp" ) );
@@ -1402,7 +1420,7 @@ static SdpControllerResult_t PopulateCodecAttributesOpus( SdpControllerMediaDesc
             ret = SDP_CONTROLLER_RESULT_SDP_FAIL_SNPRINTF;
             LogError( ( "snprintf return unexpected value %d", written ) );
         }
-        else if( written == remainSize )
+        else if( ( size_t ) written >= remainSize )
         {
             ret = SDP_CONTROLLER_RESULT_SDP_POPULATE_BUFFER_TOO_SMALL;
             LogError( ( "buffer has no space for rtcp-fb H264 value" ) );
@@ -1459,7 +1477,7 @@ static SdpControllerResult_t PopulateCodecAttributesVp8( SdpControllerMediaDescr
         ret = SDP_CONTROLLER_RESULT_SDP_FAIL_SNPRINTF;
         LogError( ( "snprintf return unexpected value %d", written ) );
     }
-    else if( written == remainSize )
+    else if( ( size_t ) written >= remainSize )
     {
         ret = SDP_CONTROLLER_RESULT_SDP_POPULATE_BUFFER_TOO_SMALL;
         LogError( ( "buffer has no space for rtpmap VP8" ) );
@@ -1524,7 +1542,7 @@ static SdpControllerResult_t PopulateCodecAttributesMulaw( SdpControllerMediaDes
         ret = SDP_CONTROLLER_RESULT_SDP_FAIL_SNPRINTF;
         LogError( ( "snprintf return unexpected value %d", written ) );
     }
-    else if( written == remainSize )
+    else if( ( size_t ) written >= remainSize )
     {
         ret = SDP_CONTROLLER_RESULT_SDP_POPULATE_BUFFER_TOO_SMALL;
         LogError( ( "buffer has no space for rtpmap MULAW" ) );
@@ -1563,7 +1581,7 @@ static SdpControllerResult_t PopulateCodecAttributesMulaw( SdpControllerMediaDes
             ret = SDP_CONTROLLER_RESULT_SDP_FAIL_SNPRINTF;
             LogError( ( "snprintf return unexpected value %d", written ) );
         }
-        else if( written == remainSize )
+        else if( ( size_t ) written >= remainSize )
         {
             ret = SDP_CONTROLLER_RESULT_SDP_POPULATE_BUFFER_TOO_SMALL;
             LogError( ( "buffer has no space for rtcp-fb H264 value" ) );
@@ -1620,7 +1638,7 @@ static SdpControllerResult_t PopulateCodecAttributesAlaw( SdpControllerMediaDesc
         ret = SDP_CONTROLLER_RESULT_SDP_FAIL_SNPRINTF;
         LogError( ( "snprintf return unexpected value %d", written ) );
     }
-    else if( written == remainSize )
+    else if( ( size_t ) written >= remainSize )
     {
         ret = SDP_CONTROLLER_RESULT_SDP_POPULATE_BUFFER_TOO_SMALL;
         LogError( ( "buffer has no space for rtpmap ALAW" ) );
@@ -1659,7 +1677,7 @@ static SdpControllerResult_t PopulateCodecAttributesAlaw( SdpControllerMediaDesc
             ret = SDP_CONTROLLER_RESULT_SDP_FAIL_SNPRINTF;
             LogError( ( "snprintf return unexpected value %d", written ) );
         }
-        else if( written == remainSize )
+        else if( ( size_t ) written >= remainSize )
         {
             ret = SDP_CONTROLLER_RESULT_SDP_POPULATE_BUFFER_TOO_SMALL;
             LogError( ( "buffer has no space for rtcp-fb H264 value" ) );
@@ -1718,7 +1736,7 @@ static SdpControllerResult_t PopulateCodecAttributesH265( SdpControllerMediaDesc
         ret = SDP_CONTROLLER_RESULT_SDP_FAIL_SNPRINTF;
         LogError( ( "snprintf return unexpected value %d", written ) );
     }
-    else if( written == remainSize )
+    else if( ( size_t ) written >= remainSize )
     {
         ret = SDP_CONTROLLER_RESULT_SDP_POPULATE_BUFFER_TOO_SMALL;
         LogError( ( "buffer has no space for rtpmap H265 value" ) );
@@ -1748,7 +1766,7 @@ static SdpControllerResult_t PopulateCodecAttributesH265( SdpControllerMediaDesc
             ret = SDP_CONTROLLER_RESULT_SDP_FAIL_SNPRINTF;
             LogError( ( "snprintf return unexpected value %d", written ) );
         }
-        else if( written == remainSize )
+        else if( ( size_t ) written >= remainSize )
         {
             ret = SDP_CONTROLLER_RESULT_SDP_POPULATE_BUFFER_TOO_SMALL;
             LogError( ( "buffer has no space for rtcp-fb H265 value" ) );
@@ -1801,7 +1819,7 @@ static SdpControllerResult_t PopulateCodecAttributesH265( SdpControllerMediaDesc
                 ret = SDP_CONTROLLER_RESULT_SDP_FAIL_SNPRINTF;
                 LogError( ( "snprintf return unexpected value %d", written ) );
             }
-            else if( written == remainSize )
+            else if( ( size_t ) written >= remainSize )
             {
                 ret = SDP_CONTROLLER_RESULT_SDP_POPULATE_BUFFER_TOO_SMALL;
                 LogError( ( "buffer has no space for fmtp" ) );
@@ -2019,7 +2037,7 @@ static int AddSessionAttributeGroup( char * pBuffer,
             totalWritten = -1;
             LogError( ( "snprintf return unexpected value %d", written ) );
         }
-        else if( written == remainSize )
+        else if( ( size_t ) written >= remainSize )
         {
             totalWritten = -2;
             LogError( ( "buffer has no space for attribute name" ) );
@@ -2054,7 +2072,7 @@ static int AddSessionAttributeGroup( char * pBuffer,
                 totalWritten = -1;
                 LogError( ( "snprintf return unexpected value %d", written ) );
             }
-            else if( written == remainSize )
+            else if( ( size_t ) written >= remainSize )
             {
                 totalWritten = -2;
                 LogError( ( "buffer has no space for attribute value" ) );
@@ -2078,7 +2096,7 @@ static int AddSessionAttributeGroup( char * pBuffer,
             totalWritten = -1;
             LogError( ( "snprintf return unexpected value %d", written ) );
         }
-        else if( written == remainSize )
+        else if( ( size_t ) written >= remainSize )
         {
             totalWritten = -2;
             LogError( ( "buffer has no space for attribute value" ) );
@@ -2088,6 +2106,7 @@ static int AddSessionAttributeGroup( char * pBuffer,
             char * pAppendNumber = pCurBuffer + written;
             int offset = 0;
 
+            remainSize -= written;
             totalWritten += written;
 
             for( i = 0; i < pLocalSdpDescription->mediaCount; i++ )
@@ -2099,7 +2118,7 @@ static int AddSessionAttributeGroup( char * pBuffer,
                     LogError( ( "snprintf return unexpected value %d", written ) );
                     break;
                 }
-                else if( written == remainSize - offset )
+                else if( ( size_t ) written >= remainSize - offset )
                 {
                     totalWritten = -2;
                     LogError( ( "buffer has no space for attribute value" ) );
@@ -2111,9 +2130,12 @@ static int AddSessionAttributeGroup( char * pBuffer,
                 }
             }
 
-            pLocalSdpDescription->attributes[ pLocalSdpDescription->sessionAttributesCount ].pAttributeValue = pCurBuffer;
-            pLocalSdpDescription->attributes[ pLocalSdpDescription->sessionAttributesCount ].attributeValueLength = strlen( pCurBuffer );
-            totalWritten += offset;
+            if( totalWritten >= 0 )
+            {
+                pLocalSdpDescription->attributes[ pLocalSdpDescription->sessionAttributesCount ].pAttributeValue = pCurBuffer;
+                pLocalSdpDescription->attributes[ pLocalSdpDescription->sessionAttributesCount ].attributeValueLength = strlen( pCurBuffer );
+                totalWritten += offset;
+            }
         }
     }
 
@@ -2152,7 +2174,7 @@ static int AddSessionAttributeIceOptions( char * pBuffer,
             totalWritten = -1;
             LogError( ( "snprintf return unexpected value %d", written ) );
         }
-        else if( written == remainSize )
+        else if( ( size_t ) written >= remainSize )
         {
             totalWritten = -2;
             LogError( ( "buffer has no space for session attributes" ) );
@@ -2176,7 +2198,7 @@ static int AddSessionAttributeIceOptions( char * pBuffer,
             totalWritten = -1;
             LogError( ( "snprintf return unexpected value %d", written ) );
         }
-        else if( written == remainSize )
+        else if( ( size_t ) written >= remainSize )
         {
             totalWritten = -2;
             LogError( ( "buffer has no space for session attributes" ) );
@@ -2220,7 +2242,7 @@ static int AddSessionAttributeMsidSemantic( char * pBuffer,
             totalWritten = -1;
             LogError( ( "snprintf return unexpected value %d", written ) );
         }
-        else if( written == remainSize )
+        else if( ( size_t ) written >= remainSize )
         {
             totalWritten = -2;
             LogError( ( "buffer has no space for session attributes" ) );
@@ -2244,7 +2266,7 @@ static int AddSessionAttributeMsidSemantic( char * pBuffer,
             totalWritten = -1;
             LogError( ( "snprintf return unexpected value %d", written ) );
         }
-        else if( written == remainSize )
+        else if( ( size_t ) written >= remainSize )
         {
             totalWritten = -2;
             LogError( ( "buffer has no space for session attributes" ) );
@@ -2290,7 +2312,12 @@ static SdpControllerResult_t PopulateSessionAttributes( SdpControllerSdpDescript
         /* a=group:BINDLE 0 1 ...
          * Note that we need to session media count to populate this value. */
         written = AddSessionAttributeGroup( pCurBuffer, remainSize, pLocalSdpDescription, pRemoteSdpDescription );
-        if( written < 0 )
+        if( written == -2 )
+        {
+            ret = SDP_CONTROLLER_RESULT_SDP_POPULATE_BUFFER_TOO_SMALL;
+            LogError( ( "Fail to add group to session attribute with return %d", written ) );
+        }
+        else if( written < 0 )
         {
             ret = SDP_CONTROLLER_RESULT_SDP_FAIL_ADD_SESSION_ATTRIBUTE_GROUP;
             LogError( ( "Fail to add group to session attribute with return %d", written ) );
@@ -2309,7 +2336,12 @@ static SdpControllerResult_t PopulateSessionAttributes( SdpControllerSdpDescript
         if( populateConfiguration.canTrickleIce != 0U )
         {
             written = AddSessionAttributeIceOptions( pCurBuffer, remainSize, pLocalSdpDescription, pRemoteSdpDescription );
-            if( written < 0 )
+            if( written == -2 )
+            {
+                ret = SDP_CONTROLLER_RESULT_SDP_POPULATE_BUFFER_TOO_SMALL;
+                LogError( ( "Fail to add ice-options to session attribute with return %d", written ) );
+            }
+            else if( written < 0 )
             {
                 ret = SDP_CONTROLLER_RESULT_SDP_FAIL_ADD_SESSION_ATTRIBUTE_ICE_OPTIONS;
                 LogError( ( "Fail to add ice-options to session attribute with return %d", written ) );
@@ -2327,7 +2359,12 @@ static SdpControllerResult_t PopulateSessionAttributes( SdpControllerSdpDescript
     {
         /* a=msid-semantic: WMS myKvsVideoStream */
         written = AddSessionAttributeMsidSemantic( pCurBuffer, remainSize, pLocalSdpDescription, pRemoteSdpDescription );
-        if( written < 0 )
+        if( written == -2 )
+        {
+            ret = SDP_CONTROLLER_RESULT_SDP_POPULATE_BUFFER_TOO_SMALL;
+            LogError( ( "Fail to add msid-semantic to session attribute with return %d", written ) );
+        }
+        else if( written < 0 )
         {
             ret = SDP_CONTROLLER_RESULT_SDP_FAIL_ADD_SESSION_ATTRIBUTE_MSID_SEMANTIC;
             LogError( ( "Fail to add msid-semantic to session attribute with return %d", written ) );
@@ -2385,6 +2422,13 @@ SdpControllerResult_t SdpController_DeserializeSdpOffer( const char * pSdpOfferC
         {
             break;
         }
+        else if( ( type == SDP_TYPE_MEDIA ) &&
+                 ( pOffer->mediaCount >= SDP_CONTROLLER_MAX_SDP_MEDIA_DESCRIPTIONS_COUNT ) )
+        {
+            LogError( ( "Media description count exceeds %d", SDP_CONTROLLER_MAX_SDP_MEDIA_DESCRIPTIONS_COUNT ) );
+            ret = SDP_CONTROLLER_RESULT_SDP_MEDIA_DESCRIPTION_MAX_EXCEDDED;
+            break;
+        }
         else if( type == SDP_TYPE_MEDIA )
         {
             pOffer->mediaDescriptions[ pOffer->mediaCount ].pMediaName = pValue;
@@ -2534,7 +2578,7 @@ SdpControllerResult_t SdpController_SerializeSdpMessageByDescription( SdpControl
             LogError( ( "Unexpected behavior, snprintf returns %d", written ) );
             ret = SDP_CONTROLLER_RESULT_SDP_FAIL_SNPRINTF;
         }
-        else if( written == remainSize )
+        else if( ( size_t ) written >= remainSize )
         {
             LogError( ( "output buffer full" ) );
             ret = SDP_CONTROLLER_RESULT_SDP_CONVERTED_BUFFER_TOO_SMALL;
@@ -2568,7 +2612,7 @@ SdpControllerResult_t SdpController_SerializeSdpMessageByDescription( SdpControl
             LogError( ( "Unexpected behavior, snprintf returns %d", written ) );
             ret = SDP_CONTROLLER_RESULT_SDP_FAIL_SNPRINTF;
         }
-        else if( written == remainSize )
+        else if( ( size_t ) written >= remainSize )
         {
             LogError( ( "output buffer full" ) );
             ret = SDP_CONTROLLER_RESULT_SDP_CONVERTED_BUFFER_TOO_SMALL;
@@ -2714,7 +2758,7 @@ SdpControllerResult_t SdpController_PopulateSingleMedia( SdpControllerMediaDescr
             ret = SDP_CONTROLLER_RESULT_SDP_FAIL_SNPRINTF;
             LogError( ( "snprintf return unexpected value %d", written ) );
         }
-        else if( written == remainSize )
+        else if( ( size_t ) written >= remainSize )
         {
             ret = SDP_CONTROLLER_RESULT_SDP_POPULATE_BUFFER_TOO_SMALL;
             LogError( ( "buffer has no space for media name" ) );
@@ -2767,7 +2811,7 @@ SdpControllerResult_t SdpController_PopulateSingleMedia( SdpControllerMediaDescr
             ret = SDP_CONTROLLER_RESULT_SDP_FAIL_SNPRINTF;
             LogError( ( "snprintf return unexpected value %d", written ) );
         }
-        else if( written == remainSize )
+        else if( ( size_t ) written >= remainSize )
         {
             ret = SDP_CONTROLLER_RESULT_SDP_POPULATE_BUFFER_TOO_SMALL;
             LogError( ( "buffer has no space for msid" ) );
@@ -2800,7 +2844,7 @@ SdpControllerResult_t SdpController_PopulateSingleMedia( SdpControllerMediaDescr
             ret = SDP_CONTROLLER_RESULT_SDP_FAIL_SNPRINTF;
             LogError( ( "snprintf return unexpected value %d", written ) );
         }
-        else if( written == remainSize )
+        else if( ( size_t ) written >= remainSize )
         {
             ret = SDP_CONTROLLER_RESULT_SDP_POPULATE_BUFFER_TOO_SMALL;
             LogError( ( "buffer has no space for RTX ssrc-group" ) );
@@ -2874,7 +2918,7 @@ SdpControllerResult_t SdpController_PopulateSingleMedia( SdpControllerMediaDescr
             ret = SDP_CONTROLLER_RESULT_SDP_FAIL_SNPRINTF;
             LogError( ( "snprintf return unexpected value %d", written ) );
         }
-        else if( written == remainSize )
+        else if( ( size_t ) written >= remainSize )
         {
             ret = SDP_CONTROLLER_RESULT_SDP_POPULATE_BUFFER_TOO_SMALL;
             LogError( ( "buffer has no space for msid" ) );
@@ -2942,7 +2986,7 @@ SdpControllerResult_t SdpController_PopulateSingleMedia( SdpControllerMediaDescr
                 ret = SDP_CONTROLLER_RESULT_SDP_FAIL_SNPRINTF;
                 LogError( ( "snprintf return unexpected value %d", written ) );
             }
-            else if( written == remainSize )
+            else if( ( size_t ) written >= remainSize )
             {
                 ret = SDP_CONTROLLER_RESULT_SDP_POPULATE_BUFFER_TOO_SMALL;
                 LogError( ( "buffer has no space for mid" ) );
@@ -3078,6 +3122,35 @@ SdpControllerResult_t SdpController_PopulateSingleMedia( SdpControllerMediaDescr
         *pTargetAttributeCount += 1;
     }
 
+    /* max-message-size */
+    if( ( ret == SDP_CONTROLLER_RESULT_OK ) && ( trackKind == TRANSCEIVER_TRACK_KIND_DATA_CHANNEL ) && ( populateConfiguration.maxMessageSize > 0U ) )
+    {
+        written = snprintf( pCurBuffer, remainSize, "%u", ( unsigned int ) populateConfiguration.maxMessageSize );
+
+        if( written < 0 )
+        {
+            ret = SDP_CONTROLLER_RESULT_SDP_FAIL_SNPRINTF;
+            LogError( ( "snprintf return unexpected value %d", written ) );
+        }
+        else if( ( size_t ) written >= remainSize )
+        {
+            ret = SDP_CONTROLLER_RESULT_SDP_POPULATE_BUFFER_TOO_SMALL;
+            LogError( ( "buffer has no space for max-message-size" ) );
+        }
+        else
+        {
+            pTargetAttribute = &pLocalMediaDescription->attributes[ *pTargetAttributeCount ];
+            pTargetAttribute->pAttributeName = SDP_CONTROLLER_DATA_CHANNEL_ATTRIBUTE_NAME_MAX_MESSAGE_SIZE;
+            pTargetAttribute->attributeNameLength = SDP_CONTROLLER_DATA_CHANNEL_ATTRIBUTE_NAME_MAX_MESSAGE_SIZE_LENGTH;
+            pTargetAttribute->pAttributeValue = pCurBuffer;
+            pTargetAttribute->attributeValueLength = written;
+            *pTargetAttributeCount += 1;
+
+            pCurBuffer += written;
+            remainSize -= written;
+        }
+    }
+
     if( ret == SDP_CONTROLLER_RESULT_OK )
     {
         *ppBuffer = pCurBuffer;
@@ -56,6 +56,7 @@ typedef enum SdpControllerResult
     SDP_CONTROLLER_RESULT_SDP_INVALID_TWCC_ID,
     SDP_CONTROLLER_RESULT_SDP_CONVERTED_BUFFER_TOO_SMALL,
     SDP_CONTROLLER_RESULT_SDP_POPULATE_BUFFER_TOO_SMALL,
+    SDP_CONTROLLER_RESULT_SDP_MEDIA_DESCRIPTION_MAX_EXCEDDED,
 } SdpControllerResult_t;
 
 typedef enum SdpControllerDtlsRole
@@ -166,6 +167,8 @@ typedef struct SdpControllerQuickAccess
     uint32_t audioCodecRtxPayload;
     uint32_t videoSsrc;
     uint32_t audioSsrc;
+    uint8_t isMaxMessageSizeSet;
+    uint32_t maxMessageSize;
     const char * pRemoteCandidates[ SDP_CONTROLLER_MAX_SDP_ATTRIBUTES_COUNT ];
     size_t remoteCandidateLengths[ SDP_CONTROLLER_MAX_SDP_ATTRIBUTES_COUNT ];
     uint8_t remoteCandidateCount;
@@ -251,6 +254,9 @@ typedef struct SdpControllerPopulateMediaConfiguration
 
     /* TWCC EXT ID */
     uint16_t twccExtId;
+
+    /* Data channel max-message-size, the attribute is skipped if it's 0. */
+    uint32_t maxMessageSize;
 } SdpControllerPopulateMediaConfiguration_t;
 
 typedef struct SdpControllerPopulateSessionConfiguration
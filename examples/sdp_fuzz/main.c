@@ -0,0 +1,996 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * SDP controller fuzzing harness and parse benchmark.
+ *
+ * Everything here is fed with what a remote peer sends, through three targets:
+ *  - offer: SdpController_DeserializeSdpOffer, then the answer is populated from
+ *    the parsed offer and serialized the way the peer connection does, and it
+ *    must parse back with the same media count.
+ *  - candidate: IceController_DeserializeIceCandidate on the input, and on each
+ *    candidate of the input when it parses as an offer.
+ *  - roundtrip: a parsed offer is serialized and parsed again, the second parse
+ *    must match the first (differential check). Only inputs made of plain CRLF
+ *    terminated lines are compared, the serializer rewrites anything else.
+ * A mismatch aborts, so fuzzers report it like a crash.
+ *
+ * Built with SDP_FUZZ_LIBFUZZER, LLVMFuzzerTestOneInput runs every target on
+ * each input and libFuzzer provides main. Otherwise main replays the corpus
+ * files and directories given, optionally with random mutations of each, which
+ * is also the entry point for AFL:
+ *   afl-fuzz -i examples/sdp_fuzz/corpus -o findings -- WebRTCLinuxSdpFuzz @@
+ * With -b, it reports the CPU time and throughput of each target on each
+ * corpus file instead. Inputs are copied into buffers of their exact size,
+ * build with ENABLE_ADDRESS_SANITIZER to catch reads past them.
+ *
+ * Usage: WebRTCLinuxSdpFuzz [-t offer|candidate|roundtrip|all] [-m mutations_per_input] [-s seed] [-b iterations] path...
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "logging.h"
+#include "sdp_controller.h"
+#include "ice_controller.h"
+
+/* Large enough for the biggest answer the peer connection accepts. */
+#define SDP_FUZZ_BUFFER_LENGTH              ( 64 * 1024 )
+
+/* Inputs larger than the websocket receive buffer never reach the parsers. */
+#define SDP_FUZZ_MAX_INPUT_LENGTH           ( 64 * 1024 )
+
+#define SDP_FUZZ_MAX_MUTATIONS_PER_RUN      ( 8 )
+#define SDP_FUZZ_PATH_BUFFER_LENGTH         ( 1024 )
+
+#define SDP_FUZZ_TARGET_OFFER               ( 1U << 0 )
+#define SDP_FUZZ_TARGET_CANDIDATE           ( 1U << 1 )
+#define SDP_FUZZ_TARGET_ROUNDTRIP           ( 1U << 2 )
+#define SDP_FUZZ_TARGET_ALL                 ( SDP_FUZZ_TARGET_OFFER | SDP_FUZZ_TARGET_CANDIDATE | SDP_FUZZ_TARGET_ROUNDTRIP )
+
+/* The answer side of the harness, same shape as the master example. */
+#define SDP_FUZZ_CNAME                      "sdpFuzzCname"
+#define SDP_FUZZ_USER_NAME                  "fuzz"
+#define SDP_FUZZ_PASSWORD                   "sdpfuzzpassword00000001"
+#define SDP_FUZZ_FINGERPRINT \
+    "5C:2E:3A:9B:1D:7F:60:44:8E:0A:F3:12:C9:B5:6D:71:2F:E8:90:4A:1C:D3:77:05:BB:36:E2:58:09:AF:14:C6"
+#define SDP_FUZZ_MAX_MESSAGE_SIZE           ( 65536 )
+
+/* What the deserializer doesn't keep, filled in before serializing a parsed offer. */
+#define SDP_FUZZ_DEFAULT_USER_NAME          "-"
+#define SDP_FUZZ_DEFAULT_SESSION_VERSION    ( 2 )
+#define SDP_FUZZ_DEFAULT_ORIGIN_ADDRESS     "127.0.0.1"
+#define SDP_FUZZ_DEFAULT_MEDIA_ADDRESS      "0.0.0.0"
+
+/* The descriptions are too large for the stack of fuzzer threads. */
+static SdpControllerSdpDescription_t offerDescription;
+static SdpControllerSdpDescription_t reparsedDescription;
+static SdpControllerSdpDescription_t answerDescription;
+
+static char answerContentBuffer[ SDP_FUZZ_BUFFER_LENGTH ];
+static char serializedBuffer[ SDP_FUZZ_BUFFER_LENGTH ];
+
+static Transceiver_t videoTransceiver;
+static Transceiver_t audioTransceiver;
+
+/*----------------------------------------------------------------------------*/
+
+static void ReportMismatch( const char * pWhat )
+{
+    printf( "SDP fuzz check failed: %s\n", pWhat );
+    fflush( stdout );
+    abort();
+}
+
+/*----------------------------------------------------------------------------*/
+
+/* Copies the input into a buffer of its exact size, so the sanitizers catch
+ * any read past the end. */
+static char * CopyInput( const uint8_t * pData,
+                         size_t size )
+{
+    char * pCopy = ( char * ) malloc( size > 0U ? size : 1U );
+
+    if( ( pCopy != NULL ) && ( size > 0U ) )
+    {
+        memcpy( pCopy, pData, size );
+    }
+
+    return pCopy;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static uint8_t IsSameBuffer( const char * pA,
+                             size_t aLength,
+                             const char * pB,
+                             size_t bLength )
+{
+    return ( aLength == bLength ) &&
+           ( ( aLength == 0U ) || ( memcmp( pA, pB, aLength ) == 0 ) );
+}
+
+/*----------------------------------------------------------------------------*/
+
+static uint8_t IsSameAttributes( const SdpControllerAttributes_t * pA,
+                                 const SdpControllerAttributes_t * pB,
+                                 uint32_t count )
+{
+    uint8_t isSame = 1U;
+    uint32_t i;
+
+    for( i = 0; ( isSame != 0U ) && ( i < count ); i++ )
+    {
+        isSame = IsSameBuffer( pA[ i ].pAttributeName, pA[ i ].attributeNameLength,
+                               pB[ i ].pAttributeName, pB[ i ].attributeNameLength ) &&
+                 IsSameBuffer( pA[ i ].pAttributeValue, pA[ i ].attributeValueLength,
+                               pB[ i ].pAttributeValue, pB[ i ].attributeValueLength );
+    }
+
+    return isSame;
+}
+
+/*----------------------------------------------------------------------------*/
+
+/* Returns 1 if every line ends with CRLF and there's no other control character. */
+static uint8_t IsPlainSdp( const char * pSdp,
+                           size_t sdpLength )
+{
+    uint8_t isPlain = ( sdpLength >= 2U ) ? 1U : 0U;
+    size_t i;
+
+    for( i = 0; ( isPlain != 0U ) && ( i < sdpLength ); i++ )
+    {
+        if( pSdp[ i ] == '\r' )
+        {
+            isPlain = ( ( i + 1U < sdpLength ) && ( pSdp[ i + 1U ] == '\n' ) ) ? 1U : 0U;
+            i++;
+        }
+        else if( ( ( unsigned char ) pSdp[ i ] < 0x20U ) || ( pSdp[ i ] == 0x7F ) )
+        {
+            isPlain = 0U;
+        }
+        else
+        {
+            /* Empty else marker. */
+        }
+    }
+
+    if( ( isPlain != 0U ) && ( pSdp[ sdpLength - 1U ] != '\n' ) )
+    {
+        isPlain = 0U;
+    }
+
+    return isPlain;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static void InitTransceivers( void )
+{
+    memset( &( videoTransceiver ), 0, sizeof( Transceiver_t ) );
+    videoTransceiver.trackKind = TRANSCEIVER_TRACK_KIND_VIDEO;
+    videoTransceiver.direction = TRANSCEIVER_TRACK_DIRECTION_SENDRECV;
+    TRANSCEIVER_ENABLE_CODEC( videoTransceiver.codecBitMap, TRANSCEIVER_RTC_CODEC_H264_PROFILE_42E01F_LEVEL_ASYMMETRY_ALLOWED_PACKETIZATION_BIT );
+    TRANSCEIVER_ENABLE_CODEC( videoTransceiver.codecBitMap, TRANSCEIVER_RTC_CODEC_VP8_BIT );
+    TRANSCEIVER_ENABLE_CODEC( videoTransceiver.codecBitMap, TRANSCEIVER_RTC_CODEC_H265_BIT );
+    videoTransceiver.streamIdLength = snprintf( videoTransceiver.streamId, sizeof( videoTransceiver.streamId ), "sdpFuzzStream" );
+    videoTransceiver.trackIdLength = snprintf( videoTransceiver.trackId, sizeof( videoTransceiver.trackId ), "sdpFuzzVideoTrack" );
+    videoTransceiver.ssrc = 1000U;
+    videoTransceiver.rtxSsrc = 1001U;
+
+    memset( &( audioTransceiver ), 0, sizeof( Transceiver_t ) );
+    audioTransceiver.trackKind = TRANSCEIVER_TRACK_KIND_AUDIO;
+    audioTransceiver.direction = TRANSCEIVER_TRACK_DIRECTION_SENDRECV;
+    TRANSCEIVER_ENABLE_CODEC( audioTransceiver.codecBitMap, TRANSCEIVER_RTC_CODEC_OPUS_BIT );
+    TRANSCEIVER_ENABLE_CODEC( audioTransceiver.codecBitMap, TRANSCEIVER_RTC_CODEC_MULAW_BIT );
+    TRANSCEIVER_ENABLE_CODEC( audioTransceiver.codecBitMap, TRANSCEIVER_RTC_CODEC_ALAW_BIT );
+    audioTransceiver.streamIdLength = snprintf( audioTransceiver.streamId, sizeof( audioTransceiver.streamId ), "sdpFuzzStream" );
+    audioTransceiver.trackIdLength = snprintf( audioTransceiver.trackId, sizeof( audioTransceiver.trackId ), "sdpFuzzAudioTrack" );
+    audioTransceiver.ssrc = 2000U;
+    audioTransceiver.rtxSsrc = 2001U;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static TransceiverTrackKind_t GetTrackKind( const SdpControllerMediaDescription_t * pMediaDescription )
+{
+    TransceiverTrackKind_t trackKind = TRANSCEIVER_TRACK_KIND_UNKNOWN;
+
+    if( ( pMediaDescription->mediaNameLength >= strlen( "video" ) ) &&
+        ( strncmp( pMediaDescription->pMediaName, "video", strlen( "video" ) ) == 0 ) )
+    {
+        trackKind = TRANSCEIVER_TRACK_KIND_VIDEO;
+    }
+    else if( ( pMediaDescription->mediaNameLength >= strlen( "audio" ) ) &&
+             ( strncmp( pMediaDescription->pMediaName, "audio", strlen( "audio" ) ) == 0 ) )
+    {
+        trackKind = TRANSCEIVER_TRACK_KIND_AUDIO;
+    }
+    else if( ( pMediaDescription->mediaNameLength >= strlen( "application" ) ) &&
+             ( strncmp( pMediaDescription->pMediaName, "application", strlen( "application" ) ) == 0 ) )
+    {
+        trackKind = TRANSCEIVER_TRACK_KIND_DATA_CHANNEL;
+    }
+    else
+    {
+        /* Empty else marker. */
+    }
+
+    return trackKind;
+}
+
+/*----------------------------------------------------------------------------*/
+
+/* Populates and serializes the answer to offerDescription, then parses it back.
+ * Returns 1 if the answer was created. */
+static uint8_t CreateAnswer( void )
+{
+    SdpControllerResult_t ret = SDP_CONTROLLER_RESULT_OK;
+    SdpControllerPopulateMediaConfiguration_t mediaConfiguration;
+    SdpControllerPopulateSessionConfiguration_t sessionConfiguration;
+    char * pBuffer = answerContentBuffer;
+    size_t bufferLength = sizeof( answerContentBuffer );
+    size_t serializedLength = sizeof( serializedBuffer );
+    size_t headLength;
+    TransceiverTrackKind_t trackKind;
+    uint32_t i;
+    char * pAnswer = NULL;
+
+    memset( &( answerDescription ), 0, sizeof( SdpControllerSdpDescription_t ) );
+
+    memset( &( mediaConfiguration ), 0, sizeof( SdpControllerPopulateMediaConfiguration_t ) );
+    mediaConfiguration.isOffer = 0U;
+    mediaConfiguration.canTrickleIce = 1U;
+    mediaConfiguration.pCname = SDP_FUZZ_CNAME;
+    mediaConfiguration.cnameLength = strlen( SDP_FUZZ_CNAME );
+    mediaConfiguration.pUserName = SDP_FUZZ_USER_NAME;
+    mediaConfiguration.userNameLength = strlen( SDP_FUZZ_USER_NAME );
+    mediaConfiguration.pPassword = SDP_FUZZ_PASSWORD;
+    mediaConfiguration.passwordLength = strlen( SDP_FUZZ_PASSWORD );
+    mediaConfiguration.pLocalFingerprint = SDP_FUZZ_FINGERPRINT;
+    mediaConfiguration.localFingerprintLength = strlen( SDP_FUZZ_FINGERPRINT );
+    mediaConfiguration.twccExtId = ( uint16_t ) offerDescription.quickAccess.twccExtId;
+
+    for( i = 0; ( ret == SDP_CONTROLLER_RESULT_OK ) && ( i < offerDescription.mediaCount ); i++ )
+    {
+        trackKind = GetTrackKind( &( offerDescription.mediaDescriptions[ i ] ) );
+        mediaConfiguration.maxMessageSize = 0U;
+
+        if( trackKind == TRANSCEIVER_TRACK_KIND_VIDEO )
+        {
+            mediaConfiguration.pTransceiver = &( videoTransceiver );
+            mediaConfiguration.payloadType = TRANSCEIVER_RTC_CODEC_DEFAULT_PAYLOAD_H264;
+            mediaConfiguration.rtxPayloadType = TRANSCEIVER_RTC_CODEC_DEFAULT_PAYLOAD_H264 - 1U;
+        }
+        else if( trackKind == TRANSCEIVER_TRACK_KIND_AUDIO )
+        {
+            mediaConfiguration.pTransceiver = &( audioTransceiver );
+            mediaConfiguration.payloadType = TRANSCEIVER_RTC_CODEC_DEFAULT_PAYLOAD_OPUS;
+            mediaConfiguration.rtxPayloadType = 0U;
+        }
+        else if( trackKind == TRANSCEIVER_TRACK_KIND_DATA_CHANNEL )
+        {
+            mediaConfiguration.pTransceiver = NULL;
+            mediaConfiguration.maxMessageSize = SDP_FUZZ_MAX_MESSAGE_SIZE;
+        }
+        else
+        {
+            /* The peer connection has no transceiver for it, no answer. */
+            ret = SDP_CONTROLLER_RESULT_BAD_PARAMETER;
+        }
+
+        if( ret == SDP_CONTROLLER_RESULT_OK )
+        {
+            ret = SdpController_PopulateSingleMedia( &( offerDescription.mediaDescriptions[ i ] ),
+                                                     mediaConfiguration,
+                                                     &( answerDescription.mediaDescriptions[ i ] ),
+                                                     i,
+                                                     &( pBuffer ),
+                                                     &( bufferLength ),
+                                                     trackKind );
+        }
+
+        if( ret == SDP_CONTROLLER_RESULT_OK )
+        {
+            answerDescription.mediaCount++;
+        }
+    }
+
+    if( ret == SDP_CONTROLLER_RESULT_OK )
+    {
+        memset( &( sessionConfiguration ), 0, sizeof( SdpControllerPopulateSessionConfiguration_t ) );
+        sessionConfiguration.canTrickleIce = 1U;
+        ret = SdpController_PopulateSessionDescription( &( offerDescription ),
+                                                        sessionConfiguration,
+                                                        &( answerDescription ),
+                                                        &( pBuffer ),
+                                                        &( bufferLength ) );
+    }
+
+    if( ret == SDP_CONTROLLER_RESULT_OK )
+    {
+        ret = SdpController_SerializeSdpMessageByDescription( SDP_CONTROLLER_MESSAGE_TYPE_ANSWER,
+                                                              &( answerDescription ),
+                                                              serializedBuffer,
+                                                              &( serializedLength ) );
+    }
+
+    /* Everything we serialize ourselves must parse back. */
+    if( ret == SDP_CONTROLLER_RESULT_OK )
+    {
+        headLength = strlen( "{\"type\": \"answer\", \"sdp\": \"" );
+        if( serializedLength < headLength + strlen( SDP_CONTROLLER_MESSAGE_TEMPLATE_TAIL ) )
+        {
+            ReportMismatch( "answer shorter than its JSON envelope" );
+        }
+
+        serializedLength -= headLength + strlen( SDP_CONTROLLER_MESSAGE_TEMPLATE_TAIL );
+        pAnswer = CopyInput( ( const uint8_t * ) &( serializedBuffer[ headLength ] ), serializedLength );
+        if( pAnswer == NULL )
+        {
+            ret = SDP_CONTROLLER_RESULT_BAD_PARAMETER;
+        }
+    }
+
+    if( ret == SDP_CONTROLLER_RESULT_OK )
+    {
+        if( SdpController_DeserializeSdpOffer( pAnswer, serializedLength, &( reparsedDescription ) ) != SDP_CONTROLLER_RESULT_OK )
+        {
+            ReportMismatch( "answer doesn't parse back" );
+        }
+        else if( reparsedDescription.mediaCount != offerDescription.mediaCount )
+        {
+            ReportMismatch( "answer media count differs from the offer" );
+        }
+        else
+        {
+            /* Empty else marker. */
+        }
+    }
+
+    free( pAnswer );
+
+    return ( ret == SDP_CONTROLLER_RESULT_OK ) ? 1U : 0U;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static uint8_t RunOffer( const uint8_t * pData,
+                         size_t size )
+{
+    uint8_t isOk = 0U;
+    char * pOffer = CopyInput( pData, size );
+
+    if( pOffer != NULL )
+    {
+        if( SdpController_DeserializeSdpOffer( pOffer, size, &( offerDescription ) ) == SDP_CONTROLLER_RESULT_OK )
+        {
+            isOk = CreateAnswer();
+        }
+
+        free( pOffer );
+    }
+
+    return isOk;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static uint8_t RunCandidate( const uint8_t * pData,
+                             size_t size )
+{
+    uint8_t isOk = 0U;
+    char * pInput = CopyInput( pData, size );
+    IceControllerCandidate_t candidate;
+    uint32_t i;
+
+    if( pInput != NULL )
+    {
+        memset( &( candidate ), 0, sizeof( IceControllerCandidate_t ) );
+        if( IceController_DeserializeIceCandidate( pInput, size, &( candidate ) ) == ICE_CONTROLLER_RESULT_OK )
+        {
+            isOk = 1U;
+        }
+
+        /* Candidates of offers without trickle ICE take the same path. */
+        if( SdpController_DeserializeSdpOffer( pInput, size, &( offerDescription ) ) == SDP_CONTROLLER_RESULT_OK )
+        {
+            for( i = 0; i < offerDescription.quickAccess.remoteCandidateCount; i++ )
+            {
+                memset( &( candidate ), 0, sizeof( IceControllerCandidate_t ) );
+                if( IceController_DeserializeIceCandidate( offerDescription.quickAccess.pRemoteCandidates[ i ],
+                                                           offerDescription.quickAccess.remoteCandidateLengths[ i ],
+                                                           &( candidate ) ) == ICE_CONTROLLER_RESULT_OK )
+                {
+                    isOk = 1U;
+                }
+            }
+        }
+
+        free( pInput );
+    }
+
+    return isOk;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static uint8_t RunRoundTrip( const uint8_t * pData,
+                             size_t size )
+{
+    uint8_t isOk = 0U;
+    char * pOffer = CopyInput( pData, size );
+    char * pReserialized = NULL;
+    size_t serializedLength = sizeof( serializedBuffer );
+    size_t headLength = strlen( "{\"type\": \"offer\", \"sdp\": \"" );
+    uint32_t i;
+    const SdpControllerMediaDescription_t * pA, * pB;
+
+    if( ( pOffer != NULL ) &&
+        ( IsPlainSdp( pOffer, size ) != 0U ) &&
+        ( SdpController_DeserializeSdpOffer( pOffer, size, &( offerDescription ) ) == SDP_CONTROLLER_RESULT_OK ) )
+    {
+        offerDescription.origin.pUserName = SDP_FUZZ_DEFAULT_USER_NAME;
+        offerDescription.origin.userNameLength = strlen( SDP_FUZZ_DEFAULT_USER_NAME );
+        offerDescription.origin.sessionVersion = SDP_FUZZ_DEFAULT_SESSION_VERSION;
+        offerDescription.origin.sdpConnectionInformation.pConnectionAddress = SDP_FUZZ_DEFAULT_ORIGIN_ADDRESS;
+        offerDescription.origin.sdpConnectionInformation.connectionAddressLength = strlen( SDP_FUZZ_DEFAULT_ORIGIN_ADDRESS );
+        for( i = 0; i < offerDescription.mediaCount; i++ )
+        {
+            offerDescription.mediaDescriptions[ i ].connectionInformation.pConnectionAddress = SDP_FUZZ_DEFAULT_MEDIA_ADDRESS;
+            offerDescription.mediaDescriptions[ i ].connectionInformation.connectionAddressLength = strlen( SDP_FUZZ_DEFAULT_MEDIA_ADDRESS );
+        }
+
+        /* The serializer may refuse what the deserializer accepted, that's not a mismatch. */
+        if( SdpController_SerializeSdpMessageByDescription( SDP_CONTROLLER_MESSAGE_TYPE_OFFER,
+                                                            &( offerDescription ),
+                                                            serializedBuffer,
+                                                            &( serializedLength ) ) == SDP_CONTROLLER_RESULT_OK )
+        {
+            if( serializedLength < headLength + strlen( SDP_CONTROLLER_MESSAGE_TEMPLATE_TAIL ) )
+            {
+                ReportMismatch( "offer shorter than its JSON envelope" );
+            }
+
+            serializedLength -= headLength + strlen( SDP_CONTROLLER_MESSAGE_TEMPLATE_TAIL );
+            pReserialized = CopyInput( ( const uint8_t * ) &( serializedBuffer[ headLength ] ), serializedLength );
+        }
+    }
+
+    if( pReserialized != NULL )
+    {
+        if( SdpController_DeserializeSdpOffer( pReserialized, serializedLength, &( reparsedDescription ) ) != SDP_CONTROLLER_RESULT_OK )
+        {
+            ReportMismatch( "serialized offer doesn't parse back" );
+        }
+
+        if( ( reparsedDescription.version != offerDescription.version ) ||
+            ( IsSameBuffer( reparsedDescription.pSessionName, reparsedDescription.sessionNameLength,
+                            offerDescription.pSessionName, offerDescription.sessionNameLength ) == 0U ) )
+        {
+            ReportMismatch( "session version or name differs" );
+        }
+
+        if( ( reparsedDescription.sessionAttributesCount != offerDescription.sessionAttributesCount ) ||
+            ( IsSameAttributes( reparsedDescription.attributes,
+                                offerDescription.attributes,
+                                offerDescription.sessionAttributesCount ) == 0U ) )
+        {
+            ReportMismatch( "session attributes differ" );
+        }
+
+        if( reparsedDescription.mediaCount != offerDescription.mediaCount )
+        {
+            ReportMismatch( "media count differs" );
+        }
+
+        for( i = 0; i < offerDescription.mediaCount; i++ )
+        {
+            pA = &( offerDescription.mediaDescriptions[ i ] );
+            pB = &( reparsedDescription.mediaDescriptions[ i ] );
+
+            if( ( IsSameBuffer( pA->pMediaName, pA->mediaNameLength, pB->pMediaName, pB->mediaNameLength ) == 0U ) ||
+                ( IsSameBuffer( pA->pMediaTitle, pA->mediaTitleLength, pB->pMediaTitle, pB->mediaTitleLength ) == 0U ) ||
+                ( pA->mediaAttributesCount != pB->mediaAttributesCount ) ||
+                ( IsSameAttributes( pA->attributes, pB->attributes, pA->mediaAttributesCount ) == 0U ) )
+            {
+                ReportMismatch( "media description differs" );
+            }
+        }
+
+        if( ( IsSameBuffer( reparsedDescription.quickAccess.pFingerprint, reparsedDescription.quickAccess.fingerprintLength,
+                            offerDescription.quickAccess.pFingerprint, offerDescription.quickAccess.fingerprintLength ) == 0U ) ||
+            ( IsSameBuffer( reparsedDescription.quickAccess.pIceUfrag, reparsedDescription.quickAccess.iceUfragLength,
+                            offerDescription.quickAccess.pIceUfrag, offerDescription.quickAccess.iceUfragLength ) == 0U ) ||
+            ( IsSameBuffer( reparsedDescription.quickAccess.pIcePwd, reparsedDescription.quickAccess.icePwdLength,
+                            offerDescription.quickAccess.pIcePwd, offerDescription.quickAccess.icePwdLength ) == 0U ) ||
+            ( reparsedDescription.quickAccess.twccExtId != offerDescription.quickAccess.twccExtId ) ||
+            ( reparsedDescription.quickAccess.isIceTrickle != offerDescription.quickAccess.isIceTrickle ) ||
+            ( reparsedDescription.quickAccess.remoteCandidateCount != offerDescription.quickAccess.remoteCandidateCount ) )
+        {
+            ReportMismatch( "quick access info differs" );
+        }
+
+        isOk = 1U;
+        free( pReserialized );
+    }
+
+    free( pOffer );
+
+    return isOk;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static void RunTargets( uint32_t targets,
+                        const uint8_t * pData,
+                        size_t size )
+{
+    if( size <= SDP_FUZZ_MAX_INPUT_LENGTH )
+    {
+        if( ( targets & SDP_FUZZ_TARGET_OFFER ) != 0U )
+        {
+            ( void ) RunOffer( pData, size );
+        }
+
+        if( ( targets & SDP_FUZZ_TARGET_CANDIDATE ) != 0U )
+        {
+            ( void ) RunCandidate( pData, size );
+        }
+
+        if( ( targets & SDP_FUZZ_TARGET_ROUNDTRIP ) != 0U )
+        {
+            ( void ) RunRoundTrip( pData, size );
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+#if SDP_FUZZ_LIBFUZZER
+
+int LLVMFuzzerTestOneInput( const uint8_t * pData,
+                            size_t size )
+{
+    static uint8_t isInitialized = 0U;
+
+    if( isInitialized == 0U )
+    {
+        InitTransceivers();
+        isInitialized = 1U;
+    }
+
+    RunTargets( SDP_FUZZ_TARGET_ALL, pData, size );
+
+    return 0;
+}
+
+#else /* SDP_FUZZ_LIBFUZZER */
+
+typedef struct SdpFuzzBenchmarkResult
+{
+    uint64_t elapsedUs;
+    uint32_t iterations;
+    uint32_t okCount;
+} SdpFuzzBenchmarkResult_t;
+
+static uint64_t GetCpuTimeUs( void )
+{
+    struct timespec now;
+
+    clock_gettime( CLOCK_PROCESS_CPUTIME_ID, &( now ) );
+
+    return ( ( uint64_t ) now.tv_sec * 1000000U ) + ( ( uint64_t ) now.tv_nsec / 1000U );
+}
+
+/*----------------------------------------------------------------------------*/
+
+/* Applies a few random edits, biased to the ones that break SDP structure.
+ * Returns the new size, the buffer holds at least twice the input size. */
+static size_t Mutate( uint8_t * pBuffer,
+                      size_t size,
+                      size_t bufferSize,
+                      unsigned int * pSeed )
+{
+    uint32_t mutations = 1U + ( ( uint32_t ) rand_r( pSeed ) % SDP_FUZZ_MAX_MUTATIONS_PER_RUN );
+    uint32_t i;
+    size_t position, length;
+    static const char * const tokens[] = {
+        "\r\n", "a=", "m=video 9 UDP/TLS/RTP/SAVPF 96\r\n", ":", " ", "a=candidate:", "a=fmtp:", "a=rtpmap:",
+        "a=extmap:", "a=ssrc:", "a=fingerprint:sha-256 ", "4294967296", "-1", "typ", "\"",
+    };
+    const char * pToken;
+
+    for( i = 0; i < mutations; i++ )
+    {
+        position = ( size > 0U ) ? ( size_t ) rand_r( pSeed ) % size : 0U;
+
+        switch( rand_r( pSeed ) % 5 )
+        {
+            case 0:
+                /* Flip a byte. */
+                if( size > 0U )
+                {
+                    pBuffer[ position ] = ( uint8_t ) rand_r( pSeed );
+                }
+                break;
+            case 1:
+                /* Drop a run of bytes. */
+                length = ( size > 0U ) ? 1U + ( size_t ) rand_r( pSeed ) % 32U : 0U;
+                length = ( length > size - position ) ? size - position : length;
+                memmove( &( pBuffer[ position ] ), &( pBuffer[ position + length ] ), size - position - length );
+                size -= length;
+                break;
+            case 2:
+                /* Insert an SDP token. */
+                pToken = tokens[ ( size_t ) rand_r( pSeed ) % ( sizeof( tokens ) / sizeof( tokens[ 0 ] ) ) ];
+                length = strlen( pToken );
+                if( size + length <= bufferSize )
+                {
+                    memmove( &( pBuffer[ position + length ] ), &( pBuffer[ position ] ), size - position );
+                    memcpy( &( pBuffer[ position ] ), pToken, length );
+                    size += length;
+                }
+                break;
+            case 3:
+                /* Duplicate a run of bytes, repeats lines and attributes. */
+                length = ( size > 0U ) ? 1U + ( size_t ) rand_r( pSeed ) % 256U : 0U;
+                length = ( length > size - position ) ? size - position : length;
+                if( size + length <= bufferSize )
+                {
+                    memmove( &( pBuffer[ position + length ] ), &( pBuffer[ position ] ), size - position );
+                    size += length;
+                }
+                break;
+            default:
+                /* Truncate. */
+                size = position;
+                break;
+        }
+    }
+
+    return size;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static uint8_t RunTarget( uint32_t target,
+                          const uint8_t * pData,
+                          size_t size )
+{
+    uint8_t isOk = 0U;
+
+    if( target == SDP_FUZZ_TARGET_OFFER )
+    {
+        isOk = RunOffer( pData, size );
+    }
+    else if( target == SDP_FUZZ_TARGET_CANDIDATE )
+    {
+        isOk = RunCandidate( pData, size );
+    }
+    else
+    {
+        isOk = RunRoundTrip( pData, size );
+    }
+
+    return isOk;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static void BenchmarkTarget( const char * pName,
+                             uint32_t target,
+                             const uint8_t * pData,
+                             size_t size,
+                             uint32_t iterations )
+{
+    SdpFuzzBenchmarkResult_t result;
+    uint64_t startTimeUs;
+    uint32_t i;
+
+    memset( &( result ), 0, sizeof( SdpFuzzBenchmarkResult_t ) );
+    result.iterations = iterations;
+
+    startTimeUs = GetCpuTimeUs();
+
+    for( i = 0; i < iterations; i++ )
+    {
+        result.okCount += RunTarget( target, pData, size );
+    }
+
+    result.elapsedUs = GetCpuTimeUs() - startTimeUs;
+
+    printf( "%-32s %-10s %8u %10.2f %10.2f %4s\n",
+            pName,
+            target == SDP_FUZZ_TARGET_OFFER ? "offer" : ( target == SDP_FUZZ_TARGET_CANDIDATE ? "candidate" : "roundtrip" ),
+            ( unsigned int ) size,
+            ( double ) result.elapsedUs / ( double ) result.iterations,
+            result.elapsedUs > 0U ? ( ( double ) size * result.iterations ) / ( double ) result.elapsedUs : 0.0,
+            result.okCount == result.iterations ? "ok" : ( result.okCount == 0U ? "fail" : "mix" ) );
+}
+
+/*----------------------------------------------------------------------------*/
+
+/* Replays, mutates or benchmarks one corpus file. Returns 0 on success. */
+static int ProcessFile( const char * pPath,
+                        uint32_t targets,
+                        uint32_t mutations,
+                        uint32_t benchmarkIterations,
+                        unsigned int * pSeed )
+{
+    int ret = 0;
+    FILE * pFile;
+    uint8_t * pInput = NULL;
+    uint8_t * pMutated = NULL;
+    long fileSize;
+    size_t size = 0, mutatedSize, bufferSize;
+    uint32_t i;
+    const char * pName = strrchr( pPath, '/' );
+
+    pName = ( pName != NULL ) ? pName + 1 : pPath;
+
+    pFile = fopen( pPath, "rb" );
+    if( pFile == NULL )
+    {
+        printf( "Fail to open %s\n", pPath );
+        ret = -1;
+    }
+
+    if( ret == 0 )
+    {
+        if( ( fseek( pFile, 0, SEEK_END ) != 0 ) ||
+            ( ( fileSize = ftell( pFile ) ) < 0 ) ||
+            ( fseek( pFile, 0, SEEK_SET ) != 0 ) )
+        {
+            printf( "Fail to get the size of %s\n", pPath );
+            ret = -1;
+        }
+        else
+        {
+            size = ( size_t ) fileSize;
+        }
+    }
+
+    if( ret == 0 )
+    {
+        bufferSize = 2U * size + 64U;
+        pInput = ( uint8_t * ) malloc( size > 0U ? size : 1U );
+        pMutated = ( uint8_t * ) malloc( bufferSize );
+        if( ( pInput == NULL ) || ( pMutated == NULL ) )
+        {
+            printf( "No memory for %s\n", pPath );
+            ret = -1;
+        }
+        else if( fread( pInput, 1, size, pFile ) != size )
+        {
+            printf( "Fail to read %s\n", pPath );
+            ret = -1;
+        }
+        else
+        {
+            /* Empty else marker. */
+        }
+    }
+
+    if( ret == 0 )
+    {
+        if( benchmarkIterations > 0U )
+        {
+            for( i = 0; i < 3U; i++ )
+            {
+                if( ( targets & ( 1U << i ) ) != 0U )
+                {
+                    BenchmarkTarget( pName, 1U << i, pInput, size, benchmarkIterations );
+                }
+            }
+        }
+        else
+        {
+            RunTargets( targets, pInput, size );
+
+            for( i = 0; i < mutations; i++ )
+            {
+                memcpy( pMutated, pInput, size );
+                mutatedSize = Mutate( pMutated, size, bufferSize, pSeed );
+                RunTargets( targets, pMutated, mutatedSize );
+            }
+        }
+    }
+
+    if( pFile != NULL )
+    {
+        fclose( pFile );
+    }
+
+    free( pInput );
+    free( pMutated );
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+/* Processes a file, or every regular file of a directory. Returns the number
+ * of files processed, or -1 on failure. */
+static int ProcessPath( const char * pPath,
+                        uint32_t targets,
+                        uint32_t mutations,
+                        uint32_t benchmarkIterations,
+                        unsigned int * pSeed )
+{
+    int ret = 0;
+    struct stat pathStat;
+    DIR * pDir;
+    struct dirent * pEntry;
+    char filePath[ SDP_FUZZ_PATH_BUFFER_LENGTH ];
+    int written;
+
+    if( stat( pPath, &( pathStat ) ) != 0 )
+    {
+        printf( "Fail to find %s\n", pPath );
+        ret = -1;
+    }
+    else if( S_ISDIR( pathStat.st_mode ) )
+    {
+        pDir = opendir( pPath );
+        if( pDir == NULL )
+        {
+            printf( "Fail to open directory %s\n", pPath );
+            ret = -1;
+        }
+
+        while( ( ret >= 0 ) && ( pDir != NULL ) && ( ( pEntry = readdir( pDir ) ) != NULL ) )
+        {
+            written = snprintf( filePath, sizeof( filePath ), "%s/%s", pPath, pEntry->d_name );
+            if( ( written < 0 ) || ( ( size_t ) written >= sizeof( filePath ) ) ||
+                ( stat( filePath, &( pathStat ) ) != 0 ) ||
+                ( S_ISREG( pathStat.st_mode ) == 0 ) )
+            {
+                continue;
+            }
+
+            if( ProcessFile( filePath, targets, mutations, benchmarkIterations, pSeed ) != 0 )
+            {
+                ret = -1;
+            }
+            else
+            {
+                ret++;
+            }
+        }
+
+        if( pDir != NULL )
+        {
+            closedir( pDir );
+        }
+    }
+    else
+    {
+        ret = ( ProcessFile( pPath, targets, mutations, benchmarkIterations, pSeed ) == 0 ) ? 1 : -1;
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+int main( int argc,
+          char * argv[] )
+{
+    int ret = 0, option, processed = 0, count;
+    uint32_t targets = SDP_FUZZ_TARGET_ALL;
+    uint32_t mutations = 0U;
+    uint32_t benchmarkIterations = 0U;
+    unsigned int seed = ( unsigned int ) time( NULL );
+
+    while( ( option = getopt( argc, argv, "t:m:s:b:" ) ) != -1 )
+    {
+        switch( option )
+        {
+            case 't':
+                if( strcmp( optarg, "offer" ) == 0 )
+                {
+                    targets = SDP_FUZZ_TARGET_OFFER;
+                }
+                else if( strcmp( optarg, "candidate" ) == 0 )
+                {
+                    targets = SDP_FUZZ_TARGET_CANDIDATE;
+                }
+                else if( strcmp( optarg, "roundtrip" ) == 0 )
+                {
+                    targets = SDP_FUZZ_TARGET_ROUNDTRIP;
+                }
+                else if( strcmp( optarg, "all" ) == 0 )
+                {
+                    targets = SDP_FUZZ_TARGET_ALL;
+                }
+                else
+                {
+                    printf( "Unknown target %s\n", optarg );
+                    ret = -1;
+                }
+                break;
+            case 'm':
+                mutations = ( uint32_t ) strtoul( optarg, NULL, 10 );
+                break;
+            case 's':
+                seed = ( unsigned int ) strtoul( optarg, NULL, 10 );
+                break;
+            case 'b':
+                benchmarkIterations = ( uint32_t ) strtoul( optarg, NULL, 10 );
+                break;
+            default:
+                ret = -1;
+                break;
+        }
+    }
+
+    if( ( ret != 0 ) || ( optind >= argc ) )
+    {
+        printf( "Usage: %s [-t offer|candidate|roundtrip|all] [-m mutations_per_input] [-s seed] [-b iterations] path...\n", argv[ 0 ] );
+        ret = -1;
+    }
+
+    if( ret == 0 )
+    {
+        InitTransceivers();
+
+        if( benchmarkIterations > 0U )
+        {
+            printf( "%-32s %-10s %8s %10s %10s %4s\n",
+                    "input", "target", "bytes", "cpu us", "MB/s", "" );
+        }
+        else if( mutations > 0U )
+        {
+            /* Rerun with the same seed to reproduce a failure. */
+            printf( "Mutating each input %u times, seed: %u\n", mutations, seed );
+            fflush( stdout );
+        }
+        else
+        {
+            /* Empty else marker. */
+        }
+
+        for( ; ( ret == 0 ) && ( optind < argc ); optind++ )
+        {
+            count = ProcessPath( argv[ optind ], targets, mutations, benchmarkIterations, &( seed ) );
+            if( count < 0 )
+            {
+                ret = -1;
+            }
+            else
+            {
+                processed += count;
+            }
+        }
+    }
+
+    if( ( ret == 0 ) && ( benchmarkIterations == 0U ) )
+    {
+        printf( "Processed %d inputs, no failure.\n", processed );
+    }
+
+    return ( ret == 0 ) ? 0 : 1;
+}
+
+#endif /* SDP_FUZZ_LIBFUZZER */
@@ -14,6 +14,10 @@
  * limitations under the License.
  */
 
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+
 #include "base64.h"
 #if METRIC_PRINT_ENABLED
 #include "metric.h"
@@ -22,6 +26,7 @@
 #include "core_json.h"
 #include "networking_utils.h"
 #include "signaling_controller.h"
+#include "signaling_controller_cache.h"
 
 /*----------------------------------------------------------------------------*/
 
@@ -29,7 +34,8 @@
 #define MIN( a,b ) ( ( ( a ) < ( b ) ) ? ( a ) : ( b ) )
 #endif
 
-#define SIGNALING_CONTROLLER_RETRY_CONNECT_TIMEOUT_MS ( 2000 )
+/* The refresh task checks for due work at least this often. */
+#define SIGNALING_CONTROLLER_REFRESH_MAX_SLEEP_SEC    ( 60 )
 
 /*----------------------------------------------------------------------------*/
 
@@ -37,6 +43,30 @@ static int OnWssMessageReceived( char * pMessage,
                                  size_t messageLength,
                                  void * pUserData );
 
+static uint32_t AcquireBuffer( uint32_t * pActiveIndex,
+                               uint32_t * pReaders );
+
+static void ReleaseBuffer( SignalingControllerContext_t * pCtx,
+                           uint32_t * pReaders,
+                           uint32_t index );
+
+static SignalingControllerResult_t GetInactiveBuffer( SignalingControllerContext_t * pCtx,
+                                                      const uint32_t * pActiveIndex,
+                                                      uint32_t * pReaders,
+                                                      uint32_t * pIndex );
+
+static void PublishBuffer( uint32_t * pActiveIndex,
+                           uint32_t index );
+
+static uint64_t GetRefreshTimeSec( uint64_t expirationSec,
+                                   uint64_t lifetimeSec );
+
+static void RequestRefresh( SignalingControllerContext_t * pCtx );
+
+static void RequestCredentialRefresh( SignalingControllerContext_t * pCtx );
+
+static void * RefreshTask( void * pParameter );
+
 static SignalingControllerResult_t HttpSend( SignalingControllerContext_t * pCtx,
                                              HttpRequest_t * pRequest,
                                              HttpResponse_t * pResponse );
@@ -47,6 +77,9 @@ static uint8_t AreCredentialsExpired( SignalingControllerContext_t * pCtx,
 static SignalingControllerResult_t FetchTemporaryCredentials( SignalingControllerContext_t * pCtx,
                                                               const AwsIotCredentials_t * pAwsIotCredentials );
 
+static SignalingControllerResult_t OverrideControlPlaneEndpoint( SignalingControllerContext_t * pCtx,
+                                                                 SignalingRequest_t * pRequest );
+
 static SignalingControllerResult_t DescribeSignalingChannel( SignalingControllerContext_t * pCtx,
                                                              const SignalingChannelName_t * pChannelName );
 
@@ -55,15 +88,49 @@ static SignalingControllerResult_t GetSignalingChannelEndpoints( SignalingContro
 
 static SignalingControllerResult_t GetIceServerConfigs( SignalingControllerContext_t * pCtx );
 
+static SignalingControllerResult_t ConstructWssEndpointUrl( SignalingControllerContext_t * pCtx );
+
 static SignalingControllerResult_t ConnectToWssEndpoint( SignalingControllerContext_t * pCtx );
 
 static SignalingControllerResult_t ConnectToSignalingService( SignalingControllerContext_t * pCtx,
                                                               const SignalingControllerConnectInfo_t * pConnectInfo );
 
+static SignalingControllerResult_t ResolveChannelEndpoints( SignalingControllerContext_t * pCtx,
+                                                            const SignalingControllerConnectInfo_t * pConnectInfo );
+
+static void * BootstrapTask( void * pParameter );
+
+static void StartBootstrapTask( SignalingControllerContext_t * pCtx );
+
+static void WaitBootstrapTask( SignalingControllerContext_t * pCtx );
+
 static void LogSignalingInfo( SignalingControllerContext_t * pCtx );
 
 static SignalingControllerResult_t JoinStorageSession( SignalingControllerContext_t * pCtx );
 
+static SignalingControllerResult_t QueueSignalingMessage( SignalingControllerContext_t * pCtx,
+                                                          const SignalingMessage_t * pSignalingMessage );
+
+static void FlushBatchedMessages( SignalingControllerContext_t * pCtx );
+
+static void OnBatchTimerExpire( void * pUserContext );
+
+static SignalingBatchedMessage_t * CreateBatchedMessage( const SignalingMessage_t * pSignalingMessage );
+
+static void HoldMessage( SignalingControllerContext_t * pCtx,
+                         SignalingBatchedMessage_t * pMessage );
+
+static uint32_t SendHeldMessages( SignalingControllerContext_t * pCtx );
+
+static void SetState( SignalingControllerContext_t * pCtx,
+                      SignalingControllerState_t state );
+
+static uint32_t GetReconnectDelayMs( uint32_t connectAttempts );
+
+static void OnConnected( SignalingControllerContext_t * pCtx );
+
+static void OnDisconnected( SignalingControllerContext_t * pCtx );
+
 /*----------------------------------------------------------------------------*/
 
 static int OnWssMessageReceived( char * pMessage,
@@ -76,6 +143,8 @@ static int OnWssMessageReceived( char * pMessage,
     SignalingControllerContext_t * pCtx = ( SignalingControllerContext_t * ) pUserData;
     SignalingMessage_t signalingMessage;
     Base64Result_t base64Result;
+    char * pPayload = NULL;
+    size_t payloadLength = 0;
 
     signalingResult = Signaling_ParseWssRecvMessage( pMessage, messageLength, &( wssRecvMessage ) );
     if( signalingResult != SIGNALING_RESULT_OK )
@@ -86,11 +155,14 @@ static int OnWssMessageReceived( char * pMessage,
 
     if( ret == 0 )
     {
-        pCtx->signalingRxMessageLength = SIGNALING_CONTROLLER_MESSAGE_BUFFER_LENGTH;
-        base64Result = Base64_Decode( wssRecvMessage.pBase64EncodedPayload,
-                                      wssRecvMessage.base64EncodedPayloadLength,
-                                      &( pCtx->signalingRxMessageBuffer[ 0 ] ),
-                                      &( pCtx->signalingRxMessageLength ) );
+        /* Decode the payload over itself in the receive buffer, the decoded
+         * payload is shorter and the other fields lie outside of it. */
+        pPayload = &( pMessage[ wssRecvMessage.pBase64EncodedPayload - pMessage ] );
+        payloadLength = wssRecvMessage.base64EncodedPayloadLength;
+        base64Result = Base64_Decode( pPayload,
+                                      payloadLength,
+                                      pPayload,
+                                      &( payloadLength ) );
 
         if( base64Result != BASE64_RESULT_OK )
         {
@@ -141,8 +213,8 @@ static int OnWssMessageReceived( char * pMessage,
         signalingMessage.pCorrelationId = wssRecvMessage.statusResponse.pCorrelationId;
         signalingMessage.correlationIdLength = wssRecvMessage.statusResponse.correlationIdLength;
         signalingMessage.messageType = wssRecvMessage.messageType;
-        signalingMessage.pMessage = &( pCtx->signalingRxMessageBuffer[ 0 ] );
-        signalingMessage.messageLength = pCtx->signalingRxMessageLength;
+        signalingMessage.pMessage = pPayload;
+        signalingMessage.messageLength = payloadLength;
 
         pCtx->messageReceivedCallback( &( signalingMessage ),
                                        pCtx->pMessageReceivedCallbackData );
@@ -153,6 +225,259 @@ static int OnWssMessageReceived( char * pMessage,
 
 /*----------------------------------------------------------------------------*/
 
+static uint32_t AcquireBuffer( uint32_t * pActiveIndex,
+                               uint32_t * pReaders )
+{
+    uint32_t index;
+
+    for( ;; )
+    {
+        index = __atomic_load_n( pActiveIndex, __ATOMIC_SEQ_CST );
+        __atomic_add_fetch( &( pReaders[ index ] ), 1U, __ATOMIC_SEQ_CST );
+
+        /* The writer may have switched buffers and started filling this one
+         * before it saw the reader, so check it's still the active one. */
+        if( __atomic_load_n( pActiveIndex, __ATOMIC_SEQ_CST ) == index )
+        {
+            break;
+        }
+
+        __atomic_sub_fetch( &( pReaders[ index ] ), 1U, __ATOMIC_SEQ_CST );
+    }
+
+    return index;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static void ReleaseBuffer( SignalingControllerContext_t * pCtx,
+                           uint32_t * pReaders,
+                           uint32_t index )
+{
+    if( __atomic_sub_fetch( &( pReaders[ index ] ), 1U, __ATOMIC_SEQ_CST ) == 0U )
+    {
+        /* Wake up a writer waiting for the last reader of this buffer. */
+        pthread_mutex_lock( &( pCtx->bufferMutex ) );
+        pthread_cond_broadcast( &( pCtx->bufferCond ) );
+        pthread_mutex_unlock( &( pCtx->bufferMutex ) );
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+static SignalingControllerResult_t GetInactiveBuffer( SignalingControllerContext_t * pCtx,
+                                                      const uint32_t * pActiveIndex,
+                                                      uint32_t * pReaders,
+                                                      uint32_t * pIndex )
+{
+    SignalingControllerResult_t ret = SIGNALING_CONTROLLER_RESULT_OK;
+    uint32_t index;
+    struct timespec deadline;
+    int waitResult = 0;
+
+    /* Must be called with httpMutex held, there is a single writer. Readers
+     * only hold a buffer for the duration of a request or an SDP offer. */
+    index = 1U - __atomic_load_n( pActiveIndex, __ATOMIC_SEQ_CST );
+
+    if( __atomic_load_n( &( pReaders[ index ] ), __ATOMIC_SEQ_CST ) != 0U )
+    {
+        clock_gettime( CLOCK_MONOTONIC, &( deadline ) );
+        deadline.tv_sec += SIGNALING_CONTROLLER_BUFFER_WAIT_TIMEOUT_MS / 1000;
+        deadline.tv_nsec += ( SIGNALING_CONTROLLER_BUFFER_WAIT_TIMEOUT_MS % 1000 ) * 1000000L;
+        if( deadline.tv_nsec >= 1000000000L )
+        {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+
+        /* ReleaseBuffer signals with bufferMutex held after dropping the
+         * count, so checking the count with it held can't miss a wakeup. */
+        pthread_mutex_lock( &( pCtx->bufferMutex ) );
+        while( ( __atomic_load_n( &( pReaders[ index ] ), __ATOMIC_SEQ_CST ) != 0U ) &&
+               ( waitResult == 0 ) )
+        {
+            waitResult = pthread_cond_timedwait( &( pCtx->bufferCond ),
+                                                 &( pCtx->bufferMutex ),
+                                                 &( deadline ) );
+        }
+        pthread_mutex_unlock( &( pCtx->bufferMutex ) );
+
+        if( __atomic_load_n( &( pReaders[ index ] ), __ATOMIC_SEQ_CST ) != 0U )
+        {
+            LogError( ( "Timed out waiting for the readers of buffer %u to finish!", index ) );
+            ret = SIGNALING_CONTROLLER_RESULT_BUFFER_BUSY;
+        }
+    }
+
+    if( ret == SIGNALING_CONTROLLER_RESULT_OK )
+    {
+        *pIndex = index;
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static void PublishBuffer( uint32_t * pActiveIndex,
+                           uint32_t index )
+{
+    __atomic_store_n( pActiveIndex, index, __ATOMIC_SEQ_CST );
+}
+
+/*----------------------------------------------------------------------------*/
+
+static uint64_t GetRefreshTimeSec( uint64_t expirationSec,
+                                   uint64_t lifetimeSec )
+{
+    uint64_t leadTimeSec;
+    uint64_t jitterSec;
+
+    leadTimeSec = lifetimeSec * ( 100U - SIGNALING_CONTROLLER_REFRESH_LIFETIME_PERCENT ) / 100U;
+    jitterSec = lifetimeSec * SIGNALING_CONTROLLER_REFRESH_JITTER_PERCENT / 100U;
+
+    if( jitterSec > 0U )
+    {
+        leadTimeSec += ( uint64_t ) rand() % ( jitterSec + 1U );
+    }
+
+    return expirationSec - MIN( leadTimeSec, lifetimeSec );
+}
+
+/*----------------------------------------------------------------------------*/
+
+static void RequestRefresh( SignalingControllerContext_t * pCtx )
+{
+    pthread_mutex_lock( &( pCtx->refreshMutex ) );
+    {
+        pCtx->isRefreshRequested = 1U;
+        pthread_cond_signal( &( pCtx->refreshCond ) );
+    }
+    pthread_mutex_unlock( &( pCtx->refreshMutex ) );
+}
+
+/*----------------------------------------------------------------------------*/
+
+static void RequestCredentialRefresh( SignalingControllerContext_t * pCtx )
+{
+    pthread_mutex_lock( &( pCtx->refreshMutex ) );
+    {
+        pCtx->isCredentialRefreshRequested = 1U;
+        pCtx->isRefreshRequested = 1U;
+        pthread_cond_signal( &( pCtx->refreshCond ) );
+    }
+    pthread_mutex_unlock( &( pCtx->refreshMutex ) );
+}
+
+/*----------------------------------------------------------------------------*/
+
+static void * RefreshTask( void * pParameter )
+{
+    SignalingControllerContext_t * pCtx = ( SignalingControllerContext_t * ) pParameter;
+    SignalingCredentials_t * pCredentials;
+    SignalingIceServerConfigs_t * pIceServerConfigs;
+    uint64_t currentTimeSec;
+    uint64_t nextRefreshTimeSec;
+    uint8_t isCredentialRefreshRequested;
+    struct timespec deadline;
+
+    for( ;; )
+    {
+        pthread_mutex_lock( &( pCtx->refreshMutex ) );
+        {
+            isCredentialRefreshRequested = pCtx->isCredentialRefreshRequested;
+            pCtx->isCredentialRefreshRequested = 0U;
+        }
+        pthread_mutex_unlock( &( pCtx->refreshMutex ) );
+
+        pthread_mutex_lock( &( pCtx->httpMutex ) );
+        {
+            /* The writers hold httpMutex, so the active buffers don't change here. */
+            currentTimeSec = NetworkingUtils_GetCurrentTimeSec( NULL );
+            pCredentials = &( pCtx->credentials[ pCtx->activeCredentials ] );
+
+            if( ( isCredentialRefreshRequested != 0U ) ||
+                ( ( pCredentials->refreshTimeSeconds != 0U ) &&
+                  ( pCredentials->refreshTimeSeconds <= currentTimeSec ) ) )
+            {
+                LogInfo( ( "Refreshing credentials, they expire at %lu.", ( unsigned long ) pCredentials->expirationSeconds ) );
+
+                #if METRIC_PRINT_ENABLED
+                Metric_StartEvent( METRIC_EVENT_SIGNALING_GET_CREDENTIALS );
+                #endif
+                if( FetchTemporaryCredentials( pCtx,
+                                               &( pCtx->pConnectInfo->awsIotCreds ) ) != SIGNALING_CONTROLLER_RESULT_OK )
+                {
+                    LogWarn( ( "Fail to refresh credentials, retrying in %d seconds.", SIGNALING_CONTROLLER_REFRESH_RETRY_SEC ) );
+                    pCredentials->refreshTimeSeconds = currentTimeSec + SIGNALING_CONTROLLER_REFRESH_RETRY_SEC;
+                }
+                #if METRIC_PRINT_ENABLED
+                Metric_EndEvent( METRIC_EVENT_SIGNALING_GET_CREDENTIALS );
+                #endif
+            }
+
+            /* ICE server configs can only be fetched once the endpoints are known. */
+            pIceServerConfigs = &( pCtx->iceServerConfigs[ pCtx->activeIceServerConfigs ] );
+
+            if( ( pCtx->httpsEndpointLength > 0 ) &&
+                ( pIceServerConfigs->refreshTimeSec <= currentTimeSec ) )
+            {
+                LogInfo( ( "Refreshing ICE server configs." ) );
+
+                #if METRIC_PRINT_ENABLED
+                Metric_StartEvent( METRIC_EVENT_SIGNALING_GET_ICE_SERVER_LIST );
+                #endif
+                if( GetIceServerConfigs( pCtx ) != SIGNALING_CONTROLLER_RESULT_OK )
+                {
+                    LogWarn( ( "Fail to refresh ICE server configs, retrying in %d seconds.", SIGNALING_CONTROLLER_REFRESH_RETRY_SEC ) );
+                    __atomic_store_n( &( pIceServerConfigs->refreshTimeSec ),
+                                      currentTimeSec + SIGNALING_CONTROLLER_REFRESH_RETRY_SEC,
+                                      __ATOMIC_SEQ_CST );
+                }
+                #if METRIC_PRINT_ENABLED
+                Metric_EndEvent( METRIC_EVENT_SIGNALING_GET_ICE_SERVER_LIST );
+                #endif
+            }
+
+            nextRefreshTimeSec = currentTimeSec + SIGNALING_CONTROLLER_REFRESH_MAX_SLEEP_SEC;
+
+            pCredentials = &( pCtx->credentials[ pCtx->activeCredentials ] );
+            if( pCredentials->refreshTimeSeconds != 0U )
+            {
+                nextRefreshTimeSec = MIN( nextRefreshTimeSec, pCredentials->refreshTimeSeconds );
+            }
+
+            pIceServerConfigs = &( pCtx->iceServerConfigs[ pCtx->activeIceServerConfigs ] );
+            if( pCtx->httpsEndpointLength > 0 )
+            {
+                nextRefreshTimeSec = MIN( nextRefreshTimeSec, pIceServerConfigs->refreshTimeSec );
+            }
+        }
+        pthread_mutex_unlock( &( pCtx->httpMutex ) );
+
+        pthread_mutex_lock( &( pCtx->refreshMutex ) );
+        {
+            deadline.tv_sec = ( time_t ) nextRefreshTimeSec;
+            deadline.tv_nsec = 0;
+
+            while( ( pCtx->isRefreshRequested == 0U ) &&
+                   ( pthread_cond_timedwait( &( pCtx->refreshCond ),
+                                             &( pCtx->refreshMutex ),
+                                             &( deadline ) ) == 0 ) )
+            {
+                /* Spurious wakeup, keep waiting. */
+            }
+
+            pCtx->isRefreshRequested = 0U;
+        }
+        pthread_mutex_unlock( &( pCtx->refreshMutex ) );
+    }
+
+    return NULL;
+}
+
+/*----------------------------------------------------------------------------*/
+
 static SignalingControllerResult_t HttpSend( SignalingControllerContext_t * pCtx,
                                              HttpRequest_t * pRequest,
                                              HttpResponse_t * pResponse )
@@ -160,20 +485,26 @@ static SignalingControllerResult_t HttpSend( SignalingControllerContext_t * pCtx
     SignalingControllerResult_t ret = SIGNALING_CONTROLLER_RESULT_OK;
     NetworkingResult_t networkingResult;
     AwsCredentials_t awsCreds;
+    SignalingCredentials_t * pCredentials;
+    uint32_t credentialsIndex;
     int i;
 
     pRequest->pUserAgent = pCtx->pUserAgentName;
     pRequest->userAgentLength = pCtx->userAgentNameLength;
 
-    awsCreds.pAccessKeyId = &( pCtx->accessKeyId[ 0 ] );
-    awsCreds.accessKeyIdLen = pCtx->accessKeyIdLength;
+    credentialsIndex = AcquireBuffer( &( pCtx->activeCredentials ),
+                                      &( pCtx->credentialsReaders[ 0 ] ) );
+    pCredentials = &( pCtx->credentials[ credentialsIndex ] );
+
+    awsCreds.pAccessKeyId = &( pCredentials->accessKeyId[ 0 ] );
+    awsCreds.accessKeyIdLen = pCredentials->accessKeyIdLength;
 
-    awsCreds.pSecretAccessKey = &( pCtx->secretAccessKey[ 0 ] );
-    awsCreds.secretAccessKeyLen = pCtx->secretAccessKeyLength;
+    awsCreds.pSecretAccessKey = &( pCredentials->secretAccessKey[ 0 ] );
+    awsCreds.secretAccessKeyLen = pCredentials->secretAccessKeyLength;
 
-    awsCreds.pSessionToken = &( pCtx->sessionToken[ 0 ] );
-    awsCreds.sessionTokenLength = pCtx->sessionTokenLength;
-    awsCreds.expirationSeconds = pCtx->expirationSeconds;
+    awsCreds.pSessionToken = &( pCredentials->sessionToken[ 0 ] );
+    awsCreds.sessionTokenLength = pCredentials->sessionTokenLength;
+    awsCreds.expirationSeconds = pCredentials->expirationSeconds;
 
     for( i = 0; i < SIGNALING_CONTROLLER_HTTP_NUM_RETRIES; i++ )
     {
@@ -189,6 +520,8 @@ static SignalingControllerResult_t HttpSend( SignalingControllerContext_t * pCtx
         }
     }
 
+    ReleaseBuffer( pCtx, &( pCtx->credentialsReaders[ 0 ] ), credentialsIndex );
+
     if( networkingResult != NETWORKING_RESULT_OK )
     {
         LogError( ( "Networking_HttpSend fails with return 0x%x!", networkingResult ) );
@@ -210,6 +543,9 @@ static SignalingControllerResult_t FetchTemporaryCredentials( SignalingControlle
     HttpRequest_t httpRequest;
     HttpResponse_t httpResponse;
     HttpRequestHeader_t httpHeader[ 1 ];
+    SignalingCredentials_t * pCredentials = NULL;
+    uint32_t credentialsIndex = 0;
+    uint64_t currentTimeSec;
 
     signalingRequest.pUrl = &( pCtx->httpUrlBuffer[ 0 ] );
     signalingRequest.urlLength = SIGNALING_CONTROLLER_HTTP_URL_BUFFER_LENGTH;
@@ -282,37 +618,123 @@ static SignalingControllerResult_t FetchTemporaryCredentials( SignalingControlle
         }
     }
 
+    if( ret == SIGNALING_CONTROLLER_RESULT_OK )
+    {
+        /* Fill the inactive credentials, the active ones may be in use. */
+        ret = GetInactiveBuffer( pCtx,
+                                 &( pCtx->activeCredentials ),
+                                 &( pCtx->credentialsReaders[ 0 ] ),
+                                 &( credentialsIndex ) );
+    }
+
+    if( ret == SIGNALING_CONTROLLER_RESULT_OK )
+    {
+        pCredentials = &( pCtx->credentials[ credentialsIndex ] );
+        pCredentials->accessKeyIdLength = 0;
+        pCredentials->secretAccessKeyLength = 0;
+        pCredentials->sessionTokenLength = 0;
+        pCredentials->expirationSeconds = 0;
+        pCredentials->refreshTimeSeconds = 0;
+    }
+
     if( ( ret == SIGNALING_CONTROLLER_RESULT_OK ) && ( signalingCredentials.pAccessKeyId != NULL ) )
     {
-        memcpy( &( pCtx->accessKeyId[ 0 ] ),
+        memcpy( &( pCredentials->accessKeyId[ 0 ] ),
                 signalingCredentials.pAccessKeyId,
                 signalingCredentials.accessKeyIdLength );
-        pCtx->accessKeyIdLength = signalingCredentials.accessKeyIdLength;
-        pCtx->accessKeyId[ signalingCredentials.accessKeyIdLength ] = '\0';
+        pCredentials->accessKeyIdLength = signalingCredentials.accessKeyIdLength;
+        pCredentials->accessKeyId[ signalingCredentials.accessKeyIdLength ] = '\0';
     }
 
     if( ( ret == SIGNALING_CONTROLLER_RESULT_OK ) && ( signalingCredentials.pSecretAccessKey != NULL ) )
     {
-        memcpy( &( pCtx->secretAccessKey[ 0 ] ),
+        memcpy( &( pCredentials->secretAccessKey[ 0 ] ),
                 signalingCredentials.pSecretAccessKey,
                 signalingCredentials.secretAccessKeyLength );
-        pCtx->secretAccessKeyLength = signalingCredentials.secretAccessKeyLength;
-        pCtx->secretAccessKey[ signalingCredentials.secretAccessKeyLength ] = '\0';
+        pCredentials->secretAccessKeyLength = signalingCredentials.secretAccessKeyLength;
+        pCredentials->secretAccessKey[ signalingCredentials.secretAccessKeyLength ] = '\0';
     }
 
     if( ( ret == SIGNALING_CONTROLLER_RESULT_OK ) && ( signalingCredentials.pSessionToken != NULL ) )
     {
-        memcpy( &( pCtx->sessionToken[ 0 ] ),
+        memcpy( &( pCredentials->sessionToken[ 0 ] ),
                 signalingCredentials.pSessionToken,
                 signalingCredentials.sessionTokenLength );
-        pCtx->sessionTokenLength = signalingCredentials.sessionTokenLength;
-        pCtx->sessionToken[ signalingCredentials.sessionTokenLength ] = '\0';
+        pCredentials->sessionTokenLength = signalingCredentials.sessionTokenLength;
+        pCredentials->sessionToken[ signalingCredentials.sessionTokenLength ] = '\0';
     }
 
     if( ( ret == SIGNALING_CONTROLLER_RESULT_OK ) && ( signalingCredentials.pExpiration != NULL ) )
     {
-        pCtx->expirationSeconds = NetworkingUtils_GetTimeFromIso8601( signalingCredentials.pExpiration,
-                                                                      signalingCredentials.expirationLength );
+        pCredentials->expirationSeconds = NetworkingUtils_GetTimeFromIso8601( signalingCredentials.pExpiration,
+                                                                              signalingCredentials.expirationLength );
+        currentTimeSec = NetworkingUtils_GetCurrentTimeSec( NULL );
+
+        if( pCredentials->expirationSeconds > currentTimeSec )
+        {
+            pCredentials->refreshTimeSeconds = GetRefreshTimeSec( pCredentials->expirationSeconds,
+                                                                  pCredentials->expirationSeconds - currentTimeSec );
+        }
+        else
+        {
+            pCredentials->refreshTimeSeconds = currentTimeSec + SIGNALING_CONTROLLER_REFRESH_RETRY_SEC;
+        }
+    }
+
+    if( ret == SIGNALING_CONTROLLER_RESULT_OK )
+    {
+        PublishBuffer( &( pCtx->activeCredentials ), credentialsIndex );
+        RequestRefresh( pCtx );
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static SignalingControllerResult_t OverrideControlPlaneEndpoint( SignalingControllerContext_t * pCtx,
+                                                                 SignalingRequest_t * pRequest )
+{
+    SignalingControllerResult_t ret = SIGNALING_CONTROLLER_RESULT_OK;
+    const SignalingControllerConnectInfo_t * pConnectInfo = pCtx->pConnectInfo;
+    const char * pPath = NULL;
+    size_t pathLength = 0, i;
+
+    if( ( pConnectInfo != NULL ) && ( pConnectInfo->pControlPlaneEndpoint != NULL ) )
+    {
+        /* The path starts at the first '/' after "scheme://". */
+        for( i = 0; i + 2 < pRequest->urlLength; i++ )
+        {
+            if( memcmp( &( pRequest->pUrl[ i ] ), "://", 3 ) == 0 )
+            {
+                pPath = memchr( &( pRequest->pUrl[ i + 3 ] ), '/', pRequest->urlLength - i - 3 );
+                break;
+            }
+        }
+
+        if( pPath == NULL )
+        {
+            LogError( ( "Fail to find the path of the control plane URL." ) );
+            ret = SIGNALING_CONTROLLER_RESULT_FAIL;
+        }
+        else
+        {
+            pathLength = pRequest->urlLength - ( size_t ) ( pPath - pRequest->pUrl );
+
+            if( pConnectInfo->controlPlaneEndpointLength + pathLength >= SIGNALING_CONTROLLER_HTTP_URL_BUFFER_LENGTH )
+            {
+                LogError( ( "Control plane URL does not fit in the buffer." ) );
+                ret = SIGNALING_CONTROLLER_RESULT_FAIL;
+            }
+        }
+
+        if( ret == SIGNALING_CONTROLLER_RESULT_OK )
+        {
+            memmove( &( pRequest->pUrl[ pConnectInfo->controlPlaneEndpointLength ] ), pPath, pathLength );
+            memcpy( pRequest->pUrl, pConnectInfo->pControlPlaneEndpoint, pConnectInfo->controlPlaneEndpointLength );
+            pRequest->urlLength = pConnectInfo->controlPlaneEndpointLength + pathLength;
+            pRequest->pUrl[ pRequest->urlLength ] = '\0';
+        }
     }
 
     return ret;
@@ -349,6 +771,10 @@ static SignalingControllerResult_t DescribeSignalingChannel( SignalingController
         LogError( ( "Fail to construct describe signaling channel request, return=0x%x", signalingResult ) );
         ret = SIGNALING_CONTROLLER_RESULT_FAIL;
     }
+    else
+    {
+        ret = OverrideControlPlaneEndpoint( pCtx, &( signalingRequest ) );
+    }
 
     if( ret == SIGNALING_CONTROLLER_RESULT_OK )
     {
@@ -446,6 +872,10 @@ static SignalingControllerResult_t GetSignalingChannelEndpoints( SignalingContro
         LogError( ( "Failed to construct Get Signaling Channel Endpoint request. return=0x%x!", signalingResult ) );
         ret = SIGNALING_CONTROLLER_RESULT_FAIL;
     }
+    else
+    {
+        ret = OverrideControlPlaneEndpoint( pCtx, &( signalingRequest ) );
+    }
 
     if( ret == SIGNALING_CONTROLLER_RESULT_OK )
     {
@@ -606,6 +1036,8 @@ static SignalingControllerResult_t GetIceServerConfigs( SignalingControllerConte
     size_t i, j;
     uint32_t minTtl = UINT32_MAX;
     uint64_t iceServerConfigTimeSec;
+    SignalingIceServerConfigs_t * pIceServerConfigs = NULL;
+    uint32_t iceServerConfigsIndex = 0;
 
     signalingChannelHttpEndpoint.pEndpoint = &( pCtx->httpsEndpoint[ 0 ] );
     signalingChannelHttpEndpoint.endpointLength = pCtx->httpsEndpointLength;
@@ -663,6 +1095,17 @@ static SignalingControllerResult_t GetIceServerConfigs( SignalingControllerConte
 
     if( ret == SIGNALING_CONTROLLER_RESULT_OK )
     {
+        /* Fill the inactive configs, the active ones may be used by an SDP offer. */
+        ret = GetInactiveBuffer( pCtx,
+                                 &( pCtx->activeIceServerConfigs ),
+                                 &( pCtx->iceServerConfigsReaders[ 0 ] ),
+                                 &( iceServerConfigsIndex ) );
+    }
+
+    if( ret == SIGNALING_CONTROLLER_RESULT_OK )
+    {
+        pIceServerConfigs = &( pCtx->iceServerConfigs[ iceServerConfigsIndex ] );
+
         for( i = 0; i < iceServersCount; i++ )
         {
             if( i >= SIGNALING_CONTROLLER_ICE_SERVER_MAX_CONFIG_COUNT )
@@ -685,18 +1128,18 @@ static SignalingControllerResult_t GetIceServerConfigs( SignalingControllerConte
                 break;
             }
 
-            memcpy( &( pCtx->iceServerConfigs[ i ].userName[ 0 ] ),
+            memcpy( &( pIceServerConfigs->iceServerConfigs[ i ].userName[ 0 ] ),
                     iceServers[ i ].pUserName,
                     iceServers[ i ].userNameLength );
-            pCtx->iceServerConfigs[ i ].userNameLength = iceServers[ i ].userNameLength;
+            pIceServerConfigs->iceServerConfigs[ i ].userNameLength = iceServers[ i ].userNameLength;
 
-            memcpy( &( pCtx->iceServerConfigs[ i ].password[ 0 ] ),
+            memcpy( &( pIceServerConfigs->iceServerConfigs[ i ].password[ 0 ] ),
                     iceServers[ i ].pPassword,
                     iceServers[ i ].passwordLength );
-            pCtx->iceServerConfigs[ i ].passwordLength = iceServers[ i ].passwordLength;
-            pCtx->iceServerConfigs[ i ].ttlSeconds = iceServers[ i ].messageTtlSeconds;
+            pIceServerConfigs->iceServerConfigs[ i ].passwordLength = iceServers[ i ].passwordLength;
+            pIceServerConfigs->iceServerConfigs[ i ].ttlSeconds = iceServers[ i ].messageTtlSeconds;
 
-            minTtl = MIN( minTtl, pCtx->iceServerConfigs[i].ttlSeconds );
+            minTtl = MIN( minTtl, pIceServerConfigs->iceServerConfigs[ i ].ttlSeconds );
 
             for( j = 0; j < iceServers[ i ].urisNum; j++ )
             {
@@ -713,15 +1156,15 @@ static SignalingControllerResult_t GetIceServerConfigs( SignalingControllerConte
                     break;
                 }
 
-                memcpy( &( pCtx->iceServerConfigs[ i ].iceServerUris[ j ].uri[ 0 ] ),
+                memcpy( &( pIceServerConfigs->iceServerConfigs[ i ].iceServerUris[ j ].uri[ 0 ] ),
                         iceServers[ i ].pUris[ j ],
                         iceServers[ i ].urisLength[ j ] );
-                pCtx->iceServerConfigs[ i ].iceServerUris[ j ].uriLength = iceServers[ i ].urisLength[ j ];
+                pIceServerConfigs->iceServerConfigs[ i ].iceServerUris[ j ].uriLength = iceServers[ i ].urisLength[ j ];
             }
 
             if( ret == SIGNALING_CONTROLLER_RESULT_OK )
             {
-                pCtx->iceServerConfigs[ i ].iceServerUriCount = j;
+                pIceServerConfigs->iceServerConfigs[ i ].iceServerUriCount = j;
             }
             else
             {
@@ -732,20 +1175,33 @@ static SignalingControllerResult_t GetIceServerConfigs( SignalingControllerConte
 
     if( ret == SIGNALING_CONTROLLER_RESULT_OK )
     {
-        pCtx->iceServerConfigsCount = i;
+        pIceServerConfigs->iceServerConfigsCount = i;
 
         iceServerConfigTimeSec = NetworkingUtils_GetCurrentTimeSec( NULL );
 
+        if( i == 0 )
+        {
+            /* No TTL to go by, check again after the usual grace period. */
+            minTtl = SIGNALING_CONTROLLER_ICE_CONFIG_REFRESH_GRACE_PERIOD_SEC;
+        }
+
         if( minTtl < SIGNALING_CONTROLLER_ICE_CONFIG_REFRESH_GRACE_PERIOD_SEC )
         {
             LogWarn( ( "Minimum TTL is less than Refresh Grace Period!" ) );
-            pCtx->iceServerConfigExpirationSec = iceServerConfigTimeSec + minTtl;
+            pIceServerConfigs->expirationSec = iceServerConfigTimeSec + minTtl;
         }
         else
         {
-            pCtx->iceServerConfigExpirationSec = iceServerConfigTimeSec +
-                                                 ( minTtl - SIGNALING_CONTROLLER_ICE_CONFIG_REFRESH_GRACE_PERIOD_SEC );
+            pIceServerConfigs->expirationSec = iceServerConfigTimeSec +
+                                               ( minTtl - SIGNALING_CONTROLLER_ICE_CONFIG_REFRESH_GRACE_PERIOD_SEC );
         }
+
+        /* Refreshed in the background well before the TURN credentials expire. */
+        pIceServerConfigs->refreshTimeSec = GetRefreshTimeSec( iceServerConfigTimeSec + minTtl,
+                                                               minTtl );
+
+        PublishBuffer( &( pCtx->activeIceServerConfigs ), iceServerConfigsIndex );
+        RequestRefresh( pCtx );
     }
 
     return ret;
@@ -753,21 +1209,20 @@ static SignalingControllerResult_t GetIceServerConfigs( SignalingControllerConte
 
 /*----------------------------------------------------------------------------*/
 
-static SignalingControllerResult_t ConnectToWssEndpoint( SignalingControllerContext_t * pCtx )
+static SignalingControllerResult_t ConstructWssEndpointUrl( SignalingControllerContext_t * pCtx )
 {
     SignalingControllerResult_t ret = SIGNALING_CONTROLLER_RESULT_OK;
     SignalingResult_t signalingResult;
     SignalingRequest_t signalingRequest;
     SignalingChannelEndpoint_t wssEndpoint;
     ConnectWssEndpointRequestInfo_t wssEndpointRequestInfo;
-    WebsocketConnectInfo_t wssConnectInfo;
-    NetworkingResult_t networkingResult;
-    AwsCredentials_t awsCreds;
 
+    /* Must be called with httpMutex held, the bootstrap task may update the
+     * channel ARN and endpoints during the websocket handshake. */
     wssEndpoint.pEndpoint = &( pCtx->wssEndpoint[ 0 ] );
     wssEndpoint.endpointLength = pCtx->wssEndpointLength;
 
-    signalingRequest.pUrl = &( pCtx->httpUrlBuffer[ 0 ] );
+    signalingRequest.pUrl = &( pCtx->wssUrlBuffer[ 0 ] );
     signalingRequest.urlLength = SIGNALING_CONTROLLER_HTTP_URL_BUFFER_LENGTH;
 
     signalingRequest.pBody = &( pCtx->httpBodyBuffer[ 0 ] );
@@ -787,34 +1242,56 @@ static SignalingControllerResult_t ConnectToWssEndpoint( SignalingControllerCont
         LogError( ( "Failed to construct Connect WSS Endpoint Request. Return=0x%x!", signalingResult ) );
         ret = SIGNALING_CONTROLLER_RESULT_FAIL;
     }
-
-    if( ret == SIGNALING_CONTROLLER_RESULT_OK )
+    else
     {
-        wssConnectInfo.pUrl = signalingRequest.pUrl;
-        wssConnectInfo.urlLength = signalingRequest.urlLength;
-        wssConnectInfo.rxCallback = OnWssMessageReceived;
-        wssConnectInfo.pRxCallbackData = pCtx;
+        pCtx->wssUrlLength = signalingRequest.urlLength;
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static SignalingControllerResult_t ConnectToWssEndpoint( SignalingControllerContext_t * pCtx )
+{
+    SignalingControllerResult_t ret = SIGNALING_CONTROLLER_RESULT_OK;
+    WebsocketConnectInfo_t wssConnectInfo;
+    NetworkingResult_t networkingResult;
+    AwsCredentials_t awsCreds;
+    SignalingCredentials_t * pCredentials;
+    uint32_t credentialsIndex;
 
-        awsCreds.pAccessKeyId = &( pCtx->accessKeyId[ 0 ] );;
-        awsCreds.accessKeyIdLen = pCtx->accessKeyIdLength;
+    /* The URL is constructed by ConstructWssEndpointUrl. */
+    wssConnectInfo.pUrl = &( pCtx->wssUrlBuffer[ 0 ] );
+    wssConnectInfo.urlLength = pCtx->wssUrlLength;
+    wssConnectInfo.rxCallback = OnWssMessageReceived;
+    wssConnectInfo.pRxCallbackData = pCtx;
 
-        awsCreds.pSecretAccessKey = &( pCtx->secretAccessKey[ 0 ] );
-        awsCreds.secretAccessKeyLen = pCtx->secretAccessKeyLength;
+    credentialsIndex = AcquireBuffer( &( pCtx->activeCredentials ),
+                                      &( pCtx->credentialsReaders[ 0 ] ) );
+    pCredentials = &( pCtx->credentials[ credentialsIndex ] );
 
-        awsCreds.pSessionToken = &( pCtx->sessionToken[ 0 ] );
-        awsCreds.sessionTokenLength = pCtx->sessionTokenLength;
-        awsCreds.expirationSeconds = pCtx->expirationSeconds;
+    awsCreds.pAccessKeyId = &( pCredentials->accessKeyId[ 0 ] );
+    awsCreds.accessKeyIdLen = pCredentials->accessKeyIdLength;
 
-        networkingResult = Networking_WebsocketConnect( &( pCtx->websocketContext ),
-                                                        &( wssConnectInfo ),
-                                                        &( awsCreds ),
-                                                        &( pCtx->awsConfig ) );
+    awsCreds.pSecretAccessKey = &( pCredentials->secretAccessKey[ 0 ] );
+    awsCreds.secretAccessKeyLen = pCredentials->secretAccessKeyLength;
 
-        if( networkingResult != NETWORKING_RESULT_OK )
-        {
-            LogError( ( "Failed to connect with WSS endpoint!" ) );
-            ret = SIGNALING_CONTROLLER_RESULT_FAIL;
-        }
+    awsCreds.pSessionToken = &( pCredentials->sessionToken[ 0 ] );
+    awsCreds.sessionTokenLength = pCredentials->sessionTokenLength;
+    awsCreds.expirationSeconds = pCredentials->expirationSeconds;
+
+    networkingResult = Networking_WebsocketConnect( &( pCtx->websocketContext ),
+                                                    &( wssConnectInfo ),
+                                                    &( awsCreds ),
+                                                    &( pCtx->awsConfig ) );
+
+    ReleaseBuffer( pCtx, &( pCtx->credentialsReaders[ 0 ] ), credentialsIndex );
+
+    if( networkingResult != NETWORKING_RESULT_OK )
+    {
+        LogError( ( "Failed to connect with WSS endpoint!" ) );
+        ret = SIGNALING_CONTROLLER_RESULT_FAIL;
     }
 
     return ret;
@@ -826,6 +1303,12 @@ static SignalingControllerResult_t ConnectToSignalingService( SignalingControlle
                                                               const SignalingControllerConnectInfo_t * pConnectInfo )
 {
     SignalingControllerResult_t ret = SIGNALING_CONTROLLER_RESULT_OK;
+    SignalingCredentials_t * pCredentials;
+    uint32_t index;
+    uint8_t isChannelReused = pCtx->isChannelResolved;
+
+    /* The previous bootstrap task uses the context fields set up below. */
+    WaitBootstrapTask( pCtx );
 
     pCtx->pUserAgentName = pConnectInfo->pUserAgentName;
     pCtx->userAgentNameLength = pConnectInfo->userAgentNameLength;
@@ -835,86 +1318,183 @@ static SignalingControllerResult_t ConnectToSignalingService( SignalingControlle
     pCtx->messageReceivedCallback = pConnectInfo->messageReceivedCallback;
     pCtx->pMessageReceivedCallbackData = pConnectInfo->pMessageReceivedCallbackData;
 
-    if( AreCredentialsExpired( pCtx, pConnectInfo ) != 0U )
-    {
-        #if METRIC_PRINT_ENABLED
-        Metric_StartEvent( METRIC_EVENT_SIGNALING_GET_CREDENTIALS );
-        #endif
-        ret = FetchTemporaryCredentials( pCtx,
-                                         &( pConnectInfo->awsIotCreds ) );
-        #if METRIC_PRINT_ENABLED
-        Metric_EndEvent( METRIC_EVENT_SIGNALING_GET_CREDENTIALS );
-        #endif
-    }
-    else
-    {
-        /* The application must have supplied AWS credentials. */
-        memcpy( &( pCtx->accessKeyId[ 0 ] ),
-                pConnectInfo->awsCreds.pAccessKeyId,
-                pConnectInfo->awsCreds.accessKeyIdLen );
-        pCtx->accessKeyIdLength = pConnectInfo->awsCreds.accessKeyIdLen;
-
-        memcpy( &( pCtx->secretAccessKey[ 0 ] ),
-                pConnectInfo->awsCreds.pSecretAccessKey,
-                pConnectInfo->awsCreds.secretAccessKeyLen );
-        pCtx->secretAccessKeyLength = pConnectInfo->awsCreds.secretAccessKeyLen;
-
-        memcpy( &( pCtx->sessionToken[ 0 ] ),
-                pConnectInfo->awsCreds.pSessionToken,
-                pConnectInfo->awsCreds.sessionTokenLength );
-        pCtx->sessionTokenLength = pConnectInfo->awsCreds.sessionTokenLength;
-
-        pCtx->expirationSeconds = pConnectInfo->awsCreds.expirationSeconds;
-    }
+    pCtx->pConnectInfo = pConnectInfo;
 
-    if( ret == SIGNALING_CONTROLLER_RESULT_OK )
+    pthread_mutex_lock( &( pCtx->httpMutex ) );
     {
-        #if METRIC_PRINT_ENABLED
-        Metric_StartEvent( METRIC_EVENT_SIGNALING_DESCRIBE_CHANNEL );
-        #endif
-        ret = DescribeSignalingChannel( pCtx, &( pConnectInfo->channelName ) );
-        #if METRIC_PRINT_ENABLED
-        Metric_EndEvent( METRIC_EVENT_SIGNALING_DESCRIBE_CHANNEL );
-        #endif
+        if( AreCredentialsExpired( pCtx, pConnectInfo ) != 0U )
+        {
+            #if METRIC_PRINT_ENABLED
+            Metric_StartEvent( METRIC_EVENT_SIGNALING_GET_CREDENTIALS );
+            #endif
+            ret = FetchTemporaryCredentials( pCtx,
+                                             &( pConnectInfo->awsIotCreds ) );
+            #if METRIC_PRINT_ENABLED
+            Metric_EndEvent( METRIC_EVENT_SIGNALING_GET_CREDENTIALS );
+            #endif
+        }
+        else
+        {
+            /* The application must have supplied AWS credentials, they are
+             * never refreshed in the background. */
+            ret = GetInactiveBuffer( pCtx,
+                                     &( pCtx->activeCredentials ),
+                                     &( pCtx->credentialsReaders[ 0 ] ),
+                                     &( index ) );
+
+            if( ret == SIGNALING_CONTROLLER_RESULT_OK )
+            {
+                pCredentials = &( pCtx->credentials[ index ] );
+
+                memcpy( &( pCredentials->accessKeyId[ 0 ] ),
+                        pConnectInfo->awsCreds.pAccessKeyId,
+                        pConnectInfo->awsCreds.accessKeyIdLen );
+                pCredentials->accessKeyIdLength = pConnectInfo->awsCreds.accessKeyIdLen;
+
+                memcpy( &( pCredentials->secretAccessKey[ 0 ] ),
+                        pConnectInfo->awsCreds.pSecretAccessKey,
+                        pConnectInfo->awsCreds.secretAccessKeyLen );
+                pCredentials->secretAccessKeyLength = pConnectInfo->awsCreds.secretAccessKeyLen;
+
+                memcpy( &( pCredentials->sessionToken[ 0 ] ),
+                        pConnectInfo->awsCreds.pSessionToken,
+                        pConnectInfo->awsCreds.sessionTokenLength );
+                pCredentials->sessionTokenLength = pConnectInfo->awsCreds.sessionTokenLength;
+
+                pCredentials->expirationSeconds = pConnectInfo->awsCreds.expirationSeconds;
+                pCredentials->refreshTimeSeconds = 0;
+
+                PublishBuffer( &( pCtx->activeCredentials ), index );
+            }
+        }
+
+        if( ( ret == SIGNALING_CONTROLLER_RESULT_OK ) &&
+            ( isChannelReused == 0U ) )
+        {
+            pCtx->isBootstrappedFromCache = 0U;
+
+            /* A cached channel ARN and endpoints let the websocket connect
+             * right away, they are validated by the bootstrap task. */
+            if( pConnectInfo->pCacheFilePath != NULL )
+            {
+                /* On failure the cache is skipped and the channel is resolved. */
+                if( ( GetInactiveBuffer( pCtx,
+                                         &( pCtx->activeIceServerConfigs ),
+                                         &( pCtx->iceServerConfigsReaders[ 0 ] ),
+                                         &( index ) ) == SIGNALING_CONTROLLER_RESULT_OK ) &&
+                    ( SignalingControllerCache_Load( pCtx, pConnectInfo, &( pCtx->iceServerConfigs[ index ] ) ) == SIGNALING_CONTROLLER_RESULT_OK ) )
+                {
+                    pCtx->isBootstrappedFromCache = 1U;
+
+                    if( pCtx->iceServerConfigs[ index ].iceServerConfigsCount > 0 )
+                    {
+                        PublishBuffer( &( pCtx->activeIceServerConfigs ), index );
+                    }
+                }
+            }
+
+            if( pCtx->isBootstrappedFromCache == 0U )
+            {
+                ret = ResolveChannelEndpoints( pCtx, pConnectInfo );
+            }
+        }
+        else
+        {
+            /* A reconnect reuses the channel ARN and endpoints in memory. */
+            pCtx->isBootstrappedFromCache = 0U;
+        }
+
+        if( ret == SIGNALING_CONTROLLER_RESULT_OK )
+        {
+            ret = ConstructWssEndpointUrl( pCtx );
+        }
     }
+    pthread_mutex_unlock( &( pCtx->httpMutex ) );
 
     if( ret == SIGNALING_CONTROLLER_RESULT_OK )
     {
+        /* Fetch the ICE server configs during the websocket handshake. */
+        StartBootstrapTask( pCtx );
+
         #if METRIC_PRINT_ENABLED
-        Metric_StartEvent( METRIC_EVENT_SIGNALING_GET_ENDPOINTS );
+        Metric_StartEvent( METRIC_EVENT_SIGNALING_CONNECT_WSS_SERVER );
         #endif
-        ret = GetSignalingChannelEndpoints( pCtx, pConnectInfo->enableStorageSession );
+        ret = ConnectToWssEndpoint( pCtx );
         #if METRIC_PRINT_ENABLED
-        Metric_EndEvent( METRIC_EVENT_SIGNALING_GET_ENDPOINTS );
+        Metric_EndEvent( METRIC_EVENT_SIGNALING_CONNECT_WSS_SERVER );
         #endif
     }
 
-    if( ret == SIGNALING_CONTROLLER_RESULT_OK )
+    if( ( ret != SIGNALING_CONTROLLER_RESULT_OK ) &&
+        ( pCtx->isBootstrappedFromCache != 0U ) )
     {
-        #if METRIC_PRINT_ENABLED
-        Metric_StartEvent( METRIC_EVENT_SIGNALING_GET_ICE_SERVER_LIST );
-        #endif
-        ret = GetIceServerConfigs( pCtx );
-        #if METRIC_PRINT_ENABLED
-        Metric_EndEvent( METRIC_EVENT_SIGNALING_GET_ICE_SERVER_LIST );
-        #endif
+        LogWarn( ( "Fail to connect with the cached WSS endpoint, resolving it again." ) );
+        WaitBootstrapTask( pCtx );
+
+        pthread_mutex_lock( &( pCtx->httpMutex ) );
+        {
+            pCtx->isBootstrappedFromCache = 0U;
+
+            if( pCtx->isBootstrapValidated != 0U )
+            {
+                /* The bootstrap task already refreshed the cache. */
+                ret = SIGNALING_CONTROLLER_RESULT_OK;
+            }
+            else
+            {
+                SignalingControllerCache_Remove( pConnectInfo );
+                ret = ResolveChannelEndpoints( pCtx, pConnectInfo );
+
+                /* The cached ICE server configs may belong to a stale channel. */
+                __atomic_store_n( &( pCtx->iceServerConfigs[ pCtx->activeIceServerConfigs ].refreshTimeSec ),
+                                  0,
+                                  __ATOMIC_SEQ_CST );
+            }
+
+            if( ret == SIGNALING_CONTROLLER_RESULT_OK )
+            {
+                ret = ConstructWssEndpointUrl( pCtx );
+            }
+        }
+        pthread_mutex_unlock( &( pCtx->httpMutex ) );
+
+        if( ret == SIGNALING_CONTROLLER_RESULT_OK )
+        {
+            if( pCtx->isBootstrapValidated == 0U )
+            {
+                StartBootstrapTask( pCtx );
+            }
+
+            #if METRIC_PRINT_ENABLED
+            Metric_StartEvent( METRIC_EVENT_SIGNALING_CONNECT_WSS_SERVER );
+            #endif
+            ret = ConnectToWssEndpoint( pCtx );
+            #if METRIC_PRINT_ENABLED
+            Metric_EndEvent( METRIC_EVENT_SIGNALING_CONNECT_WSS_SERVER );
+            #endif
+        }
     }
 
-    if( ret == SIGNALING_CONTROLLER_RESULT_OK )
+    if( ( ret != SIGNALING_CONTROLLER_RESULT_OK ) &&
+        ( isChannelReused != 0U ) )
     {
-        #if METRIC_PRINT_ENABLED
-        Metric_StartEvent( METRIC_EVENT_SIGNALING_CONNECT_WSS_SERVER );
-        #endif
-        ret = ConnectToWssEndpoint( pCtx );
-        #if METRIC_PRINT_ENABLED
-        Metric_EndEvent( METRIC_EVENT_SIGNALING_CONNECT_WSS_SERVER );
-        #endif
+        LogWarn( ( "Fail to reconnect with the last WSS endpoint, resolving it again on the next attempt." ) );
+        pCtx->isChannelResolved = 0U;
+    }
+    else if( ret == SIGNALING_CONTROLLER_RESULT_OK )
+    {
+        pCtx->isChannelResolved = 1U;
+    }
+    else
+    {
+        /* Empty else marker. */
     }
 
     /* Join the storage session, if enabled. */
     if( ( ret == SIGNALING_CONTROLLER_RESULT_OK ) &&
         ( pConnectInfo->enableStorageSession != 0 ) )
     {
+        pthread_mutex_lock( &( pCtx->httpMutex ) );
         #if METRIC_PRINT_ENABLED
         Metric_StartEvent( METRIC_EVENT_SIGNALING_JOIN_STORAGE_SESSION );
         #endif
@@ -922,11 +1502,37 @@ static SignalingControllerResult_t ConnectToSignalingService( SignalingControlle
         #if METRIC_PRINT_ENABLED
         Metric_EndEvent( METRIC_EVENT_SIGNALING_JOIN_STORAGE_SESSION );
         #endif
+        pthread_mutex_unlock( &( pCtx->httpMutex ) );
     }
 
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static SignalingControllerResult_t ResolveChannelEndpoints( SignalingControllerContext_t * pCtx,
+                                                            const SignalingControllerConnectInfo_t * pConnectInfo )
+{
+    SignalingControllerResult_t ret = SIGNALING_CONTROLLER_RESULT_OK;
+
+    /* Must be called with httpMutex held. */
+    #if METRIC_PRINT_ENABLED
+    Metric_StartEvent( METRIC_EVENT_SIGNALING_DESCRIBE_CHANNEL );
+    #endif
+    ret = DescribeSignalingChannel( pCtx, &( pConnectInfo->channelName ) );
+    #if METRIC_PRINT_ENABLED
+    Metric_EndEvent( METRIC_EVENT_SIGNALING_DESCRIBE_CHANNEL );
+    #endif
+
     if( ret == SIGNALING_CONTROLLER_RESULT_OK )
     {
-        LogSignalingInfo( pCtx );
+        #if METRIC_PRINT_ENABLED
+        Metric_StartEvent( METRIC_EVENT_SIGNALING_GET_ENDPOINTS );
+        #endif
+        ret = GetSignalingChannelEndpoints( pCtx, pConnectInfo->enableStorageSession );
+        #if METRIC_PRINT_ENABLED
+        Metric_EndEvent( METRIC_EVENT_SIGNALING_GET_ENDPOINTS );
+        #endif
     }
 
     return ret;
@@ -934,57 +1540,648 @@ static SignalingControllerResult_t ConnectToSignalingService( SignalingControlle
 
 /*----------------------------------------------------------------------------*/
 
+static void * BootstrapTask( void * pParameter )
+{
+    SignalingControllerContext_t * pCtx = ( SignalingControllerContext_t * ) pParameter;
+    SignalingControllerResult_t iceResult = SIGNALING_CONTROLLER_RESULT_OK;
+    SignalingControllerResult_t validateResult = SIGNALING_CONTROLLER_RESULT_OK;
+    char cachedChannelArn[ SIGNALING_CONTROLLER_ARN_BUFFER_LENGTH + 1 ];
+    char cachedWssEndpoint[ SIGNALING_CONTROLLER_ENDPOINT_BUFFER_LENGTH + 1 ];
+    SignalingIceServerConfigs_t * pIceServerConfigs;
+
+    pthread_mutex_lock( &( pCtx->httpMutex ) );
+    {
+        /* Viewers need the ICE server configs, fetch them before validating. */
+        pIceServerConfigs = &( pCtx->iceServerConfigs[ pCtx->activeIceServerConfigs ] );
+
+        if( ( pIceServerConfigs->iceServerConfigsCount == 0 ) ||
+            ( pIceServerConfigs->refreshTimeSec <= NetworkingUtils_GetCurrentTimeSec( NULL ) ) )
+        {
+            #if METRIC_PRINT_ENABLED
+            Metric_StartEvent( METRIC_EVENT_SIGNALING_GET_ICE_SERVER_LIST );
+            #endif
+            iceResult = GetIceServerConfigs( pCtx );
+            #if METRIC_PRINT_ENABLED
+            Metric_EndEvent( METRIC_EVENT_SIGNALING_GET_ICE_SERVER_LIST );
+            #endif
+        }
+
+        if( pCtx->isBootstrappedFromCache != 0U )
+        {
+            memcpy( cachedChannelArn, pCtx->signalingChannelArn, sizeof( cachedChannelArn ) );
+            memcpy( cachedWssEndpoint, pCtx->wssEndpoint, sizeof( cachedWssEndpoint ) );
+
+            validateResult = ResolveChannelEndpoints( pCtx, pCtx->pConnectInfo );
+
+            if( validateResult != SIGNALING_CONTROLLER_RESULT_OK )
+            {
+                LogWarn( ( "Fail to validate the cached channel ARN and endpoints." ) );
+            }
+            else
+            {
+                pCtx->isBootstrapValidated = 1U;
+
+                if( strcmp( cachedWssEndpoint, pCtx->wssEndpoint ) != 0 )
+                {
+                    LogInfo( ( "WSS endpoint changed, it's used from the next connection." ) );
+                }
+
+                /* The first fetch may have used a stale channel or endpoint. */
+                if( ( iceResult != SIGNALING_CONTROLLER_RESULT_OK ) ||
+                    ( strcmp( cachedChannelArn, pCtx->signalingChannelArn ) != 0 ) )
+                {
+                    iceResult = GetIceServerConfigs( pCtx );
+                }
+            }
+        }
+
+        if( ( pCtx->pConnectInfo->pCacheFilePath != NULL ) &&
+            ( validateResult == SIGNALING_CONTROLLER_RESULT_OK ) &&
+            ( iceResult == SIGNALING_CONTROLLER_RESULT_OK ) )
+        {
+            ( void ) SignalingControllerCache_Store( pCtx,
+                                                     pCtx->pConnectInfo,
+                                                     &( pCtx->iceServerConfigs[ pCtx->activeIceServerConfigs ] ) );
+        }
+
+        LogSignalingInfo( pCtx );
+    }
+    pthread_mutex_unlock( &( pCtx->httpMutex ) );
+
+    return NULL;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static void StartBootstrapTask( SignalingControllerContext_t * pCtx )
+{
+    pCtx->isBootstrapValidated = 0U;
+
+    if( pthread_create( &( pCtx->bootstrapTask ),
+                        NULL,
+                        BootstrapTask,
+                        pCtx ) != 0 )
+    {
+        LogWarn( ( "Fail to create signaling bootstrap task, running it inline." ) );
+        ( void ) BootstrapTask( pCtx );
+    }
+    else
+    {
+        pCtx->isBootstrapTaskStarted = 1U;
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+static void WaitBootstrapTask( SignalingControllerContext_t * pCtx )
+{
+    if( pCtx->isBootstrapTaskStarted != 0U )
+    {
+        pthread_join( pCtx->bootstrapTask, NULL );
+        pCtx->isBootstrapTaskStarted = 0U;
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
 static uint8_t AreCredentialsExpired( SignalingControllerContext_t * pCtx,
                                       const SignalingControllerConnectInfo_t * pConnectInfo )
 {
     uint8_t credentialsExpired = 0U;
     uint64_t currentTimeSeconds = NetworkingUtils_GetCurrentTimeSec( NULL );
+    const SignalingCredentials_t * pCredentials = &( pCtx->credentials[ pCtx->activeCredentials ] );
 
     if( ( pConnectInfo->awsIotCreds.thingNameLength > 0 ) &&
         ( pConnectInfo->awsIotCreds.roleAliasLength > 0 ) &&
         ( pConnectInfo->awsIotCreds.iotCredentialsEndpointLength > 0 ) )
     {
-        if( ( pCtx->expirationSeconds == 0 ) ||
-            ( currentTimeSeconds >= pCtx->expirationSeconds - SIGNALING_CONTROLLER_FETCH_CREDS_GRACE_PERIOD_SEC ) )
-        {
-            credentialsExpired = 1U;
-        }
+        if( ( pCredentials->expirationSeconds == 0 ) ||
+            ( currentTimeSeconds >= pCredentials->expirationSeconds - SIGNALING_CONTROLLER_FETCH_CREDS_GRACE_PERIOD_SEC ) )
+        {
+            credentialsExpired = 1U;
+        }
+    }
+
+    return credentialsExpired;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static void LogSignalingInfo( SignalingControllerContext_t * pCtx )
+{
+    size_t i, j;
+    const SignalingIceServerConfigs_t * pIceServerConfigs = &( pCtx->iceServerConfigs[ pCtx->activeIceServerConfigs ] );
+
+    LogInfo( ( "======================================== Channel Info ========================================" ) );
+    LogInfo( ( "Signaling Channel ARN: %s", &( pCtx->signalingChannelArn[ 0 ] ) ) );
+
+    LogInfo( ( "======================================== Endpoints Info ========================================" ) );
+    LogInfo( ( "HTTPS Endpoint: %s", &( pCtx->httpsEndpoint[ 0 ] ) ) );
+    LogInfo( ( "WSS Endpoint: %s", &( pCtx->wssEndpoint[ 0 ] ) ) );
+    LogInfo( ( "WebRTC Endpoint: %s", pCtx->webrtcEndpointLength == 0 ? "N/A" : &( pCtx->webrtcEndpoint[ 0 ] ) ) );
+
+    /* Ice server list */
+    LogInfo( ( "======================================== Ice Server List ========================================" ) );
+    LogInfo( ( "Ice Server Count: %lu", pIceServerConfigs->iceServerConfigsCount ) );
+    for( i = 0; i < pIceServerConfigs->iceServerConfigsCount; i++ )
+    {
+        LogInfo( ( "======================================== Ice Server[%lu] ========================================", i ) );
+        LogInfo( ( "    TTL (seconds): %u", pIceServerConfigs->iceServerConfigs[ i ].ttlSeconds ) );
+        LogInfo( ( "    User Name: %s", pIceServerConfigs->iceServerConfigs[ i ].userName ) );
+        LogInfo( ( "    Password: %s", pIceServerConfigs->iceServerConfigs[ i ].password ) );
+        LogInfo( ( "    URI Count: %lu", pIceServerConfigs->iceServerConfigs[ i ].iceServerUriCount ) );
+
+        for( j = 0; j < pIceServerConfigs->iceServerConfigs[ i ].iceServerUriCount; j++ )
+        {
+            LogInfo( ( "        URI: %s", &( pIceServerConfigs->iceServerConfigs[ i ].iceServerUris[ j ].uri[ 0 ] ) ) );
+        }
+    }
+    fflush( stdout );
+}
+
+/*----------------------------------------------------------------------------*/
+
+static SignalingControllerResult_t GrowTxBuffer( char ** ppBuffer,
+                                                 size_t * pBufferSize,
+                                                 size_t requiredSize )
+{
+    SignalingControllerResult_t ret = SIGNALING_CONTROLLER_RESULT_OK;
+    char * pNewBuffer;
+
+    if( requiredSize > *pBufferSize )
+    {
+        if( requiredSize < SIGNALING_CONTROLLER_MESSAGE_BUFFER_LENGTH )
+        {
+            requiredSize = SIGNALING_CONTROLLER_MESSAGE_BUFFER_LENGTH;
+        }
+
+        pNewBuffer = ( char * ) realloc( *ppBuffer, requiredSize );
+
+        if( pNewBuffer == NULL )
+        {
+            LogError( ( "Failed to allocate %lu bytes for signaling Tx buffer!", requiredSize ) );
+            ret = SIGNALING_CONTROLLER_RESULT_FAIL;
+        }
+        else
+        {
+            *ppBuffer = pNewBuffer;
+            *pBufferSize = requiredSize;
+        }
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static SignalingControllerResult_t QueueSignalingMessage( SignalingControllerContext_t * pCtx,
+                                                          const SignalingMessage_t * pSignalingMessage )
+{
+    SignalingControllerResult_t ret = SIGNALING_CONTROLLER_RESULT_OK;
+    Base64Result_t base64Result;
+    WssSendMessage_t wssSendMessage;
+    SignalingResult_t signalingResult;
+    NetworkingResult_t networkingResult;
+    size_t encodedLength;
+
+    /* Must be called with signalingTxMutex held, the Tx buffers are shared. */
+    LogDebug( ( "Sending signaling message(%lu): %.*s",
+                pSignalingMessage->messageLength,
+                ( int ) pSignalingMessage->messageLength,
+                pSignalingMessage->pMessage ) );
+
+    /* Size the buffers for the base64 encoded message and the JSON envelope around it. */
+    encodedLength = ( ( pSignalingMessage->messageLength + 2U ) / 3U ) * 4U + 1U;
+    ret = GrowTxBuffer( &( pCtx->pSignalingIntermediateMessageBuffer ),
+                        &( pCtx->signalingIntermediateMessageBufferSize ),
+                        encodedLength );
+
+    if( ret == SIGNALING_CONTROLLER_RESULT_OK )
+    {
+        ret = GrowTxBuffer( &( pCtx->pSignalingTxMessageBuffer ),
+                            &( pCtx->signalingTxMessageBufferSize ),
+                            encodedLength + pSignalingMessage->correlationIdLength +
+                            pSignalingMessage->remoteClientIdLength + SIGNALING_CONTROLLER_MESSAGE_ENVELOPE_LENGTH );
+    }
+
+    if( ret == SIGNALING_CONTROLLER_RESULT_OK )
+    {
+        pCtx->signalingIntermediateMessageLength = pCtx->signalingIntermediateMessageBufferSize;
+        base64Result = Base64_Encode( pSignalingMessage->pMessage,
+                                      pSignalingMessage->messageLength,
+                                      pCtx->pSignalingIntermediateMessageBuffer,
+                                      &( pCtx->signalingIntermediateMessageLength ) );
+
+        if( base64Result != BASE64_RESULT_OK )
+        {
+            LogError( ( "Failed to base64 encode signaling message. Result: %d!", base64Result ) );
+            ret = SIGNALING_CONTROLLER_RESULT_FAIL;
+        }
+    }
+
+    if( ret == SIGNALING_CONTROLLER_RESULT_OK )
+    {
+        memset( &( wssSendMessage ), 0, sizeof( WssSendMessage_t ) );
+
+        wssSendMessage.messageType = pSignalingMessage->messageType;
+        wssSendMessage.pBase64EncodedMessage = pCtx->pSignalingIntermediateMessageBuffer;
+        wssSendMessage.base64EncodedMessageLength = pCtx->signalingIntermediateMessageLength;
+        wssSendMessage.pCorrelationId = pSignalingMessage->pCorrelationId;
+        wssSendMessage.correlationIdLength = pSignalingMessage->correlationIdLength;
+        wssSendMessage.pRecipientClientId = pSignalingMessage->pRemoteClientId;
+        wssSendMessage.recipientClientIdLength = pSignalingMessage->remoteClientIdLength;
+
+        pCtx->signalingTxMessageLength = pCtx->signalingTxMessageBufferSize;
+        signalingResult = Signaling_ConstructWssMessage( &( wssSendMessage ),
+                                                         pCtx->pSignalingTxMessageBuffer,
+                                                         &( pCtx->signalingTxMessageLength ) );
+
+        if( signalingResult != SIGNALING_RESULT_OK )
+        {
+            LogError( ( "Failed to construct signaling Wss message. Result: %d!", signalingResult ) );
+            ret = SIGNALING_CONTROLLER_RESULT_FAIL;
+        }
+    }
+
+    if( ret == SIGNALING_CONTROLLER_RESULT_OK )
+    {
+        LogVerbose( ( "Constructed signaling WSS message (%lu): \n%.*s",
+                      pCtx->signalingTxMessageLength,
+                      ( int ) pCtx->signalingTxMessageLength,
+                      pCtx->pSignalingTxMessageBuffer ) );
+
+        networkingResult = Networking_WebsocketQueue( &( pCtx->websocketContext ),
+                                                      pCtx->pSignalingTxMessageBuffer,
+                                                      pCtx->signalingTxMessageLength );
+
+        if( networkingResult != NETWORKING_RESULT_OK )
+        {
+            LogError( ( "Failed to send signaling Wss message. Result: %d!", networkingResult ) );
+            ret = SIGNALING_CONTROLLER_RESULT_FAIL;
+        }
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static void FlushBatchedMessages( SignalingControllerContext_t * pCtx )
+{
+    SignalingBatchedMessage_t * pPending;
+    SignalingBatchedMessage_t * pCurrent;
+    SignalingBatchedMessage_t ** ppLink;
+    SignalingBatchedMessage_t * pGroupLeader;
+    SignalingBatchedMessage_t * pRetryHead = NULL;
+    SignalingBatchedMessage_t * pRetryTail = NULL;
+    SignalingMessage_t signalingMessage;
+    uint32_t sentCount = 0;
+    uint32_t retryCount = 0;
+    uint8_t isLeaderRetried;
+
+    pthread_mutex_lock( &( pCtx->batchMutex ) );
+    {
+        pPending = pCtx->pBatchHead;
+        pCtx->pBatchHead = NULL;
+        pCtx->pBatchTail = NULL;
+        pCtx->batchedMessageCount = 0;
+    }
+    pthread_mutex_unlock( &( pCtx->batchMutex ) );
+
+    if( pPending != NULL )
+    {
+        memset( &( signalingMessage ), 0, sizeof( SignalingMessage_t ) );
+
+        pthread_mutex_lock( &( pCtx->signalingTxMutex ) );
+        {
+            /* Keep the messages for the reconnect, in order. */
+            while( ( pCtx->state != SIGNALING_CONTROLLER_STATE_CONNECTED ) &&
+                   ( pPending != NULL ) )
+            {
+                pCurrent = pPending;
+                pPending = pPending->pNext;
+                HoldMessage( pCtx, pCurrent );
+            }
+
+            /* Earlier messages that failed to queue go out first, in order. */
+            if( pPending != NULL )
+            {
+                sentCount += SendHeldMessages( pCtx );
+            }
+
+            /* Send all messages of the oldest remote client, in order, before
+             * moving on to the next one. */
+            while( pPending != NULL )
+            {
+                pGroupLeader = pPending;
+                ppLink = &( pPending );
+                isLeaderRetried = 0U;
+
+                while( *ppLink != NULL )
+                {
+                    pCurrent = *ppLink;
+
+                    if( ( pCurrent->remoteClientIdLength == pGroupLeader->remoteClientIdLength ) &&
+                        ( memcmp( &( pCurrent->data[ 0 ] ), &( pGroupLeader->data[ 0 ] ), pCurrent->remoteClientIdLength ) == 0 ) )
+                    {
+                        signalingMessage.messageType = pCurrent->messageType;
+                        signalingMessage.pRemoteClientId = &( pCurrent->data[ 0 ] );
+                        signalingMessage.remoteClientIdLength = pCurrent->remoteClientIdLength;
+                        signalingMessage.pMessage = &( pCurrent->data[ pCurrent->remoteClientIdLength + pCurrent->correlationIdLength ] );
+                        signalingMessage.messageLength = pCurrent->messageLength;
+
+                        /* Unlink, the leader is freed last as the others are compared against it. */
+                        *ppLink = pCurrent->pNext;
+
+                        if( ( pCtx->pHeldHead == NULL ) &&
+                            ( pRetryHead == NULL ) &&
+                            ( QueueSignalingMessage( pCtx, &( signalingMessage ) ) == SIGNALING_CONTROLLER_RESULT_OK ) )
+                        {
+                            sentCount++;
+
+                            if( pCurrent != pGroupLeader )
+                            {
+                                free( pCurrent );
+                            }
+                        }
+                        else
+                        {
+                            /* Keep it and everything after it for the retry, in order. */
+                            pCurrent->pNext = NULL;
+                            if( pRetryTail == NULL )
+                            {
+                                pRetryHead = pCurrent;
+                            }
+                            else
+                            {
+                                pRetryTail->pNext = pCurrent;
+                            }
+                            pRetryTail = pCurrent;
+                            retryCount++;
+
+                            if( pCurrent == pGroupLeader )
+                            {
+                                isLeaderRetried = 1U;
+                            }
+                        }
+                    }
+                    else
+                    {
+                        ppLink = &( pCurrent->pNext );
+                    }
+                }
+
+                if( isLeaderRetried == 0U )
+                {
+                    free( pGroupLeader );
+                }
+            }
+
+            /* Hold the failed messages, they are retried on the next flush or after the reconnect. */
+            while( pRetryHead != NULL )
+            {
+                pCurrent = pRetryHead;
+                pRetryHead = pRetryHead->pNext;
+                HoldMessage( pCtx, pCurrent );
+            }
+
+            if( sentCount > 0U )
+            {
+                ( void ) Networking_WebsocketFlush( &( pCtx->websocketContext ) );
+            }
+        }
+        pthread_mutex_unlock( &( pCtx->signalingTxMutex ) );
+
+        if( retryCount > 0U )
+        {
+            LogWarn( ( "Failed to queue %u batched signaling messages, holding them for retry.", retryCount ) );
+        }
+
+        LogDebug( ( "Flushed %u batched signaling messages.", sentCount ) );
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+static void OnBatchTimerExpire( void * pUserContext )
+{
+    FlushBatchedMessages( ( SignalingControllerContext_t * ) pUserContext );
+}
+
+/*----------------------------------------------------------------------------*/
+
+static SignalingBatchedMessage_t * CreateBatchedMessage( const SignalingMessage_t * pSignalingMessage )
+{
+    SignalingBatchedMessage_t * pMessage;
+
+    pMessage = ( SignalingBatchedMessage_t * ) malloc( sizeof( SignalingBatchedMessage_t ) +
+                                                       pSignalingMessage->remoteClientIdLength +
+                                                       pSignalingMessage->correlationIdLength +
+                                                       pSignalingMessage->messageLength );
+
+    if( pMessage == NULL )
+    {
+        LogError( ( "Failed to allocate batched signaling message!" ) );
+    }
+    else
+    {
+        pMessage->pNext = NULL;
+        pMessage->messageType = pSignalingMessage->messageType;
+        pMessage->remoteClientIdLength = pSignalingMessage->remoteClientIdLength;
+        pMessage->correlationIdLength = pSignalingMessage->correlationIdLength;
+        pMessage->messageLength = pSignalingMessage->messageLength;
+
+        if( pSignalingMessage->remoteClientIdLength > 0U )
+        {
+            memcpy( &( pMessage->data[ 0 ] ),
+                    pSignalingMessage->pRemoteClientId,
+                    pSignalingMessage->remoteClientIdLength );
+        }
+
+        if( pSignalingMessage->correlationIdLength > 0U )
+        {
+            memcpy( &( pMessage->data[ pSignalingMessage->remoteClientIdLength ] ),
+                    pSignalingMessage->pCorrelationId,
+                    pSignalingMessage->correlationIdLength );
+        }
+
+        memcpy( &( pMessage->data[ pSignalingMessage->remoteClientIdLength + pSignalingMessage->correlationIdLength ] ),
+                pSignalingMessage->pMessage,
+                pSignalingMessage->messageLength );
+    }
+
+    return pMessage;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static void HoldMessage( SignalingControllerContext_t * pCtx,
+                         SignalingBatchedMessage_t * pMessage )
+{
+    /* Must be called with signalingTxMutex held, takes ownership of pMessage. */
+    pMessage->pNext = NULL;
+
+    if( pCtx->heldMessageCount >= SIGNALING_CONTROLLER_MAX_HELD_MESSAGES )
+    {
+        pCtx->droppedMessageCount++;
+        LogWarn( ( "Too many signaling messages held for the reconnect, dropping one of type %d, %u dropped so far.",
+                   pMessage->messageType,
+                   pCtx->droppedMessageCount ) );
+        free( pMessage );
+    }
+    else
+    {
+        if( pCtx->pHeldTail == NULL )
+        {
+            pCtx->pHeldHead = pMessage;
+        }
+        else
+        {
+            pCtx->pHeldTail->pNext = pMessage;
+        }
+        pCtx->pHeldTail = pMessage;
+        pCtx->heldMessageCount++;
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+static uint32_t SendHeldMessages( SignalingControllerContext_t * pCtx )
+{
+    SignalingBatchedMessage_t * pCurrent;
+    SignalingMessage_t signalingMessage;
+    uint32_t sentCount = 0;
+
+    /* Must be called with signalingTxMutex held. */
+    memset( &( signalingMessage ), 0, sizeof( SignalingMessage_t ) );
+
+    while( pCtx->pHeldHead != NULL )
+    {
+        pCurrent = pCtx->pHeldHead;
+
+        signalingMessage.messageType = pCurrent->messageType;
+        signalingMessage.pRemoteClientId = &( pCurrent->data[ 0 ] );
+        signalingMessage.remoteClientIdLength = pCurrent->remoteClientIdLength;
+        signalingMessage.pCorrelationId = pCurrent->correlationIdLength > 0U ? &( pCurrent->data[ pCurrent->remoteClientIdLength ] ) : NULL;
+        signalingMessage.correlationIdLength = pCurrent->correlationIdLength;
+        signalingMessage.pMessage = &( pCurrent->data[ pCurrent->remoteClientIdLength + pCurrent->correlationIdLength ] );
+        signalingMessage.messageLength = pCurrent->messageLength;
+
+        if( QueueSignalingMessage( pCtx, &( signalingMessage ) ) != SIGNALING_CONTROLLER_RESULT_OK )
+        {
+            /* Keep this one and the rest held for the next attempt, in order. */
+            LogWarn( ( "Failed to queue held signaling message, %u still held.", pCtx->heldMessageCount ) );
+            break;
+        }
+
+        sentCount++;
+        pCtx->pHeldHead = pCurrent->pNext;
+        pCtx->heldMessageCount--;
+        free( pCurrent );
+    }
+
+    if( pCtx->pHeldHead == NULL )
+    {
+        pCtx->pHeldTail = NULL;
+    }
+
+    if( sentCount > 0U )
+    {
+        ( void ) Networking_WebsocketFlush( &( pCtx->websocketContext ) );
+    }
+
+    return sentCount;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static void SetState( SignalingControllerContext_t * pCtx,
+                      SignalingControllerState_t state )
+{
+    pthread_mutex_lock( &( pCtx->signalingTxMutex ) );
+    {
+        pCtx->state = state;
+    }
+    pthread_mutex_unlock( &( pCtx->signalingTxMutex ) );
+}
+
+/*----------------------------------------------------------------------------*/
+
+static uint32_t GetReconnectDelayMs( uint32_t connectAttempts )
+{
+    uint32_t capMs = SIGNALING_CONTROLLER_RECONNECT_MAX_DELAY_MS;
+
+    if( connectAttempts == 0U )
+    {
+        capMs = 0U;
+    }
+    else if( connectAttempts <= 16U )
+    {
+        capMs = MIN( ( uint32_t ) SIGNALING_CONTROLLER_RECONNECT_BASE_DELAY_MS << ( connectAttempts - 1U ),
+                     ( uint32_t ) SIGNALING_CONTROLLER_RECONNECT_MAX_DELAY_MS );
+    }
+    else
+    {
+        /* Empty else marker. */
+    }
+
+    return capMs / 2U + ( ( uint32_t ) rand() % ( capMs / 2U + 1U ) );
+}
+
+/*----------------------------------------------------------------------------*/
+
+static void OnConnected( SignalingControllerContext_t * pCtx )
+{
+    uint32_t heldCount;
+    uint64_t reconnectDurationUs;
+
+    pthread_mutex_lock( &( pCtx->signalingTxMutex ) );
+    {
+        pCtx->state = SIGNALING_CONTROLLER_STATE_CONNECTED;
+        heldCount = SendHeldMessages( pCtx );
+    }
+    pthread_mutex_unlock( &( pCtx->signalingTxMutex ) );
+
+    if( pCtx->disconnectTimeUs != 0U )
+    {
+        reconnectDurationUs = NetworkingUtils_GetCurrentTimeUs( NULL ) - pCtx->disconnectTimeUs;
+        pCtx->reconnectCount++;
+
+        LogInfo( ( "Signaling reconnected in %lu us after %u attempts, %u held messages sent, reconnects so far: %u.",
+                   reconnectDurationUs,
+                   pCtx->connectAttempts,
+                   heldCount,
+                   pCtx->reconnectCount ) );
+
+        #if METRIC_PRINT_ENABLED
+        Metric_RecordHistogram( METRIC_HISTOGRAM_SIGNALING_RECONNECT, reconnectDurationUs );
+        Metric_RecordHistogram( METRIC_HISTOGRAM_SIGNALING_RECONNECT_ATTEMPTS, pCtx->connectAttempts );
+        Metric_RecordHistogram( METRIC_HISTOGRAM_SIGNALING_HELD_MESSAGES, heldCount );
+        #endif
+
+        pCtx->disconnectTimeUs = 0;
     }
 
-    return credentialsExpired;
+    /* connectAttempts is reset once the connection stays up, see SIGNALING_CONTROLLER_RECONNECT_MIN_UPTIME_MS. */
+    pCtx->connectedTimeUs = NetworkingUtils_GetCurrentTimeUs( NULL );
+    pCtx->credentialRefreshAttempts = 0;
+    pCtx->credentialRefreshRetryTimeUs = 0;
 }
 
 /*----------------------------------------------------------------------------*/
 
-static void LogSignalingInfo( SignalingControllerContext_t * pCtx )
+static void OnDisconnected( SignalingControllerContext_t * pCtx )
 {
-    size_t i, j;
-
-    LogInfo( ( "======================================== Channel Info ========================================" ) );
-    LogInfo( ( "Signaling Channel ARN: %s", &( pCtx->signalingChannelArn[ 0 ] ) ) );
+    /* Senders hold their messages from now on, the lws context is only
+     * destroyed by the next connect. */
+    SetState( pCtx, SIGNALING_CONTROLLER_STATE_DISCONNECTED );
 
-    LogInfo( ( "======================================== Endpoints Info ========================================" ) );
-    LogInfo( ( "HTTPS Endpoint: %s", &( pCtx->httpsEndpoint[ 0 ] ) ) );
-    LogInfo( ( "WSS Endpoint: %s", &( pCtx->wssEndpoint[ 0 ] ) ) );
-    LogInfo( ( "WebRTC Endpoint: %s", pCtx->webrtcEndpointLength == 0 ? "N/A" : &( pCtx->webrtcEndpoint[ 0 ] ) ) );
-
-    /* Ice server list */
-    LogInfo( ( "======================================== Ice Server List ========================================" ) );
-    LogInfo( ( "Ice Server Count: %lu", pCtx->iceServerConfigsCount ) );
-    for( i = 0; i < pCtx->iceServerConfigsCount; i++ )
+    if( pCtx->disconnectTimeUs == 0U )
     {
-        LogInfo( ( "======================================== Ice Server[%lu] ========================================", i ) );
-        LogInfo( ( "    TTL (seconds): %u", pCtx->iceServerConfigs[ i ].ttlSeconds ) );
-        LogInfo( ( "    User Name: %s", pCtx->iceServerConfigs[ i ].userName ) );
-        LogInfo( ( "    Password: %s", pCtx->iceServerConfigs[ i ].password ) );
-        LogInfo( ( "    URI Count: %lu", pCtx->iceServerConfigs[ i ].iceServerUriCount ) );
-
-        for( j = 0; j < pCtx->iceServerConfigs[ i ].iceServerUriCount; j++ )
-        {
-            LogInfo( ( "        URI: %s", &( pCtx->iceServerConfigs[ i ].iceServerUris[ j ].uri[ 0 ] ) ) );
-        }
+        pCtx->disconnectTimeUs = NetworkingUtils_GetCurrentTimeUs( NULL );
     }
-    fflush( stdout );
+
+    LogWarn( ( "Signaling websocket disconnected, reconnecting." ) );
 }
 
 /*----------------------------------------------------------------------------*/
@@ -994,6 +2191,7 @@ SignalingControllerResult_t SignalingController_Init( SignalingControllerContext
 {
     SignalingControllerResult_t ret = SIGNALING_CONTROLLER_RESULT_OK;
     NetworkingResult_t networkingResult;
+    pthread_condattr_t condAttr;
 
     if( ( pCtx == NULL ) || ( pSslCreds == NULL ) )
     {
@@ -1011,6 +2209,83 @@ SignalingControllerResult_t SignalingController_Init( SignalingControllerContext
         }
     }
 
+    if( ret == SIGNALING_CONTROLLER_RESULT_OK )
+    {
+        if( pthread_mutex_init( &( pCtx->httpMutex ), NULL ) != 0 )
+        {
+            LogError( ( "Failed to initialize httpMutex!" ) );
+            ret = SIGNALING_CONTROLLER_RESULT_FAIL;
+        }
+    }
+
+    if( ret == SIGNALING_CONTROLLER_RESULT_OK )
+    {
+        if( pthread_mutex_init( &( pCtx->bufferMutex ), NULL ) != 0 )
+        {
+            LogError( ( "Failed to initialize bufferMutex!" ) );
+            ret = SIGNALING_CONTROLLER_RESULT_FAIL;
+        }
+    }
+
+    if( ret == SIGNALING_CONTROLLER_RESULT_OK )
+    {
+        /* The buffer wait deadline is on the monotonic clock. */
+        if( pthread_condattr_init( &( condAttr ) ) != 0 )
+        {
+            LogError( ( "Failed to initialize bufferCond attributes!" ) );
+            ret = SIGNALING_CONTROLLER_RESULT_FAIL;
+        }
+        else
+        {
+            if( ( pthread_condattr_setclock( &( condAttr ), CLOCK_MONOTONIC ) != 0 ) ||
+                ( pthread_cond_init( &( pCtx->bufferCond ), &( condAttr ) ) != 0 ) )
+            {
+                LogError( ( "Failed to initialize bufferCond!" ) );
+                ret = SIGNALING_CONTROLLER_RESULT_FAIL;
+            }
+
+            pthread_condattr_destroy( &( condAttr ) );
+        }
+    }
+
+    if( ret == SIGNALING_CONTROLLER_RESULT_OK )
+    {
+        if( pthread_mutex_init( &( pCtx->batchMutex ), NULL ) != 0 )
+        {
+            LogError( ( "Failed to initialize batchMutex!" ) );
+            ret = SIGNALING_CONTROLLER_RESULT_FAIL;
+        }
+    }
+
+    if( ret == SIGNALING_CONTROLLER_RESULT_OK )
+    {
+        if( pthread_mutex_init( &( pCtx->refreshMutex ), NULL ) != 0 )
+        {
+            LogError( ( "Failed to initialize refreshMutex!" ) );
+            ret = SIGNALING_CONTROLLER_RESULT_FAIL;
+        }
+    }
+
+    if( ret == SIGNALING_CONTROLLER_RESULT_OK )
+    {
+        if( pthread_cond_init( &( pCtx->refreshCond ), NULL ) != 0 )
+        {
+            LogError( ( "Failed to initialize refreshCond!" ) );
+            ret = SIGNALING_CONTROLLER_RESULT_FAIL;
+        }
+    }
+
+    if( ret == SIGNALING_CONTROLLER_RESULT_OK )
+    {
+        if( TimerController_Create( &( pCtx->batchTimer ),
+                                    OnBatchTimerExpire,
+                                    pCtx ) != TIMER_CONTROLLER_RESULT_OK )
+        {
+            LogError( ( "Failed to create signaling batch timer!" ) );
+            ret = SIGNALING_CONTROLLER_RESULT_FAIL;
+        }
+    }
+
     if( ret == SIGNALING_CONTROLLER_RESULT_OK )
     {
         networkingResult = Networking_HttpInit( &( pCtx->httpContext ),
@@ -1031,6 +2306,7 @@ SignalingControllerResult_t SignalingController_Init( SignalingControllerContext
         if( networkingResult != NETWORKING_RESULT_OK )
         {
             LogError( ( "Failed to initialize websocket!" ) );
+            Networking_HttpDeinit( &( pCtx->httpContext ) );
             ret = SIGNALING_CONTROLLER_RESULT_FAIL;
         }
     }
@@ -1045,45 +2321,117 @@ SignalingControllerResult_t SignalingController_StartListening( SignalingControl
 {
     SignalingControllerResult_t ret = SIGNALING_CONTROLLER_RESULT_OK;
     NetworkingResult_t networkingResult;
+    uint32_t delayMs;
+    uint64_t nowUs;
 
     if( ( pCtx == NULL ) || ( pConnectInfo == NULL ) )
     {
         ret = SIGNALING_CONTROLLER_RESULT_BAD_PARAM;
     }
 
+    if( ( ret == SIGNALING_CONTROLLER_RESULT_OK ) &&
+        ( pCtx->isRefreshTaskStarted == 0U ) )
+    {
+        /* Keeps the credentials and ICE server configs fresh, so SDP offers
+         * never wait on the network for them. */
+        pCtx->pConnectInfo = pConnectInfo;
+
+        if( pthread_create( &( pCtx->refreshTask ),
+                            NULL,
+                            RefreshTask,
+                            pCtx ) != 0 )
+        {
+            LogWarn( ( "Fail to create signaling refresh task, configs are refreshed on expiry only." ) );
+        }
+        else
+        {
+            pCtx->isRefreshTaskStarted = 1U;
+        }
+    }
+
     if( ret == SIGNALING_CONTROLLER_RESULT_OK )
     {
+        pCtx->connectAttempts = 0;
+        SetState( pCtx, SIGNALING_CONTROLLER_STATE_CONNECTING );
+
         for( ;; )
         {
-            ret = SIGNALING_CONTROLLER_RESULT_OK;
-            networkingResult = NETWORKING_RESULT_OK;
+            switch( pCtx->state )
+            {
+                case SIGNALING_CONTROLLER_STATE_CONNECTING:
+                    pCtx->connectAttempts++;
+                    ret = ConnectToSignalingService( pCtx, pConnectInfo );
 
-            ret = ConnectToSignalingService( pCtx, pConnectInfo );
+                    if( ret == SIGNALING_CONTROLLER_RESULT_OK )
+                    {
+                        OnConnected( pCtx );
+                    }
+                    else
+                    {
+                        LogError( ( "Failed to connect to signaling service. Result: %d!", ret ) );
+                        SetState( pCtx, SIGNALING_CONTROLLER_STATE_BACKOFF );
+                    }
+                    break;
 
-            if( ret != SIGNALING_CONTROLLER_RESULT_OK )
-            {
-                LogError( ( "Failed to connect to signaling service. Result: %d!", ret ) );
-                usleep( SIGNALING_CONTROLLER_RETRY_CONNECT_TIMEOUT_MS * 1000 );
-            }
-            else
-            {
-                while( networkingResult == NETWORKING_RESULT_OK )
-                {
+                case SIGNALING_CONTROLLER_STATE_CONNECTED:
                     networkingResult = Networking_WebsocketSignal( &( pCtx->websocketContext ) );
+                    nowUs = NetworkingUtils_GetCurrentTimeUs( NULL );
+
+                    if( ( pCtx->connectAttempts != 0U ) &&
+                        ( nowUs - pCtx->connectedTimeUs >= SIGNALING_CONTROLLER_RECONNECT_MIN_UPTIME_MS * 1000ULL ) )
+                    {
+                        pCtx->connectAttempts = 0;
+                    }
 
-                    if( ( networkingResult == NETWORKING_RESULT_OK ) &&
-                        ( AreCredentialsExpired( pCtx, pConnectInfo ) != 0U ) )
+                    if( networkingResult != NETWORKING_RESULT_OK )
+                    {
+                        OnDisconnected( pCtx );
+                    }
+                    else if( AreCredentialsExpired( pCtx, pConnectInfo ) != 0U )
                     {
-                        ret = FetchTemporaryCredentials( pCtx,
-                                                         &( pConnectInfo->awsIotCreds ) );
-                        if( ret != SIGNALING_CONTROLLER_RESULT_OK )
+                        /* The refresh task does the HTTP request, this thread
+                         * only services the websocket and paces the retries. */
+                        if( ( pCtx->isRefreshTaskStarted != 0U ) &&
+                            ( nowUs >= pCtx->credentialRefreshRetryTimeUs ) )
                         {
-                            LogWarn( ( "Fail to fetch temporary credentials, reconnecting." ) );
-                            break;
+                            if( pCtx->credentialRefreshAttempts > 0U )
+                            {
+                                LogWarn( ( "Credentials are still expired, requesting refresh attempt %u.",
+                                           pCtx->credentialRefreshAttempts + 1U ) );
+                            }
+
+                            RequestCredentialRefresh( pCtx );
+                            pCtx->credentialRefreshAttempts++;
+                            delayMs = GetReconnectDelayMs( pCtx->credentialRefreshAttempts );
+                            pCtx->credentialRefreshRetryTimeUs = nowUs + delayMs * 1000ULL;
                         }
                     }
+                    else if( pCtx->credentialRefreshAttempts != 0U )
+                    {
+                        pCtx->credentialRefreshAttempts = 0;
+                        pCtx->credentialRefreshRetryTimeUs = 0;
+                    }
+                    else
+                    {
+                        /* Empty else marker. */
+                    }
+                    break;
 
-                }
+                case SIGNALING_CONTROLLER_STATE_DISCONNECTED:
+                    /* GO_AWAY or a dropped connection, the backoff is immediate
+                     * unless the connection dropped before the min uptime. */
+                    SetState( pCtx, SIGNALING_CONTROLLER_STATE_BACKOFF );
+                    break;
+
+                case SIGNALING_CONTROLLER_STATE_BACKOFF:
+                default:
+                    delayMs = GetReconnectDelayMs( pCtx->connectAttempts );
+                    LogInfo( ( "Retrying signaling connection in %u ms, attempt %u.",
+                               delayMs,
+                               pCtx->connectAttempts + 1U ) );
+                    usleep( delayMs * 1000U );
+                    SetState( pCtx, SIGNALING_CONTROLLER_STATE_CONNECTING );
+                    break;
             }
         }
     }
@@ -1097,10 +2445,7 @@ SignalingControllerResult_t SignalingController_SendMessage( SignalingController
                                                              const SignalingMessage_t * pSignalingMessage )
 {
     SignalingControllerResult_t ret = SIGNALING_CONTROLLER_RESULT_OK;
-    Base64Result_t base64Result;
-    WssSendMessage_t wssSendMessage;
-    SignalingResult_t signalingResult;
-    NetworkingResult_t networkingResult;
+    SignalingBatchedMessage_t * pHeldMessage;
 
     if( ( pCtx == NULL ) ||
         ( pSignalingMessage == NULL ) ||
@@ -1113,63 +2458,51 @@ SignalingControllerResult_t SignalingController_SendMessage( SignalingController
     {
         pthread_mutex_lock( &( pCtx->signalingTxMutex ) );
         {
-            LogDebug( ( "Sending signaling message(%lu): %.*s",
-                        pSignalingMessage->messageLength,
-                        ( int ) pSignalingMessage->messageLength,
-                        pSignalingMessage->pMessage ) );
-
-            pCtx->signalingIntermediateMessageLength = SIGNALING_CONTROLLER_MESSAGE_BUFFER_LENGTH;
-            base64Result = Base64_Encode( pSignalingMessage->pMessage,
-                                          pSignalingMessage->messageLength,
-                                          &( pCtx->signalingIntermediateMessageBuffer[ 0 ] ),
-                                          &( pCtx->signalingIntermediateMessageLength ) );
-
-            if( base64Result != BASE64_RESULT_OK )
+            if( pCtx->state != SIGNALING_CONTROLLER_STATE_CONNECTED )
             {
-                LogError( ( "Failed to base64 encode signaling message. Result: %d!", base64Result ) );
-                ret = SIGNALING_CONTROLLER_RESULT_FAIL;
-            }
-
+                pHeldMessage = CreateBatchedMessage( pSignalingMessage );
 
-            if( ret == SIGNALING_CONTROLLER_RESULT_OK )
-            {
-                memset( &( wssSendMessage ), 0, sizeof( WssSendMessage_t ) );
-
-                wssSendMessage.messageType = pSignalingMessage->messageType;
-                wssSendMessage.pBase64EncodedMessage = &( pCtx->signalingIntermediateMessageBuffer[ 0 ] );
-                wssSendMessage.base64EncodedMessageLength = pCtx->signalingIntermediateMessageLength;
-                wssSendMessage.pCorrelationId = pSignalingMessage->pCorrelationId;
-                wssSendMessage.correlationIdLength = pSignalingMessage->correlationIdLength;
-                wssSendMessage.pRecipientClientId = pSignalingMessage->pRemoteClientId;
-                wssSendMessage.recipientClientIdLength = pSignalingMessage->remoteClientIdLength;
-
-                pCtx->signalingTxMessageLength = SIGNALING_CONTROLLER_MESSAGE_BUFFER_LENGTH;
-                signalingResult = Signaling_ConstructWssMessage( &( wssSendMessage ),
-                                                                 &( pCtx->signalingTxMessageBuffer[ 0 ] ),
-                                                                 &( pCtx->signalingTxMessageLength ) );
-
-                if( signalingResult != SIGNALING_RESULT_OK )
+                if( pHeldMessage == NULL )
                 {
-                    LogError( ( "Failed to construct signaling Wss message. Result: %d!", signalingResult ) );
                     ret = SIGNALING_CONTROLLER_RESULT_FAIL;
                 }
+                else
+                {
+                    LogDebug( ( "Signaling websocket is down, holding message of type %d.", pSignalingMessage->messageType ) );
+                    HoldMessage( pCtx, pHeldMessage );
+                }
             }
-
-            if( ret == SIGNALING_CONTROLLER_RESULT_OK )
+            else
             {
-                LogVerbose( ( "Constructed signaling WSS message (%lu): \n%.*s",
-                              pCtx->signalingTxMessageLength,
-                              ( int ) pCtx->signalingTxMessageLength,
-                              &( pCtx->signalingTxMessageBuffer[ 0 ] ) ) );
+                /* Messages held after a failed queue go out first. */
+                if( pCtx->pHeldHead != NULL )
+                {
+                    ( void ) SendHeldMessages( pCtx );
+                }
 
-                networkingResult = Networking_WebsocketSend( &( pCtx->websocketContext ),
-                                                             &( pCtx->signalingTxMessageBuffer[ 0 ] ),
-                                                             pCtx->signalingTxMessageLength );
+                if( pCtx->pHeldHead != NULL )
+                {
+                    /* Still can't queue, keep the order behind the held ones. */
+                    pHeldMessage = CreateBatchedMessage( pSignalingMessage );
 
-                if( networkingResult != NETWORKING_RESULT_OK )
+                    if( pHeldMessage == NULL )
+                    {
+                        ret = SIGNALING_CONTROLLER_RESULT_FAIL;
+                    }
+                    else
+                    {
+                        HoldMessage( pCtx, pHeldMessage );
+                    }
+                }
+                else
                 {
-                    LogError( ( "Failed to send signaling Wss message. Result: %d!", networkingResult ) );
-                    ret = SIGNALING_CONTROLLER_RESULT_FAIL;
+                    ret = QueueSignalingMessage( pCtx,
+                                                 pSignalingMessage );
+
+                    if( ret == SIGNALING_CONTROLLER_RESULT_OK )
+                    {
+                        ( void ) Networking_WebsocketFlush( &( pCtx->websocketContext ) );
+                    }
                 }
             }
         }
@@ -1181,11 +2514,82 @@ SignalingControllerResult_t SignalingController_SendMessage( SignalingController
 
 /*----------------------------------------------------------------------------*/
 
+SignalingControllerResult_t SignalingController_SendMessageBatched( SignalingControllerContext_t * pCtx,
+                                                                    const SignalingMessage_t * pSignalingMessage )
+{
+    SignalingControllerResult_t ret = SIGNALING_CONTROLLER_RESULT_OK;
+    SignalingBatchedMessage_t * pBatchedMessage = NULL;
+    uint32_t batchedMessageCount = 0;
+
+    if( ( pCtx == NULL ) ||
+        ( pSignalingMessage == NULL ) ||
+        ( pSignalingMessage->pMessage == NULL ) ||
+        ( pSignalingMessage->pRemoteClientId == NULL ) ||
+        ( pSignalingMessage->correlationIdLength != 0U ) )
+    {
+        ret = SIGNALING_CONTROLLER_RESULT_BAD_PARAM;
+    }
+
+    if( ret == SIGNALING_CONTROLLER_RESULT_OK )
+    {
+        pBatchedMessage = CreateBatchedMessage( pSignalingMessage );
+
+        if( pBatchedMessage == NULL )
+        {
+            ret = SIGNALING_CONTROLLER_RESULT_FAIL;
+        }
+    }
+
+    if( ret == SIGNALING_CONTROLLER_RESULT_OK )
+    {
+        pthread_mutex_lock( &( pCtx->batchMutex ) );
+        {
+            if( pCtx->pBatchTail == NULL )
+            {
+                pCtx->pBatchHead = pBatchedMessage;
+            }
+            else
+            {
+                pCtx->pBatchTail->pNext = pBatchedMessage;
+            }
+            pCtx->pBatchTail = pBatchedMessage;
+            batchedMessageCount = ++pCtx->batchedMessageCount;
+        }
+        pthread_mutex_unlock( &( pCtx->batchMutex ) );
+
+        if( batchedMessageCount >= SIGNALING_CONTROLLER_BATCH_MAX_MESSAGES )
+        {
+            FlushBatchedMessages( pCtx );
+        }
+        else if( batchedMessageCount == 1U )
+        {
+            /* First message of the window arms the timer. */
+            if( TimerController_SetTimer( &( pCtx->batchTimer ),
+                                          SIGNALING_CONTROLLER_BATCH_WINDOW_MS,
+                                          0U ) != TIMER_CONTROLLER_RESULT_OK )
+            {
+                LogWarn( ( "Failed to arm signaling batch timer, flushing now." ) );
+                FlushBatchedMessages( pCtx );
+            }
+        }
+        else
+        {
+            /* Empty else marker. */
+        }
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
 SignalingControllerResult_t SignalingController_QueryIceServerConfigs( SignalingControllerContext_t * pCtx,
                                                                        IceServerConfig_t ** ppIceServerConfigs,
                                                                        size_t * pIceServerConfigsCount )
 {
     SignalingControllerResult_t ret = SIGNALING_CONTROLLER_RESULT_OK;
+    SignalingIceServerConfigs_t * pIceServerConfigs;
+    uint32_t index;
     uint64_t currentTimeSec;
 
     if( ( pCtx == NULL ) ||
@@ -1197,24 +2601,33 @@ SignalingControllerResult_t SignalingController_QueryIceServerConfigs( Signaling
 
     if( ret == SIGNALING_CONTROLLER_RESULT_OK )
     {
+        /* Runs on the SDP offer path, so it must never wait for a fetch. */
+        index = AcquireBuffer( &( pCtx->activeIceServerConfigs ),
+                               &( pCtx->iceServerConfigsReaders[ 0 ] ) );
+        pIceServerConfigs = &( pCtx->iceServerConfigs[ index ] );
         currentTimeSec = NetworkingUtils_GetCurrentTimeSec( NULL );
 
-        if( ( pCtx->iceServerConfigsCount == 0 ) ||
-            ( pCtx->iceServerConfigExpirationSec < currentTimeSec ) )
+        if( ( pIceServerConfigs->iceServerConfigsCount == 0 ) ||
+            ( __atomic_load_n( &( pIceServerConfigs->refreshTimeSec ), __ATOMIC_SEQ_CST ) <= currentTimeSec ) )
         {
-            LogInfo( ( "Ice server configs expired. Refresing Configs." ) );
+            RequestRefresh( pCtx );
+        }
 
-            #if METRIC_PRINT_ENABLED
-            Metric_StartEvent( METRIC_EVENT_SIGNALING_GET_ICE_SERVER_LIST );
-            #endif
-            ret = GetIceServerConfigs( pCtx );
-            #if METRIC_PRINT_ENABLED
-            Metric_EndEvent( METRIC_EVENT_SIGNALING_GET_ICE_SERVER_LIST );
-            #endif
+        if( pIceServerConfigs->iceServerConfigsCount == 0 )
+        {
+            LogWarn( ( "No ICE server configs yet, only the default STUN server is used." ) );
+        }
+        else if( pIceServerConfigs->expirationSec < currentTimeSec )
+        {
+            LogWarn( ( "Ice server configs expired, using them until the refresh completes." ) );
+        }
+        else
+        {
+            /* Empty else marker. */
         }
 
-        *ppIceServerConfigs = pCtx->iceServerConfigs;
-        *pIceServerConfigsCount = pCtx->iceServerConfigsCount;
+        *ppIceServerConfigs = &( pIceServerConfigs->iceServerConfigs[ 0 ] );
+        *pIceServerConfigsCount = pIceServerConfigs->iceServerConfigsCount;
     }
 
     return ret;
@@ -1222,6 +2635,26 @@ SignalingControllerResult_t SignalingController_QueryIceServerConfigs( Signaling
 
 /*----------------------------------------------------------------------------*/
 
+void SignalingController_ReleaseIceServerConfigs( SignalingControllerContext_t * pCtx,
+                                                  IceServerConfig_t * pIceServerConfigs )
+{
+    uint32_t i;
+
+    if( ( pCtx != NULL ) && ( pIceServerConfigs != NULL ) )
+    {
+        for( i = 0; i < 2U; i++ )
+        {
+            if( pIceServerConfigs == &( pCtx->iceServerConfigs[ i ].iceServerConfigs[ 0 ] ) )
+            {
+                ReleaseBuffer( pCtx, &( pCtx->iceServerConfigsReaders[ 0 ] ), i );
+                break;
+            }
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
 SignalingControllerResult_t SignalingController_RefreshIceServerConfigs( SignalingControllerContext_t * pCtx )
 {
     SignalingControllerResult_t ret = SIGNALING_CONTROLLER_RESULT_OK;
@@ -1233,7 +2666,9 @@ SignalingControllerResult_t SignalingController_RefreshIceServerConfigs( Signali
 
     if( ret == SIGNALING_CONTROLLER_RESULT_OK )
     {
+        pthread_mutex_lock( &( pCtx->httpMutex ) );
         ret = GetIceServerConfigs( pCtx );
+        pthread_mutex_unlock( &( pCtx->httpMutex ) );
     }
 
     return ret;
@@ -1388,6 +2823,70 @@ SignalingControllerResult_t SignalingController_DeserializeSdpContentNewline( co
 
 /*----------------------------------------------------------------------------*/
 
+SignalingControllerResult_t SignalingController_DeserializeSdpContentNewlineInPlace( char * pSdpMessage,
+                                                                                     size_t * pSdpMessageLength )
+{
+    SignalingControllerResult_t ret = SIGNALING_CONTROLLER_RESULT_OK;
+    const char * pNext = NULL;
+    size_t readIndex = 0, scanIndex = 0, writeIndex = 0, lineLength = 0;
+
+    if( ( pSdpMessage == NULL ) ||
+        ( pSdpMessageLength == NULL ) ||
+        ( *pSdpMessageLength == 0 ) )
+    {
+        ret = SIGNALING_CONTROLLER_RESULT_BAD_PARAM;
+    }
+
+    if( ret == SIGNALING_CONTROLLER_RESULT_OK )
+    {
+        /* A line loses the "\\n" or "\\r\\n" it ends with and gains "\r\n",
+         * so the write position never passes the read position. */
+        while( ( pNext = memchr( &( pSdpMessage[ scanIndex ] ),
+                                 '\\',
+                                 *pSdpMessageLength - scanIndex ) ) != NULL )
+        {
+            scanIndex = pNext - pSdpMessage + 1;
+
+            if( scanIndex >= *pSdpMessageLength )
+            {
+                break;
+            }
+            else if( pSdpMessage[ scanIndex ] != 'n' )
+            {
+                continue;
+            }
+            else
+            {
+                /* Empty else marker. */
+            }
+
+            lineLength = pNext - &( pSdpMessage[ readIndex ] );
+
+            if( ( lineLength >= 2 ) &&
+                ( pNext[ -2 ] == '\\' ) && ( pNext[ -1 ] == 'r' ) )
+            {
+                lineLength -= 2;
+            }
+
+            memmove( &( pSdpMessage[ writeIndex ] ),
+                     &( pSdpMessage[ readIndex ] ),
+                     lineLength );
+            writeIndex += lineLength;
+            pSdpMessage[ writeIndex++ ] = '\r';
+            pSdpMessage[ writeIndex++ ] = '\n';
+
+            scanIndex++;
+            readIndex = scanIndex;
+        }
+
+        *pSdpMessageLength = writeIndex;
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
 SignalingControllerResult_t SignalingController_SerializeSdpContentNewline( const char * pSdpMessage,
                                                                             size_t sdpMessageLength,
                                                                             char * pEventSdpMessage,
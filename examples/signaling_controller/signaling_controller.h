@@ -21,6 +21,7 @@
 
 #include "signaling_api.h"
 #include "networking.h"
+#include "timer_controller.h"
 
 /* Config parameters. TODO aggarg - need to move to a central config file. */
 #define SIGNALING_CONTROLLER_FETCH_CREDS_GRACE_PERIOD_SEC           ( 30 )
@@ -28,6 +29,7 @@
 #define SIGNALING_CONTROLLER_HTTP_BODY_BUFFER_LENGTH                ( 10 * 1024 )
 #define SIGNALING_CONTROLLER_HTTP_RESPONSE_BUFFER_LENGTH            ( 10 * 1024 )
 #define SIGNALING_CONTROLLER_MESSAGE_BUFFER_LENGTH                  ( 10 * 1024 )
+#define SIGNALING_CONTROLLER_MESSAGE_ENVELOPE_LENGTH                ( 256 )
 #define SIGNALING_CONTROLLER_HTTP_NUM_RETRIES                       ( 5U )
 #define SIGNALING_CONTROLLER_ARN_BUFFER_LENGTH                      ( 128 )
 #define SIGNALING_CONTROLLER_ENDPOINT_BUFFER_LENGTH                 ( 128 )
@@ -38,6 +40,37 @@
 #define SIGNALING_CONTROLLER_ICE_SERVER_MAX_CONFIG_COUNT            ( 5 )
 #define SIGNALING_CONTROLLER_ICE_CONFIG_REFRESH_GRACE_PERIOD_SEC    ( 30 )
 
+/* Credentials and ICE server configs are refreshed in the background at this
+ * percentage of their lifetime, minus up to SIGNALING_CONTROLLER_REFRESH_JITTER_PERCENT
+ * so devices started together don't refresh together. */
+#define SIGNALING_CONTROLLER_REFRESH_LIFETIME_PERCENT               ( 80 )
+#define SIGNALING_CONTROLLER_REFRESH_JITTER_PERCENT                 ( 10 )
+#define SIGNALING_CONTROLLER_REFRESH_RETRY_SEC                      ( 5 )
+
+/* A refresh gives up if the readers of the buffer it fills don't finish in time. */
+#define SIGNALING_CONTROLLER_BUFFER_WAIT_TIMEOUT_MS                 ( 5000 )
+
+/* Messages queued by SignalingController_SendMessageBatched within this window are sent together. */
+#ifndef SIGNALING_CONTROLLER_BATCH_WINDOW_MS
+#define SIGNALING_CONTROLLER_BATCH_WINDOW_MS                        ( 5 )
+#endif
+
+/* The batch is flushed early by the caller once it holds this many messages. */
+#define SIGNALING_CONTROLLER_BATCH_MAX_MESSAGES                     ( 64 )
+
+/* Reconnects back off exponentially from the base delay up to the max delay,
+ * each delay is picked at random in its upper half so devices dropped together
+ * don't reconnect together. The first attempt after a drop is immediate, the
+ * backoff only starts over once a connection stays up for the min uptime, so
+ * a connection dropped right after connecting keeps backing off. */
+#define SIGNALING_CONTROLLER_RECONNECT_BASE_DELAY_MS                ( 250 )
+#define SIGNALING_CONTROLLER_RECONNECT_MAX_DELAY_MS                 ( 30000 )
+#define SIGNALING_CONTROLLER_RECONNECT_MIN_UPTIME_MS                ( 10000 )
+
+/* Messages sent while the websocket is down are held, up to this count, and
+ * sent in order once it is back. */
+#define SIGNALING_CONTROLLER_MAX_HELD_MESSAGES                      ( 256 )
+
 /*----------------------------------------------------------------------------*/
 
 typedef enum SignalingControllerResult
@@ -45,8 +78,17 @@ typedef enum SignalingControllerResult
     SIGNALING_CONTROLLER_RESULT_OK = 0,
     SIGNALING_CONTROLLER_RESULT_BAD_PARAM,
     SIGNALING_CONTROLLER_RESULT_FAIL,
+    SIGNALING_CONTROLLER_RESULT_BUFFER_BUSY,
 } SignalingControllerResult_t;
 
+typedef enum SignalingControllerState
+{
+    SIGNALING_CONTROLLER_STATE_DISCONNECTED = 0,
+    SIGNALING_CONTROLLER_STATE_CONNECTING,
+    SIGNALING_CONTROLLER_STATE_CONNECTED,
+    SIGNALING_CONTROLLER_STATE_BACKOFF,
+} SignalingControllerState_t;
+
 typedef struct SignalingMessage
 {
     const char * pRemoteClientId;
@@ -58,6 +100,19 @@ typedef struct SignalingMessage
     size_t correlationIdLength;
 } SignalingMessage_t;
 
+typedef struct SignalingBatchedMessage
+{
+    struct SignalingBatchedMessage * pNext;
+    SignalingTypeMessage_t messageType;
+    size_t remoteClientIdLength;
+    size_t correlationIdLength;
+    size_t messageLength;
+    /* Remote client ID, correlation ID and the message. */
+    char data[];
+} SignalingBatchedMessage_t;
+
+/* Called in the listening thread. The message is decoded in place in the
+ * websocket receive buffer, so it's only valid during the call. */
 typedef int ( * SignalingMessageReceivedCallback_t )( SignalingMessage_t * pSignalingMessage,
                                                       void * pUserData );
 
@@ -84,6 +139,15 @@ typedef struct SignalingControllerConnectInfo
 
     /* Configurations. */
     uint8_t enableStorageSession;
+
+    /* Where the channel ARN, endpoints and ICE server configs are cached across
+     * restarts, NULL to always fetch them. */
+    const char * pCacheFilePath;
+
+    /* Optional, replaces the control plane endpoint of the region, e.g. a
+     * local mock signaling server like https://127.0.0.1:8443. */
+    const char * pControlPlaneEndpoint;
+    size_t controlPlaneEndpointLength;
 } SignalingControllerConnectInfo_t;
 
 typedef struct IceServerUri
@@ -103,7 +167,7 @@ typedef struct IceServerConfig
     size_t passwordLength;
 } IceServerConfig_t;
 
-typedef struct SignalingControllerContext
+typedef struct SignalingCredentials
 {
     char accessKeyId[ ACCESS_KEY_MAX_LEN + 1 ];
     size_t accessKeyIdLength;
@@ -112,6 +176,31 @@ typedef struct SignalingControllerContext
     char sessionToken[ SESSION_TOKEN_MAX_LEN + 1 ];
     size_t sessionTokenLength;
     uint64_t expirationSeconds;
+    /* 0 if the credentials are not refreshed, i.e. supplied by the application. */
+    uint64_t refreshTimeSeconds;
+} SignalingCredentials_t;
+
+typedef struct SignalingIceServerConfigs
+{
+    IceServerConfig_t iceServerConfigs[ SIGNALING_CONTROLLER_ICE_SERVER_MAX_CONFIG_COUNT ];
+    size_t iceServerConfigsCount;
+    uint64_t expirationSec;
+    uint64_t refreshTimeSec;
+} SignalingIceServerConfigs_t;
+
+typedef struct SignalingControllerContext
+{
+    /* The credentials and ICE server configs are double buffered so readers
+     * never wait for a refresh. There is one writer at a time, with httpMutex
+     * held. It fills the inactive buffer once its readers are gone and then
+     * publishes it by switching the active index. */
+    SignalingCredentials_t credentials[ 2 ];
+    uint32_t credentialsReaders[ 2 ];
+    uint32_t activeCredentials;
+
+    /* Signalled by the last reader of a buffer, the writer waits on it. */
+    pthread_mutex_t bufferMutex;
+    pthread_cond_t bufferCond;
 
     char signalingChannelArn[ SIGNALING_CONTROLLER_ARN_BUFFER_LENGTH + 1 ];
     size_t signalingChannelArnLength;
@@ -123,9 +212,9 @@ typedef struct SignalingControllerContext
     char webrtcEndpoint[ SIGNALING_CONTROLLER_ENDPOINT_BUFFER_LENGTH + 1 ];
     size_t webrtcEndpointLength;
 
-    uint64_t iceServerConfigExpirationSec;
-    size_t iceServerConfigsCount;
-    IceServerConfig_t iceServerConfigs[ SIGNALING_CONTROLLER_ICE_SERVER_MAX_CONFIG_COUNT ];
+    SignalingIceServerConfigs_t iceServerConfigs[ 2 ];
+    uint32_t iceServerConfigsReaders[ 2 ];
+    uint32_t activeIceServerConfigs;
 
     const char * pUserAgentName;
     size_t userAgentNameLength;
@@ -133,18 +222,75 @@ typedef struct SignalingControllerContext
     AwsConfig_t awsConfig;
 
     char httpUrlBuffer[ SIGNALING_CONTROLLER_HTTP_URL_BUFFER_LENGTH ];
+    /* Separate from httpUrlBuffer as the bootstrap task sends HTTP requests
+     * during the websocket handshake. */
+    char wssUrlBuffer[ SIGNALING_CONTROLLER_HTTP_URL_BUFFER_LENGTH ];
+    size_t wssUrlLength;
     char httpBodyBuffer[ SIGNALING_CONTROLLER_HTTP_BODY_BUFFER_LENGTH ];
     char httpResponserBuffer[ SIGNALING_CONTROLLER_HTTP_RESPONSE_BUFFER_LENGTH ];
-    char signalingRxMessageBuffer[ SIGNALING_CONTROLLER_MESSAGE_BUFFER_LENGTH ];
-    size_t signalingRxMessageLength;
-    char signalingTxMessageBuffer[ SIGNALING_CONTROLLER_MESSAGE_BUFFER_LENGTH ];
+    /* Allocated on the first send and grown with the largest message, with
+     * signalingTxMutex held. */
+    char * pSignalingTxMessageBuffer;
+    size_t signalingTxMessageBufferSize;
     size_t signalingTxMessageLength;
-    char signalingIntermediateMessageBuffer[ SIGNALING_CONTROLLER_MESSAGE_BUFFER_LENGTH ];
+    char * pSignalingIntermediateMessageBuffer;
+    size_t signalingIntermediateMessageBufferSize;
     size_t signalingIntermediateMessageLength;
 
     /* Serialize access to SignalingController_SendMessage. */
     pthread_mutex_t signalingTxMutex;
 
+    /* Written by the listening thread with signalingTxMutex held. Peer
+     * connections never depend on it, a reconnect only delays their
+     * signaling messages. */
+    SignalingControllerState_t state;
+    uint32_t connectAttempts;
+    uint32_t reconnectCount;
+    uint64_t disconnectTimeUs;
+    uint64_t connectedTimeUs;
+
+    /* Credential refreshes requested from the refresh task while connected,
+     * retried with the reconnect backoff without dropping the websocket. */
+    uint32_t credentialRefreshAttempts;
+    uint64_t credentialRefreshRetryTimeUs;
+
+    /* The channel ARN and endpoints of the last connection are reused on
+     * reconnect, until a connect with them fails. */
+    uint8_t isChannelResolved;
+
+    /* Messages sent while the websocket is down, with signalingTxMutex held. */
+    SignalingBatchedMessage_t * pHeldHead;
+    SignalingBatchedMessage_t * pHeldTail;
+    uint32_t heldMessageCount;
+    uint32_t droppedMessageCount;
+
+    /* Serialize HTTP requests, the HTTP context and buffers are shared by the
+     * listening thread and the callers of the ICE server config APIs. */
+    pthread_mutex_t httpMutex;
+
+    /* Fetches the ICE server configs while the websocket connects and
+     * validates the cached channel ARN and endpoints. */
+    pthread_t bootstrapTask;
+    uint8_t isBootstrapTaskStarted;
+    uint8_t isBootstrappedFromCache;
+    uint8_t isBootstrapValidated;
+    const SignalingControllerConnectInfo_t * pConnectInfo;
+
+    /* Refreshes the credentials and ICE server configs ahead of expiry. */
+    pthread_t refreshTask;
+    uint8_t isRefreshTaskStarted;
+    uint8_t isRefreshRequested;
+    uint8_t isCredentialRefreshRequested;
+    pthread_mutex_t refreshMutex;
+    pthread_cond_t refreshCond;
+
+    /* Messages waiting for the batch window to expire. */
+    pthread_mutex_t batchMutex;
+    SignalingBatchedMessage_t * pBatchHead;
+    SignalingBatchedMessage_t * pBatchTail;
+    uint32_t batchedMessageCount;
+    TimerHandler_t batchTimer;
+
     SignalingMessageReceivedCallback_t messageReceivedCallback;
     void * pMessageReceivedCallbackData;
 
@@ -157,17 +303,31 @@ typedef struct SignalingControllerContext
 SignalingControllerResult_t SignalingController_Init( SignalingControllerContext_t * pCtx,
                                                       const SSLCredentials_t * pSslCreds );
 
-/* Start listening for incoming SDP offers. */
+/* Start listening for incoming SDP offers. Never returns on success, the
+ * websocket is reconnected with backoff whenever it drops. */
 SignalingControllerResult_t SignalingController_StartListening( SignalingControllerContext_t * pCtx,
                                                                 const SignalingControllerConnectInfo_t * pConnectInfo );
 
+/* Send the message, or hold it until the websocket is reconnected. */
 SignalingControllerResult_t SignalingController_SendMessage( SignalingControllerContext_t * pCtx,
                                                              const SignalingMessage_t * pSignalingMessage );
 
+/* Copy the message and send it with the others queued in the same batch window,
+ * grouped by remote client. Meant for bursts like trickle ICE candidates, it
+ * never waits for the Tx path. Correlation IDs are not supported. */
+SignalingControllerResult_t SignalingController_SendMessageBatched( SignalingControllerContext_t * pCtx,
+                                                                    const SignalingMessage_t * pSignalingMessage );
+
+/* Get the current ICE server configs without any network I/O, a refresh is
+ * requested in the background if they are due. The configs stay valid until
+ * SignalingController_ReleaseIceServerConfigs is called. */
 SignalingControllerResult_t SignalingController_QueryIceServerConfigs( SignalingControllerContext_t * pCtx,
                                                                        IceServerConfig_t ** ppIceServerConfigs,
                                                                        size_t * pIceServerConfigsCount );
 
+void SignalingController_ReleaseIceServerConfigs( SignalingControllerContext_t * pCtx,
+                                                  IceServerConfig_t * pIceServerConfigs );
+
 SignalingControllerResult_t SignalingController_RefreshIceServerConfigs( SignalingControllerContext_t * pCtx );
 
 SignalingControllerResult_t SignalingController_ExtractSdpOfferFromSignalingMessage( const char * pSignalingMessage,
@@ -180,6 +340,11 @@ SignalingControllerResult_t SignalingController_DeserializeSdpContentNewline( co
                                                                               char * pFormalSdpMessage,
                                                                               size_t * pFormalSdpMessageLength );
 
+/* Same as SignalingController_DeserializeSdpContentNewline, but rewrites the
+ * SDP where it is, the formal SDP is never longer than the escaped one. */
+SignalingControllerResult_t SignalingController_DeserializeSdpContentNewlineInPlace( char * pSdpMessage,
+                                                                                     size_t * pSdpMessageLength );
+
 SignalingControllerResult_t SignalingController_SerializeSdpContentNewline( const char * pSdpMessage,
                                                                             size_t sdpMessageLength,
                                                                             char * pEventSdpMessage,
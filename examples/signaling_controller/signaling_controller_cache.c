@@ -0,0 +1,539 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "logging.h"
+#include "networking_utils.h"
+#include "signaling_controller_cache.h"
+
+/*----------------------------------------------------------------------------*/
+
+/*
+ * The cache is a text file with one key=value per line, the value runs up to
+ * the end of the line. Each iceServer line starts a new ICE server config and
+ * the iceServer* lines after it belong to that config:
+ *
+ * version=1
+ * region=us-west-2
+ * channelName=demo-channel
+ * updateTimeSec=1700000000
+ * channelArn=arn:aws:kinesisvideo:...
+ * httpsEndpoint=https://...
+ * wssEndpoint=wss://...
+ * webrtcEndpoint=
+ * iceServerConfigExpirationSec=1700000270
+ * iceServerConfigRefreshSec=1700000229
+ * iceServer=300
+ * iceServerUserName=...
+ * iceServerPassword=...
+ * iceServerUri=turn:...
+ */
+#define SIGNALING_CONTROLLER_CACHE_KEY_VERSION              "version"
+#define SIGNALING_CONTROLLER_CACHE_KEY_REGION               "region"
+#define SIGNALING_CONTROLLER_CACHE_KEY_CHANNEL_NAME         "channelName"
+#define SIGNALING_CONTROLLER_CACHE_KEY_UPDATE_TIME          "updateTimeSec"
+#define SIGNALING_CONTROLLER_CACHE_KEY_CHANNEL_ARN          "channelArn"
+#define SIGNALING_CONTROLLER_CACHE_KEY_HTTPS_ENDPOINT       "httpsEndpoint"
+#define SIGNALING_CONTROLLER_CACHE_KEY_WSS_ENDPOINT         "wssEndpoint"
+#define SIGNALING_CONTROLLER_CACHE_KEY_WEBRTC_ENDPOINT      "webrtcEndpoint"
+#define SIGNALING_CONTROLLER_CACHE_KEY_ICE_EXPIRATION       "iceServerConfigExpirationSec"
+#define SIGNALING_CONTROLLER_CACHE_KEY_ICE_REFRESH          "iceServerConfigRefreshSec"
+#define SIGNALING_CONTROLLER_CACHE_KEY_ICE_SERVER           "iceServer"
+#define SIGNALING_CONTROLLER_CACHE_KEY_ICE_USER_NAME        "iceServerUserName"
+#define SIGNALING_CONTROLLER_CACHE_KEY_ICE_PASSWORD         "iceServerPassword"
+#define SIGNALING_CONTROLLER_CACHE_KEY_ICE_URI              "iceServerUri"
+
+/*----------------------------------------------------------------------------*/
+
+static SignalingControllerResult_t CopyValue( char * pDst,
+                                              size_t dstBufferLength,
+                                              size_t * pDstLength,
+                                              const char * pValue,
+                                              size_t valueLength );
+
+static uint8_t IsValueEqual( const char * pValue,
+                             size_t valueLength,
+                             const char * pExpected,
+                             size_t expectedLength );
+
+static SignalingControllerResult_t ParseLine( SignalingControllerContext_t * pCtx,
+                                              const SignalingControllerConnectInfo_t * pConnectInfo,
+                                              SignalingIceServerConfigs_t * pIceServerConfigs,
+                                              const char * pKey,
+                                              const char * pValue,
+                                              size_t valueLength,
+                                              uint64_t * pUpdateTimeSec,
+                                              uint8_t * pIsHeaderMatched );
+
+static void ResetCachedFields( SignalingControllerContext_t * pCtx,
+                               SignalingIceServerConfigs_t * pIceServerConfigs );
+
+/*----------------------------------------------------------------------------*/
+
+static SignalingControllerResult_t CopyValue( char * pDst,
+                                              size_t dstBufferLength,
+                                              size_t * pDstLength,
+                                              const char * pValue,
+                                              size_t valueLength )
+{
+    SignalingControllerResult_t ret = SIGNALING_CONTROLLER_RESULT_OK;
+
+    /* The destination buffers are one byte longer for the NULL terminator. */
+    if( valueLength > dstBufferLength )
+    {
+        ret = SIGNALING_CONTROLLER_RESULT_FAIL;
+    }
+    else
+    {
+        memcpy( pDst, pValue, valueLength );
+        pDst[ valueLength ] = '\0';
+        *pDstLength = valueLength;
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static uint8_t IsValueEqual( const char * pValue,
+                             size_t valueLength,
+                             const char * pExpected,
+                             size_t expectedLength )
+{
+    return ( ( valueLength == expectedLength ) &&
+             ( memcmp( pValue, pExpected, valueLength ) == 0 ) ) ? 1U : 0U;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static SignalingControllerResult_t ParseLine( SignalingControllerContext_t * pCtx,
+                                              const SignalingControllerConnectInfo_t * pConnectInfo,
+                                              SignalingIceServerConfigs_t * pIceServerConfigs,
+                                              const char * pKey,
+                                              const char * pValue,
+                                              size_t valueLength,
+                                              uint64_t * pUpdateTimeSec,
+                                              uint8_t * pIsHeaderMatched )
+{
+    SignalingControllerResult_t ret = SIGNALING_CONTROLLER_RESULT_OK;
+    IceServerConfig_t * pIceServerConfig = NULL;
+    size_t unusedLength;
+
+    if( pIceServerConfigs->iceServerConfigsCount > 0 )
+    {
+        pIceServerConfig = &( pIceServerConfigs->iceServerConfigs[ pIceServerConfigs->iceServerConfigsCount - 1 ] );
+    }
+
+    if( strcmp( pKey, SIGNALING_CONTROLLER_CACHE_KEY_VERSION ) == 0 )
+    {
+        if( strtoul( pValue, NULL, 10 ) != SIGNALING_CONTROLLER_CACHE_VERSION )
+        {
+            LogInfo( ( "Ignoring signaling cache with version %.*s.", ( int ) valueLength, pValue ) );
+            ret = SIGNALING_CONTROLLER_RESULT_FAIL;
+        }
+        else
+        {
+            *pIsHeaderMatched = 1U;
+        }
+    }
+    else if( *pIsHeaderMatched == 0U )
+    {
+        /* The version must come first. */
+        ret = SIGNALING_CONTROLLER_RESULT_FAIL;
+    }
+    else if( strcmp( pKey, SIGNALING_CONTROLLER_CACHE_KEY_REGION ) == 0 )
+    {
+        if( IsValueEqual( pValue, valueLength,
+                          pConnectInfo->awsConfig.pRegion, pConnectInfo->awsConfig.regionLen ) == 0U )
+        {
+            LogInfo( ( "Ignoring signaling cache of region %.*s.", ( int ) valueLength, pValue ) );
+            ret = SIGNALING_CONTROLLER_RESULT_FAIL;
+        }
+    }
+    else if( strcmp( pKey, SIGNALING_CONTROLLER_CACHE_KEY_CHANNEL_NAME ) == 0 )
+    {
+        if( IsValueEqual( pValue, valueLength,
+                          pConnectInfo->channelName.pChannelName, pConnectInfo->channelName.channelNameLength ) == 0U )
+        {
+            LogInfo( ( "Ignoring signaling cache of channel %.*s.", ( int ) valueLength, pValue ) );
+            ret = SIGNALING_CONTROLLER_RESULT_FAIL;
+        }
+    }
+    else if( strcmp( pKey, SIGNALING_CONTROLLER_CACHE_KEY_UPDATE_TIME ) == 0 )
+    {
+        *pUpdateTimeSec = strtoull( pValue, NULL, 10 );
+    }
+    else if( strcmp( pKey, SIGNALING_CONTROLLER_CACHE_KEY_CHANNEL_ARN ) == 0 )
+    {
+        ret = CopyValue( &( pCtx->signalingChannelArn[ 0 ] ), SIGNALING_CONTROLLER_ARN_BUFFER_LENGTH,
+                         &( pCtx->signalingChannelArnLength ), pValue, valueLength );
+    }
+    else if( strcmp( pKey, SIGNALING_CONTROLLER_CACHE_KEY_HTTPS_ENDPOINT ) == 0 )
+    {
+        ret = CopyValue( &( pCtx->httpsEndpoint[ 0 ] ), SIGNALING_CONTROLLER_ENDPOINT_BUFFER_LENGTH,
+                         &( pCtx->httpsEndpointLength ), pValue, valueLength );
+    }
+    else if( strcmp( pKey, SIGNALING_CONTROLLER_CACHE_KEY_WSS_ENDPOINT ) == 0 )
+    {
+        ret = CopyValue( &( pCtx->wssEndpoint[ 0 ] ), SIGNALING_CONTROLLER_ENDPOINT_BUFFER_LENGTH,
+                         &( pCtx->wssEndpointLength ), pValue, valueLength );
+    }
+    else if( strcmp( pKey, SIGNALING_CONTROLLER_CACHE_KEY_WEBRTC_ENDPOINT ) == 0 )
+    {
+        ret = CopyValue( &( pCtx->webrtcEndpoint[ 0 ] ), SIGNALING_CONTROLLER_ENDPOINT_BUFFER_LENGTH,
+                         &( pCtx->webrtcEndpointLength ), pValue, valueLength );
+    }
+    else if( strcmp( pKey, SIGNALING_CONTROLLER_CACHE_KEY_ICE_EXPIRATION ) == 0 )
+    {
+        pIceServerConfigs->expirationSec = strtoull( pValue, NULL, 10 );
+    }
+    else if( strcmp( pKey, SIGNALING_CONTROLLER_CACHE_KEY_ICE_REFRESH ) == 0 )
+    {
+        pIceServerConfigs->refreshTimeSec = strtoull( pValue, NULL, 10 );
+    }
+    else if( strcmp( pKey, SIGNALING_CONTROLLER_CACHE_KEY_ICE_SERVER ) == 0 )
+    {
+        if( pIceServerConfigs->iceServerConfigsCount >= SIGNALING_CONTROLLER_ICE_SERVER_MAX_CONFIG_COUNT )
+        {
+            ret = SIGNALING_CONTROLLER_RESULT_FAIL;
+        }
+        else
+        {
+            pIceServerConfig = &( pIceServerConfigs->iceServerConfigs[ pIceServerConfigs->iceServerConfigsCount ] );
+            memset( pIceServerConfig, 0, sizeof( IceServerConfig_t ) );
+            pIceServerConfig->ttlSeconds = ( uint32_t ) strtoul( pValue, NULL, 10 );
+            pIceServerConfigs->iceServerConfigsCount++;
+        }
+    }
+    else if( pIceServerConfig == NULL )
+    {
+        /* ICE server fields before the first iceServer line. */
+        ret = SIGNALING_CONTROLLER_RESULT_FAIL;
+    }
+    else if( strcmp( pKey, SIGNALING_CONTROLLER_CACHE_KEY_ICE_USER_NAME ) == 0 )
+    {
+        ret = CopyValue( &( pIceServerConfig->userName[ 0 ] ), SIGNALING_CONTROLLER_ICE_SERVER_USER_NAME_BUFFER_LENGTH,
+                         &( pIceServerConfig->userNameLength ), pValue, valueLength );
+    }
+    else if( strcmp( pKey, SIGNALING_CONTROLLER_CACHE_KEY_ICE_PASSWORD ) == 0 )
+    {
+        ret = CopyValue( &( pIceServerConfig->password[ 0 ] ), SIGNALING_CONTROLLER_ICE_SERVER_PASSWORD_BUFFER_LENGTH,
+                         &( pIceServerConfig->passwordLength ), pValue, valueLength );
+    }
+    else if( strcmp( pKey, SIGNALING_CONTROLLER_CACHE_KEY_ICE_URI ) == 0 )
+    {
+        if( pIceServerConfig->iceServerUriCount >= SIGNALING_CONTROLLER_ICE_SERVER_MAX_URIS_COUNT )
+        {
+            ret = SIGNALING_CONTROLLER_RESULT_FAIL;
+        }
+        else
+        {
+            ret = CopyValue( &( pIceServerConfig->iceServerUris[ pIceServerConfig->iceServerUriCount ].uri[ 0 ] ),
+                             SIGNALING_CONTROLLER_ICE_SERVER_URI_BUFFER_LENGTH,
+                             &( unusedLength ), pValue, valueLength );
+
+            if( ret == SIGNALING_CONTROLLER_RESULT_OK )
+            {
+                pIceServerConfig->iceServerUris[ pIceServerConfig->iceServerUriCount ].uriLength = valueLength;
+                pIceServerConfig->iceServerUriCount++;
+            }
+        }
+    }
+    else
+    {
+        LogWarn( ( "Unknown signaling cache key: %s", pKey ) );
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static void ResetCachedFields( SignalingControllerContext_t * pCtx,
+                               SignalingIceServerConfigs_t * pIceServerConfigs )
+{
+    pCtx->signalingChannelArnLength = 0;
+    pCtx->signalingChannelArn[ 0 ] = '\0';
+    pCtx->httpsEndpointLength = 0;
+    pCtx->httpsEndpoint[ 0 ] = '\0';
+    pCtx->wssEndpointLength = 0;
+    pCtx->wssEndpoint[ 0 ] = '\0';
+    pCtx->webrtcEndpointLength = 0;
+    pCtx->webrtcEndpoint[ 0 ] = '\0';
+    pIceServerConfigs->iceServerConfigsCount = 0;
+    pIceServerConfigs->expirationSec = 0;
+    pIceServerConfigs->refreshTimeSec = 0;
+}
+
+/*----------------------------------------------------------------------------*/
+
+SignalingControllerResult_t SignalingControllerCache_Load( SignalingControllerContext_t * pCtx,
+                                                           const SignalingControllerConnectInfo_t * pConnectInfo,
+                                                           SignalingIceServerConfigs_t * pIceServerConfigs )
+{
+    SignalingControllerResult_t ret = SIGNALING_CONTROLLER_RESULT_OK;
+    FILE * pFile = NULL;
+    char line[ SIGNALING_CONTROLLER_CACHE_LINE_MAX_LENGTH ];
+    char * pSeparator;
+    size_t lineLength;
+    uint64_t updateTimeSec = 0;
+    uint64_t currentTimeSec = 0;
+    uint8_t isHeaderMatched = 0U;
+
+    if( ( pCtx == NULL ) || ( pConnectInfo == NULL ) ||
+        ( pIceServerConfigs == NULL ) || ( pConnectInfo->pCacheFilePath == NULL ) )
+    {
+        ret = SIGNALING_CONTROLLER_RESULT_BAD_PARAM;
+    }
+
+    if( ret == SIGNALING_CONTROLLER_RESULT_OK )
+    {
+        pFile = fopen( pConnectInfo->pCacheFilePath, "r" );
+
+        if( pFile == NULL )
+        {
+            LogDebug( ( "No signaling cache at %s", pConnectInfo->pCacheFilePath ) );
+            ret = SIGNALING_CONTROLLER_RESULT_FAIL;
+        }
+    }
+
+    if( ret == SIGNALING_CONTROLLER_RESULT_OK )
+    {
+        ResetCachedFields( pCtx, pIceServerConfigs );
+
+        while( ( ret == SIGNALING_CONTROLLER_RESULT_OK ) &&
+               ( fgets( line, sizeof( line ), pFile ) != NULL ) )
+        {
+            lineLength = strlen( line );
+
+            if( ( lineLength == 0 ) || ( line[ lineLength - 1 ] != '\n' ) )
+            {
+                LogWarn( ( "Signaling cache line is truncated or too long." ) );
+                ret = SIGNALING_CONTROLLER_RESULT_FAIL;
+            }
+            else
+            {
+                line[ --lineLength ] = '\0';
+                pSeparator = strchr( line, '=' );
+
+                if( pSeparator == NULL )
+                {
+                    LogWarn( ( "Malformed signaling cache line: %s", line ) );
+                    ret = SIGNALING_CONTROLLER_RESULT_FAIL;
+                }
+                else
+                {
+                    *pSeparator = '\0';
+                    ret = ParseLine( pCtx, pConnectInfo, pIceServerConfigs,
+                                     line,
+                                     pSeparator + 1,
+                                     lineLength - ( size_t )( pSeparator + 1 - line ),
+                                     &( updateTimeSec ),
+                                     &( isHeaderMatched ) );
+                }
+            }
+        }
+
+        fclose( pFile );
+    }
+
+    if( ret == SIGNALING_CONTROLLER_RESULT_OK )
+    {
+        currentTimeSec = NetworkingUtils_GetCurrentTimeSec( NULL );
+
+        if( ( isHeaderMatched == 0U ) ||
+            ( pCtx->signalingChannelArnLength == 0 ) ||
+            ( pCtx->httpsEndpointLength == 0 ) ||
+            ( pCtx->wssEndpointLength == 0 ) ||
+            ( ( pConnectInfo->enableStorageSession != 0 ) && ( pCtx->webrtcEndpointLength == 0 ) ) )
+        {
+            LogInfo( ( "Signaling cache is incomplete." ) );
+            ret = SIGNALING_CONTROLLER_RESULT_FAIL;
+        }
+        else if( ( updateTimeSec > currentTimeSec ) ||
+                 ( currentTimeSec - updateTimeSec > SIGNALING_CONTROLLER_CACHE_MAX_AGE_SEC ) )
+        {
+            LogInfo( ( "Signaling cache is too old, updated at %" PRIu64 ".", updateTimeSec ) );
+            ret = SIGNALING_CONTROLLER_RESULT_FAIL;
+        }
+        else
+        {
+            /* Empty else marker. */
+        }
+    }
+
+    if( ret == SIGNALING_CONTROLLER_RESULT_OK )
+    {
+        if( pIceServerConfigs->expirationSec <= currentTimeSec )
+        {
+            LogDebug( ( "Cached ICE server configs have expired." ) );
+            pIceServerConfigs->iceServerConfigsCount = 0;
+            pIceServerConfigs->expirationSec = 0;
+            pIceServerConfigs->refreshTimeSec = 0;
+        }
+
+        LogInfo( ( "Loaded signaling cache of channel %.*s, %lu ICE server configs.",
+                   ( int ) pConnectInfo->channelName.channelNameLength,
+                   pConnectInfo->channelName.pChannelName,
+                   pIceServerConfigs->iceServerConfigsCount ) );
+    }
+    else if( ( ret == SIGNALING_CONTROLLER_RESULT_FAIL ) && ( pFile != NULL ) )
+    {
+        ResetCachedFields( pCtx, pIceServerConfigs );
+    }
+    else
+    {
+        /* Empty else marker. */
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+SignalingControllerResult_t SignalingControllerCache_Store( SignalingControllerContext_t * pCtx,
+                                                            const SignalingControllerConnectInfo_t * pConnectInfo,
+                                                            const SignalingIceServerConfigs_t * pIceServerConfigs )
+{
+    SignalingControllerResult_t ret = SIGNALING_CONTROLLER_RESULT_OK;
+    char tempPath[ SIGNALING_CONTROLLER_CACHE_PATH_MAX_LENGTH ];
+    FILE * pFile = NULL;
+    int fd = -1;
+    int written;
+    size_t i, j;
+
+    if( ( pCtx == NULL ) || ( pConnectInfo == NULL ) ||
+        ( pIceServerConfigs == NULL ) || ( pConnectInfo->pCacheFilePath == NULL ) )
+    {
+        ret = SIGNALING_CONTROLLER_RESULT_BAD_PARAM;
+    }
+
+    if( ret == SIGNALING_CONTROLLER_RESULT_OK )
+    {
+        written = snprintf( tempPath, sizeof( tempPath ), "%s.tmp", pConnectInfo->pCacheFilePath );
+
+        if( ( written < 0 ) || ( ( size_t ) written >= sizeof( tempPath ) ) )
+        {
+            LogError( ( "Signaling cache path is too long: %s", pConnectInfo->pCacheFilePath ) );
+            ret = SIGNALING_CONTROLLER_RESULT_FAIL;
+        }
+    }
+
+    if( ret == SIGNALING_CONTROLLER_RESULT_OK )
+    {
+        /* The TURN credentials must not be readable by others. The mode only
+         * applies on creation, so a left over temp file is restricted too. */
+        fd = open( tempPath,
+                   O_WRONLY | O_CREAT | O_TRUNC,
+                   S_IRUSR | S_IWUSR );
+        if( ( fd >= 0 ) && ( fchmod( fd, S_IRUSR | S_IWUSR ) == 0 ) )
+        {
+            pFile = fdopen( fd, "w" );
+        }
+
+        if( pFile == NULL )
+        {
+            LogError( ( "Fail to open signaling cache file: %s", tempPath ) );
+            ret = SIGNALING_CONTROLLER_RESULT_FAIL;
+
+            if( fd >= 0 )
+            {
+                close( fd );
+            }
+        }
+    }
+
+    if( ret == SIGNALING_CONTROLLER_RESULT_OK )
+    {
+        fprintf( pFile, SIGNALING_CONTROLLER_CACHE_KEY_VERSION "=%d\n", SIGNALING_CONTROLLER_CACHE_VERSION );
+        fprintf( pFile, SIGNALING_CONTROLLER_CACHE_KEY_REGION "=%.*s\n",
+                 ( int ) pConnectInfo->awsConfig.regionLen, pConnectInfo->awsConfig.pRegion );
+        fprintf( pFile, SIGNALING_CONTROLLER_CACHE_KEY_CHANNEL_NAME "=%.*s\n",
+                 ( int ) pConnectInfo->channelName.channelNameLength, pConnectInfo->channelName.pChannelName );
+        fprintf( pFile, SIGNALING_CONTROLLER_CACHE_KEY_UPDATE_TIME "=%" PRIu64 "\n",
+                 NetworkingUtils_GetCurrentTimeSec( NULL ) );
+        fprintf( pFile, SIGNALING_CONTROLLER_CACHE_KEY_CHANNEL_ARN "=%s\n", &( pCtx->signalingChannelArn[ 0 ] ) );
+        fprintf( pFile, SIGNALING_CONTROLLER_CACHE_KEY_HTTPS_ENDPOINT "=%s\n", &( pCtx->httpsEndpoint[ 0 ] ) );
+        fprintf( pFile, SIGNALING_CONTROLLER_CACHE_KEY_WSS_ENDPOINT "=%s\n", &( pCtx->wssEndpoint[ 0 ] ) );
+        fprintf( pFile, SIGNALING_CONTROLLER_CACHE_KEY_WEBRTC_ENDPOINT "=%.*s\n",
+                 ( int ) pCtx->webrtcEndpointLength, &( pCtx->webrtcEndpoint[ 0 ] ) );
+        fprintf( pFile, SIGNALING_CONTROLLER_CACHE_KEY_ICE_EXPIRATION "=%" PRIu64 "\n",
+                 pIceServerConfigs->expirationSec );
+        fprintf( pFile, SIGNALING_CONTROLLER_CACHE_KEY_ICE_REFRESH "=%" PRIu64 "\n",
+                 pIceServerConfigs->refreshTimeSec );
+
+        for( i = 0; i < pIceServerConfigs->iceServerConfigsCount; i++ )
+        {
+            fprintf( pFile, SIGNALING_CONTROLLER_CACHE_KEY_ICE_SERVER "=%u\n", pIceServerConfigs->iceServerConfigs[ i ].ttlSeconds );
+            fprintf( pFile, SIGNALING_CONTROLLER_CACHE_KEY_ICE_USER_NAME "=%.*s\n",
+                     ( int ) pIceServerConfigs->iceServerConfigs[ i ].userNameLength, &( pIceServerConfigs->iceServerConfigs[ i ].userName[ 0 ] ) );
+            fprintf( pFile, SIGNALING_CONTROLLER_CACHE_KEY_ICE_PASSWORD "=%.*s\n",
+                     ( int ) pIceServerConfigs->iceServerConfigs[ i ].passwordLength, &( pIceServerConfigs->iceServerConfigs[ i ].password[ 0 ] ) );
+
+            for( j = 0; j < pIceServerConfigs->iceServerConfigs[ i ].iceServerUriCount; j++ )
+            {
+                fprintf( pFile, SIGNALING_CONTROLLER_CACHE_KEY_ICE_URI "=%.*s\n",
+                         ( int ) pIceServerConfigs->iceServerConfigs[ i ].iceServerUris[ j ].uriLength,
+                         &( pIceServerConfigs->iceServerConfigs[ i ].iceServerUris[ j ].uri[ 0 ] ) );
+            }
+        }
+
+        /* Make the content durable before the rename, so a crash never leaves an empty cache file. */
+        if( ( fflush( pFile ) != 0 ) || ( ferror( pFile ) != 0 ) || ( fsync( fd ) != 0 ) )
+        {
+            LogError( ( "Fail to write signaling cache file: %s", tempPath ) );
+            ret = SIGNALING_CONTROLLER_RESULT_FAIL;
+        }
+
+        fclose( pFile );
+    }
+
+    if( ret == SIGNALING_CONTROLLER_RESULT_OK )
+    {
+        if( rename( tempPath, pConnectInfo->pCacheFilePath ) != 0 )
+        {
+            LogError( ( "Fail to replace signaling cache file: %s", pConnectInfo->pCacheFilePath ) );
+            ret = SIGNALING_CONTROLLER_RESULT_FAIL;
+        }
+    }
+
+    if( ( ret == SIGNALING_CONTROLLER_RESULT_FAIL ) && ( fd >= 0 ) )
+    {
+        ( void ) unlink( tempPath );
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+void SignalingControllerCache_Remove( const SignalingControllerConnectInfo_t * pConnectInfo )
+{
+    if( ( pConnectInfo != NULL ) && ( pConnectInfo->pCacheFilePath != NULL ) )
+    {
+        ( void ) unlink( pConnectInfo->pCacheFilePath );
+    }
+}
+
+/*----------------------------------------------------------------------------*/
@@ -0,0 +1,51 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SIGNALING_CONTROLLER_CACHE_H
+#define SIGNALING_CONTROLLER_CACHE_H
+
+#include "signaling_controller.h"
+
+/* Bump when the file layout changes, older files are then ignored. */
+#define SIGNALING_CONTROLLER_CACHE_VERSION                          ( 1 )
+
+/* Cached channel ARN and endpoints older than this are not used. */
+#define SIGNALING_CONTROLLER_CACHE_MAX_AGE_SEC                      ( 7 * 24 * 60 * 60 )
+
+#define SIGNALING_CONTROLLER_CACHE_PATH_MAX_LENGTH                  ( 256 )
+#define SIGNALING_CONTROLLER_CACHE_LINE_MAX_LENGTH                  ( 512 )
+
+/*----------------------------------------------------------------------------*/
+
+/* Load the channel ARN and endpoints of the channel in pConnectInfo into the
+ * context, and the ICE server configs into pIceServerConfigs if they have not
+ * expired. Nothing is kept on failure. */
+SignalingControllerResult_t SignalingControllerCache_Load( SignalingControllerContext_t * pCtx,
+                                                           const SignalingControllerConnectInfo_t * pConnectInfo,
+                                                           SignalingIceServerConfigs_t * pIceServerConfigs );
+
+/* Write the channel ARN and endpoints of the context, and the ICE server
+ * configs. The file is replaced atomically and is only readable by the owner
+ * as it holds the TURN credentials. */
+SignalingControllerResult_t SignalingControllerCache_Store( SignalingControllerContext_t * pCtx,
+                                                            const SignalingControllerConnectInfo_t * pConnectInfo,
+                                                            const SignalingIceServerConfigs_t * pIceServerConfigs );
+
+void SignalingControllerCache_Remove( const SignalingControllerConnectInfo_t * pConnectInfo );
+
+/*----------------------------------------------------------------------------*/
+
+#endif /* SIGNALING_CONTROLLER_CACHE_H */
@@ -0,0 +1,531 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Signaling SDP offer parsing benchmark.
+ *
+ * Runs browser like offers of growing size through the receive path, from the
+ * websocket message to the parsed SDP description, once the way it was done
+ * before with the payload decoded and the SDP unescaped into separate 10 KB
+ * buffers, and once decoding and unescaping in place. Reports the bytes copied
+ * between buffers and the CPU time per offer. The copy out of libwebsockets is
+ * the same for both and isn't counted. No network access is needed.
+ *
+ * Usage: WebRTCLinuxSignalingParseBenchmark [-n offers_per_case]
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "logging.h"
+#include "base64.h"
+#include "signaling_controller.h"
+#include "sdp_controller.h"
+
+/* Offers per case, unless overridden by -n. */
+#define SIGNALING_PARSE_BENCHMARK_DEFAULT_OFFERS          ( 20000 )
+
+/* The buffers the payload and the SDP were copied into before. */
+#define SIGNALING_PARSE_BENCHMARK_LEGACY_MESSAGE_LENGTH   ( 10 * 1024 )
+#define SIGNALING_PARSE_BENCHMARK_LEGACY_SDP_LENGTH       ( 10000 )
+
+/* Dynamic payload types 96 to 127, a codec and its RTX each. */
+#define SIGNALING_PARSE_BENCHMARK_MAX_CODECS              ( 16 )
+
+#define SIGNALING_PARSE_BENCHMARK_FINGERPRINT \
+    "5C:2E:3A:9B:1D:7F:60:44:8E:0A:F3:12:C9:B5:6D:71:2F:E8:90:4A:1C:D3:77:05:BB:36:E2:58:09:AF:14:C6"
+
+#define SIGNALING_PARSE_BENCHMARK_MESSAGE_TEMPLATE \
+    "{\"messageType\":\"SDP_OFFER\",\"senderClientId\":\"benchmark-viewer\",\"messagePayload\":\"%.*s\"}"
+
+typedef struct SignalingParseBenchmarkCase
+{
+    const char * pName;
+    uint32_t videoSectionCount;
+    uint32_t codecCount;
+    uint32_t candidateCount;
+} SignalingParseBenchmarkCase_t;
+
+typedef struct SignalingParseBenchmarkResult
+{
+    size_t sdpLength;
+    uint64_t copiedBytes;
+    uint32_t mediaCount;
+} SignalingParseBenchmarkResult_t;
+
+static const char * const h264ProfileLevelIds[] = {
+    "42001f", "42e01f", "4d001f", "640032"
+};
+
+static char offerBuffer[ WEBSOCKET_RX_BUFFER_LENGTH ];
+static char payloadBuffer[ WEBSOCKET_RX_BUFFER_LENGTH ];
+static char wssMessage[ WEBSOCKET_RX_BUFFER_LENGTH ];
+static size_t wssMessageLength;
+
+/* Stand ins for the websocket receive buffer, the worker's copy of the
+ * message and the remote SDP kept by the peer connection. */
+static char rxBuffer[ WEBSOCKET_RX_BUFFER_LENGTH ];
+static char jobBuffer[ WEBSOCKET_RX_BUFFER_LENGTH + 1 ];
+static char remoteSdpBuffer[ WEBSOCKET_RX_BUFFER_LENGTH ];
+
+static char legacyMessageBuffer[ SIGNALING_PARSE_BENCHMARK_LEGACY_MESSAGE_LENGTH ];
+static char legacySdpBuffer[ SIGNALING_PARSE_BENCHMARK_LEGACY_SDP_LENGTH ];
+
+/* Formal SDP of the legacy path, the in place path must produce the same. */
+static char expectedSdp[ WEBSOCKET_RX_BUFFER_LENGTH ];
+static size_t expectedSdpLength;
+
+static SdpControllerSdpDescription_t sdpDescription;
+
+/*----------------------------------------------------------------------------*/
+
+static uint64_t GetCpuTimeUs( void )
+{
+    struct timespec now;
+
+    clock_gettime( CLOCK_PROCESS_CPUTIME_ID, &( now ) );
+
+    return ( ( uint64_t ) now.tv_sec * 1000000U ) + ( ( uint64_t ) now.tv_nsec / 1000U );
+}
+
+/*----------------------------------------------------------------------------*/
+
+/* Appends an escaped SDP line, the offset sticks at the buffer size once it
+ * doesn't fit. */
+static size_t AppendLine( size_t offset,
+                          const char * pFormat,
+                          ... )
+{
+    va_list args;
+    int written = -1;
+
+    if( offset < sizeof( offerBuffer ) )
+    {
+        va_start( args, pFormat );
+        written = vsnprintf( &( offerBuffer[ offset ] ), sizeof( offerBuffer ) - offset, pFormat, args );
+        va_end( args );
+    }
+
+    if( ( written < 0 ) || ( offset + ( size_t ) written >= sizeof( offerBuffer ) ) )
+    {
+        offset = sizeof( offerBuffer );
+    }
+    else
+    {
+        offset += ( size_t ) written;
+    }
+
+    return offset;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static size_t AppendTransport( size_t offset,
+                               uint32_t mid )
+{
+    offset = AppendLine( offset, "c=IN IP4 0.0.0.0\\r\\n" );
+    offset = AppendLine( offset, "a=rtcp:9 IN IP4 0.0.0.0\\r\\n" );
+    offset = AppendLine( offset, "a=ice-ufrag:bnch\\r\\n" );
+    offset = AppendLine( offset, "a=ice-pwd:benchmarkviewerpassword0001\\r\\n" );
+    offset = AppendLine( offset, "a=ice-options:trickle\\r\\n" );
+    offset = AppendLine( offset, "a=fingerprint:sha-256 " SIGNALING_PARSE_BENCHMARK_FINGERPRINT "\\r\\n" );
+    offset = AppendLine( offset, "a=setup:actpass\\r\\n" );
+    offset = AppendLine( offset, "a=mid:%u\\r\\n", mid );
+    offset = AppendLine( offset, "a=extmap:1 urn:ietf:params:rtp-hdrext:toffset\\r\\n" );
+    offset = AppendLine( offset, "a=extmap:3 http://www.ietf.org/id/draft-holmer-rmcat-transport-wide-cc-extensions-01\\r\\n" );
+    offset = AppendLine( offset, "a=sendrecv\\r\\n" );
+    offset = AppendLine( offset, "a=msid:benchmark-stream benchmark-track-%u\\r\\n", mid );
+    offset = AppendLine( offset, "a=rtcp-mux\\r\\n" );
+
+    return offset;
+}
+
+/*----------------------------------------------------------------------------*/
+
+/* Builds the SDP offer message the way the signaling service delivers it,
+ * returns 0 on success. */
+static int BuildOffer( const SignalingParseBenchmarkCase_t * pCase )
+{
+    int ret = 0, written;
+    size_t offset = 0, payloadLength = sizeof( payloadBuffer );
+    uint32_t i, j, payloadType;
+    char payloadTypes[ SIGNALING_PARSE_BENCHMARK_MAX_CODECS * 8 + 1 ];
+    size_t payloadTypesLength = 0;
+    Base64Result_t base64Result;
+
+    offset = AppendLine( offset, "{\"type\":\"offer\",\"sdp\":\"" );
+    offset = AppendLine( offset, "v=0\\r\\n" );
+    offset = AppendLine( offset, "o=- 4611731400430051336 2 IN IP4 127.0.0.1\\r\\n" );
+    offset = AppendLine( offset, "s=-\\r\\n" );
+    offset = AppendLine( offset, "t=0 0\\r\\n" );
+    offset = AppendLine( offset, "a=group:BUNDLE 0" );
+    for( i = 1; i <= pCase->videoSectionCount; i++ )
+    {
+        offset = AppendLine( offset, " %u", i );
+    }
+    offset = AppendLine( offset, "\\r\\n" );
+    offset = AppendLine( offset, "a=extmap-allow-mixed\\r\\n" );
+    offset = AppendLine( offset, "a=msid-semantic: WMS benchmark-stream\\r\\n" );
+
+    offset = AppendLine( offset, "m=audio 9 UDP/TLS/RTP/SAVPF 111\\r\\n" );
+    offset = AppendTransport( offset, 0U );
+    offset = AppendLine( offset, "a=rtpmap:111 opus/48000/2\\r\\n" );
+    offset = AppendLine( offset, "a=rtcp-fb:111 transport-cc\\r\\n" );
+    offset = AppendLine( offset, "a=fmtp:111 minptime=10;useinbandfec=1\\r\\n" );
+    offset = AppendLine( offset, "a=ssrc:10000 cname:benchmark\\r\\n" );
+
+    /* Without trickle ICE the candidates come in the offer. */
+    for( i = 0; i < pCase->candidateCount; i++ )
+    {
+        offset = AppendLine( offset,
+                             "a=candidate:%u 1 udp %u 192.168.1.%u %u typ host generation 0 network-id 1\\r\\n",
+                             1000U + i,
+                             2122260223U - i,
+                             10U + i,
+                             50000U + i );
+    }
+
+    for( i = 1; i <= pCase->videoSectionCount; i++ )
+    {
+        payloadTypesLength = 0;
+        for( j = 0; j < pCase->codecCount; j++ )
+        {
+            payloadType = 96U + 2U * j;
+            written = snprintf( &( payloadTypes[ payloadTypesLength ] ),
+                                sizeof( payloadTypes ) - payloadTypesLength,
+                                " %u %u",
+                                payloadType,
+                                payloadType + 1U );
+            payloadTypesLength += ( size_t ) written;
+        }
+
+        offset = AppendLine( offset, "m=video 9 UDP/TLS/RTP/SAVPF%s\\r\\n", payloadTypes );
+        offset = AppendTransport( offset, i );
+        offset = AppendLine( offset, "a=rtcp-rsize\\r\\n" );
+
+        for( j = 0; j < pCase->codecCount; j++ )
+        {
+            payloadType = 96U + 2U * j;
+            offset = AppendLine( offset, "a=rtpmap:%u H264/90000\\r\\n", payloadType );
+            offset = AppendLine( offset, "a=rtcp-fb:%u goog-remb\\r\\n", payloadType );
+            offset = AppendLine( offset, "a=rtcp-fb:%u transport-cc\\r\\n", payloadType );
+            offset = AppendLine( offset, "a=rtcp-fb:%u ccm fir\\r\\n", payloadType );
+            offset = AppendLine( offset, "a=rtcp-fb:%u nack\\r\\n", payloadType );
+            offset = AppendLine( offset, "a=rtcp-fb:%u nack pli\\r\\n", payloadType );
+            offset = AppendLine( offset,
+                                 "a=fmtp:%u level-asymmetry-allowed=1;packetization-mode=%u;profile-level-id=%s\\r\\n",
+                                 payloadType,
+                                 ( j / 4U ) % 2U,
+                                 h264ProfileLevelIds[ j % 4U ] );
+            offset = AppendLine( offset, "a=rtpmap:%u rtx/90000\\r\\n", payloadType + 1U );
+            offset = AppendLine( offset, "a=fmtp:%u apt=%u\\r\\n", payloadType + 1U, payloadType );
+        }
+
+        offset = AppendLine( offset, "a=ssrc-group:FID %u %u\\r\\n", 20000U + i, 30000U + i );
+        offset = AppendLine( offset, "a=ssrc:%u cname:benchmark\\r\\n", 20000U + i );
+        offset = AppendLine( offset, "a=ssrc:%u cname:benchmark\\r\\n", 30000U + i );
+    }
+
+    offset = AppendLine( offset, "\"}" );
+
+    if( offset >= sizeof( offerBuffer ) )
+    {
+        printf( "%s: offer doesn't fit in %u bytes\n", pCase->pName, ( unsigned int ) sizeof( offerBuffer ) );
+        ret = -1;
+    }
+
+    if( ret == 0 )
+    {
+        base64Result = Base64_Encode( offerBuffer, offset, payloadBuffer, &( payloadLength ) );
+        if( base64Result != BASE64_RESULT_OK )
+        {
+            printf( "%s: base64 encoding failed, result: %d\n", pCase->pName, base64Result );
+            ret = -1;
+        }
+    }
+
+    if( ret == 0 )
+    {
+        written = snprintf( wssMessage,
+                            sizeof( wssMessage ),
+                            SIGNALING_PARSE_BENCHMARK_MESSAGE_TEMPLATE,
+                            ( int ) payloadLength,
+                            payloadBuffer );
+        if( ( written < 0 ) || ( ( size_t ) written >= sizeof( wssMessage ) ) )
+        {
+            printf( "%s: message doesn't fit in the websocket receive buffer\n", pCase->pName );
+            ret = -1;
+        }
+        else
+        {
+            wssMessageLength = ( size_t ) written;
+        }
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+/* One offer from the websocket receive buffer to the parsed description,
+ * returns 0 on success. */
+static int ParseOffer( uint8_t isInPlace,
+                       SignalingParseBenchmarkResult_t * pResult )
+{
+    int ret = 0;
+    WssRecvMessage_t wssRecvMessage;
+    SignalingResult_t signalingResult;
+    Base64Result_t base64Result;
+    SignalingControllerResult_t signalingControllerResult;
+    SdpControllerResult_t sdpControllerResult;
+    char * pPayload = NULL;
+    size_t payloadLength = 0;
+    const char * pSdp = NULL;
+    size_t sdpLength = 0;
+    char * pFormalSdp = NULL;
+    size_t formalSdpLength = 0;
+
+    /* What the websocket callback does for both. */
+    memcpy( rxBuffer, wssMessage, wssMessageLength );
+
+    signalingResult = Signaling_ParseWssRecvMessage( rxBuffer, wssMessageLength, &( wssRecvMessage ) );
+    if( signalingResult != SIGNALING_RESULT_OK )
+    {
+        ret = -1;
+    }
+
+    if( ret == 0 )
+    {
+        if( isInPlace != 0U )
+        {
+            pPayload = &( rxBuffer[ wssRecvMessage.pBase64EncodedPayload - rxBuffer ] );
+            payloadLength = wssRecvMessage.base64EncodedPayloadLength;
+            base64Result = Base64_Decode( pPayload, payloadLength, pPayload, &( payloadLength ) );
+        }
+        else
+        {
+            pPayload = legacyMessageBuffer;
+            payloadLength = sizeof( legacyMessageBuffer );
+            base64Result = Base64_Decode( wssRecvMessage.pBase64EncodedPayload,
+                                          wssRecvMessage.base64EncodedPayloadLength,
+                                          pPayload,
+                                          &( payloadLength ) );
+            pResult->copiedBytes += payloadLength;
+        }
+
+        if( base64Result != BASE64_RESULT_OK )
+        {
+            ret = -1;
+        }
+    }
+
+    if( ret == 0 )
+    {
+        /* The worker's copy, the terminator keeps the legacy newline search
+         * inside the message. */
+        memcpy( jobBuffer, pPayload, payloadLength );
+        jobBuffer[ payloadLength ] = '\0';
+        pResult->copiedBytes += payloadLength;
+
+        signalingControllerResult = SignalingController_ExtractSdpOfferFromSignalingMessage( jobBuffer,
+                                                                                             payloadLength,
+                                                                                             &( pSdp ),
+                                                                                             &( sdpLength ) );
+        if( signalingControllerResult != SIGNALING_CONTROLLER_RESULT_OK )
+        {
+            ret = -1;
+        }
+    }
+
+    if( ret == 0 )
+    {
+        if( isInPlace != 0U )
+        {
+            pFormalSdp = &( jobBuffer[ pSdp - jobBuffer ] );
+            formalSdpLength = sdpLength;
+            signalingControllerResult = SignalingController_DeserializeSdpContentNewlineInPlace( pFormalSdp,
+                                                                                                 &( formalSdpLength ) );
+        }
+        else
+        {
+            pFormalSdp = legacySdpBuffer;
+            formalSdpLength = sizeof( legacySdpBuffer );
+            signalingControllerResult = SignalingController_DeserializeSdpContentNewline( pSdp,
+                                                                                          sdpLength,
+                                                                                          pFormalSdp,
+                                                                                          &( formalSdpLength ) );
+            pResult->copiedBytes += formalSdpLength;
+        }
+
+        if( signalingControllerResult != SIGNALING_CONTROLLER_RESULT_OK )
+        {
+            ret = -1;
+        }
+    }
+
+    if( ret == 0 )
+    {
+        /* The copy the peer connection keeps for the session. */
+        memcpy( remoteSdpBuffer, pFormalSdp, formalSdpLength );
+        pResult->copiedBytes += formalSdpLength;
+
+        sdpControllerResult = SdpController_DeserializeSdpOffer( remoteSdpBuffer,
+                                                                 formalSdpLength,
+                                                                 &( sdpDescription ) );
+        if( sdpControllerResult != SDP_CONTROLLER_RESULT_OK )
+        {
+            ret = -1;
+        }
+    }
+
+    if( ret == 0 )
+    {
+        pResult->sdpLength = formalSdpLength;
+        pResult->mediaCount = sdpDescription.mediaCount;
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static int RunPath( const SignalingParseBenchmarkCase_t * pCase,
+                    uint8_t isInPlace,
+                    uint32_t offers )
+{
+    int ret = 0;
+    uint32_t i;
+    uint64_t startTimeUs, elapsedUs;
+    SignalingParseBenchmarkResult_t result;
+
+    memset( &( result ), 0, sizeof( SignalingParseBenchmarkResult_t ) );
+
+    startTimeUs = GetCpuTimeUs();
+
+    for( i = 0; ( ret == 0 ) && ( i < offers ); i++ )
+    {
+        ret = ParseOffer( isInPlace, &( result ) );
+    }
+
+    elapsedUs = GetCpuTimeUs() - startTimeUs;
+
+    if( ret != 0 )
+    {
+        printf( "%-8s %-9s %8u %8s %12s %10s %6s %s\n",
+                pCase->pName,
+                isInPlace != 0U ? "in-place" : "legacy",
+                ( unsigned int ) wssMessageLength,
+                "-", "-", "-", "-",
+                isInPlace != 0U ? "failed" : "failed, over the 10 KB buffers" );
+    }
+    else
+    {
+        if( isInPlace == 0U )
+        {
+            memcpy( expectedSdp, remoteSdpBuffer, result.sdpLength );
+            expectedSdpLength = result.sdpLength;
+        }
+        else if( ( expectedSdpLength > 0U ) &&
+                 ( ( expectedSdpLength != result.sdpLength ) ||
+                   ( memcmp( expectedSdp, remoteSdpBuffer, result.sdpLength ) != 0 ) ) )
+        {
+            printf( "%s: in place SDP differs from the legacy one\n", pCase->pName );
+            ret = -1;
+        }
+        else
+        {
+            /* Empty else marker. */
+        }
+
+        printf( "%-8s %-9s %8u %8u %12lu %10.2f %6u\n",
+                pCase->pName,
+                isInPlace != 0U ? "in-place" : "legacy",
+                ( unsigned int ) wssMessageLength,
+                ( unsigned int ) result.sdpLength,
+                ( unsigned long ) ( result.copiedBytes / offers ),
+                ( double ) elapsedUs / ( double ) offers,
+                result.mediaCount );
+    }
+
+    /* The legacy path is expected to fail on offers over 10 KB. */
+    return ( isInPlace != 0U ) ? ret : 0;
+}
+
+/*----------------------------------------------------------------------------*/
+
+int main( int argc,
+          char * argv[] )
+{
+    int ret = 0, option;
+    uint32_t offers = SIGNALING_PARSE_BENCHMARK_DEFAULT_OFFERS;
+    size_t i;
+    const SignalingParseBenchmarkCase_t cases[] = {
+        { "small", 1U, 2U, 0U },
+        { "medium", 1U, 8U, 4U },
+        { "large", 2U, 12U, 8U },
+        { "huge", 3U, 16U, 16U },
+    };
+
+    while( ( option = getopt( argc, argv, "n:" ) ) != -1 )
+    {
+        switch( option )
+        {
+            case 'n':
+                offers = ( uint32_t ) strtoul( optarg, NULL, 10 );
+                break;
+            default:
+                printf( "Usage: %s [-n offers_per_case]\n", argv[ 0 ] );
+                ret = -1;
+                break;
+        }
+    }
+
+    if( ( ret == 0 ) && ( offers == 0U ) )
+    {
+        printf( "Offers per case must be above 0\n" );
+        ret = -1;
+    }
+
+    if( ret == 0 )
+    {
+        printf( "%-8s %-9s %8s %8s %12s %10s %6s\n",
+                "case", "path", "message", "sdp", "copied/offer", "cpu us", "media" );
+
+        for( i = 0; ( ret == 0 ) && ( i < sizeof( cases ) / sizeof( cases[ 0 ] ) ); i++ )
+        {
+            expectedSdpLength = 0;
+
+            ret = BuildOffer( &( cases[ i ] ) );
+
+            if( ret == 0 )
+            {
+                ret = RunPath( &( cases[ i ] ), 0U, offers );
+            }
+
+            if( ret == 0 )
+            {
+                ret = RunPath( &( cases[ i ] ), 1U, offers );
+            }
+        }
+    }
+
+    return ( ret == 0 ) ? 0 : 1;
+}
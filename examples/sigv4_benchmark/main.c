@@ -0,0 +1,441 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * SigV4 signing benchmark.
+ *
+ * Signs a canonical request shaped like the signaling HTTP API calls and the
+ * websocket connect URL, once deriving the signing key for every request as
+ * before and once reusing the cached key. No network access is needed.
+ * Before measuring, the canonical request helpers are checked against
+ * vectors for query encoding, path encoding, header folding and the empty
+ * payload, and the signer against the example of the AWS SigV4 documentation.
+ *
+ * Usage: WebRTCLinuxSigV4Benchmark [-n signatures_per_case]
+ *
+ * Exits with 1 if a vector or the known answer doesn't match, or signing fails.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "logging.h"
+#include "networking_utils.h"
+#include "networking_sigv4.h"
+
+/* Signatures per case, unless overridden by -n. */
+#define SIGV4_BENCHMARK_DEFAULT_SIGNATURES ( 100000 )
+
+#define SIGV4_BENCHMARK_ISO8601_TIME       "20240101T120000Z"
+#define SIGV4_BENCHMARK_ACCESS_KEY_ID      "AKIDEXAMPLE"
+#define SIGV4_BENCHMARK_SECRET_ACCESS_KEY  "wJalrXUtnFEMI/K7MDENG+bPxRfiCYEXAMPLEKEY"
+#define SIGV4_BENCHMARK_REGION             "us-west-2"
+#define SIGV4_BENCHMARK_SERVICE            "kinesisvideo"
+
+/* Example request of the AWS SigV4 documentation, "Create a signed AWS API request". */
+#define SIGV4_KNOWN_ANSWER_ISO8601_TIME     "20150830T123600Z"
+#define SIGV4_KNOWN_ANSWER_REGION           "us-east-1"
+#define SIGV4_KNOWN_ANSWER_SERVICE          "iam"
+#define SIGV4_KNOWN_ANSWER_SIGNATURE        "5d672d79c15b13162d9279b0855cfba6789a8edb4c82c400e06b5924a6f2b5d7"
+#define SIGV4_KNOWN_ANSWER_REQUEST_HASH     "f536975d06c0309214f805bb90ccff089219ecd68b2577efef23edd43b7e1a59"
+
+#define SIGV4_VECTOR_BUFFER_LENGTH          ( 512 )
+
+typedef struct SigV4BenchmarkCase
+{
+    const char * pName;
+    const char * pCanonicalRequest;
+    uint8_t deriveKeyEveryTime;
+} SigV4BenchmarkCase_t;
+
+typedef int ( * SigV4CanonicalizeFunc_t )( const char * pSrc,
+                                           size_t srcLength,
+                                           char * pDst,
+                                           size_t * pDstLength );
+
+typedef struct SigV4Vector
+{
+    const char * pInput;
+    const char * pExpected;
+} SigV4Vector_t;
+
+/* Query values, everything but the unreserved characters is percent-encoded, '/' and space included. */
+static const SigV4Vector_t queryVectors[] = {
+    { "arn:aws:kinesisvideo:us-west-2:123456789012:channel/demo channel/1~2.3_4-5",
+      "arn%3Aaws%3Akinesisvideo%3Aus-west-2%3A123456789012%3Achannel%2Fdemo%20channel%2F1~2.3_4-5" },
+    { "AQoD+YXIv/Ab==", "AQoD%2BYXIv%2FAb%3D%3D" },
+    { "", "" },
+};
+
+/* Paths, each segment is encoded twice and the empty path is "/". */
+static const SigV4Vector_t pathVectors[] = {
+    { "", "/" },
+    { "/", "/" },
+    { "/getSignalingChannelEndpoint", "/getSignalingChannelEndpoint" },
+    { "/documents and settings/", "/documents%2520and%2520settings/" },
+};
+
+/* Header values, whitespace is trimmed and each run of it, line folds included, becomes one space. */
+static const SigV4Vector_t headerVectors[] = {
+    { "AWS-WebRTC-KVS-Agent/1.0.0", "AWS-WebRTC-KVS-Agent/1.0.0" },
+    { "  a   b  c ", "a b c" },
+    { "application/x-www-form-urlencoded;\r\n\t charset=utf-8", "application/x-www-form-urlencoded; charset=utf-8" },
+    { "   ", "" },
+};
+
+static const char httpCanonicalRequest[] =
+    "POST\n"
+    "/getSignalingChannelEndpoint\n"
+    "\n"
+    "host:kinesisvideo.us-west-2.amazonaws.com\n"
+    "user-agent:AWS-WebRTC-KVS-Agent/1.0.0\n"
+    "x-amz-date:" SIGV4_BENCHMARK_ISO8601_TIME "\n"
+    "\n"
+    "host;user-agent;x-amz-date\n"
+    "44136fa355b3678a1146ad16f7e8649e94fb4fc21fe77e8310c060f61caaff8a";
+
+static const char websocketCanonicalRequest[] =
+    "GET\n"
+    "/\n"
+    "X-Amz-Algorithm=AWS4-HMAC-SHA256"
+    "&X-Amz-ChannelARN=arn%3Aaws%3Akinesisvideo%3Aus-west-2%3A123456789012%3Achannel%2Fdemo-channel%2F1234567890123"
+    "&X-Amz-Credential=AKIDEXAMPLE%2F20240101%2Fus-west-2%2Fkinesisvideo%2Faws4_request"
+    "&X-Amz-Date=" SIGV4_BENCHMARK_ISO8601_TIME
+    "&X-Amz-Expires=604800"
+    "&X-Amz-SignedHeaders=host\n"
+    "host:m-12345678.kinesisvideo.us-west-2.amazonaws.com\n"
+    "\n"
+    "host\n"
+    NETWORKING_SIGV4_EMPTY_PAYLOAD_HASH;
+
+static const char knownAnswerCanonicalRequest[] =
+    "GET\n"
+    "/\n"
+    "Action=ListUsers&Version=2010-05-08\n"
+    "content-type:application/x-www-form-urlencoded; charset=utf-8\n"
+    "host:iam.amazonaws.com\n"
+    "x-amz-date:" SIGV4_KNOWN_ANSWER_ISO8601_TIME "\n"
+    "\n"
+    "content-type;host;x-amz-date\n"
+    NETWORKING_SIGV4_EMPTY_PAYLOAD_HASH;
+
+static int CheckVectors( const char * pName,
+                         SigV4CanonicalizeFunc_t canonicalizeFunc,
+                         const SigV4Vector_t * pVectors,
+                         size_t vectorCount )
+{
+    int ret = 0;
+    size_t i, outputLength;
+    char output[ SIGV4_VECTOR_BUFFER_LENGTH ];
+
+    for( i = 0; ( ret == 0 ) && ( i < vectorCount ); i++ )
+    {
+        outputLength = sizeof( output );
+        ret = canonicalizeFunc( pVectors[ i ].pInput,
+                                strlen( pVectors[ i ].pInput ),
+                                output,
+                                &( outputLength ) );
+
+        if( ret != 0 )
+        {
+            printf( "%s vector %lu failed\n", pName, i );
+        }
+        else if( ( outputLength != strlen( pVectors[ i ].pExpected ) ) ||
+                 ( memcmp( output, pVectors[ i ].pExpected, outputLength ) != 0 ) )
+        {
+            printf( "%s vector %lu mismatch, expected: %s, got: %.*s\n", pName, i, pVectors[ i ].pExpected, ( int ) outputLength, output );
+            ret = -1;
+        }
+        else
+        {
+            /* Empty else marker. */
+        }
+    }
+
+    return ret;
+}
+
+/* Build the canonical request of the documentation example with the helpers,
+ * from a folded content type header and an empty payload. */
+static int CheckCanonicalRequest( void )
+{
+    int ret = 0;
+    char canonicalRequest[ SIGV4_VECTOR_BUFFER_LENGTH ];
+    char path[ SIGV4_VECTOR_BUFFER_LENGTH ];
+    char contentType[ SIGV4_VECTOR_BUFFER_LENGTH ];
+    char payloadHash[ NETWORKING_SIGV4_HEX_DIGEST_LENGTH + 1 ];
+    char requestHash[ NETWORKING_SIGV4_HEX_DIGEST_LENGTH + 1 ];
+    const char foldedContentType[] = " application/x-www-form-urlencoded;\r\n  charset=utf-8 ";
+    size_t pathLength = sizeof( path );
+    size_t contentTypeLength = sizeof( contentType );
+    int length;
+
+    memset( payloadHash, 0, sizeof( payloadHash ) );
+    memset( requestHash, 0, sizeof( requestHash ) );
+
+    ret = NetworkingSigV4_CanonicalizePath( "",
+                                            0,
+                                            path,
+                                            &( pathLength ) );
+
+    if( ret == 0 )
+    {
+        ret = NetworkingSigV4_CanonicalizeHeaderValue( foldedContentType,
+                                                       strlen( foldedContentType ),
+                                                       contentType,
+                                                       &( contentTypeLength ) );
+    }
+
+    if( ret == 0 )
+    {
+        ret = NetworkingSigV4_HexHash( NULL,
+                                       0,
+                                       payloadHash );
+    }
+
+    if( ret == 0 )
+    {
+        length = snprintf( canonicalRequest,
+                           sizeof( canonicalRequest ),
+                           "GET\n%.*s\nAction=ListUsers&Version=2010-05-08\n"
+                           "content-type:%.*s\nhost:iam.amazonaws.com\nx-amz-date:" SIGV4_KNOWN_ANSWER_ISO8601_TIME "\n"
+                           "\ncontent-type;host;x-amz-date\n%s",
+                           ( int ) pathLength,
+                           path,
+                           ( int ) contentTypeLength,
+                           contentType,
+                           payloadHash );
+
+        if( ( length < 0 ) || ( length >= ( int ) sizeof( canonicalRequest ) ) )
+        {
+            ret = -1;
+        }
+    }
+
+    if( ret == 0 )
+    {
+        ret = NetworkingSigV4_HexHash( ( const uint8_t * ) canonicalRequest,
+                                       length,
+                                       requestHash );
+    }
+
+    if( ret != 0 )
+    {
+        printf( "Canonical request building failed\n" );
+    }
+    else if( strcmp( payloadHash, NETWORKING_SIGV4_EMPTY_PAYLOAD_HASH ) != 0 )
+    {
+        printf( "Empty payload hash mismatch, got: %s\n", payloadHash );
+        ret = -1;
+    }
+    else if( ( strcmp( canonicalRequest, knownAnswerCanonicalRequest ) != 0 ) ||
+             ( strcmp( requestHash, SIGV4_KNOWN_ANSWER_REQUEST_HASH ) != 0 ) )
+    {
+        printf( "Canonical request mismatch, expected hash: %s, got: %s\n", SIGV4_KNOWN_ANSWER_REQUEST_HASH, requestHash );
+        ret = -1;
+    }
+    else
+    {
+        /* Empty else marker. */
+    }
+
+    return ret;
+}
+
+static int CheckKnownAnswer( void )
+{
+    int ret = 0;
+    NetworkingSigV4Cache_t cache;
+    char signature[ NETWORKING_SIGV4_HEX_DIGEST_LENGTH + 1 ];
+
+    memset( &( cache ), 0, sizeof( NetworkingSigV4Cache_t ) );
+    memset( signature, 0, sizeof( signature ) );
+
+    ret = NetworkingSigV4_PrepareCache( &( cache ),
+                                        SIGV4_KNOWN_ANSWER_ISO8601_TIME,
+                                        SIGV4_BENCHMARK_ACCESS_KEY_ID,
+                                        strlen( SIGV4_BENCHMARK_ACCESS_KEY_ID ),
+                                        SIGV4_BENCHMARK_SECRET_ACCESS_KEY,
+                                        strlen( SIGV4_BENCHMARK_SECRET_ACCESS_KEY ),
+                                        SIGV4_KNOWN_ANSWER_REGION,
+                                        strlen( SIGV4_KNOWN_ANSWER_REGION ),
+                                        SIGV4_KNOWN_ANSWER_SERVICE,
+                                        strlen( SIGV4_KNOWN_ANSWER_SERVICE ) );
+
+    if( ret == 0 )
+    {
+        ret = NetworkingSigV4_Sign( &( cache ),
+                                    SIGV4_KNOWN_ANSWER_ISO8601_TIME,
+                                    knownAnswerCanonicalRequest,
+                                    strlen( knownAnswerCanonicalRequest ),
+                                    signature );
+    }
+
+    if( ret != 0 )
+    {
+        printf( "Known answer signing failed\n" );
+    }
+    else if( strcmp( signature, SIGV4_KNOWN_ANSWER_SIGNATURE ) != 0 )
+    {
+        printf( "Known answer mismatch, expected: %s, got: %s\n", SIGV4_KNOWN_ANSWER_SIGNATURE, signature );
+        ret = -1;
+    }
+    else
+    {
+        printf( "Known answer matches the AWS SigV4 documentation example\n" );
+    }
+
+    return ret;
+}
+
+static int RunCase( const SigV4BenchmarkCase_t * pCase,
+                    uint32_t signatures )
+{
+    int ret = 0;
+    uint32_t i;
+    uint64_t startTimeUs, elapsedUs;
+    NetworkingSigV4Cache_t cache;
+    char signature[ NETWORKING_SIGV4_HEX_DIGEST_LENGTH + 1 ];
+
+    memset( &( cache ), 0, sizeof( NetworkingSigV4Cache_t ) );
+    memset( signature, 0, sizeof( signature ) );
+
+    startTimeUs = NetworkingUtils_GetCurrentTimeUs( NULL );
+
+    for( i = 0; ( ret == 0 ) && ( i < signatures ); i++ )
+    {
+        if( pCase->deriveKeyEveryTime != 0U )
+        {
+            NetworkingSigV4_InvalidateCache( &( cache ) );
+        }
+
+        ret = NetworkingSigV4_PrepareCache( &( cache ),
+                                            SIGV4_BENCHMARK_ISO8601_TIME,
+                                            SIGV4_BENCHMARK_ACCESS_KEY_ID,
+                                            strlen( SIGV4_BENCHMARK_ACCESS_KEY_ID ),
+                                            SIGV4_BENCHMARK_SECRET_ACCESS_KEY,
+                                            strlen( SIGV4_BENCHMARK_SECRET_ACCESS_KEY ),
+                                            SIGV4_BENCHMARK_REGION,
+                                            strlen( SIGV4_BENCHMARK_REGION ),
+                                            SIGV4_BENCHMARK_SERVICE,
+                                            strlen( SIGV4_BENCHMARK_SERVICE ) );
+
+        if( ret == 0 )
+        {
+            ret = NetworkingSigV4_Sign( &( cache ),
+                                        SIGV4_BENCHMARK_ISO8601_TIME,
+                                        pCase->pCanonicalRequest,
+                                        strlen( pCase->pCanonicalRequest ),
+                                        signature );
+        }
+    }
+
+    elapsedUs = NetworkingUtils_GetCurrentTimeUs( NULL ) - startTimeUs;
+
+    if( ret == 0 )
+    {
+        printf( "%-24s %10u %12.0f %10.3f %8u/%-8u %.16s...\n",
+                pCase->pName,
+                signatures,
+                elapsedUs > 0 ? ( double ) signatures * 1000000.0 / ( double ) elapsedUs : 0.0,
+                ( double ) elapsedUs / ( double ) signatures,
+                cache.hitCount,
+                cache.missCount,
+                signature );
+    }
+    else
+    {
+        printf( "%-24s failed\n", pCase->pName );
+    }
+
+    return ret;
+}
+
+int main( int argc,
+          char * argv[] )
+{
+    int ret = 0, option;
+    uint32_t signatures = SIGV4_BENCHMARK_DEFAULT_SIGNATURES;
+    size_t i;
+    const SigV4BenchmarkCase_t cases[] = {
+        { "http-derive-key", httpCanonicalRequest, 1U },
+        { "http-cached-key", httpCanonicalRequest, 0U },
+        { "websocket-derive-key", websocketCanonicalRequest, 1U },
+        { "websocket-cached-key", websocketCanonicalRequest, 0U },
+    };
+
+    while( ( option = getopt( argc, argv, "n:" ) ) != -1 )
+    {
+        switch( option )
+        {
+            case 'n':
+                signatures = ( uint32_t ) strtoul( optarg, NULL, 10 );
+                break;
+            default:
+                printf( "Usage: %s [-n signatures_per_case]\n", argv[ 0 ] );
+                ret = -1;
+                break;
+        }
+    }
+
+    if( ( ret == 0 ) && ( signatures == 0U ) )
+    {
+        printf( "Signatures per case must be above 0\n" );
+        ret = -1;
+    }
+
+    if( ret == 0 )
+    {
+        ret = CheckVectors( "Query", NetworkingSigV4_UriEncode, queryVectors, sizeof( queryVectors ) / sizeof( queryVectors[ 0 ] ) );
+    }
+
+    if( ret == 0 )
+    {
+        ret = CheckVectors( "Path", NetworkingSigV4_CanonicalizePath, pathVectors, sizeof( pathVectors ) / sizeof( pathVectors[ 0 ] ) );
+    }
+
+    if( ret == 0 )
+    {
+        ret = CheckVectors( "Header", NetworkingSigV4_CanonicalizeHeaderValue, headerVectors, sizeof( headerVectors ) / sizeof( headerVectors[ 0 ] ) );
+    }
+
+    if( ret == 0 )
+    {
+        ret = CheckCanonicalRequest();
+    }
+
+    if( ret == 0 )
+    {
+        printf( "Canonical request vectors match\n" );
+        ret = CheckKnownAnswer();
+    }
+
+    if( ret == 0 )
+    {
+        printf( "%-24s %10s %12s %10s %17s %s\n",
+                "case", "signatures", "sig/s", "us/sig", "key hit/miss", "signature" );
+
+        for( i = 0; ( ret == 0 ) && ( i < sizeof( cases ) / sizeof( cases[ 0 ] ) ); i++ )
+        {
+            ret = RunCase( &( cases[ i ] ), signatures );
+        }
+    }
+
+    return ( ret == 0 ) ? 0 : 1;
+}
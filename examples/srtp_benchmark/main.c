@@ -0,0 +1,301 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * SRTP protect/unprotect benchmark.
+ *
+ * Reports srtp_protect and srtp_unprotect throughput of every SRTP profile the
+ * DTLS-SRTP negotiation can pick, using the same libsrtp policies as
+ * PeerConnectionSrtp_Init, for an audio frame and for video packets up to the
+ * MTU. Packets are protected and unprotected in batches, every unprotected
+ * packet must match the original.
+ *
+ * Usage: WebRTCLinuxSrtpBenchmark [-n packets_per_case]
+ *
+ * Exits with 1 if a packet fails to round trip.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "srtp.h"
+
+/* Packets protected and unprotected per case, unless overridden by -n. */
+#define SRTP_BENCHMARK_DEFAULT_PACKETS_PER_CASE ( 1000000 )
+
+/* Packets protected before the batch is unprotected, well inside the replay window. */
+#define SRTP_BENCHMARK_BATCH_SIZE               ( 64 )
+
+#define SRTP_BENCHMARK_RTP_HEADER_LENGTH        ( 12 )
+#define SRTP_BENCHMARK_MAX_PAYLOAD_LENGTH       ( 1200 )
+#define SRTP_BENCHMARK_MAX_PACKET_LENGTH        ( SRTP_BENCHMARK_RTP_HEADER_LENGTH + SRTP_BENCHMARK_MAX_PAYLOAD_LENGTH + SRTP_MAX_TRAILER_LEN )
+
+/* AES-128 master key and the 14 bytes salt. */
+#define SRTP_BENCHMARK_MAX_KEY_LENGTH           ( 30 )
+
+#define SRTP_BENCHMARK_SSRC                     ( 0x12345678 )
+
+typedef void ( * SrtpBenchmarkPolicySetter_t )( srtp_crypto_policy_t * pPolicy );
+
+typedef struct SrtpBenchmarkProfile
+{
+    const char * pName;
+    SrtpBenchmarkPolicySetter_t policySetter;
+} SrtpBenchmarkProfile_t;
+
+/* Same policies as PeerConnectionSrtp_Init picks for each negotiated profile. */
+static const SrtpBenchmarkProfile_t profiles[] = {
+    { "AES128_CM_SHA1_80", srtp_crypto_policy_set_rtp_default },
+    { "AES128_CM_SHA1_32", srtp_crypto_policy_set_aes_cm_128_hmac_sha1_32 },
+};
+
+/* A 20 ms G.711 frame, a small video packet and a full video packet. */
+static const size_t payloadLengths[] = { 160, 500, SRTP_BENCHMARK_MAX_PAYLOAD_LENGTH };
+
+static uint8_t rtpPackets[ SRTP_BENCHMARK_BATCH_SIZE ][ SRTP_BENCHMARK_MAX_PACKET_LENGTH ];
+static uint8_t srtpPackets[ SRTP_BENCHMARK_BATCH_SIZE ][ SRTP_BENCHMARK_MAX_PACKET_LENGTH ];
+static size_t srtpPacketLengths[ SRTP_BENCHMARK_BATCH_SIZE ];
+static uint8_t unprotectedPacket[ SRTP_BENCHMARK_MAX_PACKET_LENGTH ];
+
+/*----------------------------------------------------------------------------*/
+
+static uint64_t GetTimeNs( void )
+{
+    struct timespec now;
+
+    clock_gettime( CLOCK_MONOTONIC, &( now ) );
+
+    return ( uint64_t ) now.tv_sec * 1000000000ULL + ( uint64_t ) now.tv_nsec;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static void WriteRtpHeader( uint8_t * pPacket,
+                            uint16_t sequenceNumber )
+{
+    uint32_t timestamp = ( uint32_t ) sequenceNumber * 3000U;
+
+    pPacket[ 0 ] = 0x80;
+    pPacket[ 1 ] = 96;
+    pPacket[ 2 ] = ( uint8_t ) ( sequenceNumber >> 8 );
+    pPacket[ 3 ] = ( uint8_t ) sequenceNumber;
+    pPacket[ 4 ] = ( uint8_t ) ( timestamp >> 24 );
+    pPacket[ 5 ] = ( uint8_t ) ( timestamp >> 16 );
+    pPacket[ 6 ] = ( uint8_t ) ( timestamp >> 8 );
+    pPacket[ 7 ] = ( uint8_t ) timestamp;
+    pPacket[ 8 ] = ( uint8_t ) ( SRTP_BENCHMARK_SSRC >> 24 );
+    pPacket[ 9 ] = ( uint8_t ) ( SRTP_BENCHMARK_SSRC >> 16 );
+    pPacket[ 10 ] = ( uint8_t ) ( SRTP_BENCHMARK_SSRC >> 8 );
+    pPacket[ 11 ] = ( uint8_t ) SRTP_BENCHMARK_SSRC;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static int RunCase( const SrtpBenchmarkProfile_t * pProfile,
+                    size_t payloadLength,
+                    uint32_t packetsPerCase )
+{
+    int ret = 0;
+    srtp_policy_t transmitPolicy;
+    srtp_policy_t receivePolicy;
+    srtp_t transmitSession = NULL;
+    srtp_t receiveSession = NULL;
+    srtp_err_status_t errorStatus;
+    uint8_t masterKey[ SRTP_BENCHMARK_MAX_KEY_LENGTH ];
+    size_t rtpLength = SRTP_BENCHMARK_RTP_HEADER_LENGTH + payloadLength;
+    size_t unprotectedLength;
+    uint16_t sequenceNumber = 0;
+    uint32_t packets = 0;
+    uint32_t batchSize;
+    uint32_t i;
+    uint64_t startNs;
+    uint64_t protectNs = 0;
+    uint64_t unprotectNs = 0;
+
+    for( i = 0; i < sizeof( masterKey ); i++ )
+    {
+        masterKey[ i ] = ( uint8_t ) rand();
+    }
+
+    memset( &transmitPolicy, 0, sizeof( transmitPolicy ) );
+    pProfile->policySetter( &transmitPolicy.rtp );
+    pProfile->policySetter( &transmitPolicy.rtcp );
+    transmitPolicy.key = masterKey;
+    transmitPolicy.ssrc.type = ssrc_any_outbound;
+    transmitPolicy.next = NULL;
+
+    memcpy( &receivePolicy, &transmitPolicy, sizeof( receivePolicy ) );
+    receivePolicy.ssrc.type = ssrc_any_inbound;
+
+    errorStatus = srtp_create( &transmitSession, &transmitPolicy );
+    if( errorStatus == srtp_err_status_ok )
+    {
+        errorStatus = srtp_create( &receiveSession, &receivePolicy );
+    }
+
+    if( errorStatus != srtp_err_status_ok )
+    {
+        printf( "%-20s fail to create SRTP sessions, errorStatus: %d\n", pProfile->pName, errorStatus );
+        ret = -1;
+    }
+
+    while( ( ret == 0 ) && ( packets < packetsPerCase ) )
+    {
+        batchSize = packetsPerCase - packets;
+        if( batchSize > SRTP_BENCHMARK_BATCH_SIZE )
+        {
+            batchSize = SRTP_BENCHMARK_BATCH_SIZE;
+        }
+
+        for( i = 0; i < batchSize; i++ )
+        {
+            WriteRtpHeader( rtpPackets[ i ], sequenceNumber++ );
+            memset( &( rtpPackets[ i ][ SRTP_BENCHMARK_RTP_HEADER_LENGTH ] ), ( int ) ( packets + i ), payloadLength );
+        }
+
+        startNs = GetTimeNs();
+        for( i = 0; ( ret == 0 ) && ( i < batchSize ); i++ )
+        {
+            srtpPacketLengths[ i ] = SRTP_BENCHMARK_MAX_PACKET_LENGTH;
+            errorStatus = srtp_protect( transmitSession,
+                                        rtpPackets[ i ],
+                                        rtpLength,
+                                        srtpPackets[ i ],
+                                        &( srtpPacketLengths[ i ] ),
+                                        0 );
+            if( errorStatus != srtp_err_status_ok )
+            {
+                printf( "%-20s srtp_protect failed, errorStatus: %d\n", pProfile->pName, errorStatus );
+                ret = -1;
+            }
+        }
+        protectNs += GetTimeNs() - startNs;
+
+        startNs = GetTimeNs();
+        for( i = 0; ( ret == 0 ) && ( i < batchSize ); i++ )
+        {
+            unprotectedLength = SRTP_BENCHMARK_MAX_PACKET_LENGTH;
+            errorStatus = srtp_unprotect( receiveSession,
+                                          srtpPackets[ i ],
+                                          srtpPacketLengths[ i ],
+                                          unprotectedPacket,
+                                          &unprotectedLength );
+            if( errorStatus != srtp_err_status_ok )
+            {
+                printf( "%-20s srtp_unprotect failed, errorStatus: %d\n", pProfile->pName, errorStatus );
+                ret = -1;
+            }
+            else if( ( unprotectedLength != rtpLength ) ||
+                     ( memcmp( unprotectedPacket, rtpPackets[ i ], rtpLength ) != 0 ) )
+            {
+                printf( "%-20s unprotected packet doesn't match the original\n", pProfile->pName );
+                ret = -1;
+            }
+            else
+            {
+                /* Empty else marker. */
+            }
+        }
+        unprotectNs += GetTimeNs() - startNs;
+
+        packets += batchSize;
+    }
+
+    if( ret == 0 )
+    {
+        printf( "%-20s %8lu %14.1f %12.2f %14.1f %12.2f\n",
+                pProfile->pName,
+                ( unsigned long ) payloadLength,
+                ( double ) protectNs / packets,
+                ( double ) rtpLength * packets / ( ( double ) protectNs / 1e9 ) / ( 1024.0 * 1024.0 ),
+                ( double ) unprotectNs / packets,
+                ( double ) rtpLength * packets / ( ( double ) unprotectNs / 1e9 ) / ( 1024.0 * 1024.0 ) );
+    }
+
+    if( transmitSession != NULL )
+    {
+        ( void ) srtp_dealloc( transmitSession );
+    }
+
+    if( receiveSession != NULL )
+    {
+        ( void ) srtp_dealloc( receiveSession );
+    }
+
+    return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+int main( int argc,
+          char * argv[] )
+{
+    int ret = 0;
+    int option;
+    uint32_t packetsPerCase = SRTP_BENCHMARK_DEFAULT_PACKETS_PER_CASE;
+    size_t i;
+    size_t j;
+
+    while( ( option = getopt( argc, argv, "n:" ) ) != -1 )
+    {
+        switch( option )
+        {
+            case 'n':
+                packetsPerCase = ( uint32_t ) strtoul( optarg, NULL, 10 );
+                break;
+            default:
+                printf( "Usage: %s [-n packets_per_case]\n", argv[ 0 ] );
+                ret = -1;
+                break;
+        }
+    }
+
+    if( ( ret == 0 ) && ( packetsPerCase == 0U ) )
+    {
+        printf( "Packets per case must be above 0\n" );
+        ret = -1;
+    }
+
+    if( ( ret == 0 ) && ( srtp_init() != srtp_err_status_ok ) )
+    {
+        printf( "srtp_init failed\n" );
+        ret = -1;
+    }
+
+    if( ret == 0 )
+    {
+        srand( 1 );
+
+        printf( "%-20s %8s %14s %12s %14s %12s\n",
+                "profile", "payload", "protect ns/pkt", "protect MB/s", "unprotect ns", "unprotect MB/s" );
+
+        for( i = 0; ( ret == 0 ) && ( i < sizeof( profiles ) / sizeof( profiles[ 0 ] ) ); i++ )
+        {
+            for( j = 0; ( ret == 0 ) && ( j < sizeof( payloadLengths ) / sizeof( payloadLengths[ 0 ] ) ); j++ )
+            {
+                ret = RunCase( &( profiles[ i ] ), payloadLengths[ j ], packetsPerCase );
+            }
+        }
+
+        ( void ) srtp_shutdown();
+    }
+
+    return ( ret == 0 ) ? 0 : 1;
+}
@@ -30,7 +30,7 @@ StringUtilsResult_t StringUtils_ConvertStringToUl( const char * pStr,
 
     if( ret == STRING_UTILS_RESULT_OK )
     {
-        for( i = 0; pStr[i] != '\0' && i < strLength; i++ )
+        for( i = 0; i < strLength && pStr[i] != '\0'; i++ )
         {
             if( ( pStr[i] >= '0' ) && ( pStr[i] <= '9' ) )
             {
@@ -101,7 +101,7 @@ const char * StringUtils_StrStr( const char * pStr,
             pCurrentStr = &pStr[i];
             pCurrentPattern = pPattern;
             checkedLength = 0;
-            while( pCurrentStr[ checkedLength ] == pCurrentPattern[ checkedLength ] && checkedLength < patternLength )
+            while( checkedLength < patternLength && pCurrentStr[ checkedLength ] == pCurrentPattern[ checkedLength ] )
             {
                 checkedLength++;
             }